@@ -0,0 +1,557 @@
+#include "AndroidDeviceTree.hpp"
+#include <IOKit/IOLib.h>
+#include <libkern/OSByteOrder.h>
+#include <libkern/libkern.h>
+#include <libkern/c++/OSString.h>
+
+// Devicetree Specification v0.4, 5.2-5.4
+#define FDT_MAGIC       0xD00DFEED
+#define FDT_BEGIN_NODE  1
+#define FDT_END_NODE    2
+#define FDT_PROP        3
+#define FDT_NOP         4
+#define FDT_END         9
+
+struct fdt_header {
+    uint32_t magic;
+    uint32_t totalsize;
+    uint32_t off_dt_struct;
+    uint32_t off_dt_strings;
+    uint32_t off_mem_rsvmap;
+    uint32_t version;
+    uint32_t last_comp_version;
+    uint32_t boot_cpuid_phys;
+    uint32_t size_dt_strings;
+    uint32_t size_dt_struct;
+};
+
+// FNV-1a, continued from `h`
+static uint32_t hashBytes(uint32_t h, const char *s, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        h = (h ^ (uint8_t)s[i]) * 16777619;
+    return h;
+}
+
+static const uint32_t kHashBasis = 2166136261;
+
+static uint32_t align4(uint32_t offset)
+{
+    return (offset + 3) & ~3u;
+}
+
+static int compareKeys(const void *a, const void *b)
+{
+    const uint32_t *x = (const uint32_t *)a, *y = (const uint32_t *)b;
+
+    if (x[0] != y[0])
+        return x[0] < y[0] ? -1 : 1;
+    return x[1] < y[1] ? -1 : x[1] > y[1];
+}
+
+#define super OSObject
+OSDefineMetaClassAndStructors(AndroidDeviceTree, OSObject)
+
+AndroidDeviceTree *AndroidDeviceTree::withData(OSData *blob)
+{
+    if (!blob || blob->getLength() < sizeof(fdt_header))
+        return NULL;
+
+    AndroidDeviceTree *tree = new AndroidDeviceTree;
+    if (tree && !tree->init()) {
+        tree->release();
+        return NULL;
+    }
+    if (!tree)
+        return NULL;
+
+    blob->retain();
+    tree->fBlob = blob;
+    tree->fBytes = (const uint8_t *)blob->getBytesNoCopy();
+    if (!tree->index()) {
+        tree->release();
+        return NULL;
+    }
+    return tree;
+}
+
+void AndroidDeviceTree::free(void)
+{
+    if (fNodes)
+        IOFree(fNodes, fNodeCount * sizeof(Node));
+    if (fPaths)
+        IOFree(fPaths, (fPathMask + 1) * sizeof(uint32_t));
+    if (fCompatible)
+        IOFree(fCompatible, fCompatibleCount * sizeof(Key));
+    if (fPhandles)
+        IOFree(fPhandles, fPhandleCount * sizeof(Key));
+    OSSafeReleaseNULL(fBlob);
+    super::free();
+}
+
+// ---------- indexing ----------
+
+bool AndroidDeviceTree::index(void)
+{
+    fdt_header h;
+    uint32_t size = fBlob->getLength();
+
+    memcpy(&h, fBytes, sizeof(h));
+    uint32_t total = OSSwapBigToHostInt32(h.totalsize);
+    fStructOffset = OSSwapBigToHostInt32(h.off_dt_struct);
+    fStringsOffset = OSSwapBigToHostInt32(h.off_dt_strings);
+    fStringsSize = OSSwapBigToHostInt32(h.size_dt_strings);
+    fStructEnd = fStructOffset + OSSwapBigToHostInt32(h.size_dt_struct);
+
+    // version 17 is what dtc writes; 16 lacks size_dt_struct
+    if (OSSwapBigToHostInt32(h.magic) != FDT_MAGIC || total > size ||
+        OSSwapBigToHostInt32(h.version) < 17 || OSSwapBigToHostInt32(h.last_comp_version) > 17 ||
+        (fStructOffset & 3) || fStructEnd < fStructOffset || fStructEnd > total ||
+        fStringsOffset > total || fStringsSize > total - fStringsOffset)
+        return false;
+
+    // one pass to check it and count, a second to fill in the index
+    uint32_t *last = NULL;
+    uint32_t nodes = 0, compatible = 0, phandles = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        uint32_t offset = fStructOffset, cur = kNoNode, depth = 0, n = 0, c = 0, p = 0;
+        bool done = false;
+
+        while (!done) {
+            uint32_t token;
+
+            if (offset > fStructEnd || fStructEnd - offset < 4)
+                return false;
+            memcpy(&token, fBytes + offset, 4);
+            offset += 4;
+
+            switch (OSSwapBigToHostInt32(token)) {
+            case FDT_BEGIN_NODE: {
+                const char *name = (const char *)fBytes + offset;
+                const char *nul = (const char *)memchr(name, '\0', fStructEnd - offset);
+
+                if (!nul || (depth == 0 && n != 0))
+                    return false;               // unterminated, or a second root
+                if (pass) {
+                    Node *node = &fNodes[n];
+
+                    node->name = offset;
+                    node->parent = cur;
+                    node->child = node->sibling = last[n] = kNoNode;
+                    node->pathHash = cur == kNoNode ? kHashBasis
+                        : hashBytes(hashBytes(fNodes[cur].pathHash, "/", 1), name, nul - name);
+                    if (cur != kNoNode) {
+                        if (last[cur] == kNoNode)
+                            fNodes[cur].child = n;
+                        else
+                            fNodes[last[cur]].sibling = n;
+                        last[cur] = n;
+                    }
+                    cur = n;
+                }
+                n++;
+                depth++;
+                offset = align4(offset + (uint32_t)(nul - name) + 1);
+                break;
+            }
+
+            case FDT_END_NODE:
+                if (depth == 0)
+                    return false;
+                depth--;
+                if (pass)
+                    cur = fNodes[cur].parent;
+                break;
+
+            case FDT_PROP: {
+                uint32_t hdr[2];
+
+                if (depth == 0 || fStructEnd - offset < 8)
+                    return false;
+                memcpy(hdr, fBytes + offset, 8);
+                offset += 8;
+
+                uint32_t len = OSSwapBigToHostInt32(hdr[0]), nameoff = OSSwapBigToHostInt32(hdr[1]);
+                if (len > fStructEnd - offset || nameoff >= fStringsSize ||
+                    !memchr(fBytes + fStringsOffset + nameoff, '\0', fStringsSize - nameoff))
+                    return false;
+
+                const char *prop = (const char *)fBytes + fStringsOffset + nameoff;
+                const char *value = (const char *)fBytes + offset;
+
+                if (strcmp(prop, "compatible") == 0) {
+                    for (uint32_t i = 0; i < len;) {
+                        const char *nul = (const char *)memchr(value + i, '\0', len - i);
+                        uint32_t end = nul ? (uint32_t)(nul - value) : len;
+
+                        if (end > i) {
+                            if (pass)
+                                fCompatible[c] = (Key){ hashBytes(kHashBasis, value + i, end - i), cur };
+                            c++;
+                        }
+                        i = end + 1;
+                    }
+                } else if (len == 4 && (strcmp(prop, "phandle") == 0 || strcmp(prop, "linux,phandle") == 0)) {
+                    uint32_t phandle;
+
+                    memcpy(&phandle, value, 4);
+                    if (pass)
+                        fPhandles[p] = (Key){ OSSwapBigToHostInt32(phandle), cur };
+                    p++;
+                }
+                offset = align4(offset + len);
+                break;
+            }
+
+            case FDT_NOP:
+                break;
+
+            case FDT_END:
+                if (depth != 0 || n == 0)
+                    return false;
+                done = true;
+                break;
+
+            default:
+                return false;
+            }
+        }
+
+        if (pass == 0) {
+            nodes = n;
+            compatible = c;
+            phandles = p;
+
+            fPathMask = 15;
+            while (fPathMask + 1 < nodes * 2)
+                fPathMask = fPathMask * 2 + 1;
+
+            fNodes = (Node *)IOMalloc(nodes * sizeof(Node));
+            fPaths = (uint32_t *)IOMalloc((fPathMask + 1) * sizeof(uint32_t));
+            fCompatible = compatible ? (Key *)IOMalloc(compatible * sizeof(Key)) : NULL;
+            fPhandles = phandles ? (Key *)IOMalloc(phandles * sizeof(Key)) : NULL;
+            last = (uint32_t *)IOMalloc(nodes * sizeof(uint32_t));
+            fNodeCount = fNodes ? nodes : 0;
+            fCompatibleCount = fCompatible ? compatible : 0;
+            fPhandleCount = fPhandles ? phandles : 0;
+            if (!fNodes || !fPaths || (compatible && !fCompatible) || (phandles && !fPhandles) || !last) {
+                if (last)
+                    IOFree(last, nodes * sizeof(uint32_t));
+                if (!fPaths)
+                    fPathMask = 0;
+                return false;
+            }
+        }
+    }
+    IOFree(last, nodes * sizeof(uint32_t));
+
+    memset(fPaths, 0xFF, (fPathMask + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < fNodeCount; i++) {
+        uint32_t slot = fNodes[i].pathHash & fPathMask;
+
+        while (fPaths[slot] != kNoNode)
+            slot = (slot + 1) & fPathMask;
+        fPaths[slot] = i;
+    }
+
+    // (hash, node) is unique enough to make the order deterministic
+    qsort(fCompatible, fCompatibleCount, sizeof(Key), compareKeys);
+    qsort(fPhandles, fPhandleCount, sizeof(Key), compareKeys);
+    return true;
+}
+
+// ---------- lookups ----------
+
+uint32_t AndroidDeviceTree::props(uint32_t node) const
+{
+    const char *name = (const char *)fBytes + fNodes[node].name;
+
+    return align4(fNodes[node].name + (uint32_t)strlen(name) + 1);
+}
+
+// Walk up from `node` while eating components off the end of `path`
+bool AndroidDeviceTree::pathMatches(uint32_t node, const char *path, size_t length) const
+{
+    for (;;) {
+        while (length && path[length - 1] == '/')
+            length--;
+        if (node == 0)
+            return length == 0;
+
+        size_t start = length;
+        while (start && path[start - 1] != '/')
+            start--;
+
+        const char *name = (const char *)fBytes + fNodes[node].name;
+        if (strlen(name) != length - start || memcmp(name, path + start, length - start) != 0)
+            return false;
+        length = start;
+        node = fNodes[node].parent;
+    }
+}
+
+uint32_t AndroidDeviceTree::lookupPath(const char *path, size_t length) const
+{
+    uint32_t h = kHashBasis;
+
+    for (size_t i = 0; i < length;) {
+        while (i < length && path[i] == '/')
+            i++;
+        size_t start = i;
+        while (i < length && path[i] != '/')
+            i++;
+        if (i > start)
+            h = hashBytes(hashBytes(h, "/", 1), path + start, i - start);
+    }
+
+    for (uint32_t slot = h & fPathMask; fPaths[slot] != kNoNode; slot = (slot + 1) & fPathMask) {
+        uint32_t node = fPaths[slot];
+
+        if (fNodes[node].pathHash == h && pathMatches(node, path, length))
+            return node;
+    }
+    return kNoNode;
+}
+
+uint32_t AndroidDeviceTree::findPath(const char *path) const
+{
+    if (!path)
+        return kNoNode;
+    if (path[0] == '/')
+        return lookupPath(path, strlen(path));
+
+    // "serial0/..." resolves through /aliases
+    const char *rest = strchr(path, '/');
+    size_t aliasLength = rest ? (size_t)(rest - path) : strlen(path);
+    char alias[64];
+    uint32_t aliases = lookupPath("/aliases", 8), length;
+
+    if (aliases == kNoNode || aliasLength >= sizeof(alias))
+        return kNoNode;
+    memcpy(alias, path, aliasLength);
+    alias[aliasLength] = '\0';
+
+    const char *target = (const char *)getProperty(aliases, alias, &length);
+    if (!target || !length || target[0] != '/' || !memchr(target, '\0', length))
+        return kNoNode;
+    if (!rest)
+        return lookupPath(target, strlen(target));
+
+    char full[256];
+    size_t targetLength = strlen(target), restLength = strlen(rest);
+    if (targetLength + restLength >= sizeof(full))
+        return kNoNode;
+    memcpy(full, target, targetLength);
+    memcpy(full + targetLength, rest, restLength);
+    return lookupPath(full, targetLength + restLength);
+}
+
+const AndroidDeviceTree::Key *AndroidDeviceTree::lowerBound(const Key *keys, uint32_t count, uint32_t key) const
+{
+    uint32_t lo = 0, hi = count;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (keys[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return keys + lo;
+}
+
+uint32_t AndroidDeviceTree::findPhandle(uint32_t phandle) const
+{
+    const Key *k = lowerBound(fPhandles, fPhandleCount, phandle);
+
+    return k < fPhandles + fPhandleCount && k->key == phandle ? k->node : kNoNode;
+}
+
+uint32_t AndroidDeviceTree::findCompatible(const char *compatible, uint32_t index) const
+{
+    uint32_t h = hashBytes(kHashBasis, compatible, strlen(compatible)), previous = kNoNode;
+    const Key *end = fCompatible + fCompatibleCount;
+
+    for (const Key *k = lowerBound(fCompatible, fCompatibleCount, h); k < end && k->key == h; k++) {
+        // a node listing the string twice, or another string of the same hash
+        if (k->node == previous || !isCompatible(k->node, compatible))
+            continue;
+        previous = k->node;
+        if (index-- == 0)
+            return k->node;
+    }
+    return kNoNode;
+}
+
+bool AndroidDeviceTree::isCompatible(uint32_t node, const char *compatible) const
+{
+    uint32_t length;
+    const char *list = (const char *)getProperty(node, "compatible", &length);
+    size_t want = strlen(compatible);
+
+    for (uint32_t i = 0; list && i < length;) {
+        const char *nul = (const char *)memchr(list + i, '\0', length - i);
+        uint32_t end = nul ? (uint32_t)(nul - list) : length;
+
+        if (end - i == want && memcmp(list + i, compatible, want) == 0)
+            return true;
+        i = end + 1;
+    }
+    return false;
+}
+
+uint32_t AndroidDeviceTree::parent(uint32_t node) const
+{
+    return node < fNodeCount ? fNodes[node].parent : kNoNode;
+}
+
+uint32_t AndroidDeviceTree::firstChild(uint32_t node) const
+{
+    return node < fNodeCount ? fNodes[node].child : kNoNode;
+}
+
+uint32_t AndroidDeviceTree::nextSibling(uint32_t node) const
+{
+    return node < fNodeCount ? fNodes[node].sibling : kNoNode;
+}
+
+const char *AndroidDeviceTree::name(uint32_t node) const
+{
+    return node < fNodeCount ? (const char *)fBytes + fNodes[node].name : NULL;
+}
+
+// ---------- properties ----------
+
+// index() checked every token, so these walks need no bounds checks
+uint32_t AndroidDeviceTree::nextProperty(uint32_t node, uint32_t cursor, const char **name,
+                                         const void **value, uint32_t *length) const
+{
+    if (node >= fNodeCount)
+        return 0;
+
+    uint32_t offset = cursor ? cursor : props(node);
+    for (;;) {
+        uint32_t token, hdr[2];
+
+        memcpy(&token, fBytes + offset, 4);
+        token = OSSwapBigToHostInt32(token);
+        if (token == FDT_NOP) {
+            offset += 4;
+            continue;
+        }
+        if (token != FDT_PROP)
+            return 0;                           // properties come before children
+
+        memcpy(hdr, fBytes + offset + 4, 8);
+        uint32_t len = OSSwapBigToHostInt32(hdr[0]);
+
+        *name = (const char *)fBytes + fStringsOffset + OSSwapBigToHostInt32(hdr[1]);
+        *value = fBytes + offset + 12;
+        if (length)
+            *length = len;
+        return align4(offset + 12 + len);
+    }
+}
+
+const void *AndroidDeviceTree::getProperty(uint32_t node, const char *name, uint32_t *length) const
+{
+    const char *prop;
+    const void *value;
+    uint32_t len;
+
+    for (uint32_t c = nextProperty(node, 0, &prop, &value, &len); c; c = nextProperty(node, c, &prop, &value, &len)) {
+        if (strcmp(prop, name) == 0) {
+            if (length)
+                *length = len;
+            return value;
+        }
+    }
+    return NULL;
+}
+
+bool AndroidDeviceTree::getCell(uint32_t node, const char *name, uint32_t *value) const
+{
+    uint32_t length;
+    const void *bytes = getProperty(node, name, &length);
+
+    if (!bytes || length != 4)
+        return false;
+    memcpy(value, bytes, 4);
+    *value = OSSwapBigToHostInt32(*value);
+    return true;
+}
+
+OSData *AndroidDeviceTree::copyProperty(uint32_t node, const char *name) const
+{
+    uint32_t length;
+    const void *bytes = getProperty(node, name, &length);
+
+    return bytes ? OSData::withBytesNoCopy((void *)bytes, length) : NULL;
+}
+
+// ---------- nubs ----------
+
+#undef super
+#define super IOService
+OSDefineMetaClassAndStructors(AndroidDeviceTreeNub, IOService)
+
+AndroidDeviceTreeNub *AndroidDeviceTreeNub::withNode(AndroidDeviceTree *tree, uint32_t node)
+{
+    const char *name = tree->name(node);
+    AndroidDeviceTreeNub *nub = new AndroidDeviceTreeNub;
+
+    if (!name || !nub || !nub->init()) {
+        OSSafeReleaseNULL(nub);
+        return NULL;
+    }
+
+    tree->retain();
+    nub->fTree = tree;
+    nub->fNode = node;
+
+    // "serial@ff000000": named "serial", at "ff000000", as IODeviceTree does it
+    const char *at = strchr(name, '@');
+    char base[64];
+    size_t length = at ? (size_t)(at - name) : strlen(name);
+
+    if (length >= sizeof(base))
+        length = sizeof(base) - 1;
+    memcpy(base, name, length);
+    base[length] = '\0';
+    nub->setName(base);
+    if (at)
+        nub->setLocation(at + 1);
+
+    const char *prop;
+    const void *value;
+    uint32_t len;
+    for (uint32_t c = tree->nextProperty(node, 0, &prop, &value, &len); c;
+         c = tree->nextProperty(node, c, &prop, &value, &len)) {
+        OSData *data = OSData::withBytesNoCopy((void *)value, len);
+        if (data) {
+            nub->setProperty(prop, data);
+            data->release();
+        }
+    }
+    return nub;
+}
+
+void AndroidDeviceTreeNub::free(void)
+{
+    OSSafeReleaseNULL(fTree);
+    super::free();
+}
+
+bool AndroidDeviceTreeNub::compareName(OSString *name, OSString **matched) const
+{
+    if (fTree && fTree->isCompatible(fNode, name->getCStringNoCopy())) {
+        if (matched) {
+            name->retain();
+            *matched = name;
+        }
+        return true;
+    }
+    return super::compareName(name, matched);
+}
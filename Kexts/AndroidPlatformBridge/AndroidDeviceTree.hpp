@@ -0,0 +1,110 @@
+#ifndef ANDROIDDEVICETREE_HPP
+#define ANDROIDDEVICETREE_HPP
+
+#include <IOKit/IOService.h>
+#include <libkern/c++/OSData.h>
+
+// The loader's flattened device tree (the Android DTB, BootParams.h's
+// fdt), indexed in one pass over the blob: every node by full path, and
+// by each string of its "compatible" and its phandle. Nothing else is
+// converted up front. Properties come out as OSData views into the blob,
+// made when someone asks for them, and valid as long as the tree is.
+//
+// Nodes are numbers in document order, root 0. Paths are exact, unit
+// addresses included ("/memory@80000000"), or start with an alias.
+class AndroidDeviceTree : public OSObject
+{
+    OSDeclareDefaultStructors(AndroidDeviceTree)
+
+public:
+    static const uint32_t kNoNode = 0xFFFFFFFF;
+
+    // Index `blob`, which is retained; NULL if it is no valid FDT
+    static AndroidDeviceTree *withData(OSData *blob);
+
+    uint32_t nodeCount(void) const { return fNodeCount; }
+
+    uint32_t findPath(const char *path) const;
+    uint32_t findPhandle(uint32_t phandle) const;
+
+    // The `index`-th node (document order) compatible with `compatible`,
+    // kNoNode past the last
+    uint32_t findCompatible(const char *compatible, uint32_t index = 0) const;
+    bool isCompatible(uint32_t node, const char *compatible) const;
+
+    uint32_t parent(uint32_t node) const;
+    uint32_t firstChild(uint32_t node) const;
+    uint32_t nextSibling(uint32_t node) const;
+    const char *name(uint32_t node) const;      // "cpu@0", "" for the root
+
+    // Raw (big-endian) bytes of a property, NULL if the node has none
+    const void *getProperty(uint32_t node, const char *name, uint32_t *length = NULL) const;
+    bool getCell(uint32_t node, const char *name, uint32_t *value) const;
+
+    // The same bytes as an OSData that doesn't copy them; caller releases
+    OSData *copyProperty(uint32_t node, const char *name) const;
+
+    // Every property of a node: start with cursor 0, stop when it returns 0
+    uint32_t nextProperty(uint32_t node, uint32_t cursor, const char **name,
+                          const void **value, uint32_t *length) const;
+
+protected:
+    virtual void free(void) override;
+
+private:
+    struct Node {
+        uint32_t name;          // blob offset of the NUL-terminated name
+        uint32_t parent;
+        uint32_t child;         // first, kNoNode if none
+        uint32_t sibling;       // next, kNoNode if none
+        uint32_t pathHash;
+    };
+
+    struct Key {                // compatible and phandle index entries
+        uint32_t key;           // string hash or phandle
+        uint32_t node;
+    };
+
+    bool index(void);
+    uint32_t props(uint32_t node) const;
+    bool pathMatches(uint32_t node, const char *path, size_t length) const;
+    uint32_t lookupPath(const char *path, size_t length) const;
+    const Key *lowerBound(const Key *keys, uint32_t count, uint32_t key) const;
+
+    OSData *fBlob;
+    const uint8_t *fBytes;
+    uint32_t fStructOffset, fStructEnd;
+    uint32_t fStringsOffset, fStringsSize;
+
+    Node *fNodes;
+    uint32_t fNodeCount;
+    uint32_t *fPaths;           // open-addressed by pathHash, kNoNode empty
+    uint32_t fPathMask;
+    Key *fCompatible;           // sorted by (hash, node)
+    uint32_t fCompatibleCount;
+    Key *fPhandles;             // sorted by phandle
+    uint32_t fPhandleCount;
+};
+
+// A device tree node published for matching. IONameMatch compares
+// against every string of its "compatible", as it does on Apple's
+// device tree nubs; its properties are views into the tree.
+class AndroidDeviceTreeNub : public IOService
+{
+    OSDeclareDefaultStructors(AndroidDeviceTreeNub)
+
+public:
+    static AndroidDeviceTreeNub *withNode(AndroidDeviceTree *tree, uint32_t node);
+
+    uint32_t node(void) const { return fNode; }
+
+    virtual bool compareName(OSString *name, OSString **matched = NULL) const override;
+
+protected:
+    virtual void free(void) override;
+
+private:
+    AndroidDeviceTree *fTree;
+    uint32_t fNode;
+};
+#endif // ANDROIDDEVICETREE_HPP
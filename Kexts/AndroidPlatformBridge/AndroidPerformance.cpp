@@ -0,0 +1,538 @@
+#include "AndroidPerformance.hpp"
+#include <IOKit/IOLib.h>
+#include <IOKit/IOWorkLoop.h>
+#include <kern/clock.h>
+#include <libkern/OSByteOrder.h>
+#include <libkern/c++/OSDictionary.h>
+#include <libkern/c++/OSNumber.h>
+
+#define super OSObject
+OSDefineMetaClassAndStructors(AndroidPerformance, OSObject)
+
+static uint64_t nanosecondsSince(uint64_t then, uint64_t now)
+{
+    uint64_t ns;
+
+    absolutetime_to_nanoseconds(now - then, &ns);
+    return ns;
+}
+
+AndroidPerformance *AndroidPerformance::withDeviceTree(AndroidDeviceTree *tree, IOService *owner)
+{
+    AndroidPerformance *perf = new AndroidPerformance;
+
+    if (!perf || !perf->init() || !(perf->fLock = IOLockAlloc()) || !perf->discover(tree)) {
+        OSSafeReleaseNULL(perf);
+        return NULL;
+    }
+
+    IOWorkLoop *loop = owner->getWorkLoop();
+    perf->fOwner = owner;
+    perf->fLastAccount = mach_absolute_time();
+    perf->fTimer = IOTimerEventSource::timerEventSource(perf, timerFired);
+    if (!loop || !perf->fTimer || loop->addEventSource(perf->fTimer) != kIOReturnSuccess) {
+        OSSafeReleaseNULL(perf->fTimer);
+        perf->release();
+        return NULL;
+    }
+    return perf;
+}
+
+void AndroidPerformance::stop(void)
+{
+    // user clients may keep this past the bridge's stop(); leave the CPU driver alone then
+    if (fLock) {
+        IOLockLock(fLock);
+        fHaveBackend = false;
+        IOLockUnlock(fLock);
+    }
+    if (fTimer) {
+        fTimer->cancelTimeout();
+        fTimer->getWorkLoop()->removeEventSource(fTimer);
+        OSSafeReleaseNULL(fTimer);
+    }
+}
+
+void AndroidPerformance::free(void)
+{
+    stop();
+    if (fLock)
+        IOLockFree(fLock);
+    super::free();
+}
+
+// ---------- topology ----------
+
+static bool isCPU(AndroidDeviceTree *tree, uint32_t node)
+{
+    uint32_t length;
+    const char *type = (const char *)tree->getProperty(node, "device_type", &length);
+
+    if (type)
+        return length == 4 && memcmp(type, "cpu", 4) == 0;
+    return strncmp(tree->name(node), "cpu@", 4) == 0;
+}
+
+bool AndroidPerformance::discover(AndroidDeviceTree *tree)
+{
+    uint32_t cpus = tree->findPath("/cpus");
+
+    for (uint32_t n = tree->firstChild(cpus); n != AndroidDeviceTree::kNoNode; n = tree->nextSibling(n))
+        if (isCPU(tree, n) && fCPUCount < kMaxCPUs)
+            fCPUNodes[fCPUCount++] = n;
+    if (fCPUCount == 0)
+        return false;
+
+    uint32_t map = tree->findPath("/cpus/cpu-map"), cluster = 0;
+    if (map != AndroidDeviceTree::kNoNode)
+        walkCpuMap(tree, map, &cluster);
+
+    if (fClusterCount == 0) {
+        // no cpu-map: CPUs sharing an operating point table share a clock
+        for (uint32_t i = 0; i < fCPUCount; i++) {
+            uint32_t table = 0, dmips = 0, c = 0;
+
+            tree->getCell(fCPUNodes[i], "operating-points-v2", &table);
+            tree->getCell(fCPUNodes[i], "capacity-dmips-mhz", &dmips);
+            while (c < fClusterCount && (fClusters[c].oppTable != table || fClusters[c].dmips != dmips))
+                c++;
+            if (c == PD_MAX_CLUSTERS)
+                continue;
+            fClusters[c].oppTable = table;
+            fClusters[c].dmips = dmips;
+            addCPU(fCPUNodes[i], c);
+        }
+    }
+
+    // capacity-dmips-mhz times the top frequency, the biggest at 1024;
+    // without dmips on every cluster all are taken as equal, as Linux does
+    uint64_t biggest = 0, raw[PD_MAX_CLUSTERS];
+    bool dmips = true;
+
+    for (uint32_t c = 0; c < fClusterCount; c++) {
+        Cluster *cl = &fClusters[c];
+        uint32_t first = fCPUNodes[cl->cpus[0]];
+
+        dmips = tree->getCell(first, "capacity-dmips-mhz", &cl->dmips) && cl->dmips && dmips;
+        readLevels(tree, cl, first);
+    }
+    for (uint32_t c = 0; c < fClusterCount; c++) {
+        Cluster *cl = &fClusters[c];
+        uint64_t mhz = cl->frequency[cl->levelCount - 1] / 1000000;
+
+        raw[c] = (dmips ? cl->dmips : 1) * (mhz ? mhz : 1);
+        if (raw[c] > biggest)
+            biggest = raw[c];
+    }
+    for (uint32_t c = 0; c < fClusterCount; c++)
+        fClusters[c].capacity = (uint32_t)(raw[c] * 1024 / biggest);
+
+    return fClusterCount != 0;
+}
+
+// cpu-map: socketN and clusterN nest; a node with coreN children is a cluster
+void AndroidPerformance::walkCpuMap(AndroidDeviceTree *tree, uint32_t node, uint32_t *cluster)
+{
+    bool cores = false;
+
+    for (uint32_t n = tree->firstChild(node); n != AndroidDeviceTree::kNoNode; n = tree->nextSibling(n))
+        cores = cores || strncmp(tree->name(n), "core", 4) == 0;
+
+    if (!cores) {
+        for (uint32_t n = tree->firstChild(node); n != AndroidDeviceTree::kNoNode; n = tree->nextSibling(n))
+            walkCpuMap(tree, n, cluster);
+        return;
+    }
+    if (*cluster == PD_MAX_CLUSTERS)
+        return;
+
+    for (uint32_t core = tree->firstChild(node); core != AndroidDeviceTree::kNoNode; core = tree->nextSibling(core)) {
+        uint32_t phandle;
+
+        if (tree->getCell(core, "cpu", &phandle)) {
+            addCPU(tree->findPhandle(phandle), *cluster);
+            continue;
+        }
+        for (uint32_t t = tree->firstChild(core); t != AndroidDeviceTree::kNoNode; t = tree->nextSibling(t))
+            if (tree->getCell(t, "cpu", &phandle))
+                addCPU(tree->findPhandle(phandle), *cluster);
+    }
+    if (fClusters[*cluster].cpuCount)
+        (*cluster)++;
+}
+
+void AndroidPerformance::addCPU(uint32_t node, uint32_t cluster)
+{
+    uint32_t cpu = 0;
+    while (cpu < fCPUCount && fCPUNodes[cpu] != node)
+        cpu++;
+    if (cpu == fCPUCount)
+        return;
+
+    // each CPU in one cluster only
+    for (uint32_t c = 0; c < fClusterCount; c++)
+        for (uint32_t i = 0; i < fClusters[c].cpuCount; i++)
+            if (fClusters[c].cpus[i] == cpu)
+                return;
+
+    Cluster *cl = &fClusters[cluster];
+    cl->cpus[cl->cpuCount++] = cpu;
+    if (cluster >= fClusterCount)
+        fClusterCount = cluster + 1;
+}
+
+// Insert by frequency: tables are short, and not always ascending. One
+// too long for PD_MAX_LEVELS keeps its fastest.
+static void addLevel(uint64_t *hz, uint32_t *uv, uint32_t *count, uint64_t frequency, uint32_t microvolts)
+{
+    uint32_t i = 0;
+
+    while (i < *count && hz[i] < frequency)
+        i++;
+    if (i < *count && hz[i] == frequency)
+        return;
+    if (*count == PD_MAX_LEVELS) {
+        if (i == 0)
+            return;
+        memmove(&hz[0], &hz[1], (i - 1) * sizeof(*hz));
+        memmove(&uv[0], &uv[1], (i - 1) * sizeof(*uv));
+        hz[i - 1] = frequency;
+        uv[i - 1] = microvolts;
+        return;
+    }
+    memmove(&hz[i + 1], &hz[i], (*count - i) * sizeof(*hz));
+    memmove(&uv[i + 1], &uv[i], (*count - i) * sizeof(*uv));
+    hz[i] = frequency;
+    uv[i] = microvolts;
+    (*count)++;
+}
+
+void AndroidPerformance::readLevels(AndroidDeviceTree *tree, Cluster *c, uint32_t cpu)
+{
+    uint32_t phandle, length;
+    uint32_t table = tree->getCell(cpu, "operating-points-v2", &phandle)
+        ? tree->findPhandle(phandle) : AndroidDeviceTree::kNoNode;
+
+    for (uint32_t opp = tree->firstChild(table); opp != AndroidDeviceTree::kNoNode; opp = tree->nextSibling(opp)) {
+        const uint32_t *hz = (const uint32_t *)tree->getProperty(opp, "opp-hz", &length);
+        const uint32_t *uv;
+        uint32_t uvLength, cells[2], microvolts = 0;
+
+        if (!hz || length < 8)
+            continue;
+        memcpy(cells, hz, 8);
+        uv = (const uint32_t *)tree->getProperty(opp, "opp-microvolt", &uvLength);
+        if (uv && uvLength >= 4) {
+            memcpy(&microvolts, uv, 4);
+            microvolts = OSSwapBigToHostInt32(microvolts);
+        }
+        addLevel(c->frequency, c->microvolts, &c->levelCount,
+                 (uint64_t)OSSwapBigToHostInt32(cells[0]) << 32 | OSSwapBigToHostInt32(cells[1]), microvolts);
+    }
+
+    // the older binding: <kHz uV> pairs on the CPU itself
+    const uint8_t *legacy = c->levelCount ? NULL : (const uint8_t *)tree->getProperty(cpu, "operating-points", &length);
+    for (uint32_t i = 0; legacy && i + 8 <= length; i += 8) {
+        uint32_t cells[2];
+
+        memcpy(cells, legacy + i, 8);
+        addLevel(c->frequency, c->microvolts, &c->levelCount,
+                 (uint64_t)OSSwapBigToHostInt32(cells[0]) * 1000, OSSwapBigToHostInt32(cells[1]));
+    }
+
+    if (c->levelCount == 0) {
+        uint32_t hz = 0;
+
+        tree->getCell(cpu, "clock-frequency", &hz);
+        c->frequency[0] = hz;
+        c->levelCount = 1;
+    }
+
+    // whatever the previous stage left it at; the governor takes over
+    // once there is a backend
+    c->level = c->levelCount - 1;
+}
+
+OSArray *AndroidPerformance::copyTopology(void) const
+{
+    OSArray *clusters = OSArray::withCapacity(fClusterCount);
+
+    for (uint32_t c = 0; clusters && c < fClusterCount; c++) {
+        const Cluster *cl = &fClusters[c];
+        OSDictionary *dict = OSDictionary::withCapacity(4);
+        OSArray *cpus = OSArray::withCapacity(cl->cpuCount);
+        OSArray *hz = OSArray::withCapacity(cl->levelCount);
+        OSArray *uv = OSArray::withCapacity(cl->levelCount);
+        OSNumber *capacity = OSNumber::withNumber(cl->capacity, 32);
+
+        for (uint32_t i = 0; cpus && i < cl->cpuCount; i++) {
+            OSNumber *n = OSNumber::withNumber(cl->cpus[i], 32);
+            if (n) {
+                cpus->setObject(n);
+                n->release();
+            }
+        }
+        for (uint32_t i = 0; hz && uv && i < cl->levelCount; i++) {
+            OSNumber *f = OSNumber::withNumber(cl->frequency[i], 64);
+            OSNumber *v = OSNumber::withNumber(cl->microvolts[i], 32);
+            if (f && v) {
+                hz->setObject(f);
+                uv->setObject(v);
+            }
+            OSSafeReleaseNULL(f);
+            OSSafeReleaseNULL(v);
+        }
+
+        if (dict && cpus && hz && uv && capacity) {
+            dict->setObject("CPUs", cpus);
+            dict->setObject("Capacity", capacity);
+            dict->setObject("Frequencies", hz);
+            dict->setObject("Microvolts", uv);
+            clusters->setObject(dict);
+        }
+        OSSafeReleaseNULL(cpus);
+        OSSafeReleaseNULL(hz);
+        OSSafeReleaseNULL(uv);
+        OSSafeReleaseNULL(capacity);
+        OSSafeReleaseNULL(dict);
+    }
+    return clusters;
+}
+
+// ---------- requests ----------
+
+// The lowest level at or above `frequency`, the top one if none is
+uint32_t AndroidPerformance::levelFor(const Cluster *c, uint64_t frequency) const
+{
+    uint32_t level = 0;
+
+    while (level + 1 < c->levelCount && c->frequency[level] < frequency)
+        level++;
+    return level;
+}
+
+// What the live requests allow `cluster`, dropping the expired ones
+void AndroidPerformance::bounds(uint32_t cluster, uint32_t *low, uint32_t *high)
+{
+    const Cluster *c = &fClusters[cluster];
+    uint64_t top = c->frequency[c->levelCount - 1], now = mach_absolute_time();
+
+    *low = 0;
+    *high = c->levelCount - 1;
+    for (uint32_t i = 0; i < kMaxRequests; i++) {
+        Request *r = &fRequests[i];
+
+        if (r->id && r->deadline && now >= r->deadline)
+            r->id = 0;
+        if (!r->id || (r->cluster != PD_ALL_CLUSTERS && r->cluster != cluster))
+            continue;
+
+        uint32_t floor = r->minPermille ? levelFor(c, top * r->minPermille / 1000) : 0;
+        uint32_t ceiling = levelFor(c, top * r->maxPermille / 1000);
+        if (c->frequency[ceiling] * 1000 > top * r->maxPermille && ceiling > 0)
+            ceiling--;                  // levelFor() rounds up; a ceiling rounds down
+
+        if (floor > *low)
+            *low = floor;
+        if (ceiling < *high)
+            *high = ceiling;
+    }
+    if (*low > *high)
+        *low = *high;                   // a ceiling wins over a floor
+}
+
+void AndroidPerformance::setLevel(uint32_t cluster, uint32_t level)
+{
+    Cluster *c = &fClusters[cluster];
+
+    if (level == c->level || !fHaveBackend)
+        return;
+    if (fBackend.setLevel(fBackend.context, cluster, level) == kIOReturnSuccess) {
+        c->level = level;
+        c->transitions++;
+    }
+}
+
+void AndroidPerformance::applyRequests(void)
+{
+    account(mach_absolute_time());
+    for (uint32_t c = 0; c < fClusterCount; c++) {
+        uint32_t low, high, level = fClusters[c].level;
+
+        bounds(c, &low, &high);
+        setLevel(c, level < low ? low : level > high ? high : level);
+    }
+}
+
+uint32_t AndroidPerformance::request(uint32_t cluster, uint32_t minPermille, uint32_t maxPermille,
+                                     uint32_t timeoutMs, void *client)
+{
+    uint32_t id = 0;
+
+    if ((cluster != PD_ALL_CLUSTERS && cluster >= fClusterCount) || minPermille > 1000 ||
+        maxPermille > 1000 || maxPermille == 0)
+        return 0;
+
+    IOLockLock(fLock);
+    for (uint32_t i = 0; i < kMaxRequests; i++) {
+        Request *r = &fRequests[i];
+
+        if (r->id && r->deadline && mach_absolute_time() >= r->deadline)
+            r->id = 0;
+        if (r->id)
+            continue;
+
+        if (++fNextId == 0)
+            fNextId = 1;
+        id = r->id = fNextId;
+        r->cluster = cluster;
+        r->minPermille = minPermille;
+        r->maxPermille = maxPermille;
+        r->deadline = 0;
+        if (timeoutMs)
+            clock_interval_to_deadline(timeoutMs, kMillisecondScale, &r->deadline);
+        r->client = client;
+        break;
+    }
+    // a boost is wanted now, not at the next sample
+    if (id)
+        applyRequests();
+    IOLockUnlock(fLock);
+    return id;
+}
+
+void AndroidPerformance::releaseRequest(uint32_t id, void *client)
+{
+    IOLockLock(fLock);
+    for (uint32_t i = 0; id && i < kMaxRequests; i++)
+        if (fRequests[i].id == id && fRequests[i].client == client)
+            fRequests[i].id = 0;
+    applyRequests();
+    IOLockUnlock(fLock);
+}
+
+void AndroidPerformance::releaseRequests(void *client)
+{
+    IOLockLock(fLock);
+    for (uint32_t i = 0; i < kMaxRequests; i++)
+        if (fRequests[i].client == client)
+            fRequests[i].id = 0;
+    applyRequests();
+    IOLockUnlock(fLock);
+}
+
+// ---------- governor ----------
+
+void AndroidPerformance::registerBackend(const AndroidPerformanceBackend *backend)
+{
+    IOLockLock(fLock);
+    fBackend = *backend;
+    fHaveBackend = true;
+    for (uint32_t cpu = 0; cpu < fCPUCount; cpu++)
+        fLastBusy[cpu] = fBackend.busyTime(fBackend.context, cpu);
+    fLastSample = mach_absolute_time();
+    applyRequests();
+    IOLockUnlock(fLock);
+
+    if (fTimer)
+        fTimer->setTimeoutMS(kSamplePeriodMs);
+}
+
+// Time since the last call goes to the level each cluster ran at
+void AndroidPerformance::account(uint64_t now)
+{
+    uint64_t elapsed = nanosecondsSince(fLastAccount, now);
+
+    for (uint32_t c = 0; c < fClusterCount; c++)
+        fClusters[c].residencyNs[fClusters[c].level] += elapsed;
+    fLastAccount = now;
+}
+
+void AndroidPerformance::sample(void)
+{
+    uint64_t now = mach_absolute_time();
+    uint64_t elapsed = nanosecondsSince(fLastSample, now);
+
+    if (!elapsed)
+        return;
+    account(now);
+    fLastSample = now;
+
+    for (uint32_t c = 0; c < fClusterCount; c++) {
+        Cluster *cl = &fClusters[c];
+        uint64_t busiest = 0;
+
+        for (uint32_t i = 0; i < cl->cpuCount; i++) {
+            uint32_t cpu = cl->cpus[i];
+            uint64_t busy = fBackend.busyTime(fBackend.context, cpu);
+            uint64_t delta = busy - fLastBusy[cpu];
+
+            fLastBusy[cpu] = busy;
+            cl->busyNs += delta;
+            if (delta > busiest)
+                busiest = delta;
+        }
+        cl->utilization = busiest >= elapsed ? 1000 : (uint32_t)(busiest * 1000 / elapsed);
+
+        // the frequency that would have kept it at the target
+        uint32_t wanted = levelFor(cl, cl->frequency[cl->level] * cl->utilization / kTargetPermille);
+        uint32_t target = cl->level;
+
+        if (wanted > cl->level) {
+            target = wanted;
+            cl->hold = 0;
+        } else if (wanted < cl->level) {
+            cl->holdWanted = cl->hold ? (wanted > cl->holdWanted ? wanted : cl->holdWanted) : wanted;
+            if (++cl->hold >= kDownHoldSamples) {
+                target = cl->holdWanted;
+                cl->hold = 0;
+            }
+        } else {
+            cl->hold = 0;
+        }
+
+        uint32_t low, high;
+        bounds(c, &low, &high);
+        setLevel(c, target < low ? low : target > high ? high : target);
+    }
+}
+
+void AndroidPerformance::timerFired(OSObject *owner, IOTimerEventSource *timer)
+{
+    AndroidPerformance *perf = OSDynamicCast(AndroidPerformance, owner);
+
+    if (!perf)
+        return;
+    IOLockLock(perf->fLock);
+    bool running = perf->fHaveBackend;     // false once stop() has begun
+    if (running)
+        perf->sample();
+    IOLockUnlock(perf->fLock);
+    if (running)
+        timer->setTimeoutMS(kSamplePeriodMs);
+}
+
+uint32_t AndroidPerformance::copyStatistics(pd_cluster_stats_t *stats, uint32_t count)
+{
+    IOLockLock(fLock);
+    account(mach_absolute_time());
+
+    uint32_t n = count < fClusterCount ? count : fClusterCount;
+    for (uint32_t c = 0; c < n; c++) {
+        const Cluster *cl = &fClusters[c];
+        pd_cluster_stats_t *s = &stats[c];
+
+        bzero(s, sizeof(*s));
+        s->cpus = cl->cpuCount;
+        s->capacity = cl->capacity;
+        s->level = cl->level;
+        s->level_count = cl->levelCount;
+        s->frequency = cl->frequency[cl->level];
+        s->utilization = cl->utilization;
+        s->transitions = cl->transitions;
+        s->busy_ns = cl->busyNs;
+        memcpy(s->residency_ns, cl->residencyNs, sizeof(s->residency_ns));
+    }
+    IOLockUnlock(fLock);
+    return n;
+}
@@ -0,0 +1,133 @@
+#ifndef ANDROIDPERFORMANCE_HPP
+#define ANDROIDPERFORMANCE_HPP
+
+#include <IOKit/IOLocks.h>
+#include <IOKit/IOTimerEventSource.h>
+#include <libkern/c++/OSArray.h>
+
+#include "AndroidDeviceTree.hpp"
+#include "AndroidPlatformShared.h"
+
+// What drives the hardware, registered by the SoC's cpufreq driver
+// (cpufreq-hw, SCMI, ...). Without one the topology is still published
+// and requests are kept, but no level changes.
+struct AndroidPerformanceBackend {
+    void *context;
+
+    // Run `cluster` at operating point `level`
+    IOReturn (*setLevel)(void *context, uint32_t cluster, uint32_t level);
+
+    // Nanoseconds `cpu` (as numbered in the device tree's /cpus) has been
+    // busy since boot; only differences are used
+    uint64_t (*busyTime)(void *context, uint32_t cpu);
+};
+
+// CPU clusters and their performance levels, from the device tree:
+// clusters from /cpus/cpu-map (CPUs grouped by operating point table
+// without one), each with its operating-points-v2 (or legacy
+// operating-points) table and a capacity from capacity-dmips-mhz times
+// the top frequency, 1024 for the biggest, the way Linux computes it.
+//
+// The governor samples every kSamplePeriodMs. Each cluster wants the
+// lowest level that would keep its busiest CPU under kTargetPermille:
+// it goes up at once, and down only once kDownHoldSamples samples in a
+// row wanted less, then to the highest of what they wanted. Requests
+// bound the result (see AndroidPlatformShared.h).
+class AndroidPerformance : public OSObject
+{
+    OSDeclareDefaultStructors(AndroidPerformance)
+
+public:
+    static const uint32_t kSamplePeriodMs = 20;
+    static const uint32_t kTargetPermille = 800;
+    static const uint32_t kDownHoldSamples = 4;
+    static const uint32_t kMaxCPUs = 32;
+    static const uint32_t kMaxRequests = 64;
+
+    // NULL if the tree has no CPUs; `owner` is where the timer runs
+    static AndroidPerformance *withDeviceTree(AndroidDeviceTree *tree, IOService *owner);
+
+    uint32_t clusterCount(void) const { return fClusterCount; }
+
+    // The topology as PDCPUClusters: one dictionary per cluster
+    OSArray *copyTopology(void) const;
+
+    void registerBackend(const AndroidPerformanceBackend *backend);
+
+    // A request id, 0 if the table is full; `client` is whatever
+    // releaseRequests() is later called with ("who", e.g. a user client)
+    uint32_t request(uint32_t cluster, uint32_t minPermille, uint32_t maxPermille,
+                     uint32_t timeoutMs, void *client);
+    void releaseRequest(uint32_t id, void *client);
+    void releaseRequests(void *client);
+
+    // Up to `count` clusters' statistics; returns how many were filled
+    uint32_t copyStatistics(pd_cluster_stats_t *stats, uint32_t count);
+
+    void stop(void);
+
+protected:
+    virtual void free(void) override;
+
+private:
+    struct Cluster {
+        uint32_t cpus[kMaxCPUs];
+        uint32_t cpuCount;
+        uint32_t dmips;             // capacity-dmips-mhz
+        uint32_t oppTable;          // phandle, 0 for none
+        uint32_t levelCount;
+        uint64_t frequency[PD_MAX_LEVELS];  // Hz, ascending
+        uint32_t microvolts[PD_MAX_LEVELS];
+        uint32_t capacity;
+
+        // governor
+        uint32_t level;
+        uint32_t hold;              // samples in a row that wanted less
+        uint32_t holdWanted;        // the most they wanted
+        uint32_t utilization;
+        uint64_t transitions;
+        uint64_t busyNs;
+        uint64_t residencyNs[PD_MAX_LEVELS];
+    };
+
+    struct Request {
+        uint32_t id;                // 0: free
+        uint32_t cluster;
+        uint32_t minPermille, maxPermille;
+        uint64_t deadline;          // absolute time, 0: none
+        void *client;
+    };
+
+    bool discover(AndroidDeviceTree *tree);
+    void addCPU(uint32_t node, uint32_t cluster);
+    void walkCpuMap(AndroidDeviceTree *tree, uint32_t node, uint32_t *cluster);
+    void readLevels(AndroidDeviceTree *tree, Cluster *c, uint32_t cpuNode);
+
+    uint32_t levelFor(const Cluster *c, uint64_t frequency) const;
+    void bounds(uint32_t cluster, uint32_t *low, uint32_t *high);
+    void setLevel(uint32_t cluster, uint32_t level);
+    void applyRequests(void);
+    void account(uint64_t now);
+    void sample(void);
+    static void timerFired(OSObject *owner, IOTimerEventSource *timer);
+
+    Cluster fClusters[PD_MAX_CLUSTERS];
+    uint32_t fClusterCount;
+    uint32_t fCPUNodes[kMaxCPUs];   // device tree node of each CPU, by number
+    uint32_t fCPUCount;
+    uint64_t fLastBusy[kMaxCPUs];
+
+    Request fRequests[kMaxRequests];
+    uint32_t fNextId;
+
+    AndroidPerformanceBackend fBackend;
+    bool fHaveBackend;
+    uint64_t fLastSample;           // absolute times
+    uint64_t fLastAccount;
+
+    IOLock *fLock;
+    IOService *fOwner;
+    IOTimerEventSource *fTimer;
+};
+
+#endif // ANDROIDPERFORMANCE_HPP
@@ -1,5 +1,12 @@
+#ifndef ANDROIDPLATFORMBRIDGE_HPP
+#define ANDROIDPLATFORMBRIDGE_HPP
+
+#include <IOKit/IOLocks.h>
 #include <IOKit/IOService.h>
 
+#include "AndroidDeviceTree.hpp"
+#include "AndroidPerformance.hpp"
+
 class AndroidPlatformBridge : public IOService
 {
     OSDeclareDefaultStructors(AndroidPlatformBridge)
@@ -8,6 +15,27 @@ public:
     virtual bool start(IOService *provider) override;
     virtual void stop(IOService *provider) override;
 
+    // The loader's device tree, NULL if it passed none
+    AndroidDeviceTree *getDeviceTree(void) const { return fDeviceTree; }
+
+    // CPU clusters and performance requests, NULL without a device tree
+    // that has CPUs; the SoC's cpufreq driver registers its backend here
+    AndroidPerformance *getPerformance(void) const { return fPerformance; }
+
+    // Publish the nodes compatible with `compatible` for matching (once
+    // each, attached to us); drivers whose personalities arrive after
+    // start() call this for their own. Returns how many there are.
+    uint32_t publishCompatible(const char *compatible);
+
 private:
     void publishPlatformProperties(void);
+    void publishBootTrace(void);
+    void importDeviceTree(void);
+    AndroidDeviceTreeNub *publishNode(uint32_t node);
+
+    AndroidDeviceTree *fDeviceTree;
+    AndroidPerformance *fPerformance;
+    AndroidDeviceTreeNub **fNubs;   // by node, made on first use
+    IOLock *fNubLock;
 };
+#endif // ANDROIDPLATFORMBRIDGE_HPP
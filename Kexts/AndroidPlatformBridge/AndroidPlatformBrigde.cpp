@@ -1,5 +1,15 @@
 #include "AndroidPlatformBridge.hpp"
+#include <IOKit/IOCatalogue.h>
 #include <IOKit/IOLib.h>
+#include <IOKit/IODeviceTreeSupport.h>
+#include <libkern/c++/OSArray.h>
+#include <libkern/c++/OSData.h>
+#include <libkern/c++/OSDictionary.h>
+#include <libkern/c++/OSNumber.h>
+#include <libkern/c++/OSOrderedSet.h>
+#include <libkern/c++/OSString.h>
+
+#include "../../OCMobile/BootTrace.h"
 
 #define super IOService
 OSDefineMetaClassAndStructors(AndroidPlatformBridge, IOService)
@@ -11,8 +21,19 @@ bool AndroidPlatformBridge::start(IOService *provider)
 
     IOLog("PocketDarwin: AndroidPlatformBridge starting\n");
 
+    fNubLock = IOLockAlloc();
+    if (!fNubLock) {
+        super::stop(provider);
+        return false;
+    }
+
+    importDeviceTree();
+    if (fDeviceTree)
+        fPerformance = AndroidPerformance::withDeviceTree(fDeviceTree, this);
     publishPlatformProperties();
+    publishBootTrace();
 
+    setProperty("IOUserClientClass", "AndroidPlatformUserClient");
     registerService(); // Make ourselves visible
     return true;
 }
@@ -20,6 +41,26 @@ bool AndroidPlatformBridge::start(IOService *provider)
 void AndroidPlatformBridge::stop(IOService *provider)
 {
     IOLog("PocketDarwin: AndroidPlatformBridge stopping\n");
+
+    if (fNubs) {
+        for (uint32_t i = 0; i < fDeviceTree->nodeCount(); i++) {
+            if (fNubs[i]) {
+                fNubs[i]->terminate();
+                fNubs[i]->release();
+            }
+        }
+        IOFree(fNubs, fDeviceTree->nodeCount() * sizeof(*fNubs));
+        fNubs = NULL;
+    }
+    if (fPerformance) {
+        fPerformance->stop();
+        OSSafeReleaseNULL(fPerformance);
+    }
+    OSSafeReleaseNULL(fDeviceTree);
+    if (fNubLock) {
+        IOLockFree(fNubLock);
+        fNubLock = NULL;
+    }
     super::stop(provider);
 }
 
@@ -30,9 +71,198 @@ void AndroidPlatformBridge::publishPlatformProperties(void)
     setProperty("PDArchitecture", "ARM");
     setProperty("PDTranslated", true);
 
+    // What the board says it is, straight from the device tree's root
+    if (fDeviceTree) {
+        uint32_t length;
+        const char *model = (const char *)fDeviceTree->getProperty(0, "model", &length);
+        OSData *compatible = fDeviceTree->copyProperty(0, "compatible");
+
+        if (model && length && memchr(model, '\0', length))
+            setProperty("PDModel", model);
+        if (compatible) {
+            setProperty("PDCompatible", compatible);
+            compatible->release();
+        }
+        setProperty("PDDeviceTreeNodes", fDeviceTree->nodeCount(), 32);
+    }
+
+    // CPU clusters, for userland's scheduling hints; see AndroidPerformance.hpp
+    if (fPerformance) {
+        OSArray *clusters = fPerformance->copyTopology();
+        if (clusters) {
+            setProperty("PDCPUClusters", clusters);
+            clusters->release();
+        }
+        IOLog("PocketDarwin: %u CPU clusters\n", fPerformance->clusterCount());
+    }
+
     // Future home of:
-    // - Device Tree import
     // - Memory map
     // - Boot arguments
-    // - Power hints
+}
+
+// The loader's FDT (BootParams.h), which the kernel handoff leaves in
+// /chosen/ocm-fdt. Android DTBs run to thousands of nodes, so they are
+// only indexed here; a node becomes an IOService nub when a personality
+// in the catalogue matches on AndroidDeviceTreeNub with its compatible
+// string (IONameMatch), or when a driver asks with publishCompatible().
+void AndroidPlatformBridge::importDeviceTree(void)
+{
+    IORegistryEntry *chosen = IORegistryEntry::fromPath("/chosen", gIODTPlane);
+    if (!chosen)
+        return;
+
+    OSData *blob = OSDynamicCast(OSData, chosen->getProperty("ocm-fdt"));
+    if (blob) {
+        fDeviceTree = AndroidDeviceTree::withData(blob);
+        if (!fDeviceTree)
+            IOLog("PocketDarwin: ignoring malformed device tree\n");
+    }
+    chosen->release();
+    if (!fDeviceTree)
+        return;
+
+    IOLog("PocketDarwin: device tree with %u nodes indexed\n", fDeviceTree->nodeCount());
+
+    OSDictionary *matching = serviceMatching("AndroidDeviceTreeNub");
+    SInt32 generation;
+    OSOrderedSet *drivers = matching ? gIOCatalogue->findDrivers(matching, &generation) : NULL;
+    OSSafeReleaseNULL(matching);
+    if (!drivers)
+        return;
+
+    for (unsigned i = 0; i < drivers->getCount(); i++) {
+        OSDictionary *personality = OSDynamicCast(OSDictionary, drivers->getObject(i));
+        OSObject *names = personality ? personality->getObject(gIONameMatchKey) : NULL;
+        OSArray *list = OSDynamicCast(OSArray, names);
+
+        if (OSString *name = OSDynamicCast(OSString, names))
+            publishCompatible(name->getCStringNoCopy());
+        for (unsigned j = 0; list && j < list->getCount(); j++)
+            if (OSString *name = OSDynamicCast(OSString, list->getObject(j)))
+                publishCompatible(name->getCStringNoCopy());
+    }
+    drivers->release();
+}
+
+uint32_t AndroidPlatformBridge::publishCompatible(const char *compatible)
+{
+    uint32_t count = 0;
+
+    if (!fDeviceTree || !compatible)
+        return 0;
+    for (uint32_t node; (node = fDeviceTree->findCompatible(compatible, count)) != AndroidDeviceTree::kNoNode; count++)
+        publishNode(node);
+    return count;
+}
+
+AndroidDeviceTreeNub *AndroidPlatformBridge::publishNode(uint32_t node)
+{
+    IOLockLock(fNubLock);
+
+    if (!fNubs) {
+        fNubs = (AndroidDeviceTreeNub **)IOMalloc(fDeviceTree->nodeCount() * sizeof(*fNubs));
+        if (fNubs)
+            bzero(fNubs, fDeviceTree->nodeCount() * sizeof(*fNubs));
+    }
+    if (!fNubs || fNubs[node]) {
+        AndroidDeviceTreeNub *nub = fNubs ? fNubs[node] : NULL;
+        IOLockUnlock(fNubLock);
+        return nub;
+    }
+
+    AndroidDeviceTreeNub *nub = AndroidDeviceTreeNub::withNode(fDeviceTree, node);
+    if (nub && !nub->attach(this))
+        OSSafeReleaseNULL(nub);
+    fNubs[node] = nub;
+    IOLockUnlock(fNubLock);
+
+    if (nub)
+        nub->registerService();
+    return nub;
+}
+
+// The loader's boot timeline (OCMobile/Trace.h). The kernel handoff
+// copies ocm_boot_params->trace to /chosen/ocm-boot-trace; we publish it
+// raw as PDBootTrace and decoded as PDBootTimeline, one dictionary per
+// event with the time in microseconds since the loader's entry, or since
+// the oldest event kept once the loader's ring has wrapped.
+void AndroidPlatformBridge::publishBootTrace(void)
+{
+    IORegistryEntry *chosen = IORegistryEntry::fromPath("/chosen", gIODTPlane);
+    if (!chosen)
+        return;
+
+    OSData *blob = OSDynamicCast(OSData, chosen->getProperty("ocm-boot-trace"));
+    if (!blob || blob->getLength() < sizeof(ocm_boot_trace_t)) {
+        chosen->release();
+        return;
+    }
+
+    ocm_boot_trace_t header;
+    const uint8_t *bytes = (const uint8_t *)blob->getBytesNoCopy();
+    memcpy(&header, bytes, sizeof(header));
+
+    if (header.magic != OCM_TRACE_MAGIC || header.version != OCM_TRACE_VERSION ||
+        header.count > (blob->getLength() - sizeof(header)) / sizeof(ocm_trace_event_t)) {
+        IOLog("PocketDarwin: ignoring malformed boot trace\n");
+        chosen->release();
+        return;
+    }
+
+    setProperty("PDBootTrace", blob);
+
+    OSArray *timeline = OSArray::withCapacity(header.count);
+    uint64_t t0 = UINT64_MAX;
+
+    // by time, not position: the loader's cores record concurrently
+    for (uint32_t i = 0; i < header.count; i++) {
+        ocm_trace_event_t ev;
+        memcpy(&ev, bytes + sizeof(header) + i * sizeof(ev), sizeof(ev));
+        if (ev.ticks < t0)
+            t0 = ev.ticks;
+    }
+
+    for (uint32_t i = 0; timeline && i < header.count; i++) {
+        ocm_trace_event_t ev;
+        memcpy(&ev, bytes + sizeof(header) + i * sizeof(ev), sizeof(ev));
+
+        uint64_t ticks = ev.ticks - t0;
+        uint64_t us = header.frequency
+            ? (ticks / header.frequency) * 1000000 + (ticks % header.frequency) * 1000000 / header.frequency
+            : ticks;
+
+        char name[OCM_TRACE_NAME_LEN + 1];
+        memcpy(name, ev.name, OCM_TRACE_NAME_LEN);
+        name[OCM_TRACE_NAME_LEN] = '\0';
+
+        static const char *const kinds[] = { "mark", "begin", "end" };
+        OSDictionary *entry = OSDictionary::withCapacity(4);
+        OSString *nameStr = OSString::withCString(name);
+        OSString *kindStr = OSString::withCString(ev.kind <= OCM_TRACE_END ? kinds[ev.kind] : "?");
+        OSNumber *time = OSNumber::withNumber(us, 64);
+        OSNumber *arg = OSNumber::withNumber(ev.arg, 64);
+
+        if (entry && nameStr && kindStr && time && arg) {
+            entry->setObject("Name", nameStr);
+            entry->setObject("Kind", kindStr);
+            entry->setObject("Time", time);
+            entry->setObject("Arg", arg);
+            timeline->setObject(entry);
+        }
+
+        OSSafeReleaseNULL(nameStr);
+        OSSafeReleaseNULL(kindStr);
+        OSSafeReleaseNULL(time);
+        OSSafeReleaseNULL(arg);
+        OSSafeReleaseNULL(entry);
+    }
+
+    if (timeline) {
+        setProperty("PDBootTimeline", timeline);
+        timeline->release();
+    }
+
+    IOLog("PocketDarwin: boot trace with %u events published\n", header.count);
+    chosen->release();
 }
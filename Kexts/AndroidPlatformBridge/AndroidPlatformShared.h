@@ -0,0 +1,44 @@
+#ifndef ANDROIDPLATFORMSHARED_H
+#define ANDROIDPLATFORMSHARED_H
+
+#include <stdint.h>
+
+/*
+ * AndroidPlatformBridge – user client interface
+ *
+ * IOServiceOpen() the bridge (type 0), then IOConnectCallMethod() with
+ * these selectors. Self-contained so userland can include it without
+ * IOKit's kernel headers.
+ *
+ * Performance requests are in permille of a cluster's highest
+ * frequency, so one hint means the same on every cluster. The highest
+ * floor and the lowest ceiling of all requests bound what the governor
+ * picks; a ceiling wins over a floor. A request lasts until released,
+ * its timeout runs out or its connection closes.
+ */
+
+enum {
+    kPDMethodPerformanceRequest = 0,    /* in: cluster, min, max (permille), timeout ms (0: none); out: id */
+    kPDMethodPerformanceRelease,        /* in: id */
+    kPDMethodPerformanceStatistics,     /* out: pd_cluster_stats_t per cluster */
+    kPDMethodCount
+};
+
+#define PD_ALL_CLUSTERS         0xFFFFFFFFu
+#define PD_MAX_CLUSTERS         8
+#define PD_MAX_LEVELS           32
+
+typedef struct {
+    uint32_t cpus;                      /* in the cluster */
+    uint32_t capacity;                  /* Linux' cpu_capacity: 1024 for the biggest */
+    uint32_t level;                     /* operating point now, 0 the slowest */
+    uint32_t level_count;
+    uint64_t frequency;                 /* Hz at `level`, 0 if unknown */
+    uint32_t utilization;               /* permille, busiest CPU over the last sample */
+    uint32_t reserved;
+    uint64_t transitions;
+    uint64_t busy_ns;                   /* summed over the cluster's CPUs */
+    uint64_t residency_ns[PD_MAX_LEVELS];   /* time spent at each level */
+} pd_cluster_stats_t;
+
+#endif /* ANDROIDPLATFORMSHARED_H */
@@ -0,0 +1,113 @@
+#include "AndroidPlatformUserClient.hpp"
+#include <IOKit/IOLib.h>
+
+#define super IOUserClient
+OSDefineMetaClassAndStructors(AndroidPlatformUserClient, IOUserClient)
+
+// scalar inputs, struct inputs, scalar outputs, struct outputs
+const IOExternalMethodDispatch AndroidPlatformUserClient::sMethods[kPDMethodCount] = {
+    { &AndroidPlatformUserClient::performanceRequest, 4, 0, 1, 0 },
+    { &AndroidPlatformUserClient::performanceRelease, 1, 0, 0, 0 },
+    { &AndroidPlatformUserClient::performanceStatistics, 0, 0, 0, kIOUCVariableStructureSize },
+};
+
+bool AndroidPlatformUserClient::initWithTask(task_t owningTask, void *securityID, UInt32 type, OSDictionary *properties)
+{
+    if (!super::initWithTask(owningTask, securityID, type, properties))
+        return false;
+
+    // statistics are anyone's; pinning clocks up costs battery, so that is root's
+    fAdministrator = clientHasPrivilege(securityID, kIOClientPrivilegeAdministrator) == kIOReturnSuccess;
+    return true;
+}
+
+bool AndroidPlatformUserClient::start(IOService *provider)
+{
+    fBridge = OSDynamicCast(AndroidPlatformBridge, provider);
+    if (!fBridge || !super::start(provider))
+        return false;
+
+    // ours until free(): the bridge's stop() may drop its reference while a call is in flight
+    fPerformance = fBridge->getPerformance();
+    if (fPerformance)
+        fPerformance->retain();
+    return true;
+}
+
+void AndroidPlatformUserClient::free(void)
+{
+    OSSafeReleaseNULL(fPerformance);
+    super::free();
+}
+
+IOReturn AndroidPlatformUserClient::clientClose(void)
+{
+    // whatever this connection asked for goes with it
+    if (fPerformance)
+        fPerformance->releaseRequests(this);
+    terminate();
+    return kIOReturnSuccess;
+}
+
+IOReturn AndroidPlatformUserClient::externalMethod(uint32_t selector, IOExternalMethodArguments *args,
+                                                   IOExternalMethodDispatch *dispatch, OSObject *target,
+                                                   void *reference)
+{
+    if (selector >= kPDMethodCount)
+        return kIOReturnBadArgument;
+
+    dispatch = (IOExternalMethodDispatch *)&sMethods[selector];
+    target = this;
+    return super::externalMethod(selector, args, dispatch, target, reference);
+}
+
+IOReturn AndroidPlatformUserClient::performanceRequest(OSObject *target, void *reference, IOExternalMethodArguments *args)
+{
+    AndroidPlatformUserClient *client = (AndroidPlatformUserClient *)target;
+    AndroidPerformance *perf = client->fPerformance;
+    (void)reference;
+
+    if (!client->fAdministrator)
+        return kIOReturnNotPrivileged;
+    if (!perf)
+        return kIOReturnUnsupported;
+
+    const uint64_t *in = args->scalarInput;
+    if (in[1] > 1000 || in[2] > 1000 || in[3] > UINT32_MAX)
+        return kIOReturnBadArgument;
+
+    uint32_t id = perf->request((uint32_t)in[0], (uint32_t)in[1], (uint32_t)in[2], (uint32_t)in[3], client);
+    if (!id)
+        return kIOReturnNoResources;    // or a bad cluster; the table is generous
+    args->scalarOutput[0] = id;
+    return kIOReturnSuccess;
+}
+
+IOReturn AndroidPlatformUserClient::performanceRelease(OSObject *target, void *reference, IOExternalMethodArguments *args)
+{
+    AndroidPlatformUserClient *client = (AndroidPlatformUserClient *)target;
+    AndroidPerformance *perf = client->fPerformance;
+    (void)reference;
+
+    if (!perf)
+        return kIOReturnUnsupported;
+    perf->releaseRequest((uint32_t)args->scalarInput[0], client);
+    return kIOReturnSuccess;
+}
+
+IOReturn AndroidPlatformUserClient::performanceStatistics(OSObject *target, void *reference, IOExternalMethodArguments *args)
+{
+    AndroidPlatformUserClient *client = (AndroidPlatformUserClient *)target;
+    AndroidPerformance *perf = client->fPerformance;
+    pd_cluster_stats_t stats[PD_MAX_CLUSTERS];
+    (void)reference;
+
+    if (!perf)
+        return kIOReturnUnsupported;
+
+    uint32_t room = args->structureOutputSize / sizeof(stats[0]);
+    uint32_t n = perf->copyStatistics(stats, room < PD_MAX_CLUSTERS ? room : PD_MAX_CLUSTERS);
+    memcpy(args->structureOutput, stats, n * sizeof(stats[0]));
+    args->structureOutputSize = n * sizeof(stats[0]);
+    return kIOReturnSuccess;
+}
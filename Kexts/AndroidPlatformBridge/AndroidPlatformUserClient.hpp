@@ -0,0 +1,36 @@
+#ifndef ANDROIDPLATFORMUSERCLIENT_HPP
+#define ANDROIDPLATFORMUSERCLIENT_HPP
+
+#include <IOKit/IOUserClient.h>
+
+#include "AndroidPlatformBridge.hpp"
+
+// What IOServiceOpen() on the bridge returns; see AndroidPlatformShared.h
+class AndroidPlatformUserClient : public IOUserClient
+{
+    OSDeclareDefaultStructors(AndroidPlatformUserClient)
+
+public:
+    virtual bool initWithTask(task_t owningTask, void *securityID, UInt32 type, OSDictionary *properties) override;
+    virtual bool start(IOService *provider) override;
+    virtual IOReturn clientClose(void) override;
+    virtual IOReturn externalMethod(uint32_t selector, IOExternalMethodArguments *args,
+                                    IOExternalMethodDispatch *dispatch, OSObject *target,
+                                    void *reference) override;
+
+protected:
+    virtual void free(void) override;
+
+private:
+    static const IOExternalMethodDispatch sMethods[kPDMethodCount];
+
+    static IOReturn performanceRequest(OSObject *target, void *reference, IOExternalMethodArguments *args);
+    static IOReturn performanceRelease(OSObject *target, void *reference, IOExternalMethodArguments *args);
+    static IOReturn performanceStatistics(OSObject *target, void *reference, IOExternalMethodArguments *args);
+
+    AndroidPlatformBridge *fBridge;
+    AndroidPerformance *fPerformance;   // retained, NULL if the bridge has none
+    bool fAdministrator;        // may make performance requests
+};
+
+#endif // ANDROIDPLATFORMUSERCLIENT_HPP
@@ -0,0 +1,764 @@
+#include "BlockIo.h"
+#include "Memory.h"
+#include "arch/aarch64/io.h"
+
+/*
+ * OpenCore Mobile – block I/O layer
+ * See BlockIo.h. Single core, no locking (yet).
+ */
+
+#define SLOT_NONE           0xFFFFFFFFu
+
+/* requests at least this large skip the cache */
+#define CACHE_BYPASS_MIN    8
+
+/* byte helpers hand the driver at most this many blocks per call */
+#define BYTES_CHUNK_BLOCKS  0x10000u
+
+typedef struct {
+    u64 lba;
+    u32 hash_next;
+    u32 prev;               /* towards most recently used */
+    u32 next;               /* towards least recently used */
+    u32 valid;
+} cache_slot_t;
+
+struct block_cache {
+    u32 capacity;
+    u32 readahead;
+    u32 bypass_blocks;      /* reads of this many blocks go straight through */
+    u32 bounce_blocks;
+    u32 hash_shift;
+    u32 *buckets;
+    cache_slot_t *slots;
+    u8 *data;               /* capacity * block_size */
+    u8 *bounce;             /* bounce_blocks * block_size */
+    u32 lru_head;           /* most recently used */
+    u32 lru_tail;           /* next victim */
+    u64 next_seq_lba;       /* where a sequential reader would go next */
+};
+
+static inline bool range_ok(const block_device_t *dev, u64 lba, u32 count) {
+    if (!dev->total_sectors)
+        return true;
+    return lba < dev->total_sectors && count <= dev->total_sectors - lba;
+}
+
+/* =========================
+ *  Driver calls
+ * ========================= */
+
+static status_t driver_read(block_device_t *dev, u64 lba, u32 count, void *buffer) {
+    u8 *p = (u8 *)buffer;
+
+    while (count) {
+        u32 n = count;
+        if (dev->max_transfer_blocks && n > dev->max_transfer_blocks)
+            n = dev->max_transfer_blocks;
+
+        dev->stats.transfers++;
+        status_t status = dev->read_blocks(dev, lba, n, p);
+        if (status != STATUS_SUCCESS)
+            return status;
+
+        dev->stats.bytes_read += (u64)n * dev->block_size;
+        p += (size_t)n * dev->block_size;
+        lba += n;
+        count -= n;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+static status_t driver_write(block_device_t *dev, u64 lba, u32 count, const void *buffer) {
+    const u8 *p = (const u8 *)buffer;
+
+    if (!dev->write_blocks)
+        return STATUS_ERROR;
+
+    while (count) {
+        u32 n = count;
+        if (dev->max_transfer_blocks && n > dev->max_transfer_blocks)
+            n = dev->max_transfer_blocks;
+
+        dev->stats.transfers++;
+        status_t status = dev->write_blocks(dev, lba, n, p);
+        if (status != STATUS_SUCCESS)
+            return status;
+
+        dev->stats.bytes_written += (u64)n * dev->block_size;
+        p += (size_t)n * dev->block_size;
+        lba += n;
+        count -= n;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+/* =========================
+ *  LRU cache
+ * ========================= */
+
+static inline u32 cache_hash(const struct block_cache *c, u64 lba) {
+    return (u32)((lba * 0x9E3779B97F4A7C15ULL) >> c->hash_shift);
+}
+
+static inline u8 *slot_data(const block_device_t *dev, u32 idx) {
+    return dev->cache->data + (size_t)idx * dev->block_size;
+}
+
+static void lru_unlink(struct block_cache *c, u32 idx) {
+    cache_slot_t *s = &c->slots[idx];
+
+    if (s->prev != SLOT_NONE)
+        c->slots[s->prev].next = s->next;
+    else
+        c->lru_head = s->next;
+
+    if (s->next != SLOT_NONE)
+        c->slots[s->next].prev = s->prev;
+    else
+        c->lru_tail = s->prev;
+}
+
+static void lru_push_head(struct block_cache *c, u32 idx) {
+    cache_slot_t *s = &c->slots[idx];
+
+    s->prev = SLOT_NONE;
+    s->next = c->lru_head;
+    if (c->lru_head != SLOT_NONE)
+        c->slots[c->lru_head].prev = idx;
+    c->lru_head = idx;
+    if (c->lru_tail == SLOT_NONE)
+        c->lru_tail = idx;
+}
+
+static void lru_push_tail(struct block_cache *c, u32 idx) {
+    cache_slot_t *s = &c->slots[idx];
+
+    s->next = SLOT_NONE;
+    s->prev = c->lru_tail;
+    if (c->lru_tail != SLOT_NONE)
+        c->slots[c->lru_tail].next = idx;
+    c->lru_tail = idx;
+    if (c->lru_head == SLOT_NONE)
+        c->lru_head = idx;
+}
+
+static void lru_touch(struct block_cache *c, u32 idx) {
+    if (c->lru_head == idx)
+        return;
+    lru_unlink(c, idx);
+    lru_push_head(c, idx);
+}
+
+static u32 cache_lookup(struct block_cache *c, u64 lba) {
+    u32 idx = c->buckets[cache_hash(c, lba)];
+
+    while (idx != SLOT_NONE) {
+        if (c->slots[idx].lba == lba)
+            return idx;
+        idx = c->slots[idx].hash_next;
+    }
+    return SLOT_NONE;
+}
+
+static void hash_remove(struct block_cache *c, u32 idx) {
+    u32 *link = &c->buckets[cache_hash(c, c->slots[idx].lba)];
+
+    while (*link != SLOT_NONE) {
+        if (*link == idx) {
+            *link = c->slots[idx].hash_next;
+            return;
+        }
+        link = &c->slots[*link].hash_next;
+    }
+}
+
+/* Store one block, recycling the least recently used slot if needed */
+static void cache_insert(block_device_t *dev, u64 lba, const void *src) {
+    struct block_cache *c = dev->cache;
+    u32 idx = cache_lookup(c, lba);
+
+    if (idx == SLOT_NONE) {
+        idx = c->lru_tail;
+        if (c->slots[idx].valid)
+            hash_remove(c, idx);
+
+        u32 b = cache_hash(c, lba);
+        c->slots[idx].lba = lba;
+        c->slots[idx].valid = 1;
+        c->slots[idx].hash_next = c->buckets[b];
+        c->buckets[b] = idx;
+    }
+
+    memcpy(slot_data(dev, idx), src, dev->block_size);
+    lru_touch(c, idx);
+}
+
+/* Forget cached copies of [lba, lba + count); their slots are reused first */
+static void cache_drop(block_device_t *dev, u64 lba, u32 count) {
+    struct block_cache *c = dev->cache;
+
+    if (!c)
+        return;
+
+    for (u32 i = 0; i < count; i++) {
+        u32 idx = cache_lookup(c, lba + i);
+        if (idx == SLOT_NONE)
+            continue;
+
+        hash_remove(c, idx);
+        c->slots[idx].valid = 0;
+        lru_unlink(c, idx);
+        lru_push_tail(c, idx);
+    }
+}
+
+static void cache_reset(struct block_cache *c) {
+    for (u32 i = 0; i < (1u << (64 - c->hash_shift)); i++)
+        c->buckets[i] = SLOT_NONE;
+
+    for (u32 i = 0; i < c->capacity; i++) {
+        c->slots[i].valid = 0;
+        c->slots[i].hash_next = SLOT_NONE;
+        c->slots[i].prev = i ? i - 1 : SLOT_NONE;
+        c->slots[i].next = i + 1 < c->capacity ? i + 1 : SLOT_NONE;
+    }
+
+    c->lru_head = 0;
+    c->lru_tail = c->capacity - 1;
+    c->next_seq_lba = (u64)-1;
+}
+
+status_t block_cache_attach(block_device_t *dev, u32 capacity, u32 readahead) {
+    if (!dev || !dev->block_size || capacity < 2)
+        return STATUS_INVALID_PARAM;
+
+    if (dev->cache)
+        return STATUS_SUCCESS;
+
+    struct block_cache *c = boot_alloc(sizeof(*c));
+    if (!c)
+        return STATUS_OUT_OF_MEMORY;
+
+    u32 bits = 1;
+    while ((1u << bits) < capacity)
+        bits++;
+
+    c->capacity = capacity;
+    c->hash_shift = 64 - bits;
+
+    c->bypass_blocks = readahead > CACHE_BYPASS_MIN ? readahead : CACHE_BYPASS_MIN;
+    if (c->bypass_blocks > capacity / 2)
+        c->bypass_blocks = capacity / 2 ? capacity / 2 : 1;
+
+    /* never prefetch more than the cache can hold next to the request */
+    if (readahead > capacity - c->bypass_blocks)
+        readahead = capacity - c->bypass_blocks;
+    c->readahead = readahead;
+    c->bounce_blocks = c->bypass_blocks + readahead;
+
+    c->buckets = boot_alloc(sizeof(u32) << bits);
+    c->slots = boot_alloc(sizeof(cache_slot_t) * capacity);
+    c->data = boot_alloc((size_t)capacity * dev->block_size);
+    c->bounce = boot_alloc((size_t)c->bounce_blocks * dev->block_size);
+
+    if (!c->buckets || !c->slots || !c->data || !c->bounce)
+        return STATUS_OUT_OF_MEMORY;
+
+    cache_reset(c);
+    dev->cache = c;
+    return STATUS_SUCCESS;
+}
+
+void block_cache_invalidate(block_device_t *dev) {
+    if (dev && dev->cache)
+        cache_reset(dev->cache);
+}
+
+/* =========================
+ *  Synchronous I/O
+ * ========================= */
+
+/* Fetch a run of missing blocks (plus read-ahead) through the bounce buffer */
+static status_t cache_fill(block_device_t *dev, u64 lba, u32 count,
+                           u32 extra, u8 *out) {
+    struct block_cache *c = dev->cache;
+    u32 total = count + extra;
+
+    status_t status = driver_read(dev, lba, total, c->bounce);
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    for (u32 i = 0; i < total; i++)
+        cache_insert(dev, lba + i, c->bounce + (size_t)i * dev->block_size);
+
+    memcpy(out, c->bounce, (size_t)count * dev->block_size);
+
+    dev->stats.cache_misses += count;
+    dev->stats.readahead_blocks += extra;
+    return STATUS_SUCCESS;
+}
+
+status_t block_read(block_device_t *dev, u64 lba, u32 count, void *buffer) {
+    if (!dev || !buffer || !dev->read_blocks)
+        return STATUS_INVALID_PARAM;
+    if (count == 0)
+        return STATUS_SUCCESS;
+    if (!range_ok(dev, lba, count))
+        return STATUS_OUT_OF_RANGE;
+
+    dev->stats.requests++;
+
+    struct block_cache *c = dev->cache;
+
+    /* streaming reads: one big transfer straight into the caller's buffer */
+    if (!c || count >= c->bypass_blocks) {
+        if (c)
+            c->next_seq_lba = lba + count;
+        return driver_read(dev, lba, count, buffer);
+    }
+
+    bool sequential = (lba == c->next_seq_lba);
+    u8 *out = (u8 *)buffer;
+    u32 i = 0;
+
+    c->next_seq_lba = lba + count;
+
+    while (i < count) {
+        u32 idx = cache_lookup(c, lba + i);
+
+        if (idx != SLOT_NONE) {
+            memcpy(out + (size_t)i * dev->block_size, slot_data(dev, idx),
+                   dev->block_size);
+            lru_touch(c, idx);
+            dev->stats.cache_hits++;
+            i++;
+            continue;
+        }
+
+        u32 run = 1;
+        while (i + run < count && cache_lookup(c, lba + i + run) == SLOT_NONE)
+            run++;
+
+        /* only prefetch past the end of a sequential request */
+        u32 extra = 0;
+        if (sequential && i + run == count) {
+            extra = c->readahead;
+            if (dev->total_sectors &&
+                extra > dev->total_sectors - (lba + count))
+                extra = (u32)(dev->total_sectors - (lba + count));
+        }
+
+        status_t status = cache_fill(dev, lba + i, run, extra,
+                                     out + (size_t)i * dev->block_size);
+        if (status != STATUS_SUCCESS)
+            return status;
+
+        i += run;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+status_t block_write(block_device_t *dev, u64 lba, u32 count, const void *buffer) {
+    if (!dev || !buffer)
+        return STATUS_INVALID_PARAM;
+    if (count == 0)
+        return STATUS_SUCCESS;
+    if (!range_ok(dev, lba, count))
+        return STATUS_OUT_OF_RANGE;
+
+    dev->stats.requests++;
+
+    status_t status = driver_write(dev, lba, count, buffer);
+    if (status != STATUS_SUCCESS) {
+        /* part of the range may have changed on disk */
+        block_cache_invalidate(dev);
+        return status;
+    }
+
+    /* write-through: refresh blocks we already hold, don't allocate new ones */
+    struct block_cache *c = dev->cache;
+    if (c) {
+        const u8 *src = (const u8 *)buffer;
+        for (u32 i = 0; i < count; i++) {
+            u32 idx = cache_lookup(c, lba + i);
+            if (idx != SLOT_NONE)
+                memcpy(slot_data(dev, idx), src + (size_t)i * dev->block_size,
+                       dev->block_size);
+        }
+    }
+
+    return STATUS_SUCCESS;
+}
+
+status_t block_flush(block_device_t *dev) {
+    if (!dev)
+        return STATUS_INVALID_PARAM;
+    return dev->flush ? dev->flush(dev) : STATUS_SUCCESS;
+}
+
+/* =========================
+ *  Byte-addressed helpers
+ * ========================= */
+
+status_t block_read_bytes(block_device_t *dev, u64 offset, u64 size, void *buffer) {
+    if (!dev || !buffer || !dev->block_size)
+        return STATUS_INVALID_PARAM;
+
+    u32 bs = dev->block_size;
+    u64 lba = offset / bs;
+    u32 skip = (u32)(offset % bs);
+    u8 *out = (u8 *)buffer;
+    u8 *sector = NULL;
+    status_t status = STATUS_SUCCESS;
+    arena_mark_t mark = arena_mark();
+
+    while (size) {
+        if (skip || size < bs) {
+            /* partial block at either end */
+            u32 n = bs - skip;
+            if (n > size)
+                n = (u32)size;
+
+            if (!sector && !(sector = arena_alloc(bs))) {
+                status = STATUS_OUT_OF_MEMORY;
+                break;
+            }
+
+            status = block_read(dev, lba, 1, sector);
+            if (status != STATUS_SUCCESS)
+                break;
+
+            memcpy(out, sector + skip, n);
+            out += n;
+            size -= n;
+            lba++;
+            skip = 0;
+            continue;
+        }
+
+        u64 blocks = size / bs;
+        u32 n = blocks > BYTES_CHUNK_BLOCKS ? BYTES_CHUNK_BLOCKS : (u32)blocks;
+
+        status = block_read(dev, lba, n, out);
+        if (status != STATUS_SUCCESS)
+            break;
+
+        out += (size_t)n * bs;
+        size -= (u64)n * bs;
+        lba += n;
+    }
+
+    arena_release(mark);
+    return status;
+}
+
+status_t block_write_bytes(block_device_t *dev, u64 offset, u64 size, const void *buffer) {
+    if (!dev || !buffer || !dev->block_size)
+        return STATUS_INVALID_PARAM;
+
+    u32 bs = dev->block_size;
+    u64 lba = offset / bs;
+    u32 skip = (u32)(offset % bs);
+    const u8 *in = (const u8 *)buffer;
+    u8 *sector = NULL;
+    status_t status = STATUS_SUCCESS;
+    arena_mark_t mark = arena_mark();
+
+    while (size) {
+        if (skip || size < bs) {
+            /* read-modify-write the partial block */
+            u32 n = bs - skip;
+            if (n > size)
+                n = (u32)size;
+
+            if (!sector && !(sector = arena_alloc(bs))) {
+                status = STATUS_OUT_OF_MEMORY;
+                break;
+            }
+
+            status = block_read(dev, lba, 1, sector);
+            if (status != STATUS_SUCCESS)
+                break;
+
+            memcpy(sector + skip, in, n);
+
+            status = block_write(dev, lba, 1, sector);
+            if (status != STATUS_SUCCESS)
+                break;
+
+            in += n;
+            size -= n;
+            lba++;
+            skip = 0;
+            continue;
+        }
+
+        u64 blocks = size / bs;
+        u32 n = blocks > BYTES_CHUNK_BLOCKS ? BYTES_CHUNK_BLOCKS : (u32)blocks;
+
+        status = block_write(dev, lba, n, in);
+        if (status != STATUS_SUCCESS)
+            break;
+
+        in += (size_t)n * bs;
+        size -= (u64)n * bs;
+        lba += n;
+    }
+
+    arena_release(mark);
+    return status;
+}
+
+/* =========================
+ *  Asynchronous I/O
+ * ========================= */
+
+static status_t submit_here(block_device_t *dev, block_io_t *io) {
+    bool write = (io->flags & BLOCK_IO_WRITE) != 0;
+    status_t status;
+
+    if (write)
+        cache_drop(dev, io->device_lba, io->count);
+
+    if (!dev->submit) {
+        /* no DMA engine: do it now */
+        status = write ? driver_write(dev, io->device_lba, io->count, io->buffer)
+                       : driver_read(dev, io->device_lba, io->count, io->buffer);
+        io->status = status;
+        return status;
+    }
+
+    if (dev->max_transfer_blocks && io->count > dev->max_transfer_blocks) {
+        io->status = STATUS_INVALID_PARAM;
+        return STATUS_INVALID_PARAM;
+    }
+
+    /* counted when issued */
+    dev->stats.transfers++;
+    if (write)
+        dev->stats.bytes_written += (u64)io->count * dev->block_size;
+    else
+        dev->stats.bytes_read += (u64)io->count * dev->block_size;
+
+    io->status = STATUS_PENDING;
+    status = dev->submit(dev, io);
+    if (status != STATUS_SUCCESS)
+        io->status = status;
+    return status;
+}
+
+status_t block_submit(block_device_t *dev, block_io_t *io) {
+    if (!dev || !io || !io->buffer)
+        return STATUS_INVALID_PARAM;
+
+    io->device_lba = io->lba;
+    io->next = NULL;
+
+    if (io->count == 0) {
+        io->status = STATUS_SUCCESS;
+        return STATUS_SUCCESS;
+    }
+    if (!range_ok(dev, io->lba, io->count)) {
+        io->status = STATUS_OUT_OF_RANGE;
+        return STATUS_OUT_OF_RANGE;
+    }
+
+    dev->stats.requests++;
+    return submit_here(dev, io);
+}
+
+status_t block_forward(block_device_t *lower, block_io_t *io, u64 offset) {
+    io->device_lba += offset;
+
+    if (!range_ok(lower, io->device_lba, io->count)) {
+        io->status = STATUS_OUT_OF_RANGE;
+        return STATUS_OUT_OF_RANGE;
+    }
+
+    lower->stats.requests++;
+    return submit_here(lower, io);
+}
+
+bool block_poll(block_device_t *dev, block_io_t *io) {
+    if (io->status == STATUS_PENDING && dev->poll)
+        dev->poll(dev);
+    return io->status != STATUS_PENDING;
+}
+
+status_t block_wait(block_device_t *dev, block_io_t *io) {
+    while (!block_poll(dev, io))
+        cpu_relax();
+    return io->status;
+}
+
+/* =========================
+ *  Request queue
+ * ========================= */
+
+void block_queue_read(block_device_t *dev, block_request_t *req) {
+    req->status = STATUS_NOT_FOUND;     /* not issued yet */
+    req->next = dev->queue;
+    dev->queue = req;
+}
+
+/* Sort the pending list by LBA (insertion sort; queues are short) */
+static block_request_t *queue_sort(block_request_t *list) {
+    block_request_t *sorted = NULL;
+
+    while (list) {
+        block_request_t *req = list;
+        block_request_t **link = &sorted;
+
+        list = list->next;
+        while (*link && (*link)->lba <= req->lba)
+            link = &(*link)->next;
+
+        req->next = *link;
+        *link = req;
+    }
+
+    return sorted;
+}
+
+/* Issue one run of LBA-adjacent requests [first, last] as a single transfer */
+static status_t queue_issue(block_device_t *dev, block_request_t *first,
+                            block_request_t *last, u32 nreqs, u32 total) {
+    u32 bs = dev->block_size;
+    status_t status;
+
+    if (nreqs == 1) {
+        status = block_read(dev, first->lba, first->count, first->buffer);
+        first->status = status;
+        return status;
+    }
+
+    dev->stats.requests++;
+    dev->stats.merged_requests += nreqs - 1;
+
+    /* buffers laid out back to back: it is just one bigger read */
+    bool contiguous = true;
+    for (block_request_t *r = first; r != last; r = r->next) {
+        if ((u8 *)r->buffer + (size_t)r->count * bs != (u8 *)r->next->buffer) {
+            contiguous = false;
+            break;
+        }
+    }
+
+    arena_mark_t mark = arena_mark();
+
+    if (contiguous) {
+        status = driver_read(dev, first->lba, total, first->buffer);
+    } else if (dev->read_vec) {
+        block_seg_t *segs = arena_alloc(sizeof(block_seg_t) * nreqs);
+        u32 i = 0;
+
+        if (!segs) {
+            status = STATUS_OUT_OF_MEMORY;
+        } else {
+            for (block_request_t *r = first; ; r = r->next) {
+                segs[i].buffer = r->buffer;
+                segs[i].count = r->count;
+                i++;
+                if (r == last)
+                    break;
+            }
+
+            dev->stats.transfers++;
+            status = dev->read_vec(dev, first->lba, segs, nreqs);
+            if (status == STATUS_SUCCESS)
+                dev->stats.bytes_read += (u64)total * bs;
+        }
+    } else {
+        /* one transfer into a bounce buffer, then scatter */
+        u8 *bounce = arena_alloc((size_t)total * bs);
+
+        if (!bounce) {
+            status = STATUS_OUT_OF_MEMORY;
+        } else {
+            status = driver_read(dev, first->lba, total, bounce);
+            if (status == STATUS_SUCCESS) {
+                u8 *src = bounce;
+                for (block_request_t *r = first; ; r = r->next) {
+                    memcpy(r->buffer, src, (size_t)r->count * bs);
+                    src += (size_t)r->count * bs;
+                    if (r == last)
+                        break;
+                }
+            }
+        }
+    }
+
+    arena_release(mark);
+
+    for (block_request_t *r = first; ; r = r->next) {
+        r->status = status;
+        if (r == last)
+            break;
+    }
+
+    return status;
+}
+
+status_t block_queue_submit(block_device_t *dev) {
+    if (!dev)
+        return STATUS_INVALID_PARAM;
+
+    block_request_t *req = queue_sort(dev->queue);
+    status_t result = STATUS_SUCCESS;
+
+    dev->queue = NULL;
+
+    while (req) {
+        block_request_t *first = req;
+        block_request_t *last = req;
+        u32 nreqs = 1;
+        u32 total = req->count;
+
+        if (!range_ok(dev, req->lba, req->count)) {
+            req->status = STATUS_OUT_OF_RANGE;
+            if (result == STATUS_SUCCESS)
+                result = STATUS_OUT_OF_RANGE;
+            req = req->next;
+            continue;
+        }
+
+        /* extend while the next request starts where this run ends */
+        while (last->next &&
+               last->next->lba == first->lba + total &&
+               last->next->count &&
+               range_ok(dev, first->lba, total + last->next->count) &&
+               (!dev->max_transfer_blocks ||
+                total + last->next->count <= dev->max_transfer_blocks)) {
+            last = last->next;
+            total += last->count;
+            nreqs++;
+        }
+
+        req = last->next;
+
+        status_t status = queue_issue(dev, first, last, nreqs, total);
+        if (status != STATUS_SUCCESS && result == STATUS_SUCCESS)
+            result = status;
+    }
+
+    return result;
+}
+
+/* =========================
+ *  Accounting
+ * ========================= */
+
+void block_dump_stats(const block_device_t *dev, const char *name) {
+    const block_io_stats_t *s = &dev->stats;
+
+    printf("%s: %u req, %u xfer, %u KiB read, %u KiB written\n",
+           name, (u32)s->requests, (u32)s->transfers,
+           (u32)(s->bytes_read >> 10), (u32)(s->bytes_written >> 10));
+    printf("%s: cache %u hit / %u miss, %u read-ahead, %u merged\n",
+           name, (u32)s->cache_hits, (u32)s->cache_misses,
+           (u32)s->readahead_blocks, (u32)s->merged_requests);
+}
@@ -0,0 +1,170 @@
+#ifndef BLOCKIO_H
+#define BLOCKIO_H
+
+#include <stdbool.h>
+
+#include "bootstd.h"
+
+/*
+ * OpenCore Mobile – block I/O layer
+ *
+ * One block_device_t for every storage driver (eMMC, SD, USB, loop
+ * images, partitions). Drivers only implement LBA-based read_blocks /
+ * write_blocks; everything above goes through block_read() and friends,
+ * which add:
+ *  - an optional LRU sector cache with sequential read-ahead
+ *  - a request queue that merges adjacent requests into one transfer
+ *  - per-device I/O counters
+ *
+ * Large reads bypass the cache and go to the driver as one transfer
+ * (split only at max_transfer_blocks), so streaming kernels and
+ * ramdisks through fs_read() turns into big DMA transfers.
+ *
+ * Drivers with a DMA engine can also implement submit/poll; callers then
+ * use block_submit() to keep chunk N+1 in flight while they work on
+ * chunk N. Everything else falls back to the synchronous path.
+ */
+
+typedef struct block_device block_device_t;
+typedef struct block_io block_io_t;
+
+/* One piece of a scatter/gather transfer */
+typedef struct {
+    void *buffer;
+    u32 count;              /* blocks */
+} block_seg_t;
+
+typedef struct {
+    u64 requests;           /* block_read/block_write calls */
+    u64 transfers;          /* calls that reached the driver */
+    u64 bytes_read;
+    u64 bytes_written;
+    u64 cache_hits;         /* blocks */
+    u64 cache_misses;       /* blocks */
+    u64 readahead_blocks;
+    u64 merged_requests;    /* queued requests folded into a neighbour */
+} block_io_stats_t;
+
+struct block_device {
+    void *private_data;
+    u64 total_sectors;
+    u32 block_size;
+    u32 media_id;
+    u32 max_transfer_blocks;    /* 0 = no limit */
+
+    /* ---- driver operations (LBA based) ---- */
+    status_t (*read_blocks)(block_device_t *dev, u64 lba, u32 count, void *buffer);
+    status_t (*write_blocks)(block_device_t *dev, u64 lba, u32 count, const void *buffer);
+    status_t (*flush)(block_device_t *dev);
+
+    /* optional: read contiguous LBAs into several buffers in one transfer */
+    status_t (*read_vec)(block_device_t *dev, u64 lba,
+                         const block_seg_t *segs, u32 nsegs);
+
+    /* optional asynchronous path (both or neither), see block_submit() */
+    status_t (*submit)(block_device_t *dev, block_io_t *io);
+    void (*poll)(block_device_t *dev);
+
+    /* ---- owned by the block layer ---- */
+    struct block_cache *cache;      /* NULL = uncached */
+    struct block_request *queue;    /* pending, see block_queue_read() */
+    block_io_stats_t stats;
+
+    /* ---- owned by partition discovery ---- */
+    struct gpt_cache *gpt_cache;    /* validated GPT, NULL until discovered */
+};
+
+/* =========================
+ *  Cache
+ * ========================= */
+
+/*
+ * Give `dev` an LRU cache of `capacity` blocks. Sequential reads prefetch
+ * `readahead` extra blocks. Memory comes from boot_alloc().
+ */
+status_t block_cache_attach(block_device_t *dev, u32 capacity, u32 readahead);
+
+/* Forget all cached blocks (e.g. media change) */
+void block_cache_invalidate(block_device_t *dev);
+
+/* =========================
+ *  Synchronous I/O
+ * ========================= */
+
+status_t block_read(block_device_t *dev, u64 lba, u32 count, void *buffer);
+status_t block_write(block_device_t *dev, u64 lba, u32 count, const void *buffer);
+status_t block_flush(block_device_t *dev);
+
+/* Byte-addressed helpers (partial blocks go through a bounce sector) */
+status_t block_read_bytes(block_device_t *dev, u64 offset, u64 size, void *buffer);
+status_t block_write_bytes(block_device_t *dev, u64 offset, u64 size, const void *buffer);
+
+/* =========================
+ *  Request queue
+ * ========================= */
+
+typedef struct block_request {
+    u64 lba;
+    u32 count;
+    void *buffer;
+    status_t status;        /* set by block_queue_submit() */
+    struct block_request *next;
+} block_request_t;
+
+/* Queue a read; nothing is issued until block_queue_submit() */
+void block_queue_read(block_device_t *dev, block_request_t *req);
+
+/*
+ * Issue all queued reads, sorted by LBA, with adjacent requests merged
+ * into single transfers. Returns the first error, if any; each request
+ * also carries its own status.
+ */
+status_t block_queue_submit(block_device_t *dev);
+
+/* =========================
+ *  Asynchronous I/O
+ * ========================= */
+
+#define BLOCK_IO_WRITE      (1u << 0)
+
+struct block_io {
+    u64 lba;
+    u32 count;
+    u32 flags;                  /* BLOCK_IO_* */
+    void *buffer;
+    volatile status_t status;   /* STATUS_PENDING while in flight */
+
+    /* ---- owned by the device stack ---- */
+    u64 device_lba;             /* lba as seen by the device handling it */
+    struct block_io *next;      /* driver queue link */
+};
+
+/*
+ * Start a transfer. Returns once it is queued (or, on devices without
+ * submit, once it is done); io->status turns from STATUS_PENDING into
+ * the result. `io` and its buffer must stay valid until then, and
+ * count may not exceed max_transfer_blocks on devices with submit. Async
+ * reads do not go through the cache; async writes drop cached copies.
+ */
+status_t block_submit(block_device_t *dev, block_io_t *io);
+
+/* Advance the device; true once `io` has completed */
+bool block_poll(block_device_t *dev, block_io_t *io);
+
+/* Poll until `io` completes and return its status */
+status_t block_wait(block_device_t *dev, block_io_t *io);
+
+/*
+ * For stacked devices (partitions, loop images): pass `io` on to `lower`
+ * with device_lba shifted by `offset` blocks.
+ */
+status_t block_forward(block_device_t *lower, block_io_t *io, u64 offset);
+
+/* =========================
+ *  Accounting
+ * ========================= */
+
+/* Print dev->stats to the console */
+void block_dump_stats(const block_device_t *dev, const char *name);
+
+#endif /* BLOCKIO_H */
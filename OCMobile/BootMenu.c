@@ -1,8 +1,145 @@
 #include "bootstd.h"
+#include "BootMenu.h"
+#include "Event.h"
+#include "Trace.h"
+#include "arch/aarch64/timer.h"
+
+/*
+ * OpenCore Mobile – boot menu
+ *
+ * See BootMenu.h.
+ */
 
 #define MAX_ENTRIES 1024
 #define MIN_ENTRIES NULL
 
-void boot_menu_summon() {
-    
-}
\ No newline at end of file
+/* entries on screen at once; the list scrolls past this */
+#ifndef BOOT_MENU_ROWS
+#define BOOT_MENU_ROWS          12
+#endif
+
+/* screen rows (1-based, as ANSI counts them) */
+#define ROW_TITLE               1
+#define ROW_FIRST               3
+#define ROW_FOOTER              (ROW_FIRST + BOOT_MENU_ROWS + 1)
+
+typedef struct {
+    const boot_menu_t *menu;
+    u32 count;
+    u32 selected;
+    u32 top;                    /* first entry on screen */
+    u32 remaining;              /* countdown in seconds; 0 = stopped */
+} menu_state_t;
+
+/* ===== drawing ===== */
+
+static void draw_row(const menu_state_t *st, u32 index) {
+    printf("\033[%u;1H\033[K", ROW_FIRST + index - st->top);
+    if (index >= st->count)
+        return;
+
+    bool selected = index == st->selected;
+    if (selected)
+        puts("\033[7m");
+    printf(" %s ", st->menu->entries[index].name ? st->menu->entries[index].name : "?");
+    if (selected)
+        puts("\033[0m");
+}
+
+static void draw_list(const menu_state_t *st) {
+    for (u32 i = st->top; i < st->top + BOOT_MENU_ROWS; i++)
+        draw_row(st, i);
+}
+
+static void draw_footer(const menu_state_t *st) {
+    printf("\033[%u;1H\033[K", ROW_FOOTER);
+    if (st->remaining)
+        printf("Booting in %us, any key stops the countdown", st->remaining);
+    else
+        puts("Up/Down choose, Select boots");
+    if (st->count > BOOT_MENU_ROWS)
+        printf("  (%u/%u)", st->selected + 1, st->count);
+}
+
+/* ===== navigation ===== */
+
+/* Select `index`; redraw only the two rows involved unless the list scrolls */
+static void select_entry(menu_state_t *st, u32 index) {
+    u32 old = st->selected;
+
+    st->selected = index;
+    if (index < st->top || index >= st->top + BOOT_MENU_ROWS) {
+        st->top = index < st->top ? index : index + 1 - BOOT_MENU_ROWS;
+        draw_list(st);
+    } else {
+        draw_row(st, old);
+        draw_row(st, index);
+    }
+    if (st->count > BOOT_MENU_ROWS)
+        draw_footer(st);
+}
+
+/* ===== event loop ===== */
+
+int boot_menu_summon(const boot_menu_t *menu) {
+    menu_state_t st;
+
+    if (!menu || !menu->entries || !menu->count)
+        return BOOT_MENU_CANCEL;
+
+    st.menu = menu;
+    st.count = menu->count < MAX_ENTRIES ? menu->count : MAX_ENTRIES;
+    st.selected = menu->default_index < st.count ? menu->default_index : 0;
+    st.top = st.selected >= BOOT_MENU_ROWS ? st.selected + 1 - BOOT_MENU_ROWS : 0;
+
+    /* without a counter frequency there is no second to count: just wait */
+    u64 second = timer_frequency();
+    st.remaining = second ? menu->timeout : 0;
+    u64 tick = st.remaining ? timer_ticks() + second : EVENT_FOREVER;
+
+    trace_begin("menu");
+
+    console_clear();
+    printf("\033[%u;1H%s", ROW_TITLE, menu->title ? menu->title : "OpenCore Mobile");
+    draw_list(&st);
+    draw_footer(&st);
+
+    int chosen;
+    for (;;) {
+        boot_key_t key = input_wait(tick);
+
+        if (key == KEY_NONE) {
+            if (!st.remaining)
+                continue;
+            if (--st.remaining == 0) {
+                chosen = (int)st.selected;
+                break;
+            }
+            tick += second;     /* from the last tick, not from now: no drift */
+            draw_footer(&st);
+            continue;
+        }
+
+        if (st.remaining) {
+            st.remaining = 0;
+            tick = EVENT_FOREVER;
+            draw_footer(&st);
+        }
+
+        if (key == KEY_UP || key == KEY_LEFT) {
+            select_entry(&st, st.selected ? st.selected - 1 : st.count - 1);
+        } else if (key == KEY_DOWN || key == KEY_RIGHT) {
+            select_entry(&st, st.selected + 1 < st.count ? st.selected + 1 : 0);
+        } else if (key == KEY_SELECT) {
+            chosen = (int)st.selected;
+            break;
+        } else if (key == KEY_BACK) {
+            chosen = BOOT_MENU_CANCEL;
+            break;
+        }
+    }
+
+    printf("\033[%u;1H\033[K", ROW_FOOTER);
+    trace_end("menu", (u64)(s64)chosen);
+    return chosen;
+}
@@ -0,0 +1,39 @@
+#ifndef BOOTMENU_H
+#define BOOTMENU_H
+
+#include "bootstd.h"
+
+/*
+ * OpenCore Mobile – boot menu
+ *
+ * An event loop over input_wait(): nothing runs between key presses and
+ * the auto-boot countdown ticks from the generic timer's interrupt, so an
+ * idle picker keeps the core in wfi. The menu is drawn with the console's
+ * ANSI subset (Framebuffer.h), which reaches both the UART and, once
+ * fb_console_attach() has been called, the panel; a key press rewrites
+ * only the rows it changed.
+ */
+
+#define BOOT_MENU_CANCEL        (-1)
+
+typedef struct {
+    const char *name;
+    void *context;              /* the caller's, untouched */
+} boot_menu_entry_t;
+
+typedef struct {
+    const char *title;
+    const boot_menu_entry_t *entries;
+    u32 count;
+    u32 default_index;
+    u32 timeout;                /* seconds until the default boots; 0 = wait */
+} boot_menu_t;
+
+/*
+ * Show the menu and wait for a choice: the index picked (or the default,
+ * once the countdown runs out), or BOOT_MENU_CANCEL for KEY_BACK. Any key
+ * stops the countdown. Needs input_init(); event_init() for the timeout.
+ */
+int boot_menu_summon(const boot_menu_t *menu);
+
+#endif /* BOOTMENU_H */
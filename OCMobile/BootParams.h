@@ -0,0 +1,47 @@
+#ifndef BOOTPARAMS_H
+#define BOOTPARAMS_H
+
+#include "bootstd.h"
+#include "BootTrace.h"
+
+/*
+ * OpenCore Mobile – boot parameters
+ * Filled in by whatever stage chainloads us (ABL shim, U-Boot, ...),
+ * handed to boot_main() in x1.
+ */
+
+#define OCM_BOOT_MAGIC 0x4F434D424F4F54ULL /* "OCMBOOT" */
+
+/* ---- memory map ---- */
+
+typedef enum {
+    OCM_MEM_USABLE = 1,     /* free RAM, ours to allocate from */
+    OCM_MEM_RESERVED,       /* firmware, TZ carveouts, our own image */
+    OCM_MEM_MMIO
+} ocm_mem_type_t;
+
+typedef struct {
+    u64 base;
+    u64 size;
+    u32 type;               /* ocm_mem_type_t */
+    u32 reserved;
+} ocm_mem_region_t;
+
+/* ---- boot parameters ---- */
+
+struct ocm_boot_params {
+    const ocm_mem_region_t *mem_map;
+    u32 mem_map_count;
+    u32 reserved;
+
+    /* the previous stage's flattened device tree (Android's DTB), NULL if
+     * none; its header has the size. The kernel handoff passes it on as
+     * /chosen/ocm-fdt, which AndroidPlatformBridge indexes */
+    const void *fdt;
+
+    /* ours to fill in for the kernel: boot timeline, see Trace.h */
+    const ocm_boot_trace_t *trace;
+    u64 trace_size;
+};
+
+#endif /* BOOTPARAMS_H */
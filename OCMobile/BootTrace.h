@@ -0,0 +1,41 @@
+#ifndef BOOTTRACE_H
+#define BOOTTRACE_H
+
+#include <stdint.h>
+
+/*
+ * OpenCore Mobile – boot timeline wire format
+ *
+ * What the loader hands the kernel in ocm_boot_params->trace, and what
+ * AndroidPlatformBridge publishes. Self-contained so kernel-side code
+ * can include it without the loader's bootstd.h.
+ *
+ * An ocm_boot_trace_t header is followed by `count` ocm_trace_event_t
+ * records, oldest first.
+ */
+
+#define OCM_TRACE_MAGIC         0x544D434FU     /* "OCMT" */
+#define OCM_TRACE_VERSION       1
+#define OCM_TRACE_NAME_LEN      20
+
+/* ocm_trace_event_t.kind */
+#define OCM_TRACE_MARK          0               /* a point in time */
+#define OCM_TRACE_BEGIN         1               /* a phase starts... */
+#define OCM_TRACE_END           2               /* ...and ends (same name) */
+
+typedef struct {
+    uint64_t ticks;                     /* CNTVCT_EL0 */
+    uint64_t arg;                       /* event specific: bytes, count, status */
+    uint32_t kind;
+    char name[OCM_TRACE_NAME_LEN];      /* NUL padded, not always terminated */
+} ocm_trace_event_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t frequency;                 /* CNTFRQ_EL0, ticks per second; 0 = unknown */
+    uint32_t count;                     /* records that follow */
+    uint32_t dropped;                   /* older ones the ring overwrote */
+} ocm_boot_trace_t;
+
+#endif /* BOOTTRACE_H */
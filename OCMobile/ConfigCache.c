@@ -0,0 +1,146 @@
+#include "ConfigCache.h"
+#include "Memory.h"
+#include "Trace.h"
+#include "Platform/crc32/crc32.h"
+
+/*
+ * OpenCore Mobile – precompiled config.plist cache
+ * See ConfigCache.h.
+ */
+
+/* fs_read() granularity while the config's size is still unknown */
+#define CONFIG_READ_CHUNK       (64u << 10)
+
+/* sanity bound on an image header before trusting its size */
+#define CONFIG_CACHE_MAX_SIZE   (64u << 20)
+
+/* =========================
+ *  Files
+ * ========================= */
+
+/* Read all of `path` into the arena */
+static status_t read_file(fs_t *fs, const char *path, u8 **out, size_t *size) {
+    file_t file;
+    size_t cap = CONFIG_READ_CHUNK, len = 0, n;
+    u8 *buf;
+
+    if (fs_open(fs, path, &file) != 0)
+        return STATUS_NOT_FOUND;
+
+    buf = arena_alloc(cap);
+    while (buf && (n = fs_read(&file, buf + len, cap - len)) > 0) {
+        len += n;
+        if (len < cap)
+            continue;
+
+        /* the old buffer stays behind in the arena until the stage ends */
+        u8 *grown = arena_alloc(cap * 2);
+        if (grown)
+            memcpy(grown, buf, len);
+        buf = grown;
+        cap *= 2;
+    }
+
+    fs_close(&file);
+    if (!buf)
+        return STATUS_OUT_OF_MEMORY;
+
+    *out = buf;
+    *size = len;
+    return STATUS_SUCCESS;
+}
+
+/* =========================
+ *  Image
+ * ========================= */
+
+/* Map the cached image if it was built from exactly this config */
+static status_t load_image(fs_t *fs, const char *path, u64 config_size, u32 config_crc,
+                           plist_dict_t *out) {
+    arena_mark_t mark = arena_mark();
+    plist_image_header_t hdr;
+    file_t file;
+    status_t status = STATUS_NOT_FOUND;
+
+    if (fs_open(fs, path, &file) != 0)
+        return STATUS_NOT_FOUND;
+
+    /* the header alone decides, so a stale image costs one small read */
+    if (fs_read(&file, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+        memcmp(hdr.magic, PLIST_IMAGE_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.version != PLIST_IMAGE_VERSION ||
+        hdr.source_size != config_size || hdr.source_crc != config_crc ||
+        hdr.image_size < sizeof(hdr) || hdr.image_size > CONFIG_CACHE_MAX_SIZE)
+        goto out;
+
+    size_t rest = (size_t)hdr.image_size - sizeof(hdr);
+    u8 *image = arena_alloc((size_t)hdr.image_size);
+
+    status = STATUS_OUT_OF_MEMORY;
+    if (!image)
+        goto out;
+
+    memcpy(image, &hdr, sizeof(hdr));
+
+    status = STATUS_CRC_ERROR;
+    if (fs_read(&file, image + sizeof(hdr), rest) == rest &&
+        plist_image_map(image, (size_t)hdr.image_size, out) == 0)
+        status = STATUS_SUCCESS;
+
+out:
+    fs_close(&file);
+    if (status != STATUS_SUCCESS)
+        arena_release(mark);
+    return status;
+}
+
+/* =========================
+ *  Config
+ * ========================= */
+
+static status_t load_config(fs_t *fs, const char *config_path, const char *cache_path,
+                            plist_dict_t *out, config_cache_info_t *info) {
+    u8 *config;
+    size_t size;
+    status_t status;
+
+    status = read_file(fs, config_path, &config, &size);
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    info->config_size = size;
+    info->config_crc = crc32_calculate(config, size);
+
+    if (cache_path &&
+        load_image(fs, cache_path, size, info->config_crc, out) == STATUS_SUCCESS) {
+        info->cache_hit = true;
+        return STATUS_SUCCESS;
+    }
+
+    /* changed since mksdk.py built the image, or there is none */
+    trace_begin("plist parse");
+    int parsed = plist_parse(config, size, out);
+    trace_end("plist parse", out->count);
+    if (parsed != 0)
+        return STATUS_ERROR;
+
+    if (cache_path)
+        printf("config: %s missing or stale, rerun mksdk.py --config-cache\n", cache_path);
+
+    return STATUS_SUCCESS;
+}
+
+status_t config_load(fs_t *fs, const char *config_path, const char *cache_path,
+                     plist_dict_t *out, config_cache_info_t *info) {
+    config_cache_info_t local;
+
+    if (!info)
+        info = &local;
+    memset(info, 0, sizeof(*info));
+
+    trace_begin("config");
+    status_t status = load_config(fs, config_path, cache_path, out, info);
+    trace_end("config", info->cache_hit);
+
+    return status;
+}
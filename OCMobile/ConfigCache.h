@@ -0,0 +1,41 @@
+#ifndef CONFIGCACHE_H
+#define CONFIGCACHE_H
+
+#include <stdbool.h>
+
+#include "bootstd.h"
+#include "Platform/plist/plist.h"
+
+/*
+ * OpenCore Mobile – precompiled config.plist cache
+ *
+ * config.plist is read and CRC'd on every boot, but only parsed when it
+ * changed: next to it lives a plist image (see plist_image_map()) tagged
+ * with the size and CRC of the config it was built from. When both
+ * match, the image is read and relocated in place instead; otherwise the
+ * config is parsed as before.
+ *
+ * The loader's filesystems are read-only, so the image is only ever
+ * built offline, by Tools/mksdk.py --config-cache; after editing
+ * config.plist on the device, rerun it or every boot pays for a parse.
+ */
+
+#define OCM_CONFIG_PATH         "/EFI/OC/config.plist"
+#define OCM_CONFIG_CACHE_PATH   "/EFI/OC/config.cache"
+
+typedef struct {
+    u64 config_size;
+    u32 config_crc;
+    bool cache_hit;
+} config_cache_info_t;
+
+/*
+ * Load `config_path` from `fs` into `out`, going through the image at
+ * `cache_path`, which may be NULL or missing. Everything (the config
+ * buffer, the image, the dict) lives in the stage arena. `info` may be
+ * NULL.
+ */
+status_t config_load(fs_t *fs, const char *config_path, const char *cache_path,
+                     plist_dict_t *out, config_cache_info_t *info);
+
+#endif /* CONFIGCACHE_H */
@@ -0,0 +1,454 @@
+#include <stdarg.h>
+#include <stdbool.h>
+
+#include "bootstd.h"
+#include "arch/aarch64/cpu.h"
+#include "arch/aarch64/io.h"
+#include "arch/aarch64/irq.h"
+
+/*
+ * OpenCore Mobile – console
+ *
+ * putc/puts/printf copy into a ring and return; nothing on the boot path
+ * waits for the UART. The ring drains to a PL011:
+ *  - opportunistically after every write, as far as the TX FIFO has room
+ *    (a few MMIO reads, no waiting)
+ *  - from console_uart_irq() once console_enable_irq() has been called,
+ *    so output keeps flowing while the boot path is busy elsewhere
+ *  - synchronously only from console_flush(), i.e. on panic
+ *
+ * The mirror costs glyph rendering and a present, so a write doesn't
+ * feed it: console_poll() does (the boot menu's event loop, the UART
+ * interrupt, console_flush()). Only when it has fallen half a ring
+ * behind, and would start costing UART output, does a write render up
+ * to MIRROR_WRITE_BATCH bytes of it.
+ *
+ * Writers are lock-free among themselves: a write claims space with a
+ * CAS on `reserve`, copies, then publishes in claim order through
+ * `commit`. IRQs are masked for that short window so a handler that
+ * prints can't wait on the writer it interrupted. One drainer runs at a
+ * time (try-lock); whoever loses just returns.
+ *
+ * UART and mirror (framebuffer text console) read the same ring with
+ * their own cursors; space is reclaimed behind the slower one. When the
+ * ring is full new output is dropped and counted, never waited for.
+ *
+ * Received bytes go to the console_set_input() callback (the boot menu's
+ * serial keys), from the RX interrupt or, without one, from console_poll().
+ */
+
+#ifndef CONSOLE_UART_BASE
+#define CONSOLE_UART_BASE       0x09000000      /* PL011; QEMU virt, per device later */
+#endif
+
+#ifndef CONSOLE_UART_IRQ
+#define CONSOLE_UART_IRQ        33              /* SPI 1 */
+#endif
+
+#ifndef CONSOLE_RING_SIZE
+#define CONSOLE_RING_SIZE       (64u << 10)     /* power of two */
+#endif
+
+#define RING_MASK               (CONSOLE_RING_SIZE - 1)
+
+/* printf formats into this much stack before handing it to the ring */
+#define FORMAT_CHUNK            256
+
+/* Mirror bytes a write renders once the mirror lags half a ring */
+#define MIRROR_WRITE_BATCH      512
+
+/* PL011 */
+#define UART_DR                 0x000
+#define UART_FR                 0x018
+#define UART_IMSC               0x038
+#define UART_ICR                0x044
+
+#define UART_FR_BUSY            (1u << 3)
+#define UART_FR_RXFE            (1u << 4)
+#define UART_FR_TXFF            (1u << 5)
+#define UART_INT_RX             (1u << 4)
+#define UART_INT_TX             (1u << 5)
+#define UART_INT_RT             (1u << 6)
+
+static struct {
+    char buf[CONSOLE_RING_SIZE];
+
+    /* free running; wrap-around arithmetic throughout */
+    u32 reserve;                /* writers claim [reserve, reserve + n) */
+    u32 commit;                 /* everything below is complete */
+    u32 uart_tail;
+    u32 mirror_tail;
+
+    u32 draining;               /* drainer try-lock */
+    u32 dropped;                /* bytes lost to a full ring */
+    bool cr_sent;               /* '\r' of a "\r\n" already in the FIFO */
+    bool irq_driven;
+
+    void (*mirror)(const char *s, size_t len);
+    void (*input)(u8 c);
+} con;
+
+static inline u32 load_acquire(const u32 *p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void store_release(u32 *p, u32 v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+/* Oldest byte some reader still needs, seen from `head` */
+static u32 oldest_tail(u32 head) {
+    u32 uart = load_acquire(&con.uart_tail);
+
+    if (!con.mirror)
+        return uart;
+
+    u32 mirror = load_acquire(&con.mirror_tail);
+    return head - uart > head - mirror ? uart : mirror;
+}
+
+/* =========================
+ *  Ring
+ * ========================= */
+
+static void drain(bool write);
+
+static void ring_write(const char *s, size_t len) {
+    if (!len)
+        return;
+
+    if (len >= CONSOLE_RING_SIZE) {
+        __atomic_fetch_add(&con.dropped, (u32)len, __ATOMIC_RELAXED);
+        return;
+    }
+
+    u64 daif = irq_save();
+    u32 n = (u32)len;
+    u32 start = __atomic_load_n(&con.reserve, __ATOMIC_RELAXED);
+
+    do {
+        if (n > CONSOLE_RING_SIZE - (start - oldest_tail(start))) {
+            __atomic_fetch_add(&con.dropped, n, __ATOMIC_RELAXED);
+            irq_restore(daif);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&con.reserve, &start, start + n, true,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+    u32 at = start & RING_MASK;
+    u32 first = n < CONSOLE_RING_SIZE - at ? n : CONSOLE_RING_SIZE - at;
+
+    memcpy(con.buf + at, s, first);
+    memcpy(con.buf, s + first, n - first);
+
+    /* publish in claim order; only another core can be ahead of us here */
+    while (load_acquire(&con.commit) != start)
+        cpu_relax();
+    store_release(&con.commit, start + n);
+
+    irq_restore(daif);
+
+    drain(true);
+}
+
+/* =========================
+ *  Draining
+ * ========================= */
+
+static void drain_uart(u32 head) {
+    uintptr_t base = CONSOLE_UART_BASE;
+    u32 tail = con.uart_tail;
+
+    while (tail != head && !(mmio_read32(base + UART_FR) & UART_FR_TXFF)) {
+        char c = con.buf[tail & RING_MASK];
+
+        if (c == '\n' && !con.cr_sent) {
+            mmio_write32(base + UART_DR, '\r');
+            con.cr_sent = true;
+            continue;
+        }
+
+        mmio_write32(base + UART_DR, (u8)c);
+        con.cr_sent = false;
+        tail++;
+    }
+
+    store_release(&con.uart_tail, tail);
+}
+
+/* Up to `max` bytes of [mirror_tail, head) to the mirror */
+static void drain_mirror(u32 head, u32 max) {
+    void (*mirror)(const char *, size_t) = con.mirror;
+    u32 tail = con.mirror_tail;
+
+    if (!mirror)
+        return;
+    if (head - tail > max)
+        head = tail + max;
+
+    while (tail != head) {
+        u32 at = tail & RING_MASK;
+        u32 n = head - tail;
+
+        if (n > CONSOLE_RING_SIZE - at)
+            n = CONSOLE_RING_SIZE - at;
+        mirror(con.buf + at, n);
+        tail += n;
+    }
+
+    store_release(&con.mirror_tail, tail);
+}
+
+/* Hand whatever the RX FIFO holds to the input callback */
+static void drain_rx(void) {
+    void (*input)(u8 c) = con.input;
+
+    if (!input)
+        return;
+    while (!(mmio_read32(CONSOLE_UART_BASE + UART_FR) & UART_FR_RXFE))
+        input((u8)mmio_read32(CONSOLE_UART_BASE + UART_DR));
+}
+
+/* `write`: on a writer's path, where only the UART is cheap enough */
+static void drain(bool write) {
+    u32 head;
+    bool pending;
+
+    do {
+        /* seq_cst pairs with the fence below: a loser sees us, or we see its commit */
+        if (__atomic_exchange_n(&con.draining, 1, __ATOMIC_SEQ_CST))
+            return;
+
+        drain_rx();
+
+        head = load_acquire(&con.commit);
+
+        drain_uart(head);
+        if (!write)
+            drain_mirror(head, CONSOLE_RING_SIZE);
+        else if (con.mirror && head - con.mirror_tail > CONSOLE_RING_SIZE / 2)
+            drain_mirror(head, MIRROR_WRITE_BATCH);
+
+        pending = con.uart_tail != head;
+
+        /* TX interrupts only while there is something to send */
+        if (con.irq_driven)
+            mmio_write32(CONSOLE_UART_BASE + UART_IMSC, (pending ? UART_INT_TX : 0) |
+                         (con.input ? UART_INT_RX | UART_INT_RT : 0));
+
+        store_release(&con.draining, 0);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        /*
+         * A writer that lost the try-lock after `head` was sampled left
+         * its bytes to us, possibly with TX interrupts just masked: go
+         * round again rather than strand them until the next write.
+         */
+    } while (load_acquire(&con.commit) != head);
+
+    /* caught up after losing output: say so, once */
+    u32 dropped;
+    if (!pending && (dropped = __atomic_exchange_n(&con.dropped, 0, __ATOMIC_RELAXED)))
+        printf("\n[console: %u bytes dropped]\n", dropped);
+}
+
+void console_poll(void) {
+    drain(false);
+}
+
+void console_uart_irq(void) {
+    mmio_write32(CONSOLE_UART_BASE + UART_ICR, UART_INT_TX | UART_INT_RX | UART_INT_RT);
+    console_poll();
+}
+
+static void uart_handler(void *ctx) {
+    (void)ctx;
+    console_uart_irq();
+}
+
+void console_enable_irq(void) {
+    /* without an interrupt controller the opportunistic drain is all there is */
+    if (irq_register(CONSOLE_UART_IRQ, uart_handler, NULL, 0) != STATUS_SUCCESS)
+        return;
+    con.irq_driven = true;
+    console_poll();
+}
+
+void console_set_input(void (*input)(u8 c)) {
+    con.input = input;
+    console_poll();
+}
+
+void console_flush(void) {
+    while (load_acquire(&con.uart_tail) != load_acquire(&con.commit)) {
+        console_poll();
+        cpu_relax();
+    }
+    console_poll();             /* the mirror, if the UART was already done */
+
+    while (mmio_read32(CONSOLE_UART_BASE + UART_FR) & UART_FR_BUSY)
+        cpu_relax();
+}
+
+void console_set_mirror(void (*write)(const char *s, size_t len)) {
+    /* start with whatever the UART hasn't consumed yet */
+    store_release(&con.mirror_tail, load_acquire(&con.uart_tail));
+    con.mirror = write;
+    console_poll();
+}
+
+/* =========================
+ *  Output
+ * ========================= */
+
+void console_init(void) {
+    /* .bss isn't cleared by entry.s */
+    memset(&con, 0, sizeof(con));
+    mmio_write32(CONSOLE_UART_BASE + UART_IMSC, 0);
+}
+
+void putc(char c) {
+    ring_write(&c, 1);
+}
+
+void puts(const char *s) {
+    ring_write(s, strlen(s));
+}
+
+typedef struct {
+    char buf[FORMAT_CHUNK];
+    size_t len;
+} format_t;
+
+static void emit(format_t *f, char c) {
+    if (f->len == sizeof(f->buf)) {
+        ring_write(f->buf, f->len);
+        f->len = 0;
+    }
+    f->buf[f->len++] = c;
+}
+
+static void emit_number(format_t *f, u64 v, unsigned base, bool neg, unsigned width, char pad) {
+    char digits[24];
+    unsigned n = 0;
+
+    do {
+        digits[n++] = "0123456789abcdef"[v % base];
+        v /= base;
+    } while (v);
+
+    if (neg && pad == '0') {
+        emit(f, '-');           /* -0042, not 00-42 */
+        width = width ? width - 1 : 0;
+    } else if (neg) {
+        digits[n++] = '-';
+    }
+
+    for (unsigned i = n; i < width; i++)
+        emit(f, pad);
+    while (n)
+        emit(f, digits[--n]);
+}
+
+void printf(const char *fmt, ...) {
+    format_t f;
+    va_list ap;
+
+    f.len = 0;
+    va_start(ap, fmt);
+
+    for (; *fmt; fmt++) {
+        if (*fmt != '%') {
+            emit(&f, *fmt);
+            continue;
+        }
+
+        char pad = ' ';
+        unsigned width = 0;
+        int longs = 0;
+
+        if (*++fmt == '0')
+            pad = '0';
+        while (*fmt >= '0' && *fmt <= '9')
+            width = width * 10 + (unsigned)(*fmt++ - '0');
+        while (*fmt == 'l' || *fmt == 'z') {
+            longs += (*fmt == 'z') ? 2 : 1;
+            fmt++;
+        }
+
+        switch (*fmt) {
+        case 'd': {
+            s64 v = longs ? va_arg(ap, s64) : va_arg(ap, int);
+            emit_number(&f, v < 0 ? 0 - (u64)v : (u64)v, 10, v < 0, width, pad);
+            break;
+        }
+        case 'u':
+        case 'x': {
+            u64 v = longs ? va_arg(ap, u64) : va_arg(ap, unsigned);
+            emit_number(&f, v, *fmt == 'x' ? 16 : 10, false, width, pad);
+            break;
+        }
+        case 'p':
+            emit(&f, '0');
+            emit(&f, 'x');
+            emit_number(&f, (uintptr_t)va_arg(ap, void *), 16, false, width, pad);
+            break;
+        case 'c':
+            emit(&f, (char)va_arg(ap, int));
+            break;
+        case 's': {
+            const char *s = va_arg(ap, const char *);
+            size_t n;
+
+            if (!s)
+                s = "(null)";
+            for (n = strlen(s); n < width; n++)
+                emit(&f, ' ');
+            while (*s)
+                emit(&f, *s++);
+            break;
+        }
+        case '%':
+            emit(&f, '%');
+            break;
+        case '\0':
+            fmt--;
+            break;
+        default:
+            emit(&f, '%');
+            emit(&f, *fmt);
+            break;
+        }
+    }
+
+    va_end(ap);
+    ring_write(f.buf, f.len);
+}
+
+void console_clear(void) {
+    /* ANSI: clear, home; the framebuffer console reads the same bytes */
+    puts("\033[2J\033[H");
+}
+
+/* =========================
+ *  Panic / Halt
+ * ========================= */
+
+void halt(void) {
+    for (;;)
+        cpu_wfi();
+}
+
+/* loud, final, honest: the only place that waits for the UART */
+void panic(const char *reason) {
+    irq_save();
+
+    /* whoever held the drain lock isn't coming back */
+    store_release(&con.draining, 0);
+
+    puts("\npanic: ");
+    puts(reason);
+    putc('\n');
+    console_flush();
+    halt();
+}
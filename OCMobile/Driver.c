@@ -0,0 +1,221 @@
+#include "Driver.h"
+#include "Memory.h"
+#include "Smp.h"
+#include "Trace.h"
+#include "arch/aarch64/io.h"
+#include "arch/aarch64/timer.h"
+
+/*
+ * OpenCore Mobile – WriterSc drivers
+ * See Driver.h.
+ */
+
+/* =========================
+ *  Host functions
+ * ========================= */
+
+static u64 host_mmio_read8(void *ctx, const u64 *a)   { (void)ctx; return mmio_read8(a[0]); }
+static u64 host_mmio_read16(void *ctx, const u64 *a)  { (void)ctx; return mmio_read16(a[0]); }
+static u64 host_mmio_read32(void *ctx, const u64 *a)  { (void)ctx; return mmio_read32(a[0]); }
+
+static u64 host_mmio_write8(void *ctx, const u64 *a) {
+    (void)ctx;
+    mmio_write8(a[0], (u8)a[1]);
+    return 0;
+}
+
+static u64 host_mmio_write16(void *ctx, const u64 *a) {
+    (void)ctx;
+    mmio_write16(a[0], (u16)a[1]);
+    return 0;
+}
+
+static u64 host_mmio_write32(void *ctx, const u64 *a) {
+    (void)ctx;
+    mmio_write32(a[0], (u32)a[1]);
+    return 0;
+}
+
+static u64 host_udelay(void *ctx, const u64 *a) {
+    (void)ctx;
+    udelay((u32)a[0]);
+    return 0;
+}
+
+static u64 host_ticks(void *ctx, const u64 *a) {
+    (void)ctx;
+    (void)a;
+    return timer_ticks();
+}
+
+static u64 host_putc(void *ctx, const u64 *a) {
+    (void)ctx;
+    putc((char)a[0]);
+    return 0;
+}
+
+static const wscd_native_t host_functions[] = {
+    { "mmio_read8",     1, host_mmio_read8 },
+    { "mmio_read16",    1, host_mmio_read16 },
+    { "mmio_read32",    1, host_mmio_read32 },
+    { "mmio_write8",    2, host_mmio_write8 },
+    { "mmio_write16",   2, host_mmio_write16 },
+    { "mmio_write32",   2, host_mmio_write32 },
+    { "udelay",         1, host_udelay },
+    { "ticks",          0, host_ticks },
+    { "putc",           1, host_putc },
+};
+
+/* =========================
+ *  Running
+ * ========================= */
+
+static const char *fault_name(int r) {
+    switch (r) {
+    case WSCD_ERR_ARGS:     return "bad call";
+    case WSCD_ERR_UNBOUND:  return "unbound host function";
+    case WSCD_ERR_STACK:    return "stack overflow";
+    default:                return "fault";
+    }
+}
+
+static void native_fault(void *ctx, u64 reason) {
+    (void)ctx;
+    (void)reason;
+    panic("driver: native stack overflow");
+}
+
+static status_t run(driver_t *drv, u32 fn, const u64 *args, u32 nargs, u64 *result) {
+    if (drv->native) {
+        uintptr_t limit = smp_stack_base() + DRIVER_NATIVE_MARGIN;
+
+        if ((uintptr_t)__builtin_frame_address(0) <= limit) {
+            printf("driver: %s: %s() failed: stack overflow\n", wscd_name(&drv->module),
+                   wscd_func_name(&drv->module, fn));
+            return STATUS_ERROR;
+        }
+        if (wscd_call_native(&drv->module, fn, args, nargs, limit, native_fault, result) == 0)
+            return STATUS_SUCCESS;
+        printf("driver: %s: %s() failed: bad call\n", wscd_name(&drv->module),
+               wscd_func_name(&drv->module, fn));
+        return STATUS_ERROR;
+    }
+
+    arena_mark_t mark = arena_mark();
+    wscd_stack_t stack = {
+        .regs = arena_alloc(DRIVER_STACK_REGS * sizeof(u64)),
+        .reg_count = DRIVER_STACK_REGS,
+        .frames = arena_alloc(DRIVER_MAX_DEPTH * sizeof(wscd_frame_t)),
+        .frame_count = DRIVER_MAX_DEPTH,
+    };
+    status_t status = STATUS_SUCCESS;
+
+    if (!stack.regs || !stack.frames) {
+        arena_release(mark);
+        return STATUS_OUT_OF_MEMORY;
+    }
+
+    int r = wscd_call(&drv->module, &stack, fn, args, nargs, result);
+    if (r) {
+        printf("driver: %s: %s() failed: %s\n", wscd_name(&drv->module),
+               wscd_func_name(&drv->module, fn), fault_name(r));
+        status = STATUS_ERROR;
+    }
+
+    arena_release(mark);
+    return status;
+}
+
+/* =========================
+ *  Public API
+ * ========================= */
+
+/* A driver that did not load gives its image back */
+static status_t discard(driver_t *drv, status_t status) {
+    boot_free(drv->image, drv->size);
+    memset(drv, 0, sizeof(*drv));
+    return status;
+}
+
+status_t driver_load(fs_t *fs, const char *path, driver_t *out) {
+    file_t file;
+    const char *missing = NULL;
+
+    memset(out, 0, sizeof(*out));
+    if (fs_open(fs, path, &file) != 0)
+        return STATUS_NOT_FOUND;
+
+    u64 size = fs_size(&file);
+    if (size > 0xFFFFFFFFu) {
+        fs_close(&file);
+        return STATUS_CRC_ERROR;
+    }
+
+    out->image = boot_alloc(size);
+    out->size = size;
+    if (!out->image) {
+        fs_close(&file);
+        return STATUS_OUT_OF_MEMORY;
+    }
+
+    size_t got = fs_read(&file, out->image, size);
+    fs_close(&file);
+    if (got != size)
+        return discard(out, STATUS_ERROR);
+
+    if (wscd_open(out->image, size, &out->module) != 0) {
+        printf("driver: %s is no valid .wscd image\n", path);
+        return discard(out, STATUS_CRC_ERROR);
+    }
+
+    const char *name = wscd_name(&out->module);
+
+    if (out->module.native) {
+        icache_sync_range(out->image, size);
+        out->native = true;
+    }
+
+    if (wscd_bind(&out->module, host_functions,
+                  sizeof(host_functions) / sizeof(host_functions[0]), out, &missing)) {
+        printf("driver: %s requires %s, which the loader lacks\n", name, missing);
+        return discard(out, STATUS_NOT_FOUND);
+    }
+
+    u32 init = out->module.header->init;
+    u64 result = 0;
+    status_t status = STATUS_SUCCESS;
+
+    if (init != WSCD_NO_FUNC) {
+        u64 t0 = timer_ticks();
+
+        status = run(out, init, NULL, 0, &result);
+        out->init_ticks = timer_ticks() - t0;
+    }
+
+    char label[OCM_TRACE_NAME_LEN + 1];
+    u64 freq = timer_frequency();
+    u64 usec = freq ? out->init_ticks * 1000000 / freq : 0;
+
+    trace_label(label, name, " init");
+    trace_mark(label, usec);
+
+    if (status == STATUS_SUCCESS && result) {
+        printf("driver: %s: init() returned %u\n", name, (u32)result);
+        status = STATUS_ERROR;
+    }
+    if (status != STATUS_SUCCESS)
+        return discard(out, status);
+    printf("driver: %s: started in %u us%s\n", name, (u32)usec,
+           out->native ? " (native)" : "");
+    return STATUS_SUCCESS;
+}
+
+status_t driver_call(driver_t *drv, const char *name,
+                     const u64 *args, u32 nargs, u64 *result) {
+    u32 fn = wscd_find(&drv->module, name);
+    u64 local;
+
+    if (fn == WSCD_NO_FUNC)
+        return STATUS_NOT_FOUND;
+    return run(drv, fn, args, nargs, result ? result : &local);
+}
@@ -0,0 +1,56 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include <stdbool.h>
+
+#include "bootstd.h"
+#include "Platform/wscd/wscd.h"
+
+/*
+ * OpenCore Mobile – WriterSc drivers
+ *
+ * Drivers are .wscd images (Tools/writersc, format in Platform/wscd/wscd.h)
+ * rather than EFI binaries. driver_load() reads one into permanent memory,
+ * checks it once, binds what it `requires` against the loader's host
+ * functions and runs its init(), which returns 0 to stay loaded; its
+ * exported functions can be called from then on.
+ *
+ * Host functions a driver can require:
+ *   mmio_read8/16/32(addr)        mmio_write8/16/32(addr, value)
+ *   udelay(usec)                  ticks()         (CNTVCT_EL0)
+ *   putc(c)
+ *
+ * An image compiled for this CPU as well runs its native code on the
+ * calling core's stack, which it may use down to DRIVER_NATIVE_MARGIN
+ * above the bottom (smp_stack_base()); going past that panics, with the
+ * margin left for the panic and any interrupt taken on the way. Otherwise each call is interpreted on a DRIVER_STACK_REGS
+ * register stack taken from the stage arena and given back when it
+ * returns. Each load records a "<name> init" mark (arg: microseconds
+ * init() took).
+ */
+
+#define DRIVER_STACK_REGS       2048
+#define DRIVER_MAX_DEPTH        64
+#define DRIVER_NATIVE_MARGIN    (4 * 1024)
+
+typedef struct {
+    wscd_module_t module;
+    void *image;                /* boot_alloc(), given back if loading fails */
+    size_t size;
+    u64 init_ticks;             /* CNTVCT_EL0 ticks init() ran */
+    bool native;                /* running the image's aarch64 code */
+} driver_t;
+
+/*
+ * Load and start the driver at `path`. STATUS_NOT_FOUND if there is no
+ * such file or it requires a host function the loader lacks,
+ * STATUS_CRC_ERROR if it is no valid image, STATUS_ERROR if init() faults
+ * or returns nonzero.
+ */
+status_t driver_load(fs_t *fs, const char *path, driver_t *out);
+
+/* Call the exported function `name`; STATUS_NOT_FOUND if it has none, STATUS_ERROR on a fault */
+status_t driver_call(driver_t *drv, const char *name,
+                     const u64 *args, u32 nargs, u64 *result);
+
+#endif /* DRIVER_H */
@@ -0,0 +1,93 @@
+#include "Event.h"
+#include "arch/aarch64/cpu.h"
+#include "arch/aarch64/io.h"
+#include "arch/aarch64/irq.h"
+#include "arch/aarch64/timer.h"
+
+/*
+ * OpenCore Mobile – waiting
+ *
+ * See Event.h.
+ *
+ * The comparator is only armed by whoever is about to wfi, for its own
+ * deadline, and the interrupt just disarms it again: waits are not
+ * nested (handlers never sleep) so there is no queue of timers to keep.
+ */
+
+/* udelay() below this spins; sleeping isn't worth the interrupt round trip */
+#ifndef EVENT_SPIN_US
+#define EVENT_SPIN_US           50
+#endif
+
+static bool timer_irq;
+
+static void timer_handler(void *ctx) {
+    (void)ctx;
+    timer_disarm();
+}
+
+void event_init(void) {
+    timer_disarm();
+    timer_irq = irq_register(TIMER_VIRT_INTID, timer_handler, NULL, 0) == STATUS_SUCCESS;
+}
+
+u64 event_deadline_us(u64 usec) {
+    if (!timer_frequency())
+        return EVENT_FOREVER;
+    return timer_ticks() + timer_us_to_ticks(usec);
+}
+
+bool event_expired(u64 deadline) {
+    return deadline != EVENT_FOREVER && timer_ticks() >= deadline;
+}
+
+bool event_wait(u64 deadline, bool (*done)(void *ctx), void *ctx) {
+    for (;;) {
+        u64 daif = irq_save();
+
+        if (done && done(ctx)) {
+            irq_restore(daif);
+            return true;
+        }
+        if (event_expired(deadline)) {
+            irq_restore(daif);
+            return false;
+        }
+
+        /*
+         * Only sleep when some interrupt is sure to wake us. Inside a
+         * handler (the GIC holds ours back until it returns), on a
+         * secondary (only the boot CPU takes interrupts), or with a
+         * deadline but no timer interrupt, spin instead.
+         */
+        bool sleep = irq_ready() && !irq_in_handler() && cpu_index() == 0 &&
+                     (timer_irq || deadline == EVENT_FOREVER);
+        if (sleep) {
+            if (timer_irq && deadline != EVENT_FOREVER)
+                timer_arm(deadline);
+            cpu_wfi();          /* wakes on a pending IRQ even while masked */
+        }
+        irq_restore(daif);      /* ...which is taken here */
+
+        if (!sleep)
+            cpu_relax();
+    }
+}
+
+/* =========================
+ *  udelay
+ * ========================= */
+
+void udelay(u32 usec) {
+    u64 deadline = event_deadline_us(usec);
+
+    if (deadline == EVENT_FOREVER)
+        return;                 /* no counter frequency: nothing to measure with */
+
+    if (usec < EVENT_SPIN_US || !timer_irq || irq_in_handler() || cpu_index() != 0) {
+        while (timer_ticks() < deadline)
+            cpu_relax();
+        return;
+    }
+    event_wait(deadline, NULL, NULL);
+}
@@ -0,0 +1,39 @@
+#ifndef EVENT_H
+#define EVENT_H
+
+#include <stdbool.h>
+
+#include "bootstd.h"
+
+/*
+ * OpenCore Mobile – waiting
+ *
+ * The loader's one way to wait for something: sleep in wfi until an
+ * interrupt (a key, a finished transfer, the UART) or a deadline on the
+ * generic timer, then re-check. A boot menu sitting on its countdown
+ * costs a timer interrupt a second, not a spinning core.
+ *
+ * Deadlines are absolute CNTVCT_EL0 values, so a periodic wait can step
+ * `deadline += period` without drifting. Before irq_init() (or with no
+ * GIC) the same calls degrade to polling the condition.
+ */
+
+#define EVENT_FOREVER           ((u64)-1)
+
+/* Take the virtual timer's interrupt; needs irq_init() first */
+void event_init(void);
+
+/* CNTVCT_EL0 value `usec` from now (EVENT_FOREVER without a counter frequency) */
+u64 event_deadline_us(u64 usec);
+
+bool event_expired(u64 deadline);
+
+/*
+ * Sleep until `done(ctx)` is true, returning true, or `deadline` passes,
+ * returning false. `done` runs with IRQs masked, so nothing it checks
+ * can change between the check and the wfi; it must not block. A NULL
+ * `done` just sleeps until the deadline.
+ */
+bool event_wait(u64 deadline, bool (*done)(void *ctx), void *ctx);
+
+#endif /* EVENT_H */
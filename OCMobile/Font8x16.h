@@ -0,0 +1,591 @@
+#ifndef FONT8X16_H
+#define FONT8X16_H
+
+#include "bootstd.h"
+
+/*
+ * Generated by Tools/mkfont.py from DejaVuSansMono.ttf; do not edit.
+ *
+ * Printable ASCII, 8x16 cells, 4-bit coverage, two pixels per byte
+ * (left one in the high nibble).
+ */
+
+#define FONT_FIRST      0x20
+#define FONT_LAST       0x7E
+#define FONT_WIDTH      8
+#define FONT_HEIGHT     16
+
+static const u8 font_8x16[FONT_LAST - FONT_FIRST + 1][FONT_HEIGHT * FONT_WIDTH / 2] = {
+    {   /* ' ' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '!' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x30, 0x00, 0x00, 0x0b, 0xb0, 0x00,
+        0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00,
+        0x00, 0x08, 0x80, 0x00, 0x00, 0x04, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0b, 0xb0, 0x00,
+        0x00, 0x08, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '"' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x31, 0x13, 0x00, 0x00, 0xb4, 0x4b, 0x00,
+        0x00, 0xb4, 0x4b, 0x00, 0x00, 0xb4, 0x4b, 0x00, 0x00, 0x62, 0x26, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '#' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0b, 0x51, 0xf0,
+        0x00, 0x0f, 0x15, 0xb0, 0x14, 0x7d, 0x49, 0x94, 0x3b, 0xdd, 0xbf, 0xcb, 0x00, 0xb5, 0x1f, 0x00,
+        0x00, 0xf1, 0x5b, 0x00, 0xff, 0xff, 0xff, 0xf4, 0x08, 0x80, 0xc4, 0x00, 0x0b, 0x51, 0xf0, 0x00,
+        0x0b, 0x13, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '$' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x60, 0x00, 0x00, 0x04, 0x80, 0x00,
+        0x03, 0xbe, 0xdf, 0x80, 0x0a, 0x84, 0x80, 0x40, 0x0b, 0x64, 0x80, 0x00, 0x08, 0xe9, 0x91, 0x00,
+        0x00, 0x6b, 0xff, 0x80, 0x00, 0x04, 0x83, 0xf3, 0x00, 0x04, 0x80, 0xf4, 0x09, 0x77, 0x98, 0xe1,
+        0x04, 0x8c, 0xd8, 0x20, 0x00, 0x04, 0x80, 0x00, 0x00, 0x03, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '%' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3a, 0xb6, 0x00, 0x00,
+        0xb6, 0x1c, 0x30, 0x00, 0xe0, 0x08, 0x40, 0x00, 0x8a, 0x8d, 0x11, 0x76, 0x05, 0x75, 0x9a, 0x50,
+        0x17, 0xb8, 0x48, 0x60, 0x45, 0x02, 0xd8, 0xa8, 0x00, 0x04, 0x80, 0x0e, 0x00, 0x03, 0xd4, 0x7a,
+        0x00, 0x00, 0x5b, 0x91, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '&' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x27, 0x73, 0x00, 0x03, 0xea, 0x9a, 0x00,
+        0x08, 0xb0, 0x00, 0x00, 0x07, 0xc0, 0x00, 0x00, 0x02, 0xf7, 0x00, 0x00, 0x1c, 0x9e, 0x30, 0x14,
+        0x8a, 0x08, 0xc1, 0x4e, 0xb8, 0x00, 0xb9, 0x4b, 0xa9, 0x00, 0x2e, 0xd6, 0x4f, 0x71, 0x3b, 0xf3,
+        0x05, 0xcf, 0xd8, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '\'' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x20, 0x00, 0x00, 0x08, 0x80, 0x00,
+        0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x04, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '(' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x58, 0x00, 0x00, 0x01, 0xe3, 0x00,
+        0x00, 0x07, 0xc0, 0x00, 0x00, 0x0c, 0x70, 0x00, 0x00, 0x1f, 0x40, 0x00, 0x00, 0x4f, 0x00, 0x00,
+        0x00, 0x4f, 0x00, 0x00, 0x00, 0x4f, 0x10, 0x00, 0x00, 0x0f, 0x40, 0x00, 0x00, 0x0c, 0x70, 0x00,
+        0x00, 0x06, 0xc0, 0x00, 0x00, 0x00, 0xd4, 0x00, 0x00, 0x00, 0x45, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* ')' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x85, 0x00, 0x00, 0x00, 0x3e, 0x10, 0x00,
+        0x00, 0x0c, 0x70, 0x00, 0x00, 0x07, 0xc0, 0x00, 0x00, 0x04, 0xf1, 0x00, 0x00, 0x00, 0xf4, 0x00,
+        0x00, 0x00, 0xf4, 0x00, 0x00, 0x01, 0xf4, 0x00, 0x00, 0x04, 0xf0, 0x00, 0x00, 0x07, 0xc0, 0x00,
+        0x00, 0x0c, 0x60, 0x00, 0x00, 0x4d, 0x00, 0x00, 0x00, 0x54, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '*' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x40, 0x00, 0x01, 0x08, 0x80, 0x10,
+        0x09, 0x88, 0x88, 0x90, 0x00, 0x4e, 0xe4, 0x00, 0x04, 0xcb, 0xbc, 0x40, 0x07, 0x18, 0x81, 0x70,
+        0x00, 0x06, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '+' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00,
+        0x8f, 0xff, 0xff, 0xf8, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* ',' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x40, 0x00, 0x00, 0x0b, 0xf0, 0x00,
+        0x00, 0x0d, 0xb0, 0x00, 0x00, 0x2f, 0x40, 0x00, 0x00, 0x49, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '-' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x68, 0x86, 0x00, 0x00, 0x68, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '.' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x30, 0x00, 0x00, 0x0b, 0xb0, 0x00,
+        0x00, 0x08, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '/' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x40, 0x00, 0x00, 0x08, 0xb0,
+        0x00, 0x00, 0x1e, 0x40, 0x00, 0x00, 0x8c, 0x00, 0x00, 0x00, 0xd6, 0x00, 0x00, 0x06, 0xd0, 0x00,
+        0x00, 0x0d, 0x60, 0x00, 0x00, 0x6e, 0x00, 0x00, 0x00, 0xc8, 0x00, 0x00, 0x04, 0xe1, 0x00, 0x00,
+        0x0b, 0x80, 0x00, 0x00, 0x4f, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '0' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x27, 0x72, 0x00, 0x03, 0xec, 0xce, 0x30,
+        0x0a, 0xa0, 0x0a, 0xa0, 0x0f, 0x50, 0x05, 0xf0, 0x4f, 0x41, 0x14, 0xf4, 0x4f, 0x1d, 0xd1, 0xf4,
+        0x4f, 0x36, 0x53, 0xf4, 0x2f, 0x40, 0x04, 0xf2, 0x0e, 0x70, 0x07, 0xd0, 0x08, 0xe5, 0x5e, 0x80,
+        0x00, 0x8e, 0xe8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '1' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x40, 0x00, 0x06, 0xff, 0xf0, 0x00,
+        0x04, 0x44, 0xf0, 0x00, 0x00, 0x04, 0xf0, 0x00, 0x00, 0x04, 0xf0, 0x00, 0x00, 0x04, 0xf0, 0x00,
+        0x00, 0x04, 0xf0, 0x00, 0x00, 0x04, 0xf0, 0x00, 0x00, 0x04, 0xf0, 0x00, 0x02, 0x89, 0xf8, 0x82,
+        0x03, 0xbb, 0xbb, 0xb3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '2' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x58, 0x61, 0x00, 0x0e, 0xdb, 0xde, 0x30,
+        0x04, 0x00, 0x0b, 0xa0, 0x00, 0x00, 0x08, 0xe0, 0x00, 0x00, 0x0b, 0xa0, 0x00, 0x00, 0x6e, 0x20,
+        0x00, 0x03, 0xe5, 0x00, 0x00, 0x3e, 0x60, 0x00, 0x03, 0xe6, 0x00, 0x00, 0x0e, 0xc8, 0x88, 0x80,
+        0x0b, 0xbb, 0xbb, 0xb0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '3' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x58, 0x61, 0x00, 0x0f, 0xcb, 0xce, 0x30,
+        0x02, 0x00, 0x0a, 0xb0, 0x00, 0x00, 0x08, 0xb0, 0x00, 0x24, 0x5e, 0x80, 0x00, 0x8f, 0xfa, 0x00,
+        0x00, 0x00, 0x2c, 0xa0, 0x00, 0x00, 0x04, 0xf0, 0x00, 0x00, 0x05, 0xf0, 0x38, 0x44, 0x6e, 0xb0,
+        0x2a, 0xdf, 0xd9, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '4' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x24, 0x10, 0x00, 0x01, 0xdf, 0x40,
+        0x00, 0x08, 0xbf, 0x40, 0x00, 0x3d, 0x4f, 0x40, 0x00, 0xc4, 0x4f, 0x40, 0x07, 0xa0, 0x4f, 0x40,
+        0x2d, 0x20, 0x4f, 0x40, 0x8e, 0xbb, 0xcf, 0xc6, 0x24, 0x44, 0x7f, 0x72, 0x00, 0x00, 0x4f, 0x40,
+        0x00, 0x00, 0x3b, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '5' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x44, 0x44, 0x10, 0x0b, 0xff, 0xff, 0x40,
+        0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0xdb, 0xb6, 0x00, 0x07, 0x54, 0x8f, 0x80,
+        0x00, 0x00, 0x08, 0xe0, 0x00, 0x00, 0x04, 0xf0, 0x00, 0x00, 0x08, 0xe0, 0x38, 0x44, 0x6e, 0x80,
+        0x2b, 0xef, 0xc8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '6' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x85, 0x10, 0x01, 0xce, 0xbc, 0x80,
+        0x09, 0xc1, 0x00, 0x10, 0x0f, 0x50, 0x00, 0x00, 0x3f, 0x3b, 0xb9, 0x10, 0x4f, 0xd5, 0x4c, 0xb0,
+        0x4f, 0x60, 0x04, 0xf2, 0x2f, 0x40, 0x00, 0xf4, 0x0e, 0x60, 0x03, 0xf3, 0x08, 0xd4, 0x2b, 0xc0,
+        0x00, 0x8e, 0xfa, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '7' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x14, 0x44, 0x44, 0x40, 0x4f, 0xff, 0xff, 0xf0,
+        0x00, 0x00, 0x09, 0x90, 0x00, 0x00, 0x1f, 0x50, 0x00, 0x00, 0x7d, 0x00, 0x00, 0x00, 0xd8, 0x00,
+        0x00, 0x03, 0xf2, 0x00, 0x00, 0x09, 0xb0, 0x00, 0x00, 0x1e, 0x60, 0x00, 0x00, 0x6e, 0x10, 0x00,
+        0x00, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '8' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x27, 0x72, 0x00, 0x06, 0xfa, 0xaf, 0x60,
+        0x0e, 0x80, 0x08, 0xe0, 0x0f, 0x50, 0x05, 0xf0, 0x08, 0xc2, 0x2c, 0x80, 0x01, 0xcf, 0xfc, 0x10,
+        0x0c, 0x91, 0x19, 0xc0, 0x4f, 0x20, 0x02, 0xf4, 0x4f, 0x30, 0x03, 0xf4, 0x0d, 0xb3, 0x3b, 0xd0,
+        0x03, 0xaf, 0xfa, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '9' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x38, 0x61, 0x00, 0x07, 0xea, 0xce, 0x30,
+        0x1f, 0x60, 0x0a, 0xa0, 0x4f, 0x10, 0x04, 0xf0, 0x4f, 0x10, 0x05, 0xf3, 0x1f, 0x70, 0x0a, 0xf4,
+        0x06, 0xfb, 0xc9, 0xf4, 0x00, 0x24, 0x33, 0xf0, 0x00, 0x00, 0x08, 0xc0, 0x04, 0x54, 0x8f, 0x50,
+        0x05, 0xdf, 0xc5, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* ':' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x60, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x08, 0x80, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x30, 0x00, 0x00, 0x0b, 0xb0, 0x00,
+        0x00, 0x08, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* ';' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x60, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x08, 0x80, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x40, 0x00, 0x00, 0x0b, 0xf0, 0x00,
+        0x00, 0x0d, 0xb0, 0x00, 0x00, 0x2f, 0x40, 0x00, 0x00, 0x49, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '<' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x86, 0x00, 0x05, 0xaf, 0xa3, 0x28, 0xdd, 0x72, 0x00,
+        0x8f, 0x80, 0x00, 0x00, 0x16, 0xce, 0x83, 0x00, 0x00, 0x03, 0x9e, 0xc4, 0x00, 0x00, 0x01, 0x66,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '=' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x48, 0x88, 0x88, 0x84, 0x6b, 0xbb, 0xbb, 0xb6,
+        0x00, 0x00, 0x00, 0x00, 0x6b, 0xbb, 0xbb, 0xb6, 0x48, 0x88, 0x88, 0x84, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '>' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x68, 0x20, 0x00, 0x00, 0x3a, 0xfa, 0x50, 0x00, 0x00, 0x27, 0xdd, 0x82,
+        0x00, 0x00, 0x08, 0xf8, 0x00, 0x38, 0xec, 0x61, 0x4c, 0xe9, 0x30, 0x00, 0x66, 0x10, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '?' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x27, 0x72, 0x00, 0x07, 0xeb, 0xcf, 0x50,
+        0x03, 0x10, 0x09, 0xb0, 0x00, 0x00, 0x09, 0xa0, 0x00, 0x00, 0x6e, 0x30, 0x00, 0x05, 0xe3, 0x00,
+        0x00, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0b, 0x80, 0x00,
+        0x00, 0x08, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '@' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x27, 0x88, 0x20,
+        0x06, 0xd8, 0x58, 0xe2, 0x2d, 0x30, 0x00, 0x89, 0x88, 0x03, 0xab, 0x8b, 0xc4, 0x1e, 0x74, 0xcb,
+        0xf0, 0x4b, 0x00, 0x4b, 0xf0, 0x4b, 0x00, 0x4b, 0xc3, 0x2e, 0x30, 0x9b, 0x98, 0x06, 0xde, 0x88,
+        0x2e, 0x30, 0x00, 0x00, 0x06, 0xe6, 0x11, 0x30, 0x00, 0x39, 0xce, 0x80, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'A' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x30, 0x00, 0x00, 0x1f, 0xf1, 0x00,
+        0x00, 0x6c, 0xd6, 0x00, 0x00, 0xa8, 0x8a, 0x00, 0x00, 0xe5, 0x5e, 0x00, 0x05, 0xf0, 0x0f, 0x50,
+        0x08, 0xa0, 0x0b, 0x80, 0x0d, 0xff, 0xff, 0xd0, 0x3f, 0x54, 0x45, 0xf3, 0x8d, 0x00, 0x00, 0xd8,
+        0x87, 0x00, 0x00, 0x78, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'B' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x44, 0x41, 0x00, 0x0f, 0xcb, 0xdf, 0x60,
+        0x0f, 0x40, 0x07, 0xf0, 0x0f, 0x40, 0x04, 0xf3, 0x0f, 0x74, 0x4a, 0xc0, 0x0f, 0xff, 0xfd, 0x40,
+        0x0f, 0x40, 0x07, 0xe2, 0x0f, 0x40, 0x00, 0xe8, 0x0f, 0x40, 0x00, 0xf8, 0x0f, 0x74, 0x6a, 0xe2,
+        0x0b, 0xbb, 0xb8, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'C' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x87, 0x20, 0x00, 0x9e, 0xbb, 0xf0,
+        0x08, 0xe1, 0x00, 0x20, 0x0d, 0x80, 0x00, 0x00, 0x2f, 0x40, 0x00, 0x00, 0x4f, 0x40, 0x00, 0x00,
+        0x4f, 0x40, 0x00, 0x00, 0x0f, 0x60, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x03, 0xf8, 0x44, 0x90,
+        0x00, 0x3a, 0xfe, 0x90, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'D' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x14, 0x44, 0x10, 0x00, 0x4f, 0xce, 0xf8, 0x00,
+        0x4f, 0x40, 0x3e, 0x80, 0x4f, 0x40, 0x07, 0xf0, 0x4f, 0x40, 0x04, 0xf4, 0x4f, 0x40, 0x04, 0xf4,
+        0x4f, 0x40, 0x04, 0xf4, 0x4f, 0x40, 0x05, 0xf2, 0x4f, 0x40, 0x0a, 0xd0, 0x4f, 0x77, 0xae, 0x30,
+        0x3b, 0xbb, 0x82, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'E' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x44, 0x44, 0x41, 0x0b, 0xff, 0xff, 0xf4,
+        0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0x94, 0x44, 0x40, 0x0b, 0xff, 0xff, 0xf0,
+        0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0xb8, 0x88, 0x82,
+        0x08, 0xbb, 0xbb, 0xb3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'F' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x44, 0x44, 0x41, 0x08, 0xff, 0xff, 0xf4,
+        0x08, 0xb0, 0x00, 0x00, 0x08, 0xb0, 0x00, 0x00, 0x08, 0xc4, 0x44, 0x40, 0x08, 0xff, 0xff, 0xf0,
+        0x08, 0xb0, 0x00, 0x00, 0x08, 0xb0, 0x00, 0x00, 0x08, 0xb0, 0x00, 0x00, 0x08, 0xb0, 0x00, 0x00,
+        0x06, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'G' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x85, 0x10, 0x01, 0xcd, 0xbc, 0xe0,
+        0x0b, 0xb1, 0x00, 0x50, 0x2f, 0x50, 0x00, 0x00, 0x6f, 0x00, 0x00, 0x00, 0x8f, 0x00, 0x48, 0x82,
+        0x8f, 0x00, 0x6b, 0xf4, 0x4f, 0x20, 0x00, 0xf4, 0x1e, 0x60, 0x00, 0xf4, 0x07, 0xe6, 0x45, 0xf4,
+        0x00, 0x6c, 0xfd, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'H' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x14, 0x10, 0x01, 0x41, 0x4f, 0x40, 0x04, 0xf4,
+        0x4f, 0x40, 0x04, 0xf4, 0x4f, 0x40, 0x04, 0xf4, 0x4f, 0x74, 0x47, 0xf4, 0x4f, 0xff, 0xff, 0xf4,
+        0x4f, 0x40, 0x04, 0xf4, 0x4f, 0x40, 0x04, 0xf4, 0x4f, 0x40, 0x04, 0xf4, 0x4f, 0x40, 0x04, 0xf4,
+        0x3b, 0x30, 0x03, 0xb3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'I' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x44, 0x44, 0x30, 0x0b, 0xff, 0xff, 0xb0,
+        0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00,
+        0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x06, 0x8d, 0xd8, 0x60,
+        0x08, 0xbb, 0xbb, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'J' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x34, 0x44, 0x10, 0x00, 0xbf, 0xff, 0x40,
+        0x00, 0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40,
+        0x00, 0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x10, 0x00, 0x3f, 0x40, 0x89, 0x44, 0x9e, 0x00,
+        0x3a, 0xef, 0xc3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'K' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x14, 0x10, 0x00, 0x33, 0x4f, 0x40, 0x06, 0xf4,
+        0x4f, 0x40, 0x6f, 0x60, 0x4f, 0x44, 0xf6, 0x00, 0x4f, 0x7e, 0x60, 0x00, 0x4f, 0xfe, 0x80, 0x00,
+        0x4f, 0x75, 0xf3, 0x00, 0x4f, 0x40, 0xac, 0x10, 0x4f, 0x40, 0x1e, 0x80, 0x4f, 0x40, 0x06, 0xf4,
+        0x3b, 0x30, 0x00, 0x99, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'L' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x30, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00,
+        0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00,
+        0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xd8, 0x88, 0x84,
+        0x08, 0xbb, 0xbb, 0xb6, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'M' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x24, 0x10, 0x01, 0x42, 0x8f, 0x80, 0x08, 0xf8,
+        0x8d, 0xd0, 0x0d, 0xd8, 0x8b, 0xc3, 0x3c, 0xb8, 0x8b, 0x78, 0x86, 0xb8, 0x8b, 0x2d, 0xd1, 0xb8,
+        0x8b, 0x0c, 0xa0, 0xb8, 0x8b, 0x02, 0x20, 0xb8, 0x8b, 0x00, 0x00, 0xb8, 0x8b, 0x00, 0x00, 0xb8,
+        0x68, 0x00, 0x00, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'N' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x14, 0x20, 0x00, 0x41, 0x4f, 0xd0, 0x00, 0xf4,
+        0x4f, 0xd4, 0x00, 0xf4, 0x4f, 0x89, 0x00, 0xf4, 0x4f, 0x2f, 0x10, 0xf4, 0x4f, 0x09, 0x70, 0xf4,
+        0x4f, 0x04, 0xd0, 0xf4, 0x4f, 0x00, 0xd5, 0xf4, 0x4f, 0x00, 0x7a, 0xf4, 0x4f, 0x00, 0x1f, 0xf4,
+        0x3b, 0x00, 0x08, 0xb3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'O' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x27, 0x72, 0x00, 0x04, 0xec, 0xce, 0x40,
+        0x0d, 0x90, 0x09, 0xd0, 0x2f, 0x40, 0x04, 0xf2, 0x4f, 0x10, 0x01, 0xf4, 0x4f, 0x00, 0x00, 0xf4,
+        0x4f, 0x00, 0x00, 0xf4, 0x4f, 0x30, 0x03, 0xf4, 0x1f, 0x60, 0x06, 0xf0, 0x09, 0xd5, 0x5d, 0x80,
+        0x01, 0x9e, 0xe8, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'P' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x44, 0x41, 0x00, 0x0b, 0xdb, 0xdf, 0x80,
+        0x0b, 0x80, 0x06, 0xf5, 0x0b, 0x80, 0x00, 0xf8, 0x0b, 0x80, 0x01, 0xf7, 0x0b, 0xb8, 0x8c, 0xe2,
+        0x0b, 0xdb, 0xb8, 0x20, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00,
+        0x08, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'Q' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x27, 0x72, 0x00, 0x04, 0xec, 0xce, 0x40,
+        0x0d, 0x90, 0x09, 0xd0, 0x2f, 0x40, 0x04, 0xf2, 0x4f, 0x10, 0x01, 0xf4, 0x4f, 0x00, 0x00, 0xf4,
+        0x4f, 0x00, 0x00, 0xf4, 0x4f, 0x30, 0x03, 0xf4, 0x0f, 0x60, 0x06, 0xf1, 0x08, 0xd5, 0x5d, 0x90,
+        0x01, 0x8e, 0xfc, 0x10, 0x00, 0x00, 0x3e, 0x60, 0x00, 0x00, 0x03, 0x20, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'R' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x14, 0x44, 0x30, 0x00, 0x4f, 0xcb, 0xfd, 0x30,
+        0x4f, 0x40, 0x1b, 0xd0, 0x4f, 0x40, 0x08, 0xf0, 0x4f, 0x40, 0x08, 0xd0, 0x4f, 0x98, 0xad, 0x30,
+        0x4f, 0x98, 0xcb, 0x10, 0x4f, 0x40, 0x1d, 0x80, 0x4f, 0x40, 0x06, 0xe1, 0x4f, 0x40, 0x00, 0xd8,
+        0x3b, 0x30, 0x00, 0x6a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'S' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x27, 0x84, 0x00, 0x06, 0xfb, 0xbd, 0xb0,
+        0x1f, 0x60, 0x00, 0x40, 0x4f, 0x10, 0x00, 0x00, 0x1e, 0xa3, 0x00, 0x00, 0x05, 0xdf, 0xe9, 0x10,
+        0x00, 0x03, 0x7d, 0xc0, 0x00, 0x00, 0x02, 0xf4, 0x00, 0x00, 0x02, 0xf4, 0x0b, 0x64, 0x4a, 0xd0,
+        0x08, 0xcf, 0xea, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'T' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x34, 0x44, 0x44, 0x43, 0xbf, 0xff, 0xff, 0xfb,
+        0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00,
+        0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00,
+        0x00, 0x08, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'U' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x14, 0x10, 0x01, 0x41, 0x4f, 0x40, 0x04, 0xf4,
+        0x4f, 0x40, 0x04, 0xf4, 0x4f, 0x40, 0x04, 0xf4, 0x4f, 0x40, 0x04, 0xf4, 0x4f, 0x40, 0x04, 0xf4,
+        0x4f, 0x40, 0x04, 0xf4, 0x4f, 0x40, 0x04, 0xf3, 0x0f, 0x40, 0x04, 0xf0, 0x0b, 0xc4, 0x4c, 0xb0,
+        0x01, 0x9e, 0xe9, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'V' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x33, 0x00, 0x00, 0x33, 0x8d, 0x00, 0x00, 0xd8,
+        0x4f, 0x20, 0x02, 0xf4, 0x0e, 0x60, 0x06, 0xe0, 0x09, 0x90, 0x09, 0x90, 0x06, 0xd0, 0x0e, 0x60,
+        0x01, 0xf3, 0x3f, 0x10, 0x00, 0xc7, 0x7c, 0x00, 0x00, 0x7a, 0xa7, 0x00, 0x00, 0x3e, 0xe3, 0x00,
+        0x00, 0x0a, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'W' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x41, 0x00, 0x00, 0x14, 0xf4, 0x00, 0x00, 0x4f,
+        0xd7, 0x00, 0x00, 0x7d, 0xb8, 0x06, 0x60, 0x8b, 0x89, 0x0e, 0xe0, 0x98, 0x7b, 0x2c, 0xc2, 0xb7,
+        0x4d, 0x69, 0x95, 0xd4, 0x2f, 0x86, 0x68, 0xf2, 0x0f, 0xc3, 0x3c, 0xf0, 0x0c, 0xe0, 0x0e, 0xc0,
+        0x08, 0x80, 0x08, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'X' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x24, 0x00, 0x00, 0x33, 0x2e, 0x50, 0x02, 0xf5,
+        0x08, 0xd1, 0x0b, 0xa0, 0x00, 0xd8, 0x4e, 0x10, 0x00, 0x4e, 0xd7, 0x00, 0x00, 0x0c, 0xe0, 0x00,
+        0x00, 0x5e, 0xd7, 0x00, 0x01, 0xe7, 0x4e, 0x10, 0x08, 0xc0, 0x0b, 0x90, 0x4f, 0x40, 0x03, 0xf4,
+        0x88, 0x00, 0x00, 0x89, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'Y' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x33, 0x00, 0x00, 0x33, 0x8e, 0x10, 0x01, 0xe7,
+        0x0d, 0x80, 0x08, 0xd0, 0x04, 0xe2, 0x2f, 0x40, 0x00, 0xb9, 0x9b, 0x00, 0x00, 0x2f, 0xf2, 0x00,
+        0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00, 0x00, 0x0b, 0xb0, 0x00,
+        0x00, 0x08, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'Z' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x44, 0x44, 0x42, 0x0f, 0xff, 0xff, 0xf8,
+        0x00, 0x00, 0x07, 0xe2, 0x00, 0x00, 0x2e, 0x70, 0x00, 0x00, 0xab, 0x00, 0x00, 0x05, 0xe2, 0x00,
+        0x00, 0x1e, 0x70, 0x00, 0x00, 0xab, 0x00, 0x00, 0x05, 0xe2, 0x00, 0x00, 0x0d, 0xc8, 0x88, 0x86,
+        0x0b, 0xbb, 0xbb, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '[' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0b, 0xb8, 0x00, 0x00, 0x0f, 0x73, 0x00,
+        0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x00,
+        0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x00,
+        0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x96, 0x00, 0x00, 0x08, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '\\' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00, 0x2f, 0x30, 0x00, 0x00,
+        0x09, 0x90, 0x00, 0x00, 0x02, 0xf2, 0x00, 0x00, 0x00, 0xa9, 0x00, 0x00, 0x00, 0x4f, 0x10, 0x00,
+        0x00, 0x0b, 0x80, 0x00, 0x00, 0x04, 0xe1, 0x00, 0x00, 0x00, 0xd8, 0x00, 0x00, 0x00, 0x6d, 0x00,
+        0x00, 0x00, 0x0d, 0x60, 0x00, 0x00, 0x06, 0xd0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* ']' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x8b, 0xb0, 0x00, 0x00, 0x37, 0xf0, 0x00,
+        0x00, 0x04, 0xf0, 0x00, 0x00, 0x04, 0xf0, 0x00, 0x00, 0x04, 0xf0, 0x00, 0x00, 0x04, 0xf0, 0x00,
+        0x00, 0x04, 0xf0, 0x00, 0x00, 0x04, 0xf0, 0x00, 0x00, 0x04, 0xf0, 0x00, 0x00, 0x04, 0xf0, 0x00,
+        0x00, 0x04, 0xf0, 0x00, 0x00, 0x69, 0xf0, 0x00, 0x00, 0x68, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '^' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x30, 0x00, 0x00, 0x3f, 0xf3, 0x00,
+        0x02, 0xe6, 0x6e, 0x20, 0x1c, 0x60, 0x06, 0xc1, 0x36, 0x00, 0x00, 0x63, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '_' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x88, 0x88, 0x88, 0x88,
+    },
+    {   /* '`' */
+        0x00, 0x00, 0x00, 0x00, 0x01, 0x41, 0x00, 0x00, 0x00, 0x99, 0x00, 0x00, 0x00, 0x0b, 0x60, 0x00,
+        0x00, 0x01, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'a' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x06, 0xbf, 0xe9, 0x10, 0x08, 0x52, 0x3b, 0xa0, 0x00, 0x00, 0x04, 0xf0,
+        0x04, 0xcf, 0xff, 0xf0, 0x1e, 0x70, 0x04, 0xf0, 0x4f, 0x00, 0x08, 0xf0, 0x2f, 0x70, 0x5d, 0xf0,
+        0x05, 0xdf, 0xa5, 0xb0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'b' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x60, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00,
+        0x0b, 0x80, 0x00, 0x00, 0x0b, 0xab, 0xfa, 0x10, 0x0b, 0xe5, 0x2a, 0xb0, 0x0b, 0x80, 0x02, 0xf3,
+        0x0b, 0x80, 0x00, 0xf4, 0x0b, 0x80, 0x00, 0xf4, 0x0b, 0x80, 0x02, 0xf3, 0x0b, 0xe5, 0x2a, 0xb0,
+        0x08, 0x8b, 0xfa, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'c' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x3a, 0xfd, 0x90, 0x03, 0xe8, 0x23, 0x80, 0x09, 0xb0, 0x00, 0x00,
+        0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x09, 0xb0, 0x00, 0x00, 0x03, 0xe8, 0x23, 0x80,
+        0x00, 0x3a, 0xfe, 0x90, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'd' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x80, 0x00, 0x00, 0x08, 0xb0,
+        0x00, 0x00, 0x08, 0xb0, 0x01, 0xaf, 0xba, 0xb0, 0x0b, 0xb2, 0x5e, 0xb0, 0x2f, 0x30, 0x08, 0xb0,
+        0x4f, 0x00, 0x08, 0xb0, 0x4f, 0x00, 0x08, 0xb0, 0x2f, 0x30, 0x08, 0xb0, 0x0b, 0xa2, 0x4e, 0xb0,
+        0x01, 0xaf, 0xb8, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'e' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x8d, 0xfa, 0x10, 0x08, 0xc4, 0x29, 0xc0, 0x2f, 0x40, 0x01, 0xf3,
+        0x4f, 0xbb, 0xbb, 0xf4, 0x4f, 0x44, 0x44, 0x41, 0x2f, 0x20, 0x00, 0x00, 0x08, 0xc5, 0x04, 0x90,
+        0x00, 0x8d, 0xfc, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'f' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x8b, 0xb0, 0x00, 0x09, 0xc5, 0x40,
+        0x00, 0x0b, 0x80, 0x00, 0x08, 0xbe, 0xdb, 0xb0, 0x03, 0x4c, 0x94, 0x40, 0x00, 0x0b, 0x80, 0x00,
+        0x00, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00,
+        0x00, 0x08, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'g' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x01, 0xaf, 0xb8, 0x80, 0x0b, 0xc2, 0x5e, 0xb0, 0x2f, 0x30, 0x08, 0xb0,
+        0x4f, 0x00, 0x08, 0xb0, 0x4f, 0x00, 0x08, 0xb0, 0x2f, 0x30, 0x09, 0xb0, 0x0a, 0xc4, 0x6f, 0xb0,
+        0x01, 0x9b, 0x98, 0xb0, 0x00, 0x00, 0x08, 0xa0, 0x06, 0x84, 0x6e, 0x50, 0x03, 0x8b, 0x94, 0x00,
+    },
+    {   /* 'h' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x60, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00,
+        0x0b, 0x80, 0x00, 0x00, 0x0b, 0x8a, 0xfb, 0x30, 0x0b, 0xe5, 0x4c, 0xa0, 0x0b, 0x80, 0x06, 0xe0,
+        0x0b, 0x80, 0x04, 0xf0, 0x0b, 0x80, 0x04, 0xf0, 0x0b, 0x80, 0x04, 0xf0, 0x0b, 0x80, 0x04, 0xf0,
+        0x08, 0x60, 0x03, 0xb0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'i' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x80, 0x00, 0x00, 0x08, 0xb0, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x06, 0xbb, 0x80, 0x00, 0x02, 0x49, 0xb0, 0x00, 0x00, 0x08, 0xb0, 0x00,
+        0x00, 0x08, 0xb0, 0x00, 0x00, 0x08, 0xb0, 0x00, 0x00, 0x08, 0xb0, 0x00, 0x04, 0x49, 0xc4, 0x41,
+        0x0b, 0xbb, 0xbb, 0xb3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'j' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xb0, 0x00, 0x00, 0x00, 0xf0, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x03, 0xbb, 0xb0, 0x00, 0x01, 0x44, 0xf0, 0x00, 0x00, 0x00, 0xf0, 0x00,
+        0x00, 0x00, 0xf0, 0x00, 0x00, 0x00, 0xf0, 0x00, 0x00, 0x00, 0xf0, 0x00, 0x00, 0x00, 0xf0, 0x00,
+        0x00, 0x00, 0xf0, 0x00, 0x00, 0x03, 0xf0, 0x00, 0x08, 0x8c, 0xb0, 0x00, 0x08, 0x88, 0x10, 0x00,
+    },
+    {   /* 'k' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x80, 0x00, 0x00, 0x08, 0xb0, 0x00, 0x00,
+        0x08, 0xb0, 0x00, 0x00, 0x08, 0xb0, 0x06, 0xa1, 0x08, 0xb0, 0x6e, 0x30, 0x08, 0xb6, 0xe3, 0x00,
+        0x08, 0xef, 0xc0, 0x00, 0x08, 0xd3, 0xd8, 0x00, 0x08, 0xb0, 0x3f, 0x40, 0x08, 0xb0, 0x08, 0xe1,
+        0x06, 0x80, 0x00, 0x98, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'l' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0b, 0xbb, 0x30, 0x00, 0x04, 0x4f, 0x40, 0x00,
+        0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x00,
+        0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x00, 0x00, 0x0f, 0x40, 0x00, 0x00, 0x0b, 0xa4, 0x30,
+        0x00, 0x02, 0x9b, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'm' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x69, 0xcd, 0x6e, 0xb1, 0x8d, 0x2b, 0xc2, 0xd5, 0x8b, 0x08, 0x90, 0xb8,
+        0x8b, 0x08, 0x80, 0xb8, 0x8b, 0x08, 0x80, 0xb8, 0x8b, 0x08, 0x80, 0xb8, 0x8b, 0x08, 0x80, 0xb8,
+        0x68, 0x06, 0x60, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'n' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x08, 0x7a, 0xfb, 0x30, 0x0b, 0xe5, 0x4c, 0xa0, 0x0b, 0x80, 0x06, 0xe0,
+        0x0b, 0x80, 0x04, 0xf0, 0x0b, 0x80, 0x04, 0xf0, 0x0b, 0x80, 0x04, 0xf0, 0x0b, 0x80, 0x04, 0xf0,
+        0x08, 0x60, 0x03, 0xb0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'o' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x01, 0x9e, 0xe9, 0x10, 0x09, 0xc3, 0x3c, 0x90, 0x1f, 0x50, 0x05, 0xf1,
+        0x4f, 0x10, 0x01, 0xf4, 0x4f, 0x10, 0x01, 0xf4, 0x1f, 0x50, 0x05, 0xf1, 0x09, 0xc3, 0x3c, 0x90,
+        0x01, 0x9e, 0xe9, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'p' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x08, 0x8b, 0xfa, 0x10, 0x0b, 0xe5, 0x2b, 0xb0, 0x0b, 0x80, 0x03, 0xf2,
+        0x0b, 0x80, 0x00, 0xf4, 0x0b, 0x80, 0x00, 0xf4, 0x0b, 0x80, 0x03, 0xf2, 0x0b, 0xe4, 0x2a, 0xb0,
+        0x0b, 0xab, 0xfa, 0x10, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x06, 0x40, 0x00, 0x00,
+    },
+    {   /* 'q' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x01, 0x9e, 0xb6, 0xb0, 0x09, 0xc4, 0x5e, 0xf0, 0x0f, 0x50, 0x08, 0xf0,
+        0x4f, 0x10, 0x04, 0xf0, 0x4f, 0x10, 0x04, 0xf0, 0x1f, 0x50, 0x08, 0xf0, 0x0b, 0xc2, 0x4e, 0xf0,
+        0x01, 0xaf, 0xd7, 0xf0, 0x00, 0x00, 0x04, 0xf0, 0x00, 0x00, 0x04, 0xf0, 0x00, 0x00, 0x03, 0xb0,
+    },
+    {   /* 'r' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x86, 0x8e, 0xe5, 0x00, 0xbd, 0xa4, 0x44, 0x00, 0xbc, 0x00, 0x00,
+        0x00, 0xb8, 0x00, 0x00, 0x00, 0xb8, 0x00, 0x00, 0x00, 0xb8, 0x00, 0x00, 0x00, 0xb8, 0x00, 0x00,
+        0x00, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 's' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x01, 0x9e, 0xfb, 0x40, 0x08, 0xc3, 0x15, 0x50, 0x0a, 0x90, 0x00, 0x00,
+        0x05, 0xfc, 0x85, 0x00, 0x00, 0x26, 0x9f, 0x80, 0x00, 0x00, 0x08, 0xb0, 0x08, 0x51, 0x3c, 0x90,
+        0x07, 0xcf, 0xe9, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 't' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4f, 0x00, 0x00,
+        0x00, 0x4f, 0x00, 0x00, 0x3b, 0xcf, 0xbb, 0x80, 0x14, 0x7f, 0x44, 0x30, 0x00, 0x4f, 0x00, 0x00,
+        0x00, 0x4f, 0x00, 0x00, 0x00, 0x4f, 0x00, 0x00, 0x00, 0x4f, 0x00, 0x00, 0x00, 0x2f, 0x74, 0x30,
+        0x00, 0x05, 0xbb, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'u' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x08, 0x60, 0x03, 0xb0, 0x0b, 0x80, 0x04, 0xf0, 0x0b, 0x80, 0x04, 0xf0,
+        0x0b, 0x80, 0x04, 0xf0, 0x0b, 0x80, 0x04, 0xf0, 0x0b, 0x80, 0x07, 0xf0, 0x09, 0xc3, 0x5d, 0xf0,
+        0x01, 0xbf, 0xb4, 0xb0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'v' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x4a, 0x00, 0x00, 0xa4, 0x1f, 0x40, 0x04, 0xf1, 0x09, 0x90, 0x09, 0x90,
+        0x05, 0xe0, 0x0e, 0x50, 0x00, 0xe5, 0x5e, 0x00, 0x00, 0x99, 0x99, 0x00, 0x00, 0x4e, 0xe4, 0x00,
+        0x00, 0x0a, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'w' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0xb2, 0x00, 0x00, 0x2b, 0xc6, 0x00, 0x00, 0x6c, 0x98, 0x05, 0x50, 0x89,
+        0x6b, 0x0c, 0xc0, 0xb6, 0x2f, 0x2b, 0xb2, 0xf2, 0x0e, 0x97, 0x79, 0xe0, 0x0a, 0xe3, 0x3e, 0xa0,
+        0x06, 0xa0, 0x0a, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'x' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x1b, 0x30, 0x03, 0xb1, 0x07, 0xd1, 0x1d, 0x70, 0x00, 0xaa, 0xaa, 0x00,
+        0x00, 0x1d, 0xd1, 0x00, 0x00, 0x3f, 0xf3, 0x00, 0x01, 0xd7, 0x7d, 0x10, 0x0a, 0xb0, 0x0b, 0xa0,
+        0x4b, 0x10, 0x01, 0xb4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* 'y' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x4b, 0x00, 0x00, 0x95, 0x0e, 0x60, 0x03, 0xf2, 0x08, 0xa0, 0x08, 0xa0,
+        0x02, 0xf2, 0x0e, 0x60, 0x00, 0xb8, 0x5e, 0x00, 0x00, 0x6d, 0x98, 0x00, 0x00, 0x1e, 0xf3, 0x00,
+        0x00, 0x09, 0xc0, 0x00, 0x00, 0x0d, 0x60, 0x00, 0x08, 0xae, 0x10, 0x00, 0x08, 0x83, 0x00, 0x00,
+    },
+    {   /* 'z' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x06, 0xbb, 0xbb, 0x80, 0x02, 0x44, 0x4c, 0xa0, 0x00, 0x00, 0x8d, 0x10,
+        0x00, 0x05, 0xe3, 0x00, 0x00, 0x3e, 0x60, 0x00, 0x01, 0xc8, 0x00, 0x00, 0x09, 0xd4, 0x44, 0x30,
+        0x08, 0xbb, 0xbb, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '{' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7a, 0x80, 0x00, 0x07, 0xe5, 0x30,
+        0x00, 0x08, 0xb0, 0x00, 0x00, 0x08, 0xb0, 0x00, 0x00, 0x08, 0xb0, 0x00, 0x00, 0x0c, 0x80, 0x00,
+        0x08, 0xed, 0x10, 0x00, 0x03, 0x4d, 0x70, 0x00, 0x00, 0x08, 0xb0, 0x00, 0x00, 0x08, 0xb0, 0x00,
+        0x00, 0x08, 0xb0, 0x00, 0x00, 0x08, 0xc1, 0x00, 0x00, 0x02, 0xbf, 0xb0, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '|' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x60, 0x00, 0x00, 0x08, 0x80, 0x00,
+        0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00,
+        0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00,
+        0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00, 0x00, 0x08, 0x80, 0x00,
+    },
+    {   /* '}' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0xa7, 0x00, 0x00, 0x03, 0x5e, 0x60, 0x00,
+        0x00, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x08, 0xb0, 0x00,
+        0x00, 0x01, 0xde, 0x80, 0x00, 0x07, 0xd4, 0x30, 0x00, 0x0b, 0x80, 0x00, 0x00, 0x0b, 0x80, 0x00,
+        0x00, 0x0b, 0x80, 0x00, 0x00, 0x1d, 0x80, 0x00, 0x0b, 0xfb, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+    {   /* '~' */
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x85, 0x00, 0x02,
+        0x7c, 0xbd, 0xdb, 0xc7, 0x20, 0x00, 0x38, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    },
+};
+
+#endif /* FONT8X16_H */
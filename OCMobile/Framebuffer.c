@@ -0,0 +1,725 @@
+#include <stdbool.h>
+
+#include "bootstd.h"
+#include "Framebuffer.h"
+#include "Font8x16.h"
+#include "arch/aarch64/io.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/*
+ * OpenCore Mobile – framebuffer
+ *
+ * See Framebuffer.h. Row kernels (fill, 565 conversion, src-over) are
+ * NEON with a scalar tail; plain row copies go through memcpy(), which
+ * is already NEON and alignment-aware (String.c). Stores are never wider
+ * than a pixel's alignment, so drawing is safe before the MMU is on.
+ *
+ * src-over on premultiplied pixels, per channel:
+ *
+ *     out = src + dst * (255 - src_alpha) / 255
+ *
+ * with the division done exactly as (t + ((t + 128) >> 8) + 128) >> 8.
+ */
+
+#define MAX_SCALE               8
+
+/* inverse video doubles the atlas */
+#define ATLAS_SETS              2
+#define GLYPHS                  (FONT_LAST - FONT_FIRST + 1)
+
+struct fb_state {
+    u8 *draw;                   /* shadow, or the scanout itself */
+    bool shadowed;
+    u32 bytespp;
+
+    fb_rect_t dirty[FB_MAX_DIRTY];
+    u32 dirty_count;
+
+    /* glyph atlas: [set][glyph][cell_h][cell_w] in panel format */
+    u8 *atlas;
+    u32 cell_w;
+    u32 cell_h;
+    size_t glyph_bytes;
+    u32 fg;
+    u32 bg;
+
+    /* text console */
+    u32 cols;
+    u32 rows;
+    u32 col;
+    u32 row;
+    bool inverse;
+    u8 esc;                     /* ESC_* */
+    u32 esc_args[2];
+    u32 esc_nargs;
+};
+
+enum { ESC_NONE, ESC_SEEN, ESC_CSI };
+
+/* the console mirror callback has no context argument */
+static framebuffer_t *console_fb;
+
+/* =========================
+ *  Pixels
+ * ========================= */
+
+static inline u16 to_565(u32 c) {
+    return (u16)(((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F));
+}
+
+static inline u32 from_565(u16 p) {
+    u32 r = (p >> 11) & 0x1F, g = (p >> 5) & 0x3F, b = p & 0x1F;
+
+    return 0xFF000000u | ((r << 3 | r >> 2) << 16) | ((g << 2 | g >> 4) << 8) | (b << 3 | b >> 2);
+}
+
+static inline u32 div255(u32 t) {
+    return (t + ((t + 128) >> 8) + 128) >> 8;
+}
+
+static inline u32 over(u32 src, u32 dst) {
+    u32 ia = 255 - (src >> 24);
+    u32 out = 0;
+
+    for (unsigned shift = 0; shift < 32; shift += 8) {
+        u32 c = ((src >> shift) & 0xFF) + div255(((dst >> shift) & 0xFF) * ia);
+        out |= (c > 255 ? 255 : c) << shift;
+    }
+    return out;
+}
+
+/* (bg..fg) at coverage level/15, per channel */
+static u32 mix(u32 fg, u32 bg, u32 level) {
+    u32 out = 0xFF000000u;
+
+    for (unsigned shift = 0; shift < 24; shift += 8) {
+        u32 f = (fg >> shift) & 0xFF, b = (bg >> shift) & 0xFF;
+        out |= ((b * (15 - level) + f * level + 7) / 15) << shift;
+    }
+    return out;
+}
+
+static inline u8 *pixel_at(const framebuffer_t *fb, u8 *base, u32 x, u32 y) {
+    return base + (size_t)y * fb->pitch + (size_t)x * fb->state->bytespp;
+}
+
+/* =========================
+ *  Row kernels
+ * ========================= */
+
+#if defined(__aarch64__)
+static inline uint8x8_t div255_u8(uint16x8_t t) {
+    return vrshrn_n_u16(vrsraq_n_u16(t, t, 8), 8);
+}
+
+static inline void unpack_565(uint16x8_t p, uint8x8_t *r, uint8x8_t *g, uint8x8_t *b) {
+    *r = vand_u8(vshrn_n_u16(p, 8), vdup_n_u8(0xF8));
+    *g = vand_u8(vshrn_n_u16(p, 3), vdup_n_u8(0xFC));
+    *b = vmovn_u16(vshlq_n_u16(p, 3));
+    *r = vorr_u8(*r, vshr_n_u8(*r, 5));
+    *g = vorr_u8(*g, vshr_n_u8(*g, 6));
+    *b = vorr_u8(*b, vshr_n_u8(*b, 5));
+}
+
+static inline uint16x8_t pack_565(uint8x8_t r, uint8x8_t g, uint8x8_t b) {
+    uint16x8_t p = vshll_n_u8(r, 8);
+
+    p = vsriq_n_u16(p, vshll_n_u8(g, 8), 5);
+    return vsriq_n_u16(p, vshll_n_u8(b, 8), 11);
+}
+#endif
+
+static void fill_row32(u32 *d, u32 v, u32 n) {
+#if defined(__aarch64__)
+    uint32x4_t q = vdupq_n_u32(v);
+
+    for (; n >= 8; n -= 8, d += 8) {
+        vst1q_u32(d, q);
+        vst1q_u32(d + 4, q);
+    }
+#endif
+    while (n--)
+        *d++ = v;
+}
+
+static void fill_row16(u16 *d, u16 v, u32 n) {
+#if defined(__aarch64__)
+    uint16x8_t q = vdupq_n_u16(v);
+
+    for (; n >= 16; n -= 16, d += 16) {
+        vst1q_u16(d, q);
+        vst1q_u16(d + 8, q);
+    }
+#endif
+    while (n--)
+        *d++ = v;
+}
+
+static void convert_row16(u16 *d, const u32 *s, u32 n) {
+#if defined(__aarch64__)
+    for (; n >= 8; n -= 8, d += 8, s += 8) {
+        uint8x8x4_t src = vld4_u8((const u8 *)s);      /* b, g, r, a */
+        vst1q_u16(d, pack_565(src.val[2], src.val[1], src.val[0]));
+    }
+#endif
+    while (n--)
+        *d++ = to_565(*s++);
+}
+
+static void blend_row32(u32 *d, const u32 *s, u32 n) {
+#if defined(__aarch64__)
+    for (; n >= 8; n -= 8, d += 8, s += 8) {
+        uint8x8x4_t src = vld4_u8((const u8 *)s);
+        uint8x8x4_t dst = vld4_u8((const u8 *)d);
+        uint8x8_t ia = vmvn_u8(src.val[3]);
+
+        dst.val[0] = vqadd_u8(src.val[0], div255_u8(vmull_u8(dst.val[0], ia)));
+        dst.val[1] = vqadd_u8(src.val[1], div255_u8(vmull_u8(dst.val[1], ia)));
+        dst.val[2] = vqadd_u8(src.val[2], div255_u8(vmull_u8(dst.val[2], ia)));
+        dst.val[3] = vqadd_u8(src.val[3], div255_u8(vmull_u8(dst.val[3], ia)));
+        vst4_u8((u8 *)d, dst);
+    }
+#endif
+    for (; n; n--, d++, s++)
+        *d = over(*s, *d);
+}
+
+static void blend_row16(u16 *d, const u32 *s, u32 n) {
+#if defined(__aarch64__)
+    for (; n >= 8; n -= 8, d += 8, s += 8) {
+        uint8x8x4_t src = vld4_u8((const u8 *)s);
+        uint8x8_t ia = vmvn_u8(src.val[3]);
+        uint8x8_t r, g, b;
+
+        unpack_565(vld1q_u16(d), &r, &g, &b);
+        r = vqadd_u8(src.val[2], div255_u8(vmull_u8(r, ia)));
+        g = vqadd_u8(src.val[1], div255_u8(vmull_u8(g, ia)));
+        b = vqadd_u8(src.val[0], div255_u8(vmull_u8(b, ia)));
+        vst1q_u16(d, pack_565(r, g, b));
+    }
+#endif
+    for (; n; n--, d++, s++)
+        *d = to_565(over(*s, from_565(*d)));
+}
+
+/* =========================
+ *  Dirty rectangles
+ * ========================= */
+
+static inline u64 area(const fb_rect_t *r) {
+    return (u64)r->w * r->h;
+}
+
+static fb_rect_t rect_union(const fb_rect_t *a, const fb_rect_t *b) {
+    u32 x0 = a->x < b->x ? a->x : b->x;
+    u32 y0 = a->y < b->y ? a->y : b->y;
+    u32 x1 = a->x + a->w > b->x + b->w ? a->x + a->w : b->x + b->w;
+    u32 y1 = a->y + a->h > b->y + b->h ? a->y + a->h : b->y + b->h;
+
+    return (fb_rect_t){ x0, y0, x1 - x0, y1 - y0 };
+}
+
+static bool rect_overlaps(const fb_rect_t *a, const fb_rect_t *b) {
+    return a->x < b->x + b->w && b->x < a->x + a->w &&
+           a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+/*
+ * Rectangles that overlap, or whose union covers nothing extra (e.g. one
+ * menu row and the next), are folded together. When the list is full the
+ * new one goes into whichever entry grows the least.
+ */
+static void mark_dirty(struct fb_state *st, u32 x, u32 y, u32 w, u32 h) {
+    fb_rect_t r = { x, y, w, h };
+
+    for (u32 i = 0; i < st->dirty_count;) {
+        fb_rect_t u = rect_union(&r, &st->dirty[i]);
+
+        if (rect_overlaps(&r, &st->dirty[i]) || area(&u) <= area(&r) + area(&st->dirty[i])) {
+            r = u;
+            st->dirty[i] = st->dirty[--st->dirty_count];
+            i = 0;              /* the bigger rectangle may now reach others */
+            continue;
+        }
+        i++;
+    }
+
+    if (st->dirty_count < FB_MAX_DIRTY) {
+        st->dirty[st->dirty_count++] = r;
+        return;
+    }
+
+    u32 best = 0;
+    u64 best_growth = ~0ull;
+
+    for (u32 i = 0; i < st->dirty_count; i++) {
+        fb_rect_t u = rect_union(&r, &st->dirty[i]);
+        u64 growth = area(&u) - area(&st->dirty[i]);
+
+        if (growth < best_growth) {
+            best_growth = growth;
+            best = i;
+        }
+    }
+    st->dirty[best] = rect_union(&r, &st->dirty[best]);
+}
+
+/* Clip (x, y, w, h) to the panel; false if nothing is left */
+static bool clip(const framebuffer_t *fb, u32 x, u32 y, u32 *w, u32 *h) {
+    if (x >= fb->width || y >= fb->height || !*w || !*h)
+        return false;
+    if (*w > fb->width - x)
+        *w = fb->width - x;
+    if (*h > fb->height - y)
+        *h = fb->height - y;
+    return true;
+}
+
+/* =========================
+ *  Setup
+ * ========================= */
+
+int framebuffer_init(framebuffer_t *fb) {
+    if (!fb || !fb->base || !fb->width || !fb->height)
+        return -1;
+    if (fb->bpp != 32 && fb->bpp != 16)
+        return -1;
+
+    u32 bytespp = fb->bpp / 8;
+    if (fb->pitch < fb->width * bytespp || fb->pitch % bytespp)
+        return -1;
+
+    struct fb_state *st = boot_alloc(sizeof(*st));
+    if (!st)
+        return -1;
+    memset(st, 0, sizeof(*st));
+    st->bytespp = bytespp;
+
+    /* keep whatever the previous stage left on screen */
+    size_t size = (size_t)fb->pitch * fb->height;
+    st->draw = boot_alloc(size);
+    if (st->draw) {
+        memcpy(st->draw, fb->base, size);
+        st->shadowed = true;
+    } else {
+        st->draw = fb->base;
+    }
+
+    fb->state = st;
+    return 0;
+}
+
+/* =========================
+ *  Drawing
+ * ========================= */
+
+void fb_fill_rect(framebuffer_t *fb, u32 x, u32 y, u32 w, u32 h, u32 color) {
+    struct fb_state *st = fb->state;
+
+    if (!st || !clip(fb, x, y, &w, &h))
+        return;
+
+    u8 *row = pixel_at(fb, st->draw, x, y);
+    u16 c565 = to_565(color);
+
+    for (u32 i = 0; i < h; i++, row += fb->pitch) {
+        if (st->bytespp == 4)
+            fill_row32((u32 *)row, color, w);
+        else
+            fill_row16((u16 *)row, c565, w);
+    }
+
+    mark_dirty(st, x, y, w, h);
+}
+
+/* One row, overlap-safe; memcpy() itself makes no promise about overlap */
+static void move_row(u8 *d, const u8 *s, size_t n) {
+    u8 bounce[256];
+
+    if (d + n <= s || s + n <= d) {
+        memcpy(d, s, n);
+        return;
+    }
+
+    if (d < s) {
+        for (size_t off = 0; off < n; off += sizeof(bounce)) {
+            size_t k = n - off < sizeof(bounce) ? n - off : sizeof(bounce);
+            memcpy(bounce, s + off, k);
+            memcpy(d + off, bounce, k);
+        }
+    } else {
+        for (size_t end = n; end; ) {
+            size_t k = end < sizeof(bounce) ? end : sizeof(bounce);
+            end -= k;
+            memcpy(bounce, s + end, k);
+            memcpy(d + end, bounce, k);
+        }
+    }
+}
+
+void fb_copy_rect(framebuffer_t *fb, u32 dx, u32 dy, u32 sx, u32 sy, u32 w, u32 h) {
+    struct fb_state *st = fb->state;
+
+    if (!st || sx >= fb->width || sy >= fb->height)
+        return;
+
+    /* clip against both ends */
+    if (w > fb->width - sx)
+        w = fb->width - sx;
+    if (h > fb->height - sy)
+        h = fb->height - sy;
+    if (!clip(fb, dx, dy, &w, &h))
+        return;
+
+    size_t bytes = (size_t)w * st->bytespp;
+
+    if (dy <= sy) {
+        for (u32 i = 0; i < h; i++)
+            move_row(pixel_at(fb, st->draw, dx, dy + i), pixel_at(fb, st->draw, sx, sy + i), bytes);
+    } else {
+        for (u32 i = h; i--; )
+            move_row(pixel_at(fb, st->draw, dx, dy + i), pixel_at(fb, st->draw, sx, sy + i), bytes);
+    }
+
+    mark_dirty(st, dx, dy, w, h);
+}
+
+static void draw_image(framebuffer_t *fb, u32 x, u32 y, const fb_image_t *img, bool blend) {
+    struct fb_state *st = fb->state;
+    u32 w = img->width, h = img->height;
+
+    if (!st || !img->pixels || !clip(fb, x, y, &w, &h))
+        return;
+
+    u8 *row = pixel_at(fb, st->draw, x, y);
+    const u32 *src = img->pixels;
+
+    for (u32 i = 0; i < h; i++, row += fb->pitch, src += img->stride) {
+        if (st->bytespp == 4) {
+            if (blend)
+                blend_row32((u32 *)row, src, w);
+            else
+                memcpy(row, src, (size_t)w * 4);
+        } else {
+            if (blend)
+                blend_row16((u16 *)row, src, w);
+            else
+                convert_row16((u16 *)row, src, w);
+        }
+    }
+
+    mark_dirty(st, x, y, w, h);
+}
+
+void fb_blit(framebuffer_t *fb, u32 x, u32 y, const fb_image_t *img) {
+    draw_image(fb, x, y, img, false);
+}
+
+void fb_blend(framebuffer_t *fb, u32 x, u32 y, const fb_image_t *img) {
+    draw_image(fb, x, y, img, true);
+}
+
+void fb_blit_native(framebuffer_t *fb, u32 x, u32 y, const void *pixels,
+                    u32 w, u32 h, u32 stride) {
+    struct fb_state *st = fb->state;
+
+    if (!st || !pixels || !clip(fb, x, y, &w, &h))
+        return;
+
+    u8 *row = pixel_at(fb, st->draw, x, y);
+    const u8 *src = pixels;
+
+    for (u32 i = 0; i < h; i++, row += fb->pitch, src += stride)
+        memcpy(row, src, (size_t)w * st->bytespp);
+
+    mark_dirty(st, x, y, w, h);
+}
+
+void fb_present(framebuffer_t *fb) {
+    struct fb_state *st = fb->state;
+
+    if (!st)
+        return;
+
+    for (u32 i = 0; i < st->dirty_count; i++) {
+        const fb_rect_t *r = &st->dirty[i];
+        size_t bytes = (size_t)r->w * st->bytespp;
+
+        /* full-width runs are contiguous: one copy, one clean */
+        if (r->x == 0 && r->w == fb->width) {
+            bytes = (size_t)fb->pitch * r->h;
+            if (st->shadowed)
+                memcpy(pixel_at(fb, fb->base, 0, r->y), pixel_at(fb, st->draw, 0, r->y), bytes);
+            dcache_flush_range(pixel_at(fb, fb->base, 0, r->y), bytes);
+            continue;
+        }
+
+        for (u32 y = r->y; y < r->y + r->h; y++) {
+            u8 *out = pixel_at(fb, fb->base, r->x, y);
+
+            if (st->shadowed)
+                memcpy(out, pixel_at(fb, st->draw, r->x, y), bytes);
+            dcache_flush_range(out, bytes);
+        }
+    }
+
+    st->dirty_count = 0;
+}
+
+/* =========================
+ *  Glyph atlas
+ * ========================= */
+
+static void build_atlas(struct fb_state *st, u32 scale) {
+    u32 pitch = st->cell_w * st->bytespp;
+
+    for (u32 set = 0; set < ATLAS_SETS; set++) {
+        u32 fg = set ? st->bg : st->fg;
+        u32 bg = set ? st->fg : st->bg;
+        u32 levels[16];
+
+        for (u32 l = 0; l < 16; l++)
+            levels[l] = mix(fg, bg, l);
+
+        for (u32 g = 0; g < GLYPHS; g++) {
+            u8 *cell = st->atlas + (set * GLYPHS + g) * st->glyph_bytes;
+
+            for (u32 y = 0; y < st->cell_h; y++) {
+                const u8 *src = font_8x16[g] + (y / scale) * (FONT_WIDTH / 2);
+                u8 *row = cell + y * pitch;
+
+                for (u32 x = 0; x < st->cell_w; x++) {
+                    u32 fx = x / scale;
+                    u32 level = (src[fx / 2] >> (fx & 1 ? 0 : 4)) & 0xF;
+
+                    if (st->bytespp == 4)
+                        ((u32 *)row)[x] = levels[level];
+                    else
+                        ((u16 *)row)[x] = to_565(levels[level]);
+                }
+            }
+        }
+    }
+}
+
+int fb_text_init(framebuffer_t *fb, u32 scale, u32 fg, u32 bg) {
+    struct fb_state *st = fb->state;
+
+    if (!st)
+        return -1;
+
+    if (!scale) {
+        scale = fb->width / (80 * FONT_WIDTH);
+        if (!scale)
+            scale = 1;
+    }
+    if (scale > MAX_SCALE)
+        scale = MAX_SCALE;
+
+    /* same cell and colours: the atlas we have is fine */
+    if (st->atlas && st->cell_w == FONT_WIDTH * scale && st->fg == fg && st->bg == bg)
+        return 0;
+
+    /* same cell, other colours: rebuild in place; otherwise the old one goes back */
+    size_t glyph_bytes = (size_t)FONT_WIDTH * scale * FONT_HEIGHT * scale * st->bytespp;
+    u8 *atlas = st->atlas;
+
+    if (!atlas || st->glyph_bytes != glyph_bytes) {
+        atlas = boot_alloc(glyph_bytes * GLYPHS * ATLAS_SETS);
+        if (!atlas)
+            return -1;
+        if (st->atlas)
+            boot_free(st->atlas, st->glyph_bytes * GLYPHS * ATLAS_SETS);
+    }
+
+    st->atlas = atlas;
+    st->glyph_bytes = glyph_bytes;
+    st->cell_w = FONT_WIDTH * scale;
+    st->cell_h = FONT_HEIGHT * scale;
+    st->fg = fg;
+    st->bg = bg;
+    build_atlas(st, scale);
+
+    st->cols = fb->width / st->cell_w;
+    st->rows = fb->height / st->cell_h;
+    return 0;
+}
+
+u32 fb_cell_width(const framebuffer_t *fb) {
+    return fb->state && fb->state->atlas ? fb->state->cell_w : 0;
+}
+
+u32 fb_cell_height(const framebuffer_t *fb) {
+    return fb->state && fb->state->atlas ? fb->state->cell_h : 0;
+}
+
+static void draw_glyph(framebuffer_t *fb, u32 x, u32 y, char c, bool inverse) {
+    struct fb_state *st = fb->state;
+    u32 w = st->cell_w, h = st->cell_h;
+
+    if (!clip(fb, x, y, &w, &h))
+        return;
+
+    u32 g = (c >= FONT_FIRST && c <= FONT_LAST) ? (u32)(c - FONT_FIRST) : (u32)('?' - FONT_FIRST);
+    const u8 *src = st->atlas + ((inverse ? GLYPHS : 0) + g) * st->glyph_bytes;
+    size_t src_pitch = (size_t)st->cell_w * st->bytespp;
+    u8 *row = pixel_at(fb, st->draw, x, y);
+
+    for (u32 i = 0; i < h; i++, row += fb->pitch, src += src_pitch)
+        memcpy(row, src, (size_t)w * st->bytespp);
+
+    mark_dirty(st, x, y, w, h);
+}
+
+void fb_draw_text(framebuffer_t *fb, u32 x, u32 y, const char *s, bool inverse) {
+    if (!fb->state || !fb->state->atlas)
+        return;
+
+    for (; *s && x < fb->width; s++, x += fb->state->cell_w)
+        draw_glyph(fb, x, y, *s, inverse);
+}
+
+/* =========================
+ *  Text console
+ * ========================= */
+
+static void erase_cells(framebuffer_t *fb, u32 col, u32 row, u32 count) {
+    struct fb_state *st = fb->state;
+
+    fb_fill_rect(fb, col * st->cell_w, row * st->cell_h,
+                 count * st->cell_w, st->cell_h, st->inverse ? st->fg : st->bg);
+}
+
+static void newline(framebuffer_t *fb) {
+    struct fb_state *st = fb->state;
+
+    st->col = 0;
+    if (++st->row < st->rows)
+        return;
+
+    /* scroll by one text row; the bottom one is cleared to bg */
+    st->row = st->rows - 1;
+    fb_copy_rect(fb, 0, 0, 0, st->cell_h, st->cols * st->cell_w, st->row * st->cell_h);
+    fb_fill_rect(fb, 0, st->row * st->cell_h, st->cols * st->cell_w, st->cell_h, st->bg);
+}
+
+static void csi(framebuffer_t *fb, char final) {
+    struct fb_state *st = fb->state;
+    u32 a0 = st->esc_nargs > 0 ? st->esc_args[0] : 0;
+    u32 a1 = st->esc_nargs > 1 ? st->esc_args[1] : 0;
+
+    switch (final) {
+    case 'J':                   /* whole screen, whatever the argument */
+        fb_fill_rect(fb, 0, 0, fb->width, fb->height, st->bg);
+        break;
+    case 'H':
+    case 'f':
+        st->row = a0 ? a0 - 1 : 0;
+        st->col = a1 ? a1 - 1 : 0;
+        if (st->row >= st->rows)
+            st->row = st->rows - 1;
+        if (st->col >= st->cols)
+            st->col = st->cols - 1;
+        break;
+    case 'K':
+        erase_cells(fb, st->col, st->row, st->cols - st->col);
+        break;
+    case 'm':
+        if (!st->esc_nargs || a0 == 0 || a0 == 27)
+            st->inverse = false;
+        else if (a0 == 7)
+            st->inverse = true;
+        break;
+    default:
+        break;
+    }
+}
+
+static void console_char(framebuffer_t *fb, char c) {
+    struct fb_state *st = fb->state;
+
+    if (st->esc == ESC_SEEN) {
+        st->esc = (c == '[') ? ESC_CSI : ESC_NONE;
+        st->esc_nargs = 0;
+        st->esc_args[0] = st->esc_args[1] = 0;
+        return;
+    }
+
+    if (st->esc == ESC_CSI) {
+        if (c >= '0' && c <= '9') {
+            if (!st->esc_nargs)
+                st->esc_nargs = 1;
+            if (st->esc_nargs <= 2)
+                st->esc_args[st->esc_nargs - 1] = st->esc_args[st->esc_nargs - 1] * 10 + (u32)(c - '0');
+        } else if (c == ';') {
+            st->esc_nargs = st->esc_nargs ? st->esc_nargs + 1 : 2;
+        } else {
+            csi(fb, c);
+            st->esc = ESC_NONE;
+        }
+        return;
+    }
+
+    switch (c) {
+    case '\033':
+        st->esc = ESC_SEEN;
+        break;
+    case '\n':
+        newline(fb);
+        break;
+    case '\r':
+        st->col = 0;
+        break;
+    case '\b':
+        if (st->col)
+            st->col--;
+        break;
+    case '\t':
+        do {
+            console_char(fb, ' ');
+        } while (st->col % 8);
+        break;
+    default:
+        if ((u8)c < ' ')
+            break;
+        if (st->col >= st->cols)
+            newline(fb);
+        draw_glyph(fb, st->col * st->cell_w, st->row * st->cell_h, c, st->inverse);
+        st->col++;
+        break;
+    }
+}
+
+static void fb_console_write(const char *s, size_t len) {
+    framebuffer_t *fb = console_fb;
+
+    if (!fb)
+        return;
+
+    while (len--)
+        console_char(fb, *s++);
+    fb_present(fb);
+}
+
+int fb_console_attach(framebuffer_t *fb, u32 scale, u32 fg, u32 bg) {
+    if (fb_text_init(fb, scale, fg, bg) != 0)
+        return -1;
+
+    struct fb_state *st = fb->state;
+    if (!st->cols || !st->rows)
+        return -1;
+
+    st->col = st->row = 0;
+    st->inverse = false;
+    st->esc = ESC_NONE;
+
+    fb_fill_rect(fb, 0, 0, fb->width, fb->height, bg);
+    fb_present(fb);
+
+    console_fb = fb;
+    console_set_mirror(fb_console_write);
+    return 0;
+}
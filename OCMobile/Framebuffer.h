@@ -0,0 +1,88 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <stdbool.h>
+
+#include "bootstd.h"
+
+/*
+ * OpenCore Mobile – framebuffer
+ *
+ * Linear 32bpp (XRGB8888) and 16bpp (RGB565) panels. Colours are always
+ * passed as 0xAARRGGBB and converted to the panel format; images are
+ * premultiplied ARGB8888.
+ *
+ * When it fits in memory, drawing goes to a cached shadow copy of the
+ * panel (blending against write-combined scanout would read it back a
+ * pixel at a time), and every call records the rectangle it touched.
+ * fb_present() then moves only those rectangles to scanout and cleans
+ * them out to the display engine, so redrawing two menu rows costs two
+ * rows, not a 1440x3200 repaint. Without a shadow, drawing goes straight
+ * to scanout and fb_present() only does the cache maintenance.
+ */
+
+/* dirty rectangles kept before the closest pair gets merged */
+#define FB_MAX_DIRTY            16
+
+typedef struct {
+    u32 x, y;
+    u32 w, h;
+} fb_rect_t;
+
+typedef struct {
+    const u32 *pixels;          /* premultiplied 0xAARRGGBB */
+    u32 width;
+    u32 height;
+    u32 stride;                 /* in pixels */
+} fb_image_t;
+
+/*
+ * framebuffer_init() and fb_fill_rect() are declared in bootstd.h. The
+ * caller fills in base/width/height/pitch/bpp before framebuffer_init();
+ * everything below clips to the panel.
+ */
+
+/* Move a w x h block from (sx, sy) to (dx, dy); the two may overlap */
+void fb_copy_rect(framebuffer_t *fb, u32 dx, u32 dy, u32 sx, u32 sy, u32 w, u32 h);
+
+/* Opaque copy of `img` to (x, y); alpha is ignored */
+void fb_blit(framebuffer_t *fb, u32 x, u32 y, const fb_image_t *img);
+
+/* `img` over whatever is at (x, y) (src-over, premultiplied) */
+void fb_blend(framebuffer_t *fb, u32 x, u32 y, const fb_image_t *img);
+
+/* Opaque copy of w x h pixels already in the panel's format (`stride` in bytes) */
+void fb_blit_native(framebuffer_t *fb, u32 x, u32 y, const void *pixels,
+                    u32 w, u32 h, u32 stride);
+
+/* Push everything drawn since the last call to the panel */
+void fb_present(framebuffer_t *fb);
+
+/* =========================
+ *  Text
+ * ========================= */
+
+/*
+ * Glyphs are rendered once, at attach time, into an atlas in the panel's
+ * own format (anti-aliased against `bg`, plus an inverse set), so drawing
+ * a character is a few row copies. `scale` multiplies the 8x16 cell; 0
+ * picks one that gives the panel at least 80 columns' worth of cell.
+ */
+int fb_text_init(framebuffer_t *fb, u32 scale, u32 fg, u32 bg);
+
+/* Draw a string at pixel (x, y), no wrapping; needs fb_text_init() */
+void fb_draw_text(framebuffer_t *fb, u32 x, u32 y, const char *s, bool inverse);
+
+/* Cell size in pixels, 0 before fb_text_init() */
+u32 fb_cell_width(const framebuffer_t *fb);
+u32 fb_cell_height(const framebuffer_t *fb);
+
+/*
+ * Mirror the console onto `fb` (initializing text with the given scale
+ * and colours if needed). Understands \n \r \t \b and the few ANSI
+ * sequences the loader prints: clear (ESC[2J), home/position (ESC[H,
+ * ESC[row;colH), erase line (ESC[K) and reverse video (ESC[7m / ESC[0m).
+ */
+int fb_console_attach(framebuffer_t *fb, u32 scale, u32 fg, u32 bg);
+
+#endif /* FRAMEBUFFER_H */
@@ -0,0 +1,171 @@
+#include "Fs.h"
+#include "Platform/HfsPlusDxe/HfsPlus.h"
+#include "Platform/FatDxe/Fat.h"
+
+/*
+ * OpenCore Mobile – filesystem layer
+ *
+ * See Fs.h. The bootstd.h entry points live here; everything
+ * filesystem-specific is behind fs_ops_t.
+ */
+
+/* Tried in order by fs_mount_device() */
+static const fs_ops_t *const fs_drivers[] = {
+    &hfsplus_fs_ops,
+    &fat_fs_ops,
+};
+
+static struct {
+    char name[FS_DEVICE_NAME_MAX];
+    block_device_t *dev;
+} devices[FS_MAX_DEVICES];
+
+static u32 device_count;
+
+/* ===== devices ===== */
+
+status_t fs_register_device(const char *name, block_device_t *dev) {
+    size_t len = strlen(name);
+
+    if (!dev || !len || len >= FS_DEVICE_NAME_MAX)
+        return STATUS_INVALID_PARAM;
+    if (device_count == FS_MAX_DEVICES)
+        return STATUS_OUT_OF_RESOURCES;
+
+    memcpy(devices[device_count].name, name, len + 1);
+    devices[device_count].dev = dev;
+    device_count++;
+    return STATUS_SUCCESS;
+}
+
+status_t fs_mount_device(fs_t *fs, block_device_t *dev) {
+    status_t result = STATUS_NOT_FOUND;
+
+    for (size_t i = 0; i < sizeof(fs_drivers) / sizeof(fs_drivers[0]); i++) {
+        fs_volume_t *vol = NULL;
+        status_t status = fs_drivers[i]->mount(dev, &vol);
+
+        if (status == STATUS_SUCCESS) {
+            fs->impl = vol;
+            return STATUS_SUCCESS;
+        }
+        /* a driver that recognised the volume but failed says why */
+        if (status != STATUS_NOT_FOUND)
+            result = status;
+    }
+
+    return result;
+}
+
+int fs_mount(fs_t *fs, const char *path) {
+    fs->impl = NULL;
+
+    for (u32 i = 0; i < device_count; i++) {
+        if (!strcmp(devices[i].name, path))
+            return fs_mount_device(fs, devices[i].dev) == STATUS_SUCCESS ? 0 : -1;
+    }
+    return -1;
+}
+
+/* ===== files ===== */
+
+const char *fs_path_next(const char *path, const char **name, size_t *len) {
+    while (*path == '/' || *path == '\\')
+        path++;
+    if (!*path)
+        return NULL;
+
+    *name = path;
+    while (*path && *path != '/' && *path != '\\')
+        path++;
+    *len = (size_t)(path - *name);
+    return path;
+}
+
+s32 fs_utf8_to_utf16(const char *s, size_t len, u16 *out, u32 max) {
+    const u8 *p = (const u8 *)s;
+    const u8 *end = p + len;
+    s32 n = 0;
+
+    while (p < end) {
+        u32 c = *p++;
+        u32 extra = c < 0x80 ? 0 : c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 4;
+        if (extra == 4 || (u32)(end - p) < extra)
+            return -1;
+        if (extra)
+            c &= 0x3F >> extra;
+        while (extra--) {
+            if ((*p & 0xC0) != 0x80)
+                return -1;
+            c = c << 6 | (*p++ & 0x3F);
+        }
+
+        if ((u32)n + (c >= 0x10000 ? 2 : 1) > max)
+            return -1;
+        if (c >= 0x10000) {
+            c -= 0x10000;
+            out[n++] = (u16)(0xD800 | c >> 10);
+            out[n++] = (u16)(0xDC00 | (c & 0x3FF));
+        } else {
+            out[n++] = (u16)c;
+        }
+    }
+    return n;
+}
+
+int fs_open(fs_t *fs, const char *path, file_t *out) {
+    fs_volume_t *vol = (fs_volume_t *)fs->impl;
+    fs_file_t *file = NULL;
+
+    out->impl = NULL;
+    if (!vol || vol->ops->open(vol, path, &file) != STATUS_SUCCESS)
+        return -1;
+
+    file->volume = vol;
+    file->position = 0;
+    out->impl = file;
+    return 0;
+}
+
+size_t fs_read(file_t *file, void *buf, size_t size) {
+    fs_file_t *f = (fs_file_t *)file->impl;
+
+    if (!f || f->position >= f->size || !size)
+        return 0;
+    if (size > f->size - f->position)
+        size = (size_t)(f->size - f->position);
+
+    size_t n = f->volume->ops->read(f, f->position, buf, size);
+    f->position += n;
+    return n;
+}
+
+u64 fs_size(file_t *file) {
+    fs_file_t *f = (fs_file_t *)file->impl;
+    return f ? f->size : 0;
+}
+
+int fs_seek(file_t *file, u64 offset) {
+    fs_file_t *f = (fs_file_t *)file->impl;
+
+    if (!f || offset > f->size)
+        return -1;
+    f->position = offset;
+    return 0;
+}
+
+int fs_map(file_t *file, u64 offset, fs_extent_t *out) {
+    fs_file_t *f = (fs_file_t *)file->impl;
+
+    if (!f || offset >= f->size || !f->volume->ops->map)
+        return -1;
+    return f->volume->ops->map(f, offset, out);
+}
+
+void fs_close(file_t *file) {
+    fs_file_t *f = (fs_file_t *)file->impl;
+
+    if (f)
+        f->volume->ops->close(f);
+    file->impl = NULL;
+}
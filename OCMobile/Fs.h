@@ -0,0 +1,74 @@
+#ifndef FS_H
+#define FS_H
+
+#include "bootstd.h"
+#include "BlockIo.h"
+
+/*
+ * OpenCore Mobile – filesystem layer
+ *
+ * fs_t and file_t (bootstd.h) are handles onto a driver: a mounted
+ * volume's impl is the driver's fs_volume_t, an open file's its
+ * fs_file_t, and fs_open(), fs_read() and the rest dispatch through the
+ * volume's ops. The layer keeps the read position, so drivers only do
+ * positional reads.
+ *
+ * fs_mount() takes the name a block device was registered under
+ * ("sd0p2", "img0") and keeps the first driver that recognises it;
+ * fs_mount_device() skips the name.
+ */
+
+typedef struct fs_volume fs_volume_t;
+typedef struct fs_file fs_file_t;
+
+typedef struct fs_ops {
+    const char *name;
+
+    /* STATUS_NOT_FOUND when `dev` holds some other filesystem */
+    status_t (*mount)(block_device_t *dev, fs_volume_t **out);
+    status_t (*open)(fs_volume_t *vol, const char *path, fs_file_t **out);
+
+    /* Up to `size` bytes at `offset` (< file->size); bytes read, 0 on error */
+    size_t (*read)(fs_file_t *file, u64 offset, void *buf, size_t size);
+    void (*close)(fs_file_t *file);
+
+    /* optional */
+    int (*map)(fs_file_t *file, u64 offset, fs_extent_t *out);
+} fs_ops_t;
+
+/* First member of every driver's volume */
+struct fs_volume {
+    const fs_ops_t *ops;
+    block_device_t *device;
+};
+
+/* First member of every driver's open file */
+struct fs_file {
+    fs_volume_t *volume;
+    u64 size;
+    u64 position;               /* owned by the layer */
+};
+
+#define FS_MAX_DEVICES          16
+#define FS_DEVICE_NAME_MAX      16
+
+/* Make `dev` mountable as `name` */
+status_t fs_register_device(const char *name, block_device_t *dev);
+
+/* fs_mount() without the name lookup */
+status_t fs_mount_device(fs_t *fs, block_device_t *dev);
+
+/*
+ * Next component of a path, '/' or '\' separated (OpenCore writes
+ * "\EFI\OC\config.plist"), empty ones skipped. Sets *name and *len and
+ * returns where the rest starts, or NULL when there is none.
+ */
+const char *fs_path_next(const char *path, const char **name, size_t *len);
+
+/*
+ * UTF-8 into at most `max` UTF-16 units, for drivers whose names are
+ * UTF-16 on disk. Units written, or -1 if malformed or too long.
+ */
+s32 fs_utf8_to_utf16(const char *s, size_t len, u16 *out, u32 max);
+
+#endif /* FS_H */
@@ -0,0 +1,716 @@
+#include <stdbool.h>
+
+#include "Image.h"
+#include "Memory.h"
+#include "Trace.h"
+#include "Platform/crc32/crc32.h"
+#include "Platform/inflate/inflate.h"
+#include "Platform/lz4/lz4.h"
+
+/*
+ * OpenCore Mobile – boot menu images
+ * See Image.h.
+ */
+
+/* fs_read() granularity when streaming from a file */
+#define IMAGE_READ_CHUNK        (16u << 10)
+
+/* worst-case LZ4 expansion of one block */
+#define ASSET_BLOCK_BOUND       (OCM_ASSET_BLOCK_MAX + OCM_ASSET_BLOCK_MAX / 255 + 16)
+
+/* bounds any single allocation a header can ask for */
+#define IMAGE_MAX_DIM           16384
+
+#define PNG_IHDR                0x49484452u
+#define PNG_PLTE                0x504C5445u
+#define PNG_tRNS                0x74524E53u
+#define PNG_IDAT                0x49444154u
+#define PNG_IEND                0x49454E44u
+
+_Static_assert(sizeof(ocm_asset_header_t) == 32, "asset header layout");
+
+static const u8 png_signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+/* =========================
+ *  Sources
+ * ========================= */
+
+/* A buffer in memory, or a file read IMAGE_READ_CHUNK at a time */
+typedef struct {
+    const u8 *data;
+    size_t size;
+    size_t pos;
+
+    file_t *file;
+    u8 *buf;
+} source_t;
+
+/* Up to `max` contiguous bytes; 0 at the end */
+static size_t source_span(source_t *src, const u8 **out, size_t max) {
+    if (src->pos == src->size && src->file) {
+        src->data = src->buf;
+        src->size = fs_read(src->file, src->buf, IMAGE_READ_CHUNK);
+        src->pos = 0;
+    }
+
+    size_t n = src->size - src->pos;
+    if (n > max)
+        n = max;
+    *out = src->data + src->pos;
+    src->pos += n;
+    return n;
+}
+
+static bool source_read(source_t *src, void *dst, size_t len) {
+    u8 *d = dst;
+
+    while (len) {
+        const u8 *p;
+        size_t n = source_span(src, &p, len);
+
+        if (!n)
+            return false;
+        memcpy(d, p, n);
+        d += n;
+        len -= n;
+    }
+    return true;
+}
+
+/* `len` contiguous bytes: in place when they are, gathered into `scratch` otherwise */
+static const u8 *source_take(source_t *src, size_t len, u8 *scratch) {
+    const u8 *p;
+    size_t n = source_span(src, &p, len);
+
+    if (n == len)
+        return p;
+
+    memcpy(scratch, p, n);
+    return source_read(src, scratch + n, len - n) ? scratch : NULL;
+}
+
+static inline u32 be32(const u8 *p) {
+    return (u32)p[0] << 24 | (u32)p[1] << 16 | (u32)p[2] << 8 | p[3];
+}
+
+static inline u32 premultiply(u32 r, u32 g, u32 b, u32 a) {
+    if (a == 255)
+        return 0xFF000000u | r << 16 | g << 8 | b;
+    return a << 24 | ((r * a + 127) / 255) << 16 | ((g * a + 127) / 255) << 8 | ((b * a + 127) / 255);
+}
+
+/* Top-left corner for a w x h image placed at (x, y) with `flags` */
+static void place(u32 *x, u32 *y, u32 w, u32 h, u32 flags) {
+    if (!(flags & IMAGE_CENTERED))
+        return;
+    *x = *x > w / 2 ? *x - w / 2 : 0;
+    *y = *y > h / 2 ? *y - h / 2 : 0;
+}
+
+/* =========================
+ *  PNG
+ * ========================= */
+
+enum {
+    PNG_GRAY = 0,
+    PNG_RGB = 2,
+    PNG_PALETTE = 3,
+    PNG_GRAY_ALPHA = 4,
+    PNG_RGBA = 6
+};
+
+typedef struct {
+    source_t *src;
+    framebuffer_t *fb;
+    u32 x, y;
+
+    u32 width, height;
+    u8 depth;
+    u8 color;
+    u32 channels;
+    u32 filter_bpp;             /* bytes between a byte and its "left" neighbour */
+    u32 stride;                 /* bytes per row, without the filter byte */
+
+    u32 palette[256];           /* premultiplied */
+    u32 palette_size;
+    bool has_key;               /* tRNS colour key (gray/RGB) */
+    u16 key[3];
+    bool opaque;
+
+    /* rows: [0] is the filter type, the pixels follow */
+    u8 *prev;
+    u8 *cur;
+    u32 have;
+    u32 row;
+    u32 *argb;
+
+    /* IDAT walking */
+    u32 chunk_left;
+    u32 crc;
+    bool in_idat;
+    bool crc_failed;
+} png_t;
+
+/* Chunk payload: copied to `dst` (or skipped when NULL), CRC checked */
+static status_t png_chunk_data(png_t *p, u32 type, void *dst, u32 len) {
+    u8 type_be[4] = { (u8)(type >> 24), (u8)(type >> 16), (u8)(type >> 8), (u8)type };
+    u32 crc = crc32_update(0, type_be, 4);
+    u8 *d = dst;
+    u8 tail[4];
+
+    while (len) {
+        const u8 *data;
+        size_t n = source_span(p->src, &data, len);
+
+        if (!n)
+            return STATUS_ERROR;
+        crc = crc32_update(crc, data, n);
+        if (d) {
+            memcpy(d, data, n);
+            d += n;
+        }
+        len -= (u32)n;
+    }
+
+    if (!source_read(p->src, tail, 4))
+        return STATUS_ERROR;
+    return be32(tail) == crc ? STATUS_SUCCESS : STATUS_CRC_ERROR;
+}
+
+static bool png_chunk_header(png_t *p, u32 *len, u32 *type) {
+    u8 hdr[8];
+
+    if (!source_read(p->src, hdr, sizeof(hdr)))
+        return false;
+    *len = be32(hdr);
+    *type = be32(hdr + 4);
+    return *len <= 0x7FFFFFFFu;
+}
+
+static status_t png_header(png_t *p, const u8 *ihdr) {
+    static const u8 channels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+
+    p->width = be32(ihdr);
+    p->height = be32(ihdr + 4);
+    p->depth = ihdr[8];
+    p->color = ihdr[9];
+
+    if (!p->width || !p->height || p->width > IMAGE_MAX_DIM || p->height > IMAGE_MAX_DIM)
+        return STATUS_INVALID_PARAM;
+    if (p->color > PNG_RGBA || !channels[p->color])
+        return STATUS_INVALID_PARAM;
+    /* compression, filter method, interlace */
+    if (ihdr[10] != 0 || ihdr[11] != 0 || ihdr[12] != 0)
+        return STATUS_INVALID_PARAM;
+
+    switch (p->depth) {
+    case 1: case 2: case 4:
+        if (p->color != PNG_GRAY && p->color != PNG_PALETTE)
+            return STATUS_INVALID_PARAM;
+        break;
+    case 8:
+        break;
+    case 16:
+        if (p->color == PNG_PALETTE)
+            return STATUS_INVALID_PARAM;
+        break;
+    default:
+        return STATUS_INVALID_PARAM;
+    }
+
+    p->channels = channels[p->color];
+    p->stride = (p->width * p->channels * p->depth + 7) / 8;
+    p->filter_bpp = (p->channels * p->depth + 7) / 8;
+    p->opaque = p->color != PNG_GRAY_ALPHA && p->color != PNG_RGBA;
+    return STATUS_SUCCESS;
+}
+
+static status_t png_palette(png_t *p, const u8 *plte, u32 len) {
+    if (len % 3 || len / 3 > 256)
+        return STATUS_ERROR;
+
+    p->palette_size = len / 3;
+    for (u32 i = 0; i < p->palette_size; i++)
+        p->palette[i] = premultiply(plte[3 * i], plte[3 * i + 1], plte[3 * i + 2], 255);
+    return STATUS_SUCCESS;
+}
+
+static status_t png_transparency(png_t *p, const u8 *trns, u32 len) {
+    if (p->color == PNG_PALETTE) {
+        if (len > p->palette_size)
+            return STATUS_ERROR;
+        for (u32 i = 0; i < len; i++) {
+            u32 c = p->palette[i];
+            p->palette[i] = premultiply((c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF, trns[i]);
+        }
+    } else if (p->color == PNG_GRAY && len == 2) {
+        p->key[0] = (u16)(trns[0] << 8 | trns[1]);
+    } else if (p->color == PNG_RGB && len == 6) {
+        for (int i = 0; i < 3; i++)
+            p->key[i] = (u16)(trns[2 * i] << 8 | trns[2 * i + 1]);
+    } else {
+        return STATUS_SUCCESS;      /* already has alpha: tRNS is meaningless */
+    }
+
+    p->has_key = p->color != PNG_PALETTE;
+    p->opaque = false;
+    return STATUS_SUCCESS;
+}
+
+static inline u8 paeth(u8 a, u8 b, u8 c) {
+    int p = (int)a + b - c;
+    int pa = p > a ? p - a : a - p;
+    int pb = p > b ? p - b : b - p;
+    int pc = p > c ? p - c : c - p;
+
+    if (pa <= pb && pa <= pc)
+        return a;
+    return pb <= pc ? b : c;
+}
+
+static bool png_unfilter(png_t *p) {
+    u8 *cur = p->cur + 1;
+    const u8 *prev = p->prev + 1;
+    u32 n = p->stride, bpp = p->filter_bpp;
+
+    switch (p->cur[0]) {
+    case 0:
+        break;
+    case 1:
+        for (u32 i = bpp; i < n; i++)
+            cur[i] += cur[i - bpp];
+        break;
+    case 2:
+        for (u32 i = 0; i < n; i++)
+            cur[i] += prev[i];
+        break;
+    case 3:
+        for (u32 i = 0; i < bpp; i++)
+            cur[i] += prev[i] >> 1;
+        for (u32 i = bpp; i < n; i++)
+            cur[i] += (u8)((cur[i - bpp] + prev[i]) >> 1);
+        break;
+    case 4:
+        for (u32 i = 0; i < bpp; i++)
+            cur[i] += prev[i];
+        for (u32 i = bpp; i < n; i++)
+            cur[i] += paeth(cur[i - bpp], prev[i], prev[i - bpp]);
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+/* i-th sample of a row at the image's depth, unscaled */
+static inline u32 png_sample(const u8 *row, u32 i, u8 depth) {
+    switch (depth) {
+    case 8:
+        return row[i];
+    case 16:
+        return (u32)row[2 * i] << 8 | row[2 * i + 1];
+    default: {
+        u32 bit = i * depth;
+        return (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1u << depth) - 1);
+    }
+    }
+}
+
+static inline u32 png_scale(u32 v, u8 depth) {
+    switch (depth) {
+    case 8:
+        return v;
+    case 16:
+        return v >> 8;
+    default:
+        return v * 255 / ((1u << depth) - 1);
+    }
+}
+
+static void png_convert_row(png_t *p) {
+    const u8 *in = p->cur + 1;
+    u32 *out = p->argb;
+    u8 d = p->depth;
+
+    /* the common cases, unrolled */
+    if (d == 8 && p->color == PNG_RGBA) {
+        for (u32 i = 0; i < p->width; i++, in += 4)
+            out[i] = premultiply(in[0], in[1], in[2], in[3]);
+        return;
+    }
+    if (d == 8 && p->color == PNG_RGB && !p->has_key) {
+        for (u32 i = 0; i < p->width; i++, in += 3)
+            out[i] = 0xFF000000u | (u32)in[0] << 16 | (u32)in[1] << 8 | in[2];
+        return;
+    }
+
+    for (u32 i = 0; i < p->width; i++) {
+        u32 s0, s1, s2, a = 255;
+
+        switch (p->color) {
+        case PNG_PALETTE:
+            s0 = png_sample(in, i, d);
+            out[i] = s0 < p->palette_size ? p->palette[s0] : 0;
+            continue;
+        case PNG_GRAY:
+            s0 = png_sample(in, i, d);
+            if (p->has_key && s0 == p->key[0])
+                a = 0;
+            s0 = s1 = s2 = png_scale(s0, d);
+            break;
+        case PNG_GRAY_ALPHA:
+            s0 = s1 = s2 = png_scale(png_sample(in, 2 * i, d), d);
+            a = png_scale(png_sample(in, 2 * i + 1, d), d);
+            break;
+        case PNG_RGB:
+            s0 = png_sample(in, 3 * i, d);
+            s1 = png_sample(in, 3 * i + 1, d);
+            s2 = png_sample(in, 3 * i + 2, d);
+            if (p->has_key && s0 == p->key[0] && s1 == p->key[1] && s2 == p->key[2])
+                a = 0;
+            s0 = png_scale(s0, d);
+            s1 = png_scale(s1, d);
+            s2 = png_scale(s2, d);
+            break;
+        default:                /* PNG_RGBA */
+            s0 = png_scale(png_sample(in, 4 * i, d), d);
+            s1 = png_scale(png_sample(in, 4 * i + 1, d), d);
+            s2 = png_scale(png_sample(in, 4 * i + 2, d), d);
+            a = png_scale(png_sample(in, 4 * i + 3, d), d);
+            break;
+        }
+        out[i] = premultiply(s0, s1, s2, a);
+    }
+}
+
+/* inflate input: IDAT payloads, chunk after chunk */
+static size_t png_input(void *ctx, const u8 **data) {
+    png_t *p = ctx;
+
+    while (p->in_idat && !p->chunk_left) {
+        u8 tail[4];
+        u32 len, type;
+
+        if (!source_read(p->src, tail, 4) || be32(tail) != p->crc) {
+            p->crc_failed = true;
+            p->in_idat = false;
+            return 0;
+        }
+
+        /* IDATs are consecutive; anything else ends the image data */
+        if (!png_chunk_header(p, &len, &type) || type != PNG_IDAT) {
+            p->in_idat = false;
+            return 0;
+        }
+        p->chunk_left = len;
+        p->crc = crc32_update(0, "IDAT", 4);
+    }
+
+    if (!p->in_idat)
+        return 0;
+
+    size_t n = source_span(p->src, data, p->chunk_left);
+    p->chunk_left -= (u32)n;
+    p->crc = crc32_update(p->crc, *data, n);
+    if (!n)
+        p->in_idat = false;
+    return n;
+}
+
+/* inflate output: filtered rows; each one is drawn once it is complete */
+static int png_output(void *ctx, const u8 *data, size_t len) {
+    png_t *p = ctx;
+    u32 row_bytes = p->stride + 1;
+
+    while (len && p->row < p->height) {
+        u32 n = row_bytes - p->have;
+        if (n > len)
+            n = (u32)len;
+
+        memcpy(p->cur + p->have, data, n);
+        p->have += n;
+        data += n;
+        len -= n;
+        if (p->have < row_bytes)
+            break;
+
+        if (!png_unfilter(p))
+            return -1;
+        png_convert_row(p);
+
+        fb_image_t line = { p->argb, p->width, 1, p->width };
+        if (p->opaque)
+            fb_blit(p->fb, p->x, p->y + p->row, &line);
+        else
+            fb_blend(p->fb, p->x, p->y + p->row, &line);
+
+        u8 *t = p->prev;
+        p->prev = p->cur;
+        p->cur = t;
+        p->have = 0;
+        p->row++;
+    }
+
+    /* trailing bytes past the last row are tolerated, like most decoders do */
+    return 0;
+}
+
+/* Up to the first IDAT; leaves encountered PLTE/tRNS applied */
+static status_t png_begin(png_t *p, u32 *idat_len) {
+    u8 sig[8], ihdr[13];
+    u32 len, type;
+    status_t status;
+
+    if (!source_read(p->src, sig, sizeof(sig)) || memcmp(sig, png_signature, sizeof(sig)) != 0)
+        return STATUS_INVALID_PARAM;
+
+    if (!png_chunk_header(p, &len, &type) || type != PNG_IHDR || len != sizeof(ihdr))
+        return STATUS_ERROR;
+    if ((status = png_chunk_data(p, type, ihdr, len)) != STATUS_SUCCESS)
+        return status;
+    if ((status = png_header(p, ihdr)) != STATUS_SUCCESS)
+        return status;
+
+    for (;;) {
+        u8 small[768];
+
+        if (!png_chunk_header(p, &len, &type))
+            return STATUS_ERROR;
+        if (type == PNG_IDAT)
+            break;
+        if (type == PNG_IEND)
+            return STATUS_ERROR;
+
+        if (type != PNG_PLTE && type != PNG_tRNS) {
+            if ((status = png_chunk_data(p, type, NULL, len)) != STATUS_SUCCESS)
+                return status;
+            continue;
+        }
+
+        if (len > sizeof(small))
+            return STATUS_ERROR;
+        if ((status = png_chunk_data(p, type, small, len)) != STATUS_SUCCESS)
+            return status;
+        status = (type == PNG_PLTE) ? png_palette(p, small, len) : png_transparency(p, small, len);
+        if (status != STATUS_SUCCESS)
+            return status;
+    }
+
+    if (p->color == PNG_PALETTE && !p->palette_size)
+        return STATUS_ERROR;
+
+    *idat_len = len;
+    return STATUS_SUCCESS;
+}
+
+static status_t png_draw(framebuffer_t *fb, u32 x, u32 y, u32 flags, source_t *src) {
+    png_t *p = arena_alloc_zero(sizeof(*p));
+    u32 idat_len;
+    status_t status;
+
+    if (!p)
+        return STATUS_OUT_OF_MEMORY;
+    p->src = src;
+    p->fb = fb;
+
+    if ((status = png_begin(p, &idat_len)) != STATUS_SUCCESS)
+        return status;
+
+    p->prev = arena_alloc_zero(p->stride + 1);     /* row -1 is all zero */
+    p->cur = arena_alloc(p->stride + 1);
+    p->argb = arena_alloc((size_t)p->width * sizeof(u32));
+    if (!p->prev || !p->cur || !p->argb)
+        return STATUS_OUT_OF_MEMORY;
+
+    place(&x, &y, p->width, p->height, flags);
+    p->x = x;
+    p->y = y;
+    p->in_idat = true;
+    p->chunk_left = idat_len;
+    p->crc = crc32_update(0, "IDAT", 4);
+
+    if (inflate_stream(INFLATE_ZLIB, png_input, png_output, p) != 0)
+        return p->crc_failed ? STATUS_CRC_ERROR : STATUS_ERROR;
+    return p->row == p->height ? STATUS_SUCCESS : STATUS_ERROR;
+}
+
+/* =========================
+ *  Assets
+ * ========================= */
+
+static status_t asset_header(const ocm_asset_header_t *hdr, u32 *bytespp) {
+    if (memcmp(hdr->magic, OCM_ASSET_MAGIC, sizeof(hdr->magic)) != 0)
+        return STATUS_INVALID_PARAM;
+    if (hdr->version != OCM_ASSET_VERSION)
+        return STATUS_INVALID_PARAM;
+    if (!hdr->width || !hdr->height || hdr->width > IMAGE_MAX_DIM || hdr->height > IMAGE_MAX_DIM)
+        return STATUS_ERROR;
+
+    switch (hdr->format) {
+    case OCM_ASSET_ARGB8888:
+    case OCM_ASSET_XRGB8888:
+        *bytespp = 4;
+        break;
+    case OCM_ASSET_RGB565:
+        *bytespp = 2;
+        break;
+    default:
+        return STATUS_INVALID_PARAM;
+    }
+
+    u64 block_bytes = (u64)hdr->rows_per_block * hdr->width * *bytespp;
+    if (!hdr->rows_per_block || block_bytes > OCM_ASSET_BLOCK_MAX)
+        return STATUS_ERROR;
+    if (hdr->block_count != (hdr->height + hdr->rows_per_block - 1) / hdr->rows_per_block)
+        return STATUS_ERROR;
+    return STATUS_SUCCESS;
+}
+
+static status_t asset_draw(framebuffer_t *fb, u32 x, u32 y, u32 flags, source_t *src) {
+    ocm_asset_header_t hdr;
+    u32 bytespp;
+    status_t status;
+
+    if (!source_read(src, &hdr, sizeof(hdr)))
+        return STATUS_ERROR;
+    if ((status = asset_header(&hdr, &bytespp)) != STATUS_SUCCESS)
+        return status;
+
+    /* 565 rows are only "native" on a 565 panel; the PNG can cover others */
+    if (hdr.format == OCM_ASSET_RGB565 && fb->bpp != 16)
+        return STATUS_INVALID_PARAM;
+
+    u32 *sizes = arena_alloc((size_t)hdr.block_count * sizeof(u32));
+    u8 *raw = arena_alloc(OCM_ASSET_BLOCK_MAX);
+    u8 *scratch = arena_alloc(ASSET_BLOCK_BOUND);
+    if (!sizes || !raw || !scratch)
+        return STATUS_OUT_OF_MEMORY;
+    if (!source_read(src, sizes, (size_t)hdr.block_count * sizeof(u32)))
+        return STATUS_ERROR;
+
+    place(&x, &y, hdr.width, hdr.height, flags);
+
+    u32 row_bytes = hdr.width * bytespp;
+
+    for (u32 b = 0, row = 0; b < hdr.block_count; b++, row += hdr.rows_per_block) {
+        u32 rows = hdr.height - row < hdr.rows_per_block ? hdr.height - row : hdr.rows_per_block;
+        size_t expect = (size_t)rows * row_bytes, got;
+        const u8 *block;
+
+        if (sizes[b] > ASSET_BLOCK_BOUND || !(block = source_take(src, sizes[b], scratch)))
+            return STATUS_ERROR;
+        if (lz4_decompress(block, sizes[b], raw, expect, &got) != 0 || got != expect)
+            return STATUS_ERROR;
+
+        if (hdr.format == OCM_ASSET_ARGB8888) {
+            fb_image_t img = { (const u32 *)raw, hdr.width, rows, hdr.width };
+            fb_blend(fb, x, y + row, &img);
+        } else if (hdr.format == OCM_ASSET_XRGB8888 && fb->bpp != 32) {
+            fb_image_t img = { (const u32 *)raw, hdr.width, rows, hdr.width };
+            fb_blit(fb, x, y + row, &img);
+        } else {
+            fb_blit_native(fb, x, y + row, raw, hdr.width, rows, row_bytes);
+        }
+    }
+    return STATUS_SUCCESS;
+}
+
+/* =========================
+ *  Entry points
+ * ========================= */
+
+static status_t draw_source(framebuffer_t *fb, u32 x, u32 y, u32 flags, source_t *src) {
+    arena_mark_t mark = arena_mark();
+    const u8 *magic;
+    status_t status;
+
+    trace_begin("image");
+
+    /* peek: the first span always holds the 8 magic bytes for valid input */
+    size_t n = source_span(src, &magic, 8);
+    src->pos -= n;
+
+    bool asset = n == 8 && !memcmp(magic, OCM_ASSET_MAGIC, 8);
+
+    if (asset)
+        status = asset_draw(fb, x, y, flags, src);
+    else if (n == 8 && !memcmp(magic, png_signature, 8))
+        status = png_draw(fb, x, y, flags, src);
+    else
+        status = STATUS_INVALID_PARAM;
+
+    /* arg: which decoder ran, 1 for an asset */
+    trace_end("image", asset);
+    arena_release(mark);
+    return status;
+}
+
+status_t image_get_size(const void *data, size_t size, u32 *width, u32 *height) {
+    const u8 *p = data;
+
+    if (size >= 24 && !memcmp(p, png_signature, 8) && be32(p + 12) == PNG_IHDR) {
+        *width = be32(p + 16);
+        *height = be32(p + 20);
+        return STATUS_SUCCESS;
+    }
+
+    if (size >= sizeof(ocm_asset_header_t)) {
+        ocm_asset_header_t hdr;
+        u32 bytespp;
+
+        memcpy(&hdr, data, sizeof(hdr));
+        if (asset_header(&hdr, &bytespp) == STATUS_SUCCESS) {
+            *width = hdr.width;
+            *height = hdr.height;
+            return STATUS_SUCCESS;
+        }
+    }
+    return STATUS_INVALID_PARAM;
+}
+
+status_t image_draw(framebuffer_t *fb, u32 x, u32 y, u32 flags,
+                    const void *data, size_t size) {
+    source_t src = { data, size, 0, NULL, NULL };
+
+    if (!fb || !data)
+        return STATUS_INVALID_PARAM;
+    return draw_source(fb, x, y, flags, &src);
+}
+
+static status_t draw_file(framebuffer_t *fb, u32 x, u32 y, u32 flags,
+                          fs_t *fs, const char *path) {
+    arena_mark_t mark = arena_mark();
+    source_t src = { NULL, 0, 0, NULL, NULL };
+    file_t file;
+    status_t status;
+
+    if (fs_open(fs, path, &file) != 0)
+        return STATUS_NOT_FOUND;
+
+    src.file = &file;
+    src.buf = arena_alloc(IMAGE_READ_CHUNK);
+    status = src.buf ? draw_source(fb, x, y, flags, &src) : STATUS_OUT_OF_MEMORY;
+
+    fs_close(&file);
+    arena_release(mark);
+    return status;
+}
+
+status_t image_draw_file(framebuffer_t *fb, u32 x, u32 y, u32 flags,
+                         fs_t *fs, const char *path) {
+    size_t len = strlen(path);
+    char asset[256];
+
+    if (!fb || !fs)
+        return STATUS_INVALID_PARAM;
+
+    if (len > 4 && len - 4 + sizeof(OCM_ASSET_EXT) <= sizeof(asset) &&
+        !strcmp(path + len - 4, ".png")) {
+        memcpy(asset, path, len - 4);
+        memcpy(asset + len - 4, OCM_ASSET_EXT, sizeof(OCM_ASSET_EXT));
+        if (draw_file(fb, x, y, flags, fs, asset) == STATUS_SUCCESS)
+            return STATUS_SUCCESS;
+    }
+
+    return draw_file(fb, x, y, flags, fs, path);
+}
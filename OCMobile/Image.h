@@ -0,0 +1,66 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include "bootstd.h"
+#include "Framebuffer.h"
+
+/*
+ * OpenCore Mobile – boot menu images
+ *
+ * Images are drawn into a framebuffer_t while they decode; the decoded
+ * picture never exists in memory as a whole. Two formats:
+ *
+ *  - PNG: every colour type and bit depth, no Adam7. IDAT is inflated
+ *    through the 32 KiB DEFLATE window and unfiltered into two row
+ *    buffers; each finished row is converted and blitted (or blended,
+ *    when the image has alpha) straight away.
+ *
+ *  - assets from Tools/mkasset.py: rows already in the panel's pixel
+ *    format, LZ4-compressed in independent blocks of whole rows, at most
+ *    OCM_ASSET_BLOCK_MAX bytes each when decoded. Drawing one is a single
+ *    decompression pass and a row copy, with no filtering or conversion.
+ *
+ * Files are streamed in small reads rather than loaded. Scratch space
+ * comes from the stage arena and is given back before returning.
+ */
+
+#define OCM_ASSET_MAGIC         "OCMASSET"
+#define OCM_ASSET_VERSION       1
+#define OCM_ASSET_EXT           ".asset"
+#define OCM_ASSET_BLOCK_MAX     (64u << 10)
+
+typedef enum {
+    OCM_ASSET_ARGB8888 = 1,     /* premultiplied, blended onto any panel */
+    OCM_ASSET_XRGB8888,         /* opaque, copied to 32bpp panels */
+    OCM_ASSET_RGB565            /* opaque, copied to 16bpp panels */
+} ocm_asset_format_t;
+
+/* little-endian; followed by u32 compressed_size[block_count], then the blocks */
+typedef struct {
+    char magic[8];
+    u32 version;
+    u32 format;                 /* ocm_asset_format_t */
+    u32 width;
+    u32 height;
+    u32 rows_per_block;         /* the last block may have fewer */
+    u32 block_count;
+} ocm_asset_header_t;
+
+/* (x, y) is the image's centre instead of its top-left corner */
+#define IMAGE_CENTERED          (1u << 0)
+
+/* Dimensions of a PNG or asset in memory */
+status_t image_get_size(const void *data, size_t size, u32 *width, u32 *height);
+
+/* Draw a PNG or asset from memory */
+status_t image_draw(framebuffer_t *fb, u32 x, u32 y, u32 flags,
+                    const void *data, size_t size);
+
+/*
+ * Draw `path` from `fs`. For "name.png", a "name.asset" next to it is
+ * preferred when it fits the panel's format, and the PNG is the fallback.
+ */
+status_t image_draw_file(framebuffer_t *fb, u32 x, u32 y, u32 flags,
+                         fs_t *fs, const char *path);
+
+#endif /* IMAGE_H */
@@ -0,0 +1,245 @@
+#include <stdbool.h>
+
+#include "bootstd.h"
+#include "Event.h"
+#include "arch/aarch64/cpu.h"
+#include "arch/aarch64/io.h"
+#include "arch/aarch64/irq.h"
+#include "arch/aarch64/timer.h"
+
+/*
+ * OpenCore Mobile – key input
+ *
+ * Keys arrive from interrupts and queue up until the boot path asks for
+ * them; input_get()/input_wait() sleep in wfi (Event.h) rather than
+ * polling, so a menu waiting on a person costs nothing in between.
+ *
+ * Sources:
+ *  - GPIO keys (volume, power) on a PL061: one edge-triggered line per
+ *    key, debounced by time since the last accepted edge. The key map is
+ *    per device; the default is QEMU virt's power button.
+ *  - the serial console: arrows, Enter and Backspace, so the menu can be
+ *    driven over a UART as well.
+ *
+ * Without an interrupt controller the same sources are polled from
+ * input_poll() and the wait loop instead.
+ */
+
+#ifndef INPUT_GPIO_BASE
+#define INPUT_GPIO_BASE         0x09030000      /* PL061; QEMU virt, per device later; 0: none */
+#endif
+
+#ifndef INPUT_GPIO_IRQ
+#define INPUT_GPIO_IRQ          39              /* SPI 7 */
+#endif
+
+/* { line, key, active low } for each key wired to the controller */
+#ifndef INPUT_GPIO_KEYS
+#define INPUT_GPIO_KEYS         { 3, KEY_SELECT, false }        /* QEMU virt power button */
+#endif
+
+#ifndef INPUT_DEBOUNCE_MS
+#define INPUT_DEBOUNCE_MS       20
+#endif
+
+/* keys not yet read; more is a person mashing buttons, and they are dropped */
+#define INPUT_QUEUE             16              /* power of two */
+
+/* PL061 */
+#define GPIO_DIR                0x400
+#define GPIO_IS                 0x404
+#define GPIO_IBE                0x408
+#define GPIO_IEV                0x40C
+#define GPIO_IE                 0x410
+#define GPIO_RIS                0x414
+#define GPIO_MIS                0x418
+#define GPIO_IC                 0x41C
+#define GPIO_LINES              8
+
+static const struct gpio_key {
+    u8 line;
+    u8 key;                     /* boot_key_t */
+    bool active_low;
+} gpio_keys[] = { INPUT_GPIO_KEYS };
+
+#define GPIO_KEY_COUNT          (sizeof(gpio_keys) / sizeof(gpio_keys[0]))
+
+static struct {
+    u8 queue[INPUT_QUEUE];
+    u32 head;                   /* free running */
+    u32 tail;
+
+    bool gpio_irq;              /* else polled */
+    u8 gpio_mask;               /* lines in gpio_keys */
+    u64 debounce;               /* in ticks */
+    u64 last_edge[GPIO_LINES];
+
+    u8 esc;                     /* serial escape sequence state */
+    bool cr;                    /* swallow the '\n' of "\r\n" */
+} in;
+
+/* ===== queue ===== */
+
+static void push(boot_key_t key) {
+    /* producers: the IRQ handlers and, polling, the boot path itself */
+    u64 daif = irq_save();
+
+    if (in.head - in.tail < INPUT_QUEUE) {
+        in.queue[in.head % INPUT_QUEUE] = (u8)key;
+        __atomic_store_n(&in.head, in.head + 1, __ATOMIC_RELEASE);
+    }
+    irq_restore(daif);
+}
+
+static boot_key_t pop(void) {
+    u32 tail = in.tail;
+
+    if (tail == __atomic_load_n(&in.head, __ATOMIC_ACQUIRE))
+        return KEY_NONE;
+
+    boot_key_t key = (boot_key_t)in.queue[tail % INPUT_QUEUE];
+    __atomic_store_n(&in.tail, tail + 1, __ATOMIC_RELEASE);
+    return key;
+}
+
+/* ===== GPIO keys ===== */
+
+static void gpio_service(void) {
+    uintptr_t base = INPUT_GPIO_BASE;
+    u32 edges = mmio_read32(base + (in.gpio_irq ? GPIO_MIS : GPIO_RIS)) & in.gpio_mask;
+
+    if (!edges)
+        return;
+    mmio_write32(base + GPIO_IC, edges);
+
+    u64 now = timer_ticks();
+    for (u32 i = 0; i < GPIO_KEY_COUNT; i++) {
+        u32 line = gpio_keys[i].line;
+
+        if (!(edges & (1u << line)))
+            continue;
+        if (in.last_edge[line] && now - in.last_edge[line] < in.debounce)
+            continue;           /* contact bounce */
+        in.last_edge[line] = now;
+        push((boot_key_t)gpio_keys[i].key);
+    }
+}
+
+static void gpio_handler(void *ctx) {
+    (void)ctx;
+    gpio_service();
+}
+
+static void gpio_init(void) {
+    uintptr_t base = INPUT_GPIO_BASE;
+    u32 rising = 0;
+
+    if (!base)
+        return;
+
+    for (u32 i = 0; i < GPIO_KEY_COUNT; i++) {
+        if (gpio_keys[i].line >= GPIO_LINES)
+            continue;
+        in.gpio_mask |= (u8)(1u << gpio_keys[i].line);
+        if (!gpio_keys[i].active_low)
+            rising |= 1u << gpio_keys[i].line;
+    }
+
+    /* inputs, single edge, on the press */
+    u32 mask = in.gpio_mask;
+    mmio_write32(base + GPIO_IE, mmio_read32(base + GPIO_IE) & ~mask);
+    mmio_write32(base + GPIO_DIR, mmio_read32(base + GPIO_DIR) & ~mask);
+    mmio_write32(base + GPIO_IS, mmio_read32(base + GPIO_IS) & ~mask);
+    mmio_write32(base + GPIO_IBE, mmio_read32(base + GPIO_IBE) & ~mask);
+    mmio_write32(base + GPIO_IEV, (mmio_read32(base + GPIO_IEV) & ~mask) | rising);
+    mmio_write32(base + GPIO_IC, mask);
+
+    /* raw status still latches edges if there is no interrupt to take */
+    in.gpio_irq = irq_register(INPUT_GPIO_IRQ, gpio_handler, NULL, 0) == STATUS_SUCCESS;
+    if (in.gpio_irq)
+        mmio_write32(base + GPIO_IE, mmio_read32(base + GPIO_IE) | mask);
+}
+
+/* ===== serial keys ===== */
+
+enum { ESC_NONE, ESC_START, ESC_CSI };
+
+static void serial_byte(u8 c) {
+    bool cr = in.cr;
+
+    in.cr = false;
+    switch (in.esc) {
+    case ESC_START:
+        in.esc = (c == '[' || c == 'O') ? ESC_CSI : ESC_NONE;
+        if (in.esc == ESC_NONE)
+            push(KEY_BACK);     /* a lone ESC, seen once the next byte arrives */
+        return;
+
+    case ESC_CSI:
+        if (c >= 0x40 && c <= 0x7E) {       /* final byte */
+            in.esc = ESC_NONE;
+            switch (c) {
+            case 'A': push(KEY_UP); break;
+            case 'B': push(KEY_DOWN); break;
+            case 'C': push(KEY_RIGHT); break;
+            case 'D': push(KEY_LEFT); break;
+            }
+        }
+        return;
+    }
+
+    switch (c) {
+    case 0x1B:
+        in.esc = ESC_START;
+        break;
+    case '\r':
+        in.cr = true;
+        push(KEY_SELECT);
+        break;
+    case '\n':
+        if (!cr)
+            push(KEY_SELECT);
+        break;
+    case '\b':
+    case 0x7F:
+        push(KEY_BACK);
+        break;
+    }
+}
+
+/* ===== interface ===== */
+
+void input_init(void) {
+    memset(&in, 0, sizeof(in));
+    in.debounce = timer_us_to_ticks(INPUT_DEBOUNCE_MS * 1000);
+
+    gpio_init();
+    console_set_input(serial_byte);
+}
+
+/* With IRQs masked: fetch what interrupts would have, then look at the queue */
+static bool key_ready(void *ctx) {
+    (void)ctx;
+
+    if (in.gpio_mask && !in.gpio_irq)
+        gpio_service();
+    console_poll();             /* also picks up RX the interrupt might have missed */
+
+    return in.tail != __atomic_load_n(&in.head, __ATOMIC_ACQUIRE);
+}
+
+boot_key_t input_poll(void) {
+    u64 daif = irq_save();
+    boot_key_t key = key_ready(NULL) ? pop() : KEY_NONE;
+
+    irq_restore(daif);
+    return key;
+}
+
+boot_key_t input_wait(u64 deadline) {
+    return event_wait(deadline, key_ready, NULL) ? pop() : KEY_NONE;
+}
+
+boot_key_t input_get(void) {
+    return input_wait(EVENT_FOREVER);
+}
@@ -0,0 +1,485 @@
+#include "Memory.h"
+#include "arch/aarch64/cpu.h"
+#include "arch/aarch64/spinlock.h"
+
+/*
+ * OpenCore Mobile – boot allocator
+ * See Memory.h for the layout. One lock covers the shared heap; core
+ * arenas belong to their core and need none.
+ */
+
+#define MEM_ALIGN           16
+#define SLAB_PAGE_SIZE      (64 * 1024)
+#define SLAB_ZONE_MAX       (2 * 1024 * 1024)
+#define SLAB_ZONE_PAGES     (SLAB_ZONE_MAX / SLAB_PAGE_SIZE)
+#define EARLY_HEAP_SIZE     (256 * 1024)
+
+#define ALIGN_UP(x, a)      (((x) + ((a) - 1)) & ~(uintptr_t)((a) - 1))
+#define ALIGN_DOWN(x, a)    ((x) & ~(uintptr_t)((a) - 1))
+
+/* ---- heap state ---- */
+
+static u8 early_heap[EARLY_HEAP_SIZE] __attribute__((aligned(MEM_ALIGN)));
+
+static struct {
+    uintptr_t base;
+    uintptr_t end;
+    uintptr_t bottom;       /* permanent cursor, grows up */
+    uintptr_t top;          /* arena cursor, grows down */
+    uintptr_t zone;         /* slab zone base, 0 while on the early heap */
+    u32 zone_pages;
+    u32 zone_pages_used;
+    u64 high_water;
+} heap;
+
+/* secondaries' private arenas, see arena_attach_cpu(); [0] is unused */
+static struct {
+    uintptr_t base;
+    uintptr_t top;          /* grows down from end */
+    uintptr_t end;
+} core_arena[OCM_MAX_CPUS];
+
+/* boot_free()d blocks below heap.bottom, unordered: frees are rare */
+typedef struct free_block {
+    struct free_block *next;
+    size_t size;
+} free_block_t;
+
+static free_block_t *permanent_free;
+static u64 permanent_free_bytes;
+
+/* heap, slabs and zone pages; the boot CPU's arena lives in the heap */
+static spinlock_t heap_lock = SPINLOCK_INIT;
+
+/* owning cache of each zone page, so mem_free() needs no header */
+static slab_cache_t *zone_owner[SLAB_ZONE_PAGES];
+
+slab_cache_t slab_128 = SLAB_CACHE_INIT("small128", 128);
+slab_cache_t slab_512 = SLAB_CACHE_INIT("sector512", 512);
+slab_cache_t slab_4k  = SLAB_CACHE_INIT("sector4k", 4096);
+
+static void heap_setup(uintptr_t base, uintptr_t end, u32 zone_pages) {
+    heap.base = base;
+    heap.end = end;
+    heap.zone = zone_pages ? base : 0;
+    heap.zone_pages = zone_pages;
+    heap.zone_pages_used = 0;
+    heap.bottom = base + (uintptr_t)zone_pages * SLAB_PAGE_SIZE;
+    heap.top = end;
+}
+
+static inline void heap_ready(void) {
+    if (!heap.base) {
+        uintptr_t b = (uintptr_t)early_heap;
+        heap_setup(b, b + EARLY_HEAP_SIZE, 0);
+    }
+}
+
+static inline void heap_account(void) {
+    u64 used = (u64)(heap.bottom - heap.base) + (u64)(heap.end - heap.top);
+    if (used > heap.high_water)
+        heap.high_water = used;
+}
+
+/* =========================
+ *  Setup
+ * ========================= */
+
+/* the early heap has no slab zone, so no cache holds early objects */
+void mem_init(const ocm_mem_region_t *map, u32 count) {
+    const ocm_mem_region_t *best = NULL;
+
+    for (u32 i = 0; map && i < count; i++) {
+        if (map[i].type != OCM_MEM_USABLE)
+            continue;
+        if (!best || map[i].size > best->size)
+            best = &map[i];
+    }
+
+    if (!best)
+        return; /* keep running on the early heap */
+
+    uintptr_t base = ALIGN_UP((uintptr_t)best->base, SLAB_PAGE_SIZE);
+    uintptr_t end = ALIGN_DOWN((uintptr_t)(best->base + best->size), MEM_ALIGN);
+
+    if (end <= base + SLAB_PAGE_SIZE)
+        return;
+
+    /* a quarter of the region at most goes to slabs */
+    u64 zone = (u64)(end - base) / 4;
+    if (zone > SLAB_ZONE_MAX)
+        zone = SLAB_ZONE_MAX;
+
+    for (u32 i = 0; i < SLAB_ZONE_PAGES; i++)
+        zone_owner[i] = NULL;
+
+    /* early heap usage still counts towards the footprint; its freed blocks are let go */
+    u64 early = heap.high_water;
+    permanent_free = NULL;
+    permanent_free_bytes = 0;
+    heap_setup(base, end, (u32)(zone / SLAB_PAGE_SIZE));
+    heap.high_water = early;
+}
+
+void mem_get_stats(mem_stats_t *out) {
+    u64 daif = spin_lock_irqsave(&heap_lock);
+
+    heap_ready();
+
+    out->heap_base = heap.base;
+    out->heap_size = heap.end - heap.base;
+    out->permanent_used = heap.bottom - heap.base - permanent_free_bytes -
+        (u64)(heap.zone_pages - heap.zone_pages_used) * SLAB_PAGE_SIZE;
+    out->arena_used = heap.end - heap.top;
+    out->high_water = heap.high_water;
+    out->slab_pages_used = heap.zone_pages_used;
+    out->slab_pages_total = heap.zone_pages;
+
+    spin_unlock_irqrestore(&heap_lock, daif);
+}
+
+/* =========================
+ *  Permanent allocations
+ * ========================= */
+
+void *boot_alloc(size_t size) {
+    u64 daif = spin_lock_irqsave(&heap_lock);
+    void *p = NULL;
+
+    heap_ready();
+
+    size = ALIGN_UP(size, MEM_ALIGN);
+
+    /* first fit among freed blocks; a remainder stays on the list */
+    for (free_block_t **link = &permanent_free; *link; link = &(*link)->next) {
+        free_block_t *b = *link;
+
+        if (b->size < size)
+            continue;
+        if (b->size > size) {
+            free_block_t *rest = (free_block_t *)((uintptr_t)b + size);
+
+            rest->next = b->next;
+            rest->size = b->size - size;
+            *link = rest;
+        } else {
+            *link = b->next;
+        }
+        permanent_free_bytes -= size;
+        spin_unlock_irqrestore(&heap_lock, daif);
+        return b;
+    }
+
+    if (size <= heap.top - heap.bottom) {
+        p = (void *)heap.bottom;
+        heap.bottom += size;
+        heap_account();
+    }
+
+    spin_unlock_irqrestore(&heap_lock, daif);
+    return p;
+}
+
+void boot_free(void *ptr, size_t size) {
+    if (!ptr || !size)
+        return;
+
+    u64 daif = spin_lock_irqsave(&heap_lock);
+    uintptr_t at = (uintptr_t)ptr;
+
+    size = ALIGN_UP(size, MEM_ALIGN);
+    if (at + size == heap.bottom && at >= heap.base) {
+        heap.bottom = at;
+
+        /* freed blocks now at the end go back too */
+        for (free_block_t **link = &permanent_free; *link;) {
+            free_block_t *b = *link;
+
+            if ((uintptr_t)b + b->size == heap.bottom && (uintptr_t)b >= heap.base) {
+                heap.bottom = (uintptr_t)b;
+                permanent_free_bytes -= b->size;
+                *link = b->next;
+                link = &permanent_free;
+            } else {
+                link = &b->next;
+            }
+        }
+    } else {
+        free_block_t *b = ptr;
+
+        b->size = size;
+        b->next = permanent_free;
+        permanent_free = b;
+        permanent_free_bytes += size;
+    }
+
+    spin_unlock_irqrestore(&heap_lock, daif);
+}
+
+/* =========================
+ *  Stage arena
+ * ========================= */
+
+/* This core's arena when it has one of its own, else NULL (the heap's) */
+static inline u32 arena_cpu(void) {
+    u32 cpu = cpu_index();
+    return (cpu < OCM_MAX_CPUS && core_arena[cpu].end) ? cpu : 0;
+}
+
+void *arena_alloc(size_t size) {
+    u32 cpu = arena_cpu();
+
+    size = ALIGN_UP(size, MEM_ALIGN);
+
+    if (cpu) {
+        if (size > core_arena[cpu].top - core_arena[cpu].base)
+            return NULL;
+        core_arena[cpu].top -= size;
+        return (void *)core_arena[cpu].top;
+    }
+
+    u64 daif = spin_lock_irqsave(&heap_lock);
+    void *p = NULL;
+
+    heap_ready();
+    if (size <= heap.top - heap.bottom) {
+        heap.top -= size;
+        heap_account();
+        p = (void *)heap.top;
+    }
+
+    spin_unlock_irqrestore(&heap_lock, daif);
+    return p;
+}
+
+void *arena_alloc_zero(size_t size) {
+    void *p = arena_alloc(size);
+    if (p)
+        memset(p, 0, size);
+    return p;
+}
+
+arena_mark_t arena_mark(void) {
+    u32 cpu = arena_cpu();
+
+    if (cpu) {
+        arena_mark_t m = { core_arena[cpu].top };
+        return m;
+    }
+
+    heap_ready();
+
+    arena_mark_t m = { heap.top };
+    return m;
+}
+
+void arena_release(arena_mark_t mark) {
+    u32 cpu = arena_cpu();
+
+    if (cpu) {
+        if (mark.top > core_arena[cpu].top && mark.top <= core_arena[cpu].end)
+            core_arena[cpu].top = mark.top;
+        return;
+    }
+
+    u64 daif = spin_lock_irqsave(&heap_lock);
+
+    /* a reset since the mark already released more than we would */
+    if (mark.top > heap.top && mark.top <= heap.end)
+        heap.top = mark.top;
+
+    spin_unlock_irqrestore(&heap_lock, daif);
+}
+
+void arena_reset(void) {
+    u64 daif = spin_lock_irqsave(&heap_lock);
+
+    heap_ready();
+    heap.top = heap.end;
+    for (u32 i = 1; i < OCM_MAX_CPUS; i++)
+        core_arena[i].top = core_arena[i].end;
+
+    spin_unlock_irqrestore(&heap_lock, daif);
+}
+
+void arena_attach_cpu(u32 cpu, void *base, size_t size) {
+    if (cpu == 0 || cpu >= OCM_MAX_CPUS)
+        return;
+
+    uintptr_t b = ALIGN_UP((uintptr_t)base, MEM_ALIGN);
+    uintptr_t e = ALIGN_DOWN((uintptr_t)base + size, MEM_ALIGN);
+
+    core_arena[cpu].base = b;
+    core_arena[cpu].top = e > b ? e : b;
+    core_arena[cpu].end = core_arena[cpu].top;
+}
+
+/* =========================
+ *  Slabs
+ * ========================= */
+
+static inline int zone_index(const void *ptr) {
+    uintptr_t p = (uintptr_t)ptr;
+
+    if (!heap.zone || p < heap.zone ||
+        p >= heap.zone + (uintptr_t)heap.zone_pages_used * SLAB_PAGE_SIZE)
+        return -1;
+
+    return (int)((p - heap.zone) / SLAB_PAGE_SIZE);
+}
+
+void slab_cache_init(slab_cache_t *cache, const char *name, size_t obj_size) {
+    cache->name = name;
+    cache->obj_size = ALIGN_UP(obj_size, MEM_ALIGN);
+    cache->free_list = NULL;
+    cache->in_use = 0;
+    cache->peak = 0;
+    cache->pages = 0;
+}
+
+static int slab_grow(slab_cache_t *cache) {
+    if (heap.zone_pages_used >= heap.zone_pages ||
+        cache->obj_size > SLAB_PAGE_SIZE)
+        return -1;
+
+    u32 idx = heap.zone_pages_used++;
+    u8 *page = (u8 *)(heap.zone + (uintptr_t)idx * SLAB_PAGE_SIZE);
+    size_t n = SLAB_PAGE_SIZE / cache->obj_size;
+
+    zone_owner[idx] = cache;
+    cache->pages++;
+
+    /* thread the free list through the page, lowest address first */
+    for (size_t i = n; i-- > 0;) {
+        void **obj = (void **)(page + i * cache->obj_size);
+        *obj = cache->free_list;
+        cache->free_list = obj;
+    }
+
+    return 0;
+}
+
+void *slab_alloc(slab_cache_t *cache) {
+    u64 daif = spin_lock_irqsave(&heap_lock);
+
+    heap_ready();
+
+    if (!cache->free_list && slab_grow(cache) != 0) {
+        spin_unlock_irqrestore(&heap_lock, daif);
+        return arena_alloc(cache->obj_size);
+    }
+
+    void **obj = (void **)cache->free_list;
+    cache->free_list = *obj;
+
+    if (++cache->in_use > cache->peak)
+        cache->peak = cache->in_use;
+
+    spin_unlock_irqrestore(&heap_lock, daif);
+    return obj;
+}
+
+void slab_free(slab_cache_t *cache, void *ptr) {
+    u64 daif = spin_lock_irqsave(&heap_lock);
+    int idx = zone_index(ptr);
+
+    /* arena fallback or early heap: reclaimed by reset */
+    if (ptr && idx >= 0) {
+        /* trust the page table over the caller */
+        cache = zone_owner[idx];
+
+        *(void **)ptr = cache->free_list;
+        cache->free_list = ptr;
+        cache->in_use--;
+    }
+
+    spin_unlock_irqrestore(&heap_lock, daif);
+}
+
+/* =========================
+ *  Size-class front end
+ * ========================= */
+
+void *mem_alloc(size_t size) {
+    if (size == 0)
+        return NULL;
+    if (size <= 128)
+        return slab_alloc(&slab_128);
+    if (size <= 512)
+        return slab_alloc(&slab_512);
+    if (size <= 4096)
+        return slab_alloc(&slab_4k);
+    return arena_alloc(size);
+}
+
+void *mem_alloc_zero(size_t size) {
+    void *p = mem_alloc(size);
+    if (p)
+        memset(p, 0, size);
+    return p;
+}
+
+void mem_free(void *ptr) {
+    /* slab_free() finds the owner itself */
+    slab_free(NULL, ptr);
+}
+
+/* =========================
+ *  Self-test
+ * ========================= */
+
+#ifdef OCM_SELFTEST
+
+/*
+ * boot_free() on fresh blocks, with any blocks already on the free list
+ * set aside so first fit can only find the test's own. Leaves the heap
+ * as it found it.
+ */
+int mem_self_test(void) {
+    free_block_t *saved = permanent_free;
+    u64 saved_bytes = permanent_free_bytes;
+    int bad = 0;
+
+    permanent_free = NULL;
+    permanent_free_bytes = 0;
+
+    uintptr_t start = heap.bottom;
+    u8 *a, *b, *c, *d;
+    mem_stats_t before, after;
+
+    /* the last block goes straight back */
+    a = boot_alloc(64);
+    boot_free(a, 64);
+    if (heap.bottom != start || permanent_free)
+        bad = 1;
+
+    /* an older one is reused first fit, its remainder kept */
+    a = boot_alloc(256);
+    b = boot_alloc(64);
+    mem_get_stats(&before);
+    boot_free(a, 256);
+    mem_get_stats(&after);
+    if (before.permanent_used - after.permanent_used != 256)
+        bad = 1;
+    c = boot_alloc(128);
+    d = boot_alloc(120);            /* rounds up to the 128 left */
+    if (c != a || d != a + 128 || permanent_free || permanent_free_bytes)
+        bad = 1;
+
+    /* freeing the tail takes back every free block now at the end */
+    boot_free(c, 128);
+    boot_free(d, 120);
+    boot_free(b, 64);
+    if (heap.bottom != start || permanent_free || permanent_free_bytes)
+        bad = 1;
+
+    boot_free(NULL, 64);
+    if (heap.bottom != start)
+        bad = 1;
+
+    permanent_free = saved;
+    permanent_free_bytes = saved_bytes;
+    return bad ? -1 : 0;
+}
+
+#endif /* OCM_SELFTEST */
@@ -0,0 +1,115 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include "bootstd.h"
+#include "BootParams.h"
+
+/*
+ * OpenCore Mobile – boot allocator
+ *
+ * Everything is carved out of the largest usable region of the memory
+ * map handed over in ocm_boot_params:
+ *
+ *   [ slab zone | permanent (boot_alloc) -->   free   <-- stage arena ]
+ *
+ *  - boot_alloc():  lives until kernel handoff unless boot_free()d; the
+ *                   last block goes straight back, others are kept for
+ *                   reuse by later boot_alloc() calls
+ *  - arena_alloc(): lives until the next arena_reset(), which is O(1);
+ *                   error paths do not need to free anything
+ *  - slab_alloc():  fixed-size objects (sector buffers, partition
+ *                   devices) recycled through per-cache free lists
+ *
+ * Until mem_init() runs, a small static early heap backs all of this.
+ * Everything is safe to call from any core; see arena_attach_cpu() for
+ * what the arena means on secondaries.
+ */
+
+/* ---- slab caches ---- */
+
+typedef struct slab_cache {
+    const char *name;
+    size_t obj_size;
+    void *free_list;
+    u32 in_use;
+    u32 peak;
+    u32 pages;
+} slab_cache_t;
+
+/* Static initializer; rounds the object size like slab_cache_init() */
+#define SLAB_CACHE_INIT(name, size) \
+    { (name), (((size) + 15) & ~(size_t)15), NULL, 0, 0, 0 }
+
+/* Built-in caches used by mem_alloc() for small requests */
+extern slab_cache_t slab_128;
+extern slab_cache_t slab_512;       /* 512-byte sectors */
+extern slab_cache_t slab_4k;        /* 4 KiB sectors / pages */
+
+/* Define a cache for objects of `obj_size` bytes (16-byte aligned) */
+void slab_cache_init(slab_cache_t *cache, const char *name, size_t obj_size);
+
+/* Pop an object; falls back to the stage arena when the zone is full */
+void *slab_alloc(slab_cache_t *cache);
+
+/* Push an object back (objects from the arena fallback are ignored) */
+void slab_free(slab_cache_t *cache, void *ptr);
+
+/* ---- stage arena ---- */
+
+typedef struct {
+    uintptr_t top;
+} arena_mark_t;
+
+/* Allocate from the current stage (16-byte aligned) */
+void *arena_alloc(size_t size);
+void *arena_alloc_zero(size_t size);
+
+/* Nested scopes inside a stage */
+arena_mark_t arena_mark(void);
+void arena_release(arena_mark_t mark);
+
+/* Drop every arena allocation made since the last reset (O(1)), on every core */
+void arena_reset(void);
+
+/*
+ * Secondary cores get an arena of their own (Smp.c gives each one a
+ * boot_alloc() block), so work items can mark/release without racing the
+ * boot CPU's LIFO. It is private to `cpu`: whatever must outlive a work
+ * item belongs in boot_alloc() or in memory the submitter owns.
+ */
+void arena_attach_cpu(u32 cpu, void *base, size_t size);
+
+/* ---- general purpose ---- */
+
+/*
+ * Size-class front end: <= 4 KiB goes to a slab, larger requests to the
+ * stage arena. mem_free() returns slab objects and ignores the rest.
+ */
+void *mem_alloc(size_t size);
+void *mem_alloc_zero(size_t size);
+void mem_free(void *ptr);
+
+/* ---- setup / accounting ---- */
+
+typedef struct {
+    u64 heap_base;
+    u64 heap_size;
+    u64 permanent_used;     /* boot_alloc + slab pages handed out */
+    u64 arena_used;         /* current stage */
+    u64 high_water;         /* peak permanent + arena, i.e. RAM footprint */
+    u32 slab_pages_used;
+    u32 slab_pages_total;
+} mem_stats_t;
+
+/* Switch from the early heap to the boot memory map (call once). The
+ * stage that loaded us must mark our own image OCM_MEM_RESERVED. */
+void mem_init(const ocm_mem_region_t *map, u32 count);
+
+void mem_get_stats(mem_stats_t *out);
+
+#ifdef OCM_SELFTEST
+/* Check boot_free()'s reuse of freed blocks; 0 on success, -1 on failure */
+int mem_self_test(void);
+#endif
+
+#endif /* MEMORY_H */
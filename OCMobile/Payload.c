@@ -0,0 +1,821 @@
+#include "Payload.h"
+#include "BlockIo.h"
+#include "Memory.h"
+#include "Trace.h"
+#include "arch/aarch64/timer.h"
+#include "Platform/inflate/inflate.h"
+#include "Platform/lz4/lz4.h"
+#include "Platform/lzfse/lzfse.h"
+#include "Platform/lzss/lzss.h"
+
+/*
+ * OpenCore Mobile – kernelcache / ramdisk loader
+ * See Payload.h.
+ */
+
+/*
+ * Headroom before each chunk: what is left of one chunk moves there when
+ * the next is taken up, so an LZFSE block or an opcode never straddles
+ * the two. An LZFSE block within the format's symbol limits is under
+ * 128 KiB.
+ */
+#define PAYLOAD_CARRY           (256u << 10)
+
+/* fetches start on this, a multiple of any device block size for fs_map() */
+#define PAYLOAD_ALIGN           4096u
+
+/* read up front to recognise the containers */
+#define PAYLOAD_HEADER_SIZE     4096u
+
+/* Apple kernelcache header, big-endian, then the compressed bytes */
+#define COMP_MAGIC              0x636F6D70u     /* "comp" */
+#define COMP_LZSS               0x6C7A7373u     /* "lzss" */
+#define COMP_LZVN               0x6C7A766Eu     /* "lzvn" */
+#define COMP_HEADER_SIZE        0x180
+#define COMP_TYPE               4
+#define COMP_ADLER32            8
+#define COMP_UNCOMPRESSED       12
+#define COMP_COMPRESSED         16
+
+#define LZFSE_MAGIC_MASK        0x00FFFFFFu
+#define LZFSE_MAGIC             0x00787662u     /* "bvx", any block */
+
+#define LZ4_FRAME_MAGIC         0x184D2204u
+#define LZ4_LEGACY_MAGIC        0x184C2102u
+#define LZ4_SKIPPABLE_MAGIC     0x184D2A50u     /* low nibble free */
+#define LZ4_SKIPPABLE_MASK      0xFFFFFFF0u
+#define LZ4_FLG_VERSION(f)      ((f) >> 6)
+#define LZ4_FLG_BLOCK_CHECKSUM  0x10
+#define LZ4_FLG_CONTENT_SIZE    0x08
+#define LZ4_FLG_CONTENT_CHECKSUM 0x04
+#define LZ4_FLG_DICT_ID         0x01
+#define LZ4_BLOCK_UNCOMPRESSED  0x80000000u
+#define LZ4_LEGACY_BLOCK_MAX    (8u << 20)      /* decoded; compressed slightly more */
+#define LZ4_LEGACY_BOUND        (LZ4_LEGACY_BLOCK_MAX + LZ4_LEGACY_BLOCK_MAX / 255 + 16)
+
+/* DER tags of the IMG4 / IM4P wrappers */
+#define DER_INTEGER             0x02
+#define DER_OCTET_STRING        0x04
+#define DER_IA5_STRING          0x16
+#define DER_SEQUENCE            0x30
+
+static inline u32 le32(const u8 *p) {
+    return (u32)p[0] | (u32)p[1] << 8 | (u32)p[2] << 16 | (u32)p[3] << 24;
+}
+
+static inline u64 le64(const u8 *p) {
+    return (u64)le32(p + 4) << 32 | le32(p);
+}
+
+static inline u32 be32(const u8 *p) {
+    return (u32)p[0] << 24 | (u32)p[1] << 16 | (u32)p[2] << 8 | p[3];
+}
+
+static const char *codec_name(payload_codec_t codec) {
+    switch (codec) {
+    case PAYLOAD_LZSS:  return "lzss";
+    case PAYLOAD_LZVN:  return "lzvn";
+    case PAYLOAD_LZFSE: return "lzfse";
+    case PAYLOAD_LZ4:   return "lz4";
+    default:            return "raw";
+    }
+}
+
+/* =========================
+ *  Containers
+ * ========================= */
+
+/* Where the stored bytes are, and what checks them */
+typedef struct {
+    u64 offset;                 /* in the file */
+    bool has_adler;
+    u32 adler;                  /* of the decoded bytes */
+} layout_t;
+
+typedef struct {
+    u8 tag;
+    size_t header;              /* tag and length bytes */
+    u64 length;                 /* of the contents, which may run past the buffer */
+} der_t;
+
+static int der_read(const u8 *p, size_t avail, der_t *out) {
+    if (avail < 2)
+        return -1;
+
+    out->tag = p[0];
+    if (p[1] < 0x80) {
+        out->header = 2;
+        out->length = p[1];
+        return 0;
+    }
+
+    /* long form; nothing here needs more than 4 GiB */
+    size_t n = p[1] & 0x7F;
+    if (!n || n > 4 || avail < 2 + n)
+        return -1;
+    out->header = 2 + n;
+    out->length = 0;
+    for (size_t i = 0; i < n; i++)
+        out->length = out->length << 8 | p[2 + i];
+    return 0;
+}
+
+/* An element of `tag` at head[*pos], wholly inside head[0, n) unless `open` */
+static int der_expect(const u8 *head, size_t n, size_t *pos, u8 tag, bool open, der_t *out) {
+    if (*pos > n || der_read(head + *pos, n - *pos, out) != 0 || out->tag != tag)
+        return -1;
+    if (!open && out->length > n - *pos - out->header)
+        return -1;
+    return 0;
+}
+
+static bool der_is(const u8 *head, size_t pos, const der_t *e, const char *s) {
+    return e->length == 4 && memcmp(head + pos + e->header, s, 4) == 0;
+}
+
+/*
+ * SEQUENCE { "IM4P", type, description, OCTET STRING payload, ... },
+ * possibly inside SEQUENCE { "IMG4", that, ... }. 1 and the payload's
+ * extent if `head` opens one, 0 if it does not, -1 if it is malformed.
+ */
+static int parse_im4p(const u8 *head, size_t n, payload_info_t *info, u64 *offset, u64 *length) {
+    size_t pos = 0;
+    der_t e;
+
+    if (der_expect(head, n, &pos, DER_SEQUENCE, true, &e) != 0)
+        return 0;
+    pos += e.header;
+    if (der_expect(head, n, &pos, DER_IA5_STRING, false, &e) != 0)
+        return 0;
+
+    if (der_is(head, pos, &e, "IMG4")) {
+        pos += e.header + (size_t)e.length;
+        if (der_expect(head, n, &pos, DER_SEQUENCE, true, &e) != 0)
+            return -1;
+        pos += e.header;
+        if (der_expect(head, n, &pos, DER_IA5_STRING, false, &e) != 0)
+            return -1;
+    }
+    if (!der_is(head, pos, &e, "IM4P"))
+        return 0;
+    pos += e.header + (size_t)e.length;
+
+    /* type, then a free-form description */
+    if (der_expect(head, n, &pos, DER_IA5_STRING, false, &e) != 0 || e.length != 4)
+        return -1;
+    memcpy(info->type, head + pos + e.header, 4);
+    info->type[4] = '\0';
+    pos += e.header + (size_t)e.length;
+    if (der_expect(head, n, &pos, DER_IA5_STRING, false, &e) != 0)
+        return -1;
+    pos += e.header + (size_t)e.length;
+
+    if (der_expect(head, n, &pos, DER_OCTET_STRING, true, &e) != 0)
+        return -1;
+    *offset = pos + e.header;
+    *length = e.length;
+    return 1;
+}
+
+/* An INTEGER of up to 8 bytes at tail[*pos] */
+static int der_integer(const u8 *tail, size_t n, size_t *pos, u64 *out) {
+    der_t e;
+
+    if (der_expect(tail, n, pos, DER_INTEGER, false, &e) != 0 || !e.length || e.length > 8)
+        return -1;
+    *out = 0;
+    for (size_t i = 0; i < e.length; i++)
+        *out = *out << 8 | tail[*pos + e.header + i];
+    *pos += e.header + (size_t)e.length;
+    return 0;
+}
+
+static size_t read_at(file_t *file, u64 offset, void *buf, size_t size) {
+    if (fs_seek(file, offset) != 0)
+        return 0;
+    return fs_read(file, buf, size);
+}
+
+/* What the bytes at the payload's start say it is */
+static status_t detect(const u8 *head, size_t n, payload_info_t *info, layout_t *layout) {
+    if (n >= COMP_HEADER_SIZE && be32(head) == COMP_MAGIC) {
+        u32 type = be32(head + COMP_TYPE);
+        u64 stored = be32(head + COMP_COMPRESSED);
+
+        if (type == COMP_LZSS) {
+            info->codec = PAYLOAD_LZSS;
+        } else if (type == COMP_LZVN) {
+            info->codec = PAYLOAD_LZVN;
+        } else {
+            printf("payload: comp type %x not supported\n", type);
+            return STATUS_ERROR;
+        }
+        if (stored > info->stored - COMP_HEADER_SIZE)
+            return STATUS_ERROR;
+
+        layout->has_adler = true;
+        layout->adler = be32(head + COMP_ADLER32);
+        layout->offset += COMP_HEADER_SIZE;
+        info->expected = be32(head + COMP_UNCOMPRESSED);
+        info->stored = stored;
+        return STATUS_SUCCESS;
+    }
+
+    if (n < 4) {
+        info->codec = PAYLOAD_RAW;
+        return STATUS_SUCCESS;
+    }
+
+    u32 magic = le32(head);
+    if ((magic & LZFSE_MAGIC_MASK) == LZFSE_MAGIC) {
+        info->codec = PAYLOAD_LZFSE;
+    } else if (magic == LZ4_FRAME_MAGIC) {
+        info->codec = PAYLOAD_LZ4;
+        if (n >= 14 && (head[4] & LZ4_FLG_CONTENT_SIZE))
+            info->expected = le64(head + 6);
+    } else if (magic == LZ4_LEGACY_MAGIC || (magic & LZ4_SKIPPABLE_MASK) == LZ4_SKIPPABLE_MAGIC) {
+        info->codec = PAYLOAD_LZ4;
+    } else {
+        info->codec = PAYLOAD_RAW;
+    }
+    return STATUS_SUCCESS;
+}
+
+static status_t parse(file_t *file, payload_info_t *info, layout_t *layout) {
+    u64 size = fs_size(file);
+    u8 *head = arena_alloc(PAYLOAD_HEADER_SIZE);
+    size_t n;
+
+    memset(info, 0, sizeof(*info));
+    memset(layout, 0, sizeof(*layout));
+    info->stored = size;
+    if (!head)
+        return STATUS_OUT_OF_MEMORY;
+
+    n = read_at(file, 0, head, PAYLOAD_HEADER_SIZE);
+    if (n && head[0] == DER_SEQUENCE) {
+        u64 offset, length;
+        int found = parse_im4p(head, n, info, &offset, &length);
+
+        if (found < 0 || (found && (offset > size || length > size - offset))) {
+            printf("payload: malformed IM4P\n");
+            return STATUS_ERROR;
+        }
+        if (found) {
+            /* after the payload: a KBAG if it is encrypted, the decoded size if compressed */
+            u8 tail[32];
+            size_t t = read_at(file, offset + length, tail, sizeof(tail)), pos = 0;
+            der_t e;
+
+            if (t && tail[0] == DER_OCTET_STRING) {
+                printf("payload: %s payload is encrypted\n", info->type);
+                return STATUS_ERROR;
+            }
+            if (der_expect(tail, t, &pos, DER_SEQUENCE, false, &e) == 0) {
+                u64 algorithm, decoded;
+                pos += e.header;
+                if (der_integer(tail, t, &pos, &algorithm) == 0 &&
+                    der_integer(tail, t, &pos, &decoded) == 0)
+                    info->expected = decoded;
+            }
+
+            info->img4 = true;
+            info->stored = length;
+            layout->offset = offset;
+            n = read_at(file, offset, head, length < PAYLOAD_HEADER_SIZE ? (size_t)length : PAYLOAD_HEADER_SIZE);
+        }
+    }
+
+    return detect(head, n, info, layout);
+}
+
+/* =========================
+ *  Reader
+ * ========================= */
+
+/*
+ * Two chunks alternate: the decoder works through one while the other is
+ * in flight. Taking up the next one moves the unconsumed tail of the
+ * current one into the next one's headroom and refetches the drained one.
+ */
+typedef struct {
+    u8 *data;                   /* PAYLOAD_CARRY bytes of headroom precede it */
+    size_t len;                 /* valid once `io` is done */
+    block_device_t *dev;        /* `io` is in flight on it; NULL if none */
+    block_io_t io;
+} chunk_t;
+
+typedef struct {
+    file_t *file;
+    u64 next;                   /* file offset of the next fetch */
+    u64 end;                    /* where the stored bytes stop */
+    u64 left;                   /* stored bytes not consumed yet */
+    const u8 *p, *limit;        /* unconsumed bytes at hand */
+    chunk_t chunk[2];
+    u32 cur;
+    u64 wait_ticks;
+    status_t status;
+} reader_t;
+
+static void fetch(reader_t *r, chunk_t *c) {
+    u64 want = r->end - r->next;
+    fs_extent_t ext;
+
+    c->len = 0;
+    if (!want || r->status != STATUS_SUCCESS)
+        return;
+    if (want > PAYLOAD_CHUNK)
+        want = PAYLOAD_CHUNK;
+
+    u64 t0 = timer_ticks();
+
+    if (fs_map(r->file, r->next, &ext) == 0 && ext.device->block_size &&
+        PAYLOAD_CHUNK % ext.device->block_size == 0) {
+        block_device_t *dev = ext.device;
+        u32 bs = dev->block_size;
+
+        /* one request per chunk: stop at the end of the run or the transfer limit */
+        if (ext.length < want)
+            want = ext.length;
+        u64 blocks = (want + bs - 1) / bs;
+        if (dev->max_transfer_blocks && blocks > dev->max_transfer_blocks) {
+            blocks = dev->max_transfer_blocks;
+            want = blocks * bs;
+        }
+
+        c->io.lba = ext.lba;
+        c->io.count = (u32)blocks;
+        c->io.flags = 0;
+        c->io.buffer = c->data;
+        if (block_submit(dev, &c->io) >= 0) {
+            c->dev = dev;
+            c->len = (size_t)want;
+            r->next += want;
+            r->wait_ticks += timer_ticks() - t0;
+            return;
+        }
+    }
+
+    /* no plain run (or the device refused it): read it now */
+    if (read_at(r->file, r->next, c->data, (size_t)want) != want)
+        r->status = STATUS_ERROR;
+    c->len = (size_t)want;
+    r->next += want;
+    r->wait_ticks += timer_ticks() - t0;
+}
+
+static void settle(reader_t *r, chunk_t *c) {
+    if (!c->dev)
+        return;
+
+    u64 t0 = timer_ticks();
+    if (block_wait(c->dev, &c->io) != STATUS_SUCCESS)
+        r->status = STATUS_ERROR;
+    r->wait_ticks += timer_ticks() - t0;
+    c->dev = NULL;
+}
+
+/*
+ * Put at least min(n, r->left) bytes (n <= PAYLOAD_CARRY) at r->p and
+ * return how many are at hand, at most r->left; 0 with r->status set if
+ * the reads fail or the file ends first.
+ */
+static size_t reader_need(reader_t *r, size_t n) {
+    if (n > r->left)
+        n = (size_t)r->left;
+
+    while ((size_t)(r->limit - r->p) < n) {
+        chunk_t *c = &r->chunk[r->cur ^ 1];
+        size_t rest = (size_t)(r->limit - r->p);
+
+        settle(r, c);
+        if (r->status == STATUS_SUCCESS && !c->len)
+            r->status = STATUS_ERROR;
+        if (r->status != STATUS_SUCCESS)
+            return 0;
+
+        if (rest)
+            memcpy(c->data - rest, r->p, rest);
+        r->p = c->data - rest;
+        r->limit = c->data + c->len;
+        r->cur ^= 1;
+        fetch(r, &r->chunk[r->cur ^ 1]);
+    }
+
+    size_t avail = (size_t)(r->limit - r->p);
+    return avail < r->left ? avail : (size_t)r->left;
+}
+
+static inline void reader_consume(reader_t *r, size_t n) {
+    r->p += n;
+    r->left -= n;
+}
+
+/* Copy `len` stored bytes to `dst` (NULL: drop them) */
+static status_t reader_copy(reader_t *r, u8 *dst, u64 len) {
+    while (len) {
+        size_t n = reader_need(r, 1);
+        if (!n)
+            return r->status != STATUS_SUCCESS ? r->status : STATUS_ERROR;
+        if (n > len)
+            n = (size_t)len;
+        if (dst) {
+            memcpy(dst, r->p, n);
+            dst += n;
+        }
+        reader_consume(r, n);
+        len -= n;
+    }
+    return STATUS_SUCCESS;
+}
+
+static status_t reader_start(reader_t *r, file_t *file, u64 offset, u64 stored) {
+    memset(r, 0, sizeof(*r));
+    r->file = file;
+    r->next = offset & ~(u64)(PAYLOAD_ALIGN - 1);
+    r->end = offset + stored;
+    r->left = r->end - r->next;
+    r->status = STATUS_SUCCESS;
+
+    for (u32 i = 0; i < 2; i++) {
+        u8 *base = arena_alloc(PAYLOAD_CARRY + PAYLOAD_CHUNK);
+        if (!base)
+            return STATUS_OUT_OF_MEMORY;
+        r->chunk[i].data = base + PAYLOAD_CARRY;
+    }
+
+    /* chunk 0 first; chunk 1 goes out as soon as 0 is taken up */
+    r->cur = 1;
+    fetch(r, &r->chunk[0]);
+    return reader_copy(r, NULL, offset - (offset & ~(u64)(PAYLOAD_ALIGN - 1)));
+}
+
+/* Nothing may still be landing in the chunks once the arena takes them back */
+static void reader_stop(reader_t *r) {
+    settle(r, &r->chunk[0]);
+    settle(r, &r->chunk[1]);
+}
+
+/* =========================
+ *  Decoders
+ * ========================= */
+
+static status_t reader_failed(reader_t *r) {
+    return r->status != STATUS_SUCCESS ? r->status : STATUS_ERROR;
+}
+
+static status_t decode_lzss(reader_t *r, u8 *dst, size_t capacity, size_t *size) {
+    lzss_stream_t s = { dst, capacity, 0 };
+
+    while (r->left) {
+        size_t n = reader_need(r, LZSS_MAX_GROUP), used;
+        if (!n)
+            return reader_failed(r);
+        if (lzss_decode(&s, r->p, n, n == r->left, &used) != 0)
+            return STATUS_OUT_OF_RANGE;
+        reader_consume(r, used);
+    }
+
+    *size = s.pos;
+    return STATUS_SUCCESS;
+}
+
+/* Up to `length` stored bytes through `s`, stopping after end of stream */
+static status_t feed_lzvn(reader_t *r, lzvn_stream_t *s, u64 length) {
+    while (length) {
+        size_t n = reader_need(r, LZVN_MAX_OPCODE), used;
+        if (!n)
+            return reader_failed(r);
+        if (n > length)
+            n = (size_t)length;
+
+        int result = lzvn_decode(s, r->p, n, &used);
+        reader_consume(r, used);
+        length -= used;
+        if (result < 0)
+            return s->pos == s->capacity ? STATUS_OUT_OF_RANGE : STATUS_ERROR;
+        if (result > 0)
+            return reader_copy(r, NULL, length);    /* padding after the end */
+        if (!used)
+            return STATUS_ERROR;                    /* an opcode cut short */
+    }
+    return STATUS_SUCCESS;
+}
+
+static status_t decode_lzvn(reader_t *r, u8 *dst, size_t capacity, size_t *size) {
+    lzvn_stream_t s = { dst, capacity, 0, 0 };
+    status_t status = feed_lzvn(r, &s, r->left);
+
+    *size = s.pos;
+    return status;
+}
+
+static status_t decode_lzfse(reader_t *r, u8 *dst, size_t capacity, size_t *size) {
+    size_t pos = 0;
+    status_t status;
+
+    for (;;) {
+        lzfse_block_t block;
+        size_t n = reader_need(r, 32);
+
+        if (!n)
+            return reader_failed(r);
+        if (lzfse_block_info(r->p, n, &block) != 0)
+            return STATUS_ERROR;
+        if (block.raw_size > capacity - pos)
+            return STATUS_OUT_OF_RANGE;
+
+        switch (block.magic) {
+        case LZFSE_BLOCK_END:
+            reader_consume(r, block.size);
+            *size = pos;
+            return STATUS_SUCCESS;
+
+        case LZFSE_BLOCK_STORED:
+            reader_consume(r, block.header_size);
+            status = reader_copy(r, dst + pos, block.raw_size);
+            pos += block.raw_size;
+            break;
+
+        case LZFSE_BLOCK_LZVN: {
+            lzvn_stream_t s = { dst, pos + block.raw_size, pos, 0 };
+
+            reader_consume(r, block.header_size);
+            status = feed_lzvn(r, &s, block.size - block.header_size);
+            if (status == STATUS_SUCCESS && s.pos != pos + block.raw_size)
+                status = STATUS_ERROR;
+            pos = s.pos;
+            break;
+        }
+
+        default:
+            /* whole blocks only: the headroom holds any the format allows */
+            if (block.size > PAYLOAD_CARRY)
+                return STATUS_ERROR;
+            if (reader_need(r, block.size) < block.size)
+                return reader_failed(r);
+            if (lzfse_decode_block(&block, r->p, dst, capacity, &pos) != 0)
+                return STATUS_ERROR;
+            reader_consume(r, block.size);
+            status = STATUS_SUCCESS;
+            break;
+        }
+
+        if (status != STATUS_SUCCESS)
+            return status;
+    }
+}
+
+/*
+ * `length` stored bytes of one block through `s`. Tokens with long
+ * length extensions need more than a handful of bytes together, so ask
+ * for more whenever the decoder stalls.
+ */
+static status_t feed_lz4(reader_t *r, lz4_stream_t *s, u64 length) {
+    size_t want = 16;
+
+    while (length) {
+        size_t n = reader_need(r, want), used;
+        if (!n)
+            return reader_failed(r);
+        if (n > length)
+            n = (size_t)length;
+
+        int result = lz4_stream_decode(s, r->p, n, &used);
+        if (result)
+            return result == -2 ? STATUS_OUT_OF_RANGE : STATUS_ERROR;
+        reader_consume(r, used);
+        length -= used;
+        if (used) {
+            want = 16;
+        } else {
+            if (n == length || want == PAYLOAD_CARRY)
+                return STATUS_ERROR;
+            want = want * 2 < PAYLOAD_CARRY ? want * 2 : PAYLOAD_CARRY;
+        }
+    }
+
+    return lz4_stream_end(s) == 0 ? STATUS_SUCCESS : STATUS_ERROR;
+}
+
+/* Blocks of [u32 size][data] until the next magic or the file's end */
+static status_t decode_lz4_legacy(reader_t *r, lz4_stream_t *s) {
+    while (r->left) {
+        size_t n = reader_need(r, 4);
+        if (n < 4)
+            return reader_failed(r);
+
+        u32 csize = le32(r->p);
+        if (csize == LZ4_LEGACY_MAGIC || csize == LZ4_FRAME_MAGIC)
+            break;
+
+        /* a size and nothing after it: the decoded length the kernel build appends */
+        reader_consume(r, 4);
+        if (!r->left)
+            break;
+        if (csize > LZ4_LEGACY_BOUND || csize > r->left)
+            return STATUS_ERROR;
+
+        status_t status = feed_lz4(r, s, csize);
+        if (status != STATUS_SUCCESS)
+            return status;
+    }
+    return STATUS_SUCCESS;
+}
+
+static status_t decode_lz4_frame(reader_t *r, lz4_stream_t *s) {
+    size_t n = reader_need(r, 19);
+    status_t status;
+
+    if (n < 7)
+        return reader_failed(r);
+
+    u8 flg = r->p[4];
+    size_t header = 7 + (flg & LZ4_FLG_CONTENT_SIZE ? 8 : 0) + (flg & LZ4_FLG_DICT_ID ? 4 : 0);
+    if (LZ4_FLG_VERSION(flg) != 1 || (flg & LZ4_FLG_DICT_ID) || n < header)
+        return STATUS_ERROR;
+    reader_consume(r, header);
+
+    for (;;) {
+        if (reader_need(r, 4) < 4)
+            return reader_failed(r);
+
+        u32 bsize = le32(r->p);
+        u64 len = bsize & ~LZ4_BLOCK_UNCOMPRESSED;
+        reader_consume(r, 4);
+        if (!bsize)
+            break;
+        if (len > r->left)
+            return STATUS_ERROR;
+
+        if (bsize & LZ4_BLOCK_UNCOMPRESSED) {
+            if (len > s->capacity - s->pos)
+                return STATUS_OUT_OF_RANGE;
+            status = reader_copy(r, s->dst + s->pos, len);
+            s->pos += (size_t)len;
+        } else {
+            /* linked blocks reach back into earlier ones: dst is the history either way */
+            status = feed_lz4(r, s, len);
+        }
+        if (status == STATUS_SUCCESS && (flg & LZ4_FLG_BLOCK_CHECKSUM))
+            status = reader_copy(r, NULL, 4);
+        if (status != STATUS_SUCCESS)
+            return status;
+    }
+
+    return flg & LZ4_FLG_CONTENT_CHECKSUM ? reader_copy(r, NULL, 4) : STATUS_SUCCESS;
+}
+
+/* Frames of either kind, one after another */
+static status_t decode_lz4(reader_t *r, u8 *dst, size_t capacity, size_t *size) {
+    lz4_stream_t s;
+    status_t status = STATUS_SUCCESS;
+
+    lz4_stream_init(&s, dst, capacity);
+    while (r->left && status == STATUS_SUCCESS) {
+        size_t n = reader_need(r, 8);
+        if (n < 4)
+            return reader_failed(r);
+
+        u32 magic = le32(r->p);
+        if (magic == LZ4_LEGACY_MAGIC) {
+            reader_consume(r, 4);
+            status = decode_lz4_legacy(r, &s);
+        } else if (magic == LZ4_FRAME_MAGIC) {
+            status = decode_lz4_frame(r, &s);
+        } else if ((magic & LZ4_SKIPPABLE_MASK) == LZ4_SKIPPABLE_MAGIC && n >= 8) {
+            u32 skip = le32(r->p + 4);
+            reader_consume(r, 8);
+            status = reader_copy(r, NULL, skip);
+        } else {
+            status = STATUS_ERROR;
+        }
+    }
+
+    *size = s.pos;
+    return status;
+}
+
+/* =========================
+ *  Loading
+ * ========================= */
+
+static u32 mb_per_s(u64 bytes, u64 ticks) {
+    u64 freq = timer_frequency();
+
+    if (!ticks || !freq)
+        return 0;
+    return (u32)(bytes * freq / ticks / 1000000);
+}
+
+static void report(const char *name, const payload_info_t *info) {
+    char buf[OCM_TRACE_NAME_LEN + 1];
+    u32 read = mb_per_s(info->stored, info->ticks);
+
+    trace_label(buf, name, " read");
+    trace_mark(buf, read);
+
+    if (info->codec == PAYLOAD_RAW) {
+        printf("payload: %s: %u KiB, read %u MB/s\n", name, (u32)(info->size >> 10), read);
+        return;
+    }
+
+    u32 decode = mb_per_s(info->size, info->ticks - info->wait_ticks);
+    trace_label(buf, name, " decode");
+    trace_mark(buf, decode);
+    printf("payload: %s: %u KiB %s%s -> %u KiB, read %u MB/s, decode %u MB/s\n",
+           name, (u32)(info->stored >> 10), info->img4 ? "im4p/" : "", codec_name(info->codec),
+           (u32)(info->size >> 10), read, decode);
+}
+
+static status_t load_raw(file_t *file, const layout_t *layout, payload_info_t *info,
+                         u8 *dst, size_t capacity, size_t *size) {
+    if (info->stored > capacity)
+        return STATUS_OUT_OF_RANGE;
+
+    /* one fs_read(): the drivers already issue a request per on-disk run */
+    u64 t0 = timer_ticks();
+    size_t n = read_at(file, layout->offset, dst, (size_t)info->stored);
+    info->wait_ticks = timer_ticks() - t0;
+    if (n != info->stored)
+        return STATUS_ERROR;
+
+    *size = n;
+    return STATUS_SUCCESS;
+}
+
+static status_t load_compressed(file_t *file, const layout_t *layout, payload_info_t *info,
+                                u8 *dst, size_t capacity, size_t *size) {
+    reader_t r;
+    status_t status = reader_start(&r, file, layout->offset, info->stored);
+
+    if (status == STATUS_SUCCESS) {
+        switch (info->codec) {
+        case PAYLOAD_LZSS:  status = decode_lzss(&r, dst, capacity, size);  break;
+        case PAYLOAD_LZVN:  status = decode_lzvn(&r, dst, capacity, size);  break;
+        case PAYLOAD_LZFSE: status = decode_lzfse(&r, dst, capacity, size); break;
+        default:            status = decode_lz4(&r, dst, capacity, size);   break;
+        }
+    }
+
+    reader_stop(&r);
+    info->wait_ticks = r.wait_ticks;
+    return status;
+}
+
+status_t payload_probe(fs_t *fs, const char *path, payload_info_t *info) {
+    arena_mark_t mark = arena_mark();
+    layout_t layout;
+    file_t file;
+
+    if (fs_open(fs, path, &file) != 0)
+        return STATUS_NOT_FOUND;
+
+    status_t status = parse(&file, info, &layout);
+    fs_close(&file);
+    arena_release(mark);
+    return status;
+}
+
+status_t payload_load(fs_t *fs, const char *path, const char *name,
+                      void *dst, size_t capacity, payload_info_t *info) {
+    arena_mark_t mark = arena_mark();
+    payload_info_t local;
+    layout_t layout;
+    file_t file;
+    size_t size = 0;
+    status_t status;
+
+    if (!info)
+        info = &local;
+    if (fs_open(fs, path, &file) != 0)
+        return STATUS_NOT_FOUND;
+
+    u64 t0 = timer_ticks();
+    trace_begin(name);
+
+    status = parse(&file, info, &layout);
+    if (status == STATUS_SUCCESS && info->expected > capacity)
+        status = STATUS_OUT_OF_RANGE;
+    if (status == STATUS_SUCCESS) {
+        status = info->codec == PAYLOAD_RAW
+            ? load_raw(&file, &layout, info, dst, capacity, &size)
+            : load_compressed(&file, &layout, info, dst, capacity, &size);
+    }
+    if (status == STATUS_SUCCESS &&
+        ((info->expected && size != info->expected) ||
+         (layout.has_adler && adler32_update(1, dst, size) != layout.adler)))
+        status = STATUS_CRC_ERROR;
+
+    info->size = status == STATUS_SUCCESS ? size : 0;
+    info->ticks = timer_ticks() - t0;
+    fs_close(&file);
+    arena_release(mark);
+
+    trace_end(name, info->size);
+    if (status == STATUS_SUCCESS)
+        report(name, info);
+    else
+        printf("payload: %s: loading %s failed (%d)\n", name, path, status);
+    return status;
+}
@@ -0,0 +1,66 @@
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+#include <stdbool.h>
+
+#include "bootstd.h"
+
+/*
+ * OpenCore Mobile – kernelcache / ramdisk loader
+ *
+ * Loads a file to its final address, decompressing on the way: the
+ * compressed bytes pass through two PAYLOAD_CHUNK buffers and are decoded
+ * straight into the destination, which doubles as the codecs' history, so
+ * no full-size intermediate copy ever exists. While one buffer is decoded
+ * the block layer fills the other (block_submit() on the runs fs_map()
+ * reports; files without plain runs fall back to fs_read()).
+ *
+ * Recognised, outermost first:
+ *   IMG4 / IM4P     DER wrapper, unwrapped; encrypted (KBAG) payloads fail
+ *   "comp"          Apple kernelcache header, "lzss" or "lzvn", Adler-32 checked
+ *   "bvx?"          LZFSE stream (any mix of LZFSE, LZVN and stored blocks)
+ *   LZ4             frame format, or the legacy format the Linux tools write
+ * and anything else is loaded as it is, with a single fs_read().
+ *
+ * Each load records "<name>" begin/end (arg: bytes loaded) and two marks
+ * with MB/s: "<name> read", compressed bytes over the whole load, and
+ * "<name> decode", bytes produced over the time not spent waiting for the
+ * disk. The two buffers come from the stage arena and are given back
+ * before returning.
+ */
+
+#define PAYLOAD_CHUNK           (512u << 10)
+
+typedef enum {
+    PAYLOAD_RAW,
+    PAYLOAD_LZSS,
+    PAYLOAD_LZVN,
+    PAYLOAD_LZFSE,
+    PAYLOAD_LZ4
+} payload_codec_t;
+
+typedef struct {
+    payload_codec_t codec;
+    bool img4;                  /* unwrapped from an IMG4 / IM4P */
+    char type[5];               /* IM4P type ("krnl", "rdsk"), "" otherwise */
+    u64 stored;                 /* compressed bytes in the file */
+    u64 expected;               /* decoded size the headers state, 0 if none do */
+    u64 size;                   /* bytes loaded (payload_load() only) */
+    u64 ticks;                  /* CNTVCT_EL0 ticks the load took */
+    u64 wait_ticks;             /* of which spent waiting for reads */
+} payload_info_t;
+
+/* Look at `path`'s headers without loading it (size the destination by `expected`) */
+status_t payload_probe(fs_t *fs, const char *path, payload_info_t *info);
+
+/*
+ * Load `path` into dst[0, capacity), decoded. `name` labels the trace
+ * events and console line ("kernelcache", "ramdisk"). STATUS_OUT_OF_RANGE
+ * if it does not fit, STATUS_CRC_ERROR on a bad checksum or a size other
+ * than the headers state, STATUS_ERROR on corrupt data or a failed read.
+ * `info` may be NULL.
+ */
+status_t payload_load(fs_t *fs, const char *path, const char *name,
+                      void *dst, size_t capacity, payload_info_t *info);
+
+#endif /* PAYLOAD_H */
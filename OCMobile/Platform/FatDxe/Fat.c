@@ -0,0 +1,884 @@
+#include "Fat.h"
+#include "../../Memory.h"
+
+/*
+ * OpenCore Mobile – FAT32 / exFAT, read-only
+ *
+ * See Fat.h. All on-disk values are little-endian.
+ */
+
+/* =========================
+ *  On-disk layout
+ * ========================= */
+
+/* FAT32 boot sector / BPB */
+#define BPB_BYTES_PER_SECTOR    11
+#define BPB_SECTORS_PER_CLUSTER 13
+#define BPB_RESERVED_SECTORS    14
+#define BPB_NUM_FATS            16
+#define BPB_ROOT_ENTRIES        17
+#define BPB_TOTAL_SECTORS_16    19
+#define BPB_FAT_SIZE_16         22
+#define BPB_TOTAL_SECTORS_32    32
+#define BPB_FAT_SIZE_32         36
+#define BPB_EXT_FLAGS           40
+#define BPB_ROOT_CLUSTER        44
+#define BS_SIGNATURE            510
+#define BOOT_SIGNATURE          0xAA55
+
+#define EXT_FLAGS_NO_MIRROR     0x80        /* only the active FAT is kept up to date */
+#define EXT_FLAGS_ACTIVE_FAT    0x0F
+
+/* exFAT boot sector */
+#define EXFAT_NAME              3           /* "EXFAT   " */
+#define EXFAT_FAT_OFFSET        80          /* sectors */
+#define EXFAT_FAT_LENGTH        84
+#define EXFAT_HEAP_OFFSET       88
+#define EXFAT_CLUSTER_COUNT     92
+#define EXFAT_ROOT_CLUSTER      96
+#define EXFAT_VOLUME_FLAGS      106
+#define EXFAT_SECTOR_SHIFT      108
+#define EXFAT_CLUSTER_SHIFT     109
+#define EXFAT_NUM_FATS          110
+
+#define EXFAT_ACTIVE_FAT        0x0001      /* VolumeFlags: second FAT in use */
+
+/* FAT entries */
+#define FAT_FIRST_CLUSTER       2
+#define FAT32_MASK              0x0FFFFFFF  /* the top nibble is reserved */
+#define FAT32_END               0x0FFFFFF8  /* this and above end a chain */
+#define EXFAT_END               0xFFFFFFF8
+
+/* FAT32 directory entries */
+#define DIR_ENTRY_SIZE          32
+#define DIR_NAME                0           /* 8.3, space padded */
+#define DIR_ATTR                11
+#define DIR_CLUSTER_HI          20
+#define DIR_CLUSTER_LO          26
+#define DIR_FILE_SIZE           28
+
+#define DIR_END                 0x00        /* DIR_NAME[0]: no entries follow */
+#define DIR_FREE                0xE5
+#define DIR_KANJI_E5            0x05        /* a name that really starts with 0xE5 */
+
+#define ATTR_VOLUME_ID          0x08
+#define ATTR_DIRECTORY          0x10
+#define ATTR_LONG_NAME          0x0F
+
+/* VFAT long name entries, last part first */
+#define LFN_ORDER               0
+#define LFN_LAST                0x40
+#define LFN_CHECKSUM            13
+#define LFN_CHARS               13
+#define LFN_MAX_PARTS           20          /* 255 characters */
+
+static const u8 lfn_offsets[LFN_CHARS] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+
+/* exFAT directory entries */
+#define EXFAT_IN_USE            0x80        /* EntryType bit */
+#define EXFAT_TYPE_FILE         0x85
+#define EXFAT_TYPE_STREAM       0xC0
+#define EXFAT_TYPE_NAME         0xC1
+
+#define EXFAT_SECONDARY_COUNT   1           /* file entry */
+#define EXFAT_FILE_ATTR         4
+#define EXFAT_STREAM_FLAGS      1           /* stream extension entry */
+#define EXFAT_NAME_LENGTH       3
+#define EXFAT_VALID_LENGTH      8
+#define EXFAT_FIRST_CLUSTER     20
+#define EXFAT_DATA_LENGTH       24
+#define EXFAT_NAME_CHARS        15          /* file name entry, from byte 2 */
+
+#define EXFAT_NO_FAT_CHAIN      0x02
+
+/* =========================
+ *  Limits
+ * ========================= */
+
+/* Cluster chains remembered per volume, and the runs one may have */
+#ifndef FAT_CHAIN_CACHE
+#define FAT_CHAIN_CACHE         16
+#endif
+#ifndef FAT_CHAIN_RUNS
+#define FAT_CHAIN_RUNS          32
+#endif
+
+/* Resolved directory entries remembered per volume */
+#ifndef FAT_NAME_CACHE
+#define FAT_NAME_CACHE          64
+#endif
+
+/* FAT bytes read at once while walking a chain */
+#ifndef FAT_WINDOW_SIZE
+#define FAT_WINDOW_SIZE         8192
+#endif
+
+#define FAT_DIR_WINDOW          4096        /* directory bytes read at once */
+#define FAT_NAME_MAX            255         /* UTF-16 units */
+#define FAT_CACHED_NAME_MAX     40          /* longer names are looked up every time */
+#define FAT_MAX_DEPTH           32
+
+/* =========================
+ *  In-memory state
+ * ========================= */
+
+typedef struct {
+    u32 file_cluster;           /* first cluster of the run within the file */
+    u32 start;                  /* first cluster on the volume */
+    u32 count;
+} fat_run_t;
+
+typedef struct {
+    fat_run_t *runs;            /* in file order */
+    u32 count;
+    u32 capacity;
+    u32 clusters;
+} fat_chain_t;
+
+typedef struct {
+    fat_run_t *runs;            /* FAT_CHAIN_RUNS, boot_alloc() */
+    u32 first;                  /* 0 = empty */
+    u32 count;
+    u32 clusters;
+    u32 used;                   /* LRU stamp */
+} fat_cached_chain_t;
+
+/* A directory entry, as far as reading goes */
+typedef struct {
+    u32 cluster;                /* first cluster, 0 = none */
+    u64 size;                   /* bytes; 0 for FAT32 directories, the chain decides */
+    u64 valid;                  /* bytes holding data (exFAT ValidDataLength), the rest reads as 0 */
+    bool directory;
+    bool contiguous;            /* exFAT NoFatChain: no FAT entries to follow */
+} fat_node_t;
+
+typedef struct {
+    u32 dir;                    /* first cluster of the parent, 0 = empty */
+    u32 used;
+    u32 len;
+    u16 name[FAT_CACHED_NAME_MAX];  /* folded */
+    fat_node_t node;
+} fat_cached_name_t;
+
+typedef struct {
+    fs_volume_t base;           /* first, see Fs.h */
+    bool exfat;
+
+    u32 cluster_size;           /* bytes */
+    u32 cluster_count;
+    u64 fat_offset;             /* bytes into the volume, active FAT */
+    u64 fat_size;
+    u64 data_offset;            /* cluster 2 */
+    fat_node_t root;
+
+    u8 *window;                 /* FAT bytes [window_start, window_start + window_len) */
+    u64 window_start;
+    u32 window_len;
+
+    u8 *dir_window;             /* lookup() scratch */
+
+    fat_cached_chain_t chains[FAT_CHAIN_CACHE];
+    fat_cached_name_t *names;   /* FAT_NAME_CACHE */
+    u32 clock;
+} fat_volume_t;
+
+typedef struct {
+    fs_file_t base;             /* first, see Fs.h */
+    fat_chain_t chain;
+    u64 valid;
+} fat_file_t;
+
+static inline u16 le16(const u8 *p) {
+    return (u16)(p[1] << 8 | p[0]);
+}
+
+static inline u32 le32(const u8 *p) {
+    return (u32)p[3] << 24 | (u32)p[2] << 16 | (u32)p[1] << 8 | p[0];
+}
+
+static inline u64 le64(const u8 *p) {
+    return (u64)le32(p + 4) << 32 | le32(p);
+}
+
+static inline u64 cluster_offset(const fat_volume_t *vol, u32 cluster) {
+    return vol->data_offset + (u64)(cluster - FAT_FIRST_CLUSTER) * vol->cluster_size;
+}
+
+static inline bool valid_cluster(const fat_volume_t *vol, u32 cluster) {
+    return cluster >= FAT_FIRST_CLUSTER && cluster - FAT_FIRST_CLUSTER < vol->cluster_count;
+}
+
+/* =========================
+ *  Cluster chains
+ * ========================= */
+
+static status_t push_run(fat_chain_t *chain, u32 start, u32 count) {
+    u32 file_cluster = chain->clusters;
+
+    chain->clusters += count;
+    if (chain->count) {
+        fat_run_t *last = &chain->runs[chain->count - 1];
+        if (last->start + last->count == start) {
+            last->count += count;
+            return STATUS_SUCCESS;
+        }
+    }
+
+    if (chain->count == chain->capacity) {
+        u32 capacity = chain->capacity ? chain->capacity * 2 : 8;
+        fat_run_t *runs = mem_alloc(capacity * sizeof(fat_run_t));
+        if (!runs)
+            return STATUS_OUT_OF_MEMORY;
+
+        if (chain->runs) {
+            memcpy(runs, chain->runs, chain->count * sizeof(fat_run_t));
+            mem_free(chain->runs);
+        }
+        chain->runs = runs;
+        chain->capacity = capacity;
+    }
+
+    fat_run_t *r = &chain->runs[chain->count++];
+    r->file_cluster = file_cluster;
+    r->start = start;
+    r->count = count;
+    return STATUS_SUCCESS;
+}
+
+static void free_chain(fat_chain_t *chain) {
+    if (chain->runs)
+        mem_free(chain->runs);
+    memset(chain, 0, sizeof(*chain));
+}
+
+/* FAT entry of `cluster`, through the window */
+static status_t fat_entry(fat_volume_t *vol, u32 cluster, u32 *next) {
+    u64 byte = (u64)cluster * 4;
+
+    if (byte + 4 > vol->fat_size)
+        return STATUS_ERROR;
+
+    if (byte < vol->window_start || byte + 4 > vol->window_start + vol->window_len) {
+        u64 start = byte & ~(u64)(FAT_WINDOW_SIZE - 1);
+        u64 len = vol->fat_size - start;
+        if (len > FAT_WINDOW_SIZE)
+            len = FAT_WINDOW_SIZE;
+
+        vol->window_len = 0;
+        status_t status = block_read_bytes(vol->base.device, vol->fat_offset + start,
+                                           len, vol->window);
+        if (status != STATUS_SUCCESS)
+            return status;
+        vol->window_start = start;
+        vol->window_len = (u32)len;
+    }
+
+    u32 entry = le32(vol->window + (byte - vol->window_start));
+    *next = vol->exfat ? entry : entry & FAT32_MASK;
+    return STATUS_SUCCESS;
+}
+
+/* Follow the FAT from `first`, one run per stretch of consecutive clusters */
+static status_t walk_chain(fat_volume_t *vol, u32 first, fat_chain_t *chain) {
+    u32 end = vol->exfat ? EXFAT_END : FAT32_END;
+    u32 cluster = first;
+
+    for (;;) {
+        if (!valid_cluster(vol, cluster) || chain->clusters >= vol->cluster_count)
+            return STATUS_ERROR;        /* free or bad cluster in the chain, or a loop */
+
+        /* the common case: the next entry points at the next cluster */
+        u32 start = cluster, count = 0, next;
+        do {
+            status_t status = fat_entry(vol, cluster, &next);
+            if (status != STATUS_SUCCESS)
+                return status;
+            count++;
+            cluster++;
+        } while (next == cluster && valid_cluster(vol, cluster) && count < vol->cluster_count);
+
+        status_t status = push_run(chain, start, count);
+        if (status != STATUS_SUCCESS)
+            return status;
+
+        if (next >= end)
+            return STATUS_SUCCESS;
+        cluster = next;
+    }
+}
+
+/* Runs of the chain that starts at `node->cluster` */
+static status_t load_chain(fat_volume_t *vol, const fat_node_t *node, fat_chain_t *chain) {
+    memset(chain, 0, sizeof(*chain));
+    if (!node->cluster)
+        return node->size ? STATUS_ERROR : STATUS_SUCCESS;
+
+    if (node->contiguous) {
+        u64 clusters = (node->size + vol->cluster_size - 1) / vol->cluster_size;
+        if (!valid_cluster(vol, node->cluster) ||
+            clusters > vol->cluster_count - (node->cluster - FAT_FIRST_CLUSTER))
+            return STATUS_ERROR;
+        return clusters ? push_run(chain, node->cluster, (u32)clusters) : STATUS_SUCCESS;
+    }
+
+    fat_cached_chain_t *slot = NULL;
+    for (u32 i = 0; i < FAT_CHAIN_CACHE; i++) {
+        fat_cached_chain_t *c = &vol->chains[i];
+        if (c->first == node->cluster) {
+            c->used = ++vol->clock;
+            for (u32 j = 0; j < c->count; j++) {
+                status_t status = push_run(chain, c->runs[j].start, c->runs[j].count);
+                if (status != STATUS_SUCCESS) {
+                    free_chain(chain);
+                    return status;
+                }
+            }
+            return STATUS_SUCCESS;
+        }
+        if (!slot || c->used < slot->used)
+            slot = c;
+    }
+
+    status_t status = walk_chain(vol, node->cluster, chain);
+    if (status != STATUS_SUCCESS) {
+        free_chain(chain);
+        return status;
+    }
+
+    /* long chains are walked again next time rather than crowding the cache */
+    if (chain->count <= FAT_CHAIN_RUNS) {
+        memcpy(slot->runs, chain->runs, chain->count * sizeof(fat_run_t));
+        slot->first = node->cluster;
+        slot->count = chain->count;
+        slot->clusters = chain->clusters;
+        slot->used = ++vol->clock;
+    }
+    return STATUS_SUCCESS;
+}
+
+/* Run holding file cluster `cluster`, NULL past the end */
+static const fat_run_t *find_run(const fat_chain_t *chain, u64 cluster) {
+    u32 lo = 0, hi = chain->count;
+
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+        const fat_run_t *r = &chain->runs[mid];
+
+        if (cluster < r->file_cluster)
+            hi = mid;
+        else if (cluster - r->file_cluster >= r->count)
+            lo = mid + 1;
+        else
+            return r;
+    }
+    return NULL;
+}
+
+/* Chain bytes [offset, offset + size): one block-layer request per run */
+static status_t chain_read(fat_volume_t *vol, const fat_chain_t *chain,
+                           u64 offset, u64 size, void *buf) {
+    u32 cs = vol->cluster_size;
+    u8 *out = (u8 *)buf;
+
+    while (size) {
+        const fat_run_t *r = find_run(chain, offset / cs);
+        if (!r)
+            return STATUS_OUT_OF_RANGE;
+
+        u64 skip = offset - (u64)r->file_cluster * cs;
+        u64 n = (u64)r->count * cs - skip;
+        if (n > size)
+            n = size;
+
+        status_t status = block_read_bytes(vol->base.device,
+                                           cluster_offset(vol, r->start) + skip, n, out);
+        if (status != STATUS_SUCCESS)
+            return status;
+
+        out += n;
+        offset += n;
+        size -= n;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+/* =========================
+ *  Directories
+ * ========================= */
+
+/* Case folding for the characters boot paths use */
+static inline u16 fold(u16 c) {
+    if ((c >= 'a' && c <= 'z') || (c >= 0xE0 && c <= 0xFE && c != 0xF7))
+        return (u16)(c - 0x20);
+    return c;
+}
+
+static bool name_equal(const u16 *a, u32 a_len, const u16 *folded, u32 len) {
+    if (a_len != len)
+        return false;
+    for (u32 i = 0; i < len; i++) {
+        if (fold(a[i]) != folded[i])
+            return false;
+    }
+    return true;
+}
+
+/* "NAME.EXT" out of an 8.3 entry */
+static u32 short_name(const u8 *e, u16 *out) {
+    u32 n = 0, base = 8, ext = 3;
+
+    while (base && e[DIR_NAME + base - 1] == ' ')
+        base--;
+    while (ext && e[DIR_NAME + 8 + ext - 1] == ' ')
+        ext--;
+
+    for (u32 i = 0; i < base; i++)
+        out[n++] = i == 0 && e[DIR_NAME] == DIR_KANJI_E5 ? DIR_FREE : e[DIR_NAME + i];
+    if (ext) {
+        out[n++] = '.';
+        for (u32 i = 0; i < ext; i++)
+            out[n++] = e[DIR_NAME + 8 + i];
+    }
+    return n;
+}
+
+static u8 short_name_checksum(const u8 *e) {
+    u8 sum = 0;
+    for (u32 i = 0; i < 11; i++)
+        sum = (u8)(((sum & 1) << 7) + (sum >> 1) + e[DIR_NAME + i]);
+    return sum;
+}
+
+typedef struct {
+    fat_chain_t chain;
+    u64 size;
+    u64 pos;
+    u64 window_pos;
+    u32 window_len;
+} fat_dir_t;
+
+/* Next 32-byte entry, NULL at the end of the directory or on a read error */
+static const u8 *dir_next(fat_volume_t *vol, fat_dir_t *dir) {
+    if (dir->pos >= dir->size)
+        return NULL;
+
+    if (dir->pos >= dir->window_pos + dir->window_len) {
+        u64 n = dir->size - dir->pos;
+        if (n > FAT_DIR_WINDOW)
+            n = FAT_DIR_WINDOW;
+        if (chain_read(vol, &dir->chain, dir->pos, n, vol->dir_window) != STATUS_SUCCESS)
+            return NULL;
+        dir->window_pos = dir->pos;
+        dir->window_len = (u32)n;
+    }
+
+    const u8 *e = vol->dir_window + (dir->pos - dir->window_pos);
+    dir->pos += DIR_ENTRY_SIZE;
+    return e;
+}
+
+/* FAT32: long name if its checksum matches the 8.3 entry, the 8.3 name otherwise */
+static status_t scan_fat32(fat_volume_t *vol, fat_dir_t *dir, const u16 *name, u32 len,
+                           fat_node_t *out) {
+    u16 lfn[LFN_MAX_PARTS * LFN_CHARS];
+    u16 sfn[12];
+    u32 lfn_next = 0;           /* part expected next, counting down to 1 */
+    bool lfn_done = false;
+    u8 lfn_sum = 0;
+    const u8 *e;
+
+    while ((e = dir_next(vol, dir))) {
+        if (e[DIR_NAME] == DIR_END)
+            break;
+        if (e[DIR_NAME] == DIR_FREE) {
+            lfn_next = 0;
+            lfn_done = false;
+            continue;
+        }
+
+        if ((e[DIR_ATTR] & 0x3F) == ATTR_LONG_NAME) {
+            u32 part = e[LFN_ORDER] & 0x3F;
+
+            if (e[LFN_ORDER] & LFN_LAST) {
+                lfn_next = part <= LFN_MAX_PARTS ? part : 0;
+                lfn_sum = e[LFN_CHECKSUM];
+                for (u32 i = 0; i < LFN_MAX_PARTS * LFN_CHARS; i++)
+                    lfn[i] = 0;
+            } else if (part != lfn_next || e[LFN_CHECKSUM] != lfn_sum) {
+                lfn_next = 0;
+            }
+            lfn_done = false;
+            if (!lfn_next || part != lfn_next)
+                continue;
+
+            for (u32 i = 0; i < LFN_CHARS; i++)
+                lfn[(part - 1) * LFN_CHARS + i] = le16(e + lfn_offsets[i]);
+            if (--lfn_next == 0)
+                lfn_done = true;
+            continue;
+        }
+
+        bool has_lfn = lfn_done && short_name_checksum(e) == lfn_sum;
+        lfn_next = 0;
+        lfn_done = false;
+        if (e[DIR_ATTR] & ATTR_VOLUME_ID)
+            continue;
+
+        bool match;
+        if (has_lfn) {
+            u32 n = 0;
+            while (n < LFN_MAX_PARTS * LFN_CHARS && lfn[n])
+                n++;
+            match = name_equal(lfn, n, name, len);
+        } else {
+            match = name_equal(sfn, short_name(e, sfn), name, len);
+        }
+        if (!match)
+            continue;
+
+        out->cluster = (u32)le16(e + DIR_CLUSTER_HI) << 16 | le16(e + DIR_CLUSTER_LO);
+        out->directory = (e[DIR_ATTR] & ATTR_DIRECTORY) != 0;
+        out->size = out->directory ? 0 : le32(e + DIR_FILE_SIZE);
+        out->valid = out->size;
+        out->contiguous = false;
+        /* ".." of a top-level directory */
+        if (out->directory && !out->cluster)
+            *out = vol->root;
+        return STATUS_SUCCESS;
+    }
+
+    return STATUS_NOT_FOUND;
+}
+
+/* exFAT: a file entry, its stream extension, then the name in 15-unit pieces */
+static status_t scan_exfat(fat_volume_t *vol, fat_dir_t *dir, const u16 *name, u32 len,
+                           fat_node_t *out) {
+    u16 set_name[FAT_NAME_MAX];
+    u32 remaining = 0;          /* secondary entries of the set still to come */
+    u32 name_len = 0, got = 0;
+    bool stream = false;
+    fat_node_t node;
+    const u8 *e;
+
+    memset(&node, 0, sizeof(node));
+    while ((e = dir_next(vol, dir))) {
+        u8 type = e[0];
+
+        if (type == DIR_END)
+            break;
+        if (!(type & EXFAT_IN_USE)) {
+            remaining = 0;
+            continue;
+        }
+
+        if (type == EXFAT_TYPE_FILE) {
+            remaining = e[EXFAT_SECONDARY_COUNT];
+            node.directory = (le16(e + EXFAT_FILE_ATTR) & ATTR_DIRECTORY) != 0;
+            stream = false;
+            got = 0;
+            continue;
+        }
+        if (!remaining)
+            continue;
+        remaining--;
+
+        if (type == EXFAT_TYPE_STREAM && !stream) {
+            stream = true;
+            name_len = e[EXFAT_NAME_LENGTH];
+            node.contiguous = (e[EXFAT_STREAM_FLAGS] & EXFAT_NO_FAT_CHAIN) != 0;
+            node.valid = le64(e + EXFAT_VALID_LENGTH);
+            node.cluster = le32(e + EXFAT_FIRST_CLUSTER);
+            node.size = le64(e + EXFAT_DATA_LENGTH);
+        } else if (type == EXFAT_TYPE_NAME && stream) {
+            for (u32 i = 0; i < EXFAT_NAME_CHARS && got < name_len; i++)
+                set_name[got++] = le16(e + 2 + 2 * i);
+        }
+        /* vendor and other benign secondaries only count */
+
+        if (remaining || !stream || got < name_len)
+            continue;
+        if (!name_equal(set_name, name_len, name, len))
+            continue;
+
+        if (node.valid > node.size)
+            node.valid = node.size;
+        *out = node;
+        return STATUS_SUCCESS;
+    }
+
+    return STATUS_NOT_FOUND;
+}
+
+/* Entry called `name` (folded) in directory `parent` */
+static status_t lookup(fat_volume_t *vol, const fat_node_t *parent, const u16 *name, u32 len,
+                       fat_node_t *out) {
+    fat_cached_name_t *slot = NULL;
+    bool cacheable = len <= FAT_CACHED_NAME_MAX && parent->cluster;
+
+    if (cacheable) {
+        for (u32 i = 0; i < FAT_NAME_CACHE; i++) {
+            fat_cached_name_t *c = &vol->names[i];
+            if (c->dir == parent->cluster && c->len == len &&
+                !memcmp(c->name, name, len * sizeof(u16))) {
+                c->used = ++vol->clock;
+                *out = c->node;
+                return STATUS_SUCCESS;
+            }
+            if (!slot || c->used < slot->used)
+                slot = c;
+        }
+    }
+
+    fat_dir_t dir;
+    memset(&dir, 0, sizeof(dir));
+    status_t status = load_chain(vol, parent, &dir.chain);
+    if (status != STATUS_SUCCESS)
+        return status;
+    dir.size = parent->size ? parent->size : (u64)dir.chain.clusters * vol->cluster_size;
+
+    if (vol->exfat)
+        status = scan_exfat(vol, &dir, name, len, out);
+    else
+        status = scan_fat32(vol, &dir, name, len, out);
+    free_chain(&dir.chain);
+
+    if (status == STATUS_SUCCESS && cacheable) {
+        slot->dir = parent->cluster;
+        slot->len = len;
+        memcpy(slot->name, name, len * sizeof(u16));
+        slot->node = *out;
+        slot->used = ++vol->clock;
+    }
+    return status;
+}
+
+/* =========================
+ *  fs_ops_t
+ * ========================= */
+
+static void fat_close(fs_file_t *file) {
+    fat_file_t *f = (fat_file_t *)file;
+
+    free_chain(&f->chain);
+    mem_free(f);
+}
+
+/* Geometry from a FAT32 BPB; STATUS_NOT_FOUND if it is none */
+static status_t read_bpb(fat_volume_t *vol, const u8 *bs) {
+    u32 bps = le16(bs + BPB_BYTES_PER_SECTOR);
+    u32 spc = bs[BPB_SECTORS_PER_CLUSTER];
+    u32 reserved = le16(bs + BPB_RESERVED_SECTORS);
+    u32 fats = bs[BPB_NUM_FATS];
+
+    if (le16(bs + BS_SIGNATURE) != BOOT_SIGNATURE ||
+        bps < 512 || bps > 4096 || (bps & (bps - 1)) ||
+        !spc || (spc & (spc - 1)) || !reserved || !fats)
+        return STATUS_NOT_FOUND;
+
+    /* FAT12/16 keep a fixed root directory and a 16-bit FAT size */
+    if (le16(bs + BPB_ROOT_ENTRIES) || le16(bs + BPB_FAT_SIZE_16)) {
+        printf("fat: FAT12/FAT16 volumes are not supported\n");
+        return STATUS_NOT_FOUND;
+    }
+
+    u32 total = le16(bs + BPB_TOTAL_SECTORS_16);
+    if (!total)
+        total = le32(bs + BPB_TOTAL_SECTORS_32);
+    u32 fat_sectors = le32(bs + BPB_FAT_SIZE_32);
+    u64 data = reserved + (u64)fats * fat_sectors;
+    if (!fat_sectors || data >= total)
+        return STATUS_ERROR;
+
+    u32 active = 0;
+    u16 flags = le16(bs + BPB_EXT_FLAGS);
+    if ((flags & EXT_FLAGS_NO_MIRROR) && (flags & EXT_FLAGS_ACTIVE_FAT) < fats)
+        active = flags & EXT_FLAGS_ACTIVE_FAT;
+
+    vol->cluster_size = bps * spc;
+    vol->cluster_count = (u32)((total - data) / spc);
+    vol->fat_size = (u64)fat_sectors * bps;
+    vol->fat_offset = ((u64)reserved + (u64)active * fat_sectors) * bps;
+    vol->data_offset = data * bps;
+    vol->root.cluster = le32(bs + BPB_ROOT_CLUSTER);
+    return STATUS_SUCCESS;
+}
+
+static status_t read_exfat_boot(fat_volume_t *vol, const u8 *bs) {
+    u32 sector_shift = bs[EXFAT_SECTOR_SHIFT];
+    u32 cluster_shift = bs[EXFAT_CLUSTER_SHIFT];
+
+    if (le16(bs + BS_SIGNATURE) != BOOT_SIGNATURE ||
+        sector_shift < 9 || sector_shift > 12 || sector_shift + cluster_shift > 25 ||
+        !bs[EXFAT_NUM_FATS])
+        return STATUS_ERROR;
+
+    u64 fat_length = le32(bs + EXFAT_FAT_LENGTH);
+    u32 active = (le16(bs + EXFAT_VOLUME_FLAGS) & EXFAT_ACTIVE_FAT) && bs[EXFAT_NUM_FATS] > 1;
+
+    vol->exfat = true;
+    vol->cluster_size = 1u << (sector_shift + cluster_shift);
+    vol->cluster_count = le32(bs + EXFAT_CLUSTER_COUNT);
+    vol->fat_size = fat_length << sector_shift;
+    vol->fat_offset = ((u64)le32(bs + EXFAT_FAT_OFFSET) + active * fat_length) << sector_shift;
+    vol->data_offset = (u64)le32(bs + EXFAT_HEAP_OFFSET) << sector_shift;
+    vol->root.cluster = le32(bs + EXFAT_ROOT_CLUSTER);
+    return STATUS_SUCCESS;
+}
+
+static status_t fat_mount(block_device_t *dev, fs_volume_t **out) {
+    u8 bs[512];
+
+    if (!dev->block_size || block_read_bytes(dev, 0, sizeof(bs), bs) != STATUS_SUCCESS)
+        return STATUS_NOT_FOUND;
+
+    fat_volume_t *vol = mem_alloc_zero(sizeof(fat_volume_t));
+    if (!vol)
+        return STATUS_OUT_OF_MEMORY;
+
+    vol->base.ops = &fat_fs_ops;
+    vol->base.device = dev;
+
+    status_t status = !memcmp(bs + EXFAT_NAME, "EXFAT   ", 8) ? read_exfat_boot(vol, bs)
+                                                              : read_bpb(vol, bs);
+    if (status == STATUS_SUCCESS) {
+        /* the FAT cannot describe more clusters than it has entries for */
+        u64 entries = vol->fat_size / 4;
+        if (entries <= FAT_FIRST_CLUSTER || !vol->cluster_count)
+            status = STATUS_ERROR;
+        else if (vol->cluster_count > entries - FAT_FIRST_CLUSTER)
+            vol->cluster_count = (u32)(entries - FAT_FIRST_CLUSTER);
+    }
+    if (status == STATUS_SUCCESS && !valid_cluster(vol, vol->root.cluster))
+        status = STATUS_ERROR;
+    if (status != STATUS_SUCCESS) {
+        mem_free(vol);
+        return status;
+    }
+    vol->root.directory = true;
+
+    /* volumes stay mounted until handoff */
+    size_t runs = (size_t)FAT_CHAIN_CACHE * FAT_CHAIN_RUNS * sizeof(fat_run_t);
+    size_t names = (size_t)FAT_NAME_CACHE * sizeof(fat_cached_name_t);
+    u8 *pool = boot_alloc(FAT_WINDOW_SIZE + FAT_DIR_WINDOW + runs + names);
+    if (!pool) {
+        mem_free(vol);
+        return STATUS_OUT_OF_MEMORY;
+    }
+    memset(pool + FAT_WINDOW_SIZE + FAT_DIR_WINDOW, 0, runs + names);
+
+    vol->window = pool;
+    vol->dir_window = pool + FAT_WINDOW_SIZE;
+    for (u32 i = 0; i < FAT_CHAIN_CACHE; i++)
+        vol->chains[i].runs = (fat_run_t *)(vol->dir_window + FAT_DIR_WINDOW) + i * FAT_CHAIN_RUNS;
+    vol->names = (fat_cached_name_t *)(vol->dir_window + FAT_DIR_WINDOW + runs);
+
+    *out = &vol->base;
+    return STATUS_SUCCESS;
+}
+
+static status_t fat_open(fs_volume_t *v, const char *path, fs_file_t **out) {
+    fat_volume_t *vol = (fat_volume_t *)v;
+    u16 name16[FAT_NAME_MAX];
+    const char *name;
+    size_t len;
+    fat_node_t node = vol->root;
+    u32 depth = 0;
+
+    /* the root is no file */
+    const char *rest = fs_path_next(path, &name, &len);
+    if (!rest)
+        return STATUS_NOT_FOUND;
+
+    do {
+        if (!node.directory || ++depth > FAT_MAX_DEPTH)
+            return STATUS_NOT_FOUND;
+
+        s32 n = fs_utf8_to_utf16(name, len, name16, FAT_NAME_MAX);
+        if (n < 0)
+            return STATUS_INVALID_PARAM;
+        for (s32 i = 0; i < n; i++)
+            name16[i] = fold(name16[i]);
+
+        fat_node_t parent = node;
+        status_t status = lookup(vol, &parent, name16, (u32)n, &node);
+        if (status != STATUS_SUCCESS)
+            return status;
+    } while ((rest = fs_path_next(rest, &name, &len)));
+
+    if (node.directory)
+        return STATUS_NOT_FOUND;
+
+    fat_file_t *f = mem_alloc_zero(sizeof(fat_file_t));
+    if (!f)
+        return STATUS_OUT_OF_MEMORY;
+
+    status_t status = load_chain(vol, &node, &f->chain);
+    if (status == STATUS_SUCCESS && (u64)f->chain.clusters * vol->cluster_size < node.size)
+        status = STATUS_ERROR;      /* truncated chain */
+    if (status != STATUS_SUCCESS) {
+        fat_close(&f->base);
+        return status;
+    }
+
+    f->base.size = node.size;
+    f->valid = node.valid;
+    *out = &f->base;
+    return STATUS_SUCCESS;
+}
+
+static size_t fat_read(fs_file_t *file, u64 offset, void *buf, size_t size) {
+    fat_file_t *f = (fat_file_t *)file;
+    fat_volume_t *vol = (fat_volume_t *)file->volume;
+    u8 *out = (u8 *)buf;
+    size_t n = 0;
+
+    if (offset >= file->size)
+        return 0;
+    if (size > file->size - offset)
+        size = (size_t)(file->size - offset);
+
+    /* exFAT may allocate past the last byte written; that part reads as 0 */
+    if (offset < f->valid) {
+        n = f->valid - offset < size ? (size_t)(f->valid - offset) : size;
+        if (chain_read(vol, &f->chain, offset, n, out) != STATUS_SUCCESS)
+            return 0;
+    }
+    memset(out + n, 0, size - n);
+    return size;
+}
+
+static int fat_map(fs_file_t *file, u64 offset, fs_extent_t *out) {
+    fat_file_t *f = (fat_file_t *)file;
+    fat_volume_t *vol = (fat_volume_t *)file->volume;
+    block_device_t *dev = vol->base.device;
+    u32 cs = vol->cluster_size;
+
+    if (offset >= f->valid)
+        return -1;
+
+    const fat_run_t *r = find_run(&f->chain, offset / cs);
+    if (!r)
+        return -1;
+
+    u64 skip = offset - (u64)r->file_cluster * cs;
+    u64 byte = cluster_offset(vol, r->start) + skip;
+    if (byte % dev->block_size)
+        return -1;
+
+    out->device = dev;
+    out->lba = byte / dev->block_size;
+    out->length = (u64)r->count * cs - skip;
+    if (out->length > f->valid - offset)
+        out->length = f->valid - offset;
+    return 0;
+}
+
+const fs_ops_t fat_fs_ops = {
+    .name = "fat",
+    .mount = fat_mount,
+    .open = fat_open,
+    .read = fat_read,
+    .close = fat_close,
+    .map = fat_map,
+};
@@ -0,0 +1,32 @@
+#ifndef FAT_H
+#define FAT_H
+
+#include "../../Fs.h"
+
+/*
+ * OpenCore Mobile – FAT32 / exFAT, read-only
+ *
+ * A filesystem driver for Fs.h, for the EFI system partition and SD
+ * cards, after the Microsoft FAT (fatgen103) and exFAT specifications.
+ *
+ * Opening a file turns its cluster chain into runs of contiguous
+ * clusters, walking the FAT through a window of several sectors rather
+ * than a read per link; exFAT files flagged NoFatChain are one run
+ * without touching the FAT at all. fs_read() then issues one
+ * block-layer request per run, so a fragmented 50 MB kernelcache costs a
+ * handful of large reads, and fs_map() hands the runs to loop devices
+ * (ImgLd.c).
+ *
+ * Each volume remembers the run lists of recently walked chains
+ * (directories and files alike) and the entries recent path lookups
+ * resolved to, so reopening a file, or opening its siblings under
+ * \EFI\OC\Kexts, reads no directory or FAT sectors again.
+ *
+ * Names match case-insensitively, long names first, folding ASCII and
+ * Latin-1 (exFAT's up-case table is not read). 8.3 names must be ASCII.
+ * Not supported: FAT12/FAT16, writing, TexFAT transactions.
+ */
+
+extern const fs_ops_t fat_fs_ops;
+
+#endif /* FAT_H */
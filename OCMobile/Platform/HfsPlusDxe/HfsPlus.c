@@ -0,0 +1,1131 @@
+#include "HfsPlus.h"
+#include "../../Memory.h"
+#include "../inflate/inflate.h"
+#include "../lzfse/lzfse.h"
+
+/*
+ * OpenCore Mobile – HFS+ driver
+ * See HfsPlus.h. Layout per TN1150; everything on disk is big-endian
+ * except the decmpfs header and its resource-fork block table.
+ */
+
+/* =========================
+ *  On-disk format
+ * ========================= */
+
+#define HFS_VOLUME_HEADER       1024        /* byte offset on the volume */
+#define HFS_SIG_PLUS            0x482B      /* "H+" */
+#define HFS_SIG_X               0x4858      /* "HX" */
+
+/* HFSPlusVolumeHeader */
+#define VH_SIGNATURE            0
+#define VH_BLOCK_SIZE           40
+#define VH_EXTENTS_FORK         192
+#define VH_CATALOG_FORK         272
+#define VH_ATTRIBUTES_FORK      352
+
+/* HFSPlusForkData */
+#define FORK_LOGICAL_SIZE       0
+#define FORK_TOTAL_BLOCKS       12
+#define FORK_EXTENTS            16
+#define EXTENTS_PER_RECORD      8
+#define EXTENT_RECORD_SIZE      (EXTENTS_PER_RECORD * 8)
+
+#define FORK_DATA               0x00
+#define FORK_RESOURCE           0xFF
+
+/* reserved catalog node IDs */
+#define CNID_ROOT_FOLDER        2
+#define CNID_EXTENTS_FILE       3
+#define CNID_CATALOG_FILE       4
+#define CNID_ATTRIBUTES_FILE    8
+
+/* catalog records */
+#define CAT_FOLDER              1
+#define CAT_FILE                2
+
+#define CAT_ID                  8           /* folderID / fileID */
+#define FOLDER_RECORD_SIZE      88
+#define FILE_OWNER_FLAGS        41          /* permissions.ownerFlags */
+#define FILE_SPECIAL            44          /* permissions.special: iNodeNum of a hard link */
+#define FILE_TYPE               48          /* userInfo.fileType */
+#define FILE_CREATOR            52
+#define FILE_DATA_FORK          88
+#define FILE_RESOURCE_FORK      168
+#define FILE_RECORD_SIZE        248
+
+#define UF_COMPRESSED           0x20
+#define HARDLINK_TYPE           0x686C6E6B  /* "hlnk" */
+#define HARDLINK_CREATOR        0x6866732B  /* "hfs+" */
+
+/* B-tree nodes */
+#define NODE_KIND               8
+#define NODE_NUM_RECORDS        10
+#define NODE_DESCRIPTOR_SIZE    14
+
+#define NODE_LEAF               (-1)
+#define NODE_INDEX              0
+#define NODE_HEADER             1
+
+/* BTHeaderRec, from the start of the header node */
+#define HDR_ROOT_NODE           16
+#define HDR_NODE_SIZE           32
+#define HDR_MAX_KEY_LENGTH      34
+#define HDR_KEY_COMPARE         51
+#define HDR_ATTRIBUTES          52
+#define HDR_SIZE                120
+
+#define BT_BIG_KEYS             0x00000002
+#define BT_VARIABLE_INDEX_KEYS  0x00000004
+#define KEY_COMPARE_BINARY      0xBC
+
+/* attributes B-tree records */
+#define ATTR_INLINE_DATA        0x10
+#define ATTR_DATA_SIZE          12
+#define ATTR_DATA               16
+
+/* decmpfs (little-endian) */
+#define DECMPFS_MAGIC           0x636D7066  /* "cmpf" */
+#define DECMPFS_HEADER_SIZE     16
+#define DECMPFS_RAW_INLINE      1
+#define DECMPFS_ZLIB_INLINE     3
+#define DECMPFS_ZLIB_RESOURCE   4
+#define DECMPFS_LZVN_INLINE     7
+#define DECMPFS_LZVN_RESOURCE   8
+#define DECMPFS_LZFSE_INLINE    11
+#define DECMPFS_LZFSE_RESOURCE  12
+#define DECMPFS_BLOCK_SIZE      65536
+
+/* =========================
+ *  Limits
+ * ========================= */
+
+/* B-tree nodes cached per volume */
+#ifndef HFS_NODE_CACHE
+#define HFS_NODE_CACHE          32
+#endif
+
+#define HFS_MAX_DEPTH           16
+#define HFS_NAME_MAX            255         /* UTF-16 units */
+#define HFS_NODE_SIZE_MAX       32768
+#define HFS_INLINE_MAX          (1u << 20)  /* decmpfs attribute, decoded */
+
+/* =========================
+ *  In-memory state
+ * ========================= */
+
+typedef struct {
+    u32 file_block;             /* first fork block of the run */
+    u32 start;                  /* first allocation block on the volume */
+    u32 count;
+} hfs_run_t;
+
+typedef struct {
+    u64 size;                   /* logical bytes */
+    hfs_run_t *runs;            /* in fork order */
+    u32 count;
+    u32 capacity;
+} hfs_fork_t;
+
+typedef struct {
+    hfs_fork_t fork;
+    u32 root;
+    u32 attributes;             /* BT_* */
+    u16 node_size;
+    u16 max_key;
+    u8 compare;
+    u8 tag;                     /* node cache tag, 0 = the volume has no such tree */
+} hfs_btree_t;
+
+typedef struct {
+    u8 *data;
+    u32 node;
+    u32 used;                   /* LRU stamp */
+    u8 tag;                     /* 0 = empty */
+} hfs_node_t;
+
+typedef struct {
+    fs_volume_t base;           /* first, see Fs.h */
+    u32 block_size;
+    bool case_sensitive;
+
+    hfs_btree_t extents;
+    hfs_btree_t catalog;
+    hfs_btree_t attributes;
+
+    hfs_node_t nodes[HFS_NODE_CACHE];
+    u32 clock;
+
+    u32 private_folder;         /* hard link targets, 0 = not looked up yet */
+} hfs_volume_t;
+
+typedef struct {
+    fs_file_t base;             /* first, see Fs.h */
+
+    hfs_fork_t fork;            /* data fork, or the resource fork of a compressed file */
+    u32 compression;            /* decmpfs type, 0 = plain */
+
+    u8 *data;                   /* inline: the whole file; resource: block `block` - 1 */
+    u32 block;
+    u32 num_blocks;
+    u8 *table;                  /* resource: {offset, size} per block, little-endian */
+    u64 table_base;             /* resource fork offset those offsets count from */
+} hfs_file_t;
+
+static inline u16 be16(const u8 *p) {
+    return (u16)(p[0] << 8 | p[1]);
+}
+
+static inline u32 be32(const u8 *p) {
+    return (u32)p[0] << 24 | (u32)p[1] << 16 | (u32)p[2] << 8 | p[3];
+}
+
+static inline u64 be64(const u8 *p) {
+    return (u64)be32(p) << 32 | be32(p + 4);
+}
+
+static inline u32 le32(const u8 *p) {
+    return (u32)p[3] << 24 | (u32)p[2] << 16 | (u32)p[1] << 8 | p[0];
+}
+
+static inline u64 le64(const u8 *p) {
+    return (u64)le32(p + 4) << 32 | le32(p);
+}
+
+static inline void put_le32(u8 *p, u32 v) {
+    p[0] = (u8)v;
+    p[1] = (u8)(v >> 8);
+    p[2] = (u8)(v >> 16);
+    p[3] = (u8)(v >> 24);
+}
+
+/* =========================
+ *  Forks
+ * ========================= */
+
+/* Run holding fork block `block`, NULL past the end */
+static const hfs_run_t *find_run(const hfs_fork_t *fork, u64 block) {
+    u32 lo = 0, hi = fork->count;
+
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+        const hfs_run_t *r = &fork->runs[mid];
+
+        if (block < r->file_block)
+            hi = mid;
+        else if (block - r->file_block >= r->count)
+            lo = mid + 1;
+        else
+            return r;
+    }
+    return NULL;
+}
+
+/* Fork bytes [offset, offset + size): one block-layer request per run */
+static status_t fork_read(hfs_volume_t *vol, const hfs_fork_t *fork,
+                          u64 offset, u64 size, void *buf) {
+    u32 bs = vol->block_size;
+    u8 *out = (u8 *)buf;
+
+    if (offset > fork->size || size > fork->size - offset)
+        return STATUS_OUT_OF_RANGE;
+
+    while (size) {
+        const hfs_run_t *r = find_run(fork, offset / bs);
+        if (!r)
+            return STATUS_ERROR;
+
+        u64 skip = offset - (u64)r->file_block * bs;
+        u64 n = (u64)r->count * bs - skip;
+        if (n > size)
+            n = size;
+
+        status_t status = block_read_bytes(vol->base.device,
+                                           (u64)r->start * bs + skip, n, out);
+        if (status != STATUS_SUCCESS)
+            return status;
+
+        out += n;
+        offset += n;
+        size -= n;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+static status_t push_run(hfs_fork_t *fork, u32 file_block, u32 start, u32 count) {
+    if (fork->count) {
+        hfs_run_t *last = &fork->runs[fork->count - 1];
+        if (last->start + last->count == start) {
+            last->count += count;
+            return STATUS_SUCCESS;
+        }
+    }
+
+    if (fork->count == fork->capacity) {
+        u32 capacity = fork->capacity ? fork->capacity * 2 : EXTENTS_PER_RECORD;
+        hfs_run_t *runs = mem_alloc(capacity * sizeof(hfs_run_t));
+        if (!runs)
+            return STATUS_OUT_OF_MEMORY;
+
+        if (fork->runs) {
+            memcpy(runs, fork->runs, fork->count * sizeof(hfs_run_t));
+            mem_free(fork->runs);
+        }
+        fork->runs = runs;
+        fork->capacity = capacity;
+    }
+
+    hfs_run_t *r = &fork->runs[fork->count++];
+    r->file_block = file_block;
+    r->start = start;
+    r->count = count;
+    return STATUS_SUCCESS;
+}
+
+static void free_fork(hfs_fork_t *fork) {
+    if (fork->runs)
+        mem_free(fork->runs);
+    fork->runs = NULL;
+    fork->count = fork->capacity = 0;
+}
+
+typedef int (*key_cmp_t)(const hfs_volume_t *vol, const u8 *key, u32 len, const void *ctx);
+
+static status_t btree_find(hfs_volume_t *vol, const hfs_btree_t *tree,
+                           key_cmp_t cmp, const void *ctx,
+                           const u8 **data, u32 *data_len, bool *exact);
+
+typedef struct {
+    u32 id;
+    u8 fork;
+    u32 start;
+} extent_key_t;
+
+/* HFSPlusExtentKey: fileID, then forkType, then startBlock */
+static int cmp_extent_key(const hfs_volume_t *vol, const u8 *key, u32 len, const void *ctx) {
+    const extent_key_t *k = (const extent_key_t *)ctx;
+    (void)vol;
+
+    if (len < 12)
+        return 1;
+
+    u32 id = be32(key + 4);
+    if (id != k->id)
+        return id < k->id ? -1 : 1;
+    if (key[2] != k->fork)
+        return key[2] < k->fork ? -1 : 1;
+
+    u32 start = be32(key + 8);
+    if (start != k->start)
+        return start < k->start ? -1 : 1;
+    return 0;
+}
+
+/* The fork's whole extent list: the 8 in `data`, then overflow records */
+static status_t load_fork(hfs_volume_t *vol, const u8 *data, u32 id, u8 type, hfs_fork_t *fork) {
+    u32 total = be32(data + FORK_TOTAL_BLOCKS);
+    u32 blocks = 0;
+    u8 record[EXTENT_RECORD_SIZE];
+
+    memset(fork, 0, sizeof(*fork));
+    fork->size = be64(data + FORK_LOGICAL_SIZE);
+    if ((fork->size + vol->block_size - 1) / vol->block_size > total)
+        return STATUS_ERROR;
+
+    memcpy(record, data + FORK_EXTENTS, sizeof(record));
+
+    for (;;) {
+        u32 before = blocks;
+
+        for (u32 i = 0; i < EXTENTS_PER_RECORD && blocks < total; i++) {
+            u32 start = be32(record + i * 8);
+            u32 count = be32(record + i * 8 + 4);
+            if (!count)
+                break;
+            if (count > total - blocks)
+                count = total - blocks;
+
+            status_t status = push_run(fork, blocks, start, count);
+            if (status != STATUS_SUCCESS)
+                return status;
+            blocks += count;
+        }
+
+        if (blocks == total)
+            return STATUS_SUCCESS;
+
+        /* an empty record would be looked up again at the same key */
+        if (blocks == before)
+            return STATUS_ERROR;
+
+        /* the extents file's own extents never overflow */
+        if (id == CNID_EXTENTS_FILE)
+            return STATUS_ERROR;
+
+        extent_key_t key = { id, type, blocks };
+        const u8 *rec;
+        u32 len;
+        bool exact;
+
+        status_t status = btree_find(vol, &vol->extents, cmp_extent_key, &key, &rec, &len, &exact);
+        if (status != STATUS_SUCCESS || !exact || len < EXTENT_RECORD_SIZE)
+            return status != STATUS_SUCCESS ? status : STATUS_ERROR;
+        memcpy(record, rec, sizeof(record));
+    }
+}
+
+/* =========================
+ *  B-trees
+ * ========================= */
+
+/* Node `node` of `tree`, from the cache or the disk */
+static const u8 *read_node(hfs_volume_t *vol, const hfs_btree_t *tree, u32 node) {
+    hfs_node_t *victim = &vol->nodes[0];
+
+    for (u32 i = 0; i < HFS_NODE_CACHE; i++) {
+        hfs_node_t *n = &vol->nodes[i];
+        if (n->tag == tree->tag && n->node == node) {
+            n->used = ++vol->clock;
+            return n->data;
+        }
+        if (n->used < victim->used)
+            victim = n;
+    }
+
+    victim->tag = 0;
+    if (fork_read(vol, &tree->fork, (u64)node * tree->node_size,
+                  tree->node_size, victim->data) != STATUS_SUCCESS)
+        return NULL;
+
+    /* the record offsets at the end must fit */
+    u32 num = be16(victim->data + NODE_NUM_RECORDS);
+    if (NODE_DESCRIPTOR_SIZE + 2 * (num + 1) > tree->node_size)
+        return NULL;
+
+    victim->tag = tree->tag;
+    victim->node = node;
+    victim->used = ++vol->clock;
+    return victim->data;
+}
+
+/* Key (length field included) and data of record `i`; false if corrupt */
+static bool node_record(const hfs_btree_t *tree, const u8 *node, u32 i, bool index,
+                        const u8 **key, u32 *key_len, const u8 **data, u32 *data_len) {
+    u32 size = tree->node_size;
+    u32 num = be16(node + NODE_NUM_RECORDS);
+    u32 start = be16(node + size - 2 * (i + 1));
+    u32 end = be16(node + size - 2 * (i + 2));
+
+    if (start < NODE_DESCRIPTOR_SIZE || end > size - 2 * (num + 1) || start + 2 > end)
+        return false;
+
+    /* index keys take maxKeyLength unless the tree says they vary */
+    u32 len = be16(node + start);
+    u32 space = (index && !(tree->attributes & BT_VARIABLE_INDEX_KEYS)) ? tree->max_key : len;
+    if (start + 2 + space > end)
+        return false;
+
+    *key = node + start;
+    *key_len = 2 + len;
+    *data = node + start + 2 + space;
+    *data_len = end - (start + 2 + space);
+    return true;
+}
+
+/*
+ * The leaf record with the largest key <= the search key; `cmp` returns
+ * the sign of (record key - search key). *data points into the node
+ * cache and is only good until the next node read.
+ */
+static status_t btree_find(hfs_volume_t *vol, const hfs_btree_t *tree,
+                           key_cmp_t cmp, const void *ctx,
+                           const u8 **data, u32 *data_len, bool *exact) {
+    u32 node = tree->root;
+
+    if (!tree->tag || !node)
+        return STATUS_NOT_FOUND;
+
+    for (u32 depth = 0; depth < HFS_MAX_DEPTH; depth++) {
+        const u8 *n = read_node(vol, tree, node);
+        if (!n)
+            return STATUS_ERROR;
+
+        s8 kind = (s8)n[NODE_KIND];
+        bool index = kind == NODE_INDEX;
+        if (!index && kind != NODE_LEAF)
+            return STATUS_ERROR;
+
+        const u8 *key, *d;
+        u32 key_len, d_len;
+        s32 lo = 0, hi = (s32)be16(n + NODE_NUM_RECORDS) - 1;
+        s32 pick = -1;
+        int pick_cmp = 0;
+
+        while (lo <= hi) {
+            s32 mid = lo + (hi - lo) / 2;
+            if (!node_record(tree, n, (u32)mid, index, &key, &key_len, &d, &d_len))
+                return STATUS_ERROR;
+
+            int c = cmp(vol, key, key_len, ctx);
+            if (c <= 0) {
+                pick = mid;
+                pick_cmp = c;
+                lo = mid + 1;
+            } else {
+                hi = mid - 1;
+            }
+        }
+
+        if (pick < 0)
+            return STATUS_NOT_FOUND;
+        node_record(tree, n, (u32)pick, index, &key, &key_len, &d, &d_len);
+
+        if (!index) {
+            *data = d;
+            *data_len = d_len;
+            *exact = pick_cmp == 0;
+            return STATUS_SUCCESS;
+        }
+
+        if (d_len < 4)
+            return STATUS_ERROR;
+        node = be32(d);
+    }
+
+    return STATUS_ERROR;
+}
+
+/* The header record, from the fork's first extent (node 0 can't overflow) */
+static status_t read_btree_header(hfs_volume_t *vol, const u8 *fork, hfs_btree_t *tree, u8 tag) {
+    u8 hdr[HDR_SIZE];
+    u32 start = be32(fork + FORK_EXTENTS);
+    u32 count = be32(fork + FORK_EXTENTS + 4);
+
+    memset(tree, 0, sizeof(*tree));
+    if (!be64(fork + FORK_LOGICAL_SIZE))
+        return STATUS_NOT_FOUND;
+
+    if (!count || block_read_bytes(vol->base.device, (u64)start * vol->block_size,
+                                   sizeof(hdr), hdr) != STATUS_SUCCESS)
+        return STATUS_ERROR;
+    if ((s8)hdr[NODE_KIND] != NODE_HEADER)
+        return STATUS_ERROR;
+
+    tree->root = be32(hdr + HDR_ROOT_NODE);
+    tree->node_size = be16(hdr + HDR_NODE_SIZE);
+    tree->max_key = be16(hdr + HDR_MAX_KEY_LENGTH);
+    tree->compare = hdr[HDR_KEY_COMPARE];
+    tree->attributes = be32(hdr + HDR_ATTRIBUTES);
+
+    u32 ns = tree->node_size;
+    if (ns < 512 || ns > HFS_NODE_SIZE_MAX || (ns & (ns - 1)) ||
+        !(tree->attributes & BT_BIG_KEYS))
+        return STATUS_ERROR;
+
+    tree->tag = tag;
+    return STATUS_SUCCESS;
+}
+
+/* =========================
+ *  Catalog
+ * ========================= */
+
+typedef struct {
+    u32 parent;
+    const u16 *name;
+    u32 len;
+} catalog_key_t;
+
+/* HFS+ case folding, for the characters boot paths use: NUL sorts last */
+static inline u16 fold(u16 c) {
+    if (c == 0)
+        return 0xFFFF;
+    if ((c >= 'A' && c <= 'Z') || (c >= 0xC0 && c <= 0xDE && c != 0xD7))
+        return (u16)(c + 0x20);
+    return c;
+}
+
+/* HFSPlusCatalogKey: parentID, then the name */
+static int cmp_catalog_key(const hfs_volume_t *vol, const u8 *key, u32 len, const void *ctx) {
+    const catalog_key_t *k = (const catalog_key_t *)ctx;
+
+    if (len < 8)
+        return 1;
+
+    u32 parent = be32(key + 2);
+    if (parent != k->parent)
+        return parent < k->parent ? -1 : 1;
+
+    u32 n = be16(key + 6);
+    if (8 + 2 * n > len)
+        n = (len - 8) / 2;
+
+    for (u32 i = 0; i < n && i < k->len; i++) {
+        u16 a = be16(key + 8 + 2 * i);
+        u16 b = k->name[i];
+        if (!vol->case_sensitive) {
+            a = fold(a);
+            b = fold(b);
+        }
+        if (a != b)
+            return a < b ? -1 : 1;
+    }
+
+    if (n == k->len)
+        return 0;
+    return n < k->len ? -1 : 1;
+}
+
+/* Record of `name` in folder `parent`, copied into rec[FILE_RECORD_SIZE] */
+static status_t lookup(hfs_volume_t *vol, u32 parent, const u16 *name, u32 len, u8 *rec) {
+    catalog_key_t key = { parent, name, len };
+    const u8 *data;
+    u32 data_len;
+    bool exact;
+
+    status_t status = btree_find(vol, &vol->catalog, cmp_catalog_key, &key, &data, &data_len, &exact);
+    if (status != STATUS_SUCCESS)
+        return status;
+    if (!exact || data_len < 2)
+        return STATUS_NOT_FOUND;
+
+    memset(rec, 0, FILE_RECORD_SIZE);
+    memcpy(rec, data, data_len < FILE_RECORD_SIZE ? data_len : FILE_RECORD_SIZE);
+
+    switch (be16(rec)) {
+    case CAT_FOLDER:
+        return data_len >= FOLDER_RECORD_SIZE ? STATUS_SUCCESS : STATUS_ERROR;
+    case CAT_FILE:
+        return data_len >= FILE_RECORD_SIZE ? STATUS_SUCCESS : STATUS_ERROR;
+    default:
+        return STATUS_NOT_FOUND;
+    }
+}
+
+/* "\0\0\0\0HFS+ Private Data", where hard-linked files live */
+static const u16 private_folder_name[] = {
+    0, 0, 0, 0, 'H', 'F', 'S', '+', ' ', 'P', 'r', 'i', 'v', 'a', 't', 'e',
+    ' ', 'D', 'a', 't', 'a'
+};
+
+/* Replace a hard link's record with its target's, "iNode<n>" */
+static status_t resolve_hardlink(hfs_volume_t *vol, u8 *rec) {
+    u16 name[16] = { 'i', 'N', 'o', 'd', 'e' };
+    char digits[10];
+    u32 len = 5, count = 0;
+    u32 inode = be32(rec + FILE_SPECIAL);
+
+    if (!vol->private_folder) {
+        u8 folder[FILE_RECORD_SIZE];
+        u32 n = sizeof(private_folder_name) / sizeof(private_folder_name[0]);
+        if (lookup(vol, CNID_ROOT_FOLDER, private_folder_name, n, folder) != STATUS_SUCCESS ||
+            be16(folder) != CAT_FOLDER)
+            return STATUS_NOT_FOUND;
+        vol->private_folder = be32(folder + CAT_ID);
+    }
+
+    do {
+        digits[count++] = (char)('0' + inode % 10);
+        inode /= 10;
+    } while (inode);
+    while (count)
+        name[len++] = (u16)digits[--count];
+
+    status_t status = lookup(vol, vol->private_folder, name, len, rec);
+    if (status == STATUS_SUCCESS && be16(rec) != CAT_FILE)
+        status = STATUS_NOT_FOUND;
+    return status;
+}
+
+/* =========================
+ *  decmpfs
+ * ========================= */
+
+typedef struct {
+    u32 id;
+    const u16 *name;
+    u32 len;
+} attr_key_t;
+
+static const u16 decmpfs_name[] = {
+    'c', 'o', 'm', '.', 'a', 'p', 'p', 'l', 'e', '.',
+    'd', 'e', 'c', 'm', 'p', 'f', 's'
+};
+
+/* HFSPlusAttrKey: fileID, then the name (binary), then startBlock */
+static int cmp_attr_key(const hfs_volume_t *vol, const u8 *key, u32 len, const void *ctx) {
+    const attr_key_t *k = (const attr_key_t *)ctx;
+    (void)vol;
+
+    if (len < 14)
+        return 1;
+
+    u32 id = be32(key + 4);
+    if (id != k->id)
+        return id < k->id ? -1 : 1;
+
+    u32 n = be16(key + 12);
+    if (14 + 2 * n > len)
+        n = (len - 14) / 2;
+
+    for (u32 i = 0; i < n && i < k->len; i++) {
+        u16 a = be16(key + 14 + 2 * i);
+        if (a != k->name[i])
+            return a < k->name[i] ? -1 : 1;
+    }
+    if (n != k->len)
+        return n < k->len ? -1 : 1;
+
+    return be32(key + 8) ? 1 : 0;
+}
+
+typedef struct {
+    const u8 *in;
+    size_t in_len;
+    u8 *out;
+    size_t produced;
+    size_t capacity;
+} inflate_buf_t;
+
+static size_t inflate_in(void *ctx, const u8 **data) {
+    inflate_buf_t *z = (inflate_buf_t *)ctx;
+    size_t n = z->in_len;
+
+    *data = z->in;
+    z->in_len = 0;
+    return n;
+}
+
+static int inflate_out(void *ctx, const u8 *data, size_t len) {
+    inflate_buf_t *z = (inflate_buf_t *)ctx;
+
+    if (len > z->capacity - z->produced)
+        return -1;
+    memcpy(z->out + z->produced, data, len);
+    z->produced += len;
+    return 0;
+}
+
+/*
+ * One decmpfs unit into exactly `out_len` bytes. Units that would not
+ * shrink are stored as is behind a marker byte: one with the low nibble
+ * 0xF for zlib (never a zlib header), the end-of-stream opcode for LZVN.
+ */
+static status_t decode_unit(u32 compression, const u8 *in, size_t in_len, u8 *out, size_t out_len) {
+    size_t produced;
+    int rc;
+
+    if (!in_len)
+        return out_len ? STATUS_CRC_ERROR : STATUS_SUCCESS;
+
+    if (compression == DECMPFS_LZVN_INLINE || compression == DECMPFS_LZVN_RESOURCE) {
+        if (in[0] == 0x06) {
+            if (in_len - 1 < out_len)
+                return STATUS_CRC_ERROR;
+            memcpy(out, in + 1, out_len);
+            return STATUS_SUCCESS;
+        }
+        rc = lzvn_decompress(in, in_len, out, out_len, &produced);
+        return (rc == 0 && produced == out_len) ? STATUS_SUCCESS : STATUS_CRC_ERROR;
+    }
+
+    if (compression == DECMPFS_LZFSE_INLINE || compression == DECMPFS_LZFSE_RESOURCE) {
+        rc = lzfse_decompress(in, in_len, out, out_len, &produced);
+        return (rc == 0 && produced == out_len) ? STATUS_SUCCESS : STATUS_CRC_ERROR;
+    }
+
+    if ((in[0] & 0x0F) == 0x0F) {
+        if (in_len - 1 < out_len)
+            return STATUS_CRC_ERROR;
+        memcpy(out, in + 1, out_len);
+        return STATUS_SUCCESS;
+    }
+
+    /* the decoder's state is scratch */
+    arena_mark_t mark = arena_mark();
+    inflate_buf_t z = { in, in_len, out, 0, out_len };
+    rc = inflate_stream(INFLATE_ZLIB, inflate_in, inflate_out, &z);
+    arena_release(mark);
+
+    return (rc == 0 && z.produced == out_len) ? STATUS_SUCCESS : STATUS_CRC_ERROR;
+}
+
+/*
+ * LZVN / LZFSE resource forks are bare: num_blocks + 1 offsets from the
+ * fork's start, the first one (`first`, already read) being the table's
+ * own size and each of the rest where a block ends. Rewritten into the
+ * {offset, size} table zlib files use.
+ */
+static status_t open_offset_table(hfs_volume_t *vol, hfs_file_t *f, u32 first) {
+    u64 blocks = (f->base.size + DECMPFS_BLOCK_SIZE - 1) / DECMPFS_BLOCK_SIZE;
+
+    if (first % 4 || first / 4 != blocks + 1)
+        return STATUS_ERROR;
+
+    f->num_blocks = (u32)blocks;
+    f->table_base = 0;
+    f->table = mem_alloc(blocks ? (size_t)blocks * 8 : 1);
+    f->data = mem_alloc(DECMPFS_BLOCK_SIZE);
+    if (!f->table || !f->data)
+        return STATUS_OUT_OF_MEMORY;
+
+    /*
+     * The ends are read into the table's upper half and spread out from
+     * the front: entry i only ever overwrites ends up to its own.
+     */
+    u8 *ends = f->table + (size_t)blocks * 4;
+    status_t status = fork_read(vol, &f->fork, 4, blocks * 4, ends);
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    u32 start = first;
+    for (u32 i = 0; i < f->num_blocks; i++) {
+        u32 end = le32(ends + (size_t)i * 4);
+        if (end < start)
+            return STATUS_ERROR;
+        put_le32(f->table + (size_t)i * 8, start);
+        put_le32(f->table + (size_t)i * 8 + 4, end - start);
+        start = end;
+    }
+    return STATUS_SUCCESS;
+}
+
+static status_t open_compressed(hfs_volume_t *vol, hfs_file_t *f, const u8 *rec, u32 id) {
+    attr_key_t key = { id, decmpfs_name, sizeof(decmpfs_name) / sizeof(decmpfs_name[0]) };
+    const u8 *attr;
+    u32 len;
+    bool exact;
+
+    status_t status = btree_find(vol, &vol->attributes, cmp_attr_key, &key, &attr, &len, &exact);
+    if (status != STATUS_SUCCESS || !exact)
+        return status != STATUS_SUCCESS ? status : STATUS_NOT_FOUND;
+
+    /* the attribute stays in the node cache until the next node read */
+    if (len < ATTR_DATA || be32(attr) != ATTR_INLINE_DATA)
+        return STATUS_ERROR;
+
+    u32 size = be32(attr + ATTR_DATA_SIZE);
+    const u8 *hdr = attr + ATTR_DATA;
+    if (size < DECMPFS_HEADER_SIZE || size > len - ATTR_DATA || le32(hdr) != DECMPFS_MAGIC)
+        return STATUS_ERROR;
+
+    f->compression = le32(hdr + 4);
+    f->base.size = le64(hdr + 8);
+
+    switch (f->compression) {
+    case DECMPFS_RAW_INLINE:
+    case DECMPFS_ZLIB_INLINE:
+    case DECMPFS_LZVN_INLINE:
+    case DECMPFS_LZFSE_INLINE: {
+        const u8 *payload = hdr + DECMPFS_HEADER_SIZE;
+        size_t payload_len = size - DECMPFS_HEADER_SIZE;
+
+        if (f->base.size > HFS_INLINE_MAX)
+            return STATUS_ERROR;
+        f->data = mem_alloc(f->base.size ? (size_t)f->base.size : 1);
+        if (!f->data)
+            return STATUS_OUT_OF_MEMORY;
+
+        if (f->compression == DECMPFS_RAW_INLINE) {
+            if (payload_len < f->base.size)
+                return STATUS_CRC_ERROR;
+            memcpy(f->data, payload, (size_t)f->base.size);
+            return STATUS_SUCCESS;
+        }
+        return decode_unit(f->compression, payload, payload_len, f->data, (size_t)f->base.size);
+    }
+
+    case DECMPFS_ZLIB_RESOURCE:
+    case DECMPFS_LZVN_RESOURCE:
+    case DECMPFS_LZFSE_RESOURCE:
+        break;
+
+    default:
+        printf("hfs: decmpfs type %u not supported\n", f->compression);
+        return STATUS_ERROR;
+    }
+
+    u8 word[4];
+
+    status = load_fork(vol, rec + FILE_RESOURCE_FORK, id, FORK_RESOURCE, &f->fork);
+    if (status == STATUS_SUCCESS)
+        status = fork_read(vol, &f->fork, 0, sizeof(word), word);
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    if (f->compression != DECMPFS_ZLIB_RESOURCE)
+        return open_offset_table(vol, f, le32(word));
+
+    /*
+     * zlib: a resource header whose first word is the data offset, the
+     * data's length word, then the block table.
+     */
+
+    f->table_base = (u64)be32(word) + 4;
+    status = fork_read(vol, &f->fork, f->table_base, sizeof(word), word);
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    f->num_blocks = le32(word);
+    if ((u64)f->num_blocks != (f->base.size + DECMPFS_BLOCK_SIZE - 1) / DECMPFS_BLOCK_SIZE)
+        return STATUS_ERROR;
+
+    f->table = mem_alloc(f->num_blocks ? (size_t)f->num_blocks * 8 : 1);
+    f->data = mem_alloc(DECMPFS_BLOCK_SIZE);
+    if (!f->table || !f->data)
+        return STATUS_OUT_OF_MEMORY;
+
+    return fork_read(vol, &f->fork, f->table_base + 4, (u64)f->num_blocks * 8, f->table);
+}
+
+/* Resource-fork block `block` into f->data */
+static status_t load_block(hfs_volume_t *vol, hfs_file_t *f, u32 block) {
+    if (f->block == block + 1)
+        return STATUS_SUCCESS;
+
+    u32 offset = le32(f->table + (size_t)block * 8);
+    u32 size = le32(f->table + (size_t)block * 8 + 4);
+    u64 left = f->base.size - (u64)block * DECMPFS_BLOCK_SIZE;
+    size_t out_len = left < DECMPFS_BLOCK_SIZE ? (size_t)left : DECMPFS_BLOCK_SIZE;
+
+    /* stored blocks carry one marker byte on top; LZ-coded ones a little framing */
+    if (size > 2 * DECMPFS_BLOCK_SIZE)
+        return STATUS_ERROR;
+
+    f->block = 0;
+
+    arena_mark_t mark = arena_mark();
+    u8 *in = arena_alloc(size ? size : 1);
+    status_t status = in ? fork_read(vol, &f->fork, f->table_base + offset, size, in)
+                         : STATUS_OUT_OF_MEMORY;
+    if (status == STATUS_SUCCESS)
+        status = decode_unit(f->compression, in, size, f->data, out_len);
+    arena_release(mark);
+
+    if (status == STATUS_SUCCESS)
+        f->block = block + 1;
+    return status;
+}
+
+/* =========================
+ *  fs_ops_t
+ * ========================= */
+
+static void hfs_close(fs_file_t *file) {
+    hfs_file_t *f = (hfs_file_t *)file;
+
+    free_fork(&f->fork);
+    if (f->data)
+        mem_free(f->data);
+    if (f->table)
+        mem_free(f->table);
+    mem_free(f);
+}
+
+static status_t hfs_mount(block_device_t *dev, fs_volume_t **out) {
+    u8 vh[512];
+
+    if (!dev->block_size ||
+        block_read_bytes(dev, HFS_VOLUME_HEADER, sizeof(vh), vh) != STATUS_SUCCESS)
+        return STATUS_NOT_FOUND;
+
+    u16 sig = be16(vh + VH_SIGNATURE);
+    if (sig != HFS_SIG_PLUS && sig != HFS_SIG_X)
+        return STATUS_NOT_FOUND;
+
+    u32 bs = be32(vh + VH_BLOCK_SIZE);
+    if (bs < 512 || (bs & (bs - 1)))
+        return STATUS_ERROR;
+
+    hfs_volume_t *vol = mem_alloc_zero(sizeof(hfs_volume_t));
+    if (!vol)
+        return STATUS_OUT_OF_MEMORY;
+
+    vol->base.ops = &hfsplus_fs_ops;
+    vol->base.device = dev;
+    vol->block_size = bs;
+
+    /* headers first: the node cache is sized for the largest node */
+    status_t status = read_btree_header(vol, vh + VH_EXTENTS_FORK, &vol->extents, 1);
+    if (status == STATUS_SUCCESS)
+        status = read_btree_header(vol, vh + VH_CATALOG_FORK, &vol->catalog, 2);
+    if (status == STATUS_SUCCESS &&
+        read_btree_header(vol, vh + VH_ATTRIBUTES_FORK, &vol->attributes, 3) == STATUS_ERROR)
+        status = STATUS_ERROR;
+    if (status != STATUS_SUCCESS) {
+        mem_free(vol);
+        return STATUS_ERROR;
+    }
+
+    u32 node_size = vol->catalog.node_size;
+    if (vol->extents.node_size > node_size)
+        node_size = vol->extents.node_size;
+    if (vol->attributes.node_size > node_size)
+        node_size = vol->attributes.node_size;
+
+    /* volumes stay mounted until handoff */
+    u8 *pool = boot_alloc((size_t)HFS_NODE_CACHE * node_size);
+    if (!pool) {
+        mem_free(vol);
+        return STATUS_OUT_OF_MEMORY;
+    }
+    for (u32 i = 0; i < HFS_NODE_CACHE; i++)
+        vol->nodes[i].data = pool + (size_t)i * node_size;
+
+    /* the catalog and attributes files may have overflow extents */
+    status = load_fork(vol, vh + VH_EXTENTS_FORK, CNID_EXTENTS_FILE, FORK_DATA, &vol->extents.fork);
+    if (status == STATUS_SUCCESS)
+        status = load_fork(vol, vh + VH_CATALOG_FORK, CNID_CATALOG_FILE, FORK_DATA, &vol->catalog.fork);
+    if (status == STATUS_SUCCESS && vol->attributes.tag)
+        status = load_fork(vol, vh + VH_ATTRIBUTES_FORK, CNID_ATTRIBUTES_FILE, FORK_DATA,
+                           &vol->attributes.fork);
+    if (status != STATUS_SUCCESS) {
+        free_fork(&vol->extents.fork);
+        free_fork(&vol->catalog.fork);
+        free_fork(&vol->attributes.fork);
+        mem_free(vol);
+        return status;
+    }
+
+    vol->case_sensitive = sig == HFS_SIG_X && vol->catalog.compare == KEY_COMPARE_BINARY;
+
+    *out = &vol->base;
+    return STATUS_SUCCESS;
+}
+
+static status_t hfs_open(fs_volume_t *v, const char *path, fs_file_t **out) {
+    hfs_volume_t *vol = (hfs_volume_t *)v;
+    u8 rec[FILE_RECORD_SIZE];
+    u16 name16[HFS_NAME_MAX];
+    const char *name;
+    size_t len;
+    u32 parent = CNID_ROOT_FOLDER;
+    status_t status;
+
+    /* the root is no file */
+    const char *rest = fs_path_next(path, &name, &len);
+    if (!rest)
+        return STATUS_NOT_FOUND;
+
+    for (;;) {
+        s32 n = fs_utf8_to_utf16(name, len, name16, HFS_NAME_MAX);
+        if (n < 0)
+            return STATUS_INVALID_PARAM;
+
+        status = lookup(vol, parent, name16, (u32)n, rec);
+        if (status != STATUS_SUCCESS)
+            return status;
+
+        rest = fs_path_next(rest, &name, &len);
+        if (!rest)
+            break;
+
+        if (be16(rec) != CAT_FOLDER)
+            return STATUS_NOT_FOUND;
+        parent = be32(rec + CAT_ID);
+    }
+
+    if (be16(rec) != CAT_FILE)
+        return STATUS_NOT_FOUND;
+
+    if (be32(rec + FILE_TYPE) == HARDLINK_TYPE && be32(rec + FILE_CREATOR) == HARDLINK_CREATOR) {
+        status = resolve_hardlink(vol, rec);
+        if (status != STATUS_SUCCESS)
+            return status;
+    }
+
+    hfs_file_t *f = mem_alloc_zero(sizeof(hfs_file_t));
+    if (!f)
+        return STATUS_OUT_OF_MEMORY;
+
+    u32 id = be32(rec + CAT_ID);
+    if (rec[FILE_OWNER_FLAGS] & UF_COMPRESSED) {
+        status = open_compressed(vol, f, rec, id);
+    } else {
+        status = load_fork(vol, rec + FILE_DATA_FORK, id, FORK_DATA, &f->fork);
+        f->base.size = f->fork.size;
+    }
+
+    if (status != STATUS_SUCCESS) {
+        hfs_close(&f->base);
+        return status;
+    }
+
+    *out = &f->base;
+    return STATUS_SUCCESS;
+}
+
+static size_t hfs_read(fs_file_t *file, u64 offset, void *buf, size_t size) {
+    hfs_file_t *f = (hfs_file_t *)file;
+    hfs_volume_t *vol = (hfs_volume_t *)file->volume;
+    u8 *out = (u8 *)buf;
+    size_t done = 0;
+
+    if (offset >= file->size)
+        return 0;
+    if (size > file->size - offset)
+        size = (size_t)(file->size - offset);
+
+    switch (f->compression) {
+    case 0:
+        return fork_read(vol, &f->fork, offset, size, buf) == STATUS_SUCCESS ? size : 0;
+
+    case DECMPFS_ZLIB_RESOURCE:
+    case DECMPFS_LZVN_RESOURCE:
+    case DECMPFS_LZFSE_RESOURCE:
+        while (done < size) {
+            u64 pos = offset + done;
+            u32 block = (u32)(pos / DECMPFS_BLOCK_SIZE);
+            u32 skip = (u32)(pos % DECMPFS_BLOCK_SIZE);
+            size_t n = DECMPFS_BLOCK_SIZE - skip;
+            if (n > size - done)
+                n = size - done;
+
+            if (load_block(vol, f, block) != STATUS_SUCCESS)
+                break;
+            memcpy(out + done, f->data + skip, n);
+            done += n;
+        }
+        return done;
+
+    default:
+        memcpy(out, f->data + offset, size);
+        return size;
+    }
+}
+
+static int hfs_map(fs_file_t *file, u64 offset, fs_extent_t *out) {
+    hfs_file_t *f = (hfs_file_t *)file;
+    hfs_volume_t *vol = (hfs_volume_t *)file->volume;
+    block_device_t *dev = vol->base.device;
+    u32 bs = vol->block_size;
+
+    if (f->compression)
+        return -1;
+
+    const hfs_run_t *r = find_run(&f->fork, offset / bs);
+    if (!r)
+        return -1;
+
+    u64 skip = offset - (u64)r->file_block * bs;
+    u64 byte = (u64)r->start * bs + skip;
+    if (byte % dev->block_size)
+        return -1;
+
+    out->device = dev;
+    out->lba = byte / dev->block_size;
+    out->length = (u64)r->count * bs - skip;
+    if (out->length > file->size - offset)
+        out->length = file->size - offset;
+    return 0;
+}
+
+const fs_ops_t hfsplus_fs_ops = {
+    .name = "hfsplus",
+    .mount = hfs_mount,
+    .open = hfs_open,
+    .read = hfs_read,
+    .close = hfs_close,
+    .map = hfs_map,
+};
@@ -0,0 +1,33 @@
+#ifndef HFSPLUS_H
+#define HFSPLUS_H
+
+#include "../../Fs.h"
+
+/*
+ * OpenCore Mobile – HFS+ / HFSX, read-only
+ *
+ * A filesystem driver for Fs.h, after Apple TN1150. Mounting reads the
+ * volume header and the B-tree headers; the nodes of the catalog,
+ * extents and attributes trees then come through one LRU node cache per
+ * volume, so walking a path re-reads nothing but the leaves it has not
+ * seen yet.
+ *
+ * Opening a file resolves its whole extent list (overflow records
+ * included) up front. fs_read() turns each contiguous run into one
+ * block-layer request straight into the caller's buffer, and fs_map()
+ * hands the runs to loop devices (ImgLd.c).
+ *
+ * decmpfs-compressed files (UF_COMPRESSED) are decoded transparently,
+ * zlib, LZVN and LZFSE alike: inline attributes at open, resource-fork
+ * 64 KiB blocks as reads reach them.
+ *
+ * Not supported: the HFS wrapper around embedded volumes, journal replay
+ * (a volume that was not unmounted cleanly may read stale metadata),
+ * symbolic links and directory hard links. Name comparison on
+ * case-insensitive volumes folds ASCII and Latin-1; names with other
+ * letters that have case may fail to match.
+ */
+
+extern const fs_ops_t hfsplus_fs_ops;
+
+#endif /* HFSPLUS_H */
@@ -1,3 +1,1047 @@
-#include "../bootstd.h"
+#include "Kextld.h"
+#include "../Memory.h"
+#include "../Payload.h"
+#include "../Smp.h"
+#include "../Trace.h"
+#include "../arch/aarch64/io.h"
+#include "../arch/aarch64/timer.h"
+#include "crc32/crc32.h"
 
-//
+/*
+ * OpenCore Mobile – prelinked kext collections
+ * See Kextld.h.
+ */
+
+/* =========================
+ *  Checking
+ * ========================= */
+
+/* [offset, offset + size) lies within a file of `limit` bytes */
+static bool within(u64 offset, u64 size, u64 limit) {
+    return offset <= limit && size <= limit - offset;
+}
+
+static const char *string_at(const kext_collection_t *kc, u32 offset) {
+    return offset < kc->header->strings_size ? kc->strings + offset : NULL;
+}
+
+/* Everything but the fixups, which are checked as they are applied */
+static bool check(kext_collection_t *kc) {
+    const kextc_header_t *h = kc->header;
+    u8 *base = kc->image;
+
+    if (kc->size < sizeof(*h) || memcmp(h->magic, KEXTC_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != KEXTC_VERSION || h->image_size != kc->size)
+        return false;
+
+    if (!within(h->kexts_offset, (u64)h->kext_count * sizeof(kextc_kext_t), kc->size) ||
+        !within(h->symbols_offset, (u64)h->symbol_count * sizeof(kextc_symbol_t), kc->size) ||
+        !within(h->fixups_offset, (u64)h->fixup_count * sizeof(u32), kc->size) ||
+        !within(h->strings_offset, h->strings_size, kc->size) ||
+        !within(h->info_offset, h->info_size, kc->size) ||
+        !within(h->payload_offset, h->payload_size, kc->size) ||
+        ((h->kexts_offset | h->symbols_offset | h->info_offset) & 7) ||
+        (h->fixups_offset & 3) || (h->payload_offset & (KEXTC_PAGE - 1)) ||
+        (h->base & (KEXTC_PAGE - 1)) || h->payload_size > 0xFFFFFFFFu)
+        return false;
+
+    kc->strings = (const char *)base + h->strings_offset;
+    if (!h->strings_size || kc->strings[h->strings_size - 1] != '\0')
+        return false;
+
+    if (crc32_calculate(base + sizeof(*h), kc->size - sizeof(*h)) != h->image_crc)
+        return false;
+
+    const kextc_kext_t *kexts = (const kextc_kext_t *)(base + h->kexts_offset);
+
+    for (u32 i = 0; i < h->kext_count; i++) {
+        const kextc_kext_t *k = &kexts[i];
+
+        if (!string_at(kc, k->bundle_id) ||
+            (k->executable != KEXTC_NONE && !within(k->executable, k->size, h->payload_size)) ||
+            (k->kmod_info != KEXTC_NONE && !within(k->kmod_info, 1, h->payload_size)))
+            return false;
+    }
+
+    kc->symbols = (const kextc_symbol_t *)(base + h->symbols_offset);
+    kc->symbol_count = h->symbol_count;
+    for (u32 i = 0; i < h->symbol_count; i++) {
+        const kextc_symbol_t *s = &kc->symbols[i];
+
+        if (!string_at(kc, s->name) || s->kext >= h->kext_count ||
+            !within(s->offset, 1, h->payload_size))
+            return false;
+    }
+
+    return plist_image_map(base + h->info_offset, (size_t)h->info_size, &kc->info) == 0;
+}
+
+/* =========================
+ *  Loading
+ * ========================= */
+
+/* The slide pass; false (the payload half slid) on a fixup outside it */
+static bool slide(kext_collection_t *kc) {
+    const kextc_header_t *h = kc->header;
+    const u32 *fixups = (const u32 *)((u8 *)kc->image + h->fixups_offset);
+
+    if (!kc->slide)
+        return true;
+
+    for (u32 i = 0; i < h->fixup_count; i++) {
+        u32 off = fixups[i];
+
+        if ((off & 7) || (u64)off + 8 > h->payload_size)
+            return false;
+        *(u64 *)(kc->payload + off) += kc->slide;
+    }
+    return true;
+}
+
+/* kext_t per kext, its Info.plist found by walking _PrelinkInfoDictionary once */
+static status_t publish(kext_collection_t *kc) {
+    const kextc_header_t *h = kc->header;
+    const kextc_kext_t *kexts = (const kextc_kext_t *)((u8 *)kc->image + h->kexts_offset);
+    const plist_entry_t *list = plist_get(&kc->info, "_PrelinkInfoDictionary");
+
+    if (!list || list->type != PLIST_ARRAY || list->count != h->kext_count)
+        return STATUS_CRC_ERROR;
+
+    const plist_entry_t *info = plist_first(&kc->info, list);
+
+    kc->kexts = boot_alloc((h->kext_count ? h->kext_count : 1) * sizeof(kext_t));
+    if (!kc->kexts)
+        return STATUS_OUT_OF_MEMORY;
+
+    for (u32 i = 0; i < h->kext_count; i++, info = plist_next(&kc->info, info)) {
+        const kextc_kext_t *k = &kexts[i];
+        kext_t *out = &kc->kexts[i];
+
+        memset(out, 0, sizeof(*out));
+        out->bundle_id = string_at(kc, k->bundle_id);
+        out->info = info;
+        if (k->executable != KEXTC_NONE) {
+            out->executable = kc->payload + k->executable;
+            out->address = kc->vm_base + k->executable;
+            out->size = k->size;
+        }
+        if (k->kmod_info != KEXTC_NONE)
+            out->kmod_info = kc->vm_base + k->kmod_info;
+    }
+    kc->kext_count = h->kext_count;
+    return STATUS_SUCCESS;
+}
+
+/* A collection that did not load gives its image back */
+static status_t discard(kext_collection_t *kc, u8 *buf, size_t size, status_t status) {
+    boot_free(buf, size);
+    memset(kc, 0, sizeof(*kc));
+    return status;
+}
+
+static status_t load(fs_t *fs, const char *path, u64 vm_base, kext_collection_t *kc) {
+    payload_info_t info;
+    status_t status;
+
+    if (vm_base & (KEXTC_PAGE - 1))
+        return STATUS_INVALID_PARAM;
+
+    status = payload_probe(fs, path, &info);
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    /* raw files state no decoded size, compressed ones have to */
+    u64 size = info.codec == PAYLOAD_RAW ? info.stored : info.expected;
+    if (!size || size > (u64)SIZE_MAX - KEXTC_PAGE) {
+        printf("kextld: %s does not state its size\n", path);
+        return STATUS_CRC_ERROR;
+    }
+
+    /* the payload is page aligned in the file, so aligning the file keeps ADRP right */
+    size_t alloc = (size_t)size + KEXTC_PAGE - 1;
+    u8 *buf = boot_alloc(alloc);
+    if (!buf)
+        return STATUS_OUT_OF_MEMORY;
+    kc->image = (void *)(((uintptr_t)buf + KEXTC_PAGE - 1) & ~(uintptr_t)(KEXTC_PAGE - 1));
+
+    status = payload_load(fs, path, "kextcache", kc->image, (size_t)size, &info);
+    if (status != STATUS_SUCCESS)
+        return discard(kc, buf, alloc, status);
+
+    kc->size = (size_t)info.size;
+    kc->header = kc->image;
+    if (!check(kc)) {
+        printf("kextld: %s is no valid kext collection\n", path);
+        return discard(kc, buf, alloc, STATUS_CRC_ERROR);
+    }
+
+    kc->payload = (u8 *)kc->image + kc->header->payload_offset;
+    kc->vm_base = vm_base ? vm_base : (u64)(uintptr_t)kc->payload;
+    kc->slide = kc->vm_base - kc->header->base;
+    if (!slide(kc)) {
+        printf("kextld: %s has a fixup outside its payload\n", path);
+        return discard(kc, buf, alloc, STATUS_CRC_ERROR);
+    }
+    icache_sync_range(kc->payload, (size_t)kc->header->payload_size);
+
+    status = publish(kc);
+    if (status != STATUS_SUCCESS)
+        return discard(kc, buf, alloc, status);
+    printf("kextld: %u kexts, %u fixups, slide 0x%llx\n", kc->kext_count,
+           kc->header->fixup_count, (unsigned long long)kc->slide);
+    return STATUS_SUCCESS;
+}
+
+/* =========================
+ *  Public API
+ * ========================= */
+
+status_t kextld_load(fs_t *fs, const char *path, u64 vm_base, kext_collection_t *out) {
+    memset(out, 0, sizeof(*out));
+
+    trace_begin("kexts");
+    status_t status = load(fs, path, vm_base, out);
+    trace_end("kexts", status == STATUS_SUCCESS ? out->kext_count : 0);
+
+    return status;
+}
+
+u32 kextld_find(const kext_collection_t *kc, const char *bundle_id) {
+    for (u32 i = 0; i < kc->kext_count; i++)
+        if (strcmp(kc->kexts[i].bundle_id, bundle_id) == 0)
+            return i;
+    return KEXTLD_NO_KEXT;
+}
+
+u64 kextld_symbol(const kext_collection_t *kc, const char *name, u32 *kext) {
+    u32 lo = 0, hi = kc->symbol_count;
+
+    /* byte order, then kext, the way mkkextc.py sorts them: the first of a run */
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+
+        if (strcmp(kc->strings + kc->symbols[mid].name, name) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == kc->symbol_count || strcmp(kc->strings + kc->symbols[lo].name, name) != 0)
+        return 0;
+    if (kext)
+        *kext = kc->symbols[lo].kext;
+    return kc->vm_base + kc->symbols[lo].offset;
+}
+
+/* =========================
+ *  Mach-O
+ * ========================= */
+
+#define MH_MAGIC_64             0xFEEDFACFu
+#define CPU_TYPE_ARM64          0x0100000C
+#define MH_KEXT_BUNDLE          0xBu
+#define LC_SYMTAB               0x2u
+#define LC_DYSYMTAB             0xBu
+#define LC_SEGMENT_64           0x19u
+#define LC_DYLD_INFO            0x22u
+#define LC_DYLD_INFO_ONLY       0x80000022u
+#define LC_DYLD_CHAINED_FIXUPS  0x80000034u
+#define VM_PROT_WRITE           0x2
+#define N_STAB                  0xE0
+#define N_TYPE                  0x0E
+#define N_EXT                   0x01
+#define N_SECT                  0x0E
+#define N_WEAK_REF              0x0040
+#define ARM64_RELOC_UNSIGNED    0
+#define ARM64_RELOC_BRANCH26    2
+
+#define MACHO_MAX_SEGMENTS      16
+
+typedef struct {
+    u32 magic;
+    s32 cputype;
+    s32 cpusubtype;
+    u32 filetype;
+    u32 ncmds;
+    u32 sizeofcmds;
+    u32 flags;
+    u32 reserved;
+} macho_header_t;
+
+typedef struct {
+    u32 cmd;
+    u32 cmdsize;
+    char segname[16];
+    u64 vmaddr;
+    u64 vmsize;
+    u64 fileoff;
+    u64 filesize;
+    s32 maxprot;
+    s32 initprot;
+    u32 nsects;
+    u32 flags;
+} macho_segment_t;
+
+typedef struct {
+    char sectname[16];
+    char segname[16];
+    u64 addr;
+    u64 size;
+    u32 offset;
+    u32 align;
+    u32 reloff;
+    u32 nreloc;
+    u32 flags;
+    u32 reserved[3];
+} macho_section_t;
+
+typedef struct {
+    u32 cmd;
+    u32 cmdsize;
+    u32 symoff;
+    u32 nsyms;
+    u32 stroff;
+    u32 strsize;
+} macho_symtab_t;
+
+typedef struct {
+    u32 cmd;
+    u32 cmdsize;
+    u32 ilocalsym, nlocalsym;
+    u32 iextdefsym, nextdefsym;
+    u32 iundefsym, nundefsym;
+    u32 tocoff, ntoc;
+    u32 modtaboff, nmodtab;
+    u32 extrefsymoff, nextrefsyms;
+    u32 indirectsymoff, nindirectsyms;
+    u32 extreloff, nextrel;
+    u32 locreloff, nlocrel;
+} macho_dysymtab_t;
+
+typedef struct {
+    u32 strx;
+    u8 type;
+    u8 sect;
+    u16 desc;
+    u64 value;
+} macho_nlist_t;
+
+typedef struct {
+    s32 address;                /* from the first writable segment */
+    u32 info;                   /* symbol:24 pcrel:1 length:2 extern:1 type:4 */
+} macho_reloc_t;
+
+typedef struct {
+    const u8 *file;
+    const macho_segment_t *segments[MACHO_MAX_SEGMENTS];
+    u32 segment_count;
+    const macho_nlist_t *symbols;
+    u32 symbol_count;
+    const char *strings;
+    u32 strings_size;
+    const macho_reloc_t *extrel, *locrel;
+    u32 extrel_count, locrel_count;
+    u64 lowest, end;            /* vm range of the segments */
+    u64 reloc_base;             /* image offset relocations count from */
+} macho_t;
+
+static u64 read64(const u8 *p) {
+    u64 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void write64(u8 *p, u64 v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+/* Check the load commands of file[0, size) and index them; a `kext` has to be one we can link */
+static bool macho_parse(const u8 *file, size_t size, bool kext, macho_t *m) {
+    const macho_header_t *h = (const macho_header_t *)file;
+    const macho_segment_t *writable = NULL;
+
+    memset(m, 0, sizeof(*m));
+    m->file = file;
+    if (size < sizeof(*h) || ((uintptr_t)file & 7) || h->magic != MH_MAGIC_64 ||
+        !within(sizeof(*h), h->sizeofcmds, size))
+        return false;
+    if (kext && (h->cputype != CPU_TYPE_ARM64 || h->filetype != MH_KEXT_BUNDLE))
+        return false;
+
+    u64 off = sizeof(*h), end = sizeof(*h) + h->sizeofcmds;
+
+    m->lowest = ~0ull;
+    for (u32 i = 0; i < h->ncmds; i++) {
+        u32 cmd, cmdsize;
+
+        if (off + 8 > end)
+            return false;
+        memcpy(&cmd, file + off, 4);
+        memcpy(&cmdsize, file + off + 4, 4);
+        if (cmdsize < 8 || (cmdsize & 7) || cmdsize > end - off)
+            return false;
+
+        if (cmd == LC_SEGMENT_64) {
+            const macho_segment_t *s = (const macho_segment_t *)(file + off);
+
+            if (cmdsize < sizeof(*s) ||
+                (cmdsize - sizeof(*s)) / sizeof(macho_section_t) < s->nsects ||
+                !within(s->fileoff, s->filesize, size) || s->filesize > s->vmsize ||
+                s->vmaddr + s->vmsize < s->vmaddr || m->segment_count == MACHO_MAX_SEGMENTS)
+                return false;
+
+            /* relocate() rewrites the load commands where the header segment maps them */
+            if (s->fileoff == 0 && s->filesize && s->filesize < end)
+                return false;
+
+            const macho_section_t *sect = (const macho_section_t *)(s + 1);
+            for (u32 j = 0; kext && j < s->nsects; j++)
+                if (sect[j].nreloc)
+                    return false;       /* an object file, not a linked kext */
+
+            m->segments[m->segment_count++] = s;
+            if (s->vmaddr < m->lowest)
+                m->lowest = s->vmaddr;
+            if (s->vmaddr + s->vmsize > m->end)
+                m->end = s->vmaddr + s->vmsize;
+            if (!writable && (s->initprot & VM_PROT_WRITE))
+                writable = s;
+        } else if (cmd == LC_SYMTAB) {
+            const macho_symtab_t *st = (const macho_symtab_t *)(file + off);
+
+            if (cmdsize < sizeof(*st) ||
+                !within(st->symoff, (u64)st->nsyms * sizeof(macho_nlist_t), size) ||
+                !within(st->stroff, st->strsize, size) || (st->symoff & 7) ||
+                (st->nsyms && (!st->strsize || file[st->stroff + st->strsize - 1] != '\0')))
+                return false;
+            m->symbols = (const macho_nlist_t *)(file + st->symoff);
+            m->symbol_count = st->nsyms;
+            m->strings = (const char *)file + st->stroff;
+            m->strings_size = st->strsize;
+        } else if (cmd == LC_DYSYMTAB) {
+            const macho_dysymtab_t *d = (const macho_dysymtab_t *)(file + off);
+
+            if (cmdsize < sizeof(*d) ||
+                !within(d->extreloff, (u64)d->nextrel * sizeof(macho_reloc_t), size) ||
+                !within(d->locreloff, (u64)d->nlocrel * sizeof(macho_reloc_t), size) ||
+                ((d->extreloff | d->locreloff) & 3))
+                return false;
+            m->extrel = (const macho_reloc_t *)(file + d->extreloff);
+            m->extrel_count = d->nextrel;
+            m->locrel = (const macho_reloc_t *)(file + d->locreloff);
+            m->locrel_count = d->nlocrel;
+        } else if (kext && (cmd == LC_DYLD_INFO || cmd == LC_DYLD_INFO_ONLY ||
+                            cmd == LC_DYLD_CHAINED_FIXUPS)) {
+            return false;               /* dyld's fixups, not kxld's */
+        }
+        off += cmdsize;
+    }
+
+    if (!m->segment_count)
+        return !kext;
+    if (m->end - m->lowest > 0xFFFFFFFFu)
+        return false;
+    /* arm64 relocations count from the first writable segment, as in dyld and kxld */
+    m->reloc_base = (writable ? writable->vmaddr : m->lowest) - m->lowest;
+
+    for (u32 i = 0; i < m->symbol_count; i++)
+        if (m->symbols[i].strx >= m->strings_size)
+            return false;
+    return true;
+}
+
+/* Defined and external: what a file exports */
+static bool exported(const macho_nlist_t *n) {
+    return !(n->type & N_STAB) && (n->type & N_EXT) && (n->type & N_TYPE) == N_SECT;
+}
+
+/* =========================
+ *  Export table
+ * ========================= */
+
+/* DT_GNU_HASH's: h * 33 + c */
+static u32 gnu_hash(const char *s) {
+    u32 h = 5381;
+
+    while (*s)
+        h = h * 33 + (u8)*s++;
+    return h;
+}
+
+static u32 pow2_at_least(u32 n) {
+    u32 p = 1;
+
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+static status_t add(kextld_exports_t *t, const char *name, u64 address, u32 owner) {
+    if (t->count == t->capacity) {
+        u32 cap = t->capacity ? t->capacity * 2 : 256;
+        /* the old array stays behind in the arena until the stage ends */
+        kextld_export_t *grown = arena_alloc(cap * sizeof(kextld_export_t));
+
+        if (!grown)
+            return STATUS_OUT_OF_MEMORY;
+        if (t->count)
+            memcpy(grown, t->symbols, t->count * sizeof(kextld_export_t));
+        t->symbols = grown;
+        t->capacity = cap;
+    }
+    t->symbols[t->count++] = (kextld_export_t){ name, address, gnu_hash(name), owner };
+    t->bucket_count = 0;                /* needs building again */
+    return STATUS_SUCCESS;
+}
+
+status_t kextld_exports_add_macho(kextld_exports_t *t, const void *image, size_t size,
+                                  u64 slide, u32 owner) {
+    macho_t m;
+
+    if (!macho_parse(image, size, false, &m))
+        return STATUS_CRC_ERROR;
+    for (u32 i = 0; i < m.symbol_count; i++) {
+        const macho_nlist_t *n = &m.symbols[i];
+
+        if (exported(n)) {
+            status_t status = add(t, m.strings + n->strx, n->value + slide, owner);
+            if (status != STATUS_SUCCESS)
+                return status;
+        }
+    }
+    return STATUS_SUCCESS;
+}
+
+status_t kextld_exports_add_collection(kextld_exports_t *t, const kext_collection_t *kc) {
+    for (u32 i = 0; i < kc->symbol_count; i++) {
+        const kextc_symbol_t *s = &kc->symbols[i];
+        status_t status = add(t, kc->strings + s->name, kc->vm_base + s->offset,
+                              KEXTLD_OWNER_COLLECTION);
+        if (status != STATUS_SUCCESS)
+            return status;
+    }
+    return STATUS_SUCCESS;
+}
+
+/*
+ * Symbols sorted by bucket (stably, so the first added still comes
+ * first), two bloom bits per symbol at 16 or more bits of filter each:
+ * at worst one miss in seventy gets past. The word comes from hash
+ * bits 6 and up; like DT_GNU_HASH's shift2, bloom_shift takes the
+ * second bit from above those, or it would only repeat the word index.
+ */
+status_t kextld_exports_build(kextld_exports_t *t) {
+    u32 n = t->count;
+    u32 buckets = pow2_at_least(n / 2 ? n / 2 : 1);
+    u32 words = pow2_at_least(n ? (n + 3) / 4 : 1);
+    kextld_export_t *sorted = arena_alloc((n ? n : 1) * sizeof(kextld_export_t));
+    u32 *start = arena_alloc_zero((buckets + 1) * sizeof(u32));
+
+    t->bloom = arena_alloc_zero(words * sizeof(u64));
+    t->buckets = arena_alloc(buckets * sizeof(u32));
+    t->chain = arena_alloc((n ? n : 1) * sizeof(u32));
+    if (!sorted || !start || !t->bloom || !t->buckets || !t->chain)
+        return STATUS_OUT_OF_MEMORY;
+
+    t->bloom_words = words;
+    t->bloom_shift = 6;
+    while ((1u << (t->bloom_shift - 6)) < words && t->bloom_shift < 26)
+        t->bloom_shift++;               /* 6 + log2(words), leaving 6 bits */
+    for (u32 i = 0; i < n; i++) {
+        u32 h = t->symbols[i].hash;
+
+        start[(h & (buckets - 1)) + 1]++;
+        t->bloom[(h >> 6) & (words - 1)] |= 1ull << (h & 63) | 1ull << ((h >> t->bloom_shift) & 63);
+    }
+    for (u32 b = 0; b < buckets; b++)
+        start[b + 1] += start[b];
+    for (u32 b = 0; b < buckets; b++)
+        t->buckets[b] = start[b] == start[b + 1] ? ~0u : start[b];
+    for (u32 i = 0; i < n; i++)
+        sorted[start[t->symbols[i].hash & (buckets - 1)]++] = t->symbols[i];
+
+    for (u32 i = 0; i < n; i++) {
+        u32 b = sorted[i].hash & (buckets - 1);
+        bool last = i + 1 == n || (sorted[i + 1].hash & (buckets - 1)) != b;
+
+        t->chain[i] = (sorted[i].hash & ~1u) | last;
+    }
+
+    t->symbols = sorted;
+    t->capacity = n;
+    t->bucket_count = buckets;
+    return STATUS_SUCCESS;
+}
+
+/*
+ * `name` as kext `self` sees it: its own definition if it has one, else
+ * the first owned by the kernel, the collection or one of deps[0, ndeps)
+ * (deps NULL: the first anyone added).
+ */
+static const kextld_export_t *lookup(const kextld_exports_t *t, const char *name,
+                                     u32 self, const u32 *deps, u32 ndeps) {
+    if (!t->bucket_count)
+        return NULL;
+
+    u32 h = gnu_hash(name);
+    u64 word = t->bloom[(h >> 6) & (t->bloom_words - 1)];
+
+    if (!((word >> (h & 63)) & (word >> ((h >> t->bloom_shift) & 63)) & 1))
+        return NULL;
+
+    u32 i = t->buckets[h & (t->bucket_count - 1)];
+    if (i == ~0u)
+        return NULL;
+
+    const kextld_export_t *found = NULL;
+
+    for (;; i++) {
+        const kextld_export_t *e = &t->symbols[i];
+
+        if ((t->chain[i] | 1) == (h | 1) && e->owner != KEXTLD_OWNER_DROPPED &&
+            strcmp(e->name, name) == 0) {
+            bool visible = !deps || e->owner >= KEXTLD_OWNER_COLLECTION;
+
+            if (e->owner == self)
+                return e;
+            for (u32 d = 0; !visible && d < ndeps; d++)
+                visible = deps[d] == e->owner;
+            if (visible && !found)
+                found = e;
+        }
+        if (t->chain[i] & 1)
+            return found;
+    }
+}
+
+const kextld_export_t *kextld_exports_find(const kextld_exports_t *t, const char *name) {
+    return lookup(t, name, KEXTLD_NO_KEXT, NULL, 0);
+}
+
+/* =========================
+ *  Bundles
+ * ========================= */
+
+static char *join(const char *a, const char *b, const char *c) {
+    size_t la = strlen(a), lb = strlen(b), lc = c ? strlen(c) : 0;
+    char *s = arena_alloc(la + lb + lc + 1);
+
+    if (s) {
+        memcpy(s, a, la);
+        memcpy(s + la, b, lb);
+        if (c)
+            memcpy(s + la + lb, c, lc);
+        s[la + lb + lc] = '\0';
+    }
+    return s;
+}
+
+/* All of `path`, into boot_alloc() (8-byte aligned) or the arena */
+static status_t read_file(fs_t *fs, const char *path, bool permanent, u8 **out, size_t *size) {
+    file_t file;
+
+    if (!path)
+        return STATUS_OUT_OF_MEMORY;
+    if (fs_open(fs, path, &file) != 0)
+        return STATUS_NOT_FOUND;
+
+    u64 n = fs_size(&file);
+    u8 *buf = n > 0xFFFFFFFFu ? NULL : permanent ? boot_alloc((size_t)n + 1) : arena_alloc((size_t)n + 1);
+    status_t status = STATUS_OUT_OF_MEMORY;
+
+    if (buf) {
+        status = fs_read(&file, buf, (size_t)n) == n ? STATUS_SUCCESS : STATUS_ERROR;
+        buf[n] = '\0';
+    }
+    fs_close(&file);
+    *out = buf;
+    *size = (size_t)n;
+    return status;
+}
+
+status_t kextld_open(fs_t *fs, const char *bundle, kextld_kext_t *out) {
+    const char *contents = "/Contents/";
+    u8 *plist;
+    size_t size;
+
+    memset(out, 0, sizeof(*out));
+    status_t status = read_file(fs, join(bundle, contents, "Info.plist"), false, &plist, &size);
+    if (status == STATUS_NOT_FOUND) {
+        contents = "/";                 /* iOS-style flat bundle */
+        status = read_file(fs, join(bundle, contents, "Info.plist"), false, &plist, &size);
+    }
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    if (plist_parse(plist, size, &out->info) != 0) {
+        printf("kextld: %s: bad Info.plist\n", bundle);
+        return STATUS_CRC_ERROR;
+    }
+
+    const plist_entry_t *id = plist_get(&out->info, "CFBundleIdentifier");
+    const plist_entry_t *exe = plist_get(&out->info, "CFBundleExecutable");
+
+    if (!id || id->type != PLIST_STRING) {
+        printf("kextld: %s has no CFBundleIdentifier\n", bundle);
+        return STATUS_CRC_ERROR;
+    }
+    out->bundle_id = id->value.string;
+    if (!exe || exe->type != PLIST_STRING)
+        return STATUS_SUCCESS;          /* codeless */
+
+    const char *dir = contents[1] ? "/Contents/MacOS/" : "/";
+    u8 *macho;
+
+    status = read_file(fs, join(bundle, dir, exe->value.string), true, &macho, &out->macho_size);
+    out->macho = macho;
+    return status;
+}
+
+/* =========================
+ *  Linking
+ * ========================= */
+
+typedef struct {
+    kextld_kext_t *kexts;
+    const kextld_exports_t *exports;
+    const u32 *deps;            /* kext i's: deps[dep_start[i], dep_start[i + 1]) */
+    const u32 *dep_start;
+    const u32 *batch;           /* the level being linked */
+} link_job_t;
+
+/* Copy the segments into place and add the exports; serial, before any binding */
+static status_t layout(kextld_kext_t *k, u32 index, kextld_exports_t *exports, u64 vm_offset) {
+    macho_t m;
+
+    if (!k->macho)
+        return STATUS_SUCCESS;
+    if (!macho_parse(k->macho, k->macho_size, true, &m))
+        return STATUS_CRC_ERROR;
+
+    size_t size = (size_t)(m.end - m.lowest);
+    u8 *buf = boot_alloc(size + KEXTC_PAGE - 1);
+
+    if (!buf)
+        return STATUS_OUT_OF_MEMORY;
+    k->block = buf;
+    k->executable = (u8 *)(((uintptr_t)buf + KEXTC_PAGE - 1) & ~(uintptr_t)(KEXTC_PAGE - 1));
+    k->size = size;
+    k->address = (u64)(uintptr_t)k->executable + vm_offset;
+
+    memset(k->executable, 0, size);
+    for (u32 i = 0; i < m.segment_count; i++) {
+        const macho_segment_t *s = m.segments[i];
+        memcpy(k->executable + (s->vmaddr - m.lowest), m.file + s->fileoff, (size_t)s->filesize);
+    }
+
+    for (u32 i = 0; i < m.symbol_count; i++) {
+        const macho_nlist_t *n = &m.symbols[i];
+        const char *name = m.strings + n->strx;
+        u64 at = n->value - m.lowest;
+
+        if ((n->type & N_STAB) || (n->type & N_TYPE) != N_SECT || at >= size)
+            continue;
+        if (strcmp(name, "_kmod_info") == 0)
+            k->kmod_info = k->address + at;
+        if ((n->type & N_EXT)) {
+            status_t status = add(exports, name, k->address + at, index);
+            if (status != STATUS_SUCCESS)
+                return status;
+        }
+    }
+    return STATUS_SUCCESS;
+}
+
+/* What mkkextc.py's Kext.link() does, against the hashed table */
+static status_t relocate(kextld_kext_t *k, u32 index, const macho_t *m,
+                         const kextld_exports_t *exports, const u32 *deps, u32 ndeps) {
+    u8 *image = k->executable;
+
+    for (u32 i = 0; i < m->locrel_count; i++) {
+        const macho_reloc_t *r = &m->locrel[i];
+        s64 at = (s64)m->reloc_base + r->address;
+
+        if (r->info >> 28 != ARM64_RELOC_UNSIGNED || ((r->info >> 25) & 3) != 3 ||
+            (r->info & (1u << 27)) || at < 0 || (u64)at + 8 > k->size)
+            return STATUS_CRC_ERROR;
+        write64(image + at, read64(image + at) - m->lowest + k->address);
+    }
+
+    for (u32 i = 0; i < m->extrel_count; i++) {
+        const macho_reloc_t *r = &m->extrel[i];
+        s64 at = (s64)m->reloc_base + r->address;
+        u32 sym = r->info & 0xFFFFFF, kind = r->info >> 28;
+
+        if (sym >= m->symbol_count || at < 0 || (u64)at + 8 > k->size)
+            return STATUS_CRC_ERROR;
+
+        const macho_nlist_t *n = &m->symbols[sym];
+        const char *name = m->strings + n->strx;
+        const kextld_export_t *e = lookup(exports, name, index, deps, ndeps);
+        u64 target = e ? e->address : 0;
+
+        if (!e && !(n->desc & N_WEAK_REF)) {
+            k->missing = name;
+            return STATUS_NOT_FOUND;
+        }
+
+        if (kind == ARM64_RELOC_UNSIGNED && ((r->info >> 25) & 3) == 3) {
+            /* a weak reference to nothing reads as NULL */
+            write64(image + at, e ? target + read64(image + at) : 0);
+        } else if (kind == ARM64_RELOC_BRANCH26 && e) {
+            s64 disp = (s64)(target - (k->address + (u64)at));
+            u32 insn;
+
+            if ((disp & 3) || disp < -(1ll << 27) || disp >= (1ll << 27)) {
+                k->missing = name;
+                return STATUS_OUT_OF_RANGE;
+            }
+            memcpy(&insn, image + at, 4);
+            insn = (insn & 0xFC000000u) | ((u32)(disp >> 2) & 0x3FFFFFFu);
+            memcpy(image + at, &insn, 4);
+        } else {
+            k->missing = name;
+            return STATUS_CRC_ERROR;
+        }
+    }
+
+    /* the headers say where the kext runs, like a kernelcache's do */
+    for (u32 i = 0; i < m->segment_count; i++) {
+        if (m->segments[i]->fileoff != 0 || !m->segments[i]->filesize)
+            continue;
+
+        u8 *header = image + (m->segments[i]->vmaddr - m->lowest);
+        for (u32 j = 0; j < m->segment_count; j++) {
+            const macho_segment_t *s = m->segments[j];
+            macho_segment_t *out = (macho_segment_t *)(header + ((const u8 *)s - m->file));
+            macho_section_t *sect = (macho_section_t *)(out + 1);
+
+            out->vmaddr = s->vmaddr - m->lowest + k->address;
+            for (u32 n = 0; n < s->nsects; n++)
+                sect[n].addr = sect[n].addr - m->lowest + k->address;
+        }
+        break;
+    }
+    return STATUS_SUCCESS;
+}
+
+static void link_one(void *ctx, u32 index) {
+    link_job_t *job = ctx;
+    u32 i = job->batch[index];
+    kextld_kext_t *k = &job->kexts[i];
+    u64 t0 = timer_ticks();
+    macho_t m;
+
+    if (k->macho) {
+        macho_parse(k->macho, k->macho_size, true, &m);     /* layout() checked it */
+        k->status = relocate(k, i, &m, job->exports, job->deps + job->dep_start[i],
+                             job->dep_start[i + 1] - job->dep_start[i]);
+        if (k->status == STATUS_SUCCESS)
+            icache_sync_range(k->executable, (size_t)k->size);
+    }
+    k->link_ticks = timer_ticks() - t0;
+}
+
+/* Kext indices of each kext's OSBundleLibraries, those outside the set checked off here */
+static status_t dependencies(kextld_kext_t *kexts, u32 count, const kext_collection_t *kc,
+                             u32 **deps_out, u32 **start_out) {
+    u32 *start = arena_alloc((count + 1) * sizeof(u32));
+    u32 total = 0, n = 0;
+
+    if (!start)
+        return STATUS_OUT_OF_MEMORY;
+    for (u32 i = 0; i < count; i++) {
+        const plist_entry_t *libs = plist_get(&kexts[i].info, "OSBundleLibraries");
+        total += libs && libs->type == PLIST_DICT ? libs->count : 0;
+    }
+
+    u32 *deps = arena_alloc((total ? total : 1) * sizeof(u32));
+    if (!deps)
+        return STATUS_OUT_OF_MEMORY;
+
+    for (u32 i = 0; i < count; i++) {
+        kextld_kext_t *k = &kexts[i];
+        const plist_entry_t *libs = plist_get(&k->info, "OSBundleLibraries");
+
+        start[i] = n;
+        if (!libs || libs->type != PLIST_DICT)
+            continue;
+        for (const plist_entry_t *lib = plist_first(&k->info, libs); lib;
+             lib = plist_next(&k->info, lib)) {
+            u32 d = 0;
+
+            while (d < count && (d == i || strcmp(kexts[d].bundle_id, lib->key) != 0))
+                d++;
+            if (d < count) {
+                deps[n++] = d;
+            } else if (strncmp(lib->key, "com.apple.", 10) != 0 &&
+                       !(kc && kextld_find(kc, lib->key) != KEXTLD_NO_KEXT) &&
+                       k->status == STATUS_SUCCESS) {
+                k->status = STATUS_NOT_FOUND;
+                k->missing = lib->key;
+                printf("kextld: %s requires %s, which is not loaded\n", k->bundle_id, lib->key);
+            }
+        }
+    }
+    start[count] = n;
+
+    *deps_out = deps;
+    *start_out = start;
+    return STATUS_SUCCESS;
+}
+
+static void link_mark(const kextld_kext_t *k) {
+    char label[OCM_TRACE_NAME_LEN + 1];
+    const char *name = k->bundle_id;
+    u64 freq = timer_frequency();
+
+    for (const char *s = k->bundle_id; *s; s++)
+        if (*s == '.' && s[1])
+            name = s + 1;
+    trace_label(label, name, " link");
+    trace_mark(label, freq ? k->link_ticks * 1000000 / freq : 0);
+}
+
+static u32 link_all(kextld_kext_t *kexts, u32 count, kextld_exports_t *exports,
+                    const kext_collection_t *kc, u64 vm_offset) {
+    u32 linked = 0, levels = 0;
+
+    /* the table is the caller's and outlives the mark below */
+    for (u32 i = 0; i < count; i++) {
+        kexts[i].status = layout(&kexts[i], i, exports, vm_offset);
+        if (kexts[i].status != STATUS_SUCCESS)
+            printf("kextld: %s is no kext this loader can link\n", kexts[i].bundle_id);
+    }
+    status_t built = kextld_exports_build(exports);
+
+    arena_mark_t mark = arena_mark();
+    u32 *deps, *dep_start;
+    u32 *placed = arena_alloc_zero((count ? count : 1) * sizeof(u32));  /* level + 1, 0: not yet */
+    u32 *batch = arena_alloc((count ? count : 1) * sizeof(u32));
+
+    if (built != STATUS_SUCCESS || !placed || !batch ||
+        dependencies(kexts, count, kc, &deps, &dep_start) != STATUS_SUCCESS) {
+        for (u32 i = 0; i < count; i++)
+            kexts[i].status = STATUS_OUT_OF_MEMORY;
+        arena_release(mark);
+        return 0;
+    }
+
+    for (u32 level = 0;; level++) {
+        link_job_t job = { kexts, exports, deps, dep_start, batch };
+        u32 n = 0, left = 0;
+
+        /*
+         * A failed library fails its dependents, however far down, before
+         * anything is called waiting: an unplaced kext can only have
+         * failed for good (layout(), dependencies(), or here).
+         */
+        for (bool failed = true; failed;) {
+            failed = false;
+            for (u32 i = 0; i < count; i++) {
+                kextld_kext_t *k = &kexts[i];
+
+                for (u32 d = dep_start[i]; d < dep_start[i + 1] && !placed[i] &&
+                                           k->status == STATUS_SUCCESS; d++) {
+                    const kextld_kext_t *lib = &kexts[deps[d]];
+
+                    if (lib->status != STATUS_SUCCESS) {
+                        k->status = STATUS_NOT_FOUND;
+                        k->missing = lib->bundle_id;
+                        failed = true;
+                        printf("kextld: %s requires %s, which failed\n", k->bundle_id, lib->bundle_id);
+                    }
+                }
+            }
+        }
+
+        for (u32 i = 0; i < count; i++) {
+            kextld_kext_t *k = &kexts[i];
+            bool ready = true;
+
+            if (placed[i])
+                continue;
+            for (u32 d = dep_start[i]; d < dep_start[i + 1]; d++)
+                ready = ready && placed[deps[d]] && placed[deps[d]] <= level;
+            if (k->status != STATUS_SUCCESS)
+                placed[i] = level + 1;
+            else if (ready)
+                batch[n++] = i;
+            else
+                left++;
+        }
+
+        if (!n) {
+            /* nothing ready but some left: every one waits on another */
+            for (u32 i = 0; left && i < count; i++) {
+                kextld_kext_t *k = &kexts[i];
+
+                if (placed[i])
+                    continue;
+                for (u32 d = dep_start[i]; d < dep_start[i + 1] && !k->missing; d++)
+                    if (!placed[deps[d]])
+                        k->missing = kexts[deps[d]].bundle_id;
+                k->status = STATUS_NOT_FOUND;
+                printf("kextld: %s is part of a dependency cycle (through %s)\n",
+                       k->bundle_id, k->missing);
+            }
+            break;
+        }
+
+        smp_parallel_for(n, link_one, &job);
+        levels++;
+
+        for (u32 b = 0; b < n; b++) {
+            kextld_kext_t *k = &kexts[batch[b]];
+
+            placed[batch[b]] = level + 1;
+            k->level = level;
+            link_mark(k);
+            if (k->status == STATUS_SUCCESS)
+                linked++;
+            else if (k->missing)
+                printf("kextld: %s: cannot bind %s (%d)\n", k->bundle_id, k->missing, k->status);
+            else
+                printf("kextld: %s: bad relocations\n", k->bundle_id);
+        }
+    }
+
+    printf("kextld: linked %u of %u kexts in %u levels\n", linked, count, levels);
+    arena_release(mark);
+    return linked;
+}
+
+/* Kexts that failed give their executables back; their exports went with them */
+static void discard_failed(kextld_kext_t *kexts, u32 count, kextld_exports_t *exports) {
+    bool any = false;
+
+    for (u32 i = 0; i < count; i++) {
+        kextld_kext_t *k = &kexts[i];
+
+        if (k->status == STATUS_SUCCESS || !k->block)
+            continue;
+        boot_free(k->block, (size_t)k->size + KEXTC_PAGE - 1);
+        k->block = NULL;
+        k->executable = NULL;
+        k->address = 0;
+        k->size = 0;
+        k->kmod_info = 0;
+        any = true;
+    }
+
+    for (u32 i = 0; any && i < exports->count; i++) {
+        kextld_export_t *e = &exports->symbols[i];
+
+        if (e->owner < count && kexts[e->owner].status != STATUS_SUCCESS)
+            e->owner = KEXTLD_OWNER_DROPPED;
+    }
+}
+
+u32 kextld_link(kextld_kext_t *kexts, u32 count, kextld_exports_t *exports,
+                const kext_collection_t *kc, u64 vm_offset) {
+    trace_begin("kext link");
+    u32 linked = link_all(kexts, count, exports, kc, vm_offset);
+    discard_failed(kexts, count, exports);
+    trace_end("kext link", linked);
+
+    return linked;
+}
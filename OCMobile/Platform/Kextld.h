@@ -0,0 +1,248 @@
+#ifndef KEXTLD_H
+#define KEXTLD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../bootstd.h"
+#include "plist/plist.h"
+
+/*
+ * OpenCore Mobile – prelinked kext collections
+ *
+ * Kexts are not linked at boot: Tools/mkkextc.py links a set of them
+ * offline against the kernel's symbols, at a fixed base address, into
+ * one collection file:
+ *
+ *   header | kexts | symbols | fixups | strings | info | payload
+ *
+ *   kexts      kextc_kext_t per kext, in the order they were given
+ *   symbols    kextc_symbol_t per symbol the kexts export, sorted by name,
+ *              then kext (two kexts may export one name; the per-kext
+ *              _kmod_info, _kext_apple_cc, _realmain and _antimain are
+ *              left out)
+ *   fixups     u32 payload offset of every 64-bit pointer in the payload
+ *   strings    NUL-terminated names; offset 0 is ""
+ *   info       plist image (see plist_image_map()) whose root holds
+ *              _PrelinkInfoDictionary, every kext's Info.plist in kext
+ *              order with _PrelinkBundlePath, _PrelinkExecutableLoadAddr,
+ *              _PrelinkExecutableSize and _PrelinkKmodInfo added (link
+ *              addresses, before any slide)
+ *   payload    the kexts' executables, each KEXTC_PAGE aligned, with
+ *              every relocation already applied for `base`
+ *
+ * all little-endian. Loading one is a single streaming read (through
+ * payload_load(), so the file may be compressed like a kernelcache)
+ * and, when it runs anywhere but `base`, adding the slide to each
+ * fixup: no Info.plist is parsed and no symbol looked up by name.
+ * Pointers into the kernel get the same slide, so the kernel has to
+ * slide by as much, the way a kernelcache's kexts do.
+ */
+
+#define OCM_KEXTS_PATH          "/EFI/OC/kexts.kc"
+
+#define KEXTC_MAGIC             "OCMKEXTC"
+#define KEXTC_VERSION           1
+
+/* payload alignment, and what a slide has to be a multiple of (ADRP) */
+#define KEXTC_PAGE              (16u << 10)
+
+#define KEXTC_NONE              0xFFFFFFFFFFFFFFFFull
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t image_crc;         /* crc32 of everything after the header */
+    uint64_t image_size;
+    uint64_t base;              /* link address of the payload's first byte */
+
+    uint32_t kext_count;
+    uint32_t symbol_count;
+    uint32_t fixup_count;
+    uint32_t strings_size;
+
+    uint64_t kexts_offset;      /* all from the start of the file */
+    uint64_t symbols_offset;
+    uint64_t fixups_offset;
+    uint64_t strings_offset;
+    uint64_t info_offset;       /* 8-byte aligned */
+    uint64_t info_size;
+    uint64_t payload_offset;    /* KEXTC_PAGE aligned */
+    uint64_t payload_size;
+} kextc_header_t;
+
+typedef struct {
+    uint32_t bundle_id;         /* string offset */
+    uint32_t reserved;
+    uint64_t executable;        /* payload offset, KEXTC_NONE for a codeless kext */
+    uint64_t size;              /* bytes of payload from there */
+    uint64_t kmod_info;         /* payload offset of _kmod_info, KEXTC_NONE if none */
+} kextc_kext_t;
+
+typedef struct {
+    uint32_t name;              /* string offset */
+    uint32_t kext;              /* index of the kext defining it */
+    uint64_t offset;            /* payload offset */
+} kextc_symbol_t;
+
+/* ---------- loading ---------- */
+
+#define KEXTLD_NO_KEXT          0xFFFFFFFFu
+
+typedef struct {
+    const char *bundle_id;
+    u8 *executable;             /* as loaded, NULL for a codeless kext */
+    u64 address;                /* executable and kmod_info where they run, 0 if none */
+    u64 size;
+    u64 kmod_info;
+    const plist_entry_t *info;  /* its Info.plist dict, in the collection's info */
+} kext_t;
+
+typedef struct {
+    void *image;                /* boot_alloc(), stays until kernel handoff */
+    size_t size;
+    const kextc_header_t *header;
+    u8 *payload;
+    u64 vm_base;                /* the payload's address where it runs */
+    u64 slide;                  /* vm_base - header->base */
+    kext_t *kexts;
+    u32 kext_count;
+    const kextc_symbol_t *symbols;
+    u32 symbol_count;
+    const char *strings;
+    plist_dict_t info;
+} kext_collection_t;
+
+/*
+ * Load the collection at `path` into permanent memory and slide it to
+ * run with its payload at `vm_base` (0: where it was loaded, i.e. the
+ * identity map). STATUS_NOT_FOUND if there is no such file,
+ * STATUS_CRC_ERROR if it is no valid collection, STATUS_INVALID_PARAM
+ * if `vm_base` is not KEXTC_PAGE aligned; the rest as payload_load().
+ * Records "kexts" begin/end (arg: kexts loaded) around the
+ * "kextcache" events of the read itself.
+ */
+status_t kextld_load(fs_t *fs, const char *path, u64 vm_base, kext_collection_t *out);
+
+/* Index of the kext `bundle_id`, KEXTLD_NO_KEXT if the collection has none */
+u32 kextld_find(const kext_collection_t *kc, const char *bundle_id);
+
+/*
+ * Where the exported symbol `name` runs (slid), 0 if no kext exports
+ * it; `kext` (may be NULL) gets the index of the one that does, the
+ * first in kext order if several do.
+ * O(log n): the table is sorted.
+ */
+u64 kextld_symbol(const kext_collection_t *kc, const char *name, u32 *kext);
+
+/* ---------- linking at boot ---------- */
+
+/*
+ * Kexts that are not in a collection are linked here, the way
+ * mkkextc.py does it offline: the same arm64 MH_KEXT_BUNDLEs with
+ * classic relocations.
+ *
+ * Symbols bind through one export table over the kernel, the
+ * collection and every kext being linked, hashed the way GNU ELF's
+ * DT_GNU_HASH is: a bloom filter turns most misses away with one word,
+ * and a hit walks only its bucket's run of hashes, comparing names when
+ * the hash matches. A kext binds to its own definitions first (ld -kext
+ * leaves external relocations against a kext's own globals, C++ vtables
+ * and metaclasses among them), then only to the kernel, the collection
+ * and the kexts its OSBundleLibraries name; mkkextc.py binds the same
+ * way, so two kexts may export one name.
+ *
+ * Kexts are linked in dependency order, a level at a time: every kext
+ * of a level depends only on earlier levels, so each level is spread over
+ * the cores with smp_parallel_for(). com.apple.* libraries are the
+ * kernelcache's and taken as present.
+ */
+
+#define KEXTLD_OWNER_KERNEL     0xFFFFFFFFu
+#define KEXTLD_OWNER_COLLECTION 0xFFFFFFFEu
+#define KEXTLD_OWNER_DROPPED    0xFFFFFFFDu     /* a kext that failed to link: never found */
+
+typedef struct {
+    const char *name;
+    u64 address;
+    u32 hash;
+    u32 owner;                  /* kext index, or KEXTLD_OWNER_* */
+} kextld_export_t;
+
+typedef struct {
+    kextld_export_t *symbols;   /* bucket order once built */
+    u32 count;
+    u32 capacity;
+
+    /* kextld_exports_build() */
+    u64 *bloom;
+    u32 bloom_words;            /* power of two */
+    u32 bloom_shift;
+    u32 *buckets;               /* first symbol of each bucket, ~0u if empty */
+    u32 *chain;                 /* symbol hashes, bit 0 set on a bucket's last */
+    u32 bucket_count;
+} kextld_exports_t;
+
+/*
+ * Add the defined external symbols of the Mach-O file image[0, size)
+ * (the kernel, usually), `slide` added to each. The table's arrays come
+ * from the stage arena: it can be searched until the next
+ * arena_reset(), and must not be used past an arena_release() to a mark
+ * taken before it grew or was built.
+ */
+status_t kextld_exports_add_macho(kextld_exports_t *t, const void *image, size_t size,
+                                  u64 slide, u32 owner);
+
+/* Add what a collection exports, where it runs */
+status_t kextld_exports_add_collection(kextld_exports_t *t, const kext_collection_t *kc);
+
+/* Hash what has been added; lookups need it, adding more needs another build */
+status_t kextld_exports_build(kextld_exports_t *t);
+
+/* The first symbol added as `name`, NULL if there is none */
+const kextld_export_t *kextld_exports_find(const kextld_exports_t *t, const char *name);
+
+typedef struct {
+    const char *bundle_id;
+    plist_dict_t info;          /* its Info.plist */
+    const u8 *macho;            /* the executable file, NULL for a codeless kext */
+    size_t macho_size;
+
+    /* kextld_link() */
+    u8 *executable;             /* linked, in `block` */
+    void *block;                /* boot_alloc(), given back if linking fails */
+    u64 address;                /* executable and kmod_info where they run, 0 if none */
+    u64 size;
+    u64 kmod_info;
+    u32 level;                  /* 0: depends on no kext being linked */
+    u64 link_ticks;
+    status_t status;
+    const char *missing;        /* the library or symbol it failed on, if any */
+} kextld_kext_t;
+
+/*
+ * Read the bundle at `bundle` (Contents/Info.plist and the executable it
+ * names, or the flat iOS layout) into `out`. The executable stays in
+ * boot_alloc() memory, the Info.plist and its dict in the stage arena.
+ */
+status_t kextld_open(fs_t *fs, const char *bundle, kextld_kext_t *out);
+
+/*
+ * Link kexts[0, count) to run where they are loaded plus `vm_offset`
+ * (the kernel's virtual minus physical address), binding them against
+ * `exports` (the kernel's and the collection's, added but not yet
+ * built) and each other; `exports` is left built, with the kexts'
+ * symbols in it. Each kext's status says how it went:
+ * STATUS_NOT_FOUND for a missing library (or a library that failed) or
+ * symbol, STATUS_OUT_OF_RANGE for a branch that can't reach its target,
+ * STATUS_CRC_ERROR for an executable that is no kext. A kext that fails
+ * gives its executable back and its exports leave the table. Records "kext
+ * link" begin/end (arg: kexts linked) and a "<name> link" mark per kext
+ * relocated, by the last component of its bundle ID (arg: microseconds
+ * that took). Returns the number linked.
+ */
+u32 kextld_link(kextld_kext_t *kexts, u32 count, kextld_exports_t *exports,
+                const kext_collection_t *kc, u64 vm_offset);
+
+#endif /* KEXTLD_H */
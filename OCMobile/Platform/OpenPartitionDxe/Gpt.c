@@ -15,32 +15,22 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "../../bootstd.h"
+#include "../../BlockIo.h"
+#include "../../Memory.h"
+#include "../../Smp.h"
+#include "../../Trace.h"
+#include "../crc32/crc32.h"
+
 // ============================================================================
 // Type Definitions
 // ============================================================================
 
-typedef uint64_t u64;
-typedef uint32_t u32;
-typedef uint16_t u16;
-typedef uint8_t u8;
-
 #define SECTOR_SIZE 512
 #define PRIMARY_PART_HEADER_LBA 1
 #define MAX_MBR_PARTITIONS 4
 #define PMBR_GPT_PARTITION 0xEE
 
-// Status codes
-typedef enum {
-    STATUS_SUCCESS = 0,
-    STATUS_ERROR = -1,
-    STATUS_NOT_FOUND = -2,
-    STATUS_CRC_ERROR = -3,
-    STATUS_INVALID_PARAM = -4,
-    STATUS_OUT_OF_MEMORY = -5,
-    STATUS_OVERLAP = -6,
-    STATUS_OUT_OF_RANGE = -7
-} status_t;
-
 // ============================================================================
 // GUID Structure
 // ============================================================================
@@ -135,49 +125,10 @@ typedef struct __attribute__((packed)) {
     u16 signature;  // 0xAA55
 } master_boot_record_t;
 
-// ============================================================================
-// Block Device Interface
-// ============================================================================
-
-typedef struct block_device {
-    void *private_data;
-    u64 total_sectors;
-    u32 block_size;
-    u32 media_id;
-    
-    status_t (*read_disk)(struct block_device *dev, u32 media_id, 
-                         u64 offset, u32 size, void *buffer);
-    status_t (*write_disk)(struct block_device *dev, u32 media_id,
-                          u64 offset, u32 size, const void *buffer);
-} block_device_t;
-
 // ============================================================================
 // Memory/String Utilities
 // ============================================================================
 
-static void* memcpy(void* dest, const void* src, size_t n) {
-    u8* d = (u8*)dest;
-    const u8* s = (const u8*)src;
-    while (n--) *d++ = *s++;
-    return dest;
-}
-
-static void* memset(void* s, int c, size_t n) {
-    u8* p = (u8*)s;
-    while (n--) *p++ = (u8)c;
-    return s;
-}
-
-static int memcmp(const void* s1, const void* s2, size_t n) {
-    const u8* p1 = (const u8*)s1;
-    const u8* p2 = (const u8*)s2;
-    while (n--) {
-        if (*p1 != *p2) return *p1 - *p2;
-        p1++; p2++;
-    }
-    return 0;
-}
-
 static bool compare_guid(const guid_t* g1, const guid_t* g2) {
     return memcmp(g1, g2, sizeof(guid_t)) == 0;
 }
@@ -197,85 +148,17 @@ static void utf16_to_ascii(char* dest, const u16* src, size_t max_len) {
 }
 
 // ============================================================================
-// Memory Allocation (Simple - implement based on your environment)
+// Memory Allocation
 // ============================================================================
 
-static void* alloc_pool(size_t size) {
-    // TODO: Implement based on your memory allocator
-    return NULL;
-}
-
+// Sector-sized buffers come from slabs, larger ones (entry arrays) from the
+// stage arena; free_pool() on arena memory is a no-op (see Memory.h).
 static void* alloc_zero_pool(size_t size) {
-    void* ptr = alloc_pool(size);
-    if (ptr) {
-        memset(ptr, 0, size);
-    }
-    return ptr;
+    return mem_alloc_zero(size);
 }
 
 static void free_pool(void* ptr) {
-    // TODO: Implement based on your memory allocator
-}
-
-// ============================================================================
-// CRC32 Implementation
-// ============================================================================
-
-static const u32 crc32_table[256] = {
-    0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
-    0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
-    0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
-    0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
-    0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9,
-    0xFA0F3D63, 0x8D080DF5, 0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
-    0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B, 0x35B5A8FA, 0x42B2986C,
-    0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
-    0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423,
-    0xCFBA9599, 0xB8BDA50F, 0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
-    0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D, 0x76DC4190, 0x01DB7106,
-    0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
-    0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D,
-    0x91646C97, 0xE6635C01, 0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
-    0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457, 0x65B0D9C6, 0x12B7E950,
-    0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
-    0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7,
-    0xA4D1C46D, 0xD3D6F4FB, 0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
-    0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9, 0x5005713C, 0x270241AA,
-    0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
-    0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81,
-    0xB7BD5C3B, 0xC0BA6CAD, 0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
-    0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683, 0xE3630B12, 0x94643B84,
-    0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
-    0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB,
-    0x196C3671, 0x6E6B06E7, 0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
-    0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5, 0xD6D6A3E8, 0xA1D1937E,
-    0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
-    0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55,
-    0x316E8EEF, 0x4669BE79, 0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
-    0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F, 0xC5BA3BBE, 0xB2BD0B28,
-    0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
-    0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F,
-    0x72076785, 0x05005713, 0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
-    0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21, 0x86D3D2D4, 0xF1D4E242,
-    0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
-    0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69,
-    0x616BFFD3, 0x166CCF45, 0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
-    0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB, 0xAED16A4A, 0xD9D65ADC,
-    0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
-    0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693,
-    0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
-    0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
-};
-
-static u32 calculate_crc32(const void* data, size_t length) {
-    u32 crc = 0xFFFFFFFF;
-    const u8* p = (const u8*)data;
-    
-    for (size_t i = 0; i < length; i++) {
-        crc = crc32_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
-    }
-    
-    return crc ^ 0xFFFFFFFF;
+    mem_free(ptr);
 }
 
 // ============================================================================
@@ -294,7 +177,7 @@ static bool check_header_crc(u32 max_size, u32 size, gpt_header_t* header) {
     u32 original_crc = header->header_crc32;
     header->header_crc32 = 0;
     
-    u32 calculated_crc = calculate_crc32(header, size);
+    u32 calculated_crc = crc32_calculate(header, size);
     
     header->header_crc32 = calculated_crc;
     
@@ -303,7 +186,7 @@ static bool check_header_crc(u32 max_size, u32 size, gpt_header_t* header) {
 
 static void set_header_crc(u32 size, gpt_header_t* header) {
     header->header_crc32 = 0;
-    u32 crc = calculate_crc32(header, size);
+    u32 crc = crc32_calculate(header, size);
     header->header_crc32 = crc;
 }
 
@@ -311,92 +194,102 @@ static void set_header_crc(u32 size, gpt_header_t* header) {
 // GPT Validation Functions
 // ============================================================================
 
-static bool validate_gpt_entry_array_crc(block_device_t* dev, 
-                                         gpt_header_t* header) {
-    u32 entries_size = header->num_partition_entries * header->partition_entry_size;
-    u8* entries = alloc_pool(entries_size);
-    
-    if (!entries) {
-        return false;
-    }
-    
-    u64 offset = header->partition_entry_lba * dev->block_size;
-    status_t status = dev->read_disk(dev, dev->media_id, offset, 
-                                     entries_size, entries);
-    
-    if (status != STATUS_SUCCESS) {
-        free_pool(entries);
-        return false;
-    }
-    
-    u32 calculated_crc = calculate_crc32(entries, entries_size);
-    free_pool(entries);
-    
-    return (header->partition_array_crc32 == calculated_crc);
-}
+// Standard layout: PMBR at LBA 0, header at LBA 1, 128 x 128-byte entries
+// from LBA 2. Discovery reads all of it in one request.
+#define GPT_DEFAULT_ENTRY_ARRAY_SIZE (128 * 128)
 
-static bool validate_gpt_table(block_device_t* dev, u64 lba, 
-                               gpt_header_t* header_out) {
-    u32 block_size = dev->block_size;
-    gpt_header_t* header = alloc_zero_pool(block_size);
-    
-    if (!header) {
-        return false;
-    }
-    
-    // Read GPT header
-    u64 offset = lba * block_size;
-    status_t status = dev->read_disk(dev, dev->media_id, offset, 
-                                     block_size, header);
-    
-    if (status != STATUS_SUCCESS) {
-        free_pool(header);
-        return false;
-    }
-    
+// Upper bound for the entry array we are willing to load (spec minimum is
+// 16 KiB; nobody ships more than a few times that)
+#define GPT_MAX_ENTRY_ARRAY_SIZE (1024 * 1024)
+
+// Validate a header that is already in memory (no I/O)
+static bool validate_gpt_header(block_device_t* dev, u64 lba,
+                                gpt_header_t* header) {
     // Validate signature
     if (header->signature != GPT_HEADER_SIGNATURE) {
-        free_pool(header);
         return false;
     }
     
     // Validate header CRC
-    if (!check_header_crc(block_size, header->header_size, header)) {
-        free_pool(header);
+    if (!check_header_crc(dev->block_size, header->header_size, header)) {
         return false;
     }
     
     // Validate LBA
     if (header->my_lba != lba) {
-        free_pool(header);
         return false;
     }
     
     // Validate partition entry size
     if (header->partition_entry_size < sizeof(gpt_partition_entry_t)) {
-        free_pool(header);
         return false;
     }
     
-    // Check for overflow in partition entries calculation
-    if (header->num_partition_entries > (0xFFFFFFFFFFFFFFFFULL / header->partition_entry_size)) {
-        free_pool(header);
+    // Bound the entry array (also rules out overflow in the size calculation)
+    u64 entries_size = (u64)header->num_partition_entries *
+                       header->partition_entry_size;
+    if (entries_size == 0 || entries_size > GPT_MAX_ENTRY_ARRAY_SIZE) {
         return false;
     }
     
-    // Copy header to output
-    memcpy(header_out, header, sizeof(gpt_header_t));
-    
-    // Validate partition entry array CRC
-    if (!validate_gpt_entry_array_crc(dev, header_out)) {
-        free_pool(header);
+    if (header->partition_entry_lba >= dev->total_sectors) {
         return false;
     }
     
-    free_pool(header);
     return true;
 }
 
+// Return the CRC-checked entry array for a validated header. If the array
+// lies inside `buf` (which holds `buf_size` bytes starting at LBA 0) it is
+// used in place, otherwise it is read into a new arena buffer.
+static u8* load_gpt_entry_array(block_device_t* dev, gpt_header_t* header,
+                                u8* buf, u64 buf_size) {
+    u32 entries_size = header->num_partition_entries * header->partition_entry_size;
+    u64 offset = header->partition_entry_lba * dev->block_size;
+    u8* entries;
+    
+    if (buf && offset + entries_size <= buf_size) {
+        entries = buf + offset;
+    } else {
+        entries = arena_alloc(entries_size);
+        if (!entries) {
+            return NULL;
+        }
+        
+        if (block_read_bytes(dev, offset, entries_size, entries) != STATUS_SUCCESS) {
+            return NULL;
+        }
+    }
+    
+    if (crc32_calculate(entries, entries_size) != header->partition_array_crc32) {
+        return NULL;
+    }
+    
+    return entries;
+}
+
+// Read and validate the header at `lba` plus its entry array (two reads).
+// Only used for the backup table.
+static u8* read_gpt_table(block_device_t* dev, u64 lba, gpt_header_t* header_out) {
+    u32 block_size = dev->block_size;
+    gpt_header_t* header = arena_alloc(block_size);
+    
+    if (!header) {
+        return NULL;
+    }
+    
+    if (block_read(dev, lba, 1, header) != STATUS_SUCCESS) {
+        return NULL;
+    }
+    
+    if (!validate_gpt_header(dev, lba, header)) {
+        return NULL;
+    }
+    
+    memcpy(header_out, header, sizeof(gpt_header_t));
+    return load_gpt_entry_array(dev, header_out, NULL, 0);
+}
+
 // ============================================================================
 // GPT Entry Validation
 // ============================================================================
@@ -454,7 +347,10 @@ static void check_gpt_entries(gpt_header_t* header,
 // GPT Restoration
 // ============================================================================
 
-static bool restore_gpt_table(block_device_t* dev, gpt_header_t* header) {
+// Write `header` and its (already validated) entry array to the alternate
+// location.
+static bool restore_gpt_table(block_device_t* dev, gpt_header_t* header,
+                              const u8* entries) {
     u32 block_size = dev->block_size;
     gpt_header_t* new_header = alloc_zero_pool(block_size);
     
@@ -480,40 +376,16 @@ static bool restore_gpt_table(block_device_t* dev, gpt_header_t* header) {
     set_header_crc(new_header->header_size, new_header);
     
     // Write new header
-    u64 offset = new_header->my_lba * block_size;
-    status_t status = dev->write_disk(dev, dev->media_id, offset, 
-                                      block_size, new_header);
+    status_t status = block_write(dev, new_header->my_lba, 1, new_header);
+    free_pool(new_header);
     
     if (status != STATUS_SUCCESS) {
-        free_pool(new_header);
         return false;
     }
     
-    // Read and write partition entries
+    // Write entries to the new location
     u32 entries_size = header->num_partition_entries * header->partition_entry_size;
-    u8* entries = alloc_pool(entries_size);
-    
-    if (!entries) {
-        free_pool(new_header);
-        return false;
-    }
-    
-    // Read original entries
-    offset = header->partition_entry_lba * block_size;
-    status = dev->read_disk(dev, dev->media_id, offset, entries_size, entries);
-    
-    if (status != STATUS_SUCCESS) {
-        free_pool(entries);
-        free_pool(new_header);
-        return false;
-    }
-    
-    // Write to new location
-    offset = new_entry_lba * block_size;
-    status = dev->write_disk(dev, dev->media_id, offset, entries_size, entries);
-    
-    free_pool(entries);
-    free_pool(new_header);
+    status = block_write_bytes(dev, new_entry_lba * block_size, entries_size, entries);
     
     return (status == STATUS_SUCCESS);
 }
@@ -535,141 +407,80 @@ typedef struct {
     bool is_bootable;
 } gpt_partition_info_t;
 
+// Validated result of a discovery, hung off block_device_t
+typedef struct gpt_cache {
+    gpt_header_t header;
+    u32 num_partitions;
+    gpt_partition_info_t partitions[];
+} gpt_cache_t;
+
 // ============================================================================
 // Main GPT Discovery Function
 // ============================================================================
 
-status_t discover_gpt_partitions(block_device_t* dev,
-                                 gpt_partition_info_t* partitions,
-                                 u32* num_partitions,
-                                 u32 max_partitions) {
-    u32 block_size = dev->block_size;
-    u64 last_block = dev->total_sectors - 1;
-    master_boot_record_t* mbr = NULL;
-    gpt_header_t* primary_header = NULL;
-    gpt_header_t* backup_header = NULL;
-    gpt_partition_entry_t* entries = NULL;
-    partition_entry_status_t* entry_status = NULL;
-    status_t result = STATUS_NOT_FOUND;
-    u32 count = 0;
-    
-    // Validate block size
-    if (block_size < sizeof(master_boot_record_t)) {
-        return STATUS_INVALID_PARAM;
-    }
-    
-    // Read and validate protective MBR
-    mbr = alloc_pool(block_size);
-    if (!mbr) {
-        return STATUS_OUT_OF_MEMORY;
-    }
-    
-    if (dev->read_disk(dev, dev->media_id, 0, block_size, mbr) != STATUS_SUCCESS) {
-        result = STATUS_ERROR;
-        goto cleanup;
-    }
-    
-    // Verify protective MBR
-    bool has_gpt_partition = false;
+static bool is_protective_mbr(const master_boot_record_t* mbr) {
     for (u32 i = 0; i < MAX_MBR_PARTITIONS; i++) {
         if (mbr->partition[i].boot_indicator == 0x00 &&
             mbr->partition[i].os_indicator == PMBR_GPT_PARTITION &&
             mbr->partition[i].starting_lba == 1) {
-            has_gpt_partition = true;
-            break;
+            return true;
         }
     }
+    return false;
+}
+
+static bool is_usable_entry(const gpt_partition_entry_t* entry,
+                            const partition_entry_status_t* status) {
+    // Skip unused, invalid, or OS-specific partitions
+    return !compare_guid(&entry->partition_type_guid, &GUID_UNUSED) &&
+           !status->out_of_range &&
+           !status->overlap &&
+           !status->os_specific;
+}
+
+// Parse a validated entry array into a permanent cache on `dev`
+static status_t build_gpt_cache(block_device_t* dev, gpt_header_t* header,
+                                u8* entries) {
+    partition_entry_status_t* entry_status =
+        arena_alloc_zero(header->num_partition_entries *
+                         sizeof(partition_entry_status_t));
     
-    if (!has_gpt_partition) {
-        goto cleanup;
-    }
-    
-    // Allocate GPT headers
-    primary_header = alloc_zero_pool(sizeof(gpt_header_t));
-    backup_header = alloc_zero_pool(sizeof(gpt_header_t));
-    
-    if (!primary_header || !backup_header) {
-        result = STATUS_OUT_OF_MEMORY;
-        goto cleanup;
+    if (!entry_status) {
+        return STATUS_OUT_OF_MEMORY;
     }
     
-    // Validate primary and backup GPT
-    bool primary_valid = validate_gpt_table(dev, PRIMARY_PART_HEADER_LBA, primary_header);
-    bool backup_valid = false;
+    // Check partition entries
+    check_gpt_entries(header, (gpt_partition_entry_t*)entries, entry_status);
     
-    if (!primary_valid) {
-        // Try backup GPT
-        backup_valid = validate_gpt_table(dev, last_block, backup_header);
-        
-        if (backup_valid) {
-            // Restore primary from backup
-            restore_gpt_table(dev, backup_header);
-            primary_valid = validate_gpt_table(dev, 
-                                                       backup_header->alternate_lba,
-                                                       primary_header);
-        }
-    } else {
-        // Primary valid, check backup
-        backup_valid = validate_gpt_table(dev, primary_header->alternate_lba, 
-                                         backup_header);
-        
-        if (!backup_valid) {
-            // Restore backup from primary
-            restore_gpt_table(dev, primary_header);
-            backup_valid = validate_gpt_table(dev, primary_header->alternate_lba,
-                                             backup_header);
+    u32 count = 0;
+    for (u32 i = 0; i < header->num_partition_entries; i++) {
+        gpt_partition_entry_t* entry = 
+            (gpt_partition_entry_t*)(entries + i * header->partition_entry_size);
+        if (is_usable_entry(entry, &entry_status[i])) {
+            count++;
         }
     }
     
-    if (!primary_valid && !backup_valid) {
-        result = STATUS_NOT_FOUND;
-        goto cleanup;
-    }
-    
-    // Use primary header for partition enumeration
-    gpt_header_t* header = primary_valid ? primary_header : backup_header;
-    
-    // Read partition entries
-    u32 entries_size = header->num_partition_entries * header->partition_entry_size;
-    entries = alloc_pool(entries_size);
-    
-    if (!entries) {
-        result = STATUS_OUT_OF_MEMORY;
-        goto cleanup;
-    }
-    
-    u64 offset = header->partition_entry_lba * block_size;
-    if (dev->read_disk(dev, dev->media_id, offset, entries_size, entries) != STATUS_SUCCESS) {
-        result = STATUS_ERROR;
-        goto cleanup;
-    }
-    
-    // Allocate entry status array
-    entry_status = alloc_zero_pool(header->num_partition_entries * 
-                                   sizeof(partition_entry_status_t));
-    
-    if (!entry_status) {
-        result = STATUS_OUT_OF_MEMORY;
-        goto cleanup;
+    // The cache outlives the current boot stage
+    gpt_cache_t* cache = boot_alloc(sizeof(gpt_cache_t) +
+                                    count * sizeof(gpt_partition_info_t));
+    if (!cache) {
+        return STATUS_OUT_OF_MEMORY;
     }
     
-    // Check partition entries
-    check_gpt_entries(header, entries, entry_status);
+    memcpy(&cache->header, header, sizeof(gpt_header_t));
+    count = 0;
     
     // Process partition entries
-    for (u32 i = 0; i < header->num_partition_entries && count < max_partitions; i++) {
+    for (u32 i = 0; i < header->num_partition_entries; i++) {
         gpt_partition_entry_t* entry = 
-            (gpt_partition_entry_t*)((u8*)entries + i * header->partition_entry_size);
+            (gpt_partition_entry_t*)(entries + i * header->partition_entry_size);
         
-        // Skip unused, invalid, or OS-specific partitions
-        if (compare_guid(&entry->partition_type_guid, &GUID_UNUSED) ||
-            entry_status[i].out_of_range ||
-            entry_status[i].overlap ||
-            entry_status[i].os_specific) {
+        if (!is_usable_entry(entry, &entry_status[i])) {
             continue;
         }
         
-        gpt_partition_info_t* part = &partitions[count];
+        gpt_partition_info_t* part = &cache->partitions[count];
         
         copy_guid(&part->type_guid, &entry->partition_type_guid);
         copy_guid(&part->unique_guid, &entry->unique_guid);
@@ -691,19 +502,160 @@ status_t discover_gpt_partitions(block_device_t* dev,
         count++;
     }
     
-    *num_partitions = count;
-    result = STATUS_SUCCESS;
+    cache->num_partitions = count;
+    dev->gpt_cache = cache;
+    return STATUS_SUCCESS;
+}
+
+// Probe the disk. Common path is a single read of LBA 0..33 that covers
+// the PMBR, the primary header and its entry array; the backup header at
+// the last LBA is only read when the primary is damaged.
+static status_t scan_gpt(block_device_t* dev) {
+    u32 block_size = dev->block_size;
+    u64 last_block = dev->total_sectors - 1;
+    status_t result = STATUS_NOT_FOUND;
+    arena_mark_t mark = arena_mark();
+    
+    u64 span = 2 + (GPT_DEFAULT_ENTRY_ARRAY_SIZE + block_size - 1) / block_size;
+    if (span > dev->total_sectors) {
+        span = dev->total_sectors;
+    }
     
-cleanup:
-    if (mbr) free_pool(mbr);
-    if (primary_header) free_pool(primary_header);
-    if (backup_header) free_pool(backup_header);
-    if (entries) free_pool(entries);
-    if (entry_status) free_pool(entry_status);
+    u64 buf_size = span * block_size;
+    u8* buf = arena_alloc(buf_size);
+    if (!buf) {
+        return STATUS_OUT_OF_MEMORY;
+    }
     
+    if (block_read(dev, 0, (u32)span, buf) != STATUS_SUCCESS) {
+        result = STATUS_ERROR;
+        goto out;
+    }
+    
+    // Verify protective MBR
+    if (!is_protective_mbr((master_boot_record_t*)buf)) {
+        goto out;
+    }
+    
+    // Primary header and entries straight from the buffer
+    gpt_header_t* header = NULL;
+    u8* entries = NULL;
+    
+    if (span > PRIMARY_PART_HEADER_LBA) {
+        header = (gpt_header_t*)(buf + PRIMARY_PART_HEADER_LBA * block_size);
+        if (validate_gpt_header(dev, PRIMARY_PART_HEADER_LBA, header)) {
+            entries = load_gpt_entry_array(dev, header, buf, buf_size);
+        }
+    }
+    
+    if (!entries) {
+        // Try backup GPT, restore primary from it
+        header = arena_alloc(sizeof(gpt_header_t));
+        if (!header) {
+            result = STATUS_OUT_OF_MEMORY;
+            goto out;
+        }
+        
+        entries = read_gpt_table(dev, last_block, header);
+        if (!entries) {
+            goto out;
+        }
+        
+        restore_gpt_table(dev, header, entries);
+    }
+    
+    result = build_gpt_cache(dev, header, entries);
+    
+out:
+    // Nothing but the cache survives the probe
+    arena_release(mark);
     return result;
 }
 
+// Forget the cached table, e.g. after rewriting it
+void gpt_invalidate_cache(block_device_t* dev) {
+    gpt_cache_t* cache = dev->gpt_cache;
+    
+    if (cache) {
+        boot_free(cache, sizeof(gpt_cache_t) +
+                         cache->num_partitions * sizeof(gpt_partition_info_t));
+    }
+    dev->gpt_cache = NULL;
+}
+
+status_t discover_gpt_partitions(block_device_t* dev,
+                                 gpt_partition_info_t* partitions,
+                                 u32* num_partitions,
+                                 u32 max_partitions) {
+    // Validate block size
+    if (dev->block_size < sizeof(master_boot_record_t)) {
+        return STATUS_INVALID_PARAM;
+    }
+    
+    // Later lookups are served from the cache without any I/O
+    if (!dev->gpt_cache) {
+        trace_begin("gpt scan");
+        status_t status = scan_gpt(dev);
+        trace_end("gpt scan", dev->gpt_cache ? dev->gpt_cache->num_partitions : 0);
+        if (status != STATUS_SUCCESS) {
+            return status;
+        }
+    }
+    
+    const gpt_cache_t* cache = dev->gpt_cache;
+    u32 count = cache->num_partitions;
+    if (count > max_partitions) {
+        count = max_partitions;
+    }
+    
+    memcpy(partitions, cache->partitions, count * sizeof(gpt_partition_info_t));
+    *num_partitions = count;
+    return STATUS_SUCCESS;
+}
+
+typedef struct {
+    block_device_t** devs;
+    status_t* status;
+    u32 found;
+} gpt_scan_job_t;
+
+static void scan_gpt_task(void* ctx, u32 i) {
+    gpt_scan_job_t* job = (gpt_scan_job_t*)ctx;
+    block_device_t* dev = job->devs[i];
+    
+    if (dev->block_size < sizeof(master_boot_record_t)) {
+        job->status[i] = STATUS_INVALID_PARAM;
+        return;
+    }
+    
+    job->status[i] = dev->gpt_cache ? STATUS_SUCCESS : scan_gpt(dev);
+    if (dev->gpt_cache) {
+        __atomic_fetch_add(&job->found, dev->gpt_cache->num_partitions, __ATOMIC_RELAXED);
+    }
+}
+
+// Scan independent disks (eMMC, SD, USB) at the same time, one core per
+// disk (see Smp.h), so that discover_gpt_partitions() on each is then
+// served from its cache. The disks must not share a driver instance that
+// isn't safe to enter from two cores. status[i] is what disk i's scan
+// returned; STATUS_SUCCESS if any of them had a GPT. Disks without one
+// are left for discover_mbr_partitions(), a single sector read.
+status_t discover_gpt_disks(block_device_t** devs, u32 count, status_t* status) {
+    gpt_scan_job_t job = { devs, status, 0 };
+    bool any = false;
+    
+    trace_begin("partitions");
+    smp_parallel_for(count, scan_gpt_task, &job);
+    trace_end("partitions", job.found);
+    
+    for (u32 i = 0; i < count; i++) {
+        if (status[i] == STATUS_SUCCESS) {
+            any = true;
+        }
+    }
+    return any ? STATUS_SUCCESS : STATUS_NOT_FOUND;
+}
+
 // ============================================================================
 // Helper Functions
 // ============================================================================
@@ -758,16 +710,16 @@ static gpt_partition_info_t* find_partition_by_type(gpt_partition_info_t* partit
 /*
 // Example: Complete GPT partition discovery on Android device
 
-// 1. Implement block device interface
-status_t emmc_read_disk(block_device_t* dev, u32 media_id,
-                        u64 offset, u32 size, void* buffer) {
-    // Read from eMMC at byte offset
+// 1. Implement block device interface (see BlockIo.h)
+status_t emmc_read_blocks(block_device_t* dev, u64 lba,
+                          u32 count, void* buffer) {
+    // Read `count` blocks from eMMC starting at `lba`
     return STATUS_SUCCESS;
 }
 
-status_t emmc_write_disk(block_device_t* dev, u32 media_id,
-                         u64 offset, u32 size, const void* buffer) {
-    // Write to eMMC at byte offset
+status_t emmc_write_blocks(block_device_t* dev, u64 lba,
+                           u32 count, const void* buffer) {
+    // Write `count` blocks to eMMC starting at `lba`
     return STATUS_SUCCESS;
 }
 
@@ -777,10 +729,19 @@ block_device_t emmc_device = {
     .total_sectors = 0x1D1C0000,  // Example: 238GB device
     .block_size = 512,
     .media_id = 1,
-    .read_disk = emmc_read_disk,
-    .write_disk = emmc_write_disk
+    .read_blocks = emmc_read_blocks,
+    .write_blocks = emmc_write_blocks
 };
 
+// Optional: 256-block LRU cache with 32 blocks of read-ahead
+block_cache_attach(&emmc_device, 256, 32);
+
+// Several disks: scan them on all cores at once (after smp_init()); the
+// discover_gpt_partitions() calls below are then served from the caches
+//   block_device_t* disks[2] = { &emmc_device, &sd_device };
+//   status_t disk_status[2];
+//   discover_gpt_disks(disks, 2, disk_status);
+
 // 3. Discover GPT partitions
 gpt_partition_info_t partitions[128];
 u32 num_partitions = 0;
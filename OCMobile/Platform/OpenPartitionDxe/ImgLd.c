@@ -0,0 +1,935 @@
+/**
+ * @file ImgLd.c
+ * Loop block devices over disk image files (.img, .raw, .bin, .dmg)
+ *
+ * An image opened through fs_open() becomes a block_device_t of 512-byte
+ * sectors, so discover_partitions() and create_partition_device() work
+ * inside it exactly as on a disk. All the walking happens once, at open:
+ *  - the backing file's runs on its volume (fs_map) go into an extent
+ *    table, so reads go straight to the volume's block device and its
+ *    cache instead of through the filesystem
+ *  - the image layout becomes one sorted chunk table: a single raw chunk
+ *    for plain images, the chunk list of an Android sparse image, or the
+ *    blkx tables of a UDIF (.dmg) image
+ * Compressed DMG chunks (zlib and LZFSE) are decoded on demand into a
+ * small cache of decoded chunks; nothing is decompressed ahead of time.
+ *
+ * Loop devices are read-only.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../../bootstd.h"
+#include "../../BlockIo.h"
+#include "../../Memory.h"
+#include "../plist/plist.h"
+#include "../inflate/inflate.h"
+#include "../lzfse/lzfse.h"
+
+// ============================================================================
+// Type Definitions
+// ============================================================================
+
+#define IMG_SECTOR_SIZE 512
+#define IMG_CHUNK_SLOTS 2               // decoded DMG chunks kept around
+#define IMG_CHUNK_MAX (8u << 20)        // largest decoded chunk accepted
+#define IMG_INFLATE_SPAN (64u << 10)    // compressed bytes read at a time
+#define IMG_XML_MAX (16u << 20)         // largest DMG resource fork accepted
+
+// Android sparse image (libsparse sparse_format.h), little-endian
+#define SPARSE_HEADER_MAGIC 0xED26FF3A
+#define SPARSE_CHUNK_RAW 0xCAC1
+#define SPARSE_CHUNK_FILL 0xCAC2
+#define SPARSE_CHUNK_DONT_CARE 0xCAC3
+#define SPARSE_CHUNK_CRC32 0xCAC4
+
+typedef struct __attribute__((packed)) {
+    u32 magic;
+    u16 major_version;
+    u16 minor_version;
+    u16 file_hdr_sz;
+    u16 chunk_hdr_sz;
+    u32 blk_sz;
+    u32 total_blks;
+    u32 total_chunks;
+    u32 image_checksum;
+} sparse_header_t;
+
+typedef struct __attribute__((packed)) {
+    u16 chunk_type;
+    u16 reserved;
+    u32 chunk_sz;           // output blocks
+    u32 total_sz;           // bytes in the file, this header included
+} sparse_chunk_header_t;
+
+// UDIF (.dmg): big-endian "koly" trailer in the last 512 bytes, whose
+// XML resource fork holds one "mish" table per blkx entry
+#define UDIF_KOLY_MAGIC 0x6B6F6C79      // "koly"
+#define UDIF_MISH_MAGIC 0x6D697368      // "mish"
+#define UDIF_KOLY_SIZE 512
+#define UDIF_KOLY_XML_OFFSET 0xD8
+#define UDIF_KOLY_XML_LENGTH 0xE0
+#define UDIF_KOLY_SECTOR_COUNT 0x1EC
+#define UDIF_MISH_SECTOR_NUMBER 0x08
+#define UDIF_MISH_DATA_OFFSET 0x18
+#define UDIF_MISH_CHUNK_COUNT 0xC8
+#define UDIF_MISH_CHUNKS 0xCC
+#define UDIF_CHUNK_SIZE 40
+
+#define UDIF_CHUNK_ZERO 0x00000000
+#define UDIF_CHUNK_RAW 0x00000001
+#define UDIF_CHUNK_IGNORE 0x00000002
+#define UDIF_CHUNK_ZLIB 0x80000005
+#define UDIF_CHUNK_LZFSE 0x80000007
+#define UDIF_CHUNK_COMMENT 0x7FFFFFFE
+#define UDIF_CHUNK_END 0xFFFFFFFF
+
+typedef enum {
+    IMG_FORMAT_RAW,
+    IMG_FORMAT_SPARSE,
+    IMG_FORMAT_DMG
+} img_format_t;
+
+typedef enum {
+    CHUNK_FILL,             // a repeated 32-bit pattern
+    CHUNK_RAW,              // stored as is at file_offset
+    CHUNK_ZLIB,             // zlib stream of `stored` bytes at file_offset
+    CHUNK_LZFSE             // LZFSE stream of `stored` bytes at file_offset
+} img_chunk_kind_t;
+
+// One run of the image, in image bytes. The table is sorted by offset;
+// anything between two entries (holes, don't-care, DMG free space) reads
+// as zeros.
+typedef struct {
+    u64 offset;
+    u64 length;
+    u64 file_offset;
+    u64 stored;             // ZLIB: compressed bytes, FILL: the pattern
+    img_chunk_kind_t kind;
+} img_chunk_t;
+
+// One run of the backing file on its volume
+typedef struct {
+    u64 file_offset;
+    u64 length;
+    u64 lba;                // volume blocks
+} img_extent_t;
+
+// A decoded ZLIB chunk
+typedef struct {
+    u8* data;
+    u32 chunk;              // chunk index + 1, 0 = empty
+    u32 used;               // LRU stamp
+} img_slot_t;
+
+// Loop device (logical block device)
+typedef struct {
+    block_device_t block_dev;   // first, so the two cast to each other
+    file_t file;
+    u64 file_size;
+    img_format_t format;
+
+    img_chunk_t* chunks;
+    u32 num_chunks;
+
+    // NULL when the filesystem can't map the file; reads then go through
+    // fs_seek() and fs_read()
+    block_device_t* volume;
+    img_extent_t* extents;
+    u32 num_extents;
+
+    img_slot_t slots[IMG_CHUNK_SLOTS];
+    u32 slot_clock;
+} img_device_t;
+
+// ============================================================================
+// Memory Management (see Memory.h)
+// ============================================================================
+
+// Devices and their tables live until handoff: slab and boot_alloc()
+static slab_cache_t img_device_slab =
+    SLAB_CACHE_INIT("img_device", sizeof(img_device_t));
+
+static inline u32 be32(const u8* p) {
+    return (u32)p[0] << 24 | (u32)p[1] << 16 | (u32)p[2] << 8 | p[3];
+}
+
+static inline u64 be64(const u8* p) {
+    return (u64)be32(p) << 32 | be32(p + 4);
+}
+
+// ============================================================================
+// Backing File
+// ============================================================================
+
+// Index of the last extent starting at or before `offset`
+static u32 find_extent(const img_device_t* img, u64 offset) {
+    u32 lo = 0, hi = img->num_extents;
+
+    while (hi - lo > 1) {
+        u32 mid = lo + (hi - lo) / 2;
+        if (img->extents[mid].file_offset <= offset) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Read file bytes [offset, offset + size)
+static status_t file_read(img_device_t* img, u64 offset, u64 size, void* buffer) {
+    u8* out = (u8*)buffer;
+
+    if (offset > img->file_size || size > img->file_size - offset) {
+        return STATUS_OUT_OF_RANGE;
+    }
+
+    if (!img->volume) {
+        if (fs_seek(&img->file, offset) != 0 ||
+            fs_read(&img->file, out, (size_t)size) != size) {
+            return STATUS_ERROR;
+        }
+        return STATUS_SUCCESS;
+    }
+
+    // The extents cover the file end to end
+    for (u32 i = find_extent(img, offset); size; i++) {
+        const img_extent_t* ext = &img->extents[i];
+        u64 skip = offset - ext->file_offset;
+        u64 n = ext->length - skip;
+        if (n > size) {
+            n = size;
+        }
+
+        status_t status = block_read_bytes(img->volume,
+                                           ext->lba * img->volume->block_size + skip,
+                                           n, out);
+        if (status != STATUS_SUCCESS) {
+            return status;
+        }
+
+        out += n;
+        offset += n;
+        size -= n;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+// Walk the file's runs on disk, folding physically adjacent ones; with
+// `out` NULL only count them. 0 if any part of the file can't be mapped.
+static u32 walk_extents(img_device_t* img, block_device_t** volume, img_extent_t* out) {
+    u32 count = 0;
+    u64 next_lba = 0;
+    fs_extent_t ext;
+
+    for (u64 offset = 0; offset < img->file_size; offset += ext.length) {
+        if (fs_map(&img->file, offset, &ext) != 0 || !ext.length ||
+            !ext.device || !ext.device->block_size ||
+            (*volume && ext.device != *volume)) {
+            return 0;
+        }
+        *volume = ext.device;
+
+        if (ext.length > img->file_size - offset) {
+            ext.length = img->file_size - offset;
+        }
+
+        if (count && ext.lba == next_lba) {
+            if (out) {
+                out[count - 1].length += ext.length;
+            }
+        } else {
+            if (out) {
+                out[count].file_offset = offset;
+                out[count].length = ext.length;
+                out[count].lba = ext.lba;
+            }
+            count++;
+        }
+
+        // only whole-block runs can be continued
+        u32 bs = ext.device->block_size;
+        next_lba = (ext.length % bs) ? (u64)-1 : ext.lba + ext.length / bs;
+    }
+
+    return count;
+}
+
+static void map_extents(img_device_t* img) {
+    block_device_t* volume = NULL;
+    u32 count = walk_extents(img, &volume, NULL);
+    if (!count) {
+        return;
+    }
+
+    img_extent_t* extents = (img_extent_t*)boot_alloc(count * sizeof(img_extent_t));
+    if (!extents) {
+        return;
+    }
+
+    block_device_t* again = NULL;
+    if (walk_extents(img, &again, extents) != count || again != volume) {
+        return;
+    }
+
+    img->volume = volume;
+    img->extents = extents;
+    img->num_extents = count;
+}
+
+// ============================================================================
+// Chunk Table
+// ============================================================================
+
+typedef struct {
+    img_chunk_t* table;     // NULL while counting
+    u32 count;
+    img_chunk_t last;
+} chunk_builder_t;
+
+// Append a chunk, folding raw runs that sit back to back in the file
+static void add_chunk(chunk_builder_t* b, const img_chunk_t* c) {
+    img_chunk_t* last = &b->last;
+
+    if (b->count && c->kind == CHUNK_RAW && last->kind == CHUNK_RAW &&
+        last->offset + last->length == c->offset &&
+        last->file_offset + last->length == c->file_offset) {
+        last->length += c->length;
+    } else {
+        *last = *c;
+        b->count++;
+    }
+
+    if (b->table) {
+        b->table[b->count - 1] = *last;
+    }
+}
+
+static status_t parse_raw(img_device_t* img) {
+    img_chunk_t* chunk = (img_chunk_t*)boot_alloc(sizeof(img_chunk_t));
+    if (!chunk) {
+        return STATUS_OUT_OF_MEMORY;
+    }
+
+    memset(chunk, 0, sizeof(img_chunk_t));
+    chunk->length = img->file_size - img->file_size % IMG_SECTOR_SIZE;
+    chunk->kind = CHUNK_RAW;
+
+    img->format = IMG_FORMAT_RAW;
+    img->chunks = chunk;
+    img->num_chunks = 1;
+    img->block_dev.total_sectors = chunk->length / IMG_SECTOR_SIZE;
+    return STATUS_SUCCESS;
+}
+
+static status_t parse_sparse(img_device_t* img, const sparse_header_t* hdr) {
+    if (hdr->major_version != 1 ||
+        hdr->file_hdr_sz < sizeof(sparse_header_t) ||
+        hdr->chunk_hdr_sz < sizeof(sparse_chunk_header_t) ||
+        !hdr->blk_sz || hdr->blk_sz % IMG_SECTOR_SIZE) {
+        return STATUS_ERROR;
+    }
+
+    chunk_builder_t b = { 0 };
+    b.table = (img_chunk_t*)boot_alloc((size_t)hdr->total_chunks * sizeof(img_chunk_t));
+    if (!b.table && hdr->total_chunks) {
+        return STATUS_OUT_OF_MEMORY;
+    }
+
+    u64 pos = hdr->file_hdr_sz;
+    u64 offset = 0;
+
+    for (u32 i = 0; i < hdr->total_chunks; i++) {
+        sparse_chunk_header_t ch;
+        img_chunk_t c;
+
+        if (file_read(img, pos, sizeof(ch), &ch) != STATUS_SUCCESS ||
+            ch.total_sz < hdr->chunk_hdr_sz) {
+            return STATUS_ERROR;
+        }
+
+        u64 data = pos + hdr->chunk_hdr_sz;
+        u64 data_size = ch.total_sz - hdr->chunk_hdr_sz;
+        u64 length = (u64)ch.chunk_sz * hdr->blk_sz;
+
+        memset(&c, 0, sizeof(c));
+        c.offset = offset;
+        c.length = length;
+
+        switch (ch.chunk_type) {
+        case SPARSE_CHUNK_RAW:
+            if (data_size != length) {
+                return STATUS_ERROR;
+            }
+            c.kind = CHUNK_RAW;
+            c.file_offset = data;
+            add_chunk(&b, &c);
+            break;
+
+        case SPARSE_CHUNK_FILL: {
+            u32 pattern;
+            if (data_size < sizeof(pattern) ||
+                file_read(img, data, sizeof(pattern), &pattern) != STATUS_SUCCESS) {
+                return STATUS_ERROR;
+            }
+            // zero fills are holes
+            if (pattern && length) {
+                c.kind = CHUNK_FILL;
+                c.stored = pattern;
+                add_chunk(&b, &c);
+            }
+            break;
+        }
+
+        case SPARSE_CHUNK_DONT_CARE:
+            break;
+
+        case SPARSE_CHUNK_CRC32:
+            length = 0;
+            break;
+
+        default:
+            return STATUS_ERROR;
+        }
+
+        offset += length;
+        pos += ch.total_sz;
+    }
+
+    if (offset != (u64)hdr->total_blks * hdr->blk_sz) {
+        return STATUS_ERROR;
+    }
+
+    img->format = IMG_FORMAT_SPARSE;
+    img->chunks = b.table;
+    img->num_chunks = b.count;
+    img->block_dev.total_sectors = offset / IMG_SECTOR_SIZE;
+    return STATUS_SUCCESS;
+}
+
+// Every blkx table into `b`, checked against the file and each other
+static status_t dmg_chunks(img_device_t* img, const plist_dict_t* dict,
+                           const plist_entry_t* blkx, u64 sectors,
+                           chunk_builder_t* b) {
+    u64 end = 0;
+
+    for (const plist_entry_t* part = plist_first(dict, blkx); part;
+         part = plist_next(dict, part)) {
+        const plist_entry_t* data = plist_get_child(dict, part, "Data");
+        if (!data || data->type != PLIST_DATA) {
+            return STATUS_ERROR;
+        }
+
+        const u8* mish = data->value.data.bytes;
+        size_t size = data->value.data.length;
+        if (size < UDIF_MISH_CHUNKS || be32(mish) != UDIF_MISH_MAGIC) {
+            return STATUS_ERROR;
+        }
+
+        u64 first = be64(mish + UDIF_MISH_SECTOR_NUMBER);
+        u64 base = be64(mish + UDIF_MISH_DATA_OFFSET);
+        u32 entries = be32(mish + UDIF_MISH_CHUNK_COUNT);
+        if (entries > (size - UDIF_MISH_CHUNKS) / UDIF_CHUNK_SIZE) {
+            return STATUS_ERROR;
+        }
+
+        for (u32 i = 0; i < entries; i++) {
+            const u8* e = mish + UDIF_MISH_CHUNKS + (size_t)i * UDIF_CHUNK_SIZE;
+            u32 type = be32(e);
+            u64 sector = first + be64(e + 8);
+            u64 count = be64(e + 16);
+            img_chunk_t c;
+
+            memset(&c, 0, sizeof(c));
+            c.offset = sector * IMG_SECTOR_SIZE;
+            c.length = count * IMG_SECTOR_SIZE;
+            c.file_offset = base + be64(e + 24);
+            c.stored = be64(e + 32);
+
+            switch (type) {
+            case UDIF_CHUNK_RAW:
+                c.kind = CHUNK_RAW;
+                break;
+            case UDIF_CHUNK_ZLIB:
+                c.kind = CHUNK_ZLIB;
+                break;
+            case UDIF_CHUNK_LZFSE:
+                c.kind = CHUNK_LZFSE;
+                break;
+            case UDIF_CHUNK_ZERO:
+            case UDIF_CHUNK_IGNORE:
+            case UDIF_CHUNK_COMMENT:
+            case UDIF_CHUNK_END:
+                continue;
+            default:
+                // ADC, bzip2, LZMA: convert with hdiutil -format UDZO
+                printf("imgld: dmg chunk type %x not supported\n", type);
+                return STATUS_ERROR;
+            }
+
+            if (!count) {
+                continue;
+            }
+            if (sector < end || count > sectors || sector > sectors - count ||
+                c.file_offset > img->file_size ||
+                c.stored > img->file_size - c.file_offset ||
+                (c.kind == CHUNK_RAW && c.stored < c.length) ||
+                (c.kind != CHUNK_RAW && c.length > IMG_CHUNK_MAX) ||
+                (c.kind == CHUNK_LZFSE && c.stored > 2 * IMG_CHUNK_MAX)) {
+                return STATUS_ERROR;
+            }
+
+            add_chunk(b, &c);
+            end = sector + count;
+        }
+    }
+
+    return STATUS_SUCCESS;
+}
+
+static status_t parse_dmg(img_device_t* img, const u8* koly) {
+    u64 xml_offset = be64(koly + UDIF_KOLY_XML_OFFSET);
+    u64 xml_length = be64(koly + UDIF_KOLY_XML_LENGTH);
+    u64 sectors = be64(koly + UDIF_KOLY_SECTOR_COUNT);
+
+    // Old images keep the tables in a resource fork only; hdiutil
+    // convert gives them the XML one
+    if (!xml_length || xml_length > IMG_XML_MAX ||
+        xml_offset > img->file_size || xml_length > img->file_size - xml_offset) {
+        return STATUS_NOT_FOUND;
+    }
+
+    arena_mark_t mark = arena_mark();
+    status_t status = STATUS_ERROR;
+    plist_dict_t dict;
+    const plist_entry_t* blkx;
+    chunk_builder_t b = { 0 };
+
+    char* xml = (char*)arena_alloc((size_t)xml_length + 1);
+    if (!xml) {
+        status = STATUS_OUT_OF_MEMORY;
+        goto done;
+    }
+
+    if (file_read(img, xml_offset, xml_length, xml) != STATUS_SUCCESS ||
+        plist_parse_xml(xml, (size_t)xml_length, &dict) != 0) {
+        goto done;
+    }
+
+    blkx = plist_get_path(&dict, "resource-fork/blkx");
+    if (!blkx || blkx->type != PLIST_ARRAY) {
+        goto done;
+    }
+
+    // Count, then fill an exactly sized table
+    status = dmg_chunks(img, &dict, blkx, sectors, &b);
+    if (status != STATUS_SUCCESS) {
+        goto done;
+    }
+
+    u32 count = b.count;
+    b.table = (img_chunk_t*)boot_alloc((size_t)count * sizeof(img_chunk_t));
+    b.count = 0;
+    if (!b.table && count) {
+        status = STATUS_OUT_OF_MEMORY;
+        goto done;
+    }
+
+    status = dmg_chunks(img, &dict, blkx, sectors, &b);
+    if (status == STATUS_SUCCESS) {
+        img->format = IMG_FORMAT_DMG;
+        img->chunks = b.table;
+        img->num_chunks = b.count;
+        img->block_dev.total_sectors = sectors;
+    }
+
+done:
+    arena_release(mark);
+    return status;
+}
+
+static status_t detect_layout(img_device_t* img) {
+    sparse_header_t hdr;
+    u8 koly[UDIF_KOLY_SIZE];
+
+    if (img->file_size >= sizeof(hdr) &&
+        file_read(img, 0, sizeof(hdr), &hdr) == STATUS_SUCCESS &&
+        hdr.magic == SPARSE_HEADER_MAGIC) {
+        return parse_sparse(img, &hdr);
+    }
+
+    if (img->file_size >= UDIF_KOLY_SIZE &&
+        file_read(img, img->file_size - UDIF_KOLY_SIZE, UDIF_KOLY_SIZE, koly) == STATUS_SUCCESS &&
+        be32(koly) == UDIF_KOLY_MAGIC) {
+        return parse_dmg(img, koly);
+    }
+
+    if (img->file_size < IMG_SECTOR_SIZE) {
+        return STATUS_NOT_FOUND;
+    }
+    return parse_raw(img);
+}
+
+// Index of the last chunk starting at or before `offset` (num_chunks if none)
+static u32 find_chunk(const img_device_t* img, u64 offset) {
+    u32 lo = 0, hi = img->num_chunks;
+
+    while (lo < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+        if (img->chunks[mid].offset <= offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo ? lo - 1 : img->num_chunks;
+}
+
+// ============================================================================
+// Compressed Chunks
+// ============================================================================
+
+typedef struct {
+    img_device_t* img;
+    u64 next;               // file offset of the next input span
+    u64 left;               // compressed bytes still to read
+    u8* span;
+    u8* out;
+    u64 produced;
+    u64 capacity;
+} inflate_ctx_t;
+
+static size_t inflate_in(void* ctx, const u8** data) {
+    inflate_ctx_t* z = (inflate_ctx_t*)ctx;
+    size_t n = z->left < IMG_INFLATE_SPAN ? (size_t)z->left : IMG_INFLATE_SPAN;
+
+    if (!n || file_read(z->img, z->next, n, z->span) != STATUS_SUCCESS) {
+        return 0;
+    }
+
+    z->next += n;
+    z->left -= n;
+    *data = z->span;
+    return n;
+}
+
+static int inflate_out(void* ctx, const u8* data, size_t len) {
+    inflate_ctx_t* z = (inflate_ctx_t*)ctx;
+
+    if (len > z->capacity - z->produced) {
+        return -1;
+    }
+    memcpy(z->out + z->produced, data, len);
+    z->produced += len;
+    return 0;
+}
+
+static status_t inflate_chunk(img_device_t* img, const img_chunk_t* c, u8* out) {
+    arena_mark_t mark = arena_mark();
+    inflate_ctx_t z;
+    status_t status = STATUS_OUT_OF_MEMORY;
+
+    z.img = img;
+    z.next = c->file_offset;
+    z.left = c->stored;
+    z.span = (u8*)arena_alloc(c->stored < IMG_INFLATE_SPAN ? (size_t)c->stored : IMG_INFLATE_SPAN);
+    z.out = out;
+    z.produced = 0;
+    z.capacity = c->length;
+
+    if (z.span) {
+        status = (inflate_stream(INFLATE_ZLIB, inflate_in, inflate_out, &z) == 0 &&
+                  z.produced == c->length) ? STATUS_SUCCESS : STATUS_CRC_ERROR;
+    }
+
+    arena_release(mark);
+    return status;
+}
+
+// An LZFSE chunk is decoded in one go: its blocks reach back into each other
+static status_t lzfse_chunk(img_device_t* img, const img_chunk_t* c, u8* out) {
+    arena_mark_t mark = arena_mark();
+    u8* in = (u8*)arena_alloc(c->stored ? (size_t)c->stored : 1);
+    status_t status = in ? file_read(img, c->file_offset, c->stored, in) : STATUS_OUT_OF_MEMORY;
+    size_t produced;
+
+    if (status == STATUS_SUCCESS) {
+        status = (lzfse_decompress(in, (size_t)c->stored, out, (size_t)c->length, &produced) == 0 &&
+                  produced == c->length) ? STATUS_SUCCESS : STATUS_CRC_ERROR;
+    }
+
+    arena_release(mark);
+    return status;
+}
+
+// Decoded contents of chunk `index`, from the slots or freshly decoded
+static const u8* decoded_chunk(img_device_t* img, u32 index) {
+    img_slot_t* victim = &img->slots[0];
+
+    for (u32 s = 0; s < IMG_CHUNK_SLOTS; s++) {
+        img_slot_t* slot = &img->slots[s];
+        if (slot->chunk == index + 1) {
+            slot->used = ++img->slot_clock;
+            return slot->data;
+        }
+        if (slot->used < victim->used) {
+            victim = slot;
+        }
+    }
+
+    const img_chunk_t* c = &img->chunks[index];
+
+    victim->chunk = 0;
+    status_t status = c->kind == CHUNK_LZFSE ? lzfse_chunk(img, c, victim->data)
+                                             : inflate_chunk(img, c, victim->data);
+    if (status != STATUS_SUCCESS) {
+        return NULL;
+    }
+
+    victim->chunk = index + 1;
+    victim->used = ++img->slot_clock;
+    return victim->data;
+}
+
+static status_t attach_slots(img_device_t* img) {
+    u64 largest = 0;
+
+    for (u32 i = 0; i < img->num_chunks; i++) {
+        if (img->chunks[i].kind >= CHUNK_ZLIB && img->chunks[i].length > largest) {
+            largest = img->chunks[i].length;
+        }
+    }
+    if (!largest) {
+        return STATUS_SUCCESS;
+    }
+
+    for (u32 s = 0; s < IMG_CHUNK_SLOTS; s++) {
+        img->slots[s].data = (u8*)boot_alloc((size_t)largest);
+        if (!img->slots[s].data) {
+            return STATUS_OUT_OF_MEMORY;
+        }
+    }
+    return STATUS_SUCCESS;
+}
+
+// ============================================================================
+// Loop Block Device Operations
+// ============================================================================
+
+// `size` bytes of chunk `index`, starting `skip` bytes into it
+static status_t read_chunk(img_device_t* img, u32 index, u64 skip, u64 size, u8* out) {
+    const img_chunk_t* c = &img->chunks[index];
+
+    switch (c->kind) {
+    case CHUNK_RAW:
+        return file_read(img, c->file_offset + skip, size, out);
+
+    case CHUNK_FILL: {
+        // sector aligned, so the pattern is too
+        u32 pattern = (u32)c->stored;
+        for (u64 i = 0; i < size; i += sizeof(pattern)) {
+            memcpy(out + i, &pattern, sizeof(pattern));
+        }
+        return STATUS_SUCCESS;
+    }
+
+    case CHUNK_ZLIB:
+    case CHUNK_LZFSE: {
+        const u8* data = decoded_chunk(img, index);
+        if (!data) {
+            return STATUS_CRC_ERROR;
+        }
+        memcpy(out, data + skip, (size_t)size);
+        return STATUS_SUCCESS;
+    }
+    }
+
+    return STATUS_ERROR;
+}
+
+static status_t img_read_blocks(block_device_t* dev, u64 lba,
+                                u32 count, void* buffer) {
+    img_device_t* img = (img_device_t*)dev;
+    u64 pos = lba * IMG_SECTOR_SIZE;
+    u64 size = (u64)count * IMG_SECTOR_SIZE;
+    u8* out = (u8*)buffer;
+
+    // Start at the chunk holding `pos`, or the first one after it
+    u32 i = find_chunk(img, pos);
+    if (i == img->num_chunks) {
+        i = 0;
+    } else if (pos >= img->chunks[i].offset + img->chunks[i].length) {
+        i++;
+    }
+
+    while (size) {
+        const img_chunk_t* c = i < img->num_chunks ? &img->chunks[i] : NULL;
+        u64 n;
+
+        if (!c || pos < c->offset) {
+            // hole up to the next chunk
+            n = c ? c->offset - pos : size;
+            if (n > size) {
+                n = size;
+            }
+            memset(out, 0, (size_t)n);
+        } else {
+            u64 skip = pos - c->offset;
+            n = c->length - skip;
+            if (n > size) {
+                n = size;
+            }
+            status_t status = read_chunk(img, i, skip, n, out);
+            if (status != STATUS_SUCCESS) {
+                return status;
+            }
+            i++;
+        }
+
+        out += n;
+        pos += n;
+        size -= n;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+// Volume LBA of [lba, lba + count) if it is one plain run on the volume
+static bool volume_lba(const img_device_t* img, u64 lba, u32 count, u64* out) {
+    if (!img->volume || img->volume->block_size != IMG_SECTOR_SIZE) {
+        return false;
+    }
+
+    u64 pos = lba * IMG_SECTOR_SIZE;
+    u64 size = (u64)count * IMG_SECTOR_SIZE;
+    u32 i = find_chunk(img, pos);
+    if (i == img->num_chunks) {
+        return false;
+    }
+
+    // find_chunk() gives the last chunk at or before `pos`; past its end
+    // is a hole, which only img_read_blocks() fills in
+    const img_chunk_t* c = &img->chunks[i];
+    if (c->kind != CHUNK_RAW || pos >= c->offset + c->length ||
+        pos + size > c->offset + c->length) {
+        return false;
+    }
+
+    u64 file_pos = c->file_offset + (pos - c->offset);
+    const img_extent_t* ext = &img->extents[find_extent(img, file_pos)];
+    u64 skip = file_pos - ext->file_offset;
+    if (skip >= ext->length || skip + size > ext->length || skip % IMG_SECTOR_SIZE) {
+        return false;
+    }
+
+    *out = ext->lba + skip / IMG_SECTOR_SIZE;
+    return true;
+}
+
+// Asynchronous path: reads that land on one plain run of the volume are
+// passed down as they are, everything else completes here
+static status_t img_submit(block_device_t* dev, block_io_t* io) {
+    img_device_t* img = (img_device_t*)dev;
+    u64 target;
+
+    if (io->flags & BLOCK_IO_WRITE) {
+        io->status = STATUS_ERROR;
+        return STATUS_ERROR;
+    }
+
+    if (volume_lba(img, io->device_lba, io->count, &target)) {
+        return block_forward(img->volume, io, target - io->device_lba);
+    }
+
+    io->status = img_read_blocks(dev, io->device_lba, io->count, io->buffer);
+    return io->status;
+}
+
+static void img_poll(block_device_t* dev) {
+    img_device_t* img = (img_device_t*)dev;
+    if (img->volume->poll) {
+        img->volume->poll(img->volume);
+    }
+}
+
+// ============================================================================
+// Create Loop Device
+// ============================================================================
+
+static const char* const img_format_names[] = { "raw", "sparse", "dmg" };
+
+img_device_t* create_image_device(fs_t* fs, const char* path) {
+    img_device_t* img = (img_device_t*)slab_alloc(&img_device_slab);
+    if (!img) {
+        return NULL;
+    }
+
+    memset(img, 0, sizeof(img_device_t));
+
+    if (fs_open(fs, path, &img->file) != 0) {
+        slab_free(&img_device_slab, img);
+        return NULL;
+    }
+    img->file_size = fs_size(&img->file);
+
+    // Extents first, so even probing the layout reads through them
+    map_extents(img);
+
+    status_t status = detect_layout(img);
+    if (status == STATUS_SUCCESS) {
+        status = attach_slots(img);
+    }
+    if (status != STATUS_SUCCESS) {
+        printf("imgld: %s: not a usable image (%d)\n", path, status);
+        fs_close(&img->file);
+        slab_free(&img_device_slab, img);
+        return NULL;
+    }
+
+    img->block_dev.block_size = IMG_SECTOR_SIZE;
+    img->block_dev.read_blocks = img_read_blocks;
+    img->block_dev.private_data = img;
+    if (img->volume) {
+        u32 per_block = img->volume->block_size / IMG_SECTOR_SIZE;
+        img->block_dev.max_transfer_blocks = img->volume->max_transfer_blocks * (per_block ? per_block : 1);
+        img->block_dev.submit = img_submit;
+        img->block_dev.poll = img_poll;
+    }
+
+    printf("imgld: %s: %s, %llu sectors in %u chunks, %s\n", path,
+           img_format_names[img->format], img->block_dev.total_sectors,
+           img->num_chunks, img->volume ? "mapped" : "through the filesystem");
+
+    return img;
+}
+
+// ============================================================================
+// Example Usage
+// ============================================================================
+
+/*
+// Boot from an image on an already mounted volume
+
+img_device_t* img = create_image_device(&sd_fs, "/images/android.img");
+if (!img) {
+    // not there, or not an image
+}
+
+// Optional: the loop device can carry its own cache (see BlockIo.h)
+block_cache_attach(&img->block_dev, 64, 16);
+
+// The image is a disk like any other
+partition_info_t partitions[32];
+u32 num_partitions = 0;
+
+if (discover_partitions(&img->block_dev, partitions, &num_partitions, 32) == STATUS_SUCCESS) {
+    for (u32 i = 0; i < num_partitions; i++) {
+        partition_device_t* part = create_partition_device(&img->block_dev, &partitions[i]);
+        // Mount part->block_dev...
+    }
+}
+*/
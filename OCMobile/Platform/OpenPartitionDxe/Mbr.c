@@ -15,15 +15,14 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "../../bootstd.h"
+#include "../../BlockIo.h"
+#include "../../Memory.h"
+
 // ============================================================================
 // Type Definitions
 // ============================================================================
 
-typedef uint64_t u64;
-typedef uint32_t u32;
-typedef uint16_t u16;
-typedef uint8_t u8;
-
 #define SECTOR_SIZE 512
 #define MBR_SIGNATURE 0xAA55
 #define MAX_MBR_PARTITIONS 4
@@ -31,17 +30,6 @@ typedef uint8_t u8;
 #define EXTENDED_WINDOWS_PARTITION 0x0F
 #define PMBR_GPT_PARTITION 0xEE
 
-// Status codes
-typedef enum {
-    STATUS_SUCCESS = 0,
-    STATUS_ERROR = -1,
-    STATUS_NOT_FOUND = -2,
-    STATUS_INVALID_PARAM = -3,
-    STATUS_OUT_OF_MEMORY = -4,
-    STATUS_MEDIA_CHANGED = -5,
-    STATUS_NO_MEDIA = -6
-} status_t;
-
 // ============================================================================
 // MBR Structures
 // ============================================================================
@@ -97,49 +85,10 @@ typedef struct {
     char type_name[32];
 } mbr_partition_info_t;
 
-// ============================================================================
-// Block Device Interface
-// ============================================================================
-
-typedef struct block_device {
-    void *private_data;
-    u64 total_sectors;
-    u32 block_size;
-    u32 media_id;
-    
-    status_t (*read_disk)(struct block_device *dev, u32 media_id,
-                         u64 offset, u32 size, void *buffer);
-    status_t (*write_disk)(struct block_device *dev, u32 media_id,
-                          u64 offset, u32 size, const void *buffer);
-} block_device_t;
-
 // ============================================================================
 // Memory/String Utilities
 // ============================================================================
 
-static void* memcpy(void* dest, const void* src, size_t n) {
-    u8* d = (u8*)dest;
-    const u8* s = (const u8*)src;
-    while (n--) *d++ = *s++;
-    return dest;
-}
-
-static void* memset(void* s, int c, size_t n) {
-    u8* p = (u8*)s;
-    while (n--) *p++ = (u8)c;
-    return s;
-}
-
-static int memcmp(const void* s1, const void* s2, size_t n) {
-    const u8* p1 = (const u8*)s1;
-    const u8* p2 = (const u8*)s2;
-    while (n--) {
-        if (*p1 != *p2) return *p1 - *p2;
-        p1++; p2++;
-    }
-    return 0;
-}
-
 static void strcpy_s(char* dest, size_t dest_size, const char* src) {
     size_t i = 0;
     while (i < dest_size - 1 && src[i] != '\0') {
@@ -150,24 +99,21 @@ static void strcpy_s(char* dest, size_t dest_size, const char* src) {
 }
 
 // ============================================================================
-// Memory Allocation (implement based on your environment)
+// Memory Allocation
 // ============================================================================
 
+// Sector-sized buffers come from slabs, larger ones (entry arrays) from the
+// stage arena; free_pool() on arena memory is a no-op (see Memory.h).
 static void* alloc_pool(size_t size) {
-    // TODO: Implement based on your memory allocator
-    return NULL;
+    return mem_alloc(size);
 }
 
 static void* alloc_zero_pool(size_t size) {
-    void* ptr = alloc_pool(size);
-    if (ptr) {
-        memset(ptr, 0, size);
-    }
-    return ptr;
+    return mem_alloc_zero(size);
 }
 
 static void free_pool(void* ptr) {
-    // TODO: Implement based on your memory allocator
+    mem_free(ptr);
 }
 
 // ============================================================================
@@ -295,9 +241,7 @@ static status_t process_extended_partition(block_device_t* dev,
     // Process chain of EBRs
     while (current_ebr_lba != 0 && *partition_count < max_partitions) {
         // Read EBR
-        u64 offset = current_ebr_lba * dev->block_size;
-        status_t status = dev->read_disk(dev, dev->media_id, offset,
-                                        dev->block_size, ebr);
+        status_t status = block_read(dev, current_ebr_lba, 1, ebr);
         
         if (status != STATUS_SUCCESS) {
             free_pool(ebr);
@@ -374,7 +318,7 @@ status_t discover_mbr_partitions(block_device_t* dev,
     }
     
     // Read MBR from LBA 0
-    status_t status = dev->read_disk(dev, dev->media_id, 0, dev->block_size, mbr);
+    status_t status = block_read(dev, 0, 1, mbr);
     if (status != STATUS_SUCCESS) {
         result = status;
         goto cleanup;
@@ -537,7 +481,7 @@ status_t write_mbr(block_device_t* dev, const master_boot_record_t* mbr) {
     }
     
     // Write to LBA 0
-    return dev->write_disk(dev, dev->media_id, 0, dev->block_size, mbr);
+    return block_write(dev, 0, 1, mbr);
 }
 
 // Create a basic MBR with one partition
@@ -546,7 +490,8 @@ status_t create_simple_mbr(block_device_t* dev,
                           u64 partition_size_sectors,
                           u8 partition_type,
                           bool bootable) {
-    master_boot_record_t* mbr = alloc_zero_pool(sizeof(master_boot_record_t));
+    // A whole block, since that is what gets written
+    master_boot_record_t* mbr = alloc_zero_pool(dev->block_size);
     if (!mbr) {
         return STATUS_OUT_OF_MEMORY;
     }
@@ -574,16 +519,16 @@ status_t create_simple_mbr(block_device_t* dev,
 /*
 // Example: Complete MBR partition discovery on device
 
-// 1. Implement block device interface
-status_t disk_read(block_device_t* dev, u32 media_id,
-                   u64 offset, u32 size, void* buffer) {
-    // Read from storage device at byte offset
+// 1. Implement block device interface (see BlockIo.h)
+status_t disk_read(block_device_t* dev, u64 lba,
+                   u32 count, void* buffer) {
+    // Read `count` blocks from the storage device starting at `lba`
     return STATUS_SUCCESS;
 }
 
-status_t disk_write(block_device_t* dev, u32 media_id,
-                    u64 offset, u32 size, const void* buffer) {
-    // Write to storage device at byte offset
+status_t disk_write(block_device_t* dev, u64 lba,
+                    u32 count, const void* buffer) {
+    // Write `count` blocks to the storage device starting at `lba`
     return STATUS_SUCCESS;
 }
 
@@ -593,8 +538,8 @@ block_device_t storage_device = {
     .total_sectors = 0x3A38000,  // Example: 30GB device
     .block_size = 512,
     .media_id = 1,
-    .read_disk = disk_read,
-    .write_disk = disk_write
+    .read_blocks = disk_read,
+    .write_blocks = disk_write
 };
 
 // 3. Discover MBR partitions
@@ -10,29 +10,20 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "../../bootstd.h"
+#include "../../BlockIo.h"
+#include "../../Memory.h"
+#include "../../Trace.h"
+#include "../crc32/crc32.h"
+
 // ============================================================================
 // Type Definitions
 // ============================================================================
 
-typedef uint64_t u64;
-typedef uint32_t u32;
-typedef uint16_t u16;
-typedef uint8_t u8;
-
 #define SECTOR_SIZE 512
 #define GPT_HEADER_SIGNATURE 0x5452415020494645ULL  // "EFI PART"
 #define MBR_SIGNATURE 0xAA55
 
-// Status codes
-typedef enum {
-    STATUS_SUCCESS = 0,
-    STATUS_ERROR = -1,
-    STATUS_NO_MEDIA = -2,
-    STATUS_INVALID_PARAM = -3,
-    STATUS_OUT_OF_RESOURCES = -4,
-    STATUS_NOT_FOUND = -5
-} status_t;
-
 // Partition types
 typedef enum {
     PART_TYPE_UNKNOWN = 0,
@@ -113,18 +104,6 @@ typedef struct {
     u8 mbr_type;
 } partition_info_t;
 
-// Block Device Interface
-typedef struct block_device {
-    void *private_data;
-    u64 total_sectors;
-    u32 block_size;
-    
-    // Function pointers for device operations
-    status_t (*read_blocks)(struct block_device *dev, u64 lba, u32 count, void *buffer);
-    status_t (*write_blocks)(struct block_device *dev, u64 lba, u32 count, const void *buffer);
-    status_t (*flush)(struct block_device *dev);
-} block_device_t;
-
 // Partition Device (logical block device)
 typedef struct {
     block_device_t block_dev;
@@ -133,46 +112,24 @@ typedef struct {
 } partition_device_t;
 
 // ============================================================================
-// Memory Management (Simple allocator - implement based on your environment)
+// Memory Management (see Memory.h)
 // ============================================================================
 
+static slab_cache_t partition_device_slab =
+    SLAB_CACHE_INIT("partition_device", sizeof(partition_device_t));
+
 static void* simple_malloc(size_t size) {
-    // TODO: Implement based on your bare metal memory allocator
-    // This is a placeholder - you need to implement actual allocation
-    return NULL;
+    return mem_alloc(size);
 }
 
 static void simple_free(void* ptr) {
-    // TODO: Implement based on your bare metal memory allocator
+    mem_free(ptr);
 }
 
 // ============================================================================
 // String/Memory Utilities
 // ============================================================================
 
-static void* memcpy(void* dest, const void* src, size_t n) {
-    u8* d = (u8*)dest;
-    const u8* s = (const u8*)src;
-    while (n--) *d++ = *s++;
-    return dest;
-}
-
-static void* memset(void* s, int c, size_t n) {
-    u8* p = (u8*)s;
-    while (n--) *p++ = (u8)c;
-    return s;
-}
-
-static int memcmp(const void* s1, const void* s2, size_t n) {
-    const u8* p1 = (const u8*)s1;
-    const u8* p2 = (const u8*)s2;
-    while (n--) {
-        if (*p1 != *p2) return *p1 - *p2;
-        p1++; p2++;
-    }
-    return 0;
-}
-
 // Convert UTF-16LE to ASCII (simple version)
 static void utf16_to_ascii(char* dest, const u16* src, size_t max_len) {
     size_t i = 0;
@@ -183,26 +140,6 @@ static void utf16_to_ascii(char* dest, const u16* src, size_t max_len) {
     dest[i] = '\0';
 }
 
-// ============================================================================
-// CRC32 Calculation (for GPT validation)
-// ============================================================================
-
-static const u32 crc32_table[256] = {
-    0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA,
-    // ... (full table omitted for brevity - include full 256 entries)
-};
-
-static u32 calculate_crc32(const void* data, size_t length) {
-    u32 crc = 0xFFFFFFFF;
-    const u8* p = (const u8*)data;
-    
-    for (size_t i = 0; i < length; i++) {
-        crc = crc32_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
-    }
-    
-    return crc ^ 0xFFFFFFFF;
-}
-
 // ============================================================================
 // GPT Partition Detection
 // ============================================================================
@@ -217,7 +154,7 @@ static status_t detect_gpt_partitions(block_device_t* device,
     u32 count = 0;
     
     // Read GPT header from LBA 1
-    if (device->read_blocks(device, 1, 1, sector_buf) != STATUS_SUCCESS) {
+    if (block_read(device, 1, 1, sector_buf) != STATUS_SUCCESS) {
         return STATUS_ERROR;
     }
     
@@ -231,7 +168,7 @@ static status_t detect_gpt_partitions(block_device_t* device,
     // Validate header CRC
     u32 orig_crc = gpt_hdr->header_crc32;
     gpt_hdr->header_crc32 = 0;
-    u32 calc_crc = calculate_crc32(gpt_hdr, gpt_hdr->header_size);
+    u32 calc_crc = crc32_calculate(gpt_hdr, gpt_hdr->header_size);
     
     if (orig_crc != calc_crc) {
         return STATUS_ERROR;
@@ -246,8 +183,8 @@ static status_t detect_gpt_partitions(block_device_t* device,
     
     // Read partition entries
     u32 sectors_needed = (entries_size + SECTOR_SIZE - 1) / SECTOR_SIZE;
-    if (device->read_blocks(device, gpt_hdr->partition_entry_lba, 
-                           sectors_needed, entries) != STATUS_SUCCESS) {
+    if (block_read(device, gpt_hdr->partition_entry_lba,
+                   sectors_needed, entries) != STATUS_SUCCESS) {
         simple_free(entries);
         return STATUS_ERROR;
     }
@@ -299,7 +236,7 @@ static status_t detect_mbr_partitions(block_device_t* device,
     u32 count = 0;
     
     // Read MBR from LBA 0
-    if (device->read_blocks(device, 0, 1, sector_buf) != STATUS_SUCCESS) {
+    if (block_read(device, 0, 1, sector_buf) != STATUS_SUCCESS) {
         return STATUS_ERROR;
     }
     
@@ -351,25 +288,31 @@ static status_t detect_mbr_partitions(block_device_t* device,
 // Main Partition Discovery
 // ============================================================================
 
-status_t discover_partitions(block_device_t* device,
-                             partition_info_t* partitions,
-                             u32* num_partitions,
-                             u32 max_partitions) {
+static status_t probe_partitions(block_device_t* device,
+                                 partition_info_t* partitions,
+                                 u32* num_partitions,
+                                 u32 max_partitions) {
     status_t status;
     
     // Try GPT first (UEFI spec order)
     status = detect_gpt_partitions(device, partitions, num_partitions, max_partitions);
-    if (status == STATUS_SUCCESS) {
-        return STATUS_SUCCESS;
-    }
     
     // Fall back to MBR
-    status = detect_mbr_partitions(device, partitions, num_partitions, max_partitions);
-    if (status == STATUS_SUCCESS) {
-        return STATUS_SUCCESS;
+    if (status != STATUS_SUCCESS) {
+        status = detect_mbr_partitions(device, partitions, num_partitions, max_partitions);
     }
     
-    return STATUS_NOT_FOUND;
+    return status == STATUS_SUCCESS ? STATUS_SUCCESS : STATUS_NOT_FOUND;
+}
+
+status_t discover_partitions(block_device_t* device,
+                             partition_info_t* partitions,
+                             u32* num_partitions,
+                             u32 max_partitions) {
+    trace_begin("partitions");
+    status_t status = probe_partitions(device, partitions, num_partitions, max_partitions);
+    trace_end("partitions", status == STATUS_SUCCESS ? *num_partitions : 0);
+    return status;
 }
 
 // ============================================================================
@@ -386,7 +329,8 @@ static status_t partition_read_blocks(block_device_t* dev, u64 lba,
         return STATUS_INVALID_PARAM;
     }
     
-    return part_dev->parent->read_blocks(part_dev->parent, parent_lba, count, buffer);
+    // Through the parent's cache, so partitions share one set of buffers
+    return block_read(part_dev->parent, parent_lba, count, buffer);
 }
 
 static status_t partition_write_blocks(block_device_t* dev, u64 lba,
@@ -399,12 +343,25 @@ static status_t partition_write_blocks(block_device_t* dev, u64 lba,
         return STATUS_INVALID_PARAM;
     }
     
-    return part_dev->parent->write_blocks(part_dev->parent, parent_lba, count, buffer);
+    return block_write(part_dev->parent, parent_lba, count, buffer);
 }
 
 static status_t partition_flush(block_device_t* dev) {
     partition_device_t* part_dev = (partition_device_t*)dev;
-    return part_dev->parent->flush(part_dev->parent);
+    return block_flush(part_dev->parent);
+}
+
+// Asynchronous path: shift into the parent's LBA space and pass it down
+static status_t partition_submit(block_device_t* dev, block_io_t* io) {
+    partition_device_t* part_dev = (partition_device_t*)dev;
+    return block_forward(part_dev->parent, io, part_dev->info.start_lba);
+}
+
+static void partition_poll(block_device_t* dev) {
+    partition_device_t* part_dev = (partition_device_t*)dev;
+    if (part_dev->parent->poll) {
+        part_dev->parent->poll(part_dev->parent);
+    }
 }
 
 // ============================================================================
@@ -413,7 +370,7 @@ static status_t partition_flush(block_device_t* dev) {
 
 partition_device_t* create_partition_device(block_device_t* parent,
                                            partition_info_t* info) {
-    partition_device_t* part_dev = (partition_device_t*)simple_malloc(sizeof(partition_device_t));
+    partition_device_t* part_dev = (partition_device_t*)slab_alloc(&partition_device_slab);
     if (!part_dev) {
         return NULL;
     }
@@ -428,6 +385,9 @@ partition_device_t* create_partition_device(block_device_t* parent,
     part_dev->block_dev.read_blocks = partition_read_blocks;
     part_dev->block_dev.write_blocks = partition_write_blocks;
     part_dev->block_dev.flush = partition_flush;
+    part_dev->block_dev.submit = partition_submit;
+    part_dev->block_dev.poll = partition_poll;
+    part_dev->block_dev.max_transfer_blocks = parent->max_transfer_blocks;
     part_dev->block_dev.private_data = part_dev;
     
     return part_dev;
@@ -441,6 +401,7 @@ partition_device_t* create_partition_device(block_device_t* parent,
 // Example: How to use this driver with your hardware
 
 // 1. Implement your hardware-specific block device
+//    (SDHCI eMMC/SD hosts: sdhci_init() in Platform/SdMmcDxe/Sdhci.c)
 status_t mmc_read_blocks(block_device_t* dev, u64 lba, u32 count, void* buffer) {
     // Your MMC/eMMC/SD card read implementation
     return STATUS_SUCCESS;
@@ -466,6 +427,9 @@ block_device_t mmc_device = {
     .flush = mmc_flush
 };
 
+// Optional: cache 256 blocks, read ahead 32 (see BlockIo.h)
+block_cache_attach(&mmc_device, 256, 32);
+
 // 3. Discover partitions
 partition_info_t partitions[32];
 u32 num_partitions = 0;
@@ -0,0 +1,807 @@
+#include "Sdhci.h"
+#include "../../Memory.h"
+#include "../../arch/aarch64/io.h"
+
+/*
+ * OpenCore Mobile – SDHCI host driver
+ * See Sdhci.h. Register layout per the SD Host Controller spec 3.00/4.00.
+ */
+
+/* =========================
+ *  Registers
+ * ========================= */
+
+#define SDHCI_BLOCK_SIZE        0x04    /* u16 */
+#define SDHCI_BLOCK_COUNT       0x06    /* u16 */
+#define SDHCI_ARGUMENT          0x08
+#define SDHCI_TRANSFER_MODE     0x0C    /* u16 */
+#define SDHCI_COMMAND           0x0E    /* u16 */
+#define SDHCI_RESPONSE          0x10    /* 4 x u32 */
+#define SDHCI_BUFFER            0x20
+#define SDHCI_PRESENT_STATE     0x24
+#define SDHCI_HOST_CONTROL      0x28    /* u8 */
+#define SDHCI_POWER_CONTROL     0x29    /* u8 */
+#define SDHCI_CLOCK_CONTROL     0x2C    /* u16 */
+#define SDHCI_TIMEOUT_CONTROL   0x2E    /* u8 */
+#define SDHCI_SOFTWARE_RESET    0x2F    /* u8 */
+#define SDHCI_INT_STATUS        0x30    /* normal + error */
+#define SDHCI_INT_ENABLE        0x34
+#define SDHCI_SIGNAL_ENABLE     0x38
+#define SDHCI_HOST_CONTROL2     0x3E    /* u16 */
+#define SDHCI_CAPABILITIES      0x40
+#define SDHCI_ADMA_ADDRESS      0x58    /* lo, hi at +4 */
+#define SDHCI_HOST_VERSION      0xFE    /* u16 */
+
+#define XFER_DMA                (1u << 0)
+#define XFER_BLK_CNT_EN         (1u << 1)
+#define XFER_AUTO_CMD12         (1u << 2)
+#define XFER_READ               (1u << 4)
+#define XFER_MULTI              (1u << 5)
+
+#define CMD_RESP_136            0x01
+#define CMD_RESP_48             0x02
+#define CMD_RESP_48_BUSY        0x03
+#define CMD_CRC                 0x08
+#define CMD_INDEX               0x10
+#define CMD_DATA                0x20
+
+#define PRESENT_CMD_INHIBIT     (1u << 0)
+#define PRESENT_DAT_INHIBIT     (1u << 1)
+
+#define CTRL_4BIT               (1u << 1)
+#define CTRL_HISPD              (1u << 2)
+#define CTRL_ADMA32             (2u << 3)
+#define CTRL_8BIT               (1u << 5)
+
+#define CTRL2_V4_MODE           (1u << 12)
+#define CTRL2_64BIT_ADDR        (1u << 13)
+
+#define CLOCK_INT_EN            (1u << 0)
+#define CLOCK_INT_STABLE        (1u << 1)
+#define CLOCK_CARD_EN           (1u << 2)
+
+#define RESET_ALL               (1u << 0)
+#define RESET_CMD               (1u << 1)
+#define RESET_DATA              (1u << 2)
+
+#define INT_CMD_COMPLETE        (1u << 0)
+#define INT_XFER_COMPLETE       (1u << 1)
+#define INT_DMA                 (1u << 3)
+#define INT_BUF_WR_READY        (1u << 4)
+#define INT_BUF_RD_READY        (1u << 5)
+#define INT_ERROR               (1u << 15)
+#define INT_CMD_TIMEOUT         (1u << 16)
+#define INT_CMD_CRC             (1u << 17)
+#define INT_DATA_TIMEOUT        (1u << 20)
+#define INT_DATA_CRC            (1u << 21)
+#define INT_ERROR_MASK          0x03FF0000u
+
+#define CAPS_8BIT               (1u << 18)
+#define CAPS_ADMA2              (1u << 19)
+#define CAPS_3V3                (1u << 24)
+#define CAPS_3V0                (1u << 25)
+#define CAPS_1V8                (1u << 26)
+#define CAPS_64BIT              (1u << 28)
+
+#define SDHCI_SPEC_300          2
+#define SDHCI_SPEC_400          3
+
+/* ADMA2 descriptor attributes */
+#define ADMA_VALID              (1u << 0)
+#define ADMA_END                (1u << 1)
+#define ADMA_TRAN               (2u << 4)
+#define ADMA_MAX_LEN            0x10000u        /* encoded as 0 */
+
+/* =========================
+ *  Card commands
+ * ========================= */
+
+#define MMC_GO_IDLE_STATE       0
+#define MMC_SEND_OP_COND        1
+#define MMC_ALL_SEND_CID        2
+#define MMC_SET_RELATIVE_ADDR   3   /* SD: SEND_RELATIVE_ADDR */
+#define MMC_SWITCH              6   /* SD app: SET_BUS_WIDTH */
+#define MMC_SELECT_CARD         7
+#define MMC_SEND_EXT_CSD        8   /* SD: SEND_IF_COND */
+#define MMC_SEND_CSD            9
+#define MMC_SET_BLOCKLEN        16
+#define MMC_READ_SINGLE_BLOCK   17
+#define MMC_READ_MULTIPLE_BLOCK 18
+#define MMC_WRITE_BLOCK         24
+#define MMC_WRITE_MULTIPLE_BLOCK 25
+#define SD_APP_OP_COND          41
+#define MMC_APP_CMD             55
+
+#define RSP_NONE                0
+#define RSP_R1                  (CMD_RESP_48 | CMD_CRC | CMD_INDEX)
+#define RSP_R1B                 (CMD_RESP_48_BUSY | CMD_CRC | CMD_INDEX)
+#define RSP_R2                  (CMD_RESP_136 | CMD_CRC)
+#define RSP_R3                  CMD_RESP_48
+
+#define OCR_BUSY                (1u << 31)
+#define OCR_HCS                 (1u << 30)
+#define OCR_VOLTAGE_WINDOW      0x00FF8000u
+#define MMC_OCR_DUAL_VOLTAGE    0x00000080u
+
+#define EXT_CSD_BUS_WIDTH       183
+#define EXT_CSD_HS_TIMING       185
+#define EXT_CSD_SEC_COUNT       212
+
+#define SECTOR_SIZE             512
+#define CMD_TIMEOUT_US          100000
+#define RESET_TIMEOUT_US        100000
+#define OCR_RETRIES             1000        /* 1 ms apart */
+
+/* =========================
+ *  Register access
+ * ========================= */
+
+static inline u32 rd32(const sdhci_host_t *host, u32 reg) {
+    return mmio_read32(host->base + reg);
+}
+
+static inline void wr32(const sdhci_host_t *host, u32 reg, u32 val) {
+    mmio_write32(host->base + reg, val);
+}
+
+static inline u16 rd16(const sdhci_host_t *host, u32 reg) {
+    return mmio_read16(host->base + reg);
+}
+
+static inline void wr16(const sdhci_host_t *host, u32 reg, u16 val) {
+    mmio_write16(host->base + reg, val);
+}
+
+static inline u8 rd8(const sdhci_host_t *host, u32 reg) {
+    return mmio_read8(host->base + reg);
+}
+
+static inline void wr8(const sdhci_host_t *host, u32 reg, u8 val) {
+    mmio_write8(host->base + reg, val);
+}
+
+static status_t sdhci_reset(sdhci_host_t *host, u8 mask) {
+    wr8(host, SDHCI_SOFTWARE_RESET, mask);
+
+    for (u32 t = 0; t < RESET_TIMEOUT_US; t++) {
+        if (!(rd8(host, SDHCI_SOFTWARE_RESET) & mask))
+            return STATUS_SUCCESS;
+        udelay(1);
+    }
+    return STATUS_ERROR;
+}
+
+/* Wait for any bit in `mask` or an error; 0 on timeout */
+static u32 sdhci_wait_int(sdhci_host_t *host, u32 mask, u32 timeout_us) {
+    for (u32 t = 0; t < timeout_us; t++) {
+        u32 st = rd32(host, SDHCI_INT_STATUS);
+        if (st & (mask | INT_ERROR))
+            return st;
+        udelay(1);
+    }
+    return 0;
+}
+
+static status_t int_to_status(u32 st) {
+    if (st & INT_CMD_TIMEOUT)
+        return STATUS_NO_MEDIA;
+    if (st & (INT_CMD_CRC | INT_DATA_CRC))
+        return STATUS_CRC_ERROR;
+    return STATUS_ERROR;
+}
+
+/* Recover from an error interrupt */
+static void sdhci_abort(sdhci_host_t *host, u32 st) {
+    wr32(host, SDHCI_INT_STATUS, st);
+    sdhci_reset(host, RESET_CMD | RESET_DATA);
+}
+
+/* =========================
+ *  Commands
+ * ========================= */
+
+static status_t sdhci_wait_idle(sdhci_host_t *host, u32 inhibit) {
+    for (u32 t = 0; t < CMD_TIMEOUT_US; t++) {
+        if (!(rd32(host, SDHCI_PRESENT_STATE) & inhibit))
+            return STATUS_SUCCESS;
+        udelay(1);
+    }
+    return STATUS_ERROR;
+}
+
+/* Non-data command; `resp` (4 words) may be NULL */
+static status_t sdhci_cmd(sdhci_host_t *host, u32 idx, u32 arg, u32 rsp, u32 *resp) {
+    u32 inhibit = PRESENT_CMD_INHIBIT;
+    bool busy = (rsp & CMD_RESP_48_BUSY) == CMD_RESP_48_BUSY;
+
+    if (busy)
+        inhibit |= PRESENT_DAT_INHIBIT;
+
+    if (sdhci_wait_idle(host, inhibit) != STATUS_SUCCESS)
+        return STATUS_ERROR;
+
+    wr32(host, SDHCI_INT_STATUS, ~0u);
+    wr32(host, SDHCI_ARGUMENT, arg);
+    wr16(host, SDHCI_TRANSFER_MODE, 0);
+    wr16(host, SDHCI_COMMAND, (u16)((idx << 8) | rsp));
+
+    u32 st = sdhci_wait_int(host, INT_CMD_COMPLETE, CMD_TIMEOUT_US);
+    if (!st || (st & INT_ERROR)) {
+        sdhci_abort(host, st);
+        return st ? int_to_status(st) : STATUS_ERROR;
+    }
+
+    /* R1b: the card signals busy on DAT0 until it is done */
+    if (busy) {
+        st = sdhci_wait_int(host, INT_XFER_COMPLETE, CMD_TIMEOUT_US);
+        if (!st || (st & INT_ERROR)) {
+            sdhci_abort(host, st);
+            return st ? int_to_status(st) : STATUS_ERROR;
+        }
+    }
+
+    if (resp) {
+        for (u32 i = 0; i < 4; i++)
+            resp[i] = rd32(host, SDHCI_RESPONSE + i * 4);
+    }
+
+    wr32(host, SDHCI_INT_STATUS, ~0u);
+    return STATUS_SUCCESS;
+}
+
+static status_t sdhci_app_cmd(sdhci_host_t *host, u32 idx, u32 arg, u32 rsp, u32 *resp) {
+    status_t status = sdhci_cmd(host, MMC_APP_CMD, host->rca << 16, RSP_R1, NULL);
+    if (status != STATUS_SUCCESS)
+        return status;
+    return sdhci_cmd(host, idx, arg, rsp, resp);
+}
+
+/* Program everything for a data command; DMA address must be set already */
+static void sdhci_issue_data(sdhci_host_t *host, u32 idx, u32 arg,
+                             u32 count, bool write, bool dma) {
+    u16 mode = XFER_BLK_CNT_EN;
+
+    if (count > 1)
+        mode |= XFER_MULTI | XFER_AUTO_CMD12;
+    if (!write)
+        mode |= XFER_READ;
+    if (dma)
+        mode |= XFER_DMA;
+
+    wr32(host, SDHCI_INT_STATUS, ~0u);
+    wr16(host, SDHCI_BLOCK_SIZE, (7u << 12) | SECTOR_SIZE);
+    wr16(host, SDHCI_BLOCK_COUNT, (u16)count);
+    wr32(host, SDHCI_ARGUMENT, arg);
+    wr16(host, SDHCI_TRANSFER_MODE, mode);
+    wr16(host, SDHCI_COMMAND, (u16)((idx << 8) | RSP_R1 | CMD_DATA));
+}
+
+static inline u32 rw_command(u32 count, bool write) {
+    if (write)
+        return count > 1 ? MMC_WRITE_MULTIPLE_BLOCK : MMC_WRITE_BLOCK;
+    return count > 1 ? MMC_READ_MULTIPLE_BLOCK : MMC_READ_SINGLE_BLOCK;
+}
+
+static inline u32 card_address(const sdhci_host_t *host, u64 lba) {
+    return (host->flags & SDHCI_CARD_HC) ? (u32)lba : (u32)(lba * SECTOR_SIZE);
+}
+
+/* =========================
+ *  PIO (fallback)
+ * ========================= */
+
+/* Byte-wise on our side: `buf` may be unaligned and the MMU may be off */
+static status_t sdhci_pio(sdhci_host_t *host, u32 idx, u32 arg,
+                          u32 count, u8 *buf, bool write) {
+    if (sdhci_wait_idle(host, PRESENT_CMD_INHIBIT | PRESENT_DAT_INHIBIT) != STATUS_SUCCESS)
+        return STATUS_ERROR;
+
+    sdhci_issue_data(host, idx, arg, count, write, false);
+
+    u32 ready = write ? INT_BUF_WR_READY : INT_BUF_RD_READY;
+
+    for (u32 b = 0; b < count; b++) {
+        u32 st = sdhci_wait_int(host, ready, CMD_TIMEOUT_US);
+        if (!st || (st & INT_ERROR)) {
+            sdhci_abort(host, st);
+            return st ? int_to_status(st) : STATUS_ERROR;
+        }
+        wr32(host, SDHCI_INT_STATUS, ready);
+
+        for (u32 i = 0; i < SECTOR_SIZE; i += 4) {
+            if (write) {
+                u32 w = (u32)buf[0] | ((u32)buf[1] << 8) |
+                        ((u32)buf[2] << 16) | ((u32)buf[3] << 24);
+                wr32(host, SDHCI_BUFFER, w);
+            } else {
+                u32 w = rd32(host, SDHCI_BUFFER);
+                buf[0] = (u8)w;
+                buf[1] = (u8)(w >> 8);
+                buf[2] = (u8)(w >> 16);
+                buf[3] = (u8)(w >> 24);
+            }
+            buf += 4;
+        }
+    }
+
+    u32 st = sdhci_wait_int(host, INT_XFER_COMPLETE, CMD_TIMEOUT_US);
+    if (!st || (st & INT_ERROR)) {
+        sdhci_abort(host, st);
+        return st ? int_to_status(st) : STATUS_ERROR;
+    }
+
+    wr32(host, SDHCI_INT_STATUS, ~0u);
+    return STATUS_SUCCESS;
+}
+
+/* =========================
+ *  ADMA2
+ * ========================= */
+
+static bool dma_capable(const sdhci_host_t *host, const void *buf, u64 bytes) {
+    uintptr_t p = (uintptr_t)buf;
+
+    if (!(host->flags & SDHCI_HOST_ADMA2))
+        return false;
+    if (host->flags & SDHCI_HOST_ADMA64)
+        return (p & 7) == 0;
+    return (p & 3) == 0 && (u64)p + bytes <= 0x100000000ULL;
+}
+
+/* Describe the (physically contiguous) buffer; the caller checked the size */
+static void adma_build(sdhci_host_t *host, uintptr_t addr, u64 bytes) {
+    u8 *desc = host->adma_table;
+
+    while (bytes) {
+        u32 len = bytes > ADMA_MAX_LEN ? ADMA_MAX_LEN : (u32)bytes;
+        u16 attr = ADMA_VALID | ADMA_TRAN;
+
+        bytes -= len;
+        if (!bytes)
+            attr |= ADMA_END;
+
+        *(u16 *)(desc + 0) = attr;
+        *(u16 *)(desc + 2) = (u16)len;         /* 64 KiB wraps to 0 */
+        *(u32 *)(desc + 4) = (u32)addr;
+        if (host->desc_size > 8) {
+            *(u32 *)(desc + 8) = (u32)((u64)addr >> 32);
+            *(u32 *)(desc + 12) = 0;
+        }
+
+        addr += len;
+        desc += host->desc_size;
+    }
+
+    dcache_flush_range(host->adma_table, (size_t)(desc - host->adma_table));
+}
+
+static void start_io(sdhci_host_t *host, block_io_t *io) {
+    bool write = (io->flags & BLOCK_IO_WRITE) != 0;
+    u64 bytes = (u64)io->count * SECTOR_SIZE;
+    uintptr_t table = (uintptr_t)host->adma_table;
+
+    /* no dirty lines may land on top of what the device writes */
+    dcache_flush_range(io->buffer, (size_t)bytes);
+    adma_build(host, (uintptr_t)io->buffer, bytes);
+
+    wr32(host, SDHCI_ADMA_ADDRESS, (u32)table);
+    wr32(host, SDHCI_ADMA_ADDRESS + 4, (u32)((u64)table >> 32));
+
+    host->active = io;
+    sdhci_issue_data(host, rw_command(io->count, write),
+                     card_address(host, io->device_lba), io->count, write, true);
+}
+
+/* =========================
+ *  Block device operations
+ * ========================= */
+
+static void mmc_poll(block_device_t *dev) {
+    sdhci_host_t *host = (sdhci_host_t *)dev;
+    block_io_t *io = host->active;
+
+    if (!io)
+        return;
+
+    u32 st = rd32(host, SDHCI_INT_STATUS);
+    status_t status;
+
+    if (st & INT_ERROR) {
+        sdhci_abort(host, st);
+        status = int_to_status(st);
+    } else if (st & INT_XFER_COMPLETE) {
+        wr32(host, SDHCI_INT_STATUS, st);
+        status = STATUS_SUCCESS;
+    } else {
+        return;
+    }
+
+    if (!(io->flags & BLOCK_IO_WRITE))
+        dcache_flush_range(io->buffer, (size_t)io->count * SECTOR_SIZE);
+
+    host->active = NULL;
+    io->status = status;
+
+    /* keep the bus busy */
+    block_io_t *next = host->queue_head;
+    if (next) {
+        host->queue_head = next->next;
+        if (!host->queue_head)
+            host->queue_tail = NULL;
+        start_io(host, next);
+    }
+}
+
+static void mmc_drain(sdhci_host_t *host) {
+    while (host->active) {
+        mmc_poll(&host->block_dev);
+        cpu_relax();
+    }
+}
+
+static status_t mmc_submit(block_device_t *dev, block_io_t *io) {
+    sdhci_host_t *host = (sdhci_host_t *)dev;
+    bool write = (io->flags & BLOCK_IO_WRITE) != 0;
+
+    if (!dma_capable(host, io->buffer, (u64)io->count * SECTOR_SIZE)) {
+        /* PIO is synchronous and needs the bus to itself */
+        mmc_drain(host);
+
+        status_t status = sdhci_pio(host, rw_command(io->count, write),
+                                    card_address(host, io->device_lba),
+                                    io->count, (u8 *)io->buffer, write);
+        io->status = status;
+        return status;
+    }
+
+    io->next = NULL;
+
+    if (host->active) {
+        if (host->queue_tail)
+            host->queue_tail->next = io;
+        else
+            host->queue_head = io;
+        host->queue_tail = io;
+        return STATUS_SUCCESS;
+    }
+
+    start_io(host, io);
+    return STATUS_SUCCESS;
+}
+
+/* Synchronous entry points: one request, polled to completion */
+static status_t mmc_transfer(block_device_t *dev, u64 lba, u32 count,
+                             void *buffer, u32 flags) {
+    block_io_t io = {
+        .lba = lba,
+        .count = count,
+        .flags = flags,
+        .buffer = buffer,
+        .device_lba = lba,
+    };
+
+    io.status = STATUS_PENDING;
+    if (mmc_submit(dev, &io) != STATUS_SUCCESS)
+        return io.status;
+
+    while (io.status == STATUS_PENDING) {
+        mmc_poll(dev);
+        cpu_relax();
+    }
+    return io.status;
+}
+
+static status_t mmc_read_blocks(block_device_t *dev, u64 lba, u32 count, void *buffer) {
+    return mmc_transfer(dev, lba, count, buffer, 0);
+}
+
+static status_t mmc_write_blocks(block_device_t *dev, u64 lba, u32 count,
+                                 const void *buffer) {
+    return mmc_transfer(dev, lba, count, (void *)buffer, BLOCK_IO_WRITE);
+}
+
+/* No write cache is enabled on the card, so flushing means draining */
+static status_t mmc_flush(block_device_t *dev) {
+    mmc_drain((sdhci_host_t *)dev);
+    return STATUS_SUCCESS;
+}
+
+/* =========================
+ *  Controller setup
+ * ========================= */
+
+static status_t sdhci_set_clock(sdhci_host_t *host, u32 hz) {
+    u32 base = host->base_clock_hz;
+    u32 div = 0;
+
+    wr16(host, SDHCI_CLOCK_CONTROL, 0);
+
+    /* SDCLK = base / (2 * div), div 0 = base */
+    if (base > hz) {
+        if (host->version >= SDHCI_SPEC_300) {
+            div = (base + 2 * hz - 1) / (2 * hz);
+            if (div > 1023)
+                div = 1023;
+        } else {
+            div = 1;
+            while (div < 128 && base / (2 * div) > hz)
+                div <<= 1;
+        }
+    }
+
+    u16 clk = (u16)(((div & 0xFF) << 8) | (((div >> 8) & 3) << 6) | CLOCK_INT_EN);
+    wr16(host, SDHCI_CLOCK_CONTROL, clk);
+
+    for (u32 t = 0; !(rd16(host, SDHCI_CLOCK_CONTROL) & CLOCK_INT_STABLE); t++) {
+        if (t >= RESET_TIMEOUT_US)
+            return STATUS_ERROR;
+        udelay(1);
+    }
+
+    wr16(host, SDHCI_CLOCK_CONTROL, clk | CLOCK_CARD_EN);
+    return STATUS_SUCCESS;
+}
+
+static status_t sdhci_setup_host(sdhci_host_t *host, u32 base_clock_hz) {
+    if (sdhci_reset(host, RESET_ALL) != STATUS_SUCCESS)
+        return STATUS_NO_MEDIA;
+
+    u32 caps = rd32(host, SDHCI_CAPABILITIES);
+    host->version = rd16(host, SDHCI_HOST_VERSION) & 0xFF;
+
+    host->base_clock_hz = base_clock_hz;
+    if (!host->base_clock_hz) {
+        u32 mhz_mask = host->version >= SDHCI_SPEC_300 ? 0xFF : 0x3F;
+        host->base_clock_hz = ((caps >> 8) & mhz_mask) * 1000000;
+    }
+    if (!host->base_clock_hz)
+        return STATUS_INVALID_PARAM;
+
+    if (caps & CAPS_8BIT)
+        host->flags |= SDHCI_HOST_8BIT;
+
+    /* bus power, highest supported voltage */
+    u8 power;
+    if (caps & CAPS_3V3)
+        power = 0x7 << 1;
+    else if (caps & CAPS_3V0)
+        power = 0x6 << 1;
+    else if (caps & CAPS_1V8)
+        power = 0x5 << 1;
+    else
+        return STATUS_NO_MEDIA;
+
+    wr8(host, SDHCI_POWER_CONTROL, power);
+    wr8(host, SDHCI_POWER_CONTROL, power | 1);
+
+    /* DMA: 128-bit descriptors in v4 mode when 64-bit is there, else 32-bit */
+    u8 ctrl = 0;
+    if (caps & CAPS_ADMA2) {
+        host->flags |= SDHCI_HOST_ADMA2;
+        host->desc_size = 8;
+        ctrl = CTRL_ADMA32;
+
+        if ((caps & CAPS_64BIT) && host->version >= SDHCI_SPEC_400) {
+            host->flags |= SDHCI_HOST_ADMA64;
+            host->desc_size = 16;
+            wr16(host, SDHCI_HOST_CONTROL2,
+                 rd16(host, SDHCI_HOST_CONTROL2) | CTRL2_V4_MODE | CTRL2_64BIT_ADDR);
+        }
+
+        host->adma_table = boot_alloc((size_t)SDHCI_ADMA_DESCS * host->desc_size);
+        if (!host->adma_table)
+            return STATUS_OUT_OF_MEMORY;
+    }
+    wr8(host, SDHCI_HOST_CONTROL, ctrl);
+
+    wr8(host, SDHCI_TIMEOUT_CONTROL, 0xE);
+
+    /* status only; completion is polled */
+    wr32(host, SDHCI_INT_ENABLE, INT_ERROR_MASK | INT_CMD_COMPLETE |
+         INT_XFER_COMPLETE | INT_DMA | INT_BUF_WR_READY | INT_BUF_RD_READY);
+    wr32(host, SDHCI_SIGNAL_ENABLE, 0);
+
+    /* identification runs at 400 kHz */
+    return sdhci_set_clock(host, 400000);
+}
+
+/* =========================
+ *  Card identification
+ * ========================= */
+
+/* CSD bit `start` (spec numbering); SDHCI drops the CRC byte from R2 */
+static u32 csd_bits(const u32 *resp, u32 start, u32 len) {
+    u32 v = 0;
+
+    for (u32 i = 0; i < len; i++) {
+        u32 bit = start - 8 + i;
+        v |= ((resp[bit / 32] >> (bit % 32)) & 1) << i;
+    }
+    return v;
+}
+
+static u64 csd_sectors(const u32 *csd) {
+    if (csd_bits(csd, 126, 2) == 1) {
+        /* CSD 2.0 (SDHC/SDXC): 512 KiB units */
+        return ((u64)csd_bits(csd, 48, 22) + 1) * 1024;
+    }
+
+    u64 c_size = csd_bits(csd, 62, 12);
+    u32 mult = csd_bits(csd, 47, 3);
+    u32 bl_len = csd_bits(csd, 80, 4);
+    return ((c_size + 1) << (mult + 2 + bl_len)) / SECTOR_SIZE;
+}
+
+static status_t sd_identify(sdhci_host_t *host, bool v2) {
+    u32 resp[4];
+    u32 arg = OCR_VOLTAGE_WINDOW | (v2 ? OCR_HCS : 0);
+
+    for (u32 i = 0; i < OCR_RETRIES; i++) {
+        status_t status = sdhci_app_cmd(host, SD_APP_OP_COND, arg, RSP_R3, resp);
+        if (status != STATUS_SUCCESS)
+            return status;
+
+        if (resp[0] & OCR_BUSY) {
+            host->flags |= SDHCI_CARD_SD;
+            if (resp[0] & OCR_HCS)
+                host->flags |= SDHCI_CARD_HC;
+            return STATUS_SUCCESS;
+        }
+        udelay(1000);
+    }
+    return STATUS_NO_MEDIA;
+}
+
+static status_t mmc_identify(sdhci_host_t *host) {
+    u32 resp[4];
+
+    sdhci_cmd(host, MMC_GO_IDLE_STATE, 0, RSP_NONE, NULL);
+
+    for (u32 i = 0; i < OCR_RETRIES; i++) {
+        status_t status = sdhci_cmd(host, MMC_SEND_OP_COND,
+                                    OCR_HCS | OCR_VOLTAGE_WINDOW | MMC_OCR_DUAL_VOLTAGE,
+                                    RSP_R3, resp);
+        if (status != STATUS_SUCCESS)
+            return status;
+
+        if (resp[0] & OCR_BUSY) {
+            /* access mode 10b: sector addressed */
+            if ((resp[0] & (3u << 29)) == (2u << 29))
+                host->flags |= SDHCI_CARD_HC;
+            return STATUS_SUCCESS;
+        }
+        udelay(1000);
+    }
+    return STATUS_NO_MEDIA;
+}
+
+static status_t mmc_switch(sdhci_host_t *host, u32 index, u32 value) {
+    return sdhci_cmd(host, MMC_SWITCH, (3u << 24) | (index << 16) | (value << 8),
+                     RSP_R1B, NULL);
+}
+
+/* eMMC: capacity from EXT_CSD, then 8/4-bit bus at 52 MHz */
+static status_t mmc_configure(sdhci_host_t *host, const u32 *csd) {
+    arena_mark_t mark = arena_mark();
+    u8 *ext_csd = arena_alloc(SECTOR_SIZE);
+    status_t status;
+
+    if (!ext_csd)
+        return STATUS_OUT_OF_MEMORY;
+
+    status = sdhci_pio(host, MMC_SEND_EXT_CSD, 0, 1, ext_csd, false);
+    if (status == STATUS_SUCCESS) {
+        u32 sec = (u32)ext_csd[EXT_CSD_SEC_COUNT] |
+                  ((u32)ext_csd[EXT_CSD_SEC_COUNT + 1] << 8) |
+                  ((u32)ext_csd[EXT_CSD_SEC_COUNT + 2] << 16) |
+                  ((u32)ext_csd[EXT_CSD_SEC_COUNT + 3] << 24);
+        host->block_dev.total_sectors =
+            (host->flags & SDHCI_CARD_HC) ? sec : csd_sectors(csd);
+    }
+    arena_release(mark);
+
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    u8 ctrl = rd8(host, SDHCI_HOST_CONTROL);
+    if (host->flags & SDHCI_HOST_8BIT) {
+        if (mmc_switch(host, EXT_CSD_BUS_WIDTH, 2) == STATUS_SUCCESS)
+            ctrl |= CTRL_8BIT;
+    } else if (mmc_switch(host, EXT_CSD_BUS_WIDTH, 1) == STATUS_SUCCESS) {
+        ctrl |= CTRL_4BIT;
+    }
+
+    u32 clock = 26000000;
+    if (mmc_switch(host, EXT_CSD_HS_TIMING, 1) == STATUS_SUCCESS) {
+        ctrl |= CTRL_HISPD;
+        clock = 52000000;
+    }
+
+    wr8(host, SDHCI_HOST_CONTROL, ctrl);
+    return sdhci_set_clock(host, clock);
+}
+
+/* SD: capacity from CSD, 4-bit bus at default speed */
+static status_t sd_configure(sdhci_host_t *host, const u32 *csd) {
+    host->block_dev.total_sectors = csd_sectors(csd);
+
+    if (sdhci_app_cmd(host, MMC_SWITCH, 2, RSP_R1, NULL) == STATUS_SUCCESS)
+        wr8(host, SDHCI_HOST_CONTROL, rd8(host, SDHCI_HOST_CONTROL) | CTRL_4BIT);
+
+    return sdhci_set_clock(host, 25000000);
+}
+
+status_t sdhci_init(sdhci_host_t *host, uintptr_t base, u32 base_clock_hz) {
+    u32 resp[4];
+    u32 csd[4];
+    status_t status;
+
+    if (!host || !base)
+        return STATUS_INVALID_PARAM;
+
+    memset(host, 0, sizeof(*host));
+    host->base = base;
+
+    status = sdhci_setup_host(host, base_clock_hz);
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    sdhci_cmd(host, MMC_GO_IDLE_STATE, 0, RSP_NONE, NULL);
+
+    /* SD answers CMD8 (v2) and ACMD41; eMMC answers neither */
+    bool sd_v2 = sdhci_cmd(host, MMC_SEND_EXT_CSD, 0x1AA, RSP_R1, resp) == STATUS_SUCCESS &&
+                 (resp[0] & 0xFFF) == 0x1AA;
+
+    status = sd_identify(host, sd_v2);
+    if (status != STATUS_SUCCESS)
+        status = mmc_identify(host);
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    status = sdhci_cmd(host, MMC_ALL_SEND_CID, 0, RSP_R2, NULL);
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    if (host->flags & SDHCI_CARD_SD) {
+        status = sdhci_cmd(host, MMC_SET_RELATIVE_ADDR, 0, RSP_R1, resp);
+        host->rca = resp[0] >> 16;
+    } else {
+        host->rca = 1;
+        status = sdhci_cmd(host, MMC_SET_RELATIVE_ADDR, host->rca << 16, RSP_R1, NULL);
+    }
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    status = sdhci_cmd(host, MMC_SEND_CSD, host->rca << 16, RSP_R2, csd);
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    status = sdhci_cmd(host, MMC_SELECT_CARD, host->rca << 16, RSP_R1B, NULL);
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    if (!(host->flags & SDHCI_CARD_HC)) {
+        status = sdhci_cmd(host, MMC_SET_BLOCKLEN, SECTOR_SIZE, RSP_R1, NULL);
+        if (status != STATUS_SUCCESS)
+            return status;
+    }
+
+    status = (host->flags & SDHCI_CARD_SD) ? sd_configure(host, csd)
+                                           : mmc_configure(host, csd);
+    if (status != STATUS_SUCCESS)
+        return status;
+
+    block_device_t *dev = &host->block_dev;
+    dev->private_data = host;
+    dev->block_size = SECTOR_SIZE;
+    dev->media_id = host->rca;
+    /* one descriptor chain per transfer, 64 KiB per descriptor */
+    dev->max_transfer_blocks = (SDHCI_ADMA_DESCS - 1) * (ADMA_MAX_LEN / SECTOR_SIZE);
+    dev->read_blocks = mmc_read_blocks;
+    dev->write_blocks = mmc_write_blocks;
+    dev->flush = mmc_flush;
+    dev->submit = mmc_submit;
+    dev->poll = mmc_poll;
+
+    return STATUS_SUCCESS;
+}
@@ -0,0 +1,54 @@
+#ifndef SDHCI_H
+#define SDHCI_H
+
+#include "../../BlockIo.h"
+
+/*
+ * OpenCore Mobile – SDHCI host driver for eMMC and SD cards
+ *
+ * Transfers go through ADMA2 descriptor chains and complete
+ * asynchronously: the block device implements submit/poll, so callers can
+ * overlap storage waits with decompression or hashing (see
+ * block_submit()). Hosts without ADMA2, and buffers the DMA engine cannot
+ * address, fall back to PIO.
+ *
+ * Completion is polled from the interrupt status register; no IRQ is
+ * routed.
+ */
+
+#define SDHCI_ADMA_DESCS        128     /* 64 KiB each: 8 MiB per chain */
+
+/* host->flags */
+#define SDHCI_CARD_SD           (1u << 0)   /* else eMMC */
+#define SDHCI_CARD_HC           (1u << 1)   /* block (not byte) addressed */
+#define SDHCI_HOST_ADMA2        (1u << 2)
+#define SDHCI_HOST_ADMA64       (1u << 3)   /* 128-bit descriptors (v4) */
+#define SDHCI_HOST_8BIT         (1u << 4)
+
+typedef struct sdhci_host {
+    block_device_t block_dev;       /* first, so the two cast to each other */
+
+    uintptr_t base;
+    u32 base_clock_hz;
+    u32 version;                    /* SDHCI spec, 2 = 3.00, 3 = 4.00, ... */
+    u32 flags;
+    u32 rca;
+
+    /* ADMA2 */
+    u8 *adma_table;
+    u32 desc_size;
+
+    /* one transfer in flight, the rest wait in order */
+    block_io_t *active;
+    block_io_t *queue_head;
+    block_io_t *queue_tail;
+} sdhci_host_t;
+
+/*
+ * Reset the controller at `base`, identify the card and fill in
+ * host->block_dev. `base_clock_hz` overrides the capability register
+ * (0 = trust it; some SoCs report 0 there).
+ */
+status_t sdhci_init(sdhci_host_t *host, uintptr_t base, u32 base_clock_hz);
+
+#endif /* SDHCI_H */
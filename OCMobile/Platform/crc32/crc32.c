@@ -0,0 +1,439 @@
+#include "crc32.h"
+
+#if defined(__aarch64__)
+#include <arm_acle.h>
+#include <arm_neon.h>
+#endif
+
+/*
+ * Notes for bare metal:
+ *  - With the MMU off every access is Device memory and unaligned loads
+ *    fault, so all wide paths align the pointer first and the NEON path
+ *    only uses byte-element loads.
+ *  - Everything below works on the raw (non-inverted) CRC register;
+ *    inversion happens once in crc32_update().
+ */
+
+/* buffers shorter than this are not worth the PMULL setup/reduction */
+#define CRC32_PMULL_MIN 256
+
+/* ---------- reference table (byte-at-a-time) ---------- */
+
+static const uint32_t crc32_table[256] = {
+    0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
+    0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
+    0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
+    0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+    0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9,
+    0xFA0F3D63, 0x8D080DF5, 0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
+    0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B, 0x35B5A8FA, 0x42B2986C,
+    0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+    0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423,
+    0xCFBA9599, 0xB8BDA50F, 0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
+    0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D, 0x76DC4190, 0x01DB7106,
+    0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+    0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D,
+    0x91646C97, 0xE6635C01, 0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
+    0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457, 0x65B0D9C6, 0x12B7E950,
+    0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+    0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7,
+    0xA4D1C46D, 0xD3D6F4FB, 0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
+    0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9, 0x5005713C, 0x270241AA,
+    0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+    0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81,
+    0xB7BD5C3B, 0xC0BA6CAD, 0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
+    0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683, 0xE3630B12, 0x94643B84,
+    0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+    0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB,
+    0x196C3671, 0x6E6B06E7, 0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
+    0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5, 0xD6D6A3E8, 0xA1D1937E,
+    0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+    0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55,
+    0x316E8EEF, 0x4669BE79, 0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
+    0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F, 0xC5BA3BBE, 0xB2BD0B28,
+    0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+    0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F,
+    0x72076785, 0x05005713, 0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
+    0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21, 0x86D3D2D4, 0xF1D4E242,
+    0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+    0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69,
+    0x616BFFD3, 0x166CCF45, 0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
+    0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB, 0xAED16A4A, 0xD9D65ADC,
+    0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+    0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693,
+    0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
+    0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
+};
+
+static uint32_t crc32_bytewise(uint32_t crc, const uint8_t *p, size_t len) {
+    while (len--)
+        crc = crc32_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+/* ---------- slicing-by-8 ---------- */
+
+/* crc32_slice[0] is crc32_table; [k] advances a byte through k more zeros */
+static uint32_t crc32_slice[8][256];
+
+static crc32_backend_t crc32_selected = CRC32_BACKEND_TABLE;
+static int crc32_ready;
+
+static void crc32_build_slices(void) {
+    for (int i = 0; i < 256; i++)
+        crc32_slice[0][i] = crc32_table[i];
+
+    for (int k = 1; k < 8; k++) {
+        for (int i = 0; i < 256; i++) {
+            uint32_t c = crc32_slice[k - 1][i];
+            crc32_slice[k][i] = (c >> 8) ^ crc32_table[c & 0xFF];
+        }
+    }
+}
+
+static inline uint32_t load_le32(const uint8_t *p) {
+    return (uint32_t)p[0] |
+           ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static uint32_t crc32_slice8(uint32_t crc, const uint8_t *p, size_t len) {
+    while (len && ((uintptr_t)p & 7)) {
+        crc = crc32_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+        len--;
+    }
+
+    while (len >= 8) {
+        uint32_t lo = load_le32(p) ^ crc;
+        uint32_t hi = load_le32(p + 4);
+
+        crc = crc32_slice[7][lo & 0xFF] ^
+              crc32_slice[6][(lo >> 8) & 0xFF] ^
+              crc32_slice[5][(lo >> 16) & 0xFF] ^
+              crc32_slice[4][lo >> 24] ^
+              crc32_slice[3][hi & 0xFF] ^
+              crc32_slice[2][(hi >> 8) & 0xFF] ^
+              crc32_slice[1][(hi >> 16) & 0xFF] ^
+              crc32_slice[0][hi >> 24];
+
+        p += 8;
+        len -= 8;
+    }
+
+    return crc32_bytewise(crc, p, len);
+}
+
+/* ---------- ARMv8 CRC32 / PMULL ---------- */
+
+#if defined(__aarch64__)
+
+#if defined(__clang__)
+#define CRC32_TARGET_CRC   __attribute__((target("crc")))
+#define CRC32_TARGET_PMULL __attribute__((target("aes")))
+#else
+#define CRC32_TARGET_CRC   __attribute__((target("+crc")))
+#define CRC32_TARGET_PMULL __attribute__((target("+crypto")))
+#endif
+
+#define ISAR0_AES(v)   (((v) >> 4) & 0xF)    /* 2 = AES + PMULL */
+#define ISAR0_CRC32(v) (((v) >> 16) & 0xF)   /* 1 = CRC32 instructions */
+
+static uint64_t read_id_aa64isar0(void) {
+    uint64_t v;
+    __asm__ volatile ("mrs %0, ID_AA64ISAR0_EL1" : "=r"(v));
+    return v;
+}
+
+CRC32_TARGET_CRC
+static uint32_t crc32_armv8(uint32_t crc, const uint8_t *p, size_t len) {
+    while (len && ((uintptr_t)p & 7)) {
+        crc = __crc32b(crc, *p++);
+        len--;
+    }
+
+    /* 4x unrolled: crc32x has a 1/cycle throughput on most cores */
+    while (len >= 32) {
+        const uint64_t *q = (const uint64_t *)p;
+        crc = __crc32d(crc, q[0]);
+        crc = __crc32d(crc, q[1]);
+        crc = __crc32d(crc, q[2]);
+        crc = __crc32d(crc, q[3]);
+        p += 32;
+        len -= 32;
+    }
+
+    while (len >= 8) {
+        crc = __crc32d(crc, *(const uint64_t *)p);
+        p += 8;
+        len -= 8;
+    }
+
+    while (len--)
+        crc = __crc32b(crc, *p++);
+
+    return crc;
+}
+
+/*
+ * Folding constants for the reflected 0x04C11DB7 polynomial
+ * (x^n mod P for the 512-, 128- and 64-bit folds, then Barrett mu/P').
+ */
+static const uint64_t crc32_k1k2[2] = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+static const uint64_t crc32_k3k4[2] = { 0x01751997d0ULL, 0x00ccaa009eULL };
+static const uint64_t crc32_k5k0[2] = { 0x0163cd6124ULL, 0x0000000000ULL };
+static const uint64_t crc32_poly[2] = { 0x01db710641ULL, 0x01f7011641ULL };
+
+CRC32_TARGET_PMULL
+static inline uint64x2_t clmul_lo(uint64x2_t a, uint64x2_t b) {
+    return vreinterpretq_u64_p128(vmull_p64(
+        (poly64_t)vgetq_lane_u64(a, 0), (poly64_t)vgetq_lane_u64(b, 0)));
+}
+
+CRC32_TARGET_PMULL
+static inline uint64x2_t clmul_hi(uint64x2_t a, uint64x2_t b) {
+    return vreinterpretq_u64_p128(vmull_high_p64(
+        vreinterpretq_p64_u64(a), vreinterpretq_p64_u64(b)));
+}
+
+/* low half of a times high half of b */
+CRC32_TARGET_PMULL
+static inline uint64x2_t clmul_lo_hi(uint64x2_t a, uint64x2_t b) {
+    return vreinterpretq_u64_p128(vmull_p64(
+        (poly64_t)vgetq_lane_u64(a, 0), (poly64_t)vgetq_lane_u64(b, 1)));
+}
+
+CRC32_TARGET_PMULL
+static inline uint64x2_t load128(const uint8_t *p) {
+    return vreinterpretq_u64_u8(vld1q_u8(p));
+}
+
+CRC32_TARGET_PMULL
+static inline uint64x2_t fold128(uint64x2_t x, uint64x2_t k, uint64x2_t next) {
+    return veorq_u64(veorq_u64(clmul_hi(x, k), clmul_lo(x, k)), next);
+}
+
+/* shift a 128-bit value right by n bytes */
+#define SHR128(x, n) \
+    vreinterpretq_u64_u8(vextq_u8(vreinterpretq_u8_u64(x), vdupq_n_u8(0), (n)))
+
+/* len must be >= 64 and a multiple of 16 */
+CRC32_TARGET_PMULL
+static uint32_t crc32_pmull_fold(uint32_t crc, const uint8_t *p, size_t len) {
+    uint64x2_t x1 = load128(p + 0x00);
+    uint64x2_t x2 = load128(p + 0x10);
+    uint64x2_t x3 = load128(p + 0x20);
+    uint64x2_t x4 = load128(p + 0x30);
+    uint64x2_t k = vld1q_u64(crc32_k1k2);
+    uint64x2_t mask = vreinterpretq_u64_u32(
+        vsetq_lane_u32(0xFFFFFFFF, vsetq_lane_u32(0xFFFFFFFF, vdupq_n_u32(0), 0), 2));
+
+    x1 = veorq_u64(x1, vsetq_lane_u64((uint64_t)crc, vdupq_n_u64(0), 0));
+    p += 64;
+    len -= 64;
+
+    /* fold four lanes of 128 bits in parallel */
+    while (len >= 64) {
+        x1 = fold128(x1, k, load128(p + 0x00));
+        x2 = fold128(x2, k, load128(p + 0x10));
+        x3 = fold128(x3, k, load128(p + 0x20));
+        x4 = fold128(x4, k, load128(p + 0x30));
+        p += 64;
+        len -= 64;
+    }
+
+    /* fold the four lanes into one */
+    k = vld1q_u64(crc32_k3k4);
+    x1 = fold128(x1, k, x2);
+    x1 = fold128(x1, k, x3);
+    x1 = fold128(x1, k, x4);
+
+    while (len >= 16) {
+        x1 = fold128(x1, k, load128(p));
+        p += 16;
+        len -= 16;
+    }
+
+    /* 128 -> 64 bits */
+    x2 = clmul_lo_hi(x1, k);
+    x1 = veorq_u64(SHR128(x1, 8), x2);
+
+    k = vld1q_u64(crc32_k5k0);
+    x2 = SHR128(x1, 4);
+    x1 = vandq_u64(x1, mask);
+    x1 = veorq_u64(clmul_lo(x1, k), x2);
+
+    /* Barrett reduction to 32 bits */
+    k = vld1q_u64(crc32_poly);
+    x2 = vandq_u64(x1, mask);
+    x2 = vandq_u64(clmul_lo_hi(x2, k), mask);
+    x2 = clmul_lo(x2, k);
+    x1 = veorq_u64(x1, x2);
+
+    return vgetq_lane_u32(vreinterpretq_u32_u64(x1), 1);
+}
+
+#endif /* __aarch64__ */
+
+/* ---------- dispatch ---------- */
+
+void crc32_init(void) {
+    crc32_build_slices();
+    crc32_selected = CRC32_BACKEND_TABLE;
+
+#if defined(__aarch64__)
+    uint64_t isar0 = read_id_aa64isar0();
+
+    if (ISAR0_CRC32(isar0) >= 1)
+        crc32_selected = CRC32_BACKEND_ARMV8;
+
+    /* the PMULL path hands its tail to crc32x, so it needs both */
+    if (crc32_selected == CRC32_BACKEND_ARMV8 && ISAR0_AES(isar0) >= 2)
+        crc32_selected = CRC32_BACKEND_PMULL;
+#endif
+
+    crc32_ready = 1;
+}
+
+crc32_backend_t crc32_backend(void) {
+    if (!crc32_ready)
+        crc32_init();
+    return crc32_selected;
+}
+
+static uint32_t crc32_raw(
+    crc32_backend_t backend,
+    uint32_t crc,
+    const uint8_t *p,
+    size_t len
+) {
+    switch (backend) {
+#if defined(__aarch64__)
+    case CRC32_BACKEND_PMULL:
+        if (len >= CRC32_PMULL_MIN) {
+            size_t bulk = len & ~(size_t)15;
+            crc = crc32_pmull_fold(crc, p, bulk);
+            p += bulk;
+            len -= bulk;
+        }
+        return crc32_armv8(crc, p, len);
+
+    case CRC32_BACKEND_ARMV8:
+        return crc32_armv8(crc, p, len);
+#endif
+    default:
+        return crc32_slice8(crc, p, len);
+    }
+}
+
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len) {
+    if (!crc32_ready)
+        crc32_init();
+
+    return ~crc32_raw(crc32_selected, ~crc, (const uint8_t *)data, len);
+}
+
+uint32_t crc32_calculate(const void *data, size_t len) {
+    return crc32_update(0, data, len);
+}
+
+/* ---------- combining ---------- */
+
+/* x^(2^k) mod P(x), reflected, for k = 0..31 */
+static const uint32_t crc32_x2n[32] = {
+    0x40000000, 0x20000000, 0x08000000, 0x00800000,
+    0x00008000, 0xedb88320, 0xb1e6b092, 0xa06a2517,
+    0xed627dae, 0x88d14467, 0xd7bbfe6a, 0xec447f11,
+    0x8e7ea170, 0x6427800e, 0x4d47bae0, 0x09fe548f,
+    0x83852d0f, 0x30362f1a, 0x7b5a9cc3, 0x31fec169,
+    0x9fec022a, 0x6c8dedc4, 0x15d6874d, 0x5fde7a4e,
+    0xbad90e37, 0x2e4e5eef, 0x4eaba214, 0xa8a472c0,
+    0x429a969e, 0x148d302a, 0xc40ba6d0, 0xc4e22c3c,
+};
+
+/* a * b mod P(x), reflected; a must not be 0 */
+static uint32_t crc32_multmodp(uint32_t a, uint32_t b) {
+    uint32_t m = 1u << 31;
+    uint32_t p = 0;
+
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0)
+                break;
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ 0xEDB88320u : b >> 1;
+    }
+    return p;
+}
+
+uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2) {
+    /* crc1 shifted over len2 zero bytes: times x^(8 * len2) */
+    uint32_t x = 1u << 31;
+    unsigned k = 3;
+
+    for (size_t n = len2; n; n >>= 1, k++) {
+        if (n & 1)
+            x = crc32_multmodp(crc32_x2n[k & 31], x);
+    }
+    return crc32_multmodp(x, crc1) ^ crc2;
+}
+
+/* ---------- self-test ---------- */
+
+#define CRC32_TEST_MAX 4096
+
+static uint8_t crc32_test_buf[CRC32_TEST_MAX + 8];
+
+static const size_t crc32_test_lengths[] = {
+    0, 1, 3, 7, 8, 9, 15, 16, 31, 63, 64, 65, 92, 127, 255,
+    256, 257, 511, 512, 1000, 1023, 2048, 4095, 4096
+};
+
+int crc32_self_test(void) {
+    static const char check[] = "123456789";
+    uint32_t seed = 0x4F434D21; /* "OCM!" */
+
+    if (!crc32_ready)
+        crc32_init();
+
+    if (crc32_calculate(check, 9) != 0xCBF43926)
+        return -1;
+
+    for (size_t i = 0; i < sizeof(crc32_test_buf); i++) {
+        seed = seed * 1103515245 + 12345;
+        crc32_test_buf[i] = (uint8_t)(seed >> 16);
+    }
+
+    for (int b = CRC32_BACKEND_TABLE; b <= (int)crc32_selected; b++) {
+        for (size_t off = 0; off < 8; off++) {
+            for (size_t i = 0;
+                 i < sizeof(crc32_test_lengths) / sizeof(crc32_test_lengths[0]);
+                 i++) {
+                const uint8_t *p = crc32_test_buf + off;
+                size_t len = crc32_test_lengths[i];
+
+                uint32_t want = ~crc32_bytewise(~0u, p, len);
+                uint32_t got = ~crc32_raw((crc32_backend_t)b, ~0u, p, len);
+
+                if (got != want)
+                    return -1;
+            }
+        }
+    }
+
+    /* chained updates must match a single pass */
+    uint32_t split = crc32_update(crc32_update(0, crc32_test_buf, 1000),
+                                  crc32_test_buf + 1000, CRC32_TEST_MAX - 1000);
+    if (split != crc32_calculate(crc32_test_buf, CRC32_TEST_MAX))
+        return -1;
+
+    /* and so must CRCs of the pieces, combined */
+    if (crc32_combine(crc32_calculate(crc32_test_buf, 1000),
+                      crc32_calculate(crc32_test_buf + 1000, CRC32_TEST_MAX - 1000),
+                      CRC32_TEST_MAX - 1000) != split)
+        return -1;
+
+    return 0;
+}
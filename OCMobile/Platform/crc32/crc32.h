@@ -0,0 +1,50 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * CRC-32 (IEEE 802.3, reflected 0xEDB88320) as used by GPT headers,
+ * partition entry arrays and most on-disk formats we care about.
+ *
+ * The backend is picked once at runtime from ID_AA64ISAR0_EL1:
+ *   - PMULL folding for large buffers (needs the PMULL extension)
+ *   - ARMv8 crc32x/crc32b instructions (needs the CRC32 extension)
+ *   - slicing-by-8 tables everywhere else (host tools, old cores)
+ */
+
+typedef enum {
+    CRC32_BACKEND_TABLE = 0,
+    CRC32_BACKEND_ARMV8,
+    CRC32_BACKEND_PMULL
+} crc32_backend_t;
+
+/* Probe CPU features and build tables (called lazily if omitted) */
+void crc32_init(void);
+
+/* Backend selected by crc32_init() */
+crc32_backend_t crc32_backend(void);
+
+/*
+ * Continue a CRC over more data. `crc` is the finalized value of the
+ * previous call (0 to start), so crc32_update(crc32_update(0, a), b)
+ * equals the CRC of a followed by b.
+ */
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+/* CRC of a single buffer */
+uint32_t crc32_calculate(const void *data, size_t len);
+
+/*
+ * CRC of A followed by B from crc1 = CRC(A), crc2 = CRC(B) and B's
+ * length, in O(log len2): lets pieces of one buffer be summed apart
+ * (on different cores) and joined afterwards.
+ */
+uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
+/* Cross-check every available backend against the byte-wise table.
+ * Returns 0 on success, -1 on mismatch. */
+int crc32_self_test(void);
+
+#endif
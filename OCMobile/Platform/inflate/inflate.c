@@ -0,0 +1,474 @@
+#include "inflate.h"
+#include "../../bootstd.h"
+#include "../../Memory.h"
+
+#define MAX_BITS                15
+#define MAX_LITLEN              288
+#define MAX_DIST                30
+
+#define WINDOW_SIZE             32768u
+#define WINDOW_MASK             (WINDOW_SIZE - 1)
+
+/* codes up to this long decode with one table lookup */
+#define FAST_BITS               10
+#define FAST_MASK               ((1u << FAST_BITS) - 1)
+
+/* largest block of input inflate ever needs in the bit buffer at once */
+#define REFILL_BITS             56
+
+/* ---------- tables ---------- */
+
+/*
+ * Canonical Huffman code. `fast` maps the next FAST_BITS input bits
+ * (LSB first, as DEFLATE packs them) to (symbol << 4 | length); 0 means
+ * the code is longer and is decoded from count/symbol instead.
+ */
+typedef struct {
+    uint16_t fast[1u << FAST_BITS];
+    uint16_t count[MAX_BITS + 1];
+    uint16_t symbol[MAX_LITLEN];
+} huffman_t;
+
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577
+};
+
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/* order of the code length code lengths in a dynamic block header */
+static const uint8_t clen_order[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+typedef struct {
+    /* input */
+    inflate_input_fn input;
+    void *ctx;
+    const uint8_t *in;
+    const uint8_t *in_end;
+    uint64_t bits;
+    unsigned nbits;
+
+    /* output; `total` and `flushed` count every byte ever produced */
+    inflate_output_fn output;
+    uint64_t total;
+    uint64_t flushed;
+    uint32_t adler;
+
+    huffman_t lit;
+    huffman_t dist;
+    uint8_t window[WINDOW_SIZE];
+} inflate_t;
+
+static int build_huffman(huffman_t *h, const uint8_t *lengths, unsigned n) {
+    uint16_t offs[MAX_BITS + 2];
+    uint32_t next_code[MAX_BITS + 1];
+    int left = 1;
+
+    memset(h->count, 0, sizeof(h->count));
+    for (unsigned i = 0; i < n; i++)
+        h->count[lengths[i]]++;
+    h->count[0] = 0;
+
+    /* over-subscribed sets are corrupt; incomplete ones are legal */
+    for (unsigned len = 1; len <= MAX_BITS; len++) {
+        left = (left << 1) - h->count[len];
+        if (left < 0)
+            return -1;
+    }
+
+    offs[1] = 0;
+    next_code[1] = 0;
+    for (unsigned len = 1; len <= MAX_BITS; len++) {
+        offs[len + 1] = (uint16_t)(offs[len] + h->count[len]);
+        if (len > 1)
+            next_code[len] = (next_code[len - 1] + h->count[len - 1]) << 1;
+    }
+
+    memset(h->fast, 0, sizeof(h->fast));
+    for (unsigned sym = 0; sym < n; sym++) {
+        unsigned len = lengths[sym];
+        if (!len)
+            continue;
+
+        h->symbol[offs[len]++] = (uint16_t)sym;
+
+        uint32_t code = next_code[len]++;
+        if (len > FAST_BITS)
+            continue;
+
+        uint32_t rev = 0;
+        for (unsigned i = 0; i < len; i++)
+            rev |= ((code >> i) & 1) << (len - 1 - i);
+        for (uint32_t k = rev; k <= FAST_MASK; k += 1u << len)
+            h->fast[k] = (uint16_t)(sym << 4 | len);
+    }
+    return 0;
+}
+
+/* ---------- bits ---------- */
+
+static void refill(inflate_t *s) {
+    while (s->nbits <= REFILL_BITS) {
+        if (s->in == s->in_end) {
+            size_t n = s->input(s->ctx, &s->in);
+            if (!n) {
+                s->in = s->in_end = NULL;
+                return;
+            }
+            s->in_end = s->in + n;
+        }
+        s->bits |= (uint64_t)*s->in++ << s->nbits;
+        s->nbits += 8;
+    }
+}
+
+/* n <= 32 bits, or -1 once the input has run dry */
+static int64_t get_bits(inflate_t *s, unsigned n) {
+    if (s->nbits < n) {
+        refill(s);
+        if (s->nbits < n)
+            return -1;
+    }
+
+    uint32_t v = (uint32_t)(s->bits & ((1ull << n) - 1));
+    s->bits >>= n;
+    s->nbits -= n;
+    return v;
+}
+
+static int decode(inflate_t *s, const huffman_t *h) {
+    if (s->nbits < MAX_BITS)
+        refill(s);
+
+    unsigned e = h->fast[s->bits & FAST_MASK];
+    if (e && (e & 15) <= s->nbits) {
+        s->bits >>= e & 15;
+        s->nbits -= e & 15;
+        return (int)(e >> 4);
+    }
+
+    /* long code: walk the canonical code one bit at a time */
+    int code = 0, first = 0, index = 0;
+    for (unsigned len = 1; len <= MAX_BITS; len++) {
+        if (!s->nbits)
+            return -1;
+        code |= (int)(s->bits & 1);
+        s->bits >>= 1;
+        s->nbits--;
+
+        int count = h->count[len];
+        if (code - count < first)
+            return h->symbol[index + (code - first)];
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+/* ---------- window ---------- */
+
+static int flush(inflate_t *s) {
+    size_t n = (size_t)(s->total - s->flushed);
+    const uint8_t *p = s->window + (s->flushed & WINDOW_MASK);
+
+    if (!n)
+        return 0;
+
+    s->adler = adler32_update(s->adler, p, n);
+    s->flushed = s->total;
+    return s->output(s->ctx, p, n);
+}
+
+/* The window is handed out whenever it fills, so it never wraps unflushed */
+static inline int put(inflate_t *s, uint8_t byte) {
+    s->window[s->total++ & WINDOW_MASK] = byte;
+    return (s->total & WINDOW_MASK) ? 0 : flush(s);
+}
+
+static int copy_match(inflate_t *s, uint32_t dist, uint32_t len) {
+    if (dist > s->total || dist > WINDOW_SIZE)
+        return -1;
+
+    while (len) {
+        uint32_t dst = (uint32_t)s->total & WINDOW_MASK;
+        uint32_t src = (uint32_t)(s->total - dist) & WINDOW_MASK;
+        uint32_t n = len;
+
+        if (n > WINDOW_SIZE - dst)
+            n = WINDOW_SIZE - dst;
+        if (n > WINDOW_SIZE - src)
+            n = WINDOW_SIZE - src;
+
+        if (dst + n <= src || src + n <= dst) {
+            memcpy(s->window + dst, s->window + src, n);
+        } else {
+            /*
+             * Overlap: a run (dist < n, each byte repeats one `dist`
+             * back), or a source just ahead of us from the previous lap
+             * of the ring. Forward byte order is right for both.
+             */
+            for (uint32_t i = 0; i < n; i++)
+                s->window[dst + i] = s->window[src + i];
+        }
+
+        s->total += n;
+        len -= n;
+        if (!(s->total & WINDOW_MASK) && flush(s) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* ---------- blocks ---------- */
+
+static int stored_block(inflate_t *s) {
+    /* skip to a byte boundary; LEN and NLEN follow */
+    s->bits >>= s->nbits & 7;
+    s->nbits -= s->nbits & 7;
+
+    int64_t len = get_bits(s, 16), nlen = get_bits(s, 16);
+    if (len < 0 || nlen < 0 || (len ^ 0xFFFF) != nlen)
+        return -1;
+
+    while (len--) {
+        int64_t byte = get_bits(s, 8);
+        if (byte < 0 || put(s, (uint8_t)byte) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int codes(inflate_t *s) {
+    for (;;) {
+        int sym = decode(s, &s->lit);
+
+        if (sym < 0)
+            return -1;
+        if (sym < 256) {
+            if (put(s, (uint8_t)sym) != 0)
+                return -1;
+            continue;
+        }
+        if (sym == 256)
+            return 0;
+
+        sym -= 257;
+        if (sym >= 29)
+            return -1;
+        int64_t extra = get_bits(s, length_extra[sym]);
+        if (extra < 0)
+            return -1;
+        uint32_t len = length_base[sym] + (uint32_t)extra;
+
+        sym = decode(s, &s->dist);
+        if (sym < 0 || sym >= MAX_DIST)
+            return -1;
+        extra = get_bits(s, dist_extra[sym]);
+        if (extra < 0)
+            return -1;
+
+        if (copy_match(s, dist_base[sym] + (uint32_t)extra, len) != 0)
+            return -1;
+    }
+}
+
+static int fixed_block(inflate_t *s) {
+    uint8_t lengths[MAX_LITLEN];
+    unsigned i = 0;
+
+    while (i < 144)
+        lengths[i++] = 8;
+    while (i < 256)
+        lengths[i++] = 9;
+    while (i < 280)
+        lengths[i++] = 7;
+    while (i < MAX_LITLEN)
+        lengths[i++] = 8;
+    build_huffman(&s->lit, lengths, MAX_LITLEN);
+
+    for (i = 0; i < MAX_DIST; i++)
+        lengths[i] = 5;
+    build_huffman(&s->dist, lengths, MAX_DIST);
+
+    return codes(s);
+}
+
+static int dynamic_block(inflate_t *s) {
+    uint8_t lengths[MAX_LITLEN + MAX_DIST];
+    int64_t hlit = get_bits(s, 5), hdist = get_bits(s, 5), hclen = get_bits(s, 4);
+
+    if (hlit < 0 || hdist < 0 || hclen < 0)
+        return -1;
+    hlit += 257;
+    hdist += 1;
+    hclen += 4;
+    if (hlit > 286 || hdist > MAX_DIST)
+        return -1;
+
+    memset(lengths, 0, 19);
+    for (int64_t i = 0; i < hclen; i++) {
+        int64_t len = get_bits(s, 3);
+        if (len < 0)
+            return -1;
+        lengths[clen_order[i]] = (uint8_t)len;
+    }
+    /* the code length code lives in `lit` until the real one is built */
+    if (build_huffman(&s->lit, lengths, 19) != 0)
+        return -1;
+
+    for (int64_t i = 0; i < hlit + hdist; ) {
+        int sym = decode(s, &s->lit);
+        int64_t rep;
+        uint8_t value = 0;
+
+        if (sym < 0)
+            return -1;
+        if (sym < 16) {
+            lengths[i++] = (uint8_t)sym;
+            continue;
+        }
+
+        if (sym == 16) {
+            if (i == 0)
+                return -1;
+            value = lengths[i - 1];
+            rep = get_bits(s, 2) + 3;
+        } else if (sym == 17) {
+            rep = get_bits(s, 3) + 3;
+        } else {
+            rep = get_bits(s, 7) + 11;
+        }
+        if (rep < 3 || i + rep > hlit + hdist)
+            return -1;
+        while (rep--)
+            lengths[i++] = value;
+    }
+
+    if (!lengths[256])          /* no end-of-block code */
+        return -1;
+    if (build_huffman(&s->lit, lengths, (unsigned)hlit) != 0 ||
+        build_huffman(&s->dist, lengths + hlit, (unsigned)hdist) != 0)
+        return -1;
+
+    return codes(s);
+}
+
+/* ---------- streams ---------- */
+
+int inflate_stream(
+    inflate_format_t format,
+    inflate_input_fn input,
+    inflate_output_fn output,
+    void *ctx
+) {
+    inflate_t *s = arena_alloc(sizeof(*s));
+    int64_t last;
+
+    if (!s)
+        return -1;
+
+    s->input = input;
+    s->output = output;
+    s->ctx = ctx;
+    s->in = s->in_end = NULL;
+    s->bits = 0;
+    s->nbits = 0;
+    s->total = s->flushed = 0;
+    s->adler = 1;
+
+    if (format == INFLATE_ZLIB) {
+        int64_t cmf = get_bits(s, 8), flg = get_bits(s, 8);
+
+        /* deflate, window <= 32 KiB, no preset dictionary */
+        if (cmf < 0 || flg < 0 || (cmf & 0x0F) != 8 || (cmf >> 4) > 7 ||
+            (cmf << 8 | flg) % 31 != 0 || (flg & 0x20))
+            return -1;
+    }
+
+    do {
+        int64_t type;
+        int err;
+
+        last = get_bits(s, 1);
+        type = get_bits(s, 2);
+        if (last < 0 || type < 0)
+            return -1;
+
+        switch (type) {
+        case 0:
+            err = stored_block(s);
+            break;
+        case 1:
+            err = fixed_block(s);
+            break;
+        case 2:
+            err = dynamic_block(s);
+            break;
+        default:
+            err = -1;
+            break;
+        }
+        if (err != 0)
+            return -1;
+    } while (!last);
+
+    if (flush(s) != 0)
+        return -1;
+
+    if (format == INFLATE_ZLIB) {
+        uint32_t expect = 0;
+
+        s->bits >>= s->nbits & 7;
+        s->nbits -= s->nbits & 7;
+        for (int i = 0; i < 4; i++) {
+            int64_t byte = get_bits(s, 8);
+            if (byte < 0)
+                return -1;
+            expect = expect << 8 | (uint32_t)byte;
+        }
+        if (expect != s->adler)
+            return -1;
+    }
+
+    return 0;
+}
+
+uint32_t adler32_update(
+    uint32_t adler,
+    const void *data,
+    size_t len
+) {
+    const uint8_t *p = data;
+    uint32_t a = adler & 0xFFFF, b = adler >> 16;
+
+    while (len) {
+        /* 5552 is the most bytes before b can overflow 32 bits */
+        size_t n = len < 5552 ? len : 5552;
+
+        len -= n;
+        while (n--) {
+            a += *p++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return b << 16 | a;
+}
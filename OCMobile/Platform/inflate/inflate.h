@@ -0,0 +1,48 @@
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * DEFLATE (RFC 1951) and zlib (RFC 1950) decompression, streaming both
+ * ways: compressed input is pulled span by span from a callback, and
+ * output is pushed to another through the 32 KiB history window, so
+ * neither side ever has to hold the whole stream. PNG IDAT data is the
+ * main customer.
+ *
+ * The decoder state (window and tables, ~40 KiB) comes from the stage
+ * arena (Memory.h).
+ */
+
+/* Next span of input: set *data and return its length, 0 at the end */
+typedef size_t (*inflate_input_fn)(void *ctx, const uint8_t **data);
+
+/* Decoded bytes, in order; returning non-zero stops the decoder */
+typedef int (*inflate_output_fn)(void *ctx, const uint8_t *data, size_t len);
+
+typedef enum {
+    INFLATE_RAW,                /* bare DEFLATE blocks */
+    INFLATE_ZLIB                /* 2-byte header, Adler-32 trailer checked */
+} inflate_format_t;
+
+/*
+ * Decode one stream. Returns 0 when the final block (and trailer) has
+ * been consumed, -1 on corrupt or truncated input, allocation failure,
+ * or when `output` asked to stop.
+ */
+int inflate_stream(
+    inflate_format_t format,
+    inflate_input_fn input,
+    inflate_output_fn output,
+    void *ctx
+);
+
+/* Adler-32 of `data`, continuing from `adler` (1 to start) */
+uint32_t adler32_update(
+    uint32_t adler,
+    const void *data,
+    size_t len
+);
+
+#endif
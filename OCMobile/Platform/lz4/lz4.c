@@ -0,0 +1,191 @@
+#include "lz4.h"
+#include "../../bootstd.h"
+
+#define MIN_MATCH               4
+
+/* 4-bit length, extended by 255-valued bytes while they keep coming */
+static int read_length(const uint8_t **p, const uint8_t *end, size_t *len) {
+    if (*len != 15)
+        return 0;
+
+    for (;;) {
+        if (*p == end)
+            return -1;
+
+        uint8_t b = *(*p)++;
+        *len += b;
+        if (b != 255)
+            return 0;
+    }
+}
+
+int lz4_decompress(
+    const void *src,
+    size_t src_size,
+    void *dst,
+    size_t dst_capacity,
+    size_t *out_size
+) {
+    const uint8_t *ip = src;
+    const uint8_t *in_end = ip + src_size;
+    uint8_t *out = dst;
+    uint8_t *op = out;
+    uint8_t *out_end = out + dst_capacity;
+
+    while (ip < in_end) {
+        uint8_t token = *ip++;
+        size_t lit = token >> 4;
+
+        if (read_length(&ip, in_end, &lit) != 0 ||
+            lit > (size_t)(in_end - ip) || lit > (size_t)(out_end - op))
+            return -1;
+        memcpy(op, ip, lit);
+        ip += lit;
+        op += lit;
+
+        /* the last sequence is literals only */
+        if (ip == in_end)
+            break;
+
+        if (in_end - ip < 2)
+            return -1;
+        size_t offset = (size_t)ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        if (!offset || offset > (size_t)(op - out))
+            return -1;
+
+        size_t len = token & 15;
+        if (read_length(&ip, in_end, &len) != 0)
+            return -1;
+        len += MIN_MATCH;
+        if (len > (size_t)(out_end - op))
+            return -1;
+
+        const uint8_t *match = op - offset;
+        if (offset >= len) {
+            memcpy(op, match, len);
+            op += len;
+        } else {
+            /* overlapping: a run of the last `offset` bytes */
+            while (len--)
+                *op++ = *match++;
+        }
+    }
+
+    *out_size = (size_t)(op - out);
+    return 0;
+}
+
+/* ---------- streaming ---------- */
+
+enum {
+    STAGE_TOKEN,                /* at a token, or the block's end */
+    STAGE_LITERALS,             /* copying s->literals bytes */
+    STAGE_MATCH                 /* at a match's offset */
+};
+
+/*
+ * The length a 4-bit field extends to, if all its bytes are in
+ * [p, end): the count of bytes, or 0 if they run past it.
+ */
+static size_t length_size(const uint8_t *p, const uint8_t *end, size_t field, size_t *len) {
+    const uint8_t *q = p;
+
+    *len = field;
+    if (field != 15)
+        return 0;
+    for (;;) {
+        if (q == end)
+            return (size_t)-1;
+        uint8_t b = *q++;
+        *len += b;
+        if (b != 255)
+            return (size_t)(q - p);
+    }
+}
+
+void lz4_stream_init(lz4_stream_t *s, void *dst, size_t capacity) {
+    s->dst = dst;
+    s->capacity = capacity;
+    s->pos = 0;
+    s->literals = 0;
+    s->token = 0;
+    s->stage = STAGE_TOKEN;
+}
+
+int lz4_stream_decode(
+    lz4_stream_t *s,
+    const void *src,
+    size_t src_size,
+    size_t *consumed
+) {
+    const uint8_t *start = src;
+    const uint8_t *ip = start;
+    const uint8_t *end = ip + src_size;
+    int result = 0;
+
+    while (ip < end) {
+        if (s->stage == STAGE_TOKEN) {
+            size_t lit, n = length_size(ip + 1, end, (size_t)(ip[0] >> 4), &lit);
+            if (n == (size_t)-1)
+                break;
+            if (lit > s->capacity - s->pos) {
+                result = -2;
+                break;
+            }
+            s->token = ip[0];
+            s->literals = lit;
+            s->stage = lit ? STAGE_LITERALS : STAGE_MATCH;
+            ip += 1 + n;
+        } else if (s->stage == STAGE_LITERALS) {
+            size_t n = s->literals;
+            if (n > (size_t)(end - ip))
+                n = (size_t)(end - ip);
+            memcpy(s->dst + s->pos, ip, n);
+            s->pos += n;
+            s->literals -= n;
+            ip += n;
+            if (!s->literals)
+                s->stage = STAGE_MATCH;
+        } else {
+            size_t len, n;
+            if (end - ip < 2 ||
+                (n = length_size(ip + 2, end, s->token & 15, &len)) == (size_t)-1)
+                break;
+
+            size_t offset = (size_t)ip[0] | (size_t)ip[1] << 8;
+            len += MIN_MATCH;
+            if (!offset || offset > s->pos) {
+                result = -1;
+                break;
+            }
+            if (len > s->capacity - s->pos) {
+                result = -2;
+                break;
+            }
+            ip += 2 + n;
+
+            uint8_t *op = s->dst + s->pos;
+            const uint8_t *match = op - offset;
+            s->pos += len;
+            if (offset >= len) {
+                memcpy(op, match, len);
+            } else {
+                while (len--)
+                    *op++ = *match++;
+            }
+            s->stage = STAGE_TOKEN;
+        }
+    }
+
+    *consumed = (size_t)(ip - start);
+    return result;
+}
+
+int lz4_stream_end(lz4_stream_t *s) {
+    /* the last sequence is literals only: its match never starts */
+    if (s->stage != STAGE_MATCH)
+        return -1;
+    s->stage = STAGE_TOKEN;
+    return 0;
+}
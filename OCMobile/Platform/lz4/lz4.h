@@ -0,0 +1,57 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * LZ4 block format decoder (no frame header; containers around it carry
+ * their own sizes). Bounds-checked on both sides: a corrupt block fails
+ * instead of reading or writing outside the buffers.
+ */
+
+/* Decode `src` into `dst`; 0 and *out_size set on success, -1 otherwise */
+int lz4_decompress(
+    const void *src,
+    size_t src_size,
+    void *dst,
+    size_t dst_capacity,
+    size_t *out_size
+);
+
+/*
+ * A block decoded in pieces, for blocks that arrive in chunks. Literal
+ * runs are copied as far as the input goes; a token or match whose bytes
+ * are not all at hand is left for the next call.
+ */
+typedef struct {
+    uint8_t *dst;
+    size_t capacity;
+    size_t pos;                 /* decoded so far; dst[0, pos) is the history */
+    size_t literals;            /* of the current run, still to copy */
+    uint8_t token;
+    uint8_t stage;              /* internal */
+} lz4_stream_t;
+
+/* Start a stream; several blocks may follow one another through it */
+void lz4_stream_init(lz4_stream_t *s, void *dst, size_t capacity);
+
+/*
+ * Decode from `src` as far as the input goes; *consumed is set either
+ * way. 0 on success, -1 on corrupt input, -2 when `dst` has no room for
+ * what the input decodes to.
+ */
+int lz4_stream_decode(
+    lz4_stream_t *s,
+    const void *src,
+    size_t src_size,
+    size_t *consumed
+);
+
+/*
+ * The block ends here: 0 if it stopped cleanly after a literal run (and
+ * the stream is ready for the next block), -1 mid-sequence.
+ */
+int lz4_stream_end(lz4_stream_t *s);
+
+#endif
@@ -0,0 +1,626 @@
+#include "lzfse.h"
+#include "../../bootstd.h"
+#include "../../Memory.h"
+
+/* ---------- format ---------- */
+
+#define L_SYMBOLS               20
+#define M_SYMBOLS               20
+#define D_SYMBOLS               64
+#define LITERAL_SYMBOLS         256
+#define FREQ_SYMBOLS            (L_SYMBOLS + M_SYMBOLS + D_SYMBOLS + LITERAL_SYMBOLS)
+
+#define L_STATES                64
+#define M_STATES                64
+#define D_STATES                256
+#define LITERAL_STATES          1024
+
+#define MATCHES_PER_BLOCK       10000
+#define LITERALS_PER_BLOCK      (4 * MATCHES_PER_BLOCK)
+
+/* "bvx2": magic, n_raw_bytes, three packed 64-bit fields, then frequencies */
+#define V2_FIXED_SIZE           32
+#define V2_MAX_SIZE             (V2_FIXED_SIZE + (FREQ_SYMBOLS * 14 + 7) / 8)
+
+#define STORED_HEADER_SIZE      8       /* magic, n_raw_bytes */
+#define LZVN_HEADER_SIZE        12      /* magic, n_raw_bytes, n_payload_bytes */
+
+/* L, M and D values: a symbol picks a base, extra bits follow */
+static const uint8_t l_extra_bits[L_SYMBOLS] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 3, 5, 8
+};
+static const int32_t l_base_value[L_SYMBOLS] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 20, 28, 60
+};
+static const uint8_t m_extra_bits[M_SYMBOLS] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 5, 8, 11
+};
+static const int32_t m_base_value[M_SYMBOLS] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 24, 56, 312
+};
+static const uint8_t d_extra_bits[D_SYMBOLS] = {
+    0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+    4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7,
+    8, 8, 8, 8, 9, 9, 9, 9, 10, 10, 10, 10, 11, 11, 11, 11,
+    12, 12, 12, 12, 13, 13, 13, 13, 14, 14, 14, 14, 15, 15, 15, 15
+};
+static const int32_t d_base_value[D_SYMBOLS] = {
+    0, 1, 2, 3, 4, 6, 8, 10, 12, 16, 20, 24, 28, 36, 44, 52,
+    60, 76, 92, 108, 124, 156, 188, 220, 252, 316, 380, 444, 508, 636, 764, 892,
+    1020, 1276, 1532, 1788, 2044, 2556, 3068, 3580, 4092, 5116, 6140, 7164, 8188, 10236, 12284, 14332,
+    16380, 20476, 24572, 28668, 32764, 40956, 49148, 57340, 65532, 81916, 98300, 114684, 131068, 163836, 196604, 229372
+};
+
+/* ---------- helpers ---------- */
+
+static inline uint32_t le32(const uint8_t *p) {
+    return (uint32_t)p[3] << 24 | (uint32_t)p[2] << 16 | (uint32_t)p[1] << 8 | p[0];
+}
+
+static inline uint64_t le64(const uint8_t *p) {
+    return (uint64_t)le32(p + 4) << 32 | le32(p);
+}
+
+/* `n` <= 8 little-endian bytes */
+static inline uint64_t load_bytes(const uint8_t *p, unsigned n) {
+    uint64_t v = 0;
+    while (n--)
+        v = v << 8 | p[n];
+    return v;
+}
+
+static inline uint64_t field(uint64_t v, unsigned shift, unsigned bits) {
+    return (v >> shift) & ((1ull << bits) - 1);
+}
+
+/* Overlap-safe: a match may repeat the bytes it is producing */
+static void copy_match(uint8_t *op, size_t distance, size_t len) {
+    const uint8_t *match = op - distance;
+
+    if (distance >= len) {
+        memcpy(op, match, len);
+        return;
+    }
+    while (len--)
+        *op++ = *match++;
+}
+
+/* ---------- FSE ---------- */
+
+/*
+ * Bits are read backwards, from the end of a payload towards its start.
+ * `accum` holds `nbits` of them, the next one to pull at the top.
+ */
+typedef struct {
+    uint64_t accum;
+    int nbits;
+} bits_t;
+
+/* `n` in [-7, 0]: how far the payload's final byte is from full */
+static int bits_init(bits_t *s, int n, const uint8_t **p, const uint8_t *start) {
+    unsigned bytes = n ? 8 : 7;
+
+    if ((size_t)(*p - start) < bytes)
+        return -1;
+    *p -= bytes;
+    s->accum = load_bytes(*p, bytes);
+    s->nbits = n + (int)bytes * 8;
+
+    /* bits above the stream's start must be clear */
+    if (s->nbits < 56 || s->nbits >= 64 || (s->accum >> s->nbits) != 0)
+        return -1;
+    return 0;
+}
+
+/* Top up to at least 56 bits, whole bytes at a time */
+static inline int bits_flush(bits_t *s, const uint8_t **p, const uint8_t *start) {
+    int n = (63 - s->nbits) & ~7;
+
+    if (!n)
+        return 0;
+    if ((size_t)(*p - start) < (size_t)(n >> 3))
+        return -1;
+    *p -= n >> 3;
+    s->accum = s->accum << n | load_bytes(*p, (unsigned)n >> 3);
+    s->nbits += n;
+    return 0;
+}
+
+static inline uint64_t bits_pull(bits_t *s, unsigned n) {
+    s->nbits -= (int)n;
+    uint64_t v = s->accum >> s->nbits;
+    s->accum &= (1ull << s->nbits) - 1;
+    return v;
+}
+
+/* Literal states: `k` bits of input plus `delta` give the next state */
+typedef struct {
+    int8_t k;
+    uint8_t symbol;
+    int16_t delta;
+} fse_entry_t;
+
+/* L, M, D states: also carry the symbol's base value and extra bits */
+typedef struct {
+    uint8_t total_bits;
+    uint8_t value_bits;
+    int16_t delta;
+    int32_t base;
+} fse_value_entry_t;
+
+/*
+ * Spread the states over the symbols by frequency: symbol i owns f
+ * consecutive states, the first j0 of them reading k bits and the rest
+ * k - 1, where N <= f << k < 2N. States past the frequencies' sum stay
+ * zero (the encoder never reaches them; they only keep corrupt input in
+ * bounds).
+ */
+static int init_table(unsigned nstates, unsigned nsymbols, const uint16_t *freq,
+                      fse_entry_t *t, fse_value_entry_t *vt,
+                      const uint8_t *extra, const int32_t *base) {
+    int n_clz = __builtin_clz(nstates);
+    unsigned sum = 0, s = 0;
+
+    if (t)
+        memset(t, 0, nstates * sizeof(*t));
+    else
+        memset(vt, 0, nstates * sizeof(*vt));
+
+    for (unsigned i = 0; i < nsymbols; i++) {
+        int f = freq[i];
+        if (!f)
+            continue;
+        sum += (unsigned)f;
+        if (sum > nstates)
+            return -1;
+
+        int k = __builtin_clz((unsigned)f) - n_clz;
+        int j0 = (int)((2 * nstates) >> k) - f;
+
+        for (int j = 0; j < f; j++, s++) {
+            int bits = j < j0 ? k : k - 1;
+            int delta = j < j0 ? ((f + j) << k) - (int)nstates : (j - j0) << (k - 1);
+
+            if (t) {
+                t[s].k = (int8_t)bits;
+                t[s].symbol = (uint8_t)i;
+                t[s].delta = (int16_t)delta;
+            } else {
+                vt[s].total_bits = (uint8_t)(bits + extra[i]);
+                vt[s].value_bits = extra[i];
+                vt[s].delta = (int16_t)delta;
+                vt[s].base = base[i];
+            }
+        }
+    }
+    return 0;
+}
+
+static inline uint8_t fse_decode(uint16_t *state, const fse_entry_t *t, bits_t *in) {
+    fse_entry_t e = t[*state];
+    *state = (uint16_t)(e.delta + (int)bits_pull(in, (unsigned)e.k));
+    return e.symbol;
+}
+
+static inline int32_t fse_value_decode(uint16_t *state, const fse_value_entry_t *t, bits_t *in) {
+    fse_value_entry_t e = t[*state];
+    uint64_t v = bits_pull(in, e.total_bits);
+    *state = (uint16_t)(e.delta + (int)(v >> e.value_bits));
+    return e.base + (int32_t)(v & ((1ull << e.value_bits) - 1));
+}
+
+/* ---------- LZFSE blocks ---------- */
+
+typedef struct {
+    uint32_t n_literals;
+    uint32_t n_matches;
+    uint32_t literal_payload;
+    uint32_t lmd_payload;
+    int literal_bits;
+    int lmd_bits;
+    uint16_t literal_state[4];
+    uint16_t l_state, m_state, d_state;
+    uint16_t freq[FREQ_SYMBOLS];    /* L, M, D, literal */
+} v2_header_t;
+
+/* Scratch for one block, from the arena */
+typedef struct {
+    fse_entry_t literal_table[LITERAL_STATES];
+    fse_value_entry_t l_table[L_STATES];
+    fse_value_entry_t m_table[M_STATES];
+    fse_value_entry_t d_table[D_STATES];
+    uint8_t literals[LITERALS_PER_BLOCK + 4];
+} v2_scratch_t;
+
+/*
+ * Frequencies are packed LSB first in 2 to 14 bits each; the low five
+ * bits of what comes next say how many and, for short codes, the value.
+ */
+static uint16_t freq_value(uint32_t bits, int *nbits) {
+    static const int8_t nbits_table[32] = {
+        2, 3, 2, 5, 2, 3, 2, 8, 2, 3, 2, 5, 2, 3, 2, 14,
+        2, 3, 2, 5, 2, 3, 2, 8, 2, 3, 2, 5, 2, 3, 2, 14
+    };
+    static const int8_t value_table[32] = {
+        0, 2, 1, 4, 0, 3, 1, -1, 0, 2, 1, 5, 0, 3, 1, -1,
+        0, 2, 1, 6, 0, 3, 1, -1, 0, 2, 1, 7, 0, 3, 1, -1
+    };
+    uint32_t b = bits & 31;
+    int n = nbits_table[b];
+
+    *nbits = n;
+    if (n == 8)
+        return (uint16_t)(8 + ((bits >> 4) & 0xF));
+    if (n == 14)
+        return (uint16_t)(24 + ((bits >> 4) & 0x3FF));
+    return (uint16_t)value_table[b];
+}
+
+static int parse_v2(const uint8_t *src, size_t header_size, v2_header_t *h) {
+    uint64_t v0 = le64(src + 8), v1 = le64(src + 16), v2 = le64(src + 24);
+
+    h->n_literals = (uint32_t)field(v0, 0, 20);
+    h->literal_payload = (uint32_t)field(v0, 20, 20);
+    h->n_matches = (uint32_t)field(v0, 40, 20);
+    h->literal_bits = (int)field(v0, 60, 3) - 7;
+    for (unsigned i = 0; i < 4; i++)
+        h->literal_state[i] = (uint16_t)field(v1, 10 * i, 10);
+    h->lmd_payload = (uint32_t)field(v1, 40, 20);
+    h->lmd_bits = (int)field(v1, 60, 3) - 7;
+    h->l_state = (uint16_t)field(v2, 32, 10);
+    h->m_state = (uint16_t)field(v2, 42, 10);
+    h->d_state = (uint16_t)field(v2, 52, 10);
+
+    if (h->n_literals > LITERALS_PER_BLOCK || h->n_matches > MATCHES_PER_BLOCK ||
+        h->l_state >= L_STATES || h->m_state >= M_STATES || h->d_state >= D_STATES)
+        return -1;
+    for (unsigned i = 0; i < 4; i++) {
+        if (h->literal_state[i] >= LITERAL_STATES)
+            return -1;
+    }
+
+    const uint8_t *p = src + V2_FIXED_SIZE;
+    const uint8_t *end = src + header_size;
+    uint32_t accum = 0;
+    int accum_bits = 0;
+
+    memset(h->freq, 0, sizeof(h->freq));
+    if (p == end)
+        return 0;
+
+    for (unsigned i = 0; i < FREQ_SYMBOLS; i++) {
+        while (p < end && accum_bits + 8 <= 32) {
+            accum |= (uint32_t)*p++ << accum_bits;
+            accum_bits += 8;
+        }
+
+        int n;
+        h->freq[i] = freq_value(accum, &n);
+        if (n > accum_bits)
+            return -1;
+        accum >>= n;
+        accum_bits -= n;
+    }
+
+    /* the header must end with the last frequency, bar padding bits */
+    return accum_bits >= 8 || p != end ? -1 : 0;
+}
+
+static int decode_v2(const lzfse_block_t *block, const uint8_t *src,
+                     uint8_t *dst, size_t capacity, size_t *pos, v2_scratch_t *w) {
+    v2_header_t h;
+
+    if (parse_v2(src, block->header_size, &h) != 0)
+        return -1;
+
+    const uint16_t *l_freq = h.freq;
+    const uint16_t *m_freq = l_freq + L_SYMBOLS;
+    const uint16_t *d_freq = m_freq + M_SYMBOLS;
+    const uint16_t *lit_freq = d_freq + D_SYMBOLS;
+
+    if (init_table(LITERAL_STATES, LITERAL_SYMBOLS, lit_freq, w->literal_table, NULL, NULL, NULL) ||
+        init_table(L_STATES, L_SYMBOLS, l_freq, NULL, w->l_table, l_extra_bits, l_base_value) ||
+        init_table(M_STATES, M_SYMBOLS, m_freq, NULL, w->m_table, m_extra_bits, m_base_value) ||
+        init_table(D_STATES, D_SYMBOLS, d_freq, NULL, w->d_table, d_extra_bits, d_base_value))
+        return -1;
+
+    /* literals: four interleaved states, four symbols per refill */
+    const uint8_t *payload = src + block->header_size;
+    const uint8_t *p = payload + h.literal_payload;
+    uint16_t s0 = h.literal_state[0], s1 = h.literal_state[1];
+    uint16_t s2 = h.literal_state[2], s3 = h.literal_state[3];
+    bits_t in;
+
+    if (bits_init(&in, h.literal_bits, &p, src) != 0)
+        return -1;
+    for (uint32_t i = 0; i < h.n_literals; i += 4) {
+        if (bits_flush(&in, &p, src) != 0)
+            return -1;
+        w->literals[i + 0] = fse_decode(&s0, w->literal_table, &in);
+        w->literals[i + 1] = fse_decode(&s1, w->literal_table, &in);
+        w->literals[i + 2] = fse_decode(&s2, w->literal_table, &in);
+        w->literals[i + 3] = fse_decode(&s3, w->literal_table, &in);
+    }
+
+    /* then (L, M, D) triples: L literals, then M bytes from D back */
+    p = payload + h.literal_payload + h.lmd_payload;
+    if (bits_init(&in, h.lmd_bits, &p, src) != 0)
+        return -1;
+
+    const uint8_t *lit = w->literals;
+    const uint8_t *lit_end = w->literals + h.n_literals;
+    uint16_t l_state = h.l_state, m_state = h.m_state, d_state = h.d_state;
+    size_t o = *pos, start = *pos;
+    int32_t d = -1;             /* no previous distance yet */
+
+    for (uint32_t i = 0; i < h.n_matches; i++) {
+        if (bits_flush(&in, &p, src) != 0)
+            return -1;
+
+        size_t l = (size_t)fse_value_decode(&l_state, w->l_table, &in);
+        size_t m = (size_t)fse_value_decode(&m_state, w->m_table, &in);
+        int32_t new_d = fse_value_decode(&d_state, w->d_table, &in);
+        if (new_d)
+            d = new_d;
+
+        if (l > (size_t)(lit_end - lit) || (uint32_t)d > o + l || l + m > capacity - o)
+            return -1;
+
+        memcpy(dst + o, lit, l);
+        lit += l;
+        o += l;
+        copy_match(dst + o, (size_t)d, m);
+        o += m;
+    }
+
+    if (o - start != block->raw_size)
+        return -1;
+    *pos = o;
+    return 0;
+}
+
+int lzfse_block_info(const void *src, size_t avail, lzfse_block_t *out) {
+    const uint8_t *p = src;
+
+    if (avail < 4)
+        return 1;
+
+    out->magic = le32(p);
+    switch (out->magic) {
+    case LZFSE_BLOCK_END:
+        out->header_size = out->size = 4;
+        out->raw_size = 0;
+        return 0;
+
+    case LZFSE_BLOCK_STORED:
+        if (avail < STORED_HEADER_SIZE)
+            return 1;
+        out->header_size = STORED_HEADER_SIZE;
+        out->raw_size = le32(p + 4);
+        out->size = STORED_HEADER_SIZE + out->raw_size;
+        return 0;
+
+    case LZFSE_BLOCK_LZVN:
+        if (avail < LZVN_HEADER_SIZE)
+            return 1;
+        out->header_size = LZVN_HEADER_SIZE;
+        out->raw_size = le32(p + 4);
+        out->size = LZVN_HEADER_SIZE + (size_t)le32(p + 8);
+        return 0;
+
+    case LZFSE_BLOCK_V2: {
+        if (avail < V2_FIXED_SIZE)
+            return 1;
+        uint64_t v0 = le64(p + 8), v1 = le64(p + 16), v2 = le64(p + 24);
+        size_t header_size = (size_t)field(v2, 0, 32);
+        if (header_size < V2_FIXED_SIZE || header_size > V2_MAX_SIZE)
+            return -1;
+        out->header_size = header_size;
+        out->raw_size = le32(p + 4);
+        out->size = header_size + (size_t)field(v0, 20, 20) + (size_t)field(v1, 40, 20);
+        return 0;
+    }
+
+    default:
+        return -1;
+    }
+}
+
+int lzfse_decode_block(
+    const lzfse_block_t *block,
+    const void *src,
+    uint8_t *dst,
+    size_t capacity,
+    size_t *pos
+) {
+    const uint8_t *p = src;
+
+    if (*pos > capacity || block->raw_size > capacity - *pos)
+        return -1;
+
+    switch (block->magic) {
+    case LZFSE_BLOCK_END:
+        return 0;
+
+    case LZFSE_BLOCK_STORED:
+        memcpy(dst + *pos, p + STORED_HEADER_SIZE, block->raw_size);
+        *pos += block->raw_size;
+        return 0;
+
+    case LZFSE_BLOCK_LZVN: {
+        /* the block's end is where its raw size says, not a capacity */
+        lzvn_stream_t s = { dst, *pos + block->raw_size, *pos, 0 };
+        size_t used;
+
+        if (lzvn_decode(&s, p + LZVN_HEADER_SIZE, block->size - LZVN_HEADER_SIZE, &used) != 1 ||
+            s.pos != *pos + block->raw_size)
+            return -1;
+        *pos = s.pos;
+        return 0;
+    }
+
+    case LZFSE_BLOCK_V2: {
+        arena_mark_t mark = arena_mark();
+        v2_scratch_t *w = arena_alloc(sizeof(*w));
+        int result = w ? decode_v2(block, p, dst, capacity, pos, w) : -1;
+
+        arena_release(mark);
+        return result;
+    }
+
+    default:
+        return -1;
+    }
+}
+
+int lzfse_decompress(
+    const void *src,
+    size_t src_size,
+    void *dst,
+    size_t dst_capacity,
+    size_t *out_size
+) {
+    const uint8_t *p = src;
+    size_t left = src_size, pos = 0;
+
+    for (;;) {
+        lzfse_block_t block;
+
+        if (lzfse_block_info(p, left, &block) != 0 || block.size > left ||
+            lzfse_decode_block(&block, p, dst, dst_capacity, &pos) != 0)
+            return -1;
+        if (block.magic == LZFSE_BLOCK_END)
+            break;
+        p += block.size;
+        left -= block.size;
+    }
+
+    *out_size = pos;
+    return 0;
+}
+
+/* ---------- LZVN ---------- */
+
+/*
+ * Opcodes (L literals follow the opcode bytes, then M bytes are copied
+ * from D back; "previous" reuses the last D):
+ *
+ *   LLMMMDDD DDDDDDDD             small distance, D < 1536
+ *   LLMMM111 DDDDDDDD DDDDDDDD    large distance
+ *   LLMMM110                      previous distance (L > 0)
+ *   101LLMMM DDDDDDMM DDDDDDDD    medium distance, M up to 34
+ *   1110LLLL / 11100000 L-16      literals only
+ *   1111MMMM / 11110000 M-16      match at the previous distance
+ *   00000110                      end of stream; 00001110, 00010110 nop
+ *
+ * M is MMM + 3 in the first three. 0x1E-0x3E by eights, 0x70-0x7F and
+ * 0xD0-0xDF are undefined.
+ */
+int lzvn_decode(lzvn_stream_t *s, const void *src, size_t src_size, size_t *consumed) {
+    const uint8_t *start = src;
+    const uint8_t *p = start;
+    const uint8_t *end = p + src_size;
+    size_t o = s->pos;
+    size_t d_prev = s->distance;
+    int result = 0;
+
+    while (p < end) {
+        uint8_t op = p[0];
+        size_t n, l, m, d = d_prev;
+
+        if (op >= 0xE0) {
+            /* literals only, or a match at the previous distance */
+            int literal = op < 0xF0;
+            n = (op & 0x0F) ? 1 : 2;
+            if ((size_t)(end - p) < n)
+                break;
+            size_t len = n == 1 ? (size_t)(op & 0x0F) : (size_t)p[1] + 16;
+            l = literal ? len : 0;
+            m = literal ? 0 : len;
+        } else if (op >= 0xD0 || (op & 0xF0) == 0x70) {
+            result = -1;
+            break;
+        } else if (op >= 0xA0 && op < 0xC0) {
+            n = 3;
+            if ((size_t)(end - p) < n)
+                break;
+            l = (op >> 3) & 3;
+            m = ((size_t)(op & 7) << 2 | (p[1] & 3)) + 3;
+            d = (size_t)(p[1] >> 2) | (size_t)p[2] << 6;
+        } else {
+            l = op >> 6;
+            m = ((op >> 3) & 7) + 3;
+            switch (op & 7) {
+            case 6:
+                if (!l) {
+                    if (op == 0x06) {
+                        p++;
+                        result = 1;
+                        goto out;
+                    }
+                    if (op == 0x0E || op == 0x16) {
+                        p++;
+                        continue;
+                    }
+                    result = -1;
+                    goto out;
+                }
+                n = 1;
+                break;
+            case 7:
+                n = 3;
+                if ((size_t)(end - p) < n)
+                    goto out;
+                d = (size_t)p[1] | (size_t)p[2] << 8;
+                break;
+            default:
+                n = 2;
+                if ((size_t)(end - p) < n)
+                    goto out;
+                d = (size_t)(op & 7) << 8 | p[1];
+                break;
+            }
+        }
+
+        if ((size_t)(end - p) - n < l)
+            break;
+        if (l + m > s->capacity - o || (m && (!d || d > o + l))) {
+            result = -1;
+            break;
+        }
+
+        memcpy(s->dst + o, p + n, l);
+        o += l;
+        p += n + l;
+        if (m) {
+            copy_match(s->dst + o, d, m);
+            o += m;
+            d_prev = d;
+        }
+    }
+
+out:
+    s->pos = o;
+    s->distance = d_prev;
+    *consumed = (size_t)(p - start);
+    return result;
+}
+
+int lzvn_decompress(
+    const void *src,
+    size_t src_size,
+    void *dst,
+    size_t dst_capacity,
+    size_t *out_size
+) {
+    lzvn_stream_t s = { dst, dst_capacity, 0, 0 };
+    size_t used;
+
+    /* ending without the end-of-stream opcode is fine if nothing is left over */
+    int result = lzvn_decode(&s, src, src_size, &used);
+    if (result < 0 || (result == 0 && used != src_size))
+        return -1;
+
+    *out_size = s.pos;
+    return 0;
+}
@@ -0,0 +1,96 @@
+#ifndef LZFSE_H
+#define LZFSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * LZFSE and LZVN decompression, Apple's formats for kernelcaches, IM4P
+ * payloads, decmpfs (types 7/8 LZVN, 11/12 LZFSE) and DMG chunks.
+ *
+ * An LZFSE stream is a run of blocks, each opening with a magic: "bvx2"
+ * (LZFSE with a packed header), "bvxn" (LZVN), "bvx-" (stored) and
+ * "bvx$" (end of stream). "bvx1", the unpacked LZFSE header no encoder
+ * writes, is refused. Matches reach back across blocks into everything
+ * decoded before, so all of it decodes into one flat buffer that doubles
+ * as the history.
+ *
+ * lzfse_decompress() takes a stream that is wholly in memory. For those
+ * that are not, lzfse_block_info() sizes the block at the front and
+ * lzfse_decode_block() decodes it once it is all in hand; stored blocks
+ * can be copied out piecewise instead.
+ *
+ * The LZFSE block decoder's tables and literals (~50 KiB) come from the
+ * stage arena (Memory.h) and are released before it returns.
+ */
+
+#define LZFSE_BLOCK_END         0x24787662u     /* "bvx$" */
+#define LZFSE_BLOCK_STORED      0x2D787662u     /* "bvx-" */
+#define LZFSE_BLOCK_V2          0x32787662u     /* "bvx2" */
+#define LZFSE_BLOCK_LZVN        0x6E787662u     /* "bvxn" */
+
+typedef struct {
+    uint32_t magic;             /* LZFSE_BLOCK_* */
+    size_t header_size;         /* bytes before the payload */
+    size_t size;                /* header and payload */
+    size_t raw_size;            /* bytes the block decodes to */
+} lzfse_block_t;
+
+/*
+ * Size up the block starting at `src`, of which `avail` bytes are at
+ * hand. 0 and *out set; 1 if more bytes are needed to tell (the fixed
+ * header is under 32); -1 if it is no block or a corrupt one.
+ */
+int lzfse_block_info(const void *src, size_t avail, lzfse_block_t *out);
+
+/*
+ * Decode the whole of `block` (block->size bytes at `src`) to dst + *pos,
+ * within dst[0, capacity); dst[0, *pos) is the history. 0 and *pos
+ * advanced by block->raw_size, -1 on corrupt input or lack of room.
+ */
+int lzfse_decode_block(
+    const lzfse_block_t *block,
+    const void *src,
+    uint8_t *dst,
+    size_t capacity,
+    size_t *pos
+);
+
+/* A whole stream in memory; 0 and *out_size set, -1 otherwise */
+int lzfse_decompress(
+    const void *src,
+    size_t src_size,
+    void *dst,
+    size_t dst_capacity,
+    size_t *out_size
+);
+
+/* An LZVN stream decoded in pieces, into a flat buffer */
+typedef struct {
+    uint8_t *dst;
+    size_t capacity;
+    size_t pos;                 /* decoded so far; dst[0, pos) is the history */
+    size_t distance;            /* of the last match, for "previous distance" opcodes */
+} lzvn_stream_t;
+
+/*
+ * Decode opcodes from `src` as far as the input goes: one whose bytes or
+ * literals are not all inside src[0, src_size) is left for the next call
+ * (LZVN_MAX_OPCODE bytes always make progress). *consumed is set either
+ * way. 1 once the end-of-stream opcode is decoded, 0 when it wants more
+ * input, -1 on corrupt input or lack of room.
+ */
+#define LZVN_MAX_OPCODE         274
+
+int lzvn_decode(lzvn_stream_t *s, const void *src, size_t src_size, size_t *consumed);
+
+/* A whole LZVN stream in memory; 0 and *out_size set, -1 otherwise */
+int lzvn_decompress(
+    const void *src,
+    size_t src_size,
+    void *dst,
+    size_t dst_capacity,
+    size_t *out_size
+);
+
+#endif
@@ -0,0 +1,74 @@
+#include "lzss.h"
+#include "../../bootstd.h"
+
+#define RING_SIZE               4096
+#define MAX_MATCH               18
+#define THRESHOLD               2      /* matches are longer than this */
+
+/* Where the first output byte sits in the encoder's ring */
+#define RING_START              (RING_SIZE - MAX_MATCH)
+
+int lzss_decode(
+    lzss_stream_t *s,
+    const void *src,
+    size_t src_size,
+    int last,
+    size_t *consumed
+) {
+    const uint8_t *start = src;
+    const uint8_t *p = start;
+    const uint8_t *end = p + src_size;
+    uint8_t *dst = s->dst;
+    size_t o = s->pos;
+    int result = 0;
+
+    while (p < end && (last || (size_t)(end - p) >= LZSS_MAX_GROUP)) {
+        uint8_t flags = *p++;
+
+        for (unsigned bit = 0; bit < 8 && p < end; bit++, flags >>= 1) {
+            if (flags & 1) {
+                if (o == s->capacity) {
+                    result = -1;
+                    goto out;
+                }
+                dst[o++] = *p++;
+                continue;
+            }
+
+            /* a truncated match ends the stream, as it does the encoder's */
+            if (end - p < 2) {
+                p = end;
+                break;
+            }
+            size_t i = (size_t)p[0] | (size_t)(p[1] & 0xF0) << 4;
+            size_t len = (size_t)(p[1] & 0x0F) + THRESHOLD + 1;
+            p += 2;
+
+            if (len > s->capacity - o) {
+                result = -1;
+                goto out;
+            }
+
+            /* ring index -> distance back from the current byte */
+            size_t r = (RING_START + o) & (RING_SIZE - 1);
+            size_t dist = (r - i) & (RING_SIZE - 1);
+            if (!dist)
+                dist = RING_SIZE;
+
+            for (size_t k = 0; k < len; k++, o++) {
+                if (dist <= o) {
+                    dst[o] = dst[o - dist];
+                } else {
+                    /* before the start: the ring's preset, spaces then zeros */
+                    size_t ring = (i + k) & (RING_SIZE - 1);
+                    dst[o] = ring < RING_START ? ' ' : 0;
+                }
+            }
+        }
+    }
+
+out:
+    s->pos = o;
+    *consumed = (size_t)(p - start);
+    return result;
+}
@@ -0,0 +1,39 @@
+#ifndef LZSS_H
+#define LZSS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * LZSS decoder for "comp"/"lzss" kernelcaches (Okumura's LZSS as Apple's
+ * kext tools write it: a 4096-byte ring preset to spaces, 3..18 byte
+ * matches). Each flag byte covers the next eight items, low bit first;
+ * a set bit is a literal byte, a clear one a two-byte match.
+ *
+ * The ring is never materialised: the output buffer is the history, and
+ * the ring's preset bytes are synthesised for matches reaching before
+ * the start.
+ */
+
+typedef struct {
+    uint8_t *dst;
+    size_t capacity;
+    size_t pos;                 /* decoded so far; dst[0, pos) is the history */
+} lzss_stream_t;
+
+/*
+ * Decode from `src` as far as the input goes, a whole flag group at a
+ * time (LZSS_MAX_GROUP bytes) unless `last` says no more input follows.
+ * *consumed is set either way. 0 on success, -1 on lack of room.
+ */
+#define LZSS_MAX_GROUP          17
+
+int lzss_decode(
+    lzss_stream_t *s,
+    const void *src,
+    size_t src_size,
+    int last,
+    size_t *consumed
+);
+
+#endif
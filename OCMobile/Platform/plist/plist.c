@@ -1,162 +1,1252 @@
 #include "plist.h"
-#include <string.h>
-#include <ctype.h>
+#include "../../bootstd.h"
+#include "../../Memory.h"
+#include "../crc32/crc32.h"
 
-/* ---------- helpers ---------- */
+#define PLIST_INITIAL_ENTRIES   64
+#define PLIST_MAX_DEPTH         64
+#define PLIST_MAX_NODES         (1u << 22)  /* bounds bplist DAG fan-out */
 
-static const char *skip_ws(const char *p) {
-    while (*p && isspace((unsigned char)*p))
-        p++;
-    return p;
+/* ---------- tokenizer ---------- */
+
+/*
+ * Every scan below stops at `end`; nothing relies on a terminating NUL
+ * and nothing is looked at twice.
+ */
+typedef struct {
+    char *p;
+    char *end;
+} lexer_t;
+
+typedef enum {
+    TAG_OPEN,                   /* <name ...> */
+    TAG_CLOSE,                  /* </name> */
+    TAG_EMPTY                   /* <name/> */
+} tag_kind_t;
+
+typedef struct {
+    const char *name;
+    size_t len;
+    tag_kind_t kind;
+} tag_t;
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
 }
 
-static int starts_with(const char *p, const char *s) {
-    return strncmp(p, s, strlen(s)) == 0;
+static void skip_ws(lexer_t *lx) {
+    while (lx->p < lx->end && is_space(*lx->p))
+        lx->p++;
 }
 
-static const char *find_tag_end(const char *p) {
-    while (*p && *p != '>')
-        p++;
-    return (*p == '>') ? p + 1 : NULL;
+static int has_prefix(const lexer_t *lx, const char *s, size_t len) {
+    return (size_t)(lx->end - lx->p) >= len && memcmp(lx->p, s, len) == 0;
 }
 
-static const char *extract_text(
-    const char *p,
-    const char *end_tag,
-    const char **out_text,
-    size_t *out_len
-) {
-    const char *start = p;
-    const char *end = strstr(p, end_tag);
-    if (!end)
+/* Advance past the first occurrence of `s`; 0 if it never comes */
+static int skip_past(lexer_t *lx, const char *s, size_t len) {
+    while ((size_t)(lx->end - lx->p) >= len) {
+        if (*lx->p == *s && memcmp(lx->p, s, len) == 0) {
+            lx->p += len;
+            return 1;
+        }
+        lx->p++;
+    }
+    lx->p = lx->end;
+    return 0;
+}
+
+/* Next element tag, skipping whitespace, <?...?>, <!-- --> and <!DOCTYPE> */
+static int next_tag(lexer_t *lx, tag_t *tag) {
+    for (;;) {
+        skip_ws(lx);
+
+        if (lx->p >= lx->end || *lx->p != '<')
+            return 0;
+
+        if (has_prefix(lx, "<?", 2)) {
+            if (!skip_past(lx, "?>", 2))
+                return 0;
+        } else if (has_prefix(lx, "<!--", 4)) {
+            if (!skip_past(lx, "-->", 3))
+                return 0;
+        } else if (has_prefix(lx, "<!", 2)) {
+            if (!skip_past(lx, ">", 1))
+                return 0;
+        } else {
+            break;
+        }
+    }
+
+    lx->p++;
+    tag->kind = TAG_OPEN;
+    if (lx->p < lx->end && *lx->p == '/') {
+        tag->kind = TAG_CLOSE;
+        lx->p++;
+    }
+
+    tag->name = lx->p;
+    while (lx->p < lx->end && *lx->p != '>' && *lx->p != '/' && !is_space(*lx->p))
+        lx->p++;
+    tag->len = (size_t)(lx->p - tag->name);
+
+    /* attributes (<plist version="1.0">) are not interesting */
+    while (lx->p < lx->end && *lx->p != '>')
+        lx->p++;
+    if (lx->p >= lx->end || tag->len == 0)
+        return 0;
+
+    if (lx->p[-1] == '/' && tag->kind == TAG_OPEN)
+        tag->kind = TAG_EMPTY;
+
+    lx->p++;
+    return 1;
+}
+
+static int tag_is(const tag_t *tag, const char *name, size_t len) {
+    return tag->len == len && memcmp(tag->name, name, len) == 0;
+}
+
+#define TAG_IS(tag, lit) tag_is((tag), (lit), sizeof(lit) - 1)
+
+/* Decode the five predefined XML entities in place; returns the new length */
+static size_t decode_entities(char *s, size_t len) {
+    static const struct {
+        const char *name;
+        size_t len;
+        char c;
+    } entities[] = {
+        { "&lt;", 4, '<' }, { "&gt;", 4, '>' }, { "&amp;", 5, '&' },
+        { "&quot;", 6, '"' }, { "&apos;", 6, '\'' },
+    };
+    size_t r = 0, w = 0;
+
+    while (r < len) {
+        char c = s[r];
+        size_t used = 1;
+
+        if (c == '&') {
+            for (size_t i = 0; i < sizeof(entities) / sizeof(entities[0]); i++) {
+                if (len - r >= entities[i].len &&
+                    memcmp(s + r, entities[i].name, entities[i].len) == 0) {
+                    c = entities[i].c;
+                    used = entities[i].len;
+                    break;
+                }
+            }
+        }
+
+        s[w++] = c;
+        r += used;
+    }
+
+    return w;
+}
+
+/*
+ * Character data up to the closing </name>, NUL-terminated in the buffer
+ * (over the '<' of the closing tag, which has been consumed by then).
+ */
+static char *element_text(lexer_t *lx, const char *name, size_t name_len) {
+    char *text = lx->p;
+
+    while (lx->p < lx->end && *lx->p != '<')
+        lx->p++;
+
+    char *text_end = lx->p;
+    tag_t close;
+
+    if (!next_tag(lx, &close) || close.kind != TAG_CLOSE ||
+        !tag_is(&close, name, name_len))
         return NULL;
 
-    *out_text = start;
-    *out_len = (size_t)(end - start);
-    return end + strlen(end_tag);
+    text[decode_entities(text, (size_t)(text_end - text))] = '\0';
+    return text;
 }
 
-/* ---------- core ---------- */
+/* ---------- values ---------- */
 
-int plist_parse_xml(
-    const char *buf,
-    size_t size,
-    plist_dict_t *dict
-) {
-    const char *p = buf;
-    const char *end = buf + size;
+static int parse_integer(const char *s, long *out) {
+    unsigned long v = 0;
+    int neg = 0;
+    unsigned base = 10;
 
-    if (size >= 8 && memcmp(buf, "bplist00", 8) == 0)
-        return -1; /* binary plist: hard no */
+    while (is_space(*s))
+        s++;
 
-    memset(dict, 0, sizeof(*dict));
+    if (*s == '-' || *s == '+')
+        neg = (*s++ == '-');
 
-    p = skip_ws(p);
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        base = 16;
+        s += 2;
+    }
 
-    /* skip XML header if present */
-    if (starts_with(p, "<?xml"))
-        p = strstr(p, "?>") + 2;
+    if (!*s)
+        return -1;
 
-    p = skip_ws(p);
+    for (; *s && !is_space(*s); s++) {
+        unsigned d;
 
-    if (!starts_with(p, "<plist"))
+        if (*s >= '0' && *s <= '9')
+            d = (unsigned)(*s - '0');
+        else if (base == 16 && *s >= 'a' && *s <= 'f')
+            d = (unsigned)(*s - 'a' + 10);
+        else if (base == 16 && *s >= 'A' && *s <= 'F')
+            d = (unsigned)(*s - 'A' + 10);
+        else
+            return -1;
+
+        v = v * base + d;
+    }
+
+    *out = neg ? -(long)v : (long)v;
+    return 0;
+}
+
+/*
+ * [-+]digits[.digits][e[-+]digits]. Exact (like strtod) while the digits
+ * fit 2^53 and the power of ten stays within 10^22, which covers
+ * anything a config writes; within a couple of ulps beyond that.
+ */
+static int parse_real(const char *s, double *out) {
+    uint64_t mant = 0;
+    int neg = 0, digits = 0, exp = 0;
+
+    while (is_space(*s))
+        s++;
+
+    if (*s == '-' || *s == '+')
+        neg = (*s++ == '-');
+
+    for (; *s >= '0' && *s <= '9'; s++, digits++) {
+        if (mant < 1000000000000000000ull)
+            mant = mant * 10 + (uint64_t)(*s - '0');
+        else
+            exp++;              /* digit beyond what we keep */
+    }
+
+    if (*s == '.') {
+        for (s++; *s >= '0' && *s <= '9'; s++, digits++) {
+            if (mant < 1000000000000000000ull) {
+                mant = mant * 10 + (uint64_t)(*s - '0');
+                exp--;
+            }
+        }
+    }
+
+    if (!digits)
         return -1;
 
-    p = strstr(p, ">") + 1;
-    p = skip_ws(p);
+    if (*s == 'e' || *s == 'E') {
+        int e = 0, eneg = 0;
+
+        s++;
+        if (*s == '-' || *s == '+')
+            eneg = (*s++ == '-');
+        if (*s < '0' || *s > '9')
+            return -1;
+        for (; *s >= '0' && *s <= '9'; s++)
+            if (e < 10000)
+                e = e * 10 + (*s - '0');
+        exp += eneg ? -e : e;
+    }
 
-    if (!starts_with(p, "<dict>"))
+    while (is_space(*s))
+        s++;
+    if (*s)
         return -1;
 
-    p += 6;
+    /* one scale by an exactly representable power of ten when possible */
+    double v = (double)mant, p = 1.0;
+    int n = exp < 0 ? -exp : exp;
+
+    for (int i = 0; i < n && i < 22; i++)
+        p *= 10.0;
+    v = exp < 0 ? v / p : v * p;
+    for (int i = 22; i < n && v != 0.0; i++)
+        v = exp < 0 ? v / 10.0 : v * 10.0;
 
-    while (p < end) {
-        const char *key_text;
-        size_t key_len;
+    *out = neg ? -v : v;
+    return 0;
+}
 
-        p = skip_ws(p);
+static int parse_digits(const char **s, int n, int *out) {
+    *out = 0;
+    while (n--) {
+        if (**s < '0' || **s > '9')
+            return -1;
+        *out = *out * 10 + (*(*s)++ - '0');
+    }
+    return 0;
+}
 
-        if (starts_with(p, "</dict>"))
-            break;
+/* YYYY-MM-DDTHH:MM:SSZ, as written by CoreFoundation */
+static int parse_date(const char *s, double *out) {
+    int y, mo, d, h, mi, sec;
+
+    while (is_space(*s))
+        s++;
+
+    if (parse_digits(&s, 4, &y) || *s++ != '-' ||
+        parse_digits(&s, 2, &mo) || *s++ != '-' ||
+        parse_digits(&s, 2, &d) || *s++ != 'T' ||
+        parse_digits(&s, 2, &h) || *s++ != ':' ||
+        parse_digits(&s, 2, &mi) || *s++ != ':' ||
+        parse_digits(&s, 2, &sec) || *s++ != 'Z')
+        return -1;
+
+    if (mo < 1 || mo > 12 || d < 1 || d > 31 || h > 23 || mi > 59 || sec > 60)
+        return -1;
+
+    /* days since 1970-01-01, proleptic Gregorian */
+    long yy = y - (mo <= 2);
+    long era = yy / 400;
+    long yoe = yy - era * 400;
+    long doy = (153 * (mo + (mo > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    long days = era * 146097 + doe - 719468;
 
-        if (!starts_with(p, "<key>"))
+    *out = (double)(days * 86400L + h * 3600L + mi * 60L + sec) - 978307200.0;
+    return 0;
+}
+
+static int base64_value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+/* Decode base64 in place (output never outgrows input); whitespace is skipped */
+static int base64_decode(char *s, size_t *len) {
+    uint8_t *out = (uint8_t *)s;
+    uint32_t acc = 0;
+    int bits = 0;
+    size_t w = 0;
+
+    for (; *s && *s != '='; s++) {
+        if (is_space(*s))
+            continue;
+
+        int v = base64_value(*s);
+        if (v < 0)
             return -1;
 
-        p += 5;
+        acc = (acc << 6) | (uint32_t)v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out[w++] = (uint8_t)(acc >> bits);
+        }
+    }
+
+    *len = w;
+    return 0;
+}
+
+/* ---------- nodes ---------- */
 
-        p = extract_text(p, "</key>", &key_text, &key_len);
-        if (!p)
+/* Append a zeroed node; indices stay valid across growth, pointers don't */
+static int new_node(plist_dict_t *dict, uint32_t *idx) {
+    if (dict->count >= PLIST_MAX_NODES)
+        return -1;
+
+    if (dict->count == dict->capacity) {
+        size_t cap = dict->capacity ? dict->capacity * 2 : PLIST_INITIAL_ENTRIES;
+        plist_entry_t *grown = arena_alloc(cap * sizeof(plist_entry_t));
+
+        if (!grown)
             return -1;
 
-        /* store key pointer directly */
-        plist_entry_t *e = &dict->entries[dict->count];
-        e->key = key_text;
+        /* the old array stays behind in the arena until the stage ends */
+        if (dict->count)
+            memcpy(grown, dict->entries, dict->count * sizeof(plist_entry_t));
+
+        dict->entries = grown;
+        dict->capacity = cap;
+    }
+
+    *idx = (uint32_t)dict->count++;
+    memset(&dict->entries[*idx], 0, sizeof(plist_entry_t));
+    return 0;
+}
+
+/* Link `child` as the last child of `parent`; `*last` tracks the tail */
+static void add_child(plist_dict_t *dict, uint32_t parent, uint32_t *last, uint32_t child) {
+    if (*last)
+        dict->entries[*last].next_sibling = child;
+    else
+        dict->entries[parent].first_child = child;
 
-        /* null-terminate in-place */
-        ((char *)key_text)[key_len] = '\0';
+    *last = child;
+    dict->entries[parent].count++;
+}
 
-        p = skip_ws(p);
+/* ---------- xml ---------- */
 
-        if (starts_with(p, "<string>")) {
-            const char *txt;
-            size_t len;
+static int parse_node(lexer_t *lx, plist_dict_t *dict, const tag_t *tag,
+                      uint32_t idx, unsigned depth);
 
-            p += 8;
-            p = extract_text(p, "</string>", &txt, &len);
-            if (!p)
-                return -1;
+static int parse_dict(lexer_t *lx, plist_dict_t *dict, uint32_t idx, unsigned depth) {
+    uint32_t last = 0;
+    tag_t tag;
 
-            ((char *)txt)[len] = '\0';
+    dict->entries[idx].type = PLIST_DICT;
 
+    for (;;) {
+        if (!next_tag(lx, &tag))
+            return -1;
+
+        if (tag.kind == TAG_CLOSE && TAG_IS(&tag, "dict"))
+            return 0;
+
+        if (tag.kind != TAG_OPEN || !TAG_IS(&tag, "key"))
+            return -1;
+
+        char *key = element_text(lx, "key", 3);
+        uint32_t child;
+
+        if (!key || new_node(dict, &child) || !next_tag(lx, &tag))
+            return -1;
+
+        dict->entries[child].key = key;
+        add_child(dict, idx, &last, child);
+
+        if (parse_node(lx, dict, &tag, child, depth + 1))
+            return -1;
+    }
+}
+
+static int parse_array(lexer_t *lx, plist_dict_t *dict, uint32_t idx, unsigned depth) {
+    uint32_t last = 0;
+    tag_t tag;
+
+    dict->entries[idx].type = PLIST_ARRAY;
+
+    for (;;) {
+        uint32_t child;
+
+        if (!next_tag(lx, &tag))
+            return -1;
+
+        if (tag.kind == TAG_CLOSE && TAG_IS(&tag, "array"))
+            return 0;
+
+        if (new_node(dict, &child))
+            return -1;
+
+        add_child(dict, idx, &last, child);
+
+        if (parse_node(lx, dict, &tag, child, depth + 1))
+            return -1;
+    }
+}
+
+/* The value starting at `tag` into node `idx` (re-fetched: the array moves) */
+static int parse_node(lexer_t *lx, plist_dict_t *dict, const tag_t *tag,
+                      uint32_t idx, unsigned depth) {
+    plist_entry_t *e = &dict->entries[idx];
+
+    if (depth > PLIST_MAX_DEPTH)
+        return -1;
+
+    if (tag->kind == TAG_EMPTY) {
+        if (TAG_IS(tag, "true") || TAG_IS(tag, "false")) {
+            e->type = PLIST_BOOL;
+            e->value.boolean = TAG_IS(tag, "true");
+        } else if (TAG_IS(tag, "string")) {
             e->type = PLIST_STRING;
-            e->value.string = txt;
+            e->value.string = "";
+        } else if (TAG_IS(tag, "dict")) {
+            e->type = PLIST_DICT;
+        } else if (TAG_IS(tag, "array")) {
+            e->type = PLIST_ARRAY;
+        } else if (TAG_IS(tag, "data")) {
+            e->type = PLIST_DATA;
+            e->value.data.bytes = (const uint8_t *)"";
+        } else {
+            return -1;
         }
-        else if (starts_with(p, "<integer>")) {
-            const char *txt;
-            size_t len;
+        return 0;
+    }
 
-            p += 9;
-            p = extract_text(p, "</integer>", &txt, &len);
-            if (!p)
-                return -1;
+    if (tag->kind != TAG_OPEN)
+        return -1;
 
-            char tmp[32];
-            if (len >= sizeof(tmp))
-                return -1;
+    if (TAG_IS(tag, "dict"))
+        return parse_dict(lx, dict, idx, depth);
+
+    if (TAG_IS(tag, "array"))
+        return parse_array(lx, dict, idx, depth);
+
+    /* everything else is a scalar with character data */
+    char *txt = element_text(lx, tag->name, tag->len);
+    if (!txt)
+        return -1;
+
+    if (TAG_IS(tag, "string")) {
+        e->type = PLIST_STRING;
+        e->value.string = txt;
+        return 0;
+    }
+
+    if (TAG_IS(tag, "integer")) {
+        e->type = PLIST_INTEGER;
+        return parse_integer(txt, &e->value.integer);
+    }
+
+    if (TAG_IS(tag, "real")) {
+        e->type = PLIST_REAL;
+        return parse_real(txt, &e->value.real);
+    }
+
+    if (TAG_IS(tag, "date")) {
+        e->type = PLIST_DATE;
+        return parse_date(txt, &e->value.date);
+    }
+
+    if (TAG_IS(tag, "data")) {
+        e->type = PLIST_DATA;
+        e->value.data.bytes = (const uint8_t *)txt;
+        return base64_decode(txt, &e->value.data.length);
+    }
+
+    return -1;
+}
+
+/* ---------- binary (bplist00) ---------- */
 
-            memcpy(tmp, txt, len);
-            tmp[len] = '\0';
+/*
+ * Parsing walks the object graph once, reading only markers, counts and
+ * object references, to lay out the node tree. Keys and scalar values
+ * stay in the buffer (value.lazy holds their offsets) until an accessor
+ * first returns the node; until then keys are compared in place (entry->key
+ * stays NULL, except for UTF-16 keys which are converted while indexing).
+ */
+struct plist_binary {
+    const uint8_t *buf;
+    uint64_t offset_table;          /* objects live in [8, offset_table) */
+    uint64_t num_objects;
+    uint8_t offset_size;
+    uint8_t ref_size;
+    uint8_t *decoded;               /* per node: key and value filled in yet? */
+};
 
-            e->type = PLIST_INTEGER;
-            e->value.integer = strtol(tmp, NULL, 10);
+#define BPLIST_HEADER_SIZE      8
+#define BPLIST_TRAILER_SIZE     32
+
+static uint64_t be_read(const uint8_t *p, size_t n) {
+    uint64_t v = 0;
+
+    while (n--)
+        v = (v << 8) | *p++;
+    return v;
+}
+
+/* Byte offset of object `ref`, validated */
+static int bp_object(const struct plist_binary *bp, uint64_t ref, uint64_t *off) {
+    if (ref >= bp->num_objects)
+        return -1;
+
+    *off = be_read(bp->buf + bp->offset_table + ref * bp->offset_size, bp->offset_size);
+    return (*off >= BPLIST_HEADER_SIZE && *off < bp->offset_table) ? 0 : -1;
+}
+
+/*
+ * Object header at `off`: marker, element count and where the payload
+ * starts. The payload (count * unit bytes) must end before the offset
+ * table.
+ */
+static int bp_header(const struct plist_binary *bp, uint64_t off, size_t unit,
+                     uint8_t *marker, uint64_t *count, uint64_t *data) {
+    *marker = bp->buf[off];
+    *count = *marker & 0x0F;
+    *data = off + 1;
+
+    if (*count == 0x0F && (*marker >> 4) >= 0x4) {
+        /* long form: an int object holds the count */
+        if (*data >= bp->offset_table)
+            return -1;
+
+        uint8_t m = bp->buf[*data];
+        size_t n = (size_t)1 << (m & 0x0F);
+
+        if ((m >> 4) != 0x1 || n > 8 || *data + 1 + n > bp->offset_table)
+            return -1;
+
+        *count = be_read(bp->buf + *data + 1, n);
+        *data += 1 + n;
+    }
+
+    if (*count > (bp->offset_table - *data) / (unit ? unit : 1))
+        return -1;
+
+    return 0;
+}
+
+/* Raw bytes of the key string at `off` (ASCII or UTF-16BE) */
+static int bp_key(const struct plist_binary *bp, uint64_t off,
+                  const uint8_t **bytes, size_t *len, int *utf16) {
+    uint64_t count, data;
+    uint8_t marker;
+
+    *utf16 = (bp->buf[off] >> 4) == 0x6;
+    if (((bp->buf[off] >> 4) != 0x5 && !*utf16) ||
+        bp_header(bp, off, *utf16 ? 2 : 1, &marker, &count, &data))
+        return -1;
+
+    *bytes = bp->buf + data;
+    *len = (size_t)count * (*utf16 ? 2 : 1);
+    return 0;
+}
+
+/* UTF-16BE to NUL-terminated UTF-8 in the arena */
+static char *bp_utf16_to_utf8(const uint8_t *p, size_t units) {
+    char *out = arena_alloc(units * 3 + 1);
+    size_t w = 0;
+
+    if (!out)
+        return NULL;
+
+    for (size_t i = 0; i < units; i++) {
+        uint32_t c = (uint32_t)be_read(p + i * 2, 2);
+
+        if (c >= 0xD800 && c < 0xDC00 && i + 1 < units) {
+            uint32_t lo = (uint32_t)be_read(p + (i + 1) * 2, 2);
+            if (lo >= 0xDC00 && lo < 0xE000) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (lo - 0xDC00);
+                i++;
+            }
         }
-        else if (starts_with(p, "<true/>")) {
-            e->type = PLIST_BOOL;
-            e->value.boolean = 1;
-            p += 7;
+
+        if (c < 0x80) {
+            out[w++] = (char)c;
+        } else if (c < 0x800) {
+            out[w++] = (char)(0xC0 | (c >> 6));
+            out[w++] = (char)(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            out[w++] = (char)(0xE0 | (c >> 12));
+            out[w++] = (char)(0x80 | ((c >> 6) & 0x3F));
+            out[w++] = (char)(0x80 | (c & 0x3F));
+        } else {
+            /* 4 bytes, but it took two units (6 bytes of budget) */
+            out[w++] = (char)(0xF0 | (c >> 18));
+            out[w++] = (char)(0x80 | ((c >> 12) & 0x3F));
+            out[w++] = (char)(0x80 | ((c >> 6) & 0x3F));
+            out[w++] = (char)(0x80 | (c & 0x3F));
         }
-        else if (starts_with(p, "<false/>")) {
-            e->type = PLIST_BOOL;
-            e->value.boolean = 0;
-            p += 8;
+    }
+
+    out[w] = '\0';
+    return out;
+}
+
+static char *bp_string(const uint8_t *p, size_t len, int utf16) {
+    if (utf16)
+        return bp_utf16_to_utf8(p, len / 2);
+
+    char *out = arena_alloc(len + 1);
+    if (out) {
+        memcpy(out, p, len);
+        out[len] = '\0';
+    }
+    return out;
+}
+
+/* Node type from an object marker; -1 for what plist_entry_t can't hold */
+static int bp_type(uint8_t marker) {
+    switch (marker >> 4) {
+    case 0x0:
+        return (marker == 0x08 || marker == 0x09) ? PLIST_BOOL : -1;
+    case 0x1:
+        return PLIST_INTEGER;
+    case 0x2:
+        return PLIST_REAL;
+    case 0x3:
+        return marker == 0x33 ? PLIST_DATE : -1;
+    case 0x4:
+        return PLIST_DATA;
+    case 0x5:
+    case 0x6:
+        return PLIST_STRING;
+    case 0xA:
+        return PLIST_ARRAY;
+    case 0xD:
+        return PLIST_DICT;
+    default:
+        return -1;              /* null, fill, UID, set */
+    }
+}
+
+/*
+ * Lay out the object at `off` as node `idx`, and containers' children
+ * after it. A shared subobject gets one node per reference; depth and
+ * PLIST_MAX_NODES bound what a hostile file can make that cost.
+ */
+static int bp_build(plist_dict_t *dict, const struct plist_binary *bp,
+                    uint64_t off, uint32_t idx, unsigned depth) {
+    int type = bp_type(bp->buf[off]);
+
+    if (type < 0 || depth > PLIST_MAX_DEPTH)
+        return -1;
+
+    dict->entries[idx].type = (plist_type_t)type;
+    dict->entries[idx].value.lazy.object = off;
+
+    if (type != PLIST_DICT && type != PLIST_ARRAY)
+        return 0;
+
+    int is_dict = (type == PLIST_DICT);
+    uint64_t count, data;
+    uint8_t marker;
+
+    if (bp_header(bp, off, (is_dict ? 2 : 1) * (size_t)bp->ref_size, &marker, &count, &data))
+        return -1;
+
+    const uint8_t *refs = bp->buf + data;
+    uint32_t last = 0;
+
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t value_ref = be_read(refs + (is_dict ? count + i : i) * bp->ref_size, bp->ref_size);
+        uint64_t value_off, key_off = 0;
+        uint32_t child;
+
+        if (bp_object(bp, value_ref, &value_off))
+            return -1;
+
+        if (is_dict) {
+            const uint8_t *kbytes;
+            size_t klen;
+            int utf16;
+
+            if (bp_object(bp, be_read(refs + i * bp->ref_size, bp->ref_size), &key_off) ||
+                bp_key(bp, key_off, &kbytes, &klen, &utf16))
+                return -1;
         }
-        else {
+
+        if (new_node(dict, &child))
+            return -1;
+
+        dict->entries[child].value.lazy.key = key_off;
+        add_child(dict, idx, &last, child);
+
+        if (bp_build(dict, bp, value_off, child, depth + 1))
+            return -1;
+    }
+
+    return 0;
+}
+
+/* Decode node i's key and (scalar) value from the buffer */
+static int bp_materialize(const plist_dict_t *dict, size_t i) {
+    const struct plist_binary *bp = dict->binary;
+    plist_entry_t *e = &dict->entries[i];
+    uint64_t off = e->value.lazy.object;
+    uint64_t count, data;
+    uint8_t marker = bp->buf[off];
+
+    /* the key goes first: decoding the value overwrites value.lazy */
+    if (!e->key && e->value.lazy.key) {
+        const uint8_t *kbytes;
+        size_t klen;
+        int utf16;
+
+        if (bp_key(bp, e->value.lazy.key, &kbytes, &klen, &utf16) ||
+            !(e->key = bp_string(kbytes, klen, utf16)))
+            return -1;
+    }
+
+    switch (e->type) {
+    case PLIST_BOOL:
+        e->value.boolean = (marker == 0x09);
+        break;
+
+    case PLIST_INTEGER: {
+        size_t n = (size_t)1 << (marker & 0x0F);
+
+        /* 16-byte integers only make sense for values we can't hold */
+        if (n > 8 || off + 1 + n > bp->offset_table)
+            return -1;
+
+        e->value.integer = (long)be_read(bp->buf + off + 1, n);  /* 8-byte ints are signed, smaller unsigned */
+        break;
+    }
+
+    case PLIST_REAL:
+    case PLIST_DATE: {
+        size_t n = (size_t)1 << (marker & 0x0F);
+
+        if ((n != 4 && n != 8) || off + 1 + n > bp->offset_table)
             return -1;
+
+        uint64_t bits = be_read(bp->buf + off + 1, n);
+        double v;
+
+        if (n == 4) {
+            uint32_t b32 = (uint32_t)bits;
+            float f;
+
+            memcpy(&f, &b32, sizeof(f));
+            v = f;
+        } else {
+            memcpy(&v, &bits, sizeof(v));
         }
 
-        dict->count++;
+        if (e->type == PLIST_REAL)
+            e->value.real = v;
+        else
+            e->value.date = v;
+        break;
+    }
+
+    case PLIST_DATA:
+        if (bp_header(bp, off, 1, &marker, &count, &data))
+            return -1;
+
+        /* points into the caller's buffer, like XML strings do */
+        e->value.data.bytes = bp->buf + data;
+        e->value.data.length = (size_t)count;
+        break;
+
+    case PLIST_STRING: {
+        int wide = (marker >> 4) == 0x6;
+        const char *s;
+
+        if (bp_header(bp, off, wide ? 2 : 1, &marker, &count, &data) ||
+            !(s = bp_string(bp->buf + data, (size_t)count * (wide ? 2 : 1), wide)))
+            return -1;
+
+        e->value.string = s;
+        break;
+    }
+
+    default:
+        break;                  /* containers: the layout is all there is */
     }
 
+    bp->decoded[i] = 1;
     return 0;
 }
 
+/* ---------- key index ---------- */
+
+/* FNV-1a over the key, seeded by the parent so equal keys in different dicts spread */
+static uint32_t hash_key(uint32_t parent, const uint8_t *p, size_t len) {
+    uint32_t h = 2166136261u ^ (parent * 0x9E3779B9u);
+
+    while (len--)
+        h = (h ^ *p++) * 16777619u;
+    return h;
+}
+
+/* Key of node i equals key[0, len)? Undecoded binary keys are read in place. */
+static int key_equals(const plist_dict_t *dict, size_t i, const char *key, size_t len) {
+    const plist_entry_t *e = &dict->entries[i];
+    const uint8_t *bytes;
+    size_t blen;
+    int utf16;
+
+    if (e->key)
+        return strncmp(e->key, key, len) == 0 && e->key[len] == '\0';
+
+    if (!dict->binary || !e->value.lazy.key ||
+        bp_key(dict->binary, e->value.lazy.key, &bytes, &blen, &utf16) || utf16)
+        return 0;
+    return blen == len && memcmp(bytes, key, len) == 0;
+}
+
+static int build_index(plist_dict_t *dict) {
+    size_t size = 16;
+
+    /* load factor <= 1/2 (every node but the root could be a dict member) */
+    while (size < dict->count * 2)
+        size <<= 1;
+
+    dict->index = arena_alloc_zero(size * sizeof(plist_slot_t));
+    if (!dict->index)
+        return -1;
+    dict->index_mask = size - 1;
+
+    for (uint32_t p = 0; p < dict->count; p++) {
+        if (dict->entries[p].type != PLIST_DICT)
+            continue;
+
+        for (uint32_t i = dict->entries[p].first_child; i; i = dict->entries[i].next_sibling) {
+            plist_entry_t *e = &dict->entries[i];
+            const uint8_t *bytes;
+            size_t len;
+            int utf16;
+
+            if (e->key) {
+                bytes = (const uint8_t *)e->key;
+                len = strlen(e->key);
+            } else {
+                if (bp_key(dict->binary, e->value.lazy.key, &bytes, &len, &utf16))
+                    return -1;
+
+                /* rare: decode UTF-16 keys now so lookups can compare UTF-8 */
+                if (utf16) {
+                    if (!(e->key = bp_utf16_to_utf8(bytes, len / 2)))
+                        return -1;
+                    bytes = (const uint8_t *)e->key;
+                    len = strlen(e->key);
+                }
+            }
+
+            uint32_t h = hash_key(p, bytes, len);
+            size_t s = h & dict->index_mask;
+
+            for (;; s = (s + 1) & dict->index_mask) {
+                plist_slot_t *slot = &dict->index[s];
+
+                if (!slot->entry) {
+                    slot->hash = h;
+                    slot->entry = i + 1;
+                    slot->parent = p;
+                    break;
+                }
+
+                /* duplicate key: keep the first */
+                if (slot->hash == h && slot->parent == p &&
+                    key_equals(dict, slot->entry - 1, (const char *)bytes, len))
+                    break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* ---------- core ---------- */
+
+/*
+ * Whatever a failed parse had built is left in the arena; the dict goes
+ * back to empty so no accessor reaches half-built nodes (or a binary
+ * plist's missing decoded[] map).
+ */
+static int parse_fail(plist_dict_t *dict) {
+    memset(dict, 0, sizeof(*dict));
+    return -1;
+}
+
+int plist_parse_xml(
+    char *buf,
+    size_t size,
+    plist_dict_t *dict
+) {
+    lexer_t lx = { buf, buf + size };
+    tag_t tag;
+    uint32_t root;
+
+    memset(dict, 0, sizeof(*dict));
+
+    if (size >= 8 && memcmp(buf, "bplist00", 8) == 0)
+        return parse_fail(dict); /* binary plist: see plist_parse_binary() */
+
+    if (!next_tag(&lx, &tag) || tag.kind != TAG_OPEN || !TAG_IS(&tag, "plist"))
+        return parse_fail(dict);
+
+    if (!next_tag(&lx, &tag) || new_node(dict, &root) ||
+        parse_node(&lx, dict, &tag, root, 0))
+        return parse_fail(dict);
+
+    if (build_index(dict))
+        return parse_fail(dict);
+    return 0;
+}
+
+int plist_parse_binary(
+    const void *buffer,
+    size_t size,
+    plist_dict_t *dict
+) {
+    const uint8_t *buf = buffer;
+
+    memset(dict, 0, sizeof(*dict));
+
+    if (size < BPLIST_HEADER_SIZE + BPLIST_TRAILER_SIZE ||
+        memcmp(buf, "bplist00", 8) != 0)
+        return parse_fail(dict);
+
+    const uint8_t *t = buf + size - BPLIST_TRAILER_SIZE;
+    struct plist_binary *bp = arena_alloc(sizeof(*bp));
+    if (!bp)
+        return parse_fail(dict);
+
+    bp->buf = buf;
+    bp->offset_size = t[6];
+    bp->ref_size = t[7];
+    bp->num_objects = be_read(t + 8, 8);
+    bp->offset_table = be_read(t + 24, 8);
+
+    uint64_t top = be_read(t + 16, 8);
+
+    if (bp->offset_size < 1 || bp->offset_size > 8 ||
+        bp->ref_size < 1 || bp->ref_size > 8 ||
+        bp->offset_table < BPLIST_HEADER_SIZE ||
+        bp->offset_table > size - BPLIST_TRAILER_SIZE ||
+        bp->num_objects > (size - BPLIST_TRAILER_SIZE - bp->offset_table) / bp->offset_size)
+        return parse_fail(dict);
+
+    uint64_t off;
+    uint32_t root;
+
+    dict->binary = bp;
+    if (bp_object(bp, top, &off) || new_node(dict, &root) ||
+        bp_build(dict, bp, off, root, 0))
+        return parse_fail(dict);
+
+    bp->decoded = arena_alloc_zero(dict->count);
+    if (!bp->decoded)
+        return parse_fail(dict);
+
+    if (build_index(dict))
+        return parse_fail(dict);
+    return 0;
+}
+
+int plist_parse(
+    void *buffer,
+    size_t size,
+    plist_dict_t *out_dict
+) {
+    if (size >= 8 && memcmp(buffer, "bplist00", 8) == 0)
+        return plist_parse_binary(buffer, size, out_dict);
+    return plist_parse_xml(buffer, size, out_dict);
+}
+
+/* ---------- access ---------- */
+
+/* Every node handed out goes through here: binary nodes decode on first touch */
+static const plist_entry_t *touch(const plist_dict_t *dict, size_t i) {
+    if (dict->binary && !dict->binary->decoded[i] && bp_materialize(dict, i))
+        return NULL;
+    return &dict->entries[i];
+}
+
+static const plist_entry_t *lookup(const plist_dict_t *dict, size_t parent,
+                                   const char *key, size_t len) {
+    if (!dict->index || dict->entries[parent].type != PLIST_DICT)
+        return NULL;
+
+    uint32_t h = hash_key((uint32_t)parent, (const uint8_t *)key, len);
+
+    for (size_t s = h & dict->index_mask; ; s = (s + 1) & dict->index_mask) {
+        const plist_slot_t *slot = &dict->index[s];
+
+        if (!slot->entry)
+            return NULL;
+
+        if (slot->hash == h && slot->parent == parent &&
+            key_equals(dict, slot->entry - 1, key, len))
+            return touch(dict, slot->entry - 1);
+    }
+}
+
+static const plist_entry_t *nth_child(const plist_dict_t *dict, size_t parent, size_t n) {
+    const plist_entry_t *p = &dict->entries[parent];
+
+    if ((p->type != PLIST_DICT && p->type != PLIST_ARRAY) || n >= p->count)
+        return NULL;
+
+    uint32_t i = p->first_child;
+    while (n--)
+        i = dict->entries[i].next_sibling;
+    return touch(dict, i);
+}
+
+const plist_entry_t *plist_root(
+    const plist_dict_t *dict
+) {
+    return dict->count ? touch(dict, 0) : NULL;
+}
+
 const plist_entry_t *plist_get(
     const plist_dict_t *dict,
     const char *key
 ) {
-    for (size_t i = 0; i < dict->count; i++) {
-        if (strcmp(dict->entries[i].key, key) == 0)
-            return &dict->entries[i];
+    if (!dict->count)
+        return NULL;
+    return lookup(dict, 0, key, strlen(key));
+}
+
+const plist_entry_t *plist_get_child(
+    const plist_dict_t *dict,
+    const plist_entry_t *parent,
+    const char *key
+) {
+    if (!parent)
+        return NULL;
+    return lookup(dict, (size_t)(parent - dict->entries), key, strlen(key));
+}
+
+const plist_entry_t *plist_get_index(
+    const plist_dict_t *dict,
+    const plist_entry_t *parent,
+    size_t i
+) {
+    if (!parent)
+        return NULL;
+    return nth_child(dict, (size_t)(parent - dict->entries), i);
+}
+
+const plist_entry_t *plist_first(
+    const plist_dict_t *dict,
+    const plist_entry_t *parent
+) {
+    if (!parent || (parent->type != PLIST_DICT && parent->type != PLIST_ARRAY) ||
+        !parent->first_child)
+        return NULL;
+    return touch(dict, parent->first_child);
+}
+
+const plist_entry_t *plist_next(
+    const plist_dict_t *dict,
+    const plist_entry_t *node
+) {
+    if (!node || !node->next_sibling)
+        return NULL;
+    return touch(dict, node->next_sibling);
+}
+
+const plist_entry_t *plist_get_path(
+    const plist_dict_t *dict,
+    const char *path
+) {
+    const plist_entry_t *node = plist_root(dict);
+
+    while (node && *path) {
+        const char *end = path;
+        size_t at = (size_t)(node - dict->entries);
+
+        while (*end && *end != '/')
+            end++;
+
+        size_t len = (size_t)(end - path);
+        if (!len)
+            return NULL;
+
+        if (node->type == PLIST_ARRAY) {
+            size_t n = 0;
+
+            for (const char *c = path; c < end; c++) {
+                if (*c < '0' || *c > '9')
+                    return NULL;
+                n = n * 10 + (size_t)(*c - '0');
+                if (n > PLIST_MAX_NODES)
+                    return NULL;
+            }
+            node = nth_child(dict, at, n);
+        } else {
+            node = lookup(dict, at, path, len);
+        }
+
+        path = *end ? end + 1 : end;
     }
+
+    return node;
+}
+
+/* ---------- precompiled images ---------- */
+
+/* mksdk.py writes these layouts byte for byte; change both or neither */
+_Static_assert(sizeof(plist_entry_t) == 40 && offsetof(plist_entry_t, value) == 24,
+               "plist image node layout");
+_Static_assert(sizeof(plist_slot_t) == 12, "plist image slot layout");
+_Static_assert(sizeof(plist_image_header_t) == 72, "plist image header layout");
+
+/* Offset of a NUL-terminated string inside the pool, to a pointer */
+static const char *reloc_string(uint8_t *base, const plist_image_header_t *hdr, uintptr_t off) {
+    if (off < hdr->pool_offset || off >= hdr->image_size)
+        return NULL;
+
+    for (uint64_t i = off; i < hdr->image_size; i++)
+        if (!base[i])
+            return (const char *)(base + off);
     return NULL;
 }
+
+int plist_image_map(
+    void *image,
+    size_t size,
+    plist_dict_t *dict
+) {
+    uint8_t *base = image;
+    const plist_image_header_t *hdr = image;
+
+    memset(dict, 0, sizeof(*dict));
+
+    if (size < sizeof(*hdr) || ((uintptr_t)image & 7) ||
+        memcmp(hdr->magic, PLIST_IMAGE_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != PLIST_IMAGE_VERSION || hdr->image_size > size)
+        return -1;
+
+    uint32_t n = hdr->node_count;
+    uint32_t slots = hdr->index_slots;
+
+    if (!n || n > PLIST_MAX_NODES || slots < 16 || (slots & (slots - 1)) || slots <= n ||
+        hdr->nodes_offset != sizeof(*hdr) ||
+        hdr->index_offset != hdr->nodes_offset + (uint64_t)n * sizeof(plist_entry_t) ||
+        hdr->pool_offset != hdr->index_offset + (uint64_t)slots * sizeof(plist_slot_t) ||
+        hdr->pool_offset > hdr->image_size)
+        return -1;
+
+    if (crc32_calculate(base + sizeof(*hdr), hdr->image_size - sizeof(*hdr)) != hdr->image_crc)
+        return -1;
+
+    plist_entry_t *nodes = (plist_entry_t *)(base + hdr->nodes_offset);
+
+    /*
+     * Links only point forward (nodes are in pre-order), so a bad image
+     * can't make iteration loop.
+     */
+    for (uint32_t i = 0; i < n; i++) {
+        plist_entry_t *e = &nodes[i];
+
+        if ((unsigned)e->type > PLIST_REAL ||
+            (e->first_child && (e->first_child <= i || e->first_child >= n)) ||
+            (e->next_sibling && (e->next_sibling <= i || e->next_sibling >= n)))
+            return -1;
+
+        if (e->key && !(e->key = reloc_string(base, hdr, (uintptr_t)e->key)))
+            return -1;
+
+        if (e->type == PLIST_STRING) {
+            if (!(e->value.string = reloc_string(base, hdr, (uintptr_t)e->value.string)))
+                return -1;
+        } else if (e->type == PLIST_DATA) {
+            uintptr_t off = (uintptr_t)e->value.data.bytes;
+
+            if (off < hdr->pool_offset || off > hdr->image_size ||
+                e->value.data.length > hdr->image_size - off)
+                return -1;
+            e->value.data.bytes = base + off;
+        }
+    }
+
+    dict->entries = nodes;
+    dict->count = dict->capacity = n;
+    dict->index = (plist_slot_t *)(base + hdr->index_offset);
+    dict->index_mask = slots - 1;
+
+    /* the stored hashes must be the ones lookup() computes */
+    for (uint32_t s = 0; s < slots; s++) {
+        const plist_slot_t *slot = &dict->index[s];
+
+        if (!slot->entry)
+            continue;
+
+        const plist_entry_t *e = slot->entry <= n ? &nodes[slot->entry - 1] : NULL;
+
+        if (!e || !e->key || slot->parent >= n || nodes[slot->parent].type != PLIST_DICT ||
+            slot->hash != hash_key(slot->parent, (const uint8_t *)e->key, strlen(e->key))) {
+            memset(dict, 0, sizeof(*dict));
+            return -1;
+        }
+    }
+
+    return 0;
+}
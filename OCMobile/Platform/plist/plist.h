@@ -2,39 +2,189 @@
 #define PLIST_H
 
 #include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Property lists.
+ *
+ * The whole tree lives in one contiguous node array: entries[0] is the
+ * root, and containers link to their children by index (first_child,
+ * then next_sibling; 0 ends a list, since the root is nobody's child).
+ *
+ * XML is parsed in place: keys, strings and <data> point into the
+ * caller's buffer (which gets NUL-terminated, entity- and base64-decoded
+ * where it is). bplist00 is decoded lazily: parsing only lays out the
+ * tree from the object headers, and a node's key and value are filled in
+ * when an accessor below first returns it. Nodes, the key index and
+ * decoded binary strings come from the stage arena (Memory.h).
+ */
 
 typedef enum {
     PLIST_STRING,
     PLIST_INTEGER,
-    PLIST_BOOL
+    PLIST_BOOL,
+    PLIST_DICT,
+    PLIST_ARRAY,
+    PLIST_DATA,
+    PLIST_DATE,
+    PLIST_REAL
 } plist_type_t;
 
 typedef struct {
-    const char *key;
+    const char *key;            /* NULL for array elements and the root */
 
     plist_type_t type;
+    uint32_t count;             /* dict/array: number of children */
+    uint32_t first_child;       /* dict/array: node index, 0 = empty */
+    uint32_t next_sibling;      /* node index, 0 = last */
+
     union {
         const char *string;
         long integer;
         int boolean;
+        double real;
+        double date;            /* seconds since 2001-01-01 00:00 UTC */
+        struct {
+            const uint8_t *bytes;
+            size_t length;
+        } data;
+
+        /* bplist, before decoding (internal) */
+        struct {
+            uint64_t object;
+            uint64_t key;
+        } lazy;
     } value;
 } plist_entry_t;
 
+/* open-addressed index over every dict member, keyed by (parent, key) */
 typedef struct {
-    plist_entry_t *entries;
-    size_t count;
+    uint32_t hash;
+    uint32_t entry;             /* index + 1, 0 = empty */
+    uint32_t parent;
+} plist_slot_t;
+
+typedef struct {
+    plist_entry_t *entries;     /* the node array, entries[0] = root */
+    size_t count;               /* nodes in use, not top-level keys */
     size_t capacity;
+
+    plist_slot_t *index;
+    size_t index_mask;
+
+    struct plist_binary *binary;    /* NULL for XML */
 } plist_dict_t;
 
+/* Single forward pass over buffer[0, size); 0 on success, -1 on error */
 int plist_parse_xml(
-    const char *buffer,
+    char *buffer,
+    size_t size,
+    plist_dict_t *out_dict
+);
+
+/* bplist00; `buffer` must stay mapped as long as the dict is used */
+int plist_parse_binary(
+    const void *buffer,
     size_t size,
     plist_dict_t *out_dict
 );
 
+/* Either of the above, by magic */
+int plist_parse(
+    void *buffer,
+    size_t size,
+    plist_dict_t *out_dict
+);
+
+/* ---------- access ---------- */
+
+/* The top-level object */
+const plist_entry_t *plist_root(
+    const plist_dict_t *dict
+);
+
+/* Member of the top-level dict; O(1) on average, first duplicate wins */
 const plist_entry_t *plist_get(
     const plist_dict_t *dict,
     const char *key
 );
 
+/* Member of a nested dict, same rules */
+const plist_entry_t *plist_get_child(
+    const plist_dict_t *dict,
+    const plist_entry_t *parent,
+    const char *key
+);
+
+/* i-th child of an array (or dict, in document order) */
+const plist_entry_t *plist_get_index(
+    const plist_dict_t *dict,
+    const plist_entry_t *parent,
+    size_t i
+);
+
+/* Iteration: first child of a container, then its siblings; NULL at the end */
+const plist_entry_t *plist_first(
+    const plist_dict_t *dict,
+    const plist_entry_t *parent
+);
+
+const plist_entry_t *plist_next(
+    const plist_dict_t *dict,
+    const plist_entry_t *node
+);
+
+/*
+ * Walk from the root through dict keys and array indices separated by
+ * '/', e.g. "Kernel/Add/3/BundlePath". Keys containing '/' can't be
+ * addressed this way; use plist_get_child().
+ */
+const plist_entry_t *plist_get_path(
+    const plist_dict_t *dict,
+    const char *path
+);
+
+/* ---------- precompiled images ---------- */
+
+/*
+ * A parsed dict flattened into one relocatable blob: header, the node
+ * array, the key index, then a pool of NUL-terminated strings and data.
+ * Nodes and slots are stored in their in-memory (LP64, little-endian)
+ * layout with pointers written as image offsets, so mapping one is a
+ * relocation pass rather than a parse. Only Tools/mksdk.py writes
+ * them, offline.
+ */
+
+#define PLIST_IMAGE_MAGIC       "OCMPLIMG"
+#define PLIST_IMAGE_VERSION     1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t image_crc;         /* crc32 of everything after the header */
+    uint64_t image_size;
+
+    /* what the image was built from, for the caller to compare */
+    uint64_t source_size;
+    uint32_t source_crc;
+
+    uint32_t node_count;
+    uint32_t index_slots;       /* power of two */
+    uint32_t reserved;
+
+    uint64_t nodes_offset;
+    uint64_t index_offset;
+    uint64_t pool_offset;
+} plist_image_header_t;
+
+/*
+ * Validate `image` (8-byte aligned, writable) and relocate it in place;
+ * `out_dict` then points into it, so it must outlive the dict.
+ */
+int plist_image_map(
+    void *image,
+    size_t size,
+    plist_dict_t *out_dict
+);
+
 #endif
@@ -0,0 +1,477 @@
+#include "wscd.h"
+#include "../../bootstd.h"
+#include "../crc32/crc32.h"
+
+/* Tools/writersc writes these layouts byte for byte; change both or neither */
+_Static_assert(sizeof(wscd_header_t) == 24, "wscd header layout");
+_Static_assert(sizeof(wscd_section_t) == 12, "wscd section layout");
+_Static_assert(sizeof(wscd_func_t) == 16, "wscd function layout");
+_Static_assert(sizeof(wscd_import_t) == 8, "wscd import layout");
+_Static_assert(sizeof(wscd_native_header_t) == 16, "wscd native section layout");
+
+#define LINK_CTX        0
+#define LINK_LIMIT      1
+#define LINK_FAULT      2
+#define LINK_IMPORTS    3
+
+#if defined(__aarch64__)
+#define WSCD_ARCH_HOST  WSCD_ARCH_AARCH64
+#else
+#define WSCD_ARCH_HOST  0
+#endif
+
+/* ---------- checking ---------- */
+
+static int string_ok(const wscd_module_t *m, uint32_t off) {
+    /* the table ends in a NUL, so every offset inside it is a string */
+    return off < m->strings_size;
+}
+
+static int section(const wscd_module_t *m, const wscd_section_t *s, uint32_t align,
+                   uint32_t entry, const void **out, uint32_t *count) {
+    if (*out || s->offset > m->header->image_size ||
+        s->size > m->header->image_size - s->offset ||
+        (s->offset & (align - 1)) || s->size % entry)
+        return -1;
+
+    *out = m->image + s->offset;
+    *count = s->size / entry;
+    return 0;
+}
+
+static int target_ok(const wscd_func_t *f, uint32_t pc, int32_t delta) {
+    int64_t to = (int64_t)pc + 1 + delta;
+
+    return to >= 0 && to < f->length;
+}
+
+static int call_ok(uint32_t a, uint32_t nargs, uint32_t expected, uint32_t nregs) {
+    /* the result lands in R(A) even when there are no arguments */
+    return nargs == expected && a + (nargs ? nargs : 1) <= nregs;
+}
+
+static int check_function(const wscd_module_t *m, const wscd_func_t *f) {
+    const uint32_t *code;
+    uint32_t n = f->nregs;
+
+    if (!string_ok(m, f->name) || !f->length || f->code > m->code_count ||
+        f->length > m->code_count - f->code || f->nparams > n || n > WSCD_MAX_REGS)
+        return -1;
+
+    code = m->code + f->code;
+
+    for (uint32_t pc = 0; pc < f->length; pc++) {
+        uint32_t i = code[pc];
+        uint32_t a = WSCD_A(i), b = WSCD_B(i), c = WSCD_C(i);
+        int ok;
+
+        switch (WSCD_OP(i)) {
+        case WSCD_OP_MOV:
+        case WSCD_OP_ADDI:
+        case WSCD_OP_NEG:
+        case WSCD_OP_NOT:
+        case WSCD_OP_INV:
+            ok = a < n && b < n;
+            break;
+        case WSCD_OP_LOADI:
+        case WSCD_OP_RET:
+            ok = a < n;
+            break;
+        case WSCD_OP_LOADK:
+            ok = a < n && WSCD_BX(i) < m->const_count;
+            break;
+        case WSCD_OP_ADD: case WSCD_OP_SUB: case WSCD_OP_MUL:
+        case WSCD_OP_DIVU: case WSCD_OP_DIVS: case WSCD_OP_REMU: case WSCD_OP_REMS:
+        case WSCD_OP_AND: case WSCD_OP_OR: case WSCD_OP_XOR:
+        case WSCD_OP_SHL: case WSCD_OP_SHRU: case WSCD_OP_SHRS:
+        case WSCD_OP_EQ: case WSCD_OP_NE:
+        case WSCD_OP_LTU: case WSCD_OP_LTS: case WSCD_OP_LEU: case WSCD_OP_LES:
+            ok = a < n && b < n && c < n;
+            break;
+        case WSCD_OP_EXT:
+            c &= ~WSCD_EXT_SIGNED;
+            ok = a < n && b < n && (c == 8 || c == 16 || c == 32);
+            break;
+        case WSCD_OP_JMP:
+            ok = target_ok(f, pc, WSCD_SAX(i));
+            break;
+        case WSCD_OP_JZ:
+        case WSCD_OP_JNZ:
+            ok = a < n && target_ok(f, pc, WSCD_SBX(i));
+            break;
+        case WSCD_OP_CALL:
+            ok = b < m->func_count && call_ok(a, c, m->funcs[b].nparams, n);
+            break;
+        case WSCD_OP_CALLN:
+            ok = b < m->import_count && call_ok(a, c, m->imports[b].nargs, n);
+            break;
+        default:
+            ok = 0;
+            break;
+        }
+        if (!ok)
+            return -1;
+    }
+
+    /* no falling off the end */
+    uint32_t last = WSCD_OP(code[f->length - 1]);
+
+    return last == WSCD_OP_RET || last == WSCD_OP_JMP ? 0 : -1;
+}
+
+/* Entry points inside the code, the link area after it and in the section */
+static int check_native(wscd_module_t *m, const wscd_native_header_t *hdr, uint32_t size) {
+    const uint32_t *entries = (const uint32_t *)(hdr + 1);
+
+    if (size < sizeof(*hdr) || hdr->func_count != m->func_count)
+        return -1;
+
+    uint64_t head = sizeof(*hdr) + (uint64_t)hdr->func_count * 4;
+
+    if (head + hdr->code_size > hdr->link || (hdr->link & 7) ||
+        hdr->link + 8 * (uint64_t)(LINK_IMPORTS + m->import_count) > size)
+        return -1;
+
+    for (uint32_t i = 0; i < hdr->func_count; i++)
+        if (entries[i] < head || entries[i] >= head + hdr->code_size || (entries[i] & 3))
+            return -1;
+
+    if (hdr->arch == WSCD_ARCH_HOST) {
+        m->native = hdr;
+        m->link = (uint64_t *)((uintptr_t)hdr + hdr->link);
+    }
+    return 0;
+}
+
+int wscd_open(
+    void *image,
+    size_t size,
+    wscd_module_t *m
+) {
+    const wscd_header_t *hdr = image;
+
+    memset(m, 0, sizeof(*m));
+
+    if (size < sizeof(*hdr) || ((uintptr_t)image & 7) || hdr->magic != WSCD_MAGIC ||
+        hdr->version != WSCD_VERSION || hdr->image_size > size ||
+        hdr->image_size < sizeof(*hdr) + (uint64_t)hdr->section_count * sizeof(wscd_section_t))
+        return -1;
+
+    if (crc32_calculate((const uint8_t *)image + sizeof(*hdr),
+                        hdr->image_size - sizeof(*hdr)) != hdr->image_crc)
+        return -1;
+
+    m->image = image;
+    m->header = hdr;
+
+    const wscd_section_t *sections = (const wscd_section_t *)(hdr + 1);
+    const void *strings = NULL, *funcs = NULL, *imports = NULL, *consts = NULL, *code = NULL;
+    const void *native = NULL;
+    uint32_t native_size = 0;
+
+    for (uint32_t i = 0; i < hdr->section_count; i++) {
+        const wscd_section_t *s = &sections[i];
+        int r;
+
+        switch (s->type) {
+        case WSCD_SECTION_STRINGS:
+            r = section(m, s, 1, 1, &strings, &m->strings_size);
+            break;
+        case WSCD_SECTION_FUNCS:
+            r = section(m, s, 4, sizeof(wscd_func_t), &funcs, &m->func_count);
+            break;
+        case WSCD_SECTION_IMPORTS:
+            r = section(m, s, 4, sizeof(wscd_import_t), &imports, &m->import_count);
+            break;
+        case WSCD_SECTION_CONSTS:
+            r = section(m, s, 8, sizeof(uint64_t), &consts, &m->const_count);
+            break;
+        case WSCD_SECTION_CODE:
+            r = section(m, s, 4, sizeof(uint32_t), &code, &m->code_count);
+            break;
+        case WSCD_SECTION_NATIVE:
+            r = section(m, s, 8, 1, &native, &native_size);
+            break;
+        default:
+            r = 0;              /* from a newer writersc; not ours to run */
+            break;
+        }
+        if (r)
+            return -1;
+    }
+
+    m->strings = strings;
+    m->funcs = funcs;
+    m->imports = imports;
+    m->consts = consts;
+    m->code = code;
+
+    if (!m->strings_size || m->strings[0] || m->strings[m->strings_size - 1] ||
+        !m->func_count || m->func_count > WSCD_MAX_FUNCS ||
+        m->import_count > WSCD_MAX_IMPORTS || !string_ok(m, hdr->name) ||
+        (hdr->init != WSCD_NO_FUNC && hdr->init >= m->func_count))
+        return -1;
+
+    for (uint32_t i = 0; i < m->import_count; i++)
+        if (!string_ok(m, m->imports[i].name) || m->imports[i].nargs >= WSCD_MAX_REGS)
+            return -1;
+
+    for (uint32_t i = 0; i < m->func_count; i++)
+        if (check_function(m, &m->funcs[i]))
+            return -1;
+
+    if (native && check_native(m, native, native_size))
+        return -1;
+    return 0;
+}
+
+const char *wscd_name(const wscd_module_t *m) {
+    return m->strings + m->header->name;
+}
+
+const char *wscd_func_name(const wscd_module_t *m, uint32_t fn) {
+    return fn < m->func_count ? m->strings + m->funcs[fn].name : NULL;
+}
+
+uint32_t wscd_find(const wscd_module_t *m, const char *name) {
+    for (uint32_t i = 0; i < m->func_count; i++) {
+        if (!(m->funcs[i].flags & WSCD_FUNC_EXPORT) && i != m->header->init)
+            continue;
+        if (strcmp(m->strings + m->funcs[i].name, name) == 0)
+            return i;
+    }
+    return WSCD_NO_FUNC;
+}
+
+uint32_t wscd_bind(
+    wscd_module_t *m,
+    const wscd_native_t *natives,
+    size_t count,
+    void *ctx,
+    const char **missing
+) {
+    uint32_t unresolved = 0;
+
+    m->ctx = ctx;
+    if (m->link)
+        m->link[LINK_CTX] = (uintptr_t)ctx;
+
+    for (uint32_t i = 0; i < m->import_count; i++) {
+        const char *name = m->strings + m->imports[i].name;
+
+        m->natives[i] = NULL;
+        for (size_t j = 0; j < count; j++) {
+            if (natives[j].nargs == m->imports[i].nargs && strcmp(natives[j].name, name) == 0) {
+                m->natives[i] = &natives[j];
+                break;
+            }
+        }
+        if (!m->natives[i] && !unresolved++ && missing)
+            *missing = name;
+        if (m->link)
+            m->link[LINK_IMPORTS + i] = m->natives[i] ? (uintptr_t)m->natives[i]->fn : 0;
+    }
+    m->unbound = unresolved;
+    return unresolved;
+}
+
+/* ---------- running ---------- */
+
+/*
+ * Threaded dispatch: every handler ends by fetching the next instruction
+ * and jumping straight to its handler, so there is no loop, no switch and
+ * one indirect branch per handler for the predictor to learn. wscd_open()
+ * has checked every operand, so the handlers take them as they are.
+ */
+int wscd_call(
+    const wscd_module_t *m,
+    wscd_stack_t *stack,
+    uint32_t fn,
+    const uint64_t *args,
+    uint32_t nargs,
+    uint64_t *result
+) {
+    static const void *const dispatch[WSCD_OP_COUNT] = {
+        [WSCD_OP_MOV] = &&op_mov,       [WSCD_OP_LOADI] = &&op_loadi,
+        [WSCD_OP_LOADK] = &&op_loadk,   [WSCD_OP_ADD] = &&op_add,
+        [WSCD_OP_ADDI] = &&op_addi,     [WSCD_OP_SUB] = &&op_sub,
+        [WSCD_OP_MUL] = &&op_mul,       [WSCD_OP_DIVU] = &&op_divu,
+        [WSCD_OP_DIVS] = &&op_divs,     [WSCD_OP_REMU] = &&op_remu,
+        [WSCD_OP_REMS] = &&op_rems,     [WSCD_OP_AND] = &&op_and,
+        [WSCD_OP_OR] = &&op_or,         [WSCD_OP_XOR] = &&op_xor,
+        [WSCD_OP_SHL] = &&op_shl,       [WSCD_OP_SHRU] = &&op_shru,
+        [WSCD_OP_SHRS] = &&op_shrs,     [WSCD_OP_EQ] = &&op_eq,
+        [WSCD_OP_NE] = &&op_ne,         [WSCD_OP_LTU] = &&op_ltu,
+        [WSCD_OP_LTS] = &&op_lts,       [WSCD_OP_LEU] = &&op_leu,
+        [WSCD_OP_LES] = &&op_les,       [WSCD_OP_NEG] = &&op_neg,
+        [WSCD_OP_NOT] = &&op_not,       [WSCD_OP_INV] = &&op_inv,
+        [WSCD_OP_EXT] = &&op_ext,       [WSCD_OP_JMP] = &&op_jmp,
+        [WSCD_OP_JZ] = &&op_jz,         [WSCD_OP_JNZ] = &&op_jnz,
+        [WSCD_OP_CALL] = &&op_call,     [WSCD_OP_CALLN] = &&op_calln,
+        [WSCD_OP_RET] = &&op_ret,
+    };
+
+    if (fn >= m->func_count || nargs != m->funcs[fn].nparams)
+        return WSCD_ERR_ARGS;
+    if (m->funcs[fn].nregs > stack->reg_count)
+        return WSCD_ERR_STACK;
+
+    uint64_t *base = stack->regs;
+    uint64_t *const limit = stack->regs + stack->reg_count;
+    wscd_frame_t *frame = stack->frames;
+    wscd_frame_t *const frames_end = stack->frames + stack->frame_count;
+    const uint32_t *pc = m->code + m->funcs[fn].code;
+    uint32_t i;
+
+    for (uint32_t k = 0; k < nargs; k++)
+        base[k] = args[k];
+
+#define NEXT()  do { i = *pc++; goto *dispatch[WSCD_OP(i)]; } while (0)
+#define RA      base[WSCD_A(i)]
+#define RB      base[WSCD_B(i)]
+#define RC      base[WSCD_C(i)]
+#define SRB     ((int64_t)RB)
+#define SRC     ((int64_t)RC)
+
+    NEXT();
+
+op_mov:     RA = RB;                                NEXT();
+op_loadi:   RA = (uint64_t)(int64_t)WSCD_SBX(i);    NEXT();
+op_loadk:   RA = m->consts[WSCD_BX(i)];             NEXT();
+op_add:     RA = RB + RC;                           NEXT();
+op_addi:    RA = RB + (uint64_t)(int64_t)(int8_t)WSCD_C(i); NEXT();
+op_sub:     RA = RB - RC;                           NEXT();
+op_mul:     RA = RB * RC;                           NEXT();
+op_and:     RA = RB & RC;                           NEXT();
+op_or:      RA = RB | RC;                           NEXT();
+op_xor:     RA = RB ^ RC;                           NEXT();
+op_shl:     RA = RB << (RC & 63);                   NEXT();
+op_shru:    RA = RB >> (RC & 63);                   NEXT();
+op_shrs:    RA = (uint64_t)(SRB >> (RC & 63));      NEXT();
+op_eq:      RA = RB == RC;                          NEXT();
+op_ne:      RA = RB != RC;                          NEXT();
+op_ltu:     RA = RB < RC;                           NEXT();
+op_lts:     RA = SRB < SRC;                         NEXT();
+op_leu:     RA = RB <= RC;                          NEXT();
+op_les:     RA = SRB <= SRC;                        NEXT();
+op_neg:     RA = -RB;                               NEXT();
+op_not:     RA = !RB;                               NEXT();
+op_inv:     RA = ~RB;                               NEXT();
+
+/* what udiv / sdiv (and msub after them) give: x / 0 = 0, INT64_MIN / -1 wraps */
+op_divu:    RA = RC ? RB / RC : 0;                  NEXT();
+op_remu:    RA = RC ? RB % RC : RB;                 NEXT();
+op_divs:
+    RA = !RC ? 0 : SRC == -1 ? -RB : (uint64_t)(SRB / SRC);
+    NEXT();
+op_rems:
+    RA = !RC ? RB : SRC == -1 ? 0 : (uint64_t)(SRB % SRC);
+    NEXT();
+
+op_ext: {
+    uint32_t shift = 64 - (WSCD_C(i) & ~WSCD_EXT_SIGNED);
+    uint64_t v = RB << shift;
+
+    RA = WSCD_C(i) & WSCD_EXT_SIGNED ? (uint64_t)((int64_t)v >> shift) : v >> shift;
+    NEXT();
+}
+
+op_jmp:
+    pc += WSCD_SAX(i);
+    NEXT();
+op_jz:
+    if (!RA)
+        pc += WSCD_SBX(i);
+    NEXT();
+op_jnz:
+    if (RA)
+        pc += WSCD_SBX(i);
+    NEXT();
+
+op_call: {
+    const wscd_func_t *callee = &m->funcs[WSCD_B(i)];
+    uint64_t *window = &RA;
+
+    if (frame == frames_end || callee->nregs > (size_t)(limit - window))
+        return WSCD_ERR_STACK;
+    frame->pc = pc;
+    frame->base = base;
+    frame++;
+    base = window;
+    pc = m->code + callee->code;
+    NEXT();
+}
+
+op_calln: {
+    const wscd_native_t *native = m->natives[WSCD_B(i)];
+
+    if (!native)
+        return WSCD_ERR_UNBOUND;
+    RA = native->fn(m->ctx, &RA);
+    NEXT();
+}
+
+op_ret: {
+    uint64_t v = RA;
+
+    if (frame == stack->frames) {
+        *result = v;
+        return 0;
+    }
+    /* our window starts at the caller's R(A), where the result belongs */
+    base[0] = v;
+    frame--;
+    pc = frame->pc;
+    base = frame->base;
+    NEXT();
+}
+
+#undef NEXT
+#undef RA
+#undef RB
+#undef RC
+#undef SRB
+#undef SRC
+}
+
+int wscd_call_native(
+    const wscd_module_t *m,
+    uint32_t fn,
+    const uint64_t *args,
+    uint32_t nargs,
+    uintptr_t stack_limit,
+    void (*fault)(void *ctx, uint64_t reason),
+    uint64_t *result
+) {
+#if defined(__aarch64__)
+    typedef uint64_t (*entry_t)(uint64_t, uint64_t, uint64_t, uint64_t,
+                                uint64_t, uint64_t, uint64_t, uint64_t);
+    uint64_t a[8] = { 0 };
+
+    if (!m->native || fn >= m->func_count || nargs != m->funcs[fn].nparams || nargs > 8)
+        return WSCD_ERR_ARGS;
+    if (m->unbound)
+        return WSCD_ERR_UNBOUND;
+
+    const uint32_t *entries = (const uint32_t *)(m->native + 1);
+
+    for (uint32_t k = 0; k < nargs; k++)
+        a[k] = args[k];
+    m->link[LINK_LIMIT] = stack_limit;
+    m->link[LINK_FAULT] = (uintptr_t)fault;
+
+    /* AAPCS64 leaves arguments beyond the callee's alone, so pass all eight */
+    entry_t entry = (entry_t)((uintptr_t)m->native + entries[fn]);
+    *result = entry(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+    return 0;
+#else
+    (void)m;
+    (void)fn;
+    (void)args;
+    (void)nargs;
+    (void)stack_limit;
+    (void)fault;
+    (void)result;
+    return WSCD_ERR_ARGS;
+#endif
+}
@@ -0,0 +1,280 @@
+#ifndef WSCD_H
+#define WSCD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * WriterSc compiled drivers (.wscd), as Tools/writersc writes them, and
+ * the interpreter that runs them.
+ *
+ * An image is a header, a section table and the sections it points at,
+ * all little-endian and 8-byte aligned so it runs where it was read:
+ *   strings    NUL-terminated names; offset 0 is ""
+ *   funcs      wscd_func_t per function, init() among them
+ *   imports    wscd_import_t per host function the driver `requires`
+ *   consts     64-bit constants too wide for LOADI
+ *   code       32-bit instructions, each function a contiguous run
+ *   native     optional: the same functions compiled for one CPU
+ *
+ * The code is for a register machine: a function's registers are a
+ * window of 64-bit slots, parameters first. A call passes its arguments
+ * in consecutive registers of the caller, which become the bottom of
+ * the callee's window, and the result comes back in the first of them,
+ * so calls copy nothing. Instructions are op | A << 8 | B << 16 | C << 24,
+ * with Bx (16 bits) or Ax (24 bits) taking the place of the fields above
+ * A or op; sBx and sAx are signed, jumps relative to the next instruction.
+ *
+ * wscd_open() checks everything the interpreter would otherwise have to:
+ * register numbers against the window, jump targets against the
+ * function, call arities against the callee. Running then only has to
+ * watch the stack. Division by zero gives 0 and the remainder the
+ * dividend, as aarch64's udiv / sdiv do, so both ways of running a
+ * driver agree.
+ *
+ * When the native section is for the CPU we run on, wscd_call_native()
+ * runs its code instead. Native code can't be checked the way bytecode
+ * is; it is trusted as far as the image's CRC, like any other binary.
+ */
+
+#define WSCD_MAGIC              0x44435357u     /* "WSCD" */
+#define WSCD_VERSION            1
+
+#define WSCD_MAX_REGS           256
+#define WSCD_MAX_FUNCS          256             /* CALL's B */
+#define WSCD_MAX_IMPORTS        64
+#define WSCD_NO_FUNC            0xFFFFu
+
+typedef enum {
+    WSCD_SECTION_STRINGS = 1,
+    WSCD_SECTION_FUNCS,
+    WSCD_SECTION_IMPORTS,
+    WSCD_SECTION_CONSTS,
+    WSCD_SECTION_CODE,
+    WSCD_SECTION_NATIVE
+} wscd_section_type_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t section_count;     /* wscd_section_t right after the header */
+    uint32_t image_size;
+    uint32_t image_crc;         /* CRC-32 of everything after the header */
+    uint32_t name;              /* driver name, string offset */
+    uint16_t init;              /* function index of init() */
+    uint16_t reserved;
+} wscd_header_t;
+
+typedef struct {
+    uint32_t type;              /* wscd_section_type_t */
+    uint32_t offset;            /* from the start of the image */
+    uint32_t size;
+} wscd_section_t;
+
+#define WSCD_FUNC_EXPORT        0x01
+
+typedef struct {
+    uint32_t name;              /* string offset */
+    uint32_t code;              /* first instruction, index into code */
+    uint32_t length;            /* instructions */
+    uint16_t nregs;             /* window size, >= nparams */
+    uint8_t nparams;
+    uint8_t flags;              /* WSCD_FUNC_* */
+} wscd_func_t;
+
+typedef struct {
+    uint32_t name;              /* string offset */
+    uint32_t nargs;
+} wscd_import_t;
+
+/*
+ * The native section: this header, one entry offset per function (from
+ * the start of the section), the code and, 8-byte aligned at `link`, the
+ * link area the code finds its surroundings through, zero in the file:
+ *   +0   ctx handed to host functions
+ *   +8   lowest address the stack may reach
+ *   +16  void fault(ctx, reason), called instead of going past it
+ *   +24  a host function per import, as wscd_native_t.fn
+ * Functions are AAPCS64 (arguments in x0..x7, result in x0); calling one
+ * is all wscd_call_native() does.
+ */
+#define WSCD_ARCH_AARCH64       0xAA64u
+
+#define WSCD_FAULT_STACK        1
+
+typedef struct {
+    uint32_t arch;              /* WSCD_ARCH_* */
+    uint32_t func_count;        /* as many as the funcs section */
+    uint32_t code_size;         /* bytes after the entry table */
+    uint32_t link;              /* offset of the link area */
+} wscd_native_header_t;
+
+/*
+ * Opcodes. R(x) is register x of the current window, K(x) constant x.
+ * Comparisons set 1 or 0; > and >= are emitted with the operands swapped.
+ */
+typedef enum {
+    WSCD_OP_MOV,                /* R(A) = R(B) */
+    WSCD_OP_LOADI,              /* R(A) = sBx */
+    WSCD_OP_LOADK,              /* R(A) = K(Bx) */
+    WSCD_OP_ADD,                /* R(A) = R(B) + R(C) */
+    WSCD_OP_ADDI,               /* R(A) = R(B) + (int8_t)C */
+    WSCD_OP_SUB,
+    WSCD_OP_MUL,
+    WSCD_OP_DIVU,               /* x / 0 = 0 */
+    WSCD_OP_DIVS,
+    WSCD_OP_REMU,               /* x % 0 = x */
+    WSCD_OP_REMS,
+    WSCD_OP_AND,
+    WSCD_OP_OR,
+    WSCD_OP_XOR,
+    WSCD_OP_SHL,                /* shift counts are taken mod 64 */
+    WSCD_OP_SHRU,
+    WSCD_OP_SHRS,
+    WSCD_OP_EQ,
+    WSCD_OP_NE,
+    WSCD_OP_LTU,
+    WSCD_OP_LTS,
+    WSCD_OP_LEU,
+    WSCD_OP_LES,
+    WSCD_OP_NEG,                /* R(A) = -R(B) */
+    WSCD_OP_NOT,                /* R(A) = !R(B) */
+    WSCD_OP_INV,                /* R(A) = ~R(B) */
+    WSCD_OP_EXT,                /* R(A) = R(B) cut to C & 0x7F bits, sign-extended if C & 0x80 */
+    WSCD_OP_JMP,                /* pc += sAx */
+    WSCD_OP_JZ,                 /* if (!R(A)) pc += sBx */
+    WSCD_OP_JNZ,                /* if (R(A)) pc += sBx */
+    WSCD_OP_CALL,               /* R(A) = func B (R(A) .. R(A + C - 1)) */
+    WSCD_OP_CALLN,              /* R(A) = import B (R(A) .. R(A + C - 1)) */
+    WSCD_OP_RET,                /* return R(A) */
+    WSCD_OP_COUNT
+} wscd_op_t;
+
+#define WSCD_EXT_SIGNED         0x80
+
+#define WSCD_OP(i)              ((i) & 0xFFu)
+#define WSCD_A(i)               (((i) >> 8) & 0xFFu)
+#define WSCD_B(i)               (((i) >> 16) & 0xFFu)
+#define WSCD_C(i)               ((i) >> 24)
+#define WSCD_BX(i)              ((i) >> 16)
+#define WSCD_SBX(i)             ((int32_t)(int16_t)((i) >> 16))
+#define WSCD_SAX(i)             ((int32_t)(i) >> 8)
+
+#define WSCD_ABC(op, a, b, c)   ((uint32_t)(op) | (uint32_t)(a) << 8 | \
+                                 (uint32_t)(b) << 16 | (uint32_t)(c) << 24)
+#define WSCD_ABX(op, a, bx)     ((uint32_t)(op) | (uint32_t)(a) << 8 | \
+                                 (uint32_t)(uint16_t)(bx) << 16)
+#define WSCD_AX(op, ax)         ((uint32_t)(op) | (uint32_t)(ax) << 8)
+
+/* ---------- running ---------- */
+
+/* A host function a driver can `require` */
+typedef struct {
+    const char *name;
+    uint32_t nargs;
+    uint64_t (*fn)(void *ctx, const uint64_t *args);
+} wscd_native_t;
+
+typedef struct {
+    const uint8_t *image;
+    const wscd_header_t *header;
+    const char *strings;
+    uint32_t strings_size;
+    const wscd_func_t *funcs;
+    uint32_t func_count;
+    const wscd_import_t *imports;
+    uint32_t import_count;
+    const uint64_t *consts;
+    uint32_t const_count;
+    const uint32_t *code;
+    uint32_t code_count;
+    const wscd_native_header_t *native;     /* NULL unless for this CPU */
+    uint64_t *link;
+
+    /* wscd_bind() */
+    const wscd_native_t *natives[WSCD_MAX_IMPORTS];
+    void *ctx;
+    uint32_t unbound;
+} wscd_module_t;
+
+typedef struct {
+    const uint32_t *pc;         /* of the caller, after the CALL */
+    uint64_t *base;             /* the caller's window */
+} wscd_frame_t;
+
+/* What one wscd_call() runs on; the caller owns (and sizes) both arrays */
+typedef struct {
+    uint64_t *regs;
+    size_t reg_count;
+    wscd_frame_t *frames;
+    size_t frame_count;         /* call depth */
+} wscd_stack_t;
+
+/* wscd_call() failures */
+#define WSCD_ERR_ARGS           -1      /* wrong argument count, or no such function */
+#define WSCD_ERR_UNBOUND        -2      /* an import wscd_bind() did not resolve */
+#define WSCD_ERR_STACK          -3      /* out of registers or frames */
+
+/*
+ * Check image[0, size) (8-byte aligned, and it must stay mapped) and
+ * point `m` into it. 0, or -1 if it is no valid image. The native
+ * section's link area is written to, by wscd_bind() and
+ * wscd_call_native(); the code itself still needs making executable
+ * (I-cache) by the caller.
+ */
+int wscd_open(
+    void *image,
+    size_t size,
+    wscd_module_t *m
+);
+
+/* Driver name, and a function's name by index (NULL past the end) */
+const char *wscd_name(const wscd_module_t *m);
+const char *wscd_func_name(const wscd_module_t *m, uint32_t fn);
+
+/* Index of the exported function `name` (or init()), WSCD_NO_FUNC if none */
+uint32_t wscd_find(const wscd_module_t *m, const char *name);
+
+/*
+ * Resolve the imports against natives[0, count) by name and argument
+ * count; `ctx` is passed to each. Both go into the native link area as
+ * well. Returns the number left unresolved (their calls fail with
+ * WSCD_ERR_UNBOUND) and, if any, sets *missing to the first of them.
+ */
+uint32_t wscd_bind(
+    wscd_module_t *m,
+    const wscd_native_t *natives,
+    size_t count,
+    void *ctx,
+    const char **missing
+);
+
+/* Run function `fn` to completion; 0 and *result set, WSCD_ERR_* otherwise */
+int wscd_call(
+    const wscd_module_t *m,
+    wscd_stack_t *stack,
+    uint32_t fn,
+    const uint64_t *args,
+    uint32_t nargs,
+    uint64_t *result
+);
+
+/*
+ * Run function `fn`'s native code, on the current stack, which it may
+ * grow down to `stack_limit`; past that it calls fault(ctx,
+ * WSCD_FAULT_STACK), which must not return. Needs wscd_bind() to have
+ * resolved every import first (WSCD_ERR_UNBOUND otherwise). 0 and
+ * *result set, WSCD_ERR_ARGS for a bad call or a module without native
+ * code.
+ */
+int wscd_call_native(
+    const wscd_module_t *m,
+    uint32_t fn,
+    const uint64_t *args,
+    uint32_t nargs,
+    uintptr_t stack_limit,
+    void (*fault)(void *ctx, uint64_t reason),
+    uint64_t *result
+);
+
+#endif
@@ -0,0 +1,381 @@
+#include "Smp.h"
+#include "Memory.h"
+#include "Trace.h"
+#include "Platform/crc32/crc32.h"
+#include "arch/aarch64/cpu.h"
+#include "arch/aarch64/io.h"
+#include "arch/aarch64/irq.h"
+#include "arch/aarch64/psci.h"
+#include "arch/aarch64/timer.h"
+
+/*
+ * OpenCore Mobile – boot-time work scheduler
+ *
+ * See Smp.h.
+ *
+ * The deques are Chase-Lev (fixed size, no growing): the owner pushes
+ * and takes at `bottom` without contention, thieves CAS `top`, and the
+ * two only race for the last task. The ordering follows Lê et al.,
+ * "Correct and Efficient Work-Stealing for Weak Memory Models".
+ *
+ * Secondaries are only started when the boot CPU has its MMU and data
+ * cache on: with them off every access is Device memory, where the
+ * exclusives all of this relies on are not guaranteed to work. Each
+ * starts in the boot CPU's translation regime (same tables, same
+ * attributes), so the cores see one coherent identity-mapped world.
+ */
+
+#ifndef SMP_STACK_SIZE
+#define SMP_STACK_SIZE          (32u << 10)
+#endif
+
+#ifndef SMP_ARENA_SIZE
+#define SMP_ARENA_SIZE          (1u << 20)      /* per secondary */
+#endif
+
+#define SMP_DEQUE_SIZE          256             /* power of two */
+
+/* a core that has not checked in by then is left alone */
+#define SMP_CPU_ON_TIMEOUT_US   100000
+
+/* below this a buffer's CRC is quicker on one core than split up */
+#define SMP_CRC_MIN             (1u << 20)
+#define SMP_CRC_ALIGN           64
+
+/* Read by smp.s with caches off; keep the layout in step with it */
+typedef struct {
+    u64 mair;
+    u64 tcr;
+    u64 ttbr0;
+    u64 sctlr;
+    u64 stack_top;
+    u64 cpu;                    /* index, for cpu_index() */
+} smp_boot_ctx_t;
+
+typedef struct {
+    smp_boot_ctx_t boot;
+    u64 mpidr;
+    u32 online;
+
+    /* thieves and owner on separate lines */
+    s64 top __attribute__((aligned(64)));
+    s64 bottom __attribute__((aligned(64)));
+    smp_task_t *slots[SMP_DEQUE_SIZE];
+} __attribute__((aligned(64))) smp_cpu_t;
+
+_Static_assert(__builtin_offsetof(smp_boot_ctx_t, stack_top) == 32, "smp.s CTX_STACK");
+
+extern void smp_secondary_entry(void);
+extern char stack_base[];
+void smp_secondary_main(smp_boot_ctx_t *ctx);
+
+static smp_cpu_t cpus[OCM_MAX_CPUS];
+static u32 cpu_count = 1;
+static bool started;
+
+/* ===== deque ===== */
+
+static bool deque_push(smp_cpu_t *c, smp_task_t *task) {
+    s64 b = __atomic_load_n(&c->bottom, __ATOMIC_RELAXED);
+    s64 t = __atomic_load_n(&c->top, __ATOMIC_ACQUIRE);
+
+    if (b - t >= SMP_DEQUE_SIZE)
+        return false;
+    __atomic_store_n(&c->slots[b & (SMP_DEQUE_SIZE - 1)], task, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&c->bottom, b + 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+/* Owner only: newest first */
+static smp_task_t *deque_take(smp_cpu_t *c) {
+    s64 b = __atomic_load_n(&c->bottom, __ATOMIC_RELAXED) - 1;
+
+    __atomic_store_n(&c->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    s64 t = __atomic_load_n(&c->top, __ATOMIC_RELAXED);
+
+    if (t > b) {
+        __atomic_store_n(&c->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    smp_task_t *task = __atomic_load_n(&c->slots[b & (SMP_DEQUE_SIZE - 1)], __ATOMIC_RELAXED);
+    if (t == b) {
+        /* the last one: whoever moves top gets it */
+        if (!__atomic_compare_exchange_n(&c->top, &t, t + 1, false,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            task = NULL;
+        __atomic_store_n(&c->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return task;
+}
+
+/* Anyone: oldest first; NULL when empty or when another thief won */
+static smp_task_t *deque_steal(smp_cpu_t *c) {
+    s64 t = __atomic_load_n(&c->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    s64 b = __atomic_load_n(&c->bottom, __ATOMIC_ACQUIRE);
+
+    if (t >= b)
+        return NULL;
+
+    smp_task_t *task = __atomic_load_n(&c->slots[t & (SMP_DEQUE_SIZE - 1)], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&c->top, &t, t + 1, false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return NULL;
+    return task;
+}
+
+/* ===== running work ===== */
+
+static smp_task_t *find_work(u32 self) {
+    smp_task_t *task = deque_take(&cpus[self]);
+    u32 n = __atomic_load_n(&cpu_count, __ATOMIC_ACQUIRE);
+
+    for (u32 i = 1; !task && i < n; i++)
+        task = deque_steal(&cpus[(self + i) % n]);
+    return task;
+}
+
+static void run(smp_task_t *task) {
+    /* the waiter may reuse the task as soon as pending drops */
+    smp_group_t *group = task->group;
+
+    task->fn(task->arg);
+    __atomic_sub_fetch(&group->pending, 1, __ATOMIC_RELEASE);
+    cpu_sev();
+}
+
+void smp_spawn(smp_group_t *group, smp_task_t *task, void (*fn)(void *arg), void *arg) {
+    task->fn = fn;
+    task->arg = arg;
+    task->group = group;
+    __atomic_add_fetch(&group->pending, 1, __ATOMIC_RELAXED);
+
+    if (cpu_count == 1 || !deque_push(&cpus[cpu_index()], task)) {
+        run(task);
+        return;
+    }
+    cpu_sev();
+}
+
+void smp_wait(smp_group_t *group) {
+    u32 self = cpu_index();
+
+    while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE)) {
+        smp_task_t *task = find_work(self);
+
+        if (task)
+            run(task);
+        else
+            cpu_wfe();          /* a finishing task sevs */
+    }
+}
+
+u32 smp_cpu_count(void) {
+    return cpu_count;
+}
+
+uintptr_t smp_stack_base(void) {
+    u32 cpu = cpu_index();
+
+    if (cpu == 0)
+        return (uintptr_t)stack_base;
+    return (uintptr_t)cpus[cpu].boot.stack_top - SMP_STACK_SIZE;
+}
+
+/* ===== bring-up ===== */
+
+void smp_secondary_main(smp_boot_ctx_t *ctx) {
+    u32 self = (u32)ctx->cpu;
+
+    cpu_set_index(self);
+    irq_init_secondary();
+
+    __atomic_store_n(&cpus[self].online, 1, __ATOMIC_RELEASE);
+    cpu_sev();
+
+    for (;;) {
+        smp_task_t *task = find_work(self);
+
+        if (task)
+            run(task);
+        else
+            cpu_wfe();
+    }
+}
+
+/* The boot CPU's MMU setup, for secondaries to copy; false if it is off */
+static bool capture_regime(smp_boot_ctx_t *b) {
+#if defined(__aarch64__)
+    if (cpu_current_el() == 2) {
+        __asm__ volatile ("mrs %0, MAIR_EL2" : "=r"(b->mair));
+        __asm__ volatile ("mrs %0, TCR_EL2" : "=r"(b->tcr));
+        __asm__ volatile ("mrs %0, TTBR0_EL2" : "=r"(b->ttbr0));
+        __asm__ volatile ("mrs %0, SCTLR_EL2" : "=r"(b->sctlr));
+    } else {
+        __asm__ volatile ("mrs %0, MAIR_EL1" : "=r"(b->mair));
+        __asm__ volatile ("mrs %0, TCR_EL1" : "=r"(b->tcr));
+        __asm__ volatile ("mrs %0, TTBR0_EL1" : "=r"(b->ttbr0));
+        __asm__ volatile ("mrs %0, SCTLR_EL1" : "=r"(b->sctlr));
+    }
+    return (b->sctlr & 0x5) == 0x5;     /* M and C */
+#else
+    (void)b;
+    return false;
+#endif
+}
+
+static void start_cpu(u64 mpidr) {
+    if (psci_call(PSCI_AFFINITY_INFO, mpidr, 0, 0) != PSCI_AFFINITY_OFF)
+        return;                 /* no such core, or already running something */
+
+    void *stack = boot_alloc(SMP_STACK_SIZE);
+    void *arena = boot_alloc(SMP_ARENA_SIZE);
+    if (!stack || !arena) {
+        boot_free(stack, SMP_STACK_SIZE);
+        return;
+    }
+
+    u32 index = cpu_count;
+    smp_cpu_t *c = &cpus[index];
+
+    c->boot = cpus[0].boot;
+    c->boot.stack_top = (u64)(uintptr_t)stack + SMP_STACK_SIZE;
+    c->boot.cpu = index;
+    c->mpidr = mpidr;
+    arena_attach_cpu(index, arena, SMP_ARENA_SIZE);
+
+    /* it reads all of this before its caches are on */
+    dcache_flush_range(c, sizeof(*c));
+
+    if (psci_call(PSCI_CPU_ON, mpidr, (u64)(uintptr_t)smp_secondary_entry,
+                  (u64)(uintptr_t)&c->boot) != PSCI_SUCCESS) {
+        /* the slot stays free for the next core; newest block first */
+        arena_attach_cpu(index, NULL, 0);
+        boot_free(arena, SMP_ARENA_SIZE);
+        boot_free(stack, SMP_STACK_SIZE);
+        return;
+    }
+
+    /* from here the slot is taken, even if the core turns up late */
+    __atomic_store_n(&cpu_count, index + 1, __ATOMIC_RELEASE);
+
+    u64 deadline = timer_ticks() + timer_us_to_ticks(SMP_CPU_ON_TIMEOUT_US);
+    while (!__atomic_load_n(&c->online, __ATOMIC_ACQUIRE)) {
+        if (timer_ticks() >= deadline) {
+            printf("smp: cpu %llx did not come up\n", mpidr);
+            return;
+        }
+        cpu_relax();
+    }
+}
+
+u32 smp_init(void) {
+    if (started)
+        return cpu_count;
+    started = true;
+
+    memset(cpus, 0, sizeof(cpus));
+    cpu_count = 1;
+    cpus[0].mpidr = cpu_affinity();
+    cpus[0].online = 1;
+
+    /* lazily built tables must not be built by two cores at once */
+    crc32_init();
+
+    if (!capture_regime(&cpus[0].boot)) {
+        puts("smp: MMU or caches off, staying on the boot CPU\n");
+        return 1;
+    }
+
+    /* CPU_ON and AFFINITY_INFO as used here need PSCI 0.2 */
+    s64 version = psci_call(PSCI_VERSION, 0, 0, 0);
+    if ((s32)version < 2)
+        return 1;
+
+    trace_begin("smp");
+
+    /* every core in the boot CPU's Aff3/Aff2 group, either MPIDR layout */
+    u64 group = cpus[0].mpidr & ~(u64)0xFFFF;
+    for (u64 aff1 = 0; aff1 < 8 && cpu_count < OCM_MAX_CPUS; aff1++) {
+        for (u64 aff0 = 0; aff0 < 8 && cpu_count < OCM_MAX_CPUS; aff0++) {
+            u64 mpidr = group | aff1 << 8 | aff0;
+            if (mpidr != cpus[0].mpidr)
+                start_cpu(mpidr);
+        }
+    }
+
+    trace_end("smp", cpu_count);
+    return cpu_count;
+}
+
+/* ===== helpers ===== */
+
+typedef struct {
+    void (*fn)(void *ctx, u32 index);
+    void *ctx;
+    u32 count;
+    u32 next;
+} range_job_t;
+
+/* Each worker claims indices until none are left, so uneven items balance out */
+static void range_worker(void *arg) {
+    range_job_t *job = arg;
+    u32 i;
+
+    while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->count)
+        job->fn(job->ctx, i);
+}
+
+void smp_parallel_for(u32 count, void (*fn)(void *ctx, u32 index), void *ctx) {
+    range_job_t job = { fn, ctx, count, 0 };
+    smp_task_t tasks[OCM_MAX_CPUS];
+    smp_group_t group = SMP_GROUP_INIT;
+    u32 helpers = (count < cpu_count ? count : cpu_count);
+
+    for (u32 i = 1; i < helpers; i++)
+        smp_spawn(&group, &tasks[i], range_worker, &job);
+
+    range_worker(&job);
+    smp_wait(&group);
+}
+
+typedef struct {
+    const u8 *data;
+    size_t size;
+    size_t piece;
+    u32 crc[OCM_MAX_CPUS];
+} crc_job_t;
+
+static void crc_piece(void *ctx, u32 index) {
+    crc_job_t *job = ctx;
+    size_t offset = (size_t)index * job->piece;
+    size_t len = job->size - offset < job->piece ? job->size - offset : job->piece;
+
+    job->crc[index] = crc32_calculate(job->data + offset, len);
+}
+
+u32 smp_crc32(const void *data, size_t size) {
+    u32 n = cpu_count;
+
+    if (n == 1 || size < SMP_CRC_MIN)
+        return crc32_calculate(data, size);
+
+    crc_job_t job;
+    job.data = data;
+    job.size = size;
+    job.piece = ((size + n - 1) / n + SMP_CRC_ALIGN - 1) & ~(size_t)(SMP_CRC_ALIGN - 1);
+
+    u32 pieces = (u32)((size + job.piece - 1) / job.piece);
+    smp_parallel_for(pieces, crc_piece, &job);
+
+    u32 crc = job.crc[0];
+    for (u32 i = 1; i < pieces; i++) {
+        size_t offset = (size_t)i * job.piece;
+        size_t len = size - offset < job.piece ? size - offset : job.piece;
+        crc = crc32_combine(crc, job.crc[i], len);
+    }
+    return crc;
+}
@@ -0,0 +1,63 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include "bootstd.h"
+
+/*
+ * OpenCore Mobile – boot-time work scheduler
+ *
+ * smp_init() starts the secondary cores through PSCI CPU_ON. Every core
+ * then owns a work-stealing deque: smp_spawn() pushes onto the caller's
+ * own, idle cores steal from the far end of the others' and sleep in wfe
+ * when there is nothing to take. A core waiting in smp_wait() runs
+ * queued work (its own first, then anyone's) instead of idling, so
+ * waits can nest and a task may spawn and wait itself.
+ *
+ * Tasks and groups belong to the caller and nothing is allocated per
+ * spawn; a task must stay valid until its group has been waited for.
+ * All of it degrades to running tasks inline on the boot CPU when there
+ * are no secondaries, so callers never need two code paths.
+ *
+ * Work runs on whichever core takes it, with that core's arena
+ * (Memory.h) and without interrupts or sleeping waits (Event.h spins
+ * there). Devices and other state without their own locking must be
+ * touched by one task at a time: probe different disks in parallel, not
+ * one disk from two tasks.
+ */
+
+typedef struct smp_group {
+    u32 pending;                /* spawned, not yet finished */
+} smp_group_t;
+
+typedef struct smp_task {
+    void (*fn)(void *arg);
+    void *arg;
+    smp_group_t *group;
+} smp_task_t;
+
+#define SMP_GROUP_INIT          { 0 }
+
+/* Bring up the secondaries; returns the number of cores in use (>= 1) */
+u32 smp_init(void);
+
+u32 smp_cpu_count(void);
+
+/* Lowest address of the calling core's stack (entry.s's on the boot CPU) */
+uintptr_t smp_stack_base(void);
+
+/* Queue fn(arg) in `group` (runs it right away if the deque is full) */
+void smp_spawn(smp_group_t *group, smp_task_t *task, void (*fn)(void *arg), void *arg);
+
+/* Help out until everything spawned in `group` has finished */
+void smp_wait(smp_group_t *group);
+
+/* fn(ctx, i) for every i < count, spread over the cores; returns when all are done */
+void smp_parallel_for(u32 count, void (*fn)(void *ctx, u32 index), void *ctx);
+
+/*
+ * CRC-32 (crc32_calculate()) of one large buffer, cut into a piece per
+ * core and joined with crc32_combine(). Small buffers stay on the caller.
+ */
+u32 smp_crc32(const void *data, size_t size);
+
+#endif /* SMP_H */
@@ -0,0 +1,436 @@
+#include "bootstd.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+
+#include "arch/aarch64/cpu.h"
+#endif
+
+/*
+ * OpenCore Mobile – boot-time string library
+ *
+ * One implementation of memcpy/memset/memcmp for the loader, the plist
+ * parser and the partition drivers.
+ *
+ * Alignment rules (important before the MMU is on, when all memory is
+ * Device memory and any access not aligned to its element size faults):
+ *  - 16-byte LDP/STP are only used when both sides are 16-byte aligned
+ *  - otherwise bulk copies use NEON LD1/ST1 with byte elements
+ *  - DC ZVA is only used once the MMU is on (it always faults on Device)
+ *  - word-at-a-time compares only run on mutually aligned pointers
+ *
+ * The NEON paths need FP/SIMD enabled (see arch/aarch64/entry.s).
+ */
+
+/* never let the compiler turn the byte loops below back into calls to us */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize ("no-tree-loop-distribute-patterns")
+#endif
+
+#define WORD_SIZE       sizeof(u64)
+#define WORD_MASK       (WORD_SIZE - 1)
+
+/* below this a plain STP loop beats the DC ZVA setup */
+#define ZVA_MIN_BYTES   256
+
+/* =========================
+ *  Small helpers
+ * ========================= */
+
+static inline u64 load64(const u8 *p) {
+    u64 v;
+    __builtin_memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void store64(u8 *p, u64 v) {
+    __builtin_memcpy(p, &v, sizeof(v));
+}
+
+static inline void copy_bytes(u8 *d, const u8 *s, size_t n) {
+    while (n--)
+        *d++ = *s++;
+}
+
+static inline void set_bytes(u8 *d, u8 v, size_t n) {
+    while (n--)
+        *d++ = v;
+}
+
+/* =========================
+ *  DC ZVA probing (aarch64)
+ * ========================= */
+
+#if defined(__aarch64__)
+
+#define ZVA_UNPROBED    ((size_t)-1)
+
+/*
+ * Per core: DCZID_EL0 and whether the MMU is on are that core's, and
+ * nothing promises a big.LITTLE part the same block size everywhere.
+ * In .data, not .bss, which entry.s doesn't clear.
+ */
+static size_t zva_block[OCM_MAX_CPUS] = { [0 ... OCM_MAX_CPUS - 1] = ZVA_UNPROBED };
+
+static size_t probe_zva_block(void) {
+    u64 dczid, el, sctlr;
+
+    __asm__ volatile ("mrs %0, DCZID_EL0" : "=r"(dczid));
+    if (dczid & (1u << 4))           /* DZP: DC ZVA prohibited */
+        return 0;
+
+    __asm__ volatile ("mrs %0, CurrentEL" : "=r"(el));
+    if (((el >> 2) & 3) == 2)
+        __asm__ volatile ("mrs %0, SCTLR_EL2" : "=r"(sctlr));
+    else
+        __asm__ volatile ("mrs %0, SCTLR_EL1" : "=r"(sctlr));
+
+    if (!(sctlr & 1))                /* MMU off: memory is Device */
+        return 0;
+
+    return (size_t)4 << (dczid & 0xF);
+}
+
+static inline size_t zva_block_size(void) {
+    u32 cpu = cpu_index();
+
+    if (cpu >= OCM_MAX_CPUS)
+        return probe_zva_block();
+    if (zva_block[cpu] == ZVA_UNPROBED)
+        zva_block[cpu] = probe_zva_block();
+    return zva_block[cpu];
+}
+
+#endif
+
+/* =========================
+ *  memcpy
+ * ========================= */
+
+void *memcpy(void *dst, const void *src, size_t n) {
+    u8 *d = (u8 *)dst;
+    const u8 *s = (const u8 *)src;
+
+    if (n < 16) {
+        copy_bytes(d, s, n);
+        return dst;
+    }
+
+#if defined(__aarch64__)
+    /* align the destination so no store ever straddles a line */
+    size_t head = (size_t)(-(uintptr_t)d & 15);
+    copy_bytes(d, s, head);
+    d += head;
+    s += head;
+    n -= head;
+
+    if (n >= 64 && ((uintptr_t)s & 15) == 0) {
+        __asm__ volatile (
+            "1: ldp q0, q1, [%[s]]\n"
+            "   ldp q2, q3, [%[s], #32]\n"
+            "   add %[s], %[s], #64\n"
+            "   sub %[n], %[n], #64\n"
+            "   stp q0, q1, [%[d]]\n"
+            "   stp q2, q3, [%[d], #32]\n"
+            "   add %[d], %[d], #64\n"
+            "   cmp %[n], #64\n"
+            "   b.hs 1b\n"
+            : [d] "+r"(d), [s] "+r"(s), [n] "+r"(n)
+            :
+            : "v0", "v1", "v2", "v3", "cc", "memory");
+    }
+
+    while (n >= 64) {
+        uint8x16_t a = vld1q_u8(s);
+        uint8x16_t b = vld1q_u8(s + 16);
+        uint8x16_t c = vld1q_u8(s + 32);
+        uint8x16_t e = vld1q_u8(s + 48);
+        vst1q_u8(d, a);
+        vst1q_u8(d + 16, b);
+        vst1q_u8(d + 32, c);
+        vst1q_u8(d + 48, e);
+        d += 64;
+        s += 64;
+        n -= 64;
+    }
+
+    while (n >= 16) {
+        vst1q_u8(d, vld1q_u8(s));
+        d += 16;
+        s += 16;
+        n -= 16;
+    }
+#else
+    if ((((uintptr_t)d ^ (uintptr_t)s) & WORD_MASK) == 0) {
+        size_t head = (size_t)(-(uintptr_t)d & WORD_MASK);
+        copy_bytes(d, s, head);
+        d += head;
+        s += head;
+        n -= head;
+
+        while (n >= WORD_SIZE) {
+            store64(d, load64(s));
+            d += WORD_SIZE;
+            s += WORD_SIZE;
+            n -= WORD_SIZE;
+        }
+    }
+#endif
+
+    copy_bytes(d, s, n);
+    return dst;
+}
+
+/* =========================
+ *  memset
+ * ========================= */
+
+void *memset(void *dst, int val, size_t n) {
+    u8 *d = (u8 *)dst;
+    u8 v = (u8)val;
+
+    if (n < 16) {
+        set_bytes(d, v, n);
+        return dst;
+    }
+
+#if defined(__aarch64__)
+    size_t head = (size_t)(-(uintptr_t)d & 15);
+    set_bytes(d, v, head);
+    d += head;
+    n -= head;
+
+    uint8x16_t q = vdupq_n_u8(v);
+
+    if (v == 0 && n >= ZVA_MIN_BYTES) {
+        size_t block = zva_block_size();
+
+        if (block && n >= 2 * block) {
+            /* STP up to the first ZVA block, then zero whole blocks */
+            while ((uintptr_t)d & (block - 1)) {
+                vst1q_u8(d, q);
+                d += 16;
+                n -= 16;
+            }
+
+            while (n >= block) {
+                __asm__ volatile ("dc zva, %0" : : "r"(d) : "memory");
+                d += block;
+                n -= block;
+            }
+        }
+    }
+
+    while (n >= 64) {
+        __asm__ volatile (
+            "stp %q[q], %q[q], [%[d]]\n"
+            "stp %q[q], %q[q], [%[d], #32]\n"
+            :
+            : [d] "r"(d), [q] "w"(q)
+            : "memory");
+        d += 64;
+        n -= 64;
+    }
+
+    while (n >= 16) {
+        vst1q_u8(d, q);
+        d += 16;
+        n -= 16;
+    }
+#else
+    size_t head = (size_t)(-(uintptr_t)d & WORD_MASK);
+    set_bytes(d, v, head);
+    d += head;
+    n -= head;
+
+    u64 pattern = 0x0101010101010101ULL * v;
+    while (n >= WORD_SIZE) {
+        store64(d, pattern);
+        d += WORD_SIZE;
+        n -= WORD_SIZE;
+    }
+#endif
+
+    set_bytes(d, v, n);
+    return dst;
+}
+
+/* =========================
+ *  memcmp
+ * ========================= */
+
+int memcmp(const void *a, const void *b, size_t n) {
+    const u8 *p = (const u8 *)a;
+    const u8 *q = (const u8 *)b;
+
+    if (n >= 2 * WORD_SIZE &&
+        (((uintptr_t)p ^ (uintptr_t)q) & WORD_MASK) == 0) {
+        while ((uintptr_t)p & WORD_MASK) {
+            if (*p != *q)
+                return *p - *q;
+            p++;
+            q++;
+            n--;
+        }
+
+        while (n >= WORD_SIZE) {
+            u64 x = load64(p);
+            u64 y = load64(q);
+
+            if (x != y) {
+                /* little-endian: lowest set bit is the first differing byte */
+                unsigned shift = (unsigned)__builtin_ctzll(x ^ y) & ~7u;
+                return (int)((x >> shift) & 0xFF) - (int)((y >> shift) & 0xFF);
+            }
+
+            p += WORD_SIZE;
+            q += WORD_SIZE;
+            n -= WORD_SIZE;
+        }
+    }
+
+    while (n--) {
+        if (*p != *q)
+            return *p - *q;
+        p++;
+        q++;
+    }
+
+    return 0;
+}
+
+/* =========================
+ *  C strings
+ * ========================= */
+
+size_t strlen(const char *s) {
+    const char *p = s;
+    while (*p)
+        p++;
+    return (size_t)(p - s);
+}
+
+int strcmp(const char *a, const char *b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return (u8)*a - (u8)*b;
+}
+
+int strncmp(const char *a, const char *b, size_t n) {
+    while (n && *a && *a == *b) {
+        a++;
+        b++;
+        n--;
+    }
+    return n ? (u8)*a - (u8)*b : 0;
+}
+
+char *strstr(const char *haystack, const char *needle) {
+    size_t len = strlen(needle);
+
+    if (len == 0)
+        return (char *)haystack;
+
+    for (; *haystack; haystack++) {
+        if (*haystack == *needle && strncmp(haystack, needle, len) == 0)
+            return (char *)haystack;
+    }
+    return NULL;
+}
+
+/* =========================
+ *  Benchmark (real hardware only)
+ * ========================= */
+
+#ifdef OCM_BENCH
+
+#define BENCH_MAX   (64 * 1024)
+#define BENCH_ITERS 64
+
+static u8 bench_src[BENCH_MAX + 64] __attribute__((aligned(64)));
+static u8 bench_dst[BENCH_MAX + 64] __attribute__((aligned(64)));
+
+static const size_t bench_sizes[] = {
+    16, 64, 256, 512, 4096, 16384, BENCH_MAX
+};
+
+#if defined(__aarch64__)
+static void bench_enable_cycle_counter(void) {
+    u64 pmcr;
+    __asm__ volatile ("mrs %0, PMCR_EL0" : "=r"(pmcr));
+    pmcr |= 1;                                   /* E: enable counters */
+    __asm__ volatile ("msr PMCR_EL0, %0" : : "r"(pmcr));
+    __asm__ volatile ("msr PMCNTENSET_EL0, %0" : : "r"(1ULL << 31));
+    __asm__ volatile ("isb");
+}
+
+static inline u64 bench_cycles(void) {
+    u64 c;
+    __asm__ volatile ("isb; mrs %0, PMCCNTR_EL0" : "=r"(c));
+    return c;
+}
+#else
+static void bench_enable_cycle_counter(void) {
+}
+
+static inline u64 bench_cycles(void) {
+    return 0;
+}
+#endif
+
+/* bytes per 100 cycles, so %u is enough to print it */
+static u32 bench_rate(size_t size, u64 cycles) {
+    if (cycles == 0)
+        return 0;
+    return (u32)((u64)size * BENCH_ITERS * 100 / cycles);
+}
+
+void string_bench(void) {
+    bench_enable_cycle_counter();
+
+    for (size_t i = 0; i < BENCH_MAX + 64; i++)
+        bench_src[i] = (u8)(i * 131);
+
+    printf("string_bench: bytes/100 cycles (aligned, src+3)\n");
+
+    for (size_t i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++) {
+        size_t sz = bench_sizes[i];
+        u64 t0, cpy, cpy_un, set, zero, cmp;
+
+        t0 = bench_cycles();
+        for (int it = 0; it < BENCH_ITERS; it++)
+            memcpy(bench_dst, bench_src, sz);
+        cpy = bench_cycles() - t0;
+
+        t0 = bench_cycles();
+        for (int it = 0; it < BENCH_ITERS; it++)
+            memcpy(bench_dst, bench_src + 3, sz);
+        cpy_un = bench_cycles() - t0;
+
+        t0 = bench_cycles();
+        for (int it = 0; it < BENCH_ITERS; it++)
+            memset(bench_dst, 0x5A, sz);
+        set = bench_cycles() - t0;
+
+        t0 = bench_cycles();
+        for (int it = 0; it < BENCH_ITERS; it++)
+            memset(bench_dst, 0, sz);
+        zero = bench_cycles() - t0;
+
+        memcpy(bench_dst, bench_src, sz);
+        t0 = bench_cycles();
+        for (int it = 0; it < BENCH_ITERS; it++)
+            (void)memcmp(bench_dst, bench_src, sz);
+        cmp = bench_cycles() - t0;
+
+        printf("  %u: memcpy %u/%u memset %u zero %u memcmp %u\n",
+               (u32)sz,
+               bench_rate(sz, cpy), bench_rate(sz, cpy_un),
+               bench_rate(sz, set), bench_rate(sz, zero),
+               bench_rate(sz, cmp));
+    }
+}
+
+#endif /* OCM_BENCH */
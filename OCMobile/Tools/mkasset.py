@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+"""
+Pre-pack a PNG into an OCM asset (see OCMobile/Image.h): rows already in
+the panel's pixel format, LZ4-compressed in independent blocks, so the
+loader draws it with one decompression pass instead of a PNG decode.
+
+    Tools/mkasset.py opencore-picker.png --bpp 32            # -> opencore-picker.asset
+    Tools/mkasset.py icon.png --bpp 16 --background 101820
+
+Images with transparency stay premultiplied ARGB8888 (blended at draw
+time) unless --background flattens them into the opaque native format.
+"""
+
+import argparse
+import struct
+import zlib
+from pathlib import Path
+
+ASSET_MAGIC = b"OCMASSET"
+ASSET_VERSION = 1
+ASSET_ARGB8888, ASSET_XRGB8888, ASSET_RGB565 = 1, 2, 3
+ASSET_BLOCK_MAX = 64 << 10
+ASSET_HEADER = struct.Struct("<8sIIIIII")
+
+PNG_SIGNATURE = b"\x89PNG\r\n\x1a\n"
+PNG_CHANNELS = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}
+
+# ---------- PNG ----------
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def unfilter(data, height, stride, bpp):
+    rows, prev, pos = [], bytearray(stride), 0
+    for _ in range(height):
+        kind = data[pos]
+        cur = bytearray(data[pos + 1:pos + 1 + stride])
+        pos += stride + 1
+        if kind == 1:
+            for i in range(bpp, stride):
+                cur[i] = (cur[i] + cur[i - bpp]) & 0xFF
+        elif kind == 2:
+            for i in range(stride):
+                cur[i] = (cur[i] + prev[i]) & 0xFF
+        elif kind == 3:
+            for i in range(stride):
+                left = cur[i - bpp] if i >= bpp else 0
+                cur[i] = (cur[i] + ((left + prev[i]) >> 1)) & 0xFF
+        elif kind == 4:
+            for i in range(stride):
+                left = cur[i - bpp] if i >= bpp else 0
+                up_left = prev[i - bpp] if i >= bpp else 0
+                cur[i] = (cur[i] + paeth(left, prev[i], up_left)) & 0xFF
+        elif kind != 0:
+            raise SystemExit("bad PNG filter type %d" % kind)
+        rows.append(cur)
+        prev = cur
+    return rows
+
+
+def samples(row, count, depth):
+    if depth == 8:
+        return list(row[:count])
+    if depth == 16:
+        return [row[2 * i] << 8 | row[2 * i + 1] for i in range(count)]
+    mask, out = (1 << depth) - 1, []
+    for i in range(count):
+        bit = i * depth
+        out.append((row[bit >> 3] >> (8 - depth - (bit & 7))) & mask)
+    return out
+
+
+def read_png(path):
+    """(width, height, rows of straight (r, g, b, a) tuples, 8 bits each)."""
+    data = Path(path).read_bytes()
+    if not data.startswith(PNG_SIGNATURE):
+        raise SystemExit("%s: not a PNG" % path)
+
+    pos, idat, palette, trns = 8, bytearray(), [], None
+    while pos < len(data):
+        length, kind = struct.unpack_from(">I4s", data, pos)
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            width, height, depth, color, _, _, interlace = struct.unpack(">IIBBBBB", body)
+            if interlace:
+                raise SystemExit("%s: interlaced PNGs are not supported" % path)
+        elif kind == b"PLTE":
+            palette = [tuple(body[i:i + 3]) + (255,) for i in range(0, len(body), 3)]
+        elif kind == b"tRNS":
+            trns = body
+        elif kind == b"IDAT":
+            idat += body
+        elif kind == b"IEND":
+            break
+
+    channels = PNG_CHANNELS[color]
+    stride = (width * channels * depth + 7) // 8
+    rows = unfilter(zlib.decompress(bytes(idat)), height, stride, max(1, channels * depth // 8))
+
+    if color == 3 and trns:
+        palette = [p[:3] + (trns[i] if i < len(trns) else 255,) for i, p in enumerate(palette)]
+    key = None
+    if trns and color in (0, 2):
+        key = struct.unpack(">%dH" % (len(trns) // 2), trns)
+
+    scale = (lambda v: v >> 8) if depth == 16 else (lambda v: v * 255 // ((1 << depth) - 1))
+    pixels = []
+    for row in rows:
+        s = samples(row, width * channels, depth)
+        out = []
+        for x in range(width):
+            px = s[x * channels:(x + 1) * channels]
+            if color == 3:
+                out.append(palette[px[0]] if px[0] < len(palette) else (0, 0, 0, 0))
+                continue
+            alpha = 0 if key is not None and tuple(px[:len(key)]) == key else 255
+            if color == 0:
+                out.append((scale(px[0]),) * 3 + (alpha,))
+            elif color == 2:
+                out.append(tuple(scale(v) for v in px) + (alpha,))
+            elif color == 4:
+                out.append((scale(px[0]),) * 3 + (scale(px[1]),))
+            else:
+                out.append(tuple(scale(v) for v in px))
+        pixels.append(out)
+    return width, height, pixels
+
+# ---------- LZ4 ----------
+
+def lz4_sequence(out, literals, offset, match):
+    lit = len(literals)
+    token = min(lit, 15) << 4 | (min(match - 4, 15) if match else 0)
+    out.append(token)
+    if lit >= 15:
+        rest = lit - 15
+        while rest >= 255:
+            out.append(255)
+            rest -= 255
+        out.append(rest)
+    out += literals
+    if not match:
+        return
+    out += struct.pack("<H", offset)
+    if match - 4 >= 15:
+        rest = match - 4 - 15
+        while rest >= 255:
+            out.append(255)
+            rest -= 255
+        out.append(rest)
+
+
+def lz4_compress(src):
+    """Greedy LZ4 block; honours the format's end-of-block literal rules."""
+    n, out, table = len(src), bytearray(), {}
+    anchor = i = 0
+    last_match = n - 12             # no match may start after this
+    while i < last_match:
+        key = src[i:i + 4]
+        cand = table.get(key)
+        table[key] = i
+        if cand is None or i - cand > 0xFFFF:
+            i += 1
+            continue
+        length, limit = 4, n - 5 - i  # the last 5 bytes stay literals
+        while length < limit and src[cand + length] == src[i + length]:
+            length += 1
+        lz4_sequence(out, src[anchor:i], i - cand, length)
+        for j in range(i + 1, min(i + length, last_match)):
+            table[src[j:j + 4]] = j
+        i += length
+        anchor = i
+    lz4_sequence(out, src[anchor:], 0, 0)
+    return bytes(out)
+
+# ---------- assets ----------
+
+def pack_rows(pixels, fmt, background):
+    bg = ((background >> 16) & 0xFF, (background >> 8) & 0xFF, background & 0xFF)
+    rows = []
+    for row in pixels:
+        out = bytearray()
+        for r, g, b, a in row:
+            if fmt == ASSET_ARGB8888:
+                r, g, b = ((c * a + 127) // 255 for c in (r, g, b))
+                out += struct.pack("<I", a << 24 | r << 16 | g << 8 | b)
+                continue
+            if a != 255:
+                r, g, b = ((c * a + k * (255 - a) + 127) // 255 for c, k in zip((r, g, b), bg))
+            if fmt == ASSET_XRGB8888:
+                out += struct.pack("<I", 0xFF000000 | r << 16 | g << 8 | b)
+            else:
+                out += struct.pack("<H", (r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3)
+        rows.append(bytes(out))
+    return rows
+
+
+def write_asset(png, out, bpp=32, background=None):
+    width, height, pixels = read_png(png)
+    translucent = any(p[3] != 255 for row in pixels for p in row)
+    if translucent and background is None:
+        fmt = ASSET_ARGB8888
+    else:
+        fmt = ASSET_XRGB8888 if bpp == 32 else ASSET_RGB565
+
+    rows = pack_rows(pixels, fmt, background or 0)
+    per_block = max(1, ASSET_BLOCK_MAX // len(rows[0]))
+    if per_block * len(rows[0]) > ASSET_BLOCK_MAX:
+        raise SystemExit("%s: rows too wide for one block" % png)
+
+    blocks = [lz4_compress(b"".join(rows[i:i + per_block])) for i in range(0, height, per_block)]
+    header = ASSET_HEADER.pack(ASSET_MAGIC, ASSET_VERSION, fmt, width, height, per_block, len(blocks))
+    sizes = struct.pack("<%dI" % len(blocks), *(len(b) for b in blocks))
+    Path(out).write_bytes(header + sizes + b"".join(blocks))
+    return fmt
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Pack a PNG into a boot menu asset")
+    ap.add_argument("png")
+    ap.add_argument("-o", "--output", help="default: the PNG's name with .asset")
+    ap.add_argument("--bpp", type=int, choices=(32, 16), default=32,
+                    help="panel depth the opaque formats target")
+    ap.add_argument("--background", type=lambda s: int(s, 16), metavar="RRGGBB",
+                    help="flatten transparency onto this colour")
+    args = ap.parse_args()
+
+    out = args.output or str(Path(args.png).with_suffix(".asset"))
+    fmt = write_asset(args.png, out, args.bpp, args.background)
+    names = {ASSET_ARGB8888: "ARGB8888", ASSET_XRGB8888: "XRGB8888", ASSET_RGB565: "RGB565"}
+    print("%s: %s, %d bytes" % (out, names[fmt], Path(out).stat().st_size))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""
+Rasterize a monospace TrueType font into Font8x16.h, the glyph source the
+framebuffer text console builds its atlas from (see Framebuffer.c).
+
+Printable ASCII only, 8x16 cells, 4 bits of coverage per pixel so the
+atlas can be anti-aliased against any fg/bg pair. Only needed when the
+font changes; the output is checked in.
+
+    Tools/mkfont.py /usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf > Font8x16.h
+"""
+import os
+import struct
+import sys
+
+FIRST, LAST = 0x20, 0x7E
+CELL_W, CELL_H = 8, 16
+SUPERSAMPLE = 4
+
+
+def u16(d, o):
+    return struct.unpack_from(">H", d, o)[0]
+
+
+class Font:
+    """Just enough TrueType: cmap format 4, loca/glyf outlines, hmtx."""
+
+    def __init__(self, path):
+        d = self.d = open(path, "rb").read()
+        self.tables = {}
+        for i in range(u16(d, 4)):
+            tag, _, off, length = struct.unpack_from(">4sIII", d, 12 + 16 * i)
+            self.tables[tag.decode()] = off
+
+        head = self.tables["head"]
+        long_loca = struct.unpack_from(">h", d, head + 50)[0]
+        hhea = self.tables["hhea"]
+        self.ascent, self.descent = struct.unpack_from(">hh", d, hhea + 4)
+        self.advance = u16(d, self.tables["hmtx"])     # monospace: all the same
+
+        count = u16(d, self.tables["maxp"] + 4) + 1
+        loca = self.tables["loca"]
+        if long_loca:
+            self.loca = list(struct.unpack_from(">%dI" % count, d, loca))
+        else:
+            self.loca = [2 * x for x in struct.unpack_from(">%dH" % count, d, loca)]
+        self.cmap = self._cmap()
+
+    def _cmap(self):
+        d, cmap = self.d, self.tables["cmap"]
+        for i in range(u16(d, cmap + 2)):
+            pid, _, off = struct.unpack_from(">HHI", d, cmap + 4 + 8 * i)
+            sub = cmap + off
+            if pid not in (0, 3) or u16(d, sub) != 4:
+                continue
+            seg = u16(d, sub + 6) // 2
+            ends = struct.unpack_from(">%dH" % seg, d, sub + 14)
+            starts = struct.unpack_from(">%dH" % seg, d, sub + 16 + 2 * seg)
+            deltas = struct.unpack_from(">%dh" % seg, d, sub + 16 + 4 * seg)
+            ranges_at = sub + 16 + 6 * seg
+            ranges = struct.unpack_from(">%dH" % seg, d, ranges_at)
+            glyphs = {}
+            for s in range(seg):
+                for c in range(starts[s], min(ends[s], LAST) + 1):
+                    if not ranges[s]:
+                        glyphs[c] = (c + deltas[s]) & 0xFFFF
+                        continue
+                    g = u16(d, ranges_at + 2 * s + ranges[s] + 2 * (c - starts[s]))
+                    glyphs[c] = (g + deltas[s]) & 0xFFFF if g else 0
+            return glyphs
+        raise SystemExit("no unicode cmap")
+
+    def contours(self, glyph, dx=0, dy=0):
+        """Outline of `glyph` as lists of (x, y, on_curve), in font units."""
+        d = self.d
+        if self.loca[glyph] == self.loca[glyph + 1]:
+            return []
+        at = self.tables["glyf"] + self.loca[glyph]
+        ncontours = struct.unpack_from(">h", d, at)[0]
+        p = at + 10
+
+        if ncontours < 0:
+            # composite: offset components only, which is all ASCII uses
+            out = []
+            while True:
+                flags, component = struct.unpack_from(">HH", d, p)
+                p += 4
+                if flags & 0x0001:
+                    x, y = struct.unpack_from(">hh", d, p)
+                    p += 4
+                else:
+                    x, y = struct.unpack_from(">bb", d, p)
+                    p += 2
+                p += 2 if flags & 0x0008 else 4 if flags & 0x0040 else 8 if flags & 0x0080 else 0
+                out += self.contours(component, dx + x, dy + y)
+                if not flags & 0x0020:
+                    return out
+
+        ends = struct.unpack_from(">%dH" % ncontours, d, p)
+        p += 2 * ncontours
+        p += 2 + u16(d, p)                              # skip instructions
+        npoints = ends[-1] + 1 if ncontours else 0
+
+        flags = []
+        while len(flags) < npoints:
+            f = d[p]
+            p += 1
+            flags.append(f)
+            if f & 0x08:
+                flags += [f] * d[p]
+                p += 1
+
+        def coords(short, same):
+            nonlocal p
+            v, out = 0, []
+            for f in flags:
+                if f & short:
+                    v += d[p] if f & same else -d[p]
+                    p += 1
+                elif not f & same:
+                    v += struct.unpack_from(">h", d, p)[0]
+                    p += 2
+                out.append(v)
+            return out
+
+        xs = coords(0x02, 0x10)
+        ys = coords(0x04, 0x20)
+        out, first = [], 0
+        for end in ends:
+            out.append([(xs[i] + dx, ys[i] + dy, flags[i] & 1) for i in range(first, end + 1)])
+            first = end + 1
+        return out
+
+
+def flatten(contour, steps=8):
+    """Closed polyline through a contour of quadratic B-spline segments."""
+    if not contour:
+        return []
+    # make implied on-curve midpoints explicit
+    pts = []
+    for i, a in enumerate(contour):
+        b = contour[(i + 1) % len(contour)]
+        pts.append(a)
+        if not a[2] and not b[2]:
+            pts.append(((a[0] + b[0]) / 2, (a[1] + b[1]) / 2, 1))
+    k = next(i for i, q in enumerate(pts) if q[2])
+    pts = pts[k:] + pts[:k] + [pts[k]]
+
+    out = [pts[0][:2]]
+    i = 0
+    while i < len(pts) - 1:
+        start, ctrl = pts[i], pts[i + 1]
+        if ctrl[2]:
+            out.append(ctrl[:2])
+            i += 1
+            continue
+        end = pts[i + 2]
+        for n in range(1, steps + 1):
+            t = n / steps
+            out.append(((1 - t) ** 2 * start[0] + 2 * (1 - t) * t * ctrl[0] + t * t * end[0],
+                        (1 - t) ** 2 * start[1] + 2 * (1 - t) * t * ctrl[1] + t * t * end[1]))
+        i += 2
+    return out
+
+
+def raster(font, ch, w=CELL_W, h=CELL_H, ss=SUPERSAMPLE):
+    """Coverage (0..1) per pixel: nonzero winding, ss x ss samples each."""
+    polys = [flatten(c) for c in font.contours(font.cmap.get(ord(ch), 0))]
+    scale = h / (font.ascent - font.descent)
+    xoff = (w - font.advance * scale) / 2
+    cov = [[0] * w for _ in range(h)]
+
+    for sy in range(h * ss):
+        fy = font.ascent - (sy + 0.5) / ss / scale
+        crossings = []
+        for poly in polys:
+            for (x0, y0), (x1, y1) in zip(poly, poly[1:]):
+                if y0 <= fy < y1 or y1 <= fy < y0:
+                    x = x0 + (fy - y0) * (x1 - x0) / (y1 - y0)
+                    crossings.append((x * scale + xoff, 1 if y1 > y0 else -1))
+        for sx in range(w * ss):
+            x = (sx + 0.5) / ss
+            if sum(dir for cx, dir in crossings if cx < x):
+                cov[sy // ss][sx // ss] += 1
+    return [[c / (ss * ss) for c in row] for row in cov]
+
+
+def main():
+    if len(sys.argv) != 2:
+        raise SystemExit("usage: mkfont.py FONT.ttf > Font8x16.h")
+    font = Font(sys.argv[1])
+    name = os.path.basename(sys.argv[1])
+    out = sys.stdout
+    out.write("#ifndef FONT8X16_H\n#define FONT8X16_H\n\n")
+    out.write('#include "bootstd.h"\n\n')
+    out.write("/*\n * Generated by Tools/mkfont.py from %s; do not edit.\n" % name)
+    out.write(" *\n * Printable ASCII, %ux%u cells, 4-bit coverage, two pixels per byte\n" % (CELL_W, CELL_H))
+    out.write(" * (left one in the high nibble).\n */\n\n")
+    out.write("#define FONT_FIRST      0x%02X\n#define FONT_LAST       0x%02X\n" % (FIRST, LAST))
+    out.write("#define FONT_WIDTH      %u\n#define FONT_HEIGHT     %u\n\n" % (CELL_W, CELL_H))
+    out.write("static const u8 font_8x16[FONT_LAST - FONT_FIRST + 1][FONT_HEIGHT * FONT_WIDTH / 2] = {\n")
+    for c in range(FIRST, LAST + 1):
+        cov = raster(font, chr(c))
+        data = []
+        for row in cov:
+            levels = [min(15, int(v * 15 + 0.5)) for v in row]
+            data += [levels[i] << 4 | levels[i + 1] for i in range(0, CELL_W, 2)]
+        out.write("    {   /* '%s' */\n" % {"'": "\\'", "\\": "\\\\"}.get(chr(c), chr(c)))
+        for i in range(0, len(data), 16):
+            out.write("        " + " ".join("0x%02x," % b for b in data[i:i + 16]) + "\n")
+        out.write("    },\n")
+    out.write("};\n\n#endif /* FONT8X16_H */\n")
+
+
+if __name__ == "__main__":
+    main()
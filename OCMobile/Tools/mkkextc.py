@@ -0,0 +1,335 @@
+#!/usr/bin/env python3
+"""
+Prelink kexts into one collection for the loader's Kextld, see
+OCMobile/Platform/Kextld.h for the format.
+
+Every kext is linked here, once, at a fixed base address: segments laid
+out page by page, relocations applied, and each reference bound to the
+kext's own definition if it has one, else to the kernel's symbol list
+(`nm` output), else to what the kexts its OSBundleLibraries name export,
+the way Kextld.c binds kexts at boot. The loader then only reads the
+file and, if it ends up somewhere else, adds the slide to each pointer
+listed in the fixups.
+
+Kexts are arm64 MH_KEXT_BUNDLEs with classic relocations (LC_DYSYMTAB),
+the way kxld takes them; images with dyld info or chained fixups are
+refused.
+"""
+
+import argparse
+import plistlib
+import struct
+import sys
+import zlib
+from pathlib import Path
+
+from mksdk import plist_image
+
+KEXTC_MAGIC = b"OCMKEXTC"
+KEXTC_VERSION = 1
+KEXTC_PAGE = 16 << 10
+KEXTC_NONE = (1 << 64) - 1
+HEADER = struct.Struct("<8sIIQQIIIIQQQQQQQQ")
+KEXT = struct.Struct("<IIQQQ")
+SYMBOL = struct.Struct("<IIQ")
+
+# where the kernel keeps its kexts unless told otherwise (--base)
+DEFAULT_BASE = 0xFFFFFFF010000000
+
+MH_MAGIC_64 = 0xFEEDFACF
+FAT_MAGIC = 0xCAFEBABE
+CPU_TYPE_ARM64 = 0x0100000C
+MH_KEXT_BUNDLE = 0xB
+LC_SYMTAB = 0x2
+LC_DYSYMTAB = 0xB
+LC_SEGMENT_64 = 0x19
+LC_DYLD_INFO = 0x22
+LC_DYLD_INFO_ONLY = 0x80000022
+LC_DYLD_CHAINED_FIXUPS = 0x80000034
+VM_PROT_WRITE = 0x2
+N_STAB, N_TYPE, N_EXT, N_SECT = 0xE0, 0x0E, 0x01, 0x0E
+N_WEAK_REF = 0x40
+ARM64_RELOC_UNSIGNED = 0
+ARM64_RELOC_BRANCH26 = 2
+
+# every code kext defines these; they stay its own and out of the symbol table
+KMOD_SYMBOLS = {"_kmod_info", "_kext_apple_cc", "_realmain", "_antimain"}
+MACH_HEADER = struct.Struct("<IiiIIIII")
+SEGMENT = struct.Struct("<16sQQQQiiII")
+SECTION = struct.Struct("<16s16sQQIIIIIIII")
+NLIST = struct.Struct("<IBBHQ")
+
+def fail(msg):
+    sys.exit(f"mkkextc: {msg}")
+
+def align(n, a):
+    return (n + a - 1) & ~(a - 1)
+
+class Kext:
+    def __init__(self, path):
+        self.path = Path(path)
+        contents = self.path / "Contents"
+        if not contents.is_dir():
+            contents = self.path            # iOS-style flat bundle
+        try:
+            self.info = plistlib.loads((contents / "Info.plist").read_bytes())
+        except (OSError, plistlib.InvalidFileException) as e:
+            fail(f"{path}: no readable Info.plist ({e})")
+        self.bundle_id = self.info.get("CFBundleIdentifier")
+        if not isinstance(self.bundle_id, str):
+            fail(f"{path}: no CFBundleIdentifier")
+
+        self.image = None                   # codeless
+        self.exports = {}
+        self.kmod_info = None
+        exe = self.info.get("CFBundleExecutable")
+        if exe:
+            macho = contents / "MacOS" / exe
+            if not macho.exists():
+                macho = contents / exe
+            self.parse(arm64_slice(macho.read_bytes(), macho))
+
+    def parse(self, data):
+        magic, cputype, _, filetype, ncmds, _, _, _ = MACH_HEADER.unpack_from(data, 0)
+        if magic != MH_MAGIC_64 or cputype != CPU_TYPE_ARM64 or filetype != MH_KEXT_BUNDLE:
+            fail(f"{self.path}: not an arm64 kext bundle")
+
+        self.segments, self.symbols = [], []
+        locrel = extrel = (0, 0)
+        off = MACH_HEADER.size
+        for _ in range(ncmds):
+            cmd, size = struct.unpack_from("<II", data, off)
+            if cmd == LC_SEGMENT_64:
+                name, vmaddr, vmsize, fileoff, filesize, _, initprot, nsects, _ = \
+                    SEGMENT.unpack_from(data, off + 8)
+                if filesize > vmsize:
+                    fail(f"{self.path}: segment {name.decode().rstrip(chr(0))} is larger on disk than in memory")
+                for i in range(nsects):
+                    if SECTION.unpack_from(data, off + 8 + SEGMENT.size + i * SECTION.size)[7]:
+                        fail(f"{self.path}: section relocations, not a linked kext")
+                self.segments.append((off, vmaddr, vmsize, fileoff, filesize, initprot, nsects))
+            elif cmd == LC_SYMTAB:
+                symoff, nsyms, stroff, strsize = struct.unpack_from("<IIII", data, off + 8)
+                strings = data[stroff:stroff + strsize]
+                for i in range(nsyms):
+                    strx, type_, sect, desc, value = NLIST.unpack_from(data, symoff + i * NLIST.size)
+                    name = strings[strx:strings.index(b"\0", strx)].decode()
+                    self.symbols.append((name, type_, sect, desc, value))
+            elif cmd == LC_DYSYMTAB:
+                d = struct.unpack_from("<18I", data, off + 8)
+                extrel, locrel = (d[14], d[15]), (d[16], d[17])
+            elif cmd in (LC_DYLD_INFO, LC_DYLD_INFO_ONLY, LC_DYLD_CHAINED_FIXUPS):
+                fail(f"{self.path}: dyld fixups; link kexts with `ld -kext`")
+            off += size
+
+        if not self.segments:
+            fail(f"{self.path}: no segments")
+        self.lowest = min(s[1] for s in self.segments)
+        end = max(s[1] + s[2] for s in self.segments)
+        self.image = bytearray(end - self.lowest)
+        for _, vmaddr, _, fileoff, filesize, _, _ in self.segments:
+            at = vmaddr - self.lowest
+            self.image[at:at + filesize] = data[fileoff:fileoff + filesize]
+
+        # arm64 relocations count from the first writable segment, as in dyld and kxld
+        writable = [s[1] for s in self.segments if s[5] & VM_PROT_WRITE]
+        self.reloc_base = (writable[0] if writable else self.lowest) - self.lowest
+        self.locrel = relocations(data, *locrel)
+        self.extrel = relocations(data, *extrel)
+
+        for name, type_, _, _, value in self.symbols:
+            if type_ & N_STAB or (type_ & N_TYPE) != N_SECT:
+                continue
+            if name == "_kmod_info":
+                self.kmod_info = value - self.lowest
+            if type_ & N_EXT:
+                self.exports[name] = value - self.lowest
+
+    def link(self, address, resolve, fixups):
+        """Relocate the image to run at `address`; pointer offsets go into `fixups`"""
+        image = self.image
+
+        def pointer(at, value):
+            if at + 8 > len(image):
+                fail(f"{self.path}: relocation outside the image")
+            struct.pack_into("<Q", image, at, value & KEXTC_NONE)
+            fixups.append(at)
+
+        for at, info in self.locrel:
+            at += self.reloc_base
+            if info >> 28 != ARM64_RELOC_UNSIGNED or (info >> 25) & 3 != 3 or info & (1 << 27):
+                fail(f"{self.path}: local relocation {info >> 28} unsupported")
+            pointer(at, struct.unpack_from("<Q", image, at)[0] - self.lowest + address)
+
+        for at, info in self.extrel:
+            at += self.reloc_base
+            name, _, _, desc, _ = self.symbols[info & 0xFFFFFF]
+            target = resolve(name)
+            if target is None:
+                if not desc & N_WEAK_REF:
+                    fail(f"{self.path}: undefined symbol {name}")
+                target = 0
+            kind = info >> 28
+            if kind == ARM64_RELOC_UNSIGNED and (info >> 25) & 3 == 3:
+                addend = struct.unpack_from("<q", image, at)[0]
+                if target:
+                    pointer(at, target + addend)
+                else:
+                    # a weak reference to nothing reads as NULL, as at boot
+                    struct.pack_into("<Q", image, at, 0)
+            elif kind == ARM64_RELOC_BRANCH26 and target:
+                disp = target - (address + at)
+                if disp & 3 or not -(1 << 27) <= disp < (1 << 27):
+                    fail(f"{self.path}: {name} is out of branch range from {self.bundle_id}")
+                insn = struct.unpack_from("<I", image, at)[0]
+                struct.pack_into("<I", image, at, (insn & 0xFC000000) | ((disp >> 2) & 0x3FFFFFF))
+            else:
+                fail(f"{self.path}: relocation {kind} against {name} unsupported")
+
+        # the headers say where the kext runs, like a kernelcache's do
+        for off, vmaddr, _, fileoff, _, _, nsects in self.segments:
+            if fileoff != 0:
+                continue
+            for cmd, seg_vmaddr, _, _, _, _, n in self.segments:
+                where = cmd - fileoff + (vmaddr - self.lowest)
+                pointer(where + 24, seg_vmaddr - self.lowest + address)
+                for i in range(n):
+                    sect = where + 8 + SEGMENT.size + i * SECTION.size + 32
+                    pointer(sect, struct.unpack_from("<Q", image, sect)[0] - self.lowest + address)
+            break
+
+def arm64_slice(data, path):
+    if len(data) >= 8 and struct.unpack_from(">I", data, 0)[0] == FAT_MAGIC:
+        for i in range(struct.unpack_from(">I", data, 4)[0]):
+            cputype, _, offset, size, _ = struct.unpack_from(">iiIII", data, 8 + i * 20)
+            if cputype == CPU_TYPE_ARM64:
+                return data[offset:offset + size]
+        fail(f"{path}: no arm64 slice")
+    return data
+
+def relocations(data, offset, count):
+    return [struct.unpack_from("<iI", data, offset + i * 8) for i in range(count)]
+
+def kernel_symbols(path):
+    """`nm` output (address, type, name) or plain address / name pairs"""
+    symbols = {}
+    for line in Path(path).read_text().splitlines():
+        parts = line.split()
+        if len(parts) == 3 and parts[1] not in "Uuvw":
+            symbols.setdefault(parts[2], int(parts[0], 16))
+        elif len(parts) == 2 and len(parts[0]) > 1:     # not "U _name"
+            symbols.setdefault(parts[1], int(parts[0], 16))
+    return symbols
+
+def write_collection(bundles, out, base=DEFAULT_BASE, kernel=None):
+    if base & (KEXTC_PAGE - 1):
+        fail(f"base {base:#x} is not {KEXTC_PAGE // 1024} KiB aligned")
+    kexts = [Kext(b) for b in bundles]
+    kernel = kernel_symbols(kernel) if kernel else {}
+
+    # lay the executables out first, so every kext's exports have addresses
+    offsets, size = [], 0
+    for k in kexts:
+        offsets.append(size if k.image is not None else None)
+        if k.image is not None:
+            size = align(size + len(k.image), KEXTC_PAGE)
+
+    # exports are scoped by owner: two kexts may both define a name
+    by_id = {k.bundle_id: i for i, k in enumerate(kexts)}
+    exports = [(name, i, offsets[i] + value)
+               for i, k in enumerate(kexts)
+               for name, value in k.exports.items() if name not in KMOD_SYMBOLS]
+
+    def resolver(i):
+        k = kexts[i]
+        libs = [by_id[lib] for lib in k.info.get("OSBundleLibraries", {}) if by_id.get(lib, i) != i]
+
+        def resolve(name):
+            if name in k.exports:
+                return base + offsets[i] + k.exports[name]
+            if name in kernel:
+                return kernel[name]
+            for d in libs:
+                if name in kexts[d].exports and name not in KMOD_SYMBOLS:
+                    return base + offsets[d] + kexts[d].exports[name]
+            return None
+        return resolve
+
+    payload = bytearray(size)
+    fixups = []
+    for i, (k, off) in enumerate(zip(kexts, offsets)):
+        if k.image is None:
+            continue
+        local = []
+        k.link(base + off, resolver(i), local)
+        payload[off:off + len(k.image)] = k.image
+        fixups += (off + at for at in local)
+    if size >= 1 << 32:
+        fail("the kexts take 4 GiB or more")
+
+    strings = bytearray(b"\0")
+    interned = {}
+
+    def string(s):
+        if s not in interned:
+            interned[s] = len(strings)
+            strings.extend(s.encode() + b"\0")
+        return interned[s]
+
+    table, info = bytearray(), []
+    for k, off in zip(kexts, offsets):
+        d = dict(k.info)
+        d["_PrelinkBundlePath"] = f"/System/Library/Extensions/{k.path.name}"
+        if off is not None:
+            d["_PrelinkExecutableLoadAddr"] = base + off
+            d["_PrelinkExecutableSize"] = len(k.image)
+            if k.kmod_info is not None:
+                d["_PrelinkKmodInfo"] = base + off + k.kmod_info
+        info.append(d)
+        table += KEXT.pack(string(k.bundle_id), 0,
+                           KEXTC_NONE if off is None else off,
+                           0 if off is None else len(k.image),
+                           KEXTC_NONE if off is None or k.kmod_info is None else off + k.kmod_info)
+
+    symbols = bytearray()
+    for name, kext, off in sorted(exports, key=lambda e: (e[0].encode(), e[1])):
+        symbols += SYMBOL.pack(string(name), kext, off)
+    info = plist_image({"_PrelinkInfoDictionary": info}, b"")
+
+    kexts_off = HEADER.size
+    symbols_off = kexts_off + len(table)
+    fixups_off = symbols_off + len(symbols)
+    strings_off = fixups_off + 4 * len(fixups)
+    info_off = align(strings_off + len(strings), 8)
+    payload_off = align(info_off + len(info), KEXTC_PAGE)
+
+    body = bytearray(payload_off - HEADER.size)
+    body[0:len(table)] = table
+    body[symbols_off - HEADER.size:fixups_off - HEADER.size] = symbols
+    body[fixups_off - HEADER.size:strings_off - HEADER.size] = struct.pack(f"<{len(fixups)}I", *sorted(fixups))
+    body[strings_off - HEADER.size:strings_off - HEADER.size + len(strings)] = strings
+    body[info_off - HEADER.size:info_off - HEADER.size + len(info)] = info
+    body += payload
+
+    header = HEADER.pack(KEXTC_MAGIC, KEXTC_VERSION, zlib.crc32(body), HEADER.size + len(body), base,
+                         len(kexts), len(exports), len(fixups), len(strings),
+                         kexts_off, symbols_off, fixups_off, strings_off, info_off, len(info),
+                         payload_off, size)
+    Path(out).write_bytes(header + body)
+    return len(kexts), len(exports), len(fixups)
+
+def main():
+    ap = argparse.ArgumentParser(description="Prelink kexts into one collection")
+    ap.add_argument("kexts", nargs="+", metavar="KEXT", help=".kext bundles, in load order")
+    ap.add_argument("-o", "--output", default="kexts.kc", help="collection to write (default: kexts.kc)")
+    ap.add_argument("--base", type=lambda s: int(s, 0), default=DEFAULT_BASE,
+                    help=f"link address of the first kext (default: {DEFAULT_BASE:#x})")
+    ap.add_argument("--kernel-symbols", metavar="FILE",
+                    help="the kernel's symbols, as `nm` prints them, to bind the kexts against")
+    args = ap.parse_args()
+
+    n, symbols, fixups = write_collection(args.kexts, args.output, args.base, args.kernel_symbols)
+    print(f"[✓] {args.output}: {n} kexts, {symbols} symbols, {fixups} fixups")
+
+if __name__ == "__main__":
+    main()
@@ -1,7 +1,13 @@
 #!/usr/bin/env python3
 
+import argparse
+import datetime
 import os
+import plistlib
 import shutil
+import struct
+import subprocess
+import zlib
 from pathlib import Path
 
 SDK_NAME = "PocketDarwin01.sdk"
@@ -10,6 +16,18 @@ TARGET = "arm64-apple-darwin"
 
 ROOT = Path(SDK_NAME)
 SRC = Path("sdk_sources")
+WRITERSC_DIR = Path(__file__).resolve().parent / "writersc"
+
+# Precompiled config.plist image, see OCMobile/Platform/plist/plist.h.
+# Nodes and index slots use the loader's in-memory (LP64) layout.
+PLIST_IMAGE_MAGIC = b"OCMPLIMG"
+PLIST_IMAGE_VERSION = 1
+PLIST_STRING, PLIST_INTEGER, PLIST_BOOL, PLIST_DICT, PLIST_ARRAY, \
+    PLIST_DATA, PLIST_DATE, PLIST_REAL = range(8)
+IMAGE_HEADER = struct.Struct("<8sIIQQIIIIQQQ")
+IMAGE_NODE = struct.Struct("<QIIII16s")
+IMAGE_SLOT = struct.Struct("<III")
+APPLE_EPOCH = datetime.datetime(2001, 1, 1)
 
 def mkdir(p):
     p.mkdir(parents=True, exist_ok=True)
@@ -58,7 +76,158 @@ exports:
     out = ROOT / "System/usr/lib" / f"{libname}.tbd"
     out.write_text(tbd)
 
+def plist_hash_key(parent, key):
+    # must match hash_key() in plist.c
+    h = 2166136261 ^ ((parent * 0x9E3779B9) & 0xFFFFFFFF)
+    for c in key:
+        h = ((h ^ c) * 16777619) & 0xFFFFFFFF
+    return h
+
+def plist_image(value, source):
+    """A plist image of `value`, tagged with the size and CRC of `source`"""
+    nodes = []
+
+    # pre-order, like the loader's parser: children always follow parents
+    def add(value, key):
+        idx = len(nodes)
+        node = {"key": key, "count": 0, "first": 0, "next": 0}
+        nodes.append(node)
+
+        if isinstance(value, dict):
+            node["type"] = PLIST_DICT
+            children = value.items()
+        elif isinstance(value, list):
+            node["type"] = PLIST_ARRAY
+            children = ((None, v) for v in value)
+        else:
+            children = ()
+            if isinstance(value, bool):
+                node["type"] = PLIST_BOOL
+            elif isinstance(value, int):
+                node["type"] = PLIST_INTEGER
+            elif isinstance(value, float):
+                node["type"] = PLIST_REAL
+            elif isinstance(value, datetime.datetime):
+                node["type"] = PLIST_DATE
+                value = (value - APPLE_EPOCH).total_seconds()
+            elif isinstance(value, bytes):
+                node["type"] = PLIST_DATA
+            elif isinstance(value, str):
+                node["type"] = PLIST_STRING
+            else:
+                raise ValueError(f"unsupported plist value {value!r}")
+            node["value"] = value
+
+        last = 0
+        for k, v in children:
+            child = add(v, k)
+            if last:
+                nodes[last]["next"] = child
+            else:
+                node["first"] = child
+            last = child
+            node["count"] += 1
+        return idx
+
+    add(value, None)
+
+    slots = 16
+    while slots < len(nodes) * 2:
+        slots <<= 1
+    index = [(0, 0, 0)] * slots
+    for p, node in enumerate(nodes):
+        if node["type"] != PLIST_DICT:
+            continue
+        child = node["first"]
+        while child:
+            h = plist_hash_key(p, nodes[child]["key"].encode())
+            s = h & (slots - 1)
+            while index[s][1]:
+                s = (s + 1) & (slots - 1)
+            index[s] = (h, child + 1, p)
+            child = nodes[child]["next"]
+
+    nodes_off = IMAGE_HEADER.size
+    index_off = nodes_off + len(nodes) * IMAGE_NODE.size
+    pool_off = index_off + slots * IMAGE_SLOT.size
+    pool = bytearray()
+
+    def put(b):
+        off = pool_off + len(pool)
+        pool.extend(b)
+        return off
+
+    body = bytearray()
+    for node in nodes:
+        key = put(node["key"].encode() + b"\0") if node["key"] is not None else 0
+        t, v = node["type"], node.get("value")
+        if t == PLIST_STRING:
+            value = struct.pack("<QQ", put(v.encode() + b"\0"), 0)
+        elif t == PLIST_DATA:
+            value = struct.pack("<QQ", put(v), len(v))
+        elif t == PLIST_INTEGER:
+            value = struct.pack("<QQ", v & 0xFFFFFFFFFFFFFFFF, 0)
+        elif t == PLIST_BOOL:
+            value = struct.pack("<i12x", int(v))
+        elif t in (PLIST_REAL, PLIST_DATE):
+            value = struct.pack("<d8x", v)
+        else:
+            value = bytes(16)
+        body += IMAGE_NODE.pack(key, t, node["count"], node["first"], node["next"], value)
+    for slot in index:
+        body += IMAGE_SLOT.pack(*slot)
+    body += pool
+
+    header = IMAGE_HEADER.pack(
+        PLIST_IMAGE_MAGIC, PLIST_IMAGE_VERSION, zlib.crc32(body),
+        IMAGE_HEADER.size + len(body), len(source), zlib.crc32(source),
+        len(nodes), slots, 0, nodes_off, index_off, pool_off)
+    return header + body
+
+def write_config_cache(config, out):
+    source = Path(config).read_bytes()
+    Path(out).write_bytes(plist_image(plistlib.loads(source), source))
+
+def build_drivers(drivers, out, writersc, cache):
+    # one writersc run for all of them: it spreads them over the CPUs and
+    # copies what is unchanged since the last build out of the cache
+    if writersc is None:
+        subprocess.run(["make", "-s", "-C", str(WRITERSC_DIR)], check=True)
+        writersc = WRITERSC_DIR / "writersc"
+    # -d keeps only the stem: EFI/OC/Drivers is flat, like OpenCore's
+    seen = {}
+    for d in drivers:
+        if d.stem in seen:
+            raise ValueError(f"{d} and {seen[d.stem]} would both be {d.stem}.wscd")
+        seen[d.stem] = d
+    mkdir(out)
+    mkdir(cache)
+    subprocess.run([str(writersc), "-c", str(cache), "-d", str(out),
+                    *(str(d) for d in drivers)], check=True)
+
+def build_kexts(kexts, out, kernel_symbols):
+    # imported here: mkkextc takes plist_image() from us
+    from mkkextc import write_collection
+    n, symbols, fixups = write_collection(kexts, out, kernel=kernel_symbols)
+    print(f"    {n} kexts, {symbols} symbols, {fixups} fixups")
+
 def main():
+    ap = argparse.ArgumentParser(description=f"Build {SDK_NAME}")
+    ap.add_argument("--config-cache", metavar="CONFIG",
+                    help="only write the precompiled image for CONFIG (config.cache next to it)")
+    ap.add_argument("-o", "--output", help="where --config-cache writes the image")
+    ap.add_argument("--writersc", metavar="PATH",
+                    help="compile drivers with this writersc (default: build Tools/writersc)")
+    ap.add_argument("--driver-cache", metavar="DIR", default=".wscd-cache",
+                    help="compiled drivers by source hash, reused across builds")
+    args = ap.parse_args()
+
+    if args.config_cache:
+        out = args.output or Path(args.config_cache).with_name("config.cache")
+        write_config_cache(args.config_cache, out)
+        print(f"[✓] {out}")
+        return
+
     print(f"[+] Creating {SDK_NAME}")
 
     mkdir(ROOT)
@@ -84,6 +253,28 @@ def main():
     # Write SDKSettings.plist
     write_plist()
 
+    # Ship config.plist with its image, so the first boot skips the parse
+    cfg_src = SRC / "EFI/OC/config.plist"
+    if cfg_src.exists():
+        print("[+] Config cache")
+        mkdir(ROOT / "EFI/OC")
+        shutil.copy(cfg_src, ROOT / "EFI/OC/config.plist")
+        write_config_cache(cfg_src, ROOT / "EFI/OC/config.cache")
+
+    # Compile WriterSc drivers, see OCMobile/Driver.h
+    drivers = sorted((SRC / "drivers").rglob("*.ws"))
+    if drivers:
+        print(f"[+] {len(drivers)} drivers")
+        build_drivers(drivers, ROOT / "EFI/OC/Drivers", args.writersc, Path(args.driver_cache))
+
+    # Prelink kexts into one collection, see OCMobile/Platform/Kextld.h
+    kexts = sorted((SRC / "kexts").glob("*.kext"))
+    if kexts:
+        print("[+] Kext collection")
+        mkdir(ROOT / "EFI/OC")
+        symbols = SRC / "kernel.symbols"
+        build_kexts(kexts, ROOT / "EFI/OC/kexts.kc", symbols if symbols.exists() else None)
+
     # Generate stub libraries
     sym_src = SRC / "symbols"
     if sym_src.exists():
@@ -1,17 +1,287 @@
-#include "ast.h"
+#include "writersc.h"
+#include "../../Platform/crc32/crc32.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
-extern int yyparse();
-extern ASTNode *root;
+/*
+ * One process compiles any number of drivers: each is a job, and -j
+ * worker threads take the next job until none are left. With -c, an
+ * image is also filed in the cache under the hash of what it was built
+ * from (WRITERSC_VERSION, the options that change the output, the
+ * source), and an unchanged driver is copied from there instead of
+ * compiled again.
+ */
+
+#define PATH_LEN        4096
+
+#define JOB_COMPILED    0
+#define JOB_CACHED      1
+#define JOB_FAILED      2
+
+typedef struct {
+    const char *input;
+    char *output;
+    int status;
+} Job;
+
+typedef struct {
+    Job *jobs;
+    int count;
+    atomic_int next;
+
+    const char *cache;          /* NULL: no cache */
+    FILE *listing;
+    int bytecode_only;
+    int unoptimized;
+} Build;
+
+static void usage(void) {
+    fprintf(stderr, "usage: writersc [-S] [-n] [-O0] [-j jobs] [-c cache] [-o out.wscd | -d dir] [driver.ws ...]\n"
+                    "  -S  print the bytecode listing (one driver only), and what optimizing saved\n"
+                    "  -n  bytecode only, no native aarch64 section\n"
+                    "  -O0 compile the driver as written, without optimizing it\n"
+                    "  -j  compile this many drivers at once (default: one per CPU)\n"
+                    "  -c  reuse and keep images in this directory, by source hash\n"
+                    "  -o  output (default: the input with .wscd for its extension)\n"
+                    "  -d  write the images into this directory instead\n");
+}
+
+/* "dir/foo.ws" -> "dir/foo.wscd", or "<outdir>/foo.wscd" */
+static char *output_for(const char *input, const char *outdir) {
+    const char *slash = strrchr(input, '/');
+    const char *base = outdir && slash ? slash + 1 : input;
+    const char *dot = strrchr(base, '.');
+    size_t stem = dot && (!slash || dot > slash) ? (size_t)(dot - base) : strlen(base);
+    size_t dir = outdir ? strlen(outdir) + 1 : 0;
+    char *out = malloc(dir + stem + sizeof(".wscd"));
+
+    if (out) {
+        if (outdir) {
+            memcpy(out, outdir, dir - 1);
+            out[dir - 1] = '/';
+        }
+        memcpy(out + dir, base, stem);
+        strcpy(out + dir + stem, ".wscd");
+    }
+    return out;
+}
+
+/* =========================
+ *  Cache
+ * ========================= */
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t size) {
+    const unsigned char *p = data;
+
+    for (size_t i = 0; i < size; i++)
+        h = (h ^ p[i]) * 0x100000001B3ull;
+    return h;
+}
+
+static uint64_t cache_key(const Build *b, const char *source, size_t size) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    char options[2] = { b->bytecode_only ? 'n' : '-', b->unoptimized ? '0' : '-' };
+
+    h = fnv1a(h, WRITERSC_VERSION, sizeof(WRITERSC_VERSION));
+    h = fnv1a(h, options, sizeof(options));
+    return fnv1a(h, source, size);
+}
+
+static char *read_all(FILE *f, size_t *size) {
+    size_t cap = 4096, n = 0, got;
+    char *buf = malloc(cap);
+
+    while (buf && (got = fread(buf + n, 1, cap - n, f)) > 0) {
+        n += got;
+        if (n == cap) {
+            char *bigger = realloc(buf, cap *= 2);
+            if (!bigger)
+                free(buf);
+            buf = bigger;
+        }
+    }
+    if (buf && ferror(f)) {
+        free(buf);
+        buf = NULL;
+    }
+    *size = n;
+    return buf;
+}
+
+static int copy_file(const char *from, const char *to) {
+    FILE *in = fopen(from, "rb");
+    size_t size;
+    char *data = in ? read_all(in, &size) : NULL;
+    int failed = !data;
+
+    if (in)
+        fclose(in);
+    if (data) {
+        FILE *out = fopen(to, "wb");
+
+        failed = !out || fwrite(data, 1, size, out) != size;
+        if (out && fclose(out))
+            failed = 1;
+    }
+    free(data);
+    return failed;
+}
+
+/* Into the cache by way of a name of our own, so readers never see half an image */
+static void cache_store(const char *image, const char *entry, int job) {
+    char tmp[PATH_LEN + 32];
+
+    snprintf(tmp, sizeof(tmp), "%s.%ld.%d", entry, (long)getpid(), job);
+    if (copy_file(image, tmp) || rename(tmp, entry))
+        remove(tmp);
+}
+
+/* =========================
+ *  Jobs
+ * ========================= */
+
+static int compile(Build *b, Job *job, int index) {
+    int from_stdin = strcmp(job->input, "-") == 0;
+    FILE *in = from_stdin ? stdin : fopen(job->input, "r");
+    char entry[PATH_LEN] = "";
+    int failed;
+
+    if (!in) {
+        perror(job->input);
+        return JOB_FAILED;
+    }
+
+    if (b->cache && !from_stdin && !b->listing) {
+        size_t size;
+        char *source = read_all(in, &size);
+
+        if (source)
+            snprintf(entry, sizeof(entry), "%s/%016llx.wscd", b->cache,
+                     (unsigned long long)cache_key(b, source, size));
+        free(source);
+        if (entry[0] && copy_file(entry, job->output) == 0) {
+            fclose(in);
+            return JOB_CACHED;
+        }
+        rewind(in);
+    }
+
+    ASTUnit *unit = ast_unit_new(job->input);
+
+    failed = parse_driver(unit, in) != 0 || validate_driver(unit) != 0;
+    if (!failed && !b->unoptimized)
+        optimize_driver(unit, b->listing);
+    failed = failed || codegen_driver(unit, job->output, b->listing, b->bytecode_only) != 0;
+    ast_unit_free(unit);
+    if (!from_stdin)
+        fclose(in);
+
+    if (failed)
+        return JOB_FAILED;
+    if (entry[0])
+        cache_store(job->output, entry, index);
+    return JOB_COMPILED;
+}
+
+static void *worker(void *arg) {
+    Build *b = arg;
+    int i;
+
+    while ((i = atomic_fetch_add(&b->next, 1)) < b->count)
+        b->jobs[i].status = compile(b, &b->jobs[i], i);
+    return NULL;
+}
 
 int main(int argc, char **argv) {
-    if (yyparse() != 0) {
+    Build b = { 0 };
+    const char *output = NULL, *outdir = NULL;
+    const char **inputs = calloc(argc, sizeof(char *));
+    int ninputs = 0;
+    int listing = 0;
+    long threads = 0;
+
+    if (!inputs)
+        return 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-S") == 0) {
+            listing = 1;
+        } else if (strcmp(argv[i], "-n") == 0) {
+            b.bytecode_only = 1;
+        } else if (strcmp(argv[i], "-O0") == 0) {
+            b.unoptimized = 1;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            outdir = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            b.cache = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = strtol(argv[++i], NULL, 10);
+        } else if (argv[i][0] == '-' && argv[i][1]) {
+            usage();
+            return 2;
+        } else {
+            inputs[ninputs++] = argv[i];
+        }
+    }
+
+    if (!ninputs)
+        inputs[ninputs++] = "-";
+    if ((output && (outdir || ninputs > 1)) || (listing && ninputs > 1)) {
+        usage();
+        return 2;
+    }
+
+    b.jobs = calloc(ninputs, sizeof(Job));
+    if (!b.jobs)
         return 1;
+    for (int i = 0; i < ninputs; i++) {
+        b.jobs[i].input = inputs[i];
+        b.jobs[i].output = output ? strdup(output)
+                         : strcmp(inputs[i], "-") ? output_for(inputs[i], outdir) : NULL;
+        if (!b.jobs[i].output) {
+            fprintf(stderr, "writersc: -o is needed when reading stdin\n");
+            return 2;
+        }
     }
+    b.count = ninputs;
+    b.listing = listing ? stdout : NULL;
+
+    if (threads <= 0)
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > ninputs)
+        threads = ninputs;
+    if (threads < 1)
+        threads = 1;
+
+    pthread_t *pool = calloc(threads, sizeof(pthread_t));
+    long started = 0;
 
-    printf("Parsed WriteSc driver successfully.\n");
-    // semantic validation here
-    // codegen here
+    crc32_init();               /* its tables are built once, not per thread */
+
+    while (pool && started < threads - 1 && pthread_create(&pool[started], NULL, worker, &b) == 0)
+        started++;
+    worker(&b);
+    for (long i = 0; i < started; i++)
+        pthread_join(pool[i], NULL);
+
+    int counts[3] = { 0 };
+    for (int i = 0; i < ninputs; i++) {
+        counts[b.jobs[i].status]++;
+        free(b.jobs[i].output);
+    }
+    if (ninputs > 1 || b.cache)
+        fprintf(stderr, "writersc: %d compiled, %d unchanged, %d failed\n",
+                counts[JOB_COMPILED], counts[JOB_CACHED], counts[JOB_FAILED]);
 
-    return 0;
+    free(pool);
+    free(b.jobs);
+    free(inputs);
+    return counts[JOB_FAILED] != 0;
 }
@@ -0,0 +1,494 @@
+#include "writersc.h"
+#include "../../Platform/wscd/wscd.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Bytecode -> aarch64, for the WSCD_SECTION_NATIVE section.
+ *
+ * Every function becomes an AAPCS64 function taking its parameters in
+ * x0..x7 and returning in x0, so the loader calls exported ones straight
+ * from C. Bytecode registers 0..9 live in x19..x28 (callee-saved, so
+ * they survive calls without spilling), the rest in the frame; x9..x12
+ * hold operands, x16/x17 are for the prologue and host calls. Internal
+ * calls are BLs and jumps plain branches, so the code is position
+ * independent; the one thing it addresses is the link area after it
+ * (ADR), which the loader fills in:
+ *   +0   ctx for host functions
+ *   +8   lowest address the stack may grow to
+ *   +16  void fault(ctx, reason), called on overflow; must not return
+ *   +24  one host function pointer per import
+ *
+ * Functions with more than 8 parameters have no AAPCS64 form, so for
+ * them the image goes out without a native section.
+ */
+
+#define MAPPED          10          /* bytecode registers kept in x19.. */
+#define XR(r)           (19 + (r))
+#define X0              0
+#define X9              9
+#define X10             10
+#define X11             11
+#define X12             12
+#define IP0             16
+#define IP1             17
+#define FP              29
+#define LR              30
+#define SP              31
+#define XZR             31
+
+#define LINK_CTX        0
+#define LINK_LIMIT      8
+#define LINK_FAULT      16
+#define LINK_IMPORTS    24
+
+#define COND_EQ         0x0
+#define COND_NE         0x1
+#define COND_LO         0x3
+#define COND_LS         0x9
+#define COND_LT         0xB
+#define COND_LE         0xD
+
+#define FIX_BRANCH      0           /* B, target: bytecode pc */
+#define FIX_COND        1           /* CBZ / CBNZ / B.cond, bytecode pc */
+#define FIX_CALL        2           /* BL, target: function */
+#define FIX_ADR_LINK    3           /* ADR to the link area */
+#define FIX_FAULT       4           /* B.cond to the fault stub */
+
+typedef struct {
+    size_t at;
+    int kind;
+    uint32_t target;
+} Fixup;
+
+typedef struct {
+    const IRModule *ir;
+    uint32_t *code;
+    size_t count, cap;
+    Fixup *fixups;
+    size_t nfixups, fixups_cap;
+    size_t *entries;                /* per function */
+    size_t *labels;                 /* per bytecode instruction of the current function */
+
+    /* the function being compiled */
+    int frame;
+    int saved;                      /* x19.. saved, even */
+    int spill;                      /* offset of bytecode register MAPPED */
+    int outgoing;                   /* offset of host call arguments */
+} Native;
+
+static void *grow(void *p, size_t *cap, size_t need, size_t size) {
+    if (need <= *cap)
+        return p;
+    while (*cap < need)
+        *cap = *cap ? *cap * 2 : 256;
+    p = realloc(p, *cap * size);
+    if (!p) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+static size_t emit(Native *n, uint32_t ins) {
+    n->code = grow(n->code, &n->cap, n->count + 1, sizeof(uint32_t));
+    n->code[n->count] = ins;
+    return n->count++;
+}
+
+static void fixup(Native *n, int kind, uint32_t target) {
+    n->fixups = grow(n->fixups, &n->fixups_cap, n->nfixups + 1, sizeof(Fixup));
+    n->fixups[n->nfixups++] = (Fixup){ n->count - 1, kind, target };
+}
+
+/* =========================
+ *  Encodings
+ * ========================= */
+
+#define RRR(base, d, a, b)      ((base) | (uint32_t)(b) << 16 | (uint32_t)(a) << 5 | (d))
+
+static void mov(Native *n, int d, int s) {
+    if (d != s)
+        emit(n, RRR(0xAA0003E0, d, 0, s));      /* orr xd, xzr, xs */
+}
+
+static void ldr(Native *n, int t, int base, int off) {
+    emit(n, 0xF9400000 | (uint32_t)(off / 8) << 10 | base << 5 | t);
+}
+
+static void str(Native *n, int t, int base, int off) {
+    emit(n, 0xF9000000 | (uint32_t)(off / 8) << 10 | base << 5 | t);
+}
+
+static void pair(Native *n, uint32_t op, int t1, int t2, int off) {
+    emit(n, op | (uint32_t)((off / 8) & 0x7F) << 15 | t2 << 10 | SP << 5 | t1);
+}
+
+static void stp(Native *n, int t1, int t2, int off) { pair(n, 0xA9000000, t1, t2, off); }
+static void ldp(Native *n, int t1, int t2, int off) { pair(n, 0xA9400000, t1, t2, off); }
+
+static void add_imm(Native *n, int d, int s, int imm) {
+    emit(n, 0x91000000 | (uint32_t)imm << 10 | s << 5 | d);
+}
+
+static void sub_imm(Native *n, int d, int s, int imm) {
+    emit(n, 0xD1000000 | (uint32_t)imm << 10 | s << 5 | d);
+}
+
+static void cmp(Native *n, int a, int b) {
+    emit(n, RRR(0xEB00001F, 0, a, b));          /* subs xzr, xa, xb */
+}
+
+static void cset(Native *n, int d, int cond) {
+    emit(n, 0x9A9F07E0 | (uint32_t)(cond ^ 1) << 12 | d);   /* csinc xd, xzr, xzr, !cond */
+}
+
+static void load_imm(Native *n, int d, uint64_t v) {
+    if ((int64_t)v < 0 && (int64_t)v >= -0x10000) {
+        emit(n, 0x92800000 | (uint32_t)(~v & 0xFFFF) << 5 | d);    /* movn */
+        return;
+    }
+    emit(n, 0xD2800000 | (uint32_t)(v & 0xFFFF) << 5 | d);         /* movz */
+    for (int hw = 1; hw < 4; hw++) {
+        uint32_t chunk = (v >> (16 * hw)) & 0xFFFF;
+        if (chunk)
+            emit(n, 0xF2800000 | (uint32_t)hw << 21 | chunk << 5 | d);  /* movk */
+    }
+}
+
+static void adr_link(Native *n, int d) {
+    emit(n, 0x10000000 | d);
+    fixup(n, FIX_ADR_LINK, 0);
+}
+
+/* =========================
+ *  Registers
+ * ========================= */
+
+static int slot(Native *n, int r) {
+    return n->spill + 8 * (r - MAPPED);
+}
+
+/* Where bytecode register `r` can be read, loading it into `scratch` if it lives in the frame */
+static int src(Native *n, int r, int scratch) {
+    if (r < MAPPED)
+        return XR(r);
+    ldr(n, scratch, SP, slot(n, r));
+    return scratch;
+}
+
+/* Where to compute bytecode register `r`; commit() puts it in place */
+static int dst(int r, int scratch) {
+    return r < MAPPED ? XR(r) : scratch;
+}
+
+static void commit(Native *n, int r, int reg) {
+    if (r >= MAPPED)
+        str(n, reg, SP, slot(n, r));
+}
+
+static void put(Native *n, int r, int reg) {
+    if (r < MAPPED)
+        mov(n, XR(r), reg);
+    else
+        str(n, reg, SP, slot(n, r));
+}
+
+/* =========================
+ *  Functions
+ * ========================= */
+
+static void epilogue(Native *n) {
+    for (int i = 0; i < n->saved; i += 2)
+        ldp(n, XR(i), XR(i + 1), 16 + 8 * i);
+    ldp(n, FP, LR, 0);
+    add_imm(n, SP, SP, n->frame);
+    emit(n, 0xD65F03C0);                        /* ret */
+}
+
+static int compile_function(Native *n, int index) {
+    const IRFunc *f = &n->ir->funcs[index];
+    const uint32_t *code = n->ir->code + f->code;
+    int outgoing = 0;
+
+    for (uint32_t pc = 0; pc < f->length; pc++) {
+        uint32_t i = code[pc];
+
+        if (WSCD_OP(i) == WSCD_OP_CALL && WSCD_C(i) > 8)
+            return -1;
+        if (WSCD_OP(i) == WSCD_OP_CALLN && (int)WSCD_C(i) > outgoing)
+            outgoing = WSCD_C(i);
+    }
+
+    n->saved = ((f->nregs < MAPPED ? f->nregs : MAPPED) + 1) & ~1;
+    n->spill = 16 + 8 * n->saved;
+    n->outgoing = n->spill + 8 * (f->nregs > MAPPED ? f->nregs - MAPPED : 0);
+    n->frame = (n->outgoing + 8 * outgoing + 15) & ~15;
+    if (n->frame > 4095)
+        return -1;
+
+    n->entries[index] = n->count;
+
+    /* stay above the limit the loader gave */
+    adr_link(n, IP0);
+    ldr(n, IP0, IP0, LINK_LIMIT);
+    sub_imm(n, IP1, SP, n->frame);
+    cmp(n, IP1, IP0);
+    emit(n, 0x54000000 | COND_LO);
+    fixup(n, FIX_FAULT, 0);
+
+    sub_imm(n, SP, SP, n->frame);
+    stp(n, FP, LR, 0);
+    add_imm(n, FP, SP, 0);
+    for (int k = 0; k < n->saved; k += 2)
+        stp(n, XR(k), XR(k + 1), 16 + 8 * k);
+    for (int k = 0; k < f->nparams; k++)
+        put(n, k, k);
+
+    for (uint32_t pc = 0; pc < f->length; pc++) {
+        uint32_t i = code[pc];
+        uint32_t a = WSCD_A(i), b = WSCD_B(i), c = WSCD_C(i);
+        int rb, rc, rd;
+
+        n->labels[pc] = n->count;
+
+        switch (WSCD_OP(i)) {
+        case WSCD_OP_MOV:
+            rb = src(n, b, X9);
+            put(n, a, rb);
+            break;
+        case WSCD_OP_LOADI:
+        case WSCD_OP_LOADK:
+            rd = dst(a, X11);
+            load_imm(n, rd, WSCD_OP(i) == WSCD_OP_LOADI
+                ? (uint64_t)(int64_t)WSCD_SBX(i) : n->ir->consts[WSCD_BX(i)]);
+            commit(n, a, rd);
+            break;
+        case WSCD_OP_ADDI: {
+            int imm = (int8_t)c;
+
+            rb = src(n, b, X9);
+            rd = dst(a, X11);
+            if (imm >= 0)
+                add_imm(n, rd, rb, imm);
+            else
+                sub_imm(n, rd, rb, -imm);
+            commit(n, a, rd);
+            break;
+        }
+        case WSCD_OP_ADD: case WSCD_OP_SUB: case WSCD_OP_MUL:
+        case WSCD_OP_DIVU: case WSCD_OP_DIVS: case WSCD_OP_AND: case WSCD_OP_OR:
+        case WSCD_OP_XOR: case WSCD_OP_SHL: case WSCD_OP_SHRU: case WSCD_OP_SHRS: {
+            static const uint32_t ops[WSCD_OP_COUNT] = {
+                [WSCD_OP_ADD] = 0x8B000000, [WSCD_OP_SUB] = 0xCB000000,
+                [WSCD_OP_MUL] = 0x9B007C00, [WSCD_OP_DIVU] = 0x9AC00800,
+                [WSCD_OP_DIVS] = 0x9AC00C00, [WSCD_OP_AND] = 0x8A000000,
+                [WSCD_OP_OR] = 0xAA000000, [WSCD_OP_XOR] = 0xCA000000,
+                [WSCD_OP_SHL] = 0x9AC02000, [WSCD_OP_SHRU] = 0x9AC02400,
+                [WSCD_OP_SHRS] = 0x9AC02800,
+            };
+
+            rb = src(n, b, X9);
+            rc = src(n, c, X10);
+            rd = dst(a, X11);
+            emit(n, RRR(ops[WSCD_OP(i)], rd, rb, rc));
+            commit(n, a, rd);
+            break;
+        }
+        case WSCD_OP_REMU:
+        case WSCD_OP_REMS:
+            rb = src(n, b, X9);
+            rc = src(n, c, X10);
+            rd = dst(a, X11);
+            emit(n, RRR(WSCD_OP(i) == WSCD_OP_REMU ? 0x9AC00800 : 0x9AC00C00, X12, rb, rc));
+            emit(n, 0x9B008000 | (uint32_t)rc << 16 | (uint32_t)rb << 10 | X12 << 5 | rd);  /* msub */
+            commit(n, a, rd);
+            break;
+        case WSCD_OP_EQ: case WSCD_OP_NE: case WSCD_OP_LTU:
+        case WSCD_OP_LTS: case WSCD_OP_LEU: case WSCD_OP_LES: {
+            static const int conds[WSCD_OP_COUNT] = {
+                [WSCD_OP_EQ] = COND_EQ, [WSCD_OP_NE] = COND_NE, [WSCD_OP_LTU] = COND_LO,
+                [WSCD_OP_LTS] = COND_LT, [WSCD_OP_LEU] = COND_LS, [WSCD_OP_LES] = COND_LE,
+            };
+
+            rb = src(n, b, X9);
+            rc = src(n, c, X10);
+            rd = dst(a, X11);
+            cmp(n, rb, rc);
+            cset(n, rd, conds[WSCD_OP(i)]);
+            commit(n, a, rd);
+            break;
+        }
+        case WSCD_OP_NEG:
+        case WSCD_OP_INV:
+            rb = src(n, b, X9);
+            rd = dst(a, X11);
+            emit(n, RRR(WSCD_OP(i) == WSCD_OP_NEG ? 0xCB0003E0 : 0xAA2003E0, rd, 0, rb));
+            commit(n, a, rd);
+            break;
+        case WSCD_OP_NOT:
+            rb = src(n, b, X9);
+            rd = dst(a, X11);
+            cmp(n, rb, XZR);
+            cset(n, rd, COND_EQ);
+            commit(n, a, rd);
+            break;
+        case WSCD_OP_EXT: {
+            uint32_t bits = c & ~WSCD_EXT_SIGNED;
+
+            rb = src(n, b, X9);
+            rd = dst(a, X11);
+            emit(n, (c & WSCD_EXT_SIGNED ? 0x93400000 : 0xD3400000) |   /* sbfx / ubfx #0 */
+                    (bits - 1) << 10 | (uint32_t)rb << 5 | rd);
+            commit(n, a, rd);
+            break;
+        }
+        case WSCD_OP_JMP:
+            emit(n, 0x14000000);
+            fixup(n, FIX_BRANCH, pc + 1 + WSCD_SAX(i));
+            break;
+        case WSCD_OP_JZ:
+        case WSCD_OP_JNZ:
+            rb = src(n, a, X9);
+            emit(n, (WSCD_OP(i) == WSCD_OP_JZ ? 0xB4000000 : 0xB5000000) | rb);
+            fixup(n, FIX_COND, pc + 1 + WSCD_SBX(i));
+            break;
+        case WSCD_OP_CALL:
+            for (uint32_t k = 0; k < c; k++)
+                mov(n, k, src(n, a + k, k));
+            emit(n, 0x94000000);
+            fixup(n, FIX_CALL, b);
+            put(n, a, X0);
+            break;
+        case WSCD_OP_CALLN:
+            for (uint32_t k = 0; k < c; k++)
+                str(n, src(n, a + k, X9), SP, n->outgoing + 8 * k);
+            adr_link(n, IP0);
+            ldr(n, X0, IP0, LINK_CTX);
+            ldr(n, IP1, IP0, LINK_IMPORTS + 8 * b);
+            add_imm(n, 1, SP, n->outgoing);
+            emit(n, 0xD63F0000 | IP1 << 5);     /* blr x17 */
+            put(n, a, X0);
+            break;
+        case WSCD_OP_RET:
+            mov(n, X0, src(n, a, X0));
+            epilogue(n);
+            break;
+        default:
+            return -1;
+        }
+    }
+
+    /* branches inside the function */
+    for (size_t k = 0; k < n->nfixups; k++) {
+        Fixup *x = &n->fixups[k];
+        int32_t delta;
+
+        if (x->kind != FIX_BRANCH && x->kind != FIX_COND)
+            continue;
+        delta = (int32_t)(n->labels[x->target] - x->at);
+        if (x->kind == FIX_BRANCH)
+            n->code[x->at] |= (uint32_t)delta & 0x3FFFFFF;
+        else
+            n->code[x->at] |= ((uint32_t)delta & 0x7FFFF) << 5;
+        x->kind = -1;
+    }
+    return 0;
+}
+
+/* =========================
+ *  Section
+ * ========================= */
+
+static void le32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+int native_aarch64(const IRModule *ir, uint8_t **out, size_t *size) {
+    Native n = { .ir = ir };
+    size_t longest = 1;
+    int failed = 0;
+
+    n.entries = calloc(ir->nfuncs, sizeof(size_t));
+    for (int f = 0; f < ir->nfuncs; f++)
+        if (ir->funcs[f].length > longest)
+            longest = ir->funcs[f].length;
+    n.labels = calloc(longest, sizeof(size_t));
+    if (!n.entries || !n.labels) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    for (int f = 0; f < ir->nfuncs && !failed; f++) {
+        if (ir->funcs[f].nparams > 8 || compile_function(&n, f))
+            failed = 1;
+    }
+
+    /* shared by every prologue: report the overflow, never come back */
+    size_t fault = n.count;
+    adr_link(&n, IP0);
+    ldr(&n, X0, IP0, LINK_CTX);
+    ldr(&n, IP1, IP0, LINK_FAULT);
+    load_imm(&n, 1, WSCD_FAULT_STACK);
+    emit(&n, 0xD63F0000 | IP1 << 5);            /* blr x17 */
+    emit(&n, 0xD4200000);                       /* brk #0 */
+
+    size_t head = sizeof(wscd_native_header_t) + 4 * ir->nfuncs;
+    size_t link = (head + 4 * n.count + 7) & ~(size_t)7;
+    size_t total = link + LINK_IMPORTS + 8 * ir->nimports;
+
+    if (total >= (1u << 20))
+        failed = 1;                             /* past ADR's reach */
+
+    for (size_t k = 0; k < n.nfixups && !failed; k++) {
+        Fixup *x = &n.fixups[k];
+        int32_t delta;
+
+        switch (x->kind) {
+        case FIX_CALL:
+            delta = (int32_t)(n.entries[x->target] - x->at);
+            n.code[x->at] |= (uint32_t)delta & 0x3FFFFFF;
+            break;
+        case FIX_FAULT:
+            delta = (int32_t)(fault - x->at);
+            n.code[x->at] |= ((uint32_t)delta & 0x7FFFF) << 5;
+            break;
+        case FIX_ADR_LINK:
+            delta = (int32_t)(link - (head + 4 * x->at));
+            n.code[x->at] |= ((uint32_t)delta & 3) << 29 | (((uint32_t)delta >> 2) & 0x7FFFF) << 5;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (!failed) {
+        uint8_t *p = calloc(1, total);
+
+        if (!p) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+        le32(p, WSCD_ARCH_AARCH64);
+        le32(p + 4, ir->nfuncs);
+        le32(p + 8, 4 * n.count);
+        le32(p + 12, link);
+        for (int f = 0; f < ir->nfuncs; f++)
+            le32(p + sizeof(wscd_native_header_t) + 4 * f, head + 4 * n.entries[f]);
+        for (size_t k = 0; k < n.count; k++)
+            le32(p + head + 4 * k, n.code[k]);
+        *out = p;
+        *size = total;
+    }
+
+    free(n.code);
+    free(n.fixups);
+    free(n.entries);
+    free(n.labels);
+    return failed ? -1 : 0;
+}
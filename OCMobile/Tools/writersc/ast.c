@@ -1,47 +1,328 @@
 #include "ast.h"
+#include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-ASTNode *new_node(ASTKind k) {
-    ASTNode *n = calloc(1, sizeof(ASTNode));
+/* =========================
+ *  Arena
+ * ========================= */
+
+#define CHUNK_SIZE      (64 * 1024)
+
+struct ASTChunk {
+    ASTChunk *next;
+    size_t used;
+    size_t size;
+};
+
+static void *xrealloc(void *p, size_t size) {
+    p = realloc(p, size);
+    if (!p) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void *grow(void *p, uint32_t *cap, uint32_t need, size_t size) {
+    if (need <= *cap)
+        return p;
+    while (*cap < need)
+        *cap = *cap ? *cap * 2 : 256;
+    return xrealloc(p, *cap * size);
+}
+
+static void *unit_alloc(ASTUnit *u, size_t size) {
+    ASTChunk *c = u->chunks;
+
+    size = (size + 7) & ~(size_t)7;
+    if (!c || c->size - c->used < size) {
+        size_t data = size > CHUNK_SIZE ? size : CHUNK_SIZE;
+
+        c = xrealloc(NULL, sizeof(ASTChunk) + data);
+        c->next = u->chunks;
+        c->used = 0;
+        c->size = data;
+        u->chunks = c;
+    }
+
+    void *p = (char *)(c + 1) + c->used;
+    c->used += size;
+    return p;
+}
+
+ASTUnit *ast_unit_new(const char *path) {
+    ASTUnit *u = calloc(1, sizeof(ASTUnit));
+
+    if (!u) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    u->path = path;
+    u->line = 1;
+    u->sym_init = ast_intern(u, "init", 4);
+    u->sym_bool = ast_intern(u, "bool", 4);
+    u->sym_u64 = ast_intern(u, "u64", 3);
+    return u;
+}
+
+void ast_unit_free(ASTUnit *u) {
+    if (!u)
+        return;
+    for (ASTChunk *c = u->chunks, *next; c; c = next) {
+        next = c->next;
+        free(c);
+    }
+    free(u->symbols);
+    free(u->kids);
+    free(u->pending);
+    free(u);
+}
+
+void ast_report(ASTUnit *u, int line, const char *fmt, ...) {
+    va_list ap;
+
+    flockfile(stderr);
+    if (line)
+        fprintf(stderr, "%s: line %d: ", u->path, line);
+    else
+        fprintf(stderr, "%s: ", u->path);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+    funlockfile(stderr);
+    u->errors++;
+}
+
+/* =========================
+ *  Names
+ * ========================= */
+
+static uint32_t hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;                   /* FNV-1a */
+
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
+
+static void rehash(ASTUnit *u) {
+    size_t cap = u->symbol_cap ? u->symbol_cap * 2 : 256;
+    ASTSymbol *table = calloc(cap, sizeof(ASTSymbol));
+
+    if (!table) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < u->symbol_cap; i++) {
+        ASTSymbol *s = &u->symbols[i];
+        size_t at = s->hash & (cap - 1);
+
+        if (!s->name)
+            continue;
+        while (table[at].name)
+            at = (at + 1) & (cap - 1);
+        table[at] = *s;
+    }
+    free(u->symbols);
+    u->symbols = table;
+    u->symbol_cap = cap;
+}
+
+const char *ast_intern(ASTUnit *u, const char *s, size_t len) {
+    uint32_t h = hash(s, len);
+
+    if (2 * (u->symbol_count + 1) > u->symbol_cap)
+        rehash(u);
+
+    size_t at = h & (u->symbol_cap - 1);
+    for (; u->symbols[at].name; at = (at + 1) & (u->symbol_cap - 1)) {
+        const char *name = u->symbols[at].name;
+
+        if (u->symbols[at].hash == h && strncmp(name, s, len) == 0 && name[len] == '\0')
+            return name;
+    }
+
+    char *copy = unit_alloc(u, len + 1);
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    u->symbols[at] = (ASTSymbol){ copy, h };
+    u->symbol_count++;
+    return copy;
+}
+
+/* =========================
+ *  Lists
+ * ========================= */
+
+uint32_t ast_list_begin(ASTUnit *u) {
+    return u->pending_count;
+}
+
+void ast_list_push(ASTUnit *u, ASTNode *node) {
+    u->pending = grow(u->pending, &u->pending_cap, u->pending_count + 1, sizeof(ASTNode *));
+    u->pending[u->pending_count++] = node;
+}
+
+ASTList ast_list_end(ASTUnit *u, uint32_t mark) {
+    ASTList list = { u->kid_count, u->pending_count - mark };
+
+    u->kids = grow(u->kids, &u->kid_cap, u->kid_count + list.count, sizeof(ASTNode *));
+    memcpy(u->kids + u->kid_count, u->pending + mark, list.count * sizeof(ASTNode *));
+    u->kid_count += list.count;
+    u->pending_count = mark;
+    return list;
+}
+
+/* =========================
+ *  Nodes
+ * ========================= */
+
+static ASTNode *new_node(ASTUnit *u, ASTKind k) {
+    ASTNode *n = unit_alloc(u, sizeof(ASTNode));
+
+    memset(n, 0, sizeof(*n));
     n->kind = k;
+    n->line = u->line;
     return n;
 }
 
-ASTNode *ast_driver(char *name, ASTNode *body) {
-    ASTNode *n = new_node(AST_DRIVER);
+ASTNode *ast_driver(ASTUnit *u, const char *name, ASTList body) {
+    ASTNode *n = new_node(u, AST_DRIVER);
     n->driver.name = name;
     n->driver.body = body;
     return n;
 }
 
-ASTNode *ast_function(char *name, char *ret, ASTNode *body) {
-    ASTNode *n = new_node(AST_FUNCTION);
+ASTNode *ast_function(ASTUnit *u, const char *name, const char *ret, ASTList params, ASTNode *body) {
+    ASTNode *n = new_node(u, AST_FUNCTION);
     n->function.name = name;
     n->function.ret_type = ret;
+    n->function.params = params;
     n->function.body = body;
     return n;
 }
 
-ASTNode *ast_block(ASTNode *stmts) {
-    ASTNode *n = new_node(AST_BLOCK);
+ASTNode *ast_param(ASTUnit *u, const char *name, const char *type) {
+    ASTNode *n = new_node(u, AST_PARAM);
+    n->param.name = name;
+    n->param.type = type;
+    return n;
+}
+
+ASTNode *ast_requires(ASTUnit *u, const char *name) {
+    ASTNode *n = new_node(u, AST_REQUIRES);
+    n->ident.name = name;
+    return n;
+}
+
+ASTNode *ast_exports(ASTUnit *u, const char *name) {
+    ASTNode *n = new_node(u, AST_EXPORTS);
+    n->ident.name = name;
+    return n;
+}
+
+ASTNode *ast_block(ASTUnit *u, ASTList stmts) {
+    ASTNode *n = new_node(u, AST_BLOCK);
     n->block.statements = stmts;
     return n;
 }
 
-ASTNode *ast_return(ASTNode *value) {
-    ASTNode *n = new_node(AST_RETURN);
+ASTNode *ast_return(ASTUnit *u, ASTNode *value) {
+    ASTNode *n = new_node(u, AST_RETURN);
     n->ret.value = value;
     return n;
 }
 
-ASTNode *ast_integer(unsigned long long v) {
-    ASTNode *n = new_node(AST_INTEGER);
+ASTNode *ast_var(ASTUnit *u, const char *name, const char *type, ASTNode *value) {
+    ASTNode *n = new_node(u, AST_VAR);
+    n->var.name = name;
+    n->var.type = type;
+    n->var.value = value;
+    return n;
+}
+
+ASTNode *ast_assign(ASTUnit *u, const char *name, ASTNode *value) {
+    ASTNode *n = new_node(u, AST_ASSIGN);
+    n->var.name = name;
+    n->var.value = value;
+    return n;
+}
+
+ASTNode *ast_if(ASTUnit *u, ASTNode *cond, ASTNode *then, ASTNode *otherwise) {
+    ASTNode *n = new_node(u, AST_IF);
+    n->branch.cond = cond;
+    n->branch.then = then;
+    n->branch.otherwise = otherwise;
+    return n;
+}
+
+ASTNode *ast_while(ASTUnit *u, ASTNode *cond, ASTNode *body) {
+    ASTNode *n = new_node(u, AST_WHILE);
+    n->branch.cond = cond;
+    n->branch.then = body;
+    return n;
+}
+
+ASTNode *ast_expr(ASTUnit *u, ASTNode *value) {
+    ASTNode *n = new_node(u, AST_EXPR);
+    n->expr.value = value;
+    return n;
+}
+
+ASTNode *ast_integer(ASTUnit *u, unsigned long long v) {
+    ASTNode *n = new_node(u, AST_INTEGER);
     n->integer = v;
     return n;
 }
 
-ASTNode *ast_bool(int v) {
-    ASTNode *n = new_node(AST_BOOL);
+ASTNode *ast_bool(ASTUnit *u, int v) {
+    ASTNode *n = new_node(u, AST_BOOL);
     n->boolean = v;
     return n;
 }
+
+ASTNode *ast_ident(ASTUnit *u, const char *name) {
+    ASTNode *n = new_node(u, AST_IDENT);
+    n->ident.name = name;
+    return n;
+}
+
+ASTNode *ast_call(ASTUnit *u, const char *name, ASTList args) {
+    ASTNode *n = new_node(u, AST_CALL);
+    n->call.name = name;
+    n->call.args = args;
+    return n;
+}
+
+ASTNode *ast_binary(ASTUnit *u, ASTOp op, ASTNode *lhs, ASTNode *rhs) {
+    ASTNode *n = new_node(u, AST_BINARY);
+    n->binary.op = op;
+    n->binary.lhs = lhs;
+    n->binary.rhs = rhs;
+    return n;
+}
+
+ASTNode *ast_unary(ASTUnit *u, ASTOp op, ASTNode *operand) {
+    ASTNode *n = new_node(u, AST_UNARY);
+    n->binary.op = op;
+    n->binary.lhs = operand;
+    return n;
+}
+
+ASTNode *ast_cast(ASTUnit *u, const char *type, ASTNode *value) {
+    ASTNode *n = new_node(u, AST_CAST);
+    n->line = value->line;
+    n->type = type;
+    n->expr.value = value;
+    return n;
+}
+
+ASTNode *ast_copy(ASTUnit *u, const ASTNode *from) {
+    ASTNode *n = unit_alloc(u, sizeof(ASTNode));
+
+    *n = *from;
+    return n;
+}
@@ -1,48 +1,196 @@
 #ifndef AST_H
 #define AST_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 typedef enum {
     AST_DRIVER,
     AST_FUNCTION,
+    AST_PARAM,
+    AST_REQUIRES,
+    AST_EXPORTS,
     AST_BLOCK,
     AST_RETURN,
+    AST_VAR,
+    AST_ASSIGN,
+    AST_IF,
+    AST_WHILE,
+    AST_EXPR,
     AST_INTEGER,
-    AST_BOOL
+    AST_BOOL,
+    AST_IDENT,
+    AST_CALL,
+    AST_BINARY,
+    AST_UNARY,
+    AST_CAST                    /* no syntax: the optimizer's, see optimize.c */
 } ASTKind;
 
+typedef enum {
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD,
+    OP_AND, OP_OR, OP_XOR, OP_SHL, OP_SHR,
+    OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE,
+    OP_LAND, OP_LOR,
+    OP_NEG, OP_NOT, OP_INV
+} ASTOp;
+
+/* Children: kids[first, first + count) of the unit, see ast_at() */
+typedef struct {
+    uint32_t first;
+    uint32_t count;
+} ASTList;
+
+/* Names (identifiers and types) are interned, so equal names are equal pointers */
 typedef struct ASTNode {
     ASTKind kind;
+    int line;
+    const char *type;                   /* expressions, from validate_driver(); NULL: an untyped literal */
     union {
         struct {
-            char *name;
-            struct ASTNode *body;
+            const char *name;
+            ASTList body;               /* functions, requires, exports */
         } driver;
 
         struct {
-            char *name;
-            char *ret_type;
+            const char *name;
+            const char *ret_type;       /* NULL: returns nothing */
+            ASTList params;
             struct ASTNode *body;
         } function;
 
         struct {
-            struct ASTNode *statements;
+            const char *name;
+            const char *type;
+        } param;
+
+        struct {
+            const char *name;           /* requires / exports / identifier */
+            struct ASTNode *decl;       /* identifier: its AST_VAR or AST_PARAM */
+        } ident;
+
+        struct {
+            ASTList statements;
         } block;
 
         struct {
-            struct ASTNode *value;
+            struct ASTNode *value;      /* NULL: return nothing */
         } ret;
 
+        struct {
+            const char *name;
+            const char *type;           /* NULL for an assignment */
+            struct ASTNode *value;
+            struct ASTNode *decl;       /* assignment: the variable's AST_VAR or AST_PARAM */
+            uint32_t stores, loads;     /* declaration: the optimizer's counts */
+        } var;
+
+        struct {
+            struct ASTNode *cond;
+            struct ASTNode *then;
+            struct ASTNode *otherwise;  /* NULL, or a block or an if */
+        } branch;
+
+        struct {
+            struct ASTNode *value;      /* AST_EXPR; AST_CAST: the value to bring within `type` */
+        } expr;
+
+        struct {
+            const char *name;
+            ASTList args;
+        } call;
+
+        struct {
+            ASTOp op;
+            struct ASTNode *lhs;
+            struct ASTNode *rhs;        /* NULL for unary operators */
+        } binary;
+
         unsigned long long integer;
         int boolean;
     };
-    struct ASTNode *next;
 } ASTNode;
 
-ASTNode *ast_driver(char *name, ASTNode *body);
-ASTNode *ast_function(char *name, char *ret, ASTNode *body);
-ASTNode *ast_block(ASTNode *stmts);
-ASTNode *ast_return(ASTNode *value);
-ASTNode *ast_integer(unsigned long long v);
-ASTNode *ast_bool(int v);
+typedef struct ASTChunk ASTChunk;
+
+typedef struct {
+    const char *name;
+    uint32_t hash;
+} ASTSymbol;
+
+/*
+ * One driver's worth of front end: every node and name comes from the
+ * unit's arena and goes with ast_unit_free(), so compiling many drivers
+ * in one process costs no more than the largest of them.
+ */
+typedef struct {
+    ASTChunk *chunks;
+
+    ASTSymbol *symbols;                 /* open addressing, power of two */
+    size_t symbol_count, symbol_cap;
+
+    ASTNode **kids;                     /* every finished list, back to back */
+    uint32_t kid_count, kid_cap;
+    ASTNode **pending;                  /* lists the parser is still adding to */
+    uint32_t pending_count, pending_cap;
+
+    ASTNode *root;
+    const char *sym_init;               /* "init", "bool" and "u64", interned */
+    const char *sym_bool;
+    const char *sym_u64;
+
+    const char *path;                   /* for messages */
+    int line;                           /* the lexer's, for new nodes */
+    int errors;                         /* ast_report()s */
+} ASTUnit;
+
+ASTUnit *ast_unit_new(const char *path);
+void ast_unit_free(ASTUnit *u);
+
+/*
+ * "path: line N: message" on stderr (line 0: no line), written in one
+ * piece even while other units compile on other threads; counts as an
+ * error of the unit.
+ */
+__attribute__((format(printf, 3, 4)))
+void ast_report(ASTUnit *u, int line, const char *fmt, ...);
+
+const char *ast_intern(ASTUnit *u, const char *s, size_t len);
+
+static inline ASTNode *ast_at(const ASTUnit *u, ASTList list, uint32_t i) {
+    return u->kids[list.first + i];
+}
+
+/*
+ * Lists as the parser builds them: ast_list_begin() where one starts,
+ * ast_list_push() per element, ast_list_end() once it is complete, which
+ * moves the elements into kids. Lists nest (a call's arguments inside a
+ * statement list), so begin / end pair up like brackets.
+ */
+uint32_t ast_list_begin(ASTUnit *u);
+void ast_list_push(ASTUnit *u, ASTNode *node);
+ASTList ast_list_end(ASTUnit *u, uint32_t mark);
+
+ASTNode *ast_driver(ASTUnit *u, const char *name, ASTList body);
+ASTNode *ast_function(ASTUnit *u, const char *name, const char *ret, ASTList params, ASTNode *body);
+ASTNode *ast_param(ASTUnit *u, const char *name, const char *type);
+ASTNode *ast_requires(ASTUnit *u, const char *name);
+ASTNode *ast_exports(ASTUnit *u, const char *name);
+ASTNode *ast_block(ASTUnit *u, ASTList stmts);
+ASTNode *ast_return(ASTUnit *u, ASTNode *value);
+ASTNode *ast_var(ASTUnit *u, const char *name, const char *type, ASTNode *value);
+ASTNode *ast_assign(ASTUnit *u, const char *name, ASTNode *value);
+ASTNode *ast_if(ASTUnit *u, ASTNode *cond, ASTNode *then, ASTNode *otherwise);
+ASTNode *ast_while(ASTUnit *u, ASTNode *cond, ASTNode *body);
+ASTNode *ast_expr(ASTUnit *u, ASTNode *value);
+ASTNode *ast_integer(ASTUnit *u, unsigned long long v);
+ASTNode *ast_bool(ASTUnit *u, int v);
+ASTNode *ast_ident(ASTUnit *u, const char *name);
+ASTNode *ast_call(ASTUnit *u, const char *name, ASTList args);
+ASTNode *ast_binary(ASTUnit *u, ASTOp op, ASTNode *lhs, ASTNode *rhs);
+ASTNode *ast_unary(ASTUnit *u, ASTOp op, ASTNode *operand);
+ASTNode *ast_cast(ASTUnit *u, const char *type, ASTNode *value);
+
+/* A new node with n's fields (lists and children shared), for passes that rewrite */
+ASTNode *ast_copy(ASTUnit *u, const ASTNode *n);
 
 #endif
@@ -0,0 +1,919 @@
+#include "writersc.h"
+#include "../../Platform/wscd/wscd.h"
+#include "../../Platform/crc32/crc32.h"
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * AST -> register bytecode.
+ *
+ * Each function gets a window of registers: parameters first, then
+ * locals as they are declared, then temporaries, which only live for the
+ * statement that made them. An expression is evaluated into a given
+ * register or, failing that, into the lowest free one, except that a
+ * variable is used where it lives. Calls put their arguments into the
+ * free registers at the top of the window, which is where the callee's
+ * window starts.
+ *
+ * Values are 64 bits wide in registers; stores into narrower variables,
+ * parameters and return values truncate (or sign-extend) to the declared
+ * type unless the value is known to fit.
+ */
+
+#define SIGN_UNSIGNED   0
+#define SIGN_SIGNED     1
+#define SIGN_NONE       2       /* literals: take the other operand's */
+
+typedef struct {
+    ASTNode *decl;              /* AST_VAR or AST_PARAM */
+    const char *type;
+    int reg;
+} Local;
+
+typedef struct {
+    ASTNode *node;
+    uint32_t code;
+    uint32_t length;
+    int nregs;
+    int nparams;
+    int flags;
+} Func;
+
+typedef struct {
+    const char *name;
+    int nargs;
+    int index;                  /* in the image, -1 until first called */
+} Import;
+
+typedef struct {
+    ASTUnit *unit;
+    Func funcs[WSCD_MAX_FUNCS];
+    int nfuncs;
+    Import imports[WSCD_MAX_IMPORTS];
+    int nimports;
+    int used_imports;
+    int import_order[WSCD_MAX_IMPORTS];
+
+    uint32_t *code;
+    size_t code_count, code_cap;
+    uint64_t *consts;
+    size_t const_count, const_cap;
+    char *strings;
+    size_t strings_size, strings_cap;
+
+    /* the function being lowered */
+    Func *fn;
+    Local locals[WSCD_MAX_REGS];
+    int nlocals;
+    int next;                   /* lowest free register */
+
+    int errors;
+} Codegen;
+
+__attribute__((format(printf, 3, 4)))
+static void error(Codegen *cg, ASTNode *at, const char *fmt, ...) {
+    char message[256];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(message, sizeof(message), fmt, ap);
+    va_end(ap);
+    ast_report(cg->unit, at ? at->line : 0, "%s", message);
+    cg->errors++;
+}
+
+static void *grow(void *p, size_t *cap, size_t need, size_t size) {
+    if (need <= *cap)
+        return p;
+    while (*cap < need)
+        *cap = *cap ? *cap * 2 : 64;
+    p = realloc(p, *cap * size);
+    if (!p) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+/* =========================
+ *  Pools
+ * ========================= */
+
+static uint32_t string_offset(Codegen *cg, const char *s) {
+    size_t len = strlen(s) + 1;
+
+    for (size_t off = 0; off < cg->strings_size; off += strlen(cg->strings + off) + 1)
+        if (strcmp(cg->strings + off, s) == 0)
+            return off;
+
+    cg->strings = grow(cg->strings, &cg->strings_cap, cg->strings_size + len, 1);
+    memcpy(cg->strings + cg->strings_size, s, len);
+    cg->strings_size += len;
+    return cg->strings_size - len;
+}
+
+static int const_index(Codegen *cg, uint64_t v) {
+    for (size_t i = 0; i < cg->const_count; i++)
+        if (cg->consts[i] == v)
+            return i;
+
+    cg->consts = grow(cg->consts, &cg->const_cap, cg->const_count + 1, sizeof(uint64_t));
+    cg->consts[cg->const_count] = v;
+    return cg->const_count++;
+}
+
+/* =========================
+ *  Emitting
+ * ========================= */
+
+static int emit(Codegen *cg, uint32_t ins) {
+    cg->code = grow(cg->code, &cg->code_cap, cg->code_count + 1, sizeof(uint32_t));
+    cg->code[cg->code_count] = ins;
+    return cg->code_count++;
+}
+
+static int here(Codegen *cg) {
+    return cg->code_count;
+}
+
+/* Point the jump at `at` to `target` */
+static void patch(Codegen *cg, ASTNode *node, int at, int target) {
+    uint32_t ins = cg->code[at];
+    int32_t delta = target - (at + 1);
+
+    if (WSCD_OP(ins) == WSCD_OP_JMP) {
+        if (delta < -(1 << 23) || delta >= (1 << 23))
+            error(cg, node, "function too large");
+        cg->code[at] = WSCD_AX(WSCD_OP_JMP, delta & 0xFFFFFF);
+    } else {
+        if (delta < INT16_MIN || delta > INT16_MAX)
+            error(cg, node, "branch too far");
+        cg->code[at] = WSCD_ABX(WSCD_OP(ins), WSCD_A(ins), delta);
+    }
+}
+
+static int reg_alloc(Codegen *cg, ASTNode *at) {
+    if (cg->next >= WSCD_MAX_REGS) {
+        error(cg, at, "%s(): out of registers", cg->fn->node->function.name);
+        return WSCD_MAX_REGS - 1;
+    }
+    int r = cg->next++;
+    if (cg->next > cg->fn->nregs)
+        cg->fn->nregs = cg->next;
+    return r;
+}
+
+static int target(Codegen *cg, ASTNode *at, int dst) {
+    return dst >= 0 ? dst : reg_alloc(cg, at);
+}
+
+static void load_const(Codegen *cg, int r, uint64_t v) {
+    int64_t s = (int64_t)v;
+
+    if (s >= INT16_MIN && s <= INT16_MAX) {
+        emit(cg, WSCD_ABX(WSCD_OP_LOADI, r, s));
+        return;
+    }
+    int k = const_index(cg, v);
+    if (k > 0xFFFF)
+        error(cg, NULL, "too many constants");
+    emit(cg, WSCD_ABX(WSCD_OP_LOADK, r, k));
+}
+
+/* =========================
+ *  Types
+ * ========================= */
+
+/* Identifiers point at their declarations (validate_driver()) */
+static Local *lookup(Codegen *cg, const ASTNode *decl) {
+    for (int i = cg->nlocals - 1; i >= 0; i--)
+        if (cg->locals[i].decl == decl)
+            return &cg->locals[i];
+    return NULL;
+}
+
+/* Names are interned (ast_intern()), so these compare pointers */
+static Func *find_func(Codegen *cg, const char *name) {
+    for (int i = 0; i < cg->nfuncs; i++)
+        if (cg->funcs[i].node->function.name == name)
+            return &cg->funcs[i];
+    return NULL;
+}
+
+static Import *find_import(Codegen *cg, const char *name) {
+    for (int i = 0; i < cg->nimports; i++)
+        if (cg->imports[i].name == name)
+            return &cg->imports[i];
+    return NULL;
+}
+
+/* C-like: unsigned wins, then signed; two literals stay open */
+static int combine(int l, int r) {
+    if (l == SIGN_UNSIGNED || r == SIGN_UNSIGNED)
+        return SIGN_UNSIGNED;
+    return l == SIGN_SIGNED || r == SIGN_SIGNED ? SIGN_SIGNED : SIGN_NONE;
+}
+
+static int sign_of(const ASTNode *e) {
+    if (!e->type)
+        return SIGN_NONE;
+    return type_signed(e->type) ? SIGN_SIGNED : SIGN_UNSIGNED;
+}
+
+/* R(r) = R(s), brought within `type` */
+static void narrow(Codegen *cg, int r, int s, const char *type) {
+    int bits = type_bits(type);
+
+    if (bits == 64) {
+        if (r != s)
+            emit(cg, WSCD_ABC(WSCD_OP_MOV, r, s, 0));
+        return;
+    }
+    if (bits == 1) {
+        emit(cg, WSCD_ABC(WSCD_OP_NOT, r, s, 0));
+        emit(cg, WSCD_ABC(WSCD_OP_NOT, r, r, 0));
+        return;
+    }
+    emit(cg, WSCD_ABC(WSCD_OP_EXT, r, s, bits | (type_signed(type) ? WSCD_EXT_SIGNED : 0)));
+}
+
+/* =========================
+ *  Expressions
+ * ========================= */
+
+static int gen_expr(Codegen *cg, ASTNode *e, int dst);
+
+static int gen_call(Codegen *cg, ASTNode *e, int dst) {
+    Func *f = find_func(cg, e->call.name);
+    Import *imp = f ? NULL : find_import(cg, e->call.name);
+    int top = cg->next;
+    int nargs = e->call.args.count;
+
+    for (int i = 0; i < nargs; i++) {
+        ASTNode *a = ast_at(cg->unit, e->call.args, i);
+        int r = reg_alloc(cg, a);
+
+        gen_expr(cg, a, r);
+        cg->next = r + 1;
+    }
+    if (!nargs)
+        reg_alloc(cg, e);           /* the result */
+
+    if (f) {
+        if (nargs != f->nparams)
+            error(cg, e, "wrong number of arguments to %s()", e->call.name);
+        emit(cg, WSCD_ABC(WSCD_OP_CALL, top, f - cg->funcs, nargs));
+    } else if (imp) {
+        if (imp->index < 0) {
+            imp->index = cg->used_imports;
+            imp->nargs = nargs;
+            cg->import_order[cg->used_imports++] = imp - cg->imports;
+        } else if (imp->nargs != nargs) {
+            error(cg, e, "%s() called with differing numbers of arguments", e->call.name);
+        }
+        emit(cg, WSCD_ABC(WSCD_OP_CALLN, top, imp->index, nargs));
+    } else {
+        error(cg, e, "%s() is neither defined nor required", e->call.name);
+    }
+
+    if (dst >= 0) {
+        cg->next = top;
+        if (dst != top)
+            emit(cg, WSCD_ABC(WSCD_OP_MOV, dst, top, 0));
+        return dst;
+    }
+    cg->next = top + 1;
+    return top;
+}
+
+/*
+ * && and || leave 0 or 1. They are worked out in a temporary: going
+ * straight into a variable would clobber it before the right-hand side
+ * (which may read it) runs.
+ */
+static int gen_logical(Codegen *cg, ASTNode *e, int dst) {
+    int top = cg->next;
+    int r = reg_alloc(cg, e);
+    int skip;
+
+    gen_expr(cg, e->binary.lhs, r);
+    if (e->binary.op == OP_LOR) {
+        emit(cg, WSCD_ABC(WSCD_OP_NOT, r, r, 0));
+        emit(cg, WSCD_ABC(WSCD_OP_NOT, r, r, 0));
+        skip = emit(cg, WSCD_ABX(WSCD_OP_JNZ, r, 0));
+    } else {
+        skip = emit(cg, WSCD_ABX(WSCD_OP_JZ, r, 0));
+    }
+    cg->next = r + 1;
+    gen_expr(cg, e->binary.rhs, r);
+    emit(cg, WSCD_ABC(WSCD_OP_NOT, r, r, 0));
+    emit(cg, WSCD_ABC(WSCD_OP_NOT, r, r, 0));
+    patch(cg, e, skip, here(cg));
+
+    if (dst >= 0) {
+        cg->next = top;
+        emit(cg, WSCD_ABC(WSCD_OP_MOV, dst, r, 0));
+        return dst;
+    }
+    cg->next = r + 1;
+    return r;
+}
+
+static int binary_op(ASTOp op, int sign) {
+    int s = sign == SIGN_SIGNED;
+
+    switch (op) {
+    case OP_ADD: return WSCD_OP_ADD;
+    case OP_SUB: return WSCD_OP_SUB;
+    case OP_MUL: return WSCD_OP_MUL;
+    case OP_DIV: return s ? WSCD_OP_DIVS : WSCD_OP_DIVU;
+    case OP_MOD: return s ? WSCD_OP_REMS : WSCD_OP_REMU;
+    case OP_AND: return WSCD_OP_AND;
+    case OP_OR:  return WSCD_OP_OR;
+    case OP_XOR: return WSCD_OP_XOR;
+    case OP_SHL: return WSCD_OP_SHL;
+    case OP_SHR: return s ? WSCD_OP_SHRS : WSCD_OP_SHRU;
+    case OP_EQ:  return WSCD_OP_EQ;
+    case OP_NE:  return WSCD_OP_NE;
+    case OP_LT:
+    case OP_GT:  return s ? WSCD_OP_LTS : WSCD_OP_LTU;
+    case OP_LE:
+    case OP_GE:  return s ? WSCD_OP_LES : WSCD_OP_LEU;
+    default:     return WSCD_OP_COUNT;
+    }
+}
+
+static int gen_binary(Codegen *cg, ASTNode *e, int dst) {
+    ASTOp op = e->binary.op;
+    ASTNode *rhs = e->binary.rhs;
+    int top = cg->next;
+
+    if (op == OP_LAND || op == OP_LOR)
+        return gen_logical(cg, e, dst);
+
+    int l = gen_expr(cg, e->binary.lhs, -1);
+
+    /* x + k, x - k with a small k */
+    if ((op == OP_ADD || op == OP_SUB) && rhs->kind == AST_INTEGER && rhs->integer <= 127) {
+        int imm = op == OP_ADD ? (int)rhs->integer : -(int)rhs->integer;
+
+        cg->next = top;
+        int r = target(cg, e, dst);
+        emit(cg, WSCD_ABC(WSCD_OP_ADDI, r, l, imm & 0xFF));
+        return r;
+    }
+
+    int rr = gen_expr(cg, rhs, -1);
+    /* comparisons go by their operands, everything else by its own type */
+    int sign = op >= OP_EQ ? combine(sign_of(e->binary.lhs), sign_of(rhs)) : sign_of(e);
+
+    cg->next = top;
+    int r = target(cg, e, dst);
+    if (op == OP_GT || op == OP_GE)
+        emit(cg, WSCD_ABC(binary_op(op, sign), r, rr, l));
+    else
+        emit(cg, WSCD_ABC(binary_op(op, sign), r, l, rr));
+    return r;
+}
+
+static int gen_expr(Codegen *cg, ASTNode *e, int dst) {
+    int r;
+
+    switch (e->kind) {
+    case AST_INTEGER:
+        r = target(cg, e, dst);
+        load_const(cg, r, e->integer);
+        return r;
+    case AST_BOOL:
+        r = target(cg, e, dst);
+        emit(cg, WSCD_ABX(WSCD_OP_LOADI, r, e->boolean));
+        return r;
+    case AST_IDENT: {
+        Local *l = lookup(cg, e->ident.decl);
+
+        if (dst < 0)
+            return l->reg;
+        if (dst != l->reg)
+            emit(cg, WSCD_ABC(WSCD_OP_MOV, dst, l->reg, 0));
+        return dst;
+    }
+    case AST_CALL:
+        return gen_call(cg, e, dst);
+    case AST_UNARY: {
+        static const int ops[] = { [OP_NEG] = WSCD_OP_NEG, [OP_NOT] = WSCD_OP_NOT,
+                                   [OP_INV] = WSCD_OP_INV };
+        int top = cg->next;
+        int s = gen_expr(cg, e->binary.lhs, -1);
+
+        cg->next = top;
+        r = target(cg, e, dst);
+        emit(cg, WSCD_ABC(ops[e->binary.op], r, s, 0));
+        return r;
+    }
+    case AST_BINARY:
+        return gen_binary(cg, e, dst);
+    case AST_CAST: {
+        int top = cg->next;
+        int s;
+
+        if (type_fits(e->expr.value, e->type))
+            return gen_expr(cg, e->expr.value, dst);
+        s = gen_expr(cg, e->expr.value, -1);
+        cg->next = top;
+        r = target(cg, e, dst);
+        narrow(cg, r, s, e->type);
+        return r;
+    }
+    default:
+        error(cg, e, "not an expression");
+        return target(cg, e, dst);
+    }
+}
+
+/* =========================
+ *  Statements
+ * ========================= */
+
+static void gen_block(Codegen *cg, ASTNode *block);
+
+static void gen_return(Codegen *cg, ASTNode *s) {
+    const char *type = cg->fn->node->function.ret_type;
+    int top = cg->next;
+    int r;
+
+    if (!s->ret.value) {
+        r = reg_alloc(cg, s);
+        emit(cg, WSCD_ABX(WSCD_OP_LOADI, r, 0));
+    } else {
+        r = gen_expr(cg, s->ret.value, -1);
+        if (!type_fits(s->ret.value, type)) {
+            int t = r < top ? reg_alloc(cg, s) : r;
+
+            narrow(cg, t, r, type);
+            r = t;
+        }
+    }
+    emit(cg, WSCD_ABC(WSCD_OP_RET, r, 0, 0));
+    cg->next = top;
+}
+
+/* Whether control never gets past `s` */
+static int returns(Codegen *cg, ASTNode *s) {
+    ASTList list;
+
+    switch (s->kind) {
+    case AST_RETURN:
+        return 1;
+    case AST_BLOCK:
+        list = s->block.statements;
+        return list.count && returns(cg, ast_at(cg->unit, list, list.count - 1));
+    case AST_IF:
+        return s->branch.otherwise && returns(cg, s->branch.then) &&
+               returns(cg, s->branch.otherwise);
+    default:
+        return 0;
+    }
+}
+
+static void declare(Codegen *cg, ASTNode *decl, const char *type, int reg) {
+    if (cg->nlocals == WSCD_MAX_REGS)
+        return;
+    cg->locals[cg->nlocals++] = (Local){ decl, type, reg };
+}
+
+static void gen_stmt(Codegen *cg, ASTNode *s) {
+    int top = cg->next;
+
+    switch (s->kind) {
+    case AST_RETURN:
+        gen_return(cg, s);
+        break;
+    case AST_VAR: {
+        /* anything but a variable comes back in the lowest free register */
+        int r = gen_expr(cg, s->var.value, -1);
+
+        int fits = type_fits(s->var.value, s->var.type);
+
+        if (r < top) {
+            cg->next = top;
+            int copy = reg_alloc(cg, s);
+            if (fits)
+                emit(cg, WSCD_ABC(WSCD_OP_MOV, copy, r, 0));
+            else
+                narrow(cg, copy, r, s->var.type);
+            r = copy;
+        } else if (!fits) {
+            narrow(cg, r, r, s->var.type);
+        }
+        cg->next = r + 1;
+        declare(cg, s, s->var.type, r);
+        break;
+    }
+    case AST_ASSIGN: {
+        Local *l = lookup(cg, s->var.decl);
+
+        gen_expr(cg, s->var.value, l->reg);
+        if (!type_fits(s->var.value, l->type))
+            narrow(cg, l->reg, l->reg, l->type);
+        cg->next = top;
+        break;
+    }
+    case AST_IF: {
+        int c = gen_expr(cg, s->branch.cond, -1);
+        cg->next = top;
+        int skip = emit(cg, WSCD_ABX(WSCD_OP_JZ, c, 0));
+
+        gen_block(cg, s->branch.then);
+        if (s->branch.otherwise) {
+            /*
+             * No jump over the else when the then part always returns; a
+             * ret at its end is not enough, as an if inside may jump past it.
+             */
+            int out = returns(cg, s->branch.then) ? -1 : emit(cg, WSCD_AX(WSCD_OP_JMP, 0));
+
+            patch(cg, s, skip, here(cg));
+            if (s->branch.otherwise->kind == AST_IF)
+                gen_stmt(cg, s->branch.otherwise);
+            else
+                gen_block(cg, s->branch.otherwise);
+            if (out >= 0)
+                patch(cg, s, out, here(cg));
+        } else {
+            patch(cg, s, skip, here(cg));
+        }
+        break;
+    }
+    case AST_WHILE: {
+        int start = here(cg);
+        int c = gen_expr(cg, s->branch.cond, -1);
+        cg->next = top;
+        int out = emit(cg, WSCD_ABX(WSCD_OP_JZ, c, 0));
+
+        gen_block(cg, s->branch.then);
+        patch(cg, s, emit(cg, WSCD_AX(WSCD_OP_JMP, 0)), start);
+        patch(cg, s, out, here(cg));
+        break;
+    }
+    case AST_BLOCK:
+        gen_block(cg, s);
+        break;
+    case AST_EXPR:
+        gen_expr(cg, s->expr.value, -1);
+        cg->next = top;
+        break;
+    default:
+        error(cg, s, "not a statement");
+        break;
+    }
+}
+
+static void gen_block(Codegen *cg, ASTNode *block) {
+    int nlocals = cg->nlocals;
+    int next = cg->next;
+
+    for (uint32_t i = 0; i < block->block.statements.count; i++)
+        gen_stmt(cg, ast_at(cg->unit, block->block.statements, i));
+
+    cg->nlocals = nlocals;
+    cg->next = next;
+}
+
+static void gen_function(Codegen *cg, Func *f) {
+    ASTNode *fn = f->node;
+
+    cg->fn = f;
+    cg->nlocals = 0;
+    cg->next = 0;
+    f->code = here(cg);
+
+    for (uint32_t i = 0; i < fn->function.params.count; i++) {
+        ASTNode *p = ast_at(cg->unit, fn->function.params, i);
+
+        declare(cg, p, p->param.type, reg_alloc(cg, p));
+        f->nparams++;
+    }
+    /* exported functions are called from C, which may leave high bits set */
+    for (int i = 0; i < f->nparams; i++)
+        narrow(cg, cg->locals[i].reg, cg->locals[i].reg, cg->locals[i].type);
+
+    gen_block(cg, fn->function.body);
+
+    if (!returns(cg, fn->function.body)) {
+        int r = reg_alloc(cg, fn);
+
+        emit(cg, WSCD_ABX(WSCD_OP_LOADI, r, 0));
+        emit(cg, WSCD_ABC(WSCD_OP_RET, r, 0, 0));
+        cg->next = 0;
+    }
+    f->length = here(cg) - f->code;
+}
+
+/* =========================
+ *  Listing
+ * ========================= */
+
+static const char *const op_names[WSCD_OP_COUNT] = {
+    "mov", "loadi", "loadk", "add", "addi", "sub", "mul", "divu", "divs", "remu", "rems",
+    "and", "or", "xor", "shl", "shru", "shrs", "eq", "ne", "ltu", "lts", "leu", "les",
+    "neg", "not", "inv", "ext", "jmp", "jz", "jnz", "call", "calln", "ret",
+};
+
+static void disassemble(Codegen *cg, ASTNode *d, FILE *out) {
+    fprintf(out, "driver %s: %d functions, %d imports, %zu constants, %zu instructions\n",
+            d->driver.name, cg->nfuncs, cg->used_imports, cg->const_count, cg->code_count);
+
+    for (int f = 0; f < cg->nfuncs; f++) {
+        Func *fn = &cg->funcs[f];
+
+        fprintf(out, "\nfn %s: %d params, %d registers%s\n", fn->node->function.name,
+                fn->nparams, fn->nregs, fn->flags & WSCD_FUNC_EXPORT ? ", exported" : "");
+
+        for (uint32_t pc = 0; pc < fn->length; pc++) {
+            uint32_t i = cg->code[fn->code + pc];
+            uint32_t op = WSCD_OP(i);
+
+            fprintf(out, "  %4u  %-6s", pc, op_names[op]);
+            switch (op) {
+            case WSCD_OP_LOADI:
+                fprintf(out, "r%u, %d\n", WSCD_A(i), WSCD_SBX(i));
+                break;
+            case WSCD_OP_LOADK:
+                fprintf(out, "r%u, #%u (0x%llx)\n", WSCD_A(i), WSCD_BX(i),
+                        (unsigned long long)cg->consts[WSCD_BX(i)]);
+                break;
+            case WSCD_OP_ADDI:
+                fprintf(out, "r%u, r%u, %d\n", WSCD_A(i), WSCD_B(i), (int8_t)WSCD_C(i));
+                break;
+            case WSCD_OP_MOV: case WSCD_OP_NEG: case WSCD_OP_NOT: case WSCD_OP_INV:
+                fprintf(out, "r%u, r%u\n", WSCD_A(i), WSCD_B(i));
+                break;
+            case WSCD_OP_EXT:
+                fprintf(out, "r%u, r%u, %c%u\n", WSCD_A(i), WSCD_B(i),
+                        WSCD_C(i) & WSCD_EXT_SIGNED ? 'i' : 'u', WSCD_C(i) & ~WSCD_EXT_SIGNED);
+                break;
+            case WSCD_OP_JMP:
+                fprintf(out, "%d\n", (int)pc + 1 + WSCD_SAX(i));
+                break;
+            case WSCD_OP_JZ: case WSCD_OP_JNZ:
+                fprintf(out, "r%u, %d\n", WSCD_A(i), (int)pc + 1 + WSCD_SBX(i));
+                break;
+            case WSCD_OP_CALL:
+                fprintf(out, "r%u, %s, %u\n", WSCD_A(i),
+                        cg->funcs[WSCD_B(i)].node->function.name, WSCD_C(i));
+                break;
+            case WSCD_OP_CALLN:
+                fprintf(out, "r%u, %s, %u\n", WSCD_A(i),
+                        cg->imports[cg->import_order[WSCD_B(i)]].name, WSCD_C(i));
+                break;
+            case WSCD_OP_RET:
+                fprintf(out, "r%u\n", WSCD_A(i));
+                break;
+            default:
+                fprintf(out, "r%u, r%u, r%u\n", WSCD_A(i), WSCD_B(i), WSCD_C(i));
+                break;
+            }
+        }
+    }
+}
+
+/* =========================
+ *  Image
+ * ========================= */
+
+static void put16(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    put16(p, v);
+    put16(p + 2, v >> 16);
+}
+
+static void put64(uint8_t *p, uint64_t v) {
+    put32(p, v);
+    put32(p + 4, v >> 32);
+}
+
+#define ALIGN8(x)       (((x) + 7) & ~(size_t)7)
+#define SECTIONS        6
+
+static int write_image(Codegen *cg, ASTNode *d, const char *path,
+                       const uint8_t *native, size_t native_size) {
+    uint32_t name = string_offset(cg, d->driver.name);
+    int init = WSCD_NO_FUNC;
+    int nsections = native ? SECTIONS : SECTIONS - 1;
+
+    uint32_t offsets[SECTIONS + 1];
+    uint32_t sizes[SECTIONS] = {
+        cg->nfuncs * sizeof(wscd_func_t),
+        cg->used_imports * sizeof(wscd_import_t),
+        cg->code_count * sizeof(uint32_t),
+        cg->const_count * sizeof(uint64_t),
+        cg->strings_size,
+        native_size,
+    };
+    static const uint32_t types[SECTIONS] = {
+        WSCD_SECTION_FUNCS, WSCD_SECTION_IMPORTS, WSCD_SECTION_CODE,
+        WSCD_SECTION_CONSTS, WSCD_SECTION_STRINGS, WSCD_SECTION_NATIVE,
+    };
+
+    offsets[0] = ALIGN8(sizeof(wscd_header_t) + nsections * sizeof(wscd_section_t));
+    for (int i = 0; i < nsections; i++)
+        offsets[i + 1] = ALIGN8(offsets[i] + sizes[i]);
+
+    size_t size = offsets[nsections];
+    uint8_t *image = calloc(1, size);
+    uint8_t *p;
+
+    if (!image) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    for (int i = 0; i < nsections; i++) {
+        p = image + sizeof(wscd_header_t) + i * sizeof(wscd_section_t);
+        put32(p, types[i]);
+        put32(p + 4, offsets[i]);
+        put32(p + 8, sizes[i]);
+    }
+
+    p = image + offsets[0];
+    for (int i = 0; i < cg->nfuncs; i++, p += sizeof(wscd_func_t)) {
+        Func *f = &cg->funcs[i];
+
+        if (f->node->function.name == cg->unit->sym_init)
+            init = i;
+        put32(p, string_offset(cg, f->node->function.name));
+        put32(p + 4, f->code);
+        put32(p + 8, f->length);
+        put16(p + 12, f->nregs);
+        p[14] = f->nparams;
+        p[15] = f->flags;
+    }
+
+    p = image + offsets[1];
+    for (int i = 0; i < cg->used_imports; i++, p += sizeof(wscd_import_t)) {
+        Import *imp = &cg->imports[cg->import_order[i]];
+
+        put32(p, string_offset(cg, imp->name));
+        put32(p + 4, imp->nargs);
+    }
+
+    p = image + offsets[2];
+    for (size_t i = 0; i < cg->code_count; i++, p += 4)
+        put32(p, cg->code[i]);
+
+    p = image + offsets[3];
+    for (size_t i = 0; i < cg->const_count; i++, p += 8)
+        put64(p, cg->consts[i]);
+
+    /* every name went in before the table was sized */
+    memcpy(image + offsets[4], cg->strings, cg->strings_size);
+    if (native)
+        memcpy(image + offsets[5], native, native_size);
+
+    p = image;
+    put32(p, WSCD_MAGIC);
+    put16(p + 4, WSCD_VERSION);
+    put16(p + 6, nsections);
+    put32(p + 8, size);
+    put32(p + 16, name);
+    put16(p + 20, init);
+    put32(p + 12, crc32_calculate(image + sizeof(wscd_header_t), size - sizeof(wscd_header_t)));
+
+    FILE *out = fopen(path, "wb");
+    int failed = !out || fwrite(image, 1, size, out) != size;
+
+    if (out && fclose(out))
+        failed = 1;
+    if (failed)
+        fprintf(stderr, "cannot write %s\n", path);
+    free(image);
+    return failed;
+}
+
+/* =========================
+ *  Driver
+ * ========================= */
+
+/* NULL when there is no aarch64 form for some function */
+static uint8_t *gen_native(Codegen *cg, size_t *size) {
+    IRFunc funcs[WSCD_MAX_FUNCS];
+    IRModule ir = {
+        .code = cg->code,
+        .consts = cg->consts,
+        .funcs = funcs,
+        .nfuncs = cg->nfuncs,
+        .nimports = cg->used_imports,
+    };
+    uint8_t *native;
+
+    for (int i = 0; i < cg->nfuncs; i++) {
+        Func *f = &cg->funcs[i];
+
+        funcs[i] = (IRFunc){ f->code, f->length, f->nregs, f->nparams };
+    }
+    return native_aarch64(&ir, &native, size) == 0 ? native : NULL;
+}
+
+/* The driver's functions and imports, lowered into a new Codegen */
+static Codegen *lower(ASTUnit *u) {
+    Codegen *cg = calloc(1, sizeof(Codegen));
+    ASTNode *d = u->root;
+    ASTList body = d->driver.body;
+
+    if (!cg) {
+        fprintf(stderr, "out of memory\n");
+        return NULL;
+    }
+
+    cg->unit = u;
+    string_offset(cg, "");
+    string_offset(cg, d->driver.name);
+
+    for (uint32_t i = 0; i < body.count; i++) {
+        ASTNode *n = ast_at(u, body, i);
+
+        if (n->kind == AST_FUNCTION) {
+            if (cg->nfuncs == WSCD_MAX_FUNCS) {
+                error(cg, n, "too many functions");
+                break;
+            }
+            cg->funcs[cg->nfuncs++].node = n;
+            string_offset(cg, n->function.name);
+        } else if (n->kind == AST_REQUIRES && !find_import(cg, n->ident.name)) {
+            if (cg->nimports == WSCD_MAX_IMPORTS) {
+                error(cg, n, "too many required functions");
+                break;
+            }
+            cg->imports[cg->nimports++] = (Import){ n->ident.name, 0, -1 };
+            string_offset(cg, n->ident.name);
+        }
+    }
+    for (uint32_t i = 0; i < body.count; i++) {
+        ASTNode *n = ast_at(u, body, i);
+        Func *f = n->kind == AST_EXPORTS ? find_func(cg, n->ident.name) : NULL;
+
+        if (f)
+            f->flags |= WSCD_FUNC_EXPORT;
+    }
+
+    for (int i = 0; i < cg->nfuncs; i++)
+        gen_function(cg, &cg->funcs[i]);
+    return cg;
+}
+
+static void codegen_free(Codegen *cg) {
+    free(cg->code);
+    free(cg->consts);
+    free(cg->strings);
+    free(cg);
+}
+
+int codegen_sizes(ASTUnit *u, CodeSize *sizes, int max) {
+    Codegen *cg = lower(u);
+    int n = -1;
+
+    if (!cg)
+        return -1;
+    if (!cg->errors) {
+        for (n = 0; n < cg->nfuncs && n < max; n++)
+            sizes[n] = (CodeSize){ cg->funcs[n].node->function.name, cg->funcs[n].length };
+    }
+    codegen_free(cg);
+    return n;
+}
+
+int codegen_driver(ASTUnit *u, const char *out_path, FILE *listing, int bytecode_only) {
+    Codegen *cg = lower(u);
+    ASTNode *d = u->root;
+    int errors;
+
+    if (!cg)
+        return 1;
+
+    errors = cg->errors;
+    if (!errors) {
+        uint8_t *native = NULL;
+        size_t native_size = 0;
+
+        if (!bytecode_only)
+            native = gen_native(cg, &native_size);
+        if (listing) {
+            disassemble(cg, d, listing);
+            if (native)
+                fprintf(listing, "\nnative aarch64: %zu bytes\n", native_size);
+            else if (!bytecode_only)
+                fprintf(listing, "\nno native section: some function has no aarch64 form\n");
+        }
+        errors = write_image(cg, d, out_path, native, native_size);
+        free(native);
+    }
+
+    codegen_free(cg);
+    return errors;
+}
@@ -0,0 +1,1041 @@
+#include "writersc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The middle end: rewrites a validated driver in place, between
+ * validate_driver() and codegen_driver().
+ *
+ * Each function is simplified over and over until nothing changes:
+ * operators on constants are worked out the way the interpreter would,
+ * a variable that is only ever given a constant becomes that constant,
+ * an if on a constant keeps the branch it takes, and code after a
+ * return, stores nobody reads and values nobody wants go. Then calls to
+ * small functions (and to functions called only once) are inlined, which
+ * gives the constants more to work on, and functions neither init() nor
+ * the exports can reach are dropped.
+ *
+ * Every rewrite keeps the type of what it replaces, signedness included,
+ * since the instructions around it are chosen by it (semantic.c). Where
+ * an inlined value is not already within the type that the call would
+ * have given it, an AST_CAST brings it there.
+ */
+
+#define MAX_ROUNDS      8
+#define INLINE_NODES    12      /* small enough to inline wherever it is called */
+#define INLINE_ONCE     256     /* ... or once, when that is the only call */
+#define INLINE_PARAMS   8
+#define INLINE_DEPTH    8
+
+#define INLINE_EXPR     1       /* fn f(..) -> T { return <expr>; } */
+#define INLINE_STMT     2       /* returns nothing, and has no return */
+
+typedef struct {
+    ASTNode *fn;
+    int calls;                  /* call sites, once inlining starts */
+    int root;                   /* init() or exported */
+    int reachable;
+} FuncInfo;
+
+typedef struct {
+    ASTUnit *u;
+    FuncInfo *funcs;
+    int nfuncs;
+
+    ASTNode *fn;                /* being simplified */
+    int inlining;
+    ASTNode *active[INLINE_DEPTH];  /* being inlined into it, innermost last */
+    int depth;
+    int changed;
+} Opt;
+
+/* Declarations of the copied code, and what stands in for them in the copy */
+typedef struct {
+    const ASTNode **from;
+    ASTNode **to;
+    int count, cap;
+    int expr;                   /* `to` are values (arguments), not declarations */
+} Remap;
+
+static FuncInfo *find(Opt *o, const char *name) {
+    for (int i = 0; i < o->nfuncs; i++)
+        if (o->funcs[i].fn->function.name == name)
+            return &o->funcs[i];
+    return NULL;
+}
+
+static ASTNode *changed(Opt *o, ASTNode *n) {
+    o->changed = 1;
+    return n;
+}
+
+static int is_const(const ASTNode *e) {
+    return e->kind == AST_INTEGER || e->kind == AST_BOOL;
+}
+
+static uint64_t value_of(const ASTNode *e) {
+    return e->kind == AST_BOOL ? (uint64_t)e->boolean : e->integer;
+}
+
+static ASTNode *constant(Opt *o, const ASTNode *at, uint64_t v, const char *type) {
+    ASTNode *n = ast_integer(o->u, v);
+
+    n->line = at->line;
+    n->type = type;
+    return n;
+}
+
+/* Whether `b` can stand in for `a` as far as the surrounding instructions go */
+static int same_sign(const ASTNode *a, const ASTNode *b) {
+    return !a->type == !b->type && type_signed(a->type) == type_signed(b->type);
+}
+
+/* No calls: evaluating it has no effect but its value (x / 0 does not trap) */
+static int pure(const ASTNode *e) {
+    switch (e->kind) {
+    case AST_CALL:
+        return 0;
+    case AST_UNARY:
+        return pure(e->binary.lhs);
+    case AST_BINARY:
+        return pure(e->binary.lhs) && pure(e->binary.rhs);
+    case AST_CAST:
+        return pure(e->expr.value);
+    default:
+        return 1;
+    }
+}
+
+/* Known to be 0 or 1, and a bool */
+static int zero_one(Opt *o, const ASTNode *e) {
+    if (e->type != o->u->sym_bool)
+        return 0;
+    if (e->kind == AST_BINARY)
+        return e->binary.op >= OP_EQ;
+    if (e->kind == AST_UNARY)
+        return e->binary.op == OP_NOT;
+    return e->kind == AST_IDENT || e->kind == AST_CALL || e->kind == AST_CAST;
+}
+
+/* Nodes in `n`, counting stops a little past `limit` */
+static int size_of(Opt *o, const ASTNode *n, int limit) {
+    int size = 1;
+    ASTList list = { 0, 0 };
+
+    switch (n->kind) {
+    case AST_BLOCK:
+        list = n->block.statements;
+        break;
+    case AST_CALL:
+        list = n->call.args;
+        break;
+    case AST_RETURN:
+        return n->ret.value ? 1 + size_of(o, n->ret.value, limit) : 1;
+    case AST_VAR:
+    case AST_ASSIGN:
+        return 1 + size_of(o, n->var.value, limit);
+    case AST_EXPR:
+    case AST_CAST:
+        return 1 + size_of(o, n->expr.value, limit);
+    case AST_UNARY:
+        return 1 + size_of(o, n->binary.lhs, limit);
+    case AST_BINARY:
+        size += size_of(o, n->binary.lhs, limit);
+        return size > limit ? size : size + size_of(o, n->binary.rhs, limit - size);
+    case AST_IF:
+    case AST_WHILE:
+        size += size_of(o, n->branch.cond, limit);
+        if (size <= limit)
+            size += size_of(o, n->branch.then, limit - size);
+        if (size <= limit && n->branch.otherwise)
+            size += size_of(o, n->branch.otherwise, limit - size);
+        return size;
+    default:
+        return 1;
+    }
+    for (uint32_t i = 0; i < list.count && size <= limit; i++)
+        size += size_of(o, ast_at(o->u, list, i), limit - size);
+    return size;
+}
+
+/* =========================
+ *  Counting
+ * ========================= */
+
+/*
+ * Loads and stores of every variable in `s`. A declaration comes before
+ * any use of it, so its counts start over where the walk meets it;
+ * counting code twice only makes the counts too high, which is safe.
+ */
+static void count_expr(Opt *o, ASTNode *e) {
+    switch (e->kind) {
+    case AST_IDENT:
+        if (e->ident.decl->kind == AST_VAR)
+            e->ident.decl->var.loads++;
+        break;
+    case AST_CALL:
+        for (uint32_t i = 0; i < e->call.args.count; i++)
+            count_expr(o, ast_at(o->u, e->call.args, i));
+        break;
+    case AST_BINARY:
+        count_expr(o, e->binary.rhs);
+        /* fall through */
+    case AST_UNARY:
+        count_expr(o, e->binary.lhs);
+        break;
+    case AST_CAST:
+        count_expr(o, e->expr.value);
+        break;
+    default:
+        break;
+    }
+}
+
+static void count_stmt(Opt *o, ASTNode *s) {
+    switch (s->kind) {
+    case AST_RETURN:
+        if (s->ret.value)
+            count_expr(o, s->ret.value);
+        break;
+    case AST_VAR:
+        s->var.stores = s->var.loads = 0;
+        count_expr(o, s->var.value);
+        break;
+    case AST_ASSIGN:
+        if (s->var.decl->kind == AST_VAR)
+            s->var.decl->var.stores++;
+        count_expr(o, s->var.value);
+        break;
+    case AST_IF:
+    case AST_WHILE:
+        count_expr(o, s->branch.cond);
+        count_stmt(o, s->branch.then);
+        if (s->branch.otherwise)
+            count_stmt(o, s->branch.otherwise);
+        break;
+    case AST_BLOCK:
+        for (uint32_t i = 0; i < s->block.statements.count; i++)
+            count_stmt(o, ast_at(o->u, s->block.statements, i));
+        break;
+    case AST_EXPR:
+        count_expr(o, s->expr.value);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Calls to each function in `n`, into FuncInfo.calls */
+static void count_calls(Opt *o, const ASTNode *n) {
+    ASTList list = { 0, 0 };
+
+    switch (n->kind) {
+    case AST_CALL: {
+        FuncInfo *f = find(o, n->call.name);
+
+        if (f)
+            f->calls++;
+        list = n->call.args;
+        break;
+    }
+    case AST_BLOCK:
+        list = n->block.statements;
+        break;
+    case AST_RETURN:
+        if (n->ret.value)
+            count_calls(o, n->ret.value);
+        return;
+    case AST_VAR:
+    case AST_ASSIGN:
+        count_calls(o, n->var.value);
+        return;
+    case AST_EXPR:
+    case AST_CAST:
+        count_calls(o, n->expr.value);
+        return;
+    case AST_BINARY:
+        count_calls(o, n->binary.rhs);
+        /* fall through */
+    case AST_UNARY:
+        count_calls(o, n->binary.lhs);
+        return;
+    case AST_IF:
+    case AST_WHILE:
+        count_calls(o, n->branch.cond);
+        count_calls(o, n->branch.then);
+        if (n->branch.otherwise)
+            count_calls(o, n->branch.otherwise);
+        return;
+    default:
+        return;
+    }
+    for (uint32_t i = 0; i < list.count; i++)
+        count_calls(o, ast_at(o->u, list, i));
+}
+
+/* =========================
+ *  Copying
+ * ========================= */
+
+static void remap_add(Remap *r, const ASTNode *from, ASTNode *to) {
+    if (r->count == r->cap) {
+        r->cap = r->cap ? r->cap * 2 : 16;
+        r->from = realloc(r->from, r->cap * sizeof(*r->from));
+        r->to = realloc(r->to, r->cap * sizeof(*r->to));
+        if (!r->from || !r->to) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    r->from[r->count] = from;
+    r->to[r->count++] = to;
+}
+
+static ASTNode *remap_find(const Remap *r, const ASTNode *from) {
+    for (int i = 0; i < r->count; i++)
+        if (r->from[i] == from)
+            return r->to[i];
+    return NULL;
+}
+
+static ASTNode *clone(Opt *o, Remap *r, const ASTNode *n);
+
+static ASTList clone_list(Opt *o, Remap *r, ASTList list) {
+    uint32_t mark = ast_list_begin(o->u);
+
+    for (uint32_t i = 0; i < list.count; i++)
+        ast_list_push(o->u, clone(o, r, ast_at(o->u, list, i)));
+    return ast_list_end(o->u, mark);
+}
+
+/* A deep copy of `n`, its declarations new and its uses of r->from replaced */
+static ASTNode *clone(Opt *o, Remap *r, const ASTNode *n) {
+    ASTNode *to = NULL;
+    ASTNode *c;
+
+    if (n->kind == AST_IDENT && (to = remap_find(r, n->ident.decl)) && r->expr) {
+        Remap plain = { 0 };
+
+        return clone(o, &plain, to);
+    }
+
+    c = ast_copy(o->u, n);
+    switch (n->kind) {
+    case AST_IDENT:
+        if (to)
+            c->ident.decl = to;
+        break;
+    case AST_CALL:
+        c->call.args = clone_list(o, r, n->call.args);
+        break;
+    case AST_BINARY:
+        c->binary.rhs = clone(o, r, n->binary.rhs);
+        /* fall through */
+    case AST_UNARY:
+        c->binary.lhs = clone(o, r, n->binary.lhs);
+        break;
+    case AST_CAST:
+    case AST_EXPR:
+        c->expr.value = clone(o, r, n->expr.value);
+        break;
+    case AST_RETURN:
+        if (n->ret.value)
+            c->ret.value = clone(o, r, n->ret.value);
+        break;
+    case AST_VAR:
+        c->var.value = clone(o, r, n->var.value);
+        remap_add(r, n, c);
+        break;
+    case AST_ASSIGN:
+        c->var.value = clone(o, r, n->var.value);
+        if ((to = remap_find(r, n->var.decl)))
+            c->var.decl = to;
+        break;
+    case AST_IF:
+    case AST_WHILE:
+        c->branch.cond = clone(o, r, n->branch.cond);
+        c->branch.then = clone(o, r, n->branch.then);
+        if (n->branch.otherwise)
+            c->branch.otherwise = clone(o, r, n->branch.otherwise);
+        break;
+    case AST_BLOCK:
+        c->block.statements = clone_list(o, r, n->block.statements);
+        break;
+    default:
+        break;
+    }
+    return c;
+}
+
+/* =========================
+ *  Expressions
+ * ========================= */
+
+/* `e` as 0 or 1 */
+static ASTNode *truth(Opt *o, ASTNode *e, const ASTNode *at) {
+    ASTNode *n;
+
+    if (zero_one(o, e))
+        return e;
+    n = ast_binary(o->u, OP_NE, e, constant(o, at, 0, NULL));
+    n->line = at->line;
+    n->type = o->u->sym_bool;
+    return n;
+}
+
+static ASTNode *fold(Opt *o, ASTNode *e);
+
+/* && and ||: the right-hand side only runs when the left does not decide */
+static ASTNode *fold_logical(Opt *o, ASTNode *e) {
+    ASTNode *l = e->binary.lhs, *r = e->binary.rhs;
+    int decides = e->binary.op == OP_LOR;       /* the value of l or r that settles it */
+
+    if (is_const(l)) {
+        if ((value_of(l) != 0) == decides)
+            return changed(o, constant(o, e, decides, e->type));
+        return changed(o, truth(o, r, e));
+    }
+    if (is_const(r)) {
+        if ((value_of(r) != 0) != decides)
+            return changed(o, truth(o, l, e));
+        if (pure(l))
+            return changed(o, constant(o, e, decides, e->type));
+    }
+    return e;
+}
+
+static ASTNode *fold_binary(Opt *o, ASTNode *e) {
+    ASTOp op = e->binary.op;
+    ASTNode *l = e->binary.lhs = fold(o, e->binary.lhs);
+    ASTNode *r = e->binary.rhs = fold(o, e->binary.rhs);
+
+    if (op == OP_LAND || op == OP_LOR)
+        return fold_logical(o, e);
+    if (is_const(l) && is_const(r))
+        return changed(o, constant(o, e, op_compute(op, op_signed(e), value_of(l), value_of(r)), e->type));
+
+    /* x + 0, x * 1, 0 | x and the like */
+    if (is_const(r) && same_sign(e, l)) {
+        uint64_t k = value_of(r);
+
+        if ((k == 0 && (op == OP_ADD || op == OP_SUB || op == OP_OR || op == OP_XOR ||
+                        op == OP_SHL || op == OP_SHR)) ||
+            (k == 1 && (op == OP_MUL || op == OP_DIV)))
+            return changed(o, l);
+    }
+    if (is_const(l) && same_sign(e, r)) {
+        uint64_t k = value_of(l);
+
+        if ((k == 0 && (op == OP_ADD || op == OP_OR || op == OP_XOR)) || (k == 1 && op == OP_MUL))
+            return changed(o, r);
+    }
+    return e;
+}
+
+static ASTNode *fold_unary(Opt *o, ASTNode *e) {
+    ASTNode *v = e->binary.lhs = fold(o, e->binary.lhs);
+
+    if (is_const(v))
+        return changed(o, constant(o, e, op_compute(e->binary.op, 0, value_of(v), 0), e->type));
+
+    /* !(a < b) is a >= b, and so on */
+    if (e->binary.op == OP_NOT && v->kind == AST_BINARY &&
+        v->binary.op >= OP_EQ && v->binary.op <= OP_GE) {
+        static const ASTOp inverse[] = {
+            [OP_EQ] = OP_NE, [OP_NE] = OP_EQ, [OP_LT] = OP_GE,
+            [OP_LE] = OP_GT, [OP_GT] = OP_LE, [OP_GE] = OP_LT,
+        };
+
+        v->binary.op = inverse[v->binary.op];
+        return changed(o, v);
+    }
+    return e;
+}
+
+static ASTNode *fold_cast(Opt *o, ASTNode *e) {
+    ASTNode *v = e->expr.value = fold(o, e->expr.value);
+
+    if (is_const(v))
+        return changed(o, constant(o, e, type_narrow(e->type, value_of(v)), e->type));
+    if (type_fits(v, e->type) && same_sign(e, v))
+        return changed(o, v);
+    return e;
+}
+
+/* A variable only ever given a constant is that constant */
+static ASTNode *fold_ident(Opt *o, ASTNode *e) {
+    ASTNode *decl = e->ident.decl;
+
+    if (decl->kind != AST_VAR || decl->var.stores || !is_const(decl->var.value))
+        return e;
+    return changed(o, constant(o, e, type_narrow(decl->var.type, value_of(decl->var.value)),
+                               decl->var.type));
+}
+
+/*
+ * What an argument becomes in the inlined body: a use of the parameter
+ * is of the parameter's type, brought within it on the way in.
+ */
+static ASTNode *bind(Opt *o, ASTNode *arg, const char *type) {
+    if (is_const(arg))
+        return constant(o, arg, type_narrow(type, value_of(arg)), type);
+    if (arg->type && type_signed(arg->type) == type_signed(type) && type_fits(arg, type))
+        return arg;
+    return ast_cast(o->u, type, arg);
+}
+
+static int uses(Opt *o, const ASTNode *e, const ASTNode *decl) {
+    switch (e->kind) {
+    case AST_IDENT:
+        return e->ident.decl == decl;
+    case AST_CALL: {
+        int n = 0;
+
+        for (uint32_t i = 0; i < e->call.args.count; i++)
+            n += uses(o, ast_at(o->u, e->call.args, i), decl);
+        return n;
+    }
+    case AST_BINARY:
+        return uses(o, e->binary.lhs, decl) + uses(o, e->binary.rhs, decl);
+    case AST_UNARY:
+        return uses(o, e->binary.lhs, decl);
+    case AST_CAST:
+        return uses(o, e->expr.value, decl);
+    default:
+        return 0;
+    }
+}
+
+/* Whether there is a `kind` statement in `s` */
+static int contains(Opt *o, const ASTNode *s, ASTKind kind) {
+    if (s->kind == kind)
+        return 1;
+    switch (s->kind) {
+    case AST_BLOCK:
+        for (uint32_t i = 0; i < s->block.statements.count; i++)
+            if (contains(o, ast_at(o->u, s->block.statements, i), kind))
+                return 1;
+        return 0;
+    case AST_IF:
+    case AST_WHILE:
+        return contains(o, s->branch.then, kind) ||
+               (s->branch.otherwise && contains(o, s->branch.otherwise, kind));
+    default:
+        return 0;
+    }
+}
+
+/* How `f` may be inlined here, if it may */
+static int inline_kind(Opt *o, FuncInfo *f) {
+    ASTNode *fn = f->fn;
+    ASTList body = fn->function.body->block.statements;
+    int limit = f->calls == 1 && !f->root ? INLINE_ONCE : INLINE_NODES;
+
+    if (!o->inlining || fn == o->fn || o->depth == INLINE_DEPTH ||
+        fn->function.params.count > INLINE_PARAMS)
+        return 0;
+    for (int i = 0; i < o->depth; i++)
+        if (o->active[i] == fn)
+            return 0;
+    if (size_of(o, fn->function.body, limit) > limit)
+        return 0;
+    /* a loop runs as often either way: copies of it would only save the call */
+    if (limit == INLINE_NODES && contains(o, fn->function.body, AST_WHILE))
+        return 0;
+
+    if (fn->function.ret_type) {
+        ASTNode *only = body.count == 1 ? ast_at(o->u, body, 0) : NULL;
+
+        return only && only->kind == AST_RETURN && only->ret.value ? INLINE_EXPR : 0;
+    }
+    /* a return anywhere but at the end would need a jump out of the copy */
+    for (uint32_t i = 0; i < body.count; i++) {
+        ASTNode *s = ast_at(o->u, body, i);
+
+        if (s->kind == AST_RETURN && i == body.count - 1 && !s->ret.value)
+            continue;
+        if (contains(o, s, AST_RETURN))
+            return 0;
+    }
+    return INLINE_STMT;
+}
+
+static ASTNode *inline_expr(Opt *o, ASTNode *e) {
+    FuncInfo *f = find(o, e->call.name);
+    ASTNode *fn = f ? f->fn : NULL;
+    Remap r = { .expr = 1 };
+    ASTNode *result;
+
+    if (!f || inline_kind(o, f) != INLINE_EXPR)
+        return e;
+
+    ASTList params = fn->function.params;
+    ASTList args = e->call.args;
+    ASTNode *body = ast_at(o->u, fn->function.body->block.statements, 0)->ret.value;
+    const char *ret = fn->function.ret_type;
+
+    for (uint32_t i = 0; i < args.count; i++) {
+        ASTNode *arg = ast_at(o->u, args, i);
+        ASTNode *p = ast_at(o->u, params, i);
+
+        /* arguments are worked out once, before the body: keep to ones that can move */
+        if (!pure(arg) ||
+            (uses(o, body, p) > 1 && !is_const(arg) && arg->kind != AST_IDENT)) {
+            free(r.from);
+            free(r.to);
+            return e;
+        }
+    }
+    for (uint32_t i = 0; i < args.count; i++) {
+        ASTNode *p = ast_at(o->u, params, i);
+
+        remap_add(&r, p, bind(o, ast_at(o->u, args, i), p->param.type));
+    }
+
+    result = clone(o, &r, body);
+    free(r.from);
+    free(r.to);
+    f->calls--;
+    count_calls(o, result);
+    if (!(result->type && type_signed(result->type) == type_signed(ret) && type_fits(result, ret)))
+        result = ast_cast(o->u, ret, result);
+    result->line = e->line;
+
+    o->active[o->depth++] = fn;
+    result = fold(o, result);
+    o->depth--;
+    return changed(o, result);
+}
+
+static ASTNode *fold(Opt *o, ASTNode *e) {
+    switch (e->kind) {
+    case AST_IDENT:
+        return fold_ident(o, e);
+    case AST_CALL:
+        for (uint32_t i = 0; i < e->call.args.count; i++) {
+            /* not a pointer into kids: folding can make it move */
+            ASTNode *arg = fold(o, ast_at(o->u, e->call.args, i));
+
+            o->u->kids[e->call.args.first + i] = arg;
+        }
+        return inline_expr(o, e);
+    case AST_UNARY:
+        return fold_unary(o, e);
+    case AST_BINARY:
+        return fold_binary(o, e);
+    case AST_CAST:
+        return fold_cast(o, e);
+    default:
+        return e;
+    }
+}
+
+/* =========================
+ *  Statements
+ * ========================= */
+
+static int simplify_stmt(Opt *o, ASTNode *s);
+
+/* A constant stored into `type` is stored already narrowed */
+static void store_constant(Opt *o, ASTNode **value, const char *type) {
+    if (type && is_const(*value) && !type_fits(*value, type))
+        *value = changed(o, constant(o, *value, type_narrow(type, value_of(*value)), type));
+}
+
+/* A store nobody reads: only the calls in the value are left */
+static int drop_store(Opt *o, ASTNode *s) {
+    o->changed = 1;
+    if (!pure(s->var.value)) {
+        ASTNode *e = ast_expr(o->u, s->var.value);
+
+        e->line = s->line;
+        ast_list_push(o->u, e);
+    }
+    return 0;
+}
+
+static ASTNode *simplify_block(Opt *o, ASTNode *block, int *ends) {
+    ASTList list = block->block.statements;
+    uint32_t mark = ast_list_begin(o->u);
+    uint32_t i;
+    int done = 0;
+
+    for (i = 0; i < list.count && !done; i++)
+        done = simplify_stmt(o, ast_at(o->u, list, i));
+    if (i < list.count)
+        o->changed = 1;         /* past a return */
+
+    block->block.statements = ast_list_end(o->u, mark);
+    *ends = done;
+    return block;
+}
+
+/* An else part: NULL once empty, else a block or an if */
+static ASTNode *simplify_else(Opt *o, ASTNode *s, int *ends) {
+    uint32_t mark = ast_list_begin(o->u);
+    ASTList list;
+    ASTNode *n;
+
+    *ends = simplify_stmt(o, s);
+    list = ast_list_end(o->u, mark);
+    if (!list.count)
+        return NULL;
+    n = ast_at(o->u, list, 0);
+    if (list.count == 1 && (n->kind == AST_BLOCK || n->kind == AST_IF))
+        return n;
+    n = ast_block(o->u, list);
+    n->line = s->line;
+    return n;
+}
+
+static int declares(Opt *o, const ASTNode *block) {
+    for (uint32_t i = 0; i < block->block.statements.count; i++)
+        if (ast_at(o->u, block->block.statements, i)->kind == AST_VAR)
+            return 1;
+    return 0;
+}
+
+static int simplify_if(Opt *o, ASTNode *s) {
+    ASTNode *cond = s->branch.cond = fold(o, s->branch.cond);
+    int then_ends, else_ends = 0;
+
+    if (is_const(cond)) {
+        ASTNode *taken = value_of(cond) ? s->branch.then : s->branch.otherwise;
+
+        o->changed = 1;
+        return taken ? simplify_stmt(o, taken) : 0;
+    }
+
+    simplify_block(o, s->branch.then, &then_ends);
+    if (s->branch.otherwise)
+        s->branch.otherwise = simplify_else(o, s->branch.otherwise, &else_ends);
+
+    if (!s->branch.then->block.statements.count) {
+        if (!s->branch.otherwise) {
+            o->changed = 1;
+            if (!pure(cond)) {
+                ASTNode *e = ast_expr(o->u, cond);
+
+                e->line = s->line;
+                ast_list_push(o->u, e);
+            }
+            return 0;
+        }
+        /* if (c) { } else x: if (!c) x */
+        ASTNode *otherwise = s->branch.otherwise;
+        ASTNode *not = ast_unary(o->u, OP_NOT, cond);
+
+        not->line = cond->line;
+        not->type = o->u->sym_bool;
+        s->branch.cond = fold(o, not);
+        if (otherwise->kind != AST_BLOCK) {
+            uint32_t mark = ast_list_begin(o->u);
+
+            ast_list_push(o->u, otherwise);
+            otherwise = ast_block(o->u, ast_list_end(o->u, mark));
+            otherwise->line = s->line;
+        }
+        s->branch.then = otherwise;
+        s->branch.otherwise = NULL;
+        o->changed = 1;
+        ast_list_push(o->u, s);
+        return 0;
+    }
+
+    ast_list_push(o->u, s);
+    return s->branch.otherwise && then_ends && else_ends;
+}
+
+/*
+ * A call to a function that returns nothing: its body, in a block that
+ * starts by declaring the parameters as variables given the arguments
+ * (which brings them within their types, as a call would).
+ */
+static int inline_stmt(Opt *o, ASTNode *e) {
+    FuncInfo *f = find(o, e->call.name);
+    Remap r = { 0 };
+
+    if (!f || inline_kind(o, f) != INLINE_STMT)
+        return 0;
+
+    ASTNode *fn = f->fn;
+    ASTList params = fn->function.params;
+    ASTList body = fn->function.body->block.statements;
+    uint32_t mark = ast_list_begin(o->u);
+    ASTNode *block;
+
+    for (uint32_t i = 0; i < params.count; i++) {
+        ASTNode *p = ast_at(o->u, params, i);
+        ASTNode *v = ast_var(o->u, p->param.name, p->param.type, ast_at(o->u, e->call.args, i));
+
+        v->line = e->line;
+        remap_add(&r, p, v);
+        ast_list_push(o->u, v);
+    }
+    for (uint32_t i = 0; i < body.count; i++) {
+        ASTNode *s = ast_at(o->u, body, i);
+
+        if (s->kind != AST_RETURN)
+            ast_list_push(o->u, clone(o, &r, s));
+    }
+    block = ast_block(o->u, ast_list_end(o->u, mark));
+    block->line = e->line;
+    free(r.from);
+    free(r.to);
+    f->calls--;
+    count_calls(o, block);
+
+    count_stmt(o, block);
+    o->active[o->depth++] = fn;
+    simplify_stmt(o, block);
+    o->depth--;
+    o->changed = 1;
+    return 1;
+}
+
+/* Pushes what is left of `s` onto the list being built; 1 if control never gets past it */
+static int simplify_stmt(Opt *o, ASTNode *s) {
+    int ends = 0;
+
+    switch (s->kind) {
+    case AST_RETURN:
+        if (s->ret.value) {
+            s->ret.value = fold(o, s->ret.value);
+            store_constant(o, &s->ret.value, o->fn->function.ret_type);
+        }
+        ast_list_push(o->u, s);
+        return 1;
+    case AST_VAR:
+        s->var.value = fold(o, s->var.value);
+        if (!s->var.loads)
+            return drop_store(o, s);
+        store_constant(o, &s->var.value, s->var.type);
+        break;
+    case AST_ASSIGN:
+        s->var.value = fold(o, s->var.value);
+        if (s->var.decl->kind == AST_VAR && !s->var.decl->var.loads)
+            return drop_store(o, s);
+        store_constant(o, &s->var.value,
+                       s->var.decl->kind == AST_VAR ? s->var.decl->var.type : s->var.decl->param.type);
+        break;
+    case AST_IF:
+        return simplify_if(o, s);
+    case AST_WHILE:
+        s->branch.cond = fold(o, s->branch.cond);
+        if (is_const(s->branch.cond) && !value_of(s->branch.cond)) {
+            o->changed = 1;
+            return 0;
+        }
+        simplify_block(o, s->branch.then, &ends);
+        ast_list_push(o->u, s);
+        /* there is no break: only a return leaves while (true) */
+        return is_const(s->branch.cond);
+    case AST_BLOCK:
+        if (declares(o, s)) {
+            simplify_block(o, s, &ends);
+            if (s->block.statements.count)
+                ast_list_push(o->u, s);
+            return ends;
+        }
+        /* nothing to scope: the statements join the enclosing list */
+        for (uint32_t i = 0; i < s->block.statements.count && !ends; i++)
+            ends = simplify_stmt(o, ast_at(o->u, s->block.statements, i));
+        return ends;
+    case AST_EXPR:
+        s->expr.value = fold(o, s->expr.value);
+        if (pure(s->expr.value)) {
+            o->changed = 1;
+            return 0;
+        }
+        if (s->expr.value->kind == AST_CALL && inline_stmt(o, s->expr.value))
+            return 0;
+        break;
+    default:
+        break;
+    }
+    ast_list_push(o->u, s);
+    return 0;
+}
+
+static void simplify_function(Opt *o, ASTNode *fn) {
+    int ends;
+
+    o->fn = fn;
+    for (int round = 0; round < MAX_ROUNDS; round++) {
+        o->changed = 0;
+        count_stmt(o, fn->function.body);
+        simplify_block(o, fn->function.body, &ends);
+        if (!o->changed)
+            break;
+    }
+}
+
+/* =========================
+ *  Functions
+ * ========================= */
+
+static void reach(Opt *o, FuncInfo *f);
+
+static void reach_calls(Opt *o, const ASTNode *n) {
+    ASTList list = { 0, 0 };
+
+    switch (n->kind) {
+    case AST_CALL: {
+        FuncInfo *f = find(o, n->call.name);
+
+        if (f)
+            reach(o, f);
+        list = n->call.args;
+        break;
+    }
+    case AST_BLOCK:
+        list = n->block.statements;
+        break;
+    case AST_RETURN:
+        if (n->ret.value)
+            reach_calls(o, n->ret.value);
+        return;
+    case AST_VAR:
+    case AST_ASSIGN:
+        reach_calls(o, n->var.value);
+        return;
+    case AST_EXPR:
+    case AST_CAST:
+        reach_calls(o, n->expr.value);
+        return;
+    case AST_BINARY:
+        reach_calls(o, n->binary.rhs);
+        /* fall through */
+    case AST_UNARY:
+        reach_calls(o, n->binary.lhs);
+        return;
+    case AST_IF:
+    case AST_WHILE:
+        reach_calls(o, n->branch.cond);
+        reach_calls(o, n->branch.then);
+        if (n->branch.otherwise)
+            reach_calls(o, n->branch.otherwise);
+        return;
+    default:
+        return;
+    }
+    for (uint32_t i = 0; i < list.count; i++)
+        reach_calls(o, ast_at(o->u, list, i));
+}
+
+static void reach(Opt *o, FuncInfo *f) {
+    if (f->reachable)
+        return;
+    f->reachable = 1;
+    reach_calls(o, f->fn->function.body);
+}
+
+/* The loader only calls init() and the exports (wscd_find()) */
+static void drop_unreachable(Opt *o) {
+    ASTNode *d = o->u->root;
+    ASTList body = d->driver.body;
+    uint32_t mark;
+
+    for (int i = 0; i < o->nfuncs; i++)
+        if (o->funcs[i].root)
+            reach(o, &o->funcs[i]);
+
+    mark = ast_list_begin(o->u);
+    for (uint32_t i = 0; i < body.count; i++) {
+        ASTNode *n = ast_at(o->u, body, i);
+
+        if (n->kind != AST_FUNCTION || find(o, n->function.name)->reachable)
+            ast_list_push(o->u, n);
+    }
+    d->driver.body = ast_list_end(o->u, mark);
+}
+
+/* =========================
+ *  Report
+ * ========================= */
+
+static int functions(const ASTUnit *u) {
+    ASTList body = u->root->driver.body;
+    int n = 0;
+
+    for (uint32_t i = 0; i < body.count; i++)
+        n += ast_at(u, body, i)->kind == AST_FUNCTION;
+    return n;
+}
+
+static void report_sizes(FILE *out, const CodeSize *before, int nbefore,
+                         const CodeSize *after, int nafter) {
+    uint32_t total_before = 0, total_after = 0;
+
+    for (int i = 0; i < nbefore; i++)
+        total_before += before[i].instructions;
+    for (int i = 0; i < nafter; i++)
+        total_after += after[i].instructions;
+
+    fprintf(out, "optimized: %u -> %u instructions\n", total_before, total_after);
+    for (int i = 0; i < nbefore; i++) {
+        const CodeSize *now = NULL;
+
+        for (int k = 0; k < nafter && !now; k++)
+            if (after[k].name == before[i].name)
+                now = &after[k];
+        if (now)
+            fprintf(out, "  %-24s %6u -> %u\n", before[i].name, before[i].instructions,
+                    now->instructions);
+        else
+            fprintf(out, "  %-24s %6u -> removed\n", before[i].name, before[i].instructions);
+    }
+    fputc('\n', out);
+}
+
+void optimize_driver(ASTUnit *u, FILE *report) {
+    ASTList body = u->root->driver.body;
+    Opt o = { .u = u };
+    CodeSize *before = NULL;
+    int nbefore = -1;
+
+    o.funcs = calloc(functions(u) + 1, sizeof(FuncInfo));
+    if (!o.funcs) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (uint32_t i = 0; i < body.count; i++) {
+        ASTNode *n = ast_at(u, body, i);
+
+        if (n->kind == AST_FUNCTION)
+            o.funcs[o.nfuncs++] = (FuncInfo){ .fn = n, .root = n->function.name == u->sym_init };
+    }
+    for (uint32_t i = 0; i < body.count; i++) {
+        ASTNode *n = ast_at(u, body, i);
+
+        if (n->kind == AST_EXPORTS)
+            find(&o, n->ident.name)->root = 1;
+    }
+
+    if (report && (before = malloc((o.nfuncs + 1) * sizeof(CodeSize))))
+        nbefore = codegen_sizes(u, before, o.nfuncs);
+
+    /* folding first, so that inlining sees how big the functions really are */
+    for (int i = 0; i < o.nfuncs; i++)
+        simplify_function(&o, o.funcs[i].fn);
+
+    for (int i = 0; i < o.nfuncs; i++)
+        count_calls(&o, o.funcs[i].fn->function.body);
+    o.inlining = 1;
+    for (int i = 0; i < o.nfuncs; i++)
+        simplify_function(&o, o.funcs[i].fn);
+
+    drop_unreachable(&o);
+
+    if (nbefore >= 0) {
+        CodeSize *after = malloc((o.nfuncs + 1) * sizeof(CodeSize));
+        int nafter = after ? codegen_sizes(u, after, o.nfuncs) : -1;
+
+        if (nafter >= 0)
+            report_sizes(report, before, nbefore, after, nafter);
+        free(after);
+    }
+    free(before);
+    free(o.funcs);
+}
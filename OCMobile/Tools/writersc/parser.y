@@ -1,76 +1,205 @@
-%{
+%code requires {
 #include "ast.h"
-#include <stdio.h>
 
-extern int yylex();
-void yyerror(const char *s);
-ASTNode *root;
-%}
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+}
+
+%code {
+#include "writersc.h"
+#include "lex.yy.h"
+
+static void yyerror(yyscan_t scanner, ASTUnit *unit, const char *s);
+}
+
+%define api.pure full
+%param {yyscan_t scanner}
+%parse-param {ASTUnit *unit}
 
 %union {
-    char *string;
+    const char *string;
     unsigned long long integer;
     int boolean;
     ASTNode *node;
+    uint32_t list;              /* ast_list_begin() mark */
 }
 
-%token DRIVER STRUCT FN INIT REQUIRES EXPORTS RETURN IF ELSE UNSAFE
-%token TYPE IDENT INTEGER BOOL
-%token ARROW
+%token DRIVER STRUCT FN INIT REQUIRES EXPORTS RETURN IF ELSE UNSAFE WHILE
+%token <string> TYPE IDENT
+%token <integer> INTEGER
+%token <boolean> BOOL
+%token ARROW EQ NE LE GE SHL SHR LAND LOR
+
+%type <node> program driver fn_decl param block stmt if_stmt expr
+%type <list> items params param_list stmt_list args arg_list
+%type <string> fn_name
 
-%type <node> program driver fn_decl block stmt expr
+%left LOR
+%left LAND
+%left '|'
+%left '^'
+%left '&'
+%left EQ NE
+%left '<' '>' LE GE
+%left SHL SHR
+%left '+' '-'
+%left '*' '/' '%'
+%precedence UNARY
 
 %%
 
 program:
-    driver { root = $1; }
+    driver { unit->root = $1; }
 ;
 
 driver:
-    DRIVER IDENT '{' driver_body '}' {
-        $$ = ast_driver($2, $4);
+    DRIVER IDENT '{' items '}' {
+        $$ = ast_driver(unit, $2, ast_list_end(unit, $4));
     }
 ;
 
-driver_body:
-    fn_decl
-    | driver_body fn_decl
+items:
+    %empty { $$ = ast_list_begin(unit); }
+    | items item
+;
+
+item:
+    fn_decl { ast_list_push(unit, $1); }
+    | REQUIRES requires_list ';'
+    | EXPORTS exports_list ';'
+;
+
+requires_list:
+    IDENT { ast_list_push(unit, ast_requires(unit, $1)); }
+    | requires_list ',' IDENT { ast_list_push(unit, ast_requires(unit, $3)); }
+;
+
+exports_list:
+    fn_name { ast_list_push(unit, ast_exports(unit, $1)); }
+    | exports_list ',' fn_name { ast_list_push(unit, ast_exports(unit, $3)); }
+;
+
+fn_name:
+    IDENT
+    | INIT { $$ = unit->sym_init; }
 ;
 
 fn_decl:
-    FN IDENT '(' ')' ARROW TYPE block {
-        $$ = ast_function($2, $6, $7);
+    FN fn_name '(' params ')' ARROW TYPE block {
+        $$ = ast_function(unit, $2, $7, ast_list_end(unit, $4), $8);
+    }
+    | FN fn_name '(' params ')' block {
+        $$ = ast_function(unit, $2, NULL, ast_list_end(unit, $4), $6);
     }
 ;
 
+params:
+    %empty { $$ = ast_list_begin(unit); }
+    | param_list
+;
+
+param_list:
+    param { $$ = ast_list_begin(unit); ast_list_push(unit, $1); }
+    | param_list ',' param { ast_list_push(unit, $3); }
+;
+
+param:
+    IDENT ':' TYPE { $$ = ast_param(unit, $1, $3); }
+;
+
 block:
     '{' stmt_list '}' {
-        $$ = ast_block($2);
+        $$ = ast_block(unit, ast_list_end(unit, $2));
     }
 ;
 
 stmt_list:
-    stmt
-    | stmt_list stmt
+    %empty { $$ = ast_list_begin(unit); }
+    | stmt_list stmt { ast_list_push(unit, $2); }
 ;
 
 stmt:
     RETURN expr ';' {
-        $$ = ast_return($2);
+        $$ = ast_return(unit, $2);
     }
+    | RETURN ';' { $$ = ast_return(unit, NULL); }
+    | IDENT ':' TYPE '=' expr ';' { $$ = ast_var(unit, $1, $3, $5); }
+    | IDENT '=' expr ';' { $$ = ast_assign(unit, $1, $3); }
+    | if_stmt
+    | WHILE '(' expr ')' block { $$ = ast_while(unit, $3, $5); }
+    | UNSAFE block { $$ = $2; }
+    | block
+    | expr ';' { $$ = ast_expr(unit, $1); }
+;
+
+if_stmt:
+    IF '(' expr ')' block { $$ = ast_if(unit, $3, $5, NULL); }
+    | IF '(' expr ')' block ELSE block { $$ = ast_if(unit, $3, $5, $7); }
+    | IF '(' expr ')' block ELSE if_stmt { $$ = ast_if(unit, $3, $5, $7); }
 ;
 
 expr:
     INTEGER {
-        $$ = ast_integer($1);
+        $$ = ast_integer(unit, $1);
     }
     | BOOL {
-        $$ = ast_bool($1);
+        $$ = ast_bool(unit, $1);
     }
+    | IDENT { $$ = ast_ident(unit, $1); }
+    | IDENT '(' args ')' { $$ = ast_call(unit, $1, ast_list_end(unit, $3)); }
+    | '(' expr ')' { $$ = $2; }
+    | expr '+' expr { $$ = ast_binary(unit, OP_ADD, $1, $3); }
+    | expr '-' expr { $$ = ast_binary(unit, OP_SUB, $1, $3); }
+    | expr '*' expr { $$ = ast_binary(unit, OP_MUL, $1, $3); }
+    | expr '/' expr { $$ = ast_binary(unit, OP_DIV, $1, $3); }
+    | expr '%' expr { $$ = ast_binary(unit, OP_MOD, $1, $3); }
+    | expr '&' expr { $$ = ast_binary(unit, OP_AND, $1, $3); }
+    | expr '|' expr { $$ = ast_binary(unit, OP_OR, $1, $3); }
+    | expr '^' expr { $$ = ast_binary(unit, OP_XOR, $1, $3); }
+    | expr SHL expr { $$ = ast_binary(unit, OP_SHL, $1, $3); }
+    | expr SHR expr { $$ = ast_binary(unit, OP_SHR, $1, $3); }
+    | expr EQ expr { $$ = ast_binary(unit, OP_EQ, $1, $3); }
+    | expr NE expr { $$ = ast_binary(unit, OP_NE, $1, $3); }
+    | expr '<' expr { $$ = ast_binary(unit, OP_LT, $1, $3); }
+    | expr LE expr { $$ = ast_binary(unit, OP_LE, $1, $3); }
+    | expr '>' expr { $$ = ast_binary(unit, OP_GT, $1, $3); }
+    | expr GE expr { $$ = ast_binary(unit, OP_GE, $1, $3); }
+    | expr LAND expr { $$ = ast_binary(unit, OP_LAND, $1, $3); }
+    | expr LOR expr { $$ = ast_binary(unit, OP_LOR, $1, $3); }
+    | '-' expr %prec UNARY { $$ = ast_unary(unit, OP_NEG, $2); }
+    | '!' expr %prec UNARY { $$ = ast_unary(unit, OP_NOT, $2); }
+    | '~' expr %prec UNARY { $$ = ast_unary(unit, OP_INV, $2); }
+;
+
+args:
+    %empty { $$ = ast_list_begin(unit); }
+    | arg_list
+;
+
+arg_list:
+    expr { $$ = ast_list_begin(unit); ast_list_push(unit, $1); }
+    | arg_list ',' expr { ast_list_push(unit, $3); }
 ;
 
 %%
 
-void yyerror(const char *s) {
-    fprintf(stderr, "Parser error: %s\n", s);
+static void yyerror(yyscan_t scanner, ASTUnit *unit, const char *s) {
+    (void)scanner;
+    ast_report(unit, unit->line, "%s", s);
+}
+
+int parse_driver(ASTUnit *u, FILE *in) {
+    yyscan_t scanner;
+    int r;
+
+    if (yylex_init_extra(u, &scanner)) {
+        ast_report(u, 0, "out of memory");
+        return 1;
+    }
+    yyset_in(in, scanner);
+    r = yyparse(scanner, u);
+    yylex_destroy(scanner);
+    return r || u->errors;
 }
@@ -1,20 +1,440 @@
-#include "ast.h"
+#include "writersc.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-void validate_driver(ASTNode *d) {
-    int has_init = 0;
-    ASTNode *fn = d->driver.body;
+/*
+ * Names and types. Every identifier is resolved to its declaration
+ * (ident.decl / var.decl) and every expression gets the type the code
+ * generator works by (ASTNode.type):
+ *
+ *   literals           none (NULL): they take the other operand's sign
+ *   variables, calls   as declared; required functions give u64
+ *   ! == < && ...       bool
+ *   - ~ << >>          the (left) operand's
+ *   others             unsigned if either operand is, else signed if
+ *                      either is, else none; the wider of the two
+ *
+ * Values are 64 bits wide until they are stored; a store (variable,
+ * argument, return value) brings them within the declared type.
+ */
 
-    while (fn) {
-        if (fn->kind == AST_FUNCTION &&
-            strcmp(fn->function.name, "init") == 0) {
-            has_init = 1;
+/* =========================
+ *  Types
+ * ========================= */
+
+int type_bits(const char *type) {
+    if (!type)
+        return 64;
+    if (strcmp(type, "bool") == 0)
+        return 1;
+    if (strcmp(type, "usize") == 0)
+        return 64;
+    return atoi(type + 1);
+}
+
+int type_signed(const char *type) {
+    return type && type[0] == 'i';
+}
+
+int same_type(const char *a, const char *b) {
+    return type_bits(a) == type_bits(b) && type_signed(a) == type_signed(b);
+}
+
+uint64_t type_narrow(const char *type, uint64_t v) {
+    int bits = type_bits(type);
+
+    if (bits == 64)
+        return v;
+    if (bits == 1)
+        return v != 0;
+    v <<= 64 - bits;
+    return type_signed(type) ? (uint64_t)((int64_t)v >> (64 - bits)) : v >> (64 - bits);
+}
+
+/* codegen_driver()'s pick between the signed and the unsigned instruction */
+int op_signed(const ASTNode *e) {
+    const ASTNode *l = e->binary.lhs, *r = e->binary.rhs;
+
+    if (e->kind != AST_BINARY || e->binary.op < OP_EQ)
+        return type_signed(e->type);
+    if ((l->type && !type_signed(l->type)) || (r->type && !type_signed(r->type)))
+        return 0;
+    return type_signed(l->type) || type_signed(r->type);
+}
+
+/* What the interpreter (and the native code) computes, see wscd.c */
+uint64_t op_compute(ASTOp op, int s, uint64_t a, uint64_t b) {
+    int64_t sa = (int64_t)a, sb = (int64_t)b;
+
+    switch (op) {
+    case OP_ADD:  return a + b;
+    case OP_SUB:  return a - b;
+    case OP_MUL:  return a * b;
+    case OP_DIV:
+        if (!b)
+            return 0;
+        return !s ? a / b : sb == -1 ? -a : (uint64_t)(sa / sb);
+    case OP_MOD:
+        if (!b)
+            return a;
+        return !s ? a % b : sb == -1 ? 0 : (uint64_t)(sa % sb);
+    case OP_AND:  return a & b;
+    case OP_OR:   return a | b;
+    case OP_XOR:  return a ^ b;
+    case OP_SHL:  return a << (b & 63);
+    case OP_SHR:  return s ? (uint64_t)(sa >> (b & 63)) : a >> (b & 63);
+    case OP_EQ:   return a == b;
+    case OP_NE:   return a != b;
+    case OP_LT:   return s ? sa < sb : a < b;
+    case OP_LE:   return s ? sa <= sb : a <= b;
+    case OP_GT:   return s ? sa > sb : a > b;
+    case OP_GE:   return s ? sa >= sb : a >= b;
+    case OP_LAND: return a && b;
+    case OP_LOR:  return a || b;
+    case OP_NEG:  return -a;
+    case OP_NOT:  return !a;
+    case OP_INV:  return ~a;
+    }
+    return 0;
+}
+
+static int is_boolean(const ASTNode *e) {
+    if (e->kind == AST_BOOL)
+        return 1;
+    if (e->kind == AST_UNARY)
+        return e->binary.op == OP_NOT;
+    return e->kind == AST_BINARY && e->binary.op >= OP_EQ && e->binary.op <= OP_LOR;
+}
+
+int type_fits(const ASTNode *e, const char *type) {
+    if (type_bits(type) == 64 || is_boolean(e))
+        return 1;
+    switch (e->kind) {
+    case AST_INTEGER:
+        return type_narrow(type, e->integer) == e->integer;
+    case AST_IDENT:
+    case AST_CALL:
+    case AST_CAST:
+        return same_type(e->type, type);
+    default:
+        return 0;
+    }
+}
+
+/* C-like: unsigned wins, then signed, then the wider */
+static const char *combine(const char *a, const char *b) {
+    if (!a || !b)
+        return a ? a : b;
+    if (type_signed(a) != type_signed(b))
+        return type_signed(a) ? b : a;
+    return type_bits(b) > type_bits(a) ? b : a;
+}
+
+/* =========================
+ *  Checking
+ * ========================= */
+
+typedef struct {
+    const char *name;
+    ASTNode *decl;
+} Binding;
+
+typedef struct {
+    ASTUnit *u;
+    ASTNode *fn;
+    Binding *scope;             /* innermost last */
+    size_t depth, cap;
+} Checker;
+
+/* Names are interned, so a pointer compare finds the function */
+static ASTNode *find_function(const ASTUnit *u, const char *name) {
+    ASTList body = u->root->driver.body;
+
+    for (uint32_t i = 0; i < body.count; i++) {
+        ASTNode *n = ast_at(u, body, i);
+
+        if (n->kind == AST_FUNCTION && n->function.name == name)
+            return n;
+    }
+    return NULL;
+}
+
+static int is_required(const ASTUnit *u, const char *name) {
+    ASTList body = u->root->driver.body;
+
+    for (uint32_t i = 0; i < body.count; i++) {
+        ASTNode *n = ast_at(u, body, i);
+
+        if (n->kind == AST_REQUIRES && n->ident.name == name)
+            return 1;
+    }
+    return 0;
+}
+
+static ASTNode *lookup(Checker *c, const char *name) {
+    for (size_t i = c->depth; i-- > 0;)
+        if (c->scope[i].name == name)
+            return c->scope[i].decl;
+    return NULL;
+}
+
+/* Names declared since `scope` are the current block's */
+static void declare(Checker *c, size_t scope, const char *name, ASTNode *decl) {
+    for (size_t i = scope; i < c->depth; i++)
+        if (c->scope[i].name == name)
+            ast_report(c->u, decl->line, "%s declared twice", name);
+
+    if (c->depth == c->cap) {
+        c->cap = c->cap ? c->cap * 2 : 32;
+        c->scope = realloc(c->scope, c->cap * sizeof(Binding));
+        if (!c->scope) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
         }
-        fn = fn->next;
     }
+    c->scope[c->depth++] = (Binding){ name, decl };
+}
 
-    if (!has_init) {
-        fprintf(stderr, "Driver missing init() function\n");
+static const char *decl_type(const ASTNode *decl) {
+    return decl->kind == AST_PARAM ? decl->param.type : decl->var.type;
+}
+
+/* The value of an expression of literals alone, as the optimizer folds it */
+static int constant_value(const ASTNode *e, uint64_t *v) {
+    uint64_t a, b;
+
+    switch (e->kind) {
+    case AST_INTEGER:
+        *v = e->integer;
+        return 1;
+    case AST_BOOL:
+        *v = e->boolean;
+        return 1;
+    case AST_UNARY:
+        if (!constant_value(e->binary.lhs, &a))
+            return 0;
+        *v = op_compute(e->binary.op, 0, a, 0);
+        return 1;
+    case AST_BINARY:
+        if (!constant_value(e->binary.lhs, &a) || !constant_value(e->binary.rhs, &b))
+            return 0;
+        *v = op_compute(e->binary.op, op_signed(e), a, b);
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/*
+ * A constant that cannot be stored into `type`: 0 - 129 is no i8. A
+ * negative one goes into an unsigned type as long as its magnitude fits
+ * (-1 is all ones).
+ */
+static void check_store(Checker *c, ASTNode *value, const char *type, const char *what) {
+    int bits = type_bits(type);
+    uint64_t v, max;
+    int64_t s;
+    int fits;
+
+    if (bits == 64 || !constant_value(value, &v))
+        return;
+    max = bits == 1 ? 1 : (1ull << (bits - type_signed(type))) - 1;
+    s = (int64_t)v;
+    if (type_signed(type))
+        fits = s >= -(int64_t)max - 1 && s <= (int64_t)max;
+    else
+        fits = v <= max || (s < 0 && bits > 1 && -v <= max);
+    if (fits)
+        return;
+    if (s < 0)
+        ast_report(c->u, value->line, "%lld does not fit %s %s", (long long)s, what, type);
+    else
+        ast_report(c->u, value->line, "%llu does not fit %s %s", (unsigned long long)v, what, type);
+}
+
+static const char *check_expr(Checker *c, ASTNode *e, int used);
+
+static const char *check_call(Checker *c, ASTNode *e, int used) {
+    ASTNode *f = find_function(c->u, e->call.name);
+    ASTList args = e->call.args;
+
+    for (uint32_t i = 0; i < args.count; i++)
+        check_expr(c, ast_at(c->u, args, i), 1);
+
+    if (f) {
+        ASTList params = f->function.params;
+
+        if (args.count != params.count) {
+            ast_report(c->u, e->line, "wrong number of arguments to %s()", e->call.name);
+        } else {
+            for (uint32_t i = 0; i < args.count; i++)
+                check_store(c, ast_at(c->u, args, i), ast_at(c->u, params, i)->param.type,
+                            "parameter of type");
+        }
+        if (used && !f->function.ret_type)
+            ast_report(c->u, e->line, "%s() returns nothing", e->call.name);
+        return f->function.ret_type;
+    }
+    if (!is_required(c->u, e->call.name))
+        ast_report(c->u, e->line, "%s() is neither defined nor required", e->call.name);
+    return c->u->sym_u64;
+}
+
+/* `used`: the value is wanted, so it has to be there */
+static const char *check_expr(Checker *c, ASTNode *e, int used) {
+    const char *l, *r;
+
+    switch (e->kind) {
+    case AST_INTEGER:
+    case AST_BOOL:
+        e->type = NULL;
+        break;
+    case AST_IDENT:
+        e->ident.decl = lookup(c, e->ident.name);
+        if (!e->ident.decl) {
+            ast_report(c->u, e->line, "%s is not declared", e->ident.name);
+            e->type = NULL;
+        } else {
+            e->type = decl_type(e->ident.decl);
+        }
+        break;
+    case AST_CALL:
+        e->type = check_call(c, e, used);
+        break;
+    case AST_UNARY:
+        l = check_expr(c, e->binary.lhs, 1);
+        e->type = e->binary.op == OP_NOT ? c->u->sym_bool : l;
+        break;
+    case AST_BINARY:
+        l = check_expr(c, e->binary.lhs, 1);
+        r = check_expr(c, e->binary.rhs, 1);
+        if (is_boolean(e))
+            e->type = c->u->sym_bool;
+        else if (e->binary.op == OP_SHL || e->binary.op == OP_SHR)
+            e->type = l;
+        else
+            e->type = combine(l, r);
+        break;
+    case AST_CAST:
+        check_expr(c, e->expr.value, 1);
+        break;
+    default:
+        ast_report(c->u, e->line, "not an expression");
+        break;
+    }
+    return e->type;
+}
+
+static void check_block(Checker *c, ASTNode *block);
+
+static void check_stmt(Checker *c, ASTNode *s, size_t scope) {
+    const char *ret = c->fn->function.ret_type;
+
+    switch (s->kind) {
+    case AST_RETURN:
+        if (!s->ret.value)
+            break;
+        check_expr(c, s->ret.value, 1);
+        if (!ret)
+            ast_report(c->u, s->line, "%s() does not return a value", c->fn->function.name);
+        else
+            check_store(c, s->ret.value, ret, "return type");
+        break;
+    case AST_VAR:
+        /* the value is worked out before the name exists */
+        check_expr(c, s->var.value, 1);
+        check_store(c, s->var.value, s->var.type, "type");
+        declare(c, scope, s->var.name, s);
+        break;
+    case AST_ASSIGN:
+        check_expr(c, s->var.value, 1);
+        s->var.decl = lookup(c, s->var.name);
+        if (!s->var.decl)
+            ast_report(c->u, s->line, "%s is not declared", s->var.name);
+        else
+            check_store(c, s->var.value, decl_type(s->var.decl), "type");
+        break;
+    case AST_IF:
+        check_expr(c, s->branch.cond, 1);
+        check_block(c, s->branch.then);
+        if (s->branch.otherwise && s->branch.otherwise->kind == AST_IF)
+            check_stmt(c, s->branch.otherwise, c->depth);
+        else if (s->branch.otherwise)
+            check_block(c, s->branch.otherwise);
+        break;
+    case AST_WHILE:
+        check_expr(c, s->branch.cond, 1);
+        check_block(c, s->branch.then);
+        break;
+    case AST_BLOCK:
+        check_block(c, s);
+        break;
+    case AST_EXPR:
+        check_expr(c, s->expr.value, 0);
+        break;
+    default:
+        ast_report(c->u, s->line, "not a statement");
+        break;
+    }
+}
+
+static void check_block(Checker *c, ASTNode *block) {
+    size_t depth = c->depth;
+
+    for (uint32_t i = 0; i < block->block.statements.count; i++)
+        check_stmt(c, ast_at(c->u, block->block.statements, i), depth);
+    c->depth = depth;
+}
+
+static void check_function(Checker *c, ASTNode *fn) {
+    c->fn = fn;
+    c->depth = 0;
+    for (uint32_t i = 0; i < fn->function.params.count; i++) {
+        ASTNode *p = ast_at(c->u, fn->function.params, i);
+
+        declare(c, 0, p->param.name, p);
+    }
+    check_block(c, fn->function.body);
+}
+
+int validate_driver(ASTUnit *u) {
+    int errors = u->errors;
+    ASTList body = u->root->driver.body;
+    ASTNode *init = find_function(u, u->sym_init);
+    Checker c = { .u = u };
+
+    if (!init) {
+        ast_report(u, 0, "driver %s has no init()", u->root->driver.name);
+    } else if (init->function.params.count) {
+        ast_report(u, init->line, "init() takes no parameters");
     }
+
+    for (uint32_t i = 0; i < body.count; i++) {
+        ASTNode *n = ast_at(u, body, i);
+
+        switch (n->kind) {
+        case AST_FUNCTION:
+            if (find_function(u, n->function.name) != n) {
+                ast_report(u, n->line, "%s() defined twice", n->function.name);
+            }
+            check_function(&c, n);
+            break;
+        case AST_EXPORTS:
+            if (!find_function(u, n->ident.name)) {
+                ast_report(u, n->line, "exported %s() is not defined", n->ident.name);
+            }
+            break;
+        case AST_REQUIRES:
+            if (find_function(u, n->ident.name)) {
+                ast_report(u, n->line, "%s() is both required and defined", n->ident.name);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    free(c.scope);
+    return u->errors - errors;
 }
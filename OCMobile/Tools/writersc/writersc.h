@@ -0,0 +1,86 @@
+#ifndef WRITERSC_H
+#define WRITERSC_H
+
+#include "ast.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/* Part of every cache key (-c): bump it whenever the same source would compile differently */
+#define WRITERSC_VERSION        "writersc 5"
+
+/*
+ * Parse one driver from `in` into `u` (u->root); nonzero on a syntax
+ * error. Reentrant: every unit has a scanner of its own.
+ */
+int parse_driver(ASTUnit *u, FILE *in);
+
+/*
+ * Checks the parser leaves to us, names and types among them; resolves
+ * every identifier and types every expression on the way (semantic.c
+ * has the rules). Returns the number of errors reported.
+ */
+int validate_driver(ASTUnit *u);
+
+/* Declared types (u8 .. u64, i8 .. i64, usize, bool); NULL is an untyped literal */
+int type_bits(const char *type);
+int type_signed(const char *type);
+int same_type(const char *a, const char *b);
+
+/* What storing `v` into `type` leaves */
+uint64_t type_narrow(const char *type, uint64_t v);
+
+/* Whether `e`'s value is already within `type`, so storing it changes nothing */
+int type_fits(const ASTNode *e, const char *type);
+
+/* Whether binary or unary `e` takes the signed instruction, and what that computes */
+int op_signed(const ASTNode *e);
+uint64_t op_compute(ASTOp op, int s, uint64_t a, uint64_t b);
+
+/*
+ * Rewrite a validated driver into a smaller one that computes the same:
+ * constant folding and propagation, dead code, inlining of small
+ * functions, functions nothing can call. With `report`, prints every
+ * function's instruction count before and after there.
+ */
+void optimize_driver(ASTUnit *u, FILE *report);
+
+/*
+ * Lower the driver to .wscd bytecode (../../Platform/wscd/wscd.h) and
+ * write the image to `out_path`, with a native aarch64 section unless
+ * `bytecode_only`; with `listing`, also disassemble it there. 0, or the
+ * number of errors reported.
+ */
+int codegen_driver(ASTUnit *u, const char *out_path, FILE *listing, int bytecode_only);
+
+typedef struct {
+    const char *name;
+    uint32_t instructions;
+} CodeSize;
+
+/* The instructions each function lowers to, without writing anything; -1 on errors */
+int codegen_sizes(ASTUnit *u, CodeSize *sizes, int max);
+
+/* The bytecode a backend works from, as codegen_driver() laid it out */
+typedef struct {
+    uint32_t code;              /* first instruction */
+    uint32_t length;
+    int nregs;
+    int nparams;
+} IRFunc;
+
+typedef struct {
+    const uint32_t *code;
+    const uint64_t *consts;
+    const IRFunc *funcs;
+    int nfuncs;
+    int nimports;
+} IRModule;
+
+/*
+ * The WSCD_SECTION_NATIVE section for `ir`, malloc()ed into *out; -1 if
+ * some function has no aarch64 form (more than 8 parameters or arguments,
+ * a frame past 4 KiB) and the image has to do with bytecode.
+ */
+int native_aarch64(const IRModule *ir, uint8_t **out, size_t *size);
+
+#endif
@@ -0,0 +1,161 @@
+#include "Trace.h"
+#include "Memory.h"
+#include "arch/aarch64/timer.h"
+
+/*
+ * OpenCore Mobile – boot timeline
+ * See Trace.h. Nothing here can fail. Any core may record: a slot is
+ * claimed atomically before it is filled. Dumping and handoff run on the
+ * boot CPU once the secondaries are idle.
+ */
+
+static ocm_trace_event_t ring[OCM_TRACE_EVENTS];
+static u32 recorded;            /* total, including overwritten */
+static u64 frequency;
+
+static void record(const char *name, u32 kind, u64 arg, u64 ticks) {
+    u32 slot = __atomic_fetch_add(&recorded, 1, __ATOMIC_RELAXED);
+    ocm_trace_event_t *ev = &ring[slot % OCM_TRACE_EVENTS];
+    size_t i = 0;
+
+    ev->ticks = ticks;
+    ev->arg = arg;
+    ev->kind = kind;
+    for (; i < OCM_TRACE_NAME_LEN && name[i]; i++)
+        ev->name[i] = name[i];
+    for (; i < OCM_TRACE_NAME_LEN; i++)
+        ev->name[i] = '\0';
+}
+
+/* i-th retained event, oldest first */
+static const ocm_trace_event_t *event_at(u32 i) {
+    u32 first = recorded > OCM_TRACE_EVENTS ? recorded - OCM_TRACE_EVENTS : 0;
+    return &ring[(first + i) % OCM_TRACE_EVENTS];
+}
+
+static u32 retained(void) {
+    return recorded > OCM_TRACE_EVENTS ? OCM_TRACE_EVENTS : recorded;
+}
+
+/*
+ * Time zero for the dump: "entry" until the ring wraps, then the oldest
+ * event still kept. By time, not slot: cores record concurrently, so a
+ * slot may be claimed a little after a later one's stamp.
+ */
+static u64 oldest_ticks(u32 n) {
+    u64 t0 = event_at(0)->ticks;
+
+    for (u32 i = 1; i < n; i++)
+        if (event_at(i)->ticks < t0)
+            t0 = event_at(i)->ticks;
+    return t0;
+}
+
+static u32 ticks_to_us(u64 ticks) {
+    if (!frequency)
+        return (u32)ticks;      /* CNTFRQ unprogrammed: raw ticks */
+    return (u32)((ticks / frequency) * 1000000u + (ticks % frequency) * 1000000u / frequency);
+}
+
+static int same_name(const ocm_trace_event_t *a, const ocm_trace_event_t *b) {
+    return memcmp(a->name, b->name, OCM_TRACE_NAME_LEN) == 0;
+}
+
+/* =========================
+ *  Recording
+ * ========================= */
+
+void trace_init(u64 entry_ticks) {
+    recorded = 0;
+    frequency = timer_frequency();
+    record("entry", OCM_TRACE_MARK, 0, entry_ticks ? entry_ticks : timer_ticks());
+}
+
+void trace_mark(const char *name, u64 arg) {
+    record(name, OCM_TRACE_MARK, arg, timer_ticks());
+}
+
+void trace_label(char *out, const char *name, const char *suffix) {
+    size_t n = 0;
+
+    while (*name && n < OCM_TRACE_NAME_LEN)
+        out[n++] = *name++;
+    while (*suffix && n < OCM_TRACE_NAME_LEN)
+        out[n++] = *suffix++;
+    out[n] = '\0';
+}
+
+void trace_begin(const char *name) {
+    record(name, OCM_TRACE_BEGIN, 0, timer_ticks());
+}
+
+void trace_end(const char *name, u64 arg) {
+    record(name, OCM_TRACE_END, arg, timer_ticks());
+}
+
+/* =========================
+ *  Output
+ * ========================= */
+
+void trace_dump(void) {
+    u32 n = retained();
+
+    if (!n)
+        return;
+
+    u64 t0 = oldest_ticks(n);
+    const char *since = recorded > n ? "the oldest kept event" : "entry";
+
+    printf("trace: %u events, %u dropped, %s since %s%s\n", n, recorded - n,
+           frequency ? "us" : "ticks", since, frequency ? "" : " (CNTFRQ unset)");
+
+    for (u32 i = 0; i < n; i++) {
+        const ocm_trace_event_t *ev = event_at(i);
+        char name[OCM_TRACE_NAME_LEN + 1];
+
+        memcpy(name, ev->name, OCM_TRACE_NAME_LEN);
+        name[OCM_TRACE_NAME_LEN] = '\0';
+
+        printf("  %u %s%s", ticks_to_us(ev->ticks - t0),
+               ev->kind == OCM_TRACE_BEGIN ? "> " : ev->kind == OCM_TRACE_END ? "< " : "",
+               name);
+
+        /* ends show how long the phase took: find its begin */
+        if (ev->kind == OCM_TRACE_END) {
+            for (u32 j = i; j-- > 0;) {
+                const ocm_trace_event_t *b = event_at(j);
+                if (b->kind == OCM_TRACE_BEGIN && same_name(b, ev)) {
+                    printf(" (%u)", ticks_to_us(ev->ticks - b->ticks));
+                    break;
+                }
+            }
+        }
+
+        if (ev->arg)
+            printf(" [%u]", (u32)ev->arg);
+        printf("\n");
+    }
+}
+
+void trace_handoff(struct ocm_boot_params *next) {
+    trace_mark("kernel handoff", 0);
+
+    u32 n = retained();
+    size_t size = sizeof(ocm_boot_trace_t) + n * sizeof(ocm_trace_event_t);
+    ocm_boot_trace_t *out = boot_alloc(size);
+
+    next->trace = out;
+    next->trace_size = out ? size : 0;
+    if (!out)
+        return;
+
+    out->magic = OCM_TRACE_MAGIC;
+    out->version = OCM_TRACE_VERSION;
+    out->frequency = frequency;
+    out->count = n;
+    out->dropped = recorded - n;
+
+    ocm_trace_event_t *events = (ocm_trace_event_t *)(out + 1);
+    for (u32 i = 0; i < n; i++)
+        events[i] = *event_at(i);
+}
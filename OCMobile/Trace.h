@@ -0,0 +1,62 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "bootstd.h"
+#include "BootParams.h"
+#include "BootTrace.h"
+
+/*
+ * OpenCore Mobile – boot timeline
+ *
+ * Named, CNTVCT_EL0-stamped events in a fixed ring (the oldest are
+ * overwritten if a boot ever records more than OCM_TRACE_EVENTS). Cheap
+ * enough to leave on: a counter read and a 40-byte store.
+ *
+ * The stages record, in order:
+ *   entry            _start, stamped by entry.s before any C runs
+ *   mem init         allocator moved onto the memory map
+ *   console          first output possible
+ *   smp              begin/end around bringing up secondaries (arg: cores in use)
+ *   partitions       begin/end around discovery (arg: partitions found)
+ *   config           begin/end around config_load() (arg: 1 = cache hit)
+ *   plist parse      begin/end, only on a cache miss (arg: nodes)
+ *   kernelcache      begin/end around payload_load() (arg: bytes loaded), then
+ *                    "kernelcache read" / "kernelcache decode" marks (arg: MB/s)
+ *   ramdisk          the same for the ramdisk
+ *   <driver> init    mark per WriterSc driver started (arg: microseconds init() took)
+ *   kexts            begin/end around kext loading (arg: kexts loaded), with
+ *                    "kextcache" events like the kernelcache's for the read
+ *   kext link        begin/end around linking kexts at boot (arg: kexts linked),
+ *                    with a "<name> link" mark per kext (arg: microseconds)
+ *   menu             begin/end around the boot menu (arg: entry chosen, -1 cancelled)
+ *   kernel handoff   trace_handoff()
+ *
+ * trace_dump() prints it on the console; trace_handoff() copies it for
+ * the kernel, where AndroidPlatformBridge publishes it in the IORegistry.
+ */
+
+#define OCM_TRACE_EVENTS        128
+
+/* CNTVCT_EL0 as read by entry.s at _start */
+extern u64 ocm_entry_ticks;
+
+/* Reset the ring and record "entry" at `entry_ticks` (0 = now) */
+void trace_init(u64 entry_ticks);
+
+void trace_mark(const char *name, u64 arg);
+
+/* "<name><suffix>", cut to what an event holds; `out` has OCM_TRACE_NAME_LEN + 1 bytes */
+void trace_label(char *out, const char *name, const char *suffix);
+void trace_begin(const char *name);
+void trace_end(const char *name, u64 arg);
+
+/* The timeline, one line per event, relative to entry (the oldest event kept once the ring wraps) */
+void trace_dump(void);
+
+/*
+ * Record "kernel handoff" and put a linear copy of the ring (oldest
+ * first, in permanent boot_alloc() memory) into `next`.
+ */
+void trace_handoff(struct ocm_boot_params *next);
+
+#endif /* TRACE_H */
@@ -0,0 +1,109 @@
+#ifndef ARCH_AARCH64_CPU_H
+#define ARCH_AARCH64_CPU_H
+
+#include "../../bootstd.h"
+
+/*
+ * OpenCore Mobile – CPU state helpers
+ */
+
+/* cores the loader will use (Smp.c), including the boot CPU */
+#define OCM_MAX_CPUS            8
+
+/* Mask IRQs on this core; returns the previous DAIF for irq_restore() */
+static inline u64 irq_save(void) {
+#if defined(__aarch64__)
+    u64 daif;
+    __asm__ volatile ("mrs %0, DAIF\n\tmsr DAIFSet, #2" : "=r"(daif) :: "memory");
+    return daif;
+#else
+    return 0;
+#endif
+}
+
+static inline void irq_restore(u64 daif) {
+#if defined(__aarch64__)
+    __asm__ volatile ("msr DAIF, %0" :: "r"(daif) : "memory");
+#else
+    (void)daif;
+#endif
+}
+
+/* Unmask IRQs on this core (irq_init() does this once the GIC is up) */
+static inline void cpu_irq_enable(void) {
+#if defined(__aarch64__)
+    __asm__ volatile ("msr DAIFClr, #2" ::: "memory");
+#endif
+}
+
+static inline void cpu_wfi(void) {
+#if defined(__aarch64__)
+    __asm__ volatile ("wfi" ::: "memory");
+#endif
+}
+
+/* Wait for an event (sev from another core, or an interrupt) */
+static inline void cpu_wfe(void) {
+#if defined(__aarch64__)
+    __asm__ volatile ("wfe" ::: "memory");
+#endif
+}
+
+/* Wake every core sitting in wfe; orders our earlier stores first */
+static inline void cpu_sev(void) {
+#if defined(__aarch64__)
+    __asm__ volatile ("dsb ish\n\tsev" ::: "memory");
+#endif
+}
+
+/* Exception level the loader runs at (1 or 2) */
+static inline u32 cpu_current_el(void) {
+#if defined(__aarch64__)
+    u64 el;
+    __asm__ volatile ("mrs %0, CurrentEL" : "=r"(el));
+    return (u32)(el >> 2) & 3;
+#else
+    return 1;
+#endif
+}
+
+/* MPIDR_EL1 affinity fields, Aff3 in bits [39:32] and Aff2..0 in [23:0] */
+static inline u64 cpu_affinity(void) {
+#if defined(__aarch64__)
+    u64 mpidr;
+    __asm__ volatile ("mrs %0, MPIDR_EL1" : "=r"(mpidr));
+    return mpidr & 0xFF00FFFFFFull;
+#else
+    return 0;
+#endif
+}
+
+/*
+ * Which of the loader's cores this is: 0 for the boot CPU (entry.s
+ * clears TPIDR), 1.. for secondaries Smp.c brought up.
+ */
+static inline u32 cpu_index(void) {
+#if defined(__aarch64__)
+    u64 id;
+    if (cpu_current_el() == 2)
+        __asm__ volatile ("mrs %0, TPIDR_EL2" : "=r"(id));
+    else
+        __asm__ volatile ("mrs %0, TPIDR_EL1" : "=r"(id));
+    return (u32)id;
+#else
+    return 0;
+#endif
+}
+
+static inline void cpu_set_index(u32 index) {
+#if defined(__aarch64__)
+    if (cpu_current_el() == 2)
+        __asm__ volatile ("msr TPIDR_EL2, %0" :: "r"((u64)index));
+    else
+        __asm__ volatile ("msr TPIDR_EL1, %0" :: "r"((u64)index));
+#else
+    (void)index;
+#endif
+}
+
+#endif /* ARCH_AARCH64_CPU_H */
@@ -2,11 +2,35 @@
 .extern boot_main
 
 _start:
+    /* Stamp the handoff first, for the boot timeline (Trace.h) */
+    mrs x19, cntvct_el0
+
+    /* 0. Enable FP/SIMD at EL1 (NEON string routines, compiler spills) */
+    mrs x0, CurrentEL
+    cmp x0, #(1 << 2)
+    b.ne 1f
+    mov x0, #(3 << 20)       /* CPACR_EL1.FPEN = 0b11 */
+    msr cpacr_el1, x0
+    isb
+1:
+
+    /* cpu_index() (cpu.h) is 0 on the boot CPU; the register is not reset */
+    mrs x0, CurrentEL
+    cmp x0, #(2 << 2)
+    b.ne 2f
+    msr tpidr_el2, xzr
+    b 3f
+2:  msr tpidr_el1, xzr
+3:
+
     /* 1. Setup Stack (Critical for C execution) */
     /* Must be 16-byte aligned for AArch64 hardware */
     ldr x0, =stack_top
     mov sp, x0
 
+    ldr x0, =ocm_entry_ticks
+    str x19, [x0]
+
     /* 2. Prepare arguments for: void boot_main(uint64_t magic, void *boot_args) */
     mov x0, #0xFEEDFACE      /* Param 1: Magic value for XNU compatibility */
     ldr x1, =boot_params     /* Param 2: Pointer to a struct/data in memory */
@@ -19,7 +43,13 @@ hang:
     wfi
     b hang
 
+.section .data
+.align 3
+.global ocm_entry_ticks
+ocm_entry_ticks: .quad 0
+
 .section .bss
 .align 16
+.global stack_base
 stack_base: .skip 0x4000     /* 16KB stack */
 stack_top:
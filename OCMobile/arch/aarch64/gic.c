@@ -0,0 +1,289 @@
+#include "gic.h"
+#include "cpu.h"
+#include "io.h"
+
+/*
+ * OpenCore Mobile – GIC interrupt controller
+ *
+ * See gic.h.
+ */
+
+#ifndef GIC_DIST_BASE
+#define GIC_DIST_BASE           0x08000000      /* QEMU virt, per device later */
+#endif
+
+#ifndef GIC_CPU_BASE
+#define GIC_CPU_BASE            0x08010000      /* GICv2 CPU interface */
+#endif
+
+#ifndef GIC_REDIST_BASE
+#define GIC_REDIST_BASE         0x080A0000      /* GICv3 redistributors */
+#endif
+
+/* one priority for everything: no nesting, and well inside any PMR */
+#define GIC_PRIORITY            0xA0
+#define GIC_PMR                 0xF0
+
+/* register polls that should take microseconds; give up after this many */
+#define GIC_SPIN_LIMIT          1000000u
+
+/* Distributor */
+#define GICD_CTLR               0x0000
+#define GICD_TYPER              0x0004
+#define GICD_IGROUPR            0x0080
+#define GICD_ISENABLER          0x0100
+#define GICD_ICENABLER          0x0180
+#define GICD_IPRIORITYR         0x0400
+#define GICD_ITARGETSR          0x0800
+#define GICD_ICFGR              0x0C00
+#define GICD_IROUTER            0x6000
+#define GICD_PIDR2              0xFFE8
+
+#define GICD_CTLR_ENABLE_G1     (1u << 0)       /* v2: the only enable bit we own */
+#define GICD_CTLR_ENABLE_G1A    (1u << 1)
+#define GICD_CTLR_ARE_NS        (1u << 4)
+#define GICD_CTLR_RWP           (1u << 31)
+
+/* GICv2 CPU interface */
+#define GICC_CTLR               0x0000
+#define GICC_PMR                0x0004
+#define GICC_IAR                0x000C
+#define GICC_EOIR               0x0010
+
+/* GICv3 redistributor: RD_base frame, then SGI_base 64 KiB above it */
+#define GICR_CTLR               0x0000
+#define GICR_TYPER              0x0008
+#define GICR_WAKER              0x0014
+#define GICR_SGI_BASE           0x10000
+#define GICR_FRAME              0x20000
+
+#define GICR_CTLR_RWP           (1u << 3)
+#define GICR_TYPER_VLPIS        (1u << 1)
+#define GICR_TYPER_LAST         (1u << 4)
+#define GICR_WAKER_SLEEP        (1u << 1)
+#define GICR_WAKER_ASLEEP       (1u << 2)
+
+static struct {
+    u32 version;                /* 0 until gic_init() succeeds */
+    u32 lines;                  /* INTIDs the distributor implements */
+    uintptr_t rd;               /* v3: this core's RD_base */
+} gic;
+
+/* ===== helpers ===== */
+
+static bool wait_clear(uintptr_t reg, u32 bits) {
+    for (u32 i = 0; i < GIC_SPIN_LIMIT; i++) {
+        if (!(mmio_read32(reg) & bits))
+            return true;
+        cpu_relax();
+    }
+    return false;
+}
+
+static void wait_rwp(u32 intid) {
+    if (gic.version < 3)
+        return;
+    if (intid < 32)
+        wait_clear(gic.rd + GICR_CTLR, GICR_CTLR_RWP);
+    else
+        wait_clear(GIC_DIST_BASE + GICD_CTLR, GICD_CTLR_RWP);
+}
+
+/* Where the banked SGI/PPI registers of `intid` live */
+static uintptr_t bank_base(u32 intid) {
+    return (gic.version >= 3 && intid < 32) ? gic.rd + GICR_SGI_BASE : GIC_DIST_BASE;
+}
+
+/*
+ * SPIs [32, lines): disabled, default priority, routed here. v3 also puts
+ * them in Group 1; on v2 the groups are left as found, since from the
+ * non-secure side they are firmware's, and a GIC we own (no EL3) signals
+ * Group 0 as IRQ just as well.
+ */
+static void setup_spis(u64 route, u8 targets) {
+    for (u32 id = 32; id < gic.lines; id += 32) {
+        mmio_write32(GIC_DIST_BASE + GICD_ICENABLER + id / 8, 0xFFFFFFFF);
+        if (gic.version >= 3)
+            mmio_write32(GIC_DIST_BASE + GICD_IGROUPR + id / 8, 0xFFFFFFFF);
+    }
+    for (u32 id = 32; id < gic.lines; id++) {
+        mmio_write8(GIC_DIST_BASE + GICD_IPRIORITYR + id, GIC_PRIORITY);
+        if (gic.version >= 3) {
+            uintptr_t r = GIC_DIST_BASE + GICD_IROUTER + (uintptr_t)id * 8;
+            mmio_write32(r, (u32)route);
+            mmio_write32(r + 4, (u32)(route >> 32));
+        } else {
+            mmio_write8(GIC_DIST_BASE + GICD_ITARGETSR + id, targets);
+        }
+    }
+}
+
+/* Same for the banked SGIs/PPIs, in whichever frame holds them */
+static void setup_banked(void) {
+    uintptr_t base = bank_base(0);
+
+    mmio_write32(base + GICD_ICENABLER, 0xFFFFFFFF);
+    if (gic.version >= 3)
+        mmio_write32(base + GICD_IGROUPR, 0xFFFFFFFF);
+    for (u32 id = 0; id < 32; id++)
+        mmio_write8(base + GICD_IPRIORITYR + id, GIC_PRIORITY);
+    wait_rwp(0);
+}
+
+/* ===== GICv3 ===== */
+
+static bool v3_find_redistributor(u64 affinity) {
+    u32 want = (u32)((affinity >> 8) & 0xFF000000) | (u32)(affinity & 0xFFFFFF);
+    uintptr_t rd = GIC_REDIST_BASE;
+
+    for (u32 i = 0; i < 512; i++) {
+        u32 typer = mmio_read32(rd + GICR_TYPER);
+
+        if (mmio_read32(rd + GICR_TYPER + 4) == want) {
+            gic.rd = rd;
+            return true;
+        }
+        if (typer & GICR_TYPER_LAST)
+            break;
+        rd += GICR_FRAME * ((typer & GICR_TYPER_VLPIS) ? 2 : 1);
+    }
+    return false;
+}
+
+static status_t v3_cpu_interface(void) {
+#if defined(__aarch64__)
+    u64 sre;
+
+    /* system register access; from EL2, also let EL1 keep it */
+    if (cpu_current_el() == 2) {
+        __asm__ volatile ("mrs %0, ICC_SRE_EL2" : "=r"(sre));
+        __asm__ volatile ("msr ICC_SRE_EL2, %0\n\tisb" :: "r"(sre | 0x9));
+    }
+    __asm__ volatile ("mrs %0, ICC_SRE_EL1" : "=r"(sre));
+    __asm__ volatile ("msr ICC_SRE_EL1, %0\n\tisb" :: "r"(sre | 1));
+    __asm__ volatile ("mrs %0, ICC_SRE_EL1" : "=r"(sre));
+    if (!(sre & 1))
+        return STATUS_NOT_FOUND;       /* firmware kept us on the legacy interface */
+
+    __asm__ volatile ("msr ICC_PMR_EL1, %0" :: "r"((u64)GIC_PMR));
+    __asm__ volatile ("msr ICC_CTLR_EL1, xzr");             /* EOI also deactivates */
+    __asm__ volatile ("msr ICC_IGRPEN1_EL1, %0\n\tisb" :: "r"((u64)1));
+    return STATUS_SUCCESS;
+#else
+    return STATUS_NOT_FOUND;
+#endif
+}
+
+static status_t v3_init(void) {
+    u64 affinity = cpu_affinity();
+
+    if (!v3_find_redistributor(affinity))
+        return STATUS_NOT_FOUND;
+
+    /* wake this core's redistributor */
+    mmio_write32(gic.rd + GICR_WAKER, mmio_read32(gic.rd + GICR_WAKER) & ~GICR_WAKER_SLEEP);
+    if (!wait_clear(gic.rd + GICR_WAKER, GICR_WAKER_ASLEEP))
+        return STATUS_ERROR;
+
+    mmio_write32(GIC_DIST_BASE + GICD_CTLR, 0);
+    wait_clear(GIC_DIST_BASE + GICD_CTLR, GICD_CTLR_RWP);
+
+    setup_spis(affinity, 0);
+    setup_banked();
+
+    mmio_write32(GIC_DIST_BASE + GICD_CTLR,
+                 GICD_CTLR_ARE_NS | GICD_CTLR_ENABLE_G1A | GICD_CTLR_ENABLE_G1);
+    wait_clear(GIC_DIST_BASE + GICD_CTLR, GICD_CTLR_RWP);
+
+    return v3_cpu_interface();
+}
+
+/* ===== GICv2 ===== */
+
+static status_t v2_init(void) {
+    /* the banked ITARGETSR0..7 read back this core's own bit */
+    u8 self = mmio_read8(GIC_DIST_BASE + GICD_ITARGETSR);
+
+    mmio_write32(GIC_DIST_BASE + GICD_CTLR, 0);
+    setup_spis(0, self ? self : 1);
+    setup_banked();
+    mmio_write32(GIC_DIST_BASE + GICD_CTLR, GICD_CTLR_ENABLE_G1);
+
+    mmio_write32(GIC_CPU_BASE + GICC_PMR, GIC_PMR);
+    mmio_write32(GIC_CPU_BASE + GICC_CTLR, 1);
+    return STATUS_SUCCESS;
+}
+
+/* ===== interface ===== */
+
+status_t gic_init(void) {
+    u32 arch = (mmio_read32(GIC_DIST_BASE + GICD_PIDR2) >> 4) & 0xF;
+    status_t status;
+
+    gic.version = arch;
+    gic.lines = 32 * ((mmio_read32(GIC_DIST_BASE + GICD_TYPER) & 0x1F) + 1);
+    if (gic.lines > GIC_INTID_SPECIAL)
+        gic.lines = GIC_INTID_SPECIAL;
+
+    if (arch == 3 || arch == 4)
+        status = v3_init();
+    else if (arch == 1 || arch == 2)
+        status = v2_init();
+    else
+        status = STATUS_NOT_FOUND;
+
+    if (status != STATUS_SUCCESS)
+        gic.version = 0;
+    return status;
+}
+
+u32 gic_version(void) {
+    return gic.version;
+}
+
+void gic_configure(u32 intid, bool edge) {
+    if (!gic.version || intid < 16 || intid >= gic.lines)
+        return;
+
+    uintptr_t reg = bank_base(intid) + GICD_ICFGR + intid / 16 * 4;
+    u32 shift = (intid % 16) * 2 + 1;
+    u32 cfg = mmio_read32(reg) & ~(1u << shift);
+
+    mmio_write32(reg, cfg | ((u32)edge << shift));
+}
+
+void gic_enable(u32 intid) {
+    if (!gic.version || intid >= gic.lines)
+        return;
+    mmio_write32(bank_base(intid) + GICD_ISENABLER + intid / 32 * 4, 1u << (intid % 32));
+}
+
+void gic_disable(u32 intid) {
+    if (!gic.version || intid >= gic.lines)
+        return;
+    mmio_write32(bank_base(intid) + GICD_ICENABLER + intid / 32 * 4, 1u << (intid % 32));
+    wait_rwp(intid);
+}
+
+u32 gic_ack(void) {
+    if (gic.version >= 3) {
+#if defined(__aarch64__)
+        u64 iar;
+        __asm__ volatile ("mrs %0, ICC_IAR1_EL1" : "=r"(iar) :: "memory");
+        return (u32)iar & 0xFFFFFF;
+#endif
+    } else if (gic.version) {
+        return mmio_read32(GIC_CPU_BASE + GICC_IAR) & 0x3FF;
+    }
+    return 1023;
+}
+
+void gic_eoi(u32 intid) {
+    if (gic.version >= 3) {
+#if defined(__aarch64__)
+        __asm__ volatile ("msr ICC_EOIR1_EL1, %0\n\tisb" :: "r"((u64)intid) : "memory");
+#endif
+    } else if (gic.version) {
+        mmio_write32(GIC_CPU_BASE + GICC_EOIR, intid);
+    }
+}
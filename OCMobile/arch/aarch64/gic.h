@@ -0,0 +1,39 @@
+#ifndef ARCH_AARCH64_GIC_H
+#define ARCH_AARCH64_GIC_H
+
+#include <stdbool.h>
+
+#include "../../bootstd.h"
+
+/*
+ * OpenCore Mobile – GIC interrupt controller
+ *
+ * GICv2 (memory-mapped CPU interface) and GICv3/v4 (ICC_* system
+ * registers, per-CPU redistributors), told apart by GICD_PIDR2. Every
+ * interrupt is Group 1 (non-secure) at one priority and, for SPIs,
+ * routed to the core that ran gic_init(). See irq.h for the layer
+ * drivers use.
+ */
+
+#define GIC_PPI(n)              (16u + (n))
+#define GIC_SPI(n)              (32u + (n))
+
+/* gic_ack() values from here up are special (1023: nothing pending) */
+#define GIC_INTID_SPECIAL       1020u
+
+/* STATUS_NOT_FOUND if there is no GIC this driver understands */
+status_t gic_init(void);
+u32 gic_version(void);
+
+/* Edge or level (SGIs are always edge) */
+void gic_configure(u32 intid, bool edge);
+void gic_enable(u32 intid);
+void gic_disable(u32 intid);
+
+/* Highest priority pending interrupt, now active; >= GIC_INTID_SPECIAL if none */
+u32 gic_ack(void);
+
+/* Drop priority and deactivate */
+void gic_eoi(u32 intid);
+
+#endif /* ARCH_AARCH64_GIC_H */
@@ -0,0 +1,116 @@
+#ifndef ARCH_AARCH64_IO_H
+#define ARCH_AARCH64_IO_H
+
+#include "../../bootstd.h"
+
+/*
+ * OpenCore Mobile – MMIO accessors and cache maintenance for drivers
+ *
+ * The loader runs identity mapped, so a virtual address is also the
+ * bus address programmed into DMA engines.
+ */
+
+/* =========================
+ *  MMIO
+ * ========================= */
+
+static inline u8 mmio_read8(uintptr_t addr) {
+    return *(volatile u8 *)addr;
+}
+
+static inline u16 mmio_read16(uintptr_t addr) {
+    return *(volatile u16 *)addr;
+}
+
+static inline u32 mmio_read32(uintptr_t addr) {
+    return *(volatile u32 *)addr;
+}
+
+static inline void mmio_write8(uintptr_t addr, u8 val) {
+    *(volatile u8 *)addr = val;
+}
+
+static inline void mmio_write16(uintptr_t addr, u16 val) {
+    *(volatile u16 *)addr = val;
+}
+
+static inline void mmio_write32(uintptr_t addr, u32 val) {
+    *(volatile u32 *)addr = val;
+}
+
+/* =========================
+ *  Barriers
+ * ========================= */
+
+#if defined(__aarch64__)
+#define dsb_sy()        __asm__ volatile ("dsb sy" ::: "memory")
+#define dmb_sy()        __asm__ volatile ("dmb sy" ::: "memory")
+#define cpu_relax()     __asm__ volatile ("yield" ::: "memory")
+#else
+#define dsb_sy()        __asm__ volatile ("" ::: "memory")
+#define dmb_sy()        __asm__ volatile ("" ::: "memory")
+#define cpu_relax()     __asm__ volatile ("" ::: "memory")
+#endif
+
+/* =========================
+ *  Data cache maintenance (to the point of coherency)
+ * ========================= */
+
+static inline uintptr_t dcache_line_size(void) {
+#if defined(__aarch64__)
+    u64 ctr;
+    __asm__ volatile ("mrs %0, CTR_EL0" : "=r"(ctr));
+    return (uintptr_t)4 << ((ctr >> 16) & 0xF);     /* DminLine, in words */
+#else
+    return 64;
+#endif
+}
+
+/*
+ * Clean and invalidate [addr, addr + size). Used on both sides of a
+ * non-coherent DMA transfer: before, so no dirty line gets written back
+ * over the device's data; after a device write, so the CPU re-reads RAM.
+ * Harmless while the caches are still off.
+ */
+static inline void dcache_flush_range(const void *addr, size_t size) {
+#if defined(__aarch64__)
+    uintptr_t line = dcache_line_size();
+    uintptr_t p = (uintptr_t)addr & ~(line - 1);
+    uintptr_t end = (uintptr_t)addr + size;
+
+    for (; p < end; p += line)
+        __asm__ volatile ("dc civac, %0" : : "r"(p) : "memory");
+    dsb_sy();
+#else
+    (void)addr;
+    (void)size;
+#endif
+}
+
+/*
+ * Make instructions just written to [addr, addr + size) visible to
+ * instruction fetch: clean them to the point of unification, then drop
+ * whatever the I-cache still holds for the range.
+ */
+static inline void icache_sync_range(const void *addr, size_t size) {
+#if defined(__aarch64__)
+    u64 ctr;
+    __asm__ volatile ("mrs %0, CTR_EL0" : "=r"(ctr));
+
+    uintptr_t dline = (uintptr_t)4 << ((ctr >> 16) & 0xF);
+    uintptr_t iline = (uintptr_t)4 << (ctr & 0xF);          /* IminLine */
+    uintptr_t end = (uintptr_t)addr + size;
+
+    for (uintptr_t p = (uintptr_t)addr & ~(dline - 1); p < end; p += dline)
+        __asm__ volatile ("dc cvau, %0" : : "r"(p) : "memory");
+    __asm__ volatile ("dsb ish" ::: "memory");
+    for (uintptr_t p = (uintptr_t)addr & ~(iline - 1); p < end; p += iline)
+        __asm__ volatile ("ic ivau, %0" : : "r"(p) : "memory");
+    __asm__ volatile ("dsb ish\n\tisb" ::: "memory");
+#else
+    (void)addr;
+    (void)size;
+#endif
+}
+
+#endif /* ARCH_AARCH64_IO_H */
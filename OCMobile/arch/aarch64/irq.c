@@ -0,0 +1,125 @@
+#include "irq.h"
+#include "cpu.h"
+#include "gic.h"
+
+/*
+ * OpenCore Mobile – interrupts
+ *
+ * See irq.h.
+ */
+
+extern const char ocm_vectors[];
+
+static struct {
+    irq_handler_t handler;
+    void *ctx;
+} handlers[IRQ_MAX];
+
+static bool ready;
+static volatile u32 depth;
+
+/* ===== setup ===== */
+
+static void install_vectors(void) {
+#if defined(__aarch64__)
+    if (cpu_current_el() == 2)
+        __asm__ volatile ("msr VBAR_EL2, %0\n\tisb" :: "r"(ocm_vectors) : "memory");
+    else
+        __asm__ volatile ("msr VBAR_EL1, %0\n\tisb" :: "r"(ocm_vectors) : "memory");
+#endif
+}
+
+void irq_init(void) {
+    if (ready)
+        return;
+
+    /* even without a GIC, a stray exception should say what it was */
+    install_vectors();
+
+    if (gic_init() != STATUS_SUCCESS) {
+        puts("irq: no interrupt controller, polling\n");
+        return;
+    }
+
+    ready = true;
+    cpu_irq_enable();
+}
+
+void irq_init_secondary(void) {
+    install_vectors();
+}
+
+bool irq_ready(void) {
+    return ready;
+}
+
+bool irq_in_handler(void) {
+    return depth != 0;
+}
+
+status_t irq_register(u32 intid, irq_handler_t handler, void *ctx, u32 flags) {
+    if (!handler || intid >= IRQ_MAX)
+        return STATUS_INVALID_PARAM;
+    if (!ready)
+        return STATUS_NOT_FOUND;
+
+    u64 daif = irq_save();
+    handlers[intid].handler = handler;
+    handlers[intid].ctx = ctx;
+    gic_configure(intid, flags & IRQ_EDGE);
+    gic_enable(intid);
+    irq_restore(daif);
+    return STATUS_SUCCESS;
+}
+
+void irq_unregister(u32 intid) {
+    if (intid >= IRQ_MAX || !ready)
+        return;
+
+    u64 daif = irq_save();
+    gic_disable(intid);
+    handlers[intid].handler = NULL;
+    irq_restore(daif);
+}
+
+/* ===== vectors ===== */
+
+void irq_dispatch(void) {
+    depth++;
+    for (;;) {
+        u32 intid = gic_ack();
+
+        if (intid >= GIC_INTID_SPECIAL)
+            break;
+        if (handlers[intid].handler)
+            handlers[intid].handler(handlers[intid].ctx);
+        else
+            gic_disable(intid);         /* nobody asked for it; don't let it storm */
+        gic_eoi(intid);
+    }
+    depth--;
+}
+
+void exception_unexpected(u64 kind) {
+    static const char *const where[4] = {
+        "current EL, SP_EL0", "current EL, SP_ELx", "lower EL, AArch64", "lower EL, AArch32"
+    };
+    static const char *const what[4] = { "sync", "IRQ", "FIQ", "SError" };
+    u64 esr = 0, elr = 0, far = 0;
+
+#if defined(__aarch64__)
+    if (cpu_current_el() == 2) {
+        __asm__ volatile ("mrs %0, ESR_EL2" : "=r"(esr));
+        __asm__ volatile ("mrs %0, ELR_EL2" : "=r"(elr));
+        __asm__ volatile ("mrs %0, FAR_EL2" : "=r"(far));
+    } else {
+        __asm__ volatile ("mrs %0, ESR_EL1" : "=r"(esr));
+        __asm__ volatile ("mrs %0, ELR_EL1" : "=r"(elr));
+        __asm__ volatile ("mrs %0, FAR_EL1" : "=r"(far));
+    }
+#endif
+
+    printf("\nexception: %s from %s\n  ESR %llx  ELR %llx  FAR %llx\n",
+           what[kind & 3], where[(kind >> 2) & 3], esr, elr, far);
+    panic("OCM: unexpected exception");
+}
@@ -0,0 +1,46 @@
+#ifndef ARCH_AARCH64_IRQ_H
+#define ARCH_AARCH64_IRQ_H
+
+#include <stdbool.h>
+
+#include "../../bootstd.h"
+
+/*
+ * OpenCore Mobile – interrupts
+ *
+ * One handler per GIC INTID, run from the IRQ vector with IRQs masked
+ * (no nesting). Handlers must be short and must not sleep: everything
+ * they share with the boot path is either a lock-free queue or guarded
+ * by irq_save()/irq_restore() on the other side.
+ *
+ * Until irq_init() has found a GIC, irq_ready() is false and drivers
+ * are expected to fall back to polling; Event.c does that for waits.
+ */
+
+#define IRQ_MAX                 1020
+
+/* irq_register() flags */
+#define IRQ_EDGE                (1u << 0)       /* default: level */
+
+typedef void (*irq_handler_t)(void *ctx);
+
+/* Install the vectors, bring up the GIC and unmask IRQs on this core */
+void irq_init(void);
+bool irq_ready(void);
+
+/* Secondaries: vectors only, so faults are reported; they take no IRQs */
+void irq_init_secondary(void);
+
+/* True while a handler is running (sleeping there would never wake) */
+bool irq_in_handler(void);
+
+/* Route `intid` to `handler` and enable it; STATUS_NOT_FOUND before irq_init() */
+status_t irq_register(u32 intid, irq_handler_t handler, void *ctx, u32 flags);
+void irq_unregister(u32 intid);
+
+/* Called from vectors.s */
+void irq_dispatch(void);
+__attribute__((noreturn))
+void exception_unexpected(u64 kind);
+
+#endif /* ARCH_AARCH64_IRQ_H */
@@ -0,0 +1,62 @@
+#ifndef ARCH_AARCH64_PSCI_H
+#define ARCH_AARCH64_PSCI_H
+
+#include "../../bootstd.h"
+#include "cpu.h"
+
+/*
+ * OpenCore Mobile – PSCI (power state coordination, SMC64 calling convention)
+ *
+ * From EL2 the call has to be an SMC. From EL1 it depends on who
+ * implements PSCI: QEMU virt answers HVC, phones' secure firmware SMC
+ * (-DPSCI_USE_SMC).
+ */
+
+#define PSCI_VERSION            0x84000000u
+#define PSCI_CPU_ON             0xC4000003u
+#define PSCI_AFFINITY_INFO      0xC4000004u
+
+#define PSCI_SUCCESS            0
+#define PSCI_NOT_SUPPORTED      (-1)
+#define PSCI_INVALID_PARAMETERS (-2)
+#define PSCI_ALREADY_ON         (-4)
+
+/* AFFINITY_INFO results */
+#define PSCI_AFFINITY_ON        0
+#define PSCI_AFFINITY_OFF       1
+#define PSCI_AFFINITY_ON_PENDING 2
+
+static inline s64 psci_call(u64 fn, u64 a1, u64 a2, u64 a3) {
+#if defined(__aarch64__)
+    register u64 x0 __asm__("x0") = fn;
+    register u64 x1 __asm__("x1") = a1;
+    register u64 x2 __asm__("x2") = a2;
+    register u64 x3 __asm__("x3") = a3;
+
+    /* SMCCC 1.0: results may come back in x1-x3, and x4-x17 are not
+     * preserved; Linux's arm_smccc_1_0 wrappers say the same */
+#ifndef PSCI_USE_SMC
+    if (cpu_current_el() == 1)
+        __asm__ volatile ("hvc #0"
+                          : "+r"(x0), "+r"(x1), "+r"(x2), "+r"(x3)
+                          :
+                          : "x4", "x5", "x6", "x7", "x8", "x9", "x10", "x11", "x12",
+                            "x13", "x14", "x15", "x16", "x17", "memory");
+    else
+#endif
+        __asm__ volatile ("smc #0"
+                          : "+r"(x0), "+r"(x1), "+r"(x2), "+r"(x3)
+                          :
+                          : "x4", "x5", "x6", "x7", "x8", "x9", "x10", "x11", "x12",
+                            "x13", "x14", "x15", "x16", "x17", "memory");
+    return (s64)x0;
+#else
+    (void)fn;
+    (void)a1;
+    (void)a2;
+    (void)a3;
+    return PSCI_NOT_SUPPORTED;
+#endif
+}
+
+#endif /* ARCH_AARCH64_PSCI_H */
@@ -0,0 +1,67 @@
+/*
+ * OpenCore Mobile – secondary core entry
+ *
+ * PSCI CPU_ON lands here with the MMU and caches off and x0 = the
+ * smp_boot_ctx_t Smp.c cleaned to memory for this core. Take on the boot
+ * CPU's translation regime, then its stack, and enter C.
+ */
+
+.global smp_secondary_entry
+.extern smp_secondary_main
+
+/* smp_boot_ctx_t */
+.equ CTX_MAIR,      0
+.equ CTX_TCR,       8
+.equ CTX_TTBR0,     16
+.equ CTX_SCTLR,     24
+.equ CTX_STACK,     32
+
+.section .text
+smp_secondary_entry:
+    mov x19, x0
+
+    mrs x1, CurrentEL
+    cmp x1, #(2 << 2)
+    b.eq 2f
+
+    /* EL1: FP/SIMD on, as entry.s does for the boot CPU */
+    mov x1, #(3 << 20)
+    msr cpacr_el1, x1
+
+    ldp x1, x2, [x19, #CTX_MAIR]
+    ldp x3, x4, [x19, #CTX_TTBR0]
+    msr mair_el1, x1
+    msr tcr_el1, x2
+    msr ttbr0_el1, x3
+    isb
+    tlbi vmalle1
+    dsb nsh
+    isb
+    msr sctlr_el1, x4
+    isb
+    b 3f
+
+2:  /* EL2 */
+    ldp x1, x2, [x19, #CTX_MAIR]
+    ldp x3, x4, [x19, #CTX_TTBR0]
+    msr mair_el2, x1
+    msr tcr_el2, x2
+    msr ttbr0_el2, x3
+    isb
+    tlbi alle2
+    dsb nsh
+    isb
+    msr sctlr_el2, x4
+    isb
+
+3:  ic iallu
+    dsb nsh
+    isb
+
+    ldr x1, [x19, #CTX_STACK]
+    mov sp, x1
+    mov x0, x19
+    bl smp_secondary_main
+
+4:  wfe
+    b 4b
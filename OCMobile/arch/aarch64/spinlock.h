@@ -0,0 +1,37 @@
+#ifndef ARCH_AARCH64_SPINLOCK_H
+#define ARCH_AARCH64_SPINLOCK_H
+
+#include "../../bootstd.h"
+#include "cpu.h"
+#include "io.h"
+
+/*
+ * OpenCore Mobile – spinlocks
+ *
+ * For the few structures secondaries share with the boot CPU (the heap,
+ * mostly). Held for a handful of instructions, with IRQs masked so an
+ * interrupt handler on the same core can't spin on its own holder.
+ */
+
+typedef struct {
+    u32 locked;
+} spinlock_t;
+
+#define SPINLOCK_INIT           { 0 }
+
+static inline u64 spin_lock_irqsave(spinlock_t *lock) {
+    u64 daif = irq_save();
+
+    while (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&lock->locked, __ATOMIC_RELAXED))
+            cpu_relax();
+    }
+    return daif;
+}
+
+static inline void spin_unlock_irqrestore(spinlock_t *lock, u64 daif) {
+    __atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+    irq_restore(daif);
+}
+
+#endif /* ARCH_AARCH64_SPINLOCK_H */
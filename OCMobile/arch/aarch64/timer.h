@@ -0,0 +1,62 @@
+#ifndef ARCH_AARCH64_TIMER_H
+#define ARCH_AARCH64_TIMER_H
+
+#include "../../bootstd.h"
+
+/*
+ * OpenCore Mobile – ARM generic timer
+ *
+ * CNTVCT_EL0 runs from reset at CNTFRQ_EL0 Hz, which whatever booted us
+ * is expected to have programmed (0 means it didn't).
+ *
+ * Deadlines use the EL1 virtual timer: CNTV_CVAL_EL0 compared against
+ * the same counter, raising PPI 11 (INTID 27) once it is reached. It is
+ * one comparator for the whole loader; Event.c owns it.
+ */
+
+#define TIMER_VIRT_INTID        27
+
+static inline u64 timer_ticks(void) {
+#if defined(__aarch64__)
+    u64 cnt;
+    /* don't let the read be hoisted above the work being timed */
+    __asm__ volatile ("isb; mrs %0, CNTVCT_EL0" : "=r"(cnt) :: "memory");
+    return cnt;
+#else
+    return 0;
+#endif
+}
+
+static inline u64 timer_frequency(void) {
+#if defined(__aarch64__)
+    u64 frq;
+    __asm__ volatile ("mrs %0, CNTFRQ_EL0" : "=r"(frq));
+    return frq & 0xFFFFFFFFu;
+#else
+    return 0;
+#endif
+}
+
+/* Fire TIMER_VIRT_INTID once CNTVCT_EL0 >= `deadline` (at once if it already is) */
+static inline void timer_arm(u64 deadline) {
+#if defined(__aarch64__)
+    __asm__ volatile ("msr CNTV_CVAL_EL0, %0\n\t"
+                      "msr CNTV_CTL_EL0, %1\n\t"
+                      "isb" :: "r"(deadline), "r"((u64)1) : "memory");
+#else
+    (void)deadline;
+#endif
+}
+
+/* Stop the comparator; also drops its (level) interrupt */
+static inline void timer_disarm(void) {
+#if defined(__aarch64__)
+    __asm__ volatile ("msr CNTV_CTL_EL0, xzr\n\tisb" ::: "memory");
+#endif
+}
+
+static inline u64 timer_us_to_ticks(u64 usec) {
+    return usec * timer_frequency() / 1000000;
+}
+
+#endif /* ARCH_AARCH64_TIMER_H */
@@ -0,0 +1,131 @@
+/*
+ * OpenCore Mobile – exception vectors
+ *
+ * Installed in VBAR_ELx by irq_init(). The loader only ever runs on
+ * SP_ELx at its own EL, so the only entry expected is IRQ from that
+ * group; anything else is reported by exception_unexpected() and stops.
+ *
+ * IRQs are not nested (PSTATE.I stays set for the whole handler), so
+ * ELR/SPSR survive untouched. The general registers irq_dispatch() may
+ * clobber are x0-x18, fp and lr. The SIMD file is saved whole: AAPCS64
+ * only has a callee keep d8-d15, the low halves of v8-v15, so a handler
+ * reaching the NEON string and framebuffer routines could otherwise
+ * corrupt the upper halves of q8-q15 in the interrupted code. FPSR and
+ * FPCR go with it.
+ */
+
+.global ocm_vectors
+.extern irq_dispatch
+.extern exception_unexpected
+
+/* frame: 21 GPRs + FPSR/FPCR (padded to 24 for alignment) + 32 q registers */
+.equ FRAME_GPR,     (24 * 8)
+.equ FRAME_SIZE,    (FRAME_GPR + 32 * 16)
+
+.macro unexpected kind
+    .balign 0x80
+    mov x0, #\kind
+    b exception_unexpected
+.endm
+
+.macro irq_vector
+    .balign 0x80
+    b irq_entry
+.endm
+
+.section .text
+.balign 0x800
+ocm_vectors:
+    /* current EL, SP_EL0 */
+    unexpected 0
+    unexpected 1
+    unexpected 2
+    unexpected 3
+
+    /* current EL, SP_ELx: where the loader runs */
+    unexpected 4
+    irq_vector
+    unexpected 6
+    unexpected 7
+
+    /* lower EL, AArch64 */
+    unexpected 8
+    unexpected 9
+    unexpected 10
+    unexpected 11
+
+    /* lower EL, AArch32 */
+    unexpected 12
+    unexpected 13
+    unexpected 14
+    unexpected 15
+
+irq_entry:
+    sub sp, sp, #FRAME_SIZE
+    stp x0, x1, [sp, #0x00]
+    stp x2, x3, [sp, #0x10]
+    stp x4, x5, [sp, #0x20]
+    stp x6, x7, [sp, #0x30]
+    stp x8, x9, [sp, #0x40]
+    stp x10, x11, [sp, #0x50]
+    stp x12, x13, [sp, #0x60]
+    stp x14, x15, [sp, #0x70]
+    stp x16, x17, [sp, #0x80]
+    stp x18, x29, [sp, #0x90]
+    str x30, [sp, #0xA0]
+    mrs x0, fpsr
+    mrs x1, fpcr
+    stp x0, x1, [sp, #0xA8]
+    add x0, sp, #FRAME_GPR
+    stp q0, q1, [x0, #0x000]
+    stp q2, q3, [x0, #0x020]
+    stp q4, q5, [x0, #0x040]
+    stp q6, q7, [x0, #0x060]
+    stp q8, q9, [x0, #0x080]
+    stp q10, q11, [x0, #0x0A0]
+    stp q12, q13, [x0, #0x0C0]
+    stp q14, q15, [x0, #0x0E0]
+    stp q16, q17, [x0, #0x100]
+    stp q18, q19, [x0, #0x120]
+    stp q20, q21, [x0, #0x140]
+    stp q22, q23, [x0, #0x160]
+    stp q24, q25, [x0, #0x180]
+    stp q26, q27, [x0, #0x1A0]
+    stp q28, q29, [x0, #0x1C0]
+    stp q30, q31, [x0, #0x1E0]
+
+    bl irq_dispatch
+
+    add x0, sp, #FRAME_GPR
+    ldp q0, q1, [x0, #0x000]
+    ldp q2, q3, [x0, #0x020]
+    ldp q4, q5, [x0, #0x040]
+    ldp q6, q7, [x0, #0x060]
+    ldp q8, q9, [x0, #0x080]
+    ldp q10, q11, [x0, #0x0A0]
+    ldp q12, q13, [x0, #0x0C0]
+    ldp q14, q15, [x0, #0x0E0]
+    ldp q16, q17, [x0, #0x100]
+    ldp q18, q19, [x0, #0x120]
+    ldp q20, q21, [x0, #0x140]
+    ldp q22, q23, [x0, #0x160]
+    ldp q24, q25, [x0, #0x180]
+    ldp q26, q27, [x0, #0x1A0]
+    ldp q28, q29, [x0, #0x1C0]
+    ldp q30, q31, [x0, #0x1E0]
+    ldp x0, x1, [sp, #0xA8]
+    msr fpsr, x0
+    msr fpcr, x1
+    ldr x30, [sp, #0xA0]
+    ldp x18, x29, [sp, #0x90]
+    ldp x16, x17, [sp, #0x80]
+    ldp x14, x15, [sp, #0x70]
+    ldp x12, x13, [sp, #0x60]
+    ldp x10, x11, [sp, #0x50]
+    ldp x8, x9, [sp, #0x40]
+    ldp x6, x7, [sp, #0x30]
+    ldp x4, x5, [sp, #0x20]
+    ldp x2, x3, [sp, #0x10]
+    ldp x0, x1, [sp, #0x00]
+    add sp, sp, #FRAME_SIZE
+    eret
@@ -17,10 +17,34 @@ typedef int16_t  s16;
 typedef int32_t  s32;
 typedef int64_t  s64;
 
+/* =========================
+ *  Status codes (shared by drivers)
+ * ========================= */
+
+typedef enum {
+    STATUS_SUCCESS          = 0,
+    STATUS_PENDING          = 1,    /* async request still in flight */
+    STATUS_ERROR            = -1,
+    STATUS_NOT_FOUND        = -2,
+    STATUS_CRC_ERROR        = -3,
+    STATUS_INVALID_PARAM    = -4,
+    STATUS_OUT_OF_MEMORY    = -5,
+    STATUS_OVERLAP          = -6,
+    STATUS_OUT_OF_RANGE     = -7,
+    STATUS_MEDIA_CHANGED    = -8,
+    STATUS_NO_MEDIA         = -9,
+    STATUS_OUT_OF_RESOURCES = -10
+} status_t;
+
 /* =========================
  *  Console / Text Output
  * ========================= */
 
+/*
+ * Output goes into an in-memory ring and never waits for the UART; see
+ * Console.c for how the ring drains.
+ */
+
 /* Initialize text output (UART or framebuffer text mode) */
 void console_init(void);
 
@@ -30,12 +54,28 @@ void putc(char c);
 /* Output a null-terminated string */
 void puts(const char *s);
 
-/* Minimal printf (supports %s %c %x %d %u only) */
+/* Minimal printf (%s %c %x %d %u %p %%, l/ll/z, width and 0 padding) */
 void printf(const char *fmt, ...);
 
 /* Clear screen (if framebuffer-backed) */
 void console_clear(void);
 
+/* Move what the UART FIFO has room for out of the ring, and bring the mirror up to date; never waits */
+void console_poll(void);
+
+/* Drain everything to the wire, waiting as long as it takes (panic path) */
+void console_flush(void);
+
+/* Drain on the UART's interrupt from now on (routes it to console_uart_irq(); needs irq_init()) */
+void console_enable_irq(void);
+void console_uart_irq(void);
+
+/* Received bytes, from the RX interrupt or console_poll() (NULL detaches) */
+void console_set_input(void (*input)(u8 c));
+
+/* Second reader of the ring, e.g. the framebuffer text console (NULL detaches) */
+void console_set_mirror(void (*write)(const char *s, size_t len));
+
 /* =========================
  *  Input (early boot)
  * ========================= */
@@ -56,9 +96,12 @@ void input_init(void);
 /* Poll input (non-blocking) */
 boot_key_t input_poll(void);
 
-/* Blocking wait for a key */
+/* Blocking wait for a key; sleeps in wfi (see Event.h) */
 boot_key_t input_get(void);
 
+/* Wait for a key until `deadline` (CNTVCT_EL0, see Event.h); KEY_NONE if it passes first */
+boot_key_t input_wait(u64 deadline);
+
 /* =========================
  *  Framebuffer (optional)
  * ========================= */
@@ -68,13 +111,16 @@ typedef struct {
     u32     width;
     u32     height;
     u32     pitch;
-    u32     bpp;
+    u32     bpp;        /* 32 (XRGB8888) or 16 (RGB565) */
+
+    struct fb_state *state;     /* Framebuffer.c */
 } framebuffer_t;
 
-/* Initialize framebuffer if available */
+/* Take over a framebuffer described by base..bpp; 0, or -1 if unusable.
+ * Drawing calls are in Framebuffer.h. */
 int framebuffer_init(framebuffer_t *fb);
 
-/* Draw a filled rectangle */
+/* Draw a filled rectangle (0xAARRGGBB, alpha ignored) */
 void fb_fill_rect(
     framebuffer_t *fb,
     u32 x, u32 y,
@@ -103,6 +149,24 @@ int fs_open(fs_t *fs, const char *path, file_t *out);
 /* Read from file */
 size_t fs_read(file_t *file, void *buf, size_t size);
 
+/* Size of an open file in bytes */
+u64 fs_size(file_t *file);
+
+/* Move the read position; 0, or -1 past the end */
+int fs_seek(file_t *file, u64 offset);
+
+/* Where a run of a file's bytes sits on its volume, see fs_map() */
+typedef struct {
+    struct block_device *device;    /* BlockIo.h */
+    u64 lba;                        /* device block holding `offset` */
+    u64 length;                     /* contiguous bytes from there */
+} fs_extent_t;
+
+/* Map file byte `offset` (a multiple of the device block size) to the
+ * run holding it; -1 if it has no plain copy on disk (compressed,
+ * inline, a hole), which leaves fs_read() as the only way in */
+int fs_map(file_t *file, u64 offset, fs_extent_t *out);
+
 /* Close file */
 void fs_close(file_t *file);
 
@@ -110,19 +174,34 @@ void fs_close(file_t *file);
  *  Memory
  * ========================= */
 
-/* Early boot allocator (bump allocator) */
+/* Early boot allocator (bump allocator, lives until kernel handoff;
+ * arenas and slabs live in Memory.h) */
 void *boot_alloc(size_t size);
 
+/* Give back a boot_alloc() block of `size` bytes, e.g. on an error path */
+void boot_free(void *ptr, size_t size);
+
 /* Memory set / copy (no libc) */
 void *memcpy(void *dst, const void *src, size_t n);
 void *memset(void *dst, int val, size_t n);
 int   memcmp(const void *a, const void *b, size_t n);
 
+/* C strings (no libc) */
+size_t strlen(const char *s);
+int    strcmp(const char *a, const char *b);
+int    strncmp(const char *a, const char *b, size_t n);
+char  *strstr(const char *haystack, const char *needle);
+
+#ifdef OCM_BENCH
+/* Print memcpy/memset/memcmp bytes per 100 cycles for each size bucket */
+void string_bench(void);
+#endif
+
 /* =========================
  *  Time / Delay
  * ========================= */
 
-/* Busy-wait delay (microseconds if possible) */
+/* Delay in microseconds; short ones spin, longer ones sleep in wfi (Event.c) */
 void udelay(u32 usec);
 
 /* =========================
@@ -1,66 +1,64 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "bootstd.h"
+#include "BootParams.h"
+#include "Memory.h"
+#include "Trace.h"
+#include "Event.h"
+#include "Smp.h"
+#include "arch/aarch64/irq.h"
+#include "Platform/crc32/crc32.h"
+
 /*
  * OpenCore Mobile – Prototype Loader
  * Stage 0: Control + Visibility
  */
 
-#define OCM_BOOT_MAGIC 0x4F434D424F4F54ULL /* "OCMBOOT" */
-
-/* ---- boot parameters (opaque for now) ---- */
-struct ocm_boot_params {
-    void *opaque;   /* future: dtb, framebuffer, memory map */
-};
-
-/* ---- platform hooks (to be implemented per device) ---- */
-static void ocm_console_putc(char c);
-static void ocm_halt(void);
-
-/* ---- panic: loud, final, honest ---- */
-static void ocm_panic(const char *msg) {
-    while (*msg) {
-        ocm_console_putc(*msg++);
-    }
-    ocm_console_putc('\n');
-    ocm_halt();
-}
-
 /* ---- entry point ---- */
 void boot_main(uint64_t magic, void *params) {
-    (void)params; /* unused in prototype stage */
+    const struct ocm_boot_params *bp = params;
 
     if (magic != OCM_BOOT_MAGIC) {
         /* silent refusal: caller is not trusted */
-        ocm_halt();
+        halt();
     }
 
-    /* visible proof of life */
-    ocm_console_putc('O');
-    ocm_console_putc('C');
-    ocm_console_putc('M');
-    ocm_console_putc('\n');
+    trace_init(ocm_entry_ticks);
 
-    /* explicit stop: nothing else exists yet */
-    ocm_panic("OCM: prototype loader reached");
-//    boot_menu_summon();
-}
+    /* move allocations off the early heap onto real RAM */
+    if (bp)
+        mem_init(bp->mem_map, bp->mem_map_count);
+    trace_mark("mem init", 0);
 
-/* =========================================================
- * Platform-specific minimal implementations
- * =========================================================
- * Replace these with UART / framebuffer writes per device.
- */
+    /* visible proof of life (buffered; drains as the UART FIFO allows) */
+    console_init();
+    puts("OCM\n");
+    trace_mark("console", 0);
 
-#define UART_BASE 0x09000000 /* example address */
+    /* from here on waits sleep in wfi and the console drains on its IRQ */
+    irq_init();
+    event_init();
+    console_enable_irq();
+    input_init();
 
-static void ocm_console_putc(char c) {
-    volatile uint32_t *uart = (volatile uint32_t *)UART_BASE;
-    *uart = (uint32_t)c;
-}
+    /* secondaries take queued work from here on (disk probes, CRCs) */
+    smp_init();
 
-static void ocm_halt(void) {
-    for (;;) {
-        __asm__ volatile ("wfi");
-    }
+#ifdef OCM_SELFTEST
+    if (crc32_self_test() != 0)
+        panic("OCM: crc32 self-test failed");
+    if (mem_self_test() != 0)
+        panic("OCM: boot_free self-test failed");
+#endif
+
+#ifdef OCM_BENCH
+    string_bench();
+#endif
+
+    trace_dump();
+
+    /* explicit stop: nothing else exists yet (panic flushes the console) */
+    panic("OCM: prototype loader reached");
+//    boot_menu_summon(&menu);
 }
@@ -7,6 +7,16 @@ typedef NS_ENUM(NSInteger, PDBatteryState) {
     PDBatteryStateFull
 };
 
+/*
+ * Posted on the main queue whenever the values below change: the fuel
+ * gauge reported something, or the time remaining was re-estimated.
+ */
+extern NSString *const PDBatteryManagerDidChangeNotification;
+
+/*
+ * The getters return a cache the gauge's change notifications keep
+ * current; none of them calls into the kernel.
+ */
 @interface PDBatteryManager : NSObject
 
 + (instancetype)sharedManager;
@@ -29,7 +39,7 @@ typedef NS_ENUM(NSInteger, PDBatteryState) {
 /* Estimated time remaining in minutes, or -1 if unknown */
 - (NSInteger)estimatedTimeRemaining;
 
-/* Force refresh from kernel / HAL */
+/* Force refresh from kernel / HAL, in one call */
 - (void)updateBatteryInfo;
 
 @end
@@ -1,17 +1,52 @@
 #import "PDBatteryManager.h"
 
-/* 
+/*
  * These functions are assumed to be provided by
  * Pocket Darwin's power / IOKit bridge layer.
  * They are C on purpose.
+ *
+ * pd_power_snapshot() reads everything the fuel gauge knows in one
+ * bridge round-trip. pd_power_change_fd() is a descriptor that turns
+ * readable when the gauge reports a change (plug, level step, the
+ * current moving); it stays readable until the next snapshot, so
+ * nothing has to be read from it. No-battery devices never fire it.
  */
-extern int pd_power_has_battery(void);
-extern int pd_power_is_charging(void);
-extern int pd_power_is_full(void);
-extern int pd_power_capacity_percent(void);
-extern int pd_power_voltage_mv(void);
-extern int pd_power_temperature_tenths(void);
-extern int pd_power_time_remaining_minutes(void);
+#define PD_POWER_HAS_BATTERY    (1u << 0)
+#define PD_POWER_CHARGING       (1u << 1)
+#define PD_POWER_FULL           (1u << 2)
+
+typedef struct {
+    uint32_t flags;                 /* PD_POWER_* */
+    int32_t  capacity_percent;      /* -1 if unknown */
+    int32_t  voltage_mv;            /* 0 if unknown */
+    int32_t  temperature_tenths;    /* 0 if unknown */
+    int32_t  current_ua;            /* average, negative while discharging */
+    int32_t  charge_uah;            /* left, -1 if unknown */
+    int32_t  time_to_empty_minutes; /* the gauge's own estimate, -1 if it has none */
+} pd_power_snapshot_t;
+
+extern int pd_power_snapshot(pd_power_snapshot_t *snapshot);  /* 0 on success */
+extern int pd_power_change_fd(void);                          /* -1 if none */
+
+NSString *const PDBatteryManagerDidChangeNotification = @"PDBatteryManagerDidChangeNotification";
+
+/*
+ * Without a gauge estimate, time remaining is charge over current. The
+ * current is averaged over the updates between two estimates, and the
+ * estimate itself goes on a timer that is armed by the first update
+ * after one and coalesced with other wakeups - a discharging phone
+ * still refreshes it about once a minute, an idle one not at all.
+ */
+#define PD_ESTIMATE_INTERVAL    (60 * NSEC_PER_SEC)
+#define PD_ESTIMATE_LEEWAY      (30 * NSEC_PER_SEC)
+
+/*
+ * A failed snapshot leaves the change fd readable, and a read source
+ * fires for as long as it is; the source is suspended and retried
+ * later instead, backing off from one second to a minute.
+ */
+#define PD_RETRY_FIRST          (1 * NSEC_PER_SEC)
+#define PD_RETRY_MAX            (60 * NSEC_PER_SEC)
 
 @implementation PDBatteryManager {
     BOOL _hasBattery;
@@ -20,6 +55,16 @@ extern int pd_power_time_remaining_minutes(void);
     NSInteger _voltage;
     NSInteger _temperature;
     NSInteger _timeRemaining;
+
+    pd_power_snapshot_t _snapshot;
+    double _currentSum;             /* uA, discharging positive */
+    NSUInteger _currentSamples;
+
+    dispatch_source_t _changeSource;
+    dispatch_source_t _estimateTimer;
+    BOOL _estimatePending;
+    uint64_t _retryDelay;           /* ns, 0 while snapshots work */
+    BOOL _retrySuspended;
 }
 
 + (instancetype)sharedManager {
@@ -28,6 +73,7 @@ extern int pd_power_time_remaining_minutes(void);
     dispatch_once(&onceToken, ^{
         shared = [[PDBatteryManager alloc] init];
         [shared updateBatteryInfo];
+        [shared startObserving];
     });
     return shared;
 }
@@ -56,33 +102,153 @@ extern int pd_power_time_remaining_minutes(void);
     return _timeRemaining;
 }
 
+/*
+ * Everything runs on the main queue, so the cache needs no lock. The
+ * sources hold the shared manager, which lives as long as the process.
+ */
+- (void)startObserving {
+    int fd = pd_power_change_fd();
+    if (fd < 0)
+        return;
+
+    _changeSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, fd, 0,
+                                           dispatch_get_main_queue());
+    dispatch_source_set_event_handler(_changeSource, ^{
+        [self updateBatteryInfo];
+    });
+    dispatch_resume(_changeSource);
+
+    _estimateTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0,
+                                            dispatch_get_main_queue());
+    dispatch_source_set_timer(_estimateTimer, DISPATCH_TIME_FOREVER,
+                              DISPATCH_TIME_FOREVER, PD_ESTIMATE_LEEWAY);
+    dispatch_source_set_event_handler(_estimateTimer, ^{
+        if ([self estimateTimeRemaining])
+            [self didChange];
+    });
+    dispatch_resume(_estimateTimer);
+}
+
 - (void)updateBatteryInfo {
-    if (!pd_power_has_battery()) {
+    pd_power_snapshot_t s;
+
+    if (pd_power_snapshot(&s) != 0) {
+        [self retryLater];  /* keep what we had */
+        return;
+    }
+    _retryDelay = 0;
+    _snapshot = s;
+
+    /* the gauge reports more than is cached: only post what changed */
+    BOOL hadBattery = _hasBattery;
+    PDBatteryState oldState = _state;
+    float oldLevel = _level;
+    NSInteger oldVoltage = _voltage;
+    NSInteger oldTemperature = _temperature;
+    NSInteger oldTimeRemaining = _timeRemaining;
+
+    if (!(s.flags & PD_POWER_HAS_BATTERY)) {
         _hasBattery = NO;
         _state = PDBatteryStateUnknown;
         _level = -1.0f;
         _voltage = 0;
         _temperature = 0;
         _timeRemaining = -1;
-        return;
+    } else {
+        [self applySnapshot:&s];
+    }
+
+    if (_hasBattery != hadBattery || _state != oldState || _level != oldLevel ||
+        _voltage != oldVoltage || _temperature != oldTemperature ||
+        _timeRemaining != oldTimeRemaining) {
+        [self didChange];
     }
+}
 
+/* A snapshot with a battery into the cache */
+- (void)applySnapshot:(const pd_power_snapshot_t *)s {
     _hasBattery = YES;
 
-    if (pd_power_is_full()) {
-        _state = PDBatteryStateFull;
-    } else if (pd_power_is_charging()) {
-        _state = PDBatteryStateCharging;
+    PDBatteryState state;
+    if (s->flags & PD_POWER_FULL) {
+        state = PDBatteryStateFull;
+    } else if (s->flags & PD_POWER_CHARGING) {
+        state = PDBatteryStateCharging;
+    } else {
+        state = PDBatteryStateUnplugged;
+    }
+
+    /* a plug or unplug makes the old average meaningless */
+    if (state != _state) {
+        _currentSum = 0;
+        _currentSamples = 0;
+    }
+    _state = state;
+
+    _level = (s->capacity_percent >= 0) ? (s->capacity_percent / 100.0f) : -1.0f;
+    _voltage = s->voltage_mv;
+    _temperature = s->temperature_tenths;
+
+    if (_state != PDBatteryStateUnplugged) {
+        _timeRemaining = -1;
+    } else if (s->time_to_empty_minutes >= 0) {
+        _timeRemaining = s->time_to_empty_minutes;
     } else {
-        _state = PDBatteryStateUnplugged;
+        if (s->current_ua < 0) {
+            _currentSum += -(double)s->current_ua;
+            _currentSamples++;
+        }
+        if (_timeRemaining < 0) {
+            [self estimateTimeRemaining];   /* first one now */
+        } else if (_estimateTimer && !_estimatePending) {
+            _estimatePending = YES;
+            dispatch_source_set_timer(_estimateTimer,
+                                      dispatch_time(DISPATCH_TIME_NOW, PD_ESTIMATE_INTERVAL),
+                                      DISPATCH_TIME_FOREVER, PD_ESTIMATE_LEEWAY);
+        }
     }
+}
+
+- (void)retryLater {
+    if (!_changeSource || _retrySuspended)
+        return;     /* no source to spin, or a retry is already due */
+
+    _retryDelay = _retryDelay ? MIN(_retryDelay * 2, (uint64_t)PD_RETRY_MAX) : PD_RETRY_FIRST;
+    _retrySuspended = YES;
+    dispatch_suspend(_changeSource);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)_retryDelay),
+                   dispatch_get_main_queue(), ^{
+        _retrySuspended = NO;
+        dispatch_resume(_changeSource);
+        [self updateBatteryInfo];
+    });
+}
 
-    int cap = pd_power_capacity_percent();
-    _level = (cap >= 0) ? (cap / 100.0f) : -1.0f;
+/* Whether the estimate moved; the caller posts */
+- (BOOL)estimateTimeRemaining {
+    _estimatePending = NO;
+
+    if (!_hasBattery || _state != PDBatteryStateUnplugged ||
+        _snapshot.charge_uah < 0 || !_currentSamples) {
+        return NO;
+    }
+
+    double current = _currentSum / _currentSamples;
+    _currentSum = 0;
+    _currentSamples = 0;
+    if (current <= 0)
+        return NO;
+
+    NSInteger minutes = (NSInteger)(_snapshot.charge_uah / current * 60.0);
+    if (minutes == _timeRemaining)
+        return NO;
+    _timeRemaining = minutes;
+    return YES;
+}
 
-    _voltage = pd_power_voltage_mv();
-    _temperature = pd_power_temperature_tenths();
-    _timeRemaining = pd_power_time_remaining_minutes();
+- (void)didChange {
+    [[NSNotificationCenter defaultCenter]
+        postNotificationName:PDBatteryManagerDidChangeNotification object:self];
 }
 
 @end